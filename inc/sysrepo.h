@@ -338,9 +338,25 @@ typedef enum sr_conn_flag_e {
 /**
  * @brief Options overriding default connection handling by ::sr_connect call,
  * it is supposed to be bitwise OR-ed value of any ::sr_conn_flag_t flags.
+ * The size of the socket pool of the connection can be OR-ed in using ::SR_CONN_POOL_SIZE.
  */
 typedef uint32_t sr_conn_options_t;
 
+/**
+ * @brief Bits of ::sr_conn_options_t holding the size of the socket pool of the connection.
+ */
+#define SR_CONN_POOL_MASK 0x00ff0000
+
+/**
+ * @brief Encodes the size of the socket pool into ::sr_conn_options_t.
+ *
+ * By default, all sessions of a connection share one socket and their requests are processed
+ * one after another. With a pool of N sockets (N <= 255), the sessions started on the connection
+ * are spread across the sockets, so that requests of sessions used from different threads
+ * can be processed by sysrepo engine in parallel.
+ */
+#define SR_CONN_POOL_SIZE(N) ((((sr_conn_options_t)(N)) << 16) & SR_CONN_POOL_MASK)
+
 /**
  * @brief Flags used to override default session handling (used by ::sr_session_start
  * and ::sr_session_start_user calls).
@@ -389,6 +405,10 @@ typedef enum sr_datastore_e {
  * ::SR_ERR_DISCONNECT error on active sessions. In this case, the application is supposed to reconnect
  * with another ::sr_connect call and restart all lost sessions.
  *
+ * @note Multi-threaded applications sharing one connection may request a pool of sockets
+ * using ::SR_CONN_POOL_SIZE in opts. Each session is bound to one socket of the pool
+ * for its whole lifetime.
+ *
  * @param[in] app_name Name of the application connecting to the datastore
  * (can be a static string). Used only for accounting purposes.
  * @param[in] opts Options overriding default connection handling by this call.
@@ -751,6 +771,42 @@ int sr_get_item(sr_session_ctx_t *session, const char *xpath, sr_val_t **value);
  */
 int sr_get_items(sr_session_ctx_t *session, const char *xpath, sr_val_t **values, size_t *value_cnt);
 
+/**
+ * @brief Data elements matching one of the xpaths requested by ::sr_get_items_multi.
+ */
+typedef struct sr_val_set_s {
+    int result;          /**< Result of the retrieval (SR_ERR_OK, SR_ERR_NOT_FOUND if there are no matching nodes, ...). */
+    sr_val_t *values;    /**< Array of retrieved data elements, NULL if the result is not SR_ERR_OK. */
+    size_t value_cnt;    /**< Number of elements in the values array. */
+} sr_val_set_t;
+
+/**
+ * @brief Retrieves arrays of data elements matching each of the provided XPaths.
+ *
+ * All xpaths are sent within one request and all data elements are transferred within
+ * one response message, which is much more efficient than calling ::sr_get_items or ::sr_get_item
+ * for each of the xpaths. The xpaths are evaluated over the same data of the session,
+ * operational data are requested from the providers once per module for all its xpaths.
+ *
+ * The result of each xpath is reported separately in its value set, the failure of one
+ * xpath does not affect the others. The return code of the call reflects only the errors
+ * of the request as a whole.
+ *
+ * @note Not supported in the sessions of notification callbacks.
+ *
+ * @see @ref xp_page "Path Addressing" documentation
+ * for Path syntax used for identification of yang nodes in sysrepo calls.
+ *
+ * @param[in] session Session context acquired with ::sr_session_start call.
+ * @param[in] xpaths Array of @ref xp_page "Data Path" identifiers of the data elements to be retrieved.
+ * @param[in] xpath_cnt Number of xpaths in the array, must be greater than zero.
+ * @param[out] val_sets Array of xpath_cnt value sets in the order of the xpaths (allocated by the function,
+ * it is supposed to be freed by the caller using ::sr_free_val_sets).
+ *
+ * @return Error code (SR_ERR_OK on success, SR_ERR_UNSUPPORTED in the session of a notification callback).
+ */
+int sr_get_items_multi(sr_session_ctx_t *session, const char **xpaths, size_t xpath_cnt, sr_val_set_t **val_sets);
+
 /**
  * @brief Creates an iterator for retrieving of the data elements stored under provided xpath.
  *
@@ -882,6 +938,48 @@ int sr_get_subtree(sr_session_ctx_t *session, const char *xpath, sr_get_subtree_
 int sr_get_subtrees(sr_session_ctx_t *session, const char *xpath, sr_get_subtree_options_t opts,
         sr_node_t **subtrees, size_t *subtree_cnt);
 
+/**
+ * @brief Format of the data exported by ::sr_export_data call.
+ */
+typedef enum sr_data_format_e {
+    SR_DATA_XML,   /**< XML format. */
+    SR_DATA_JSON,  /**< JSON format. */
+    SR_DATA_LYB,   /**< libyang binary format. */
+} sr_data_format_t;
+
+/**
+ * @brief Callback to be called with each chunk of the data exported by ::sr_export_data call.
+ *
+ * @param[in] chunk Part of the serialized data, valid only until the callback returns.
+ * @param[in] size Size of the chunk in bytes.
+ * @param[in] private_ctx Private context opaque to sysrepo, as passed to ::sr_export_data call.
+ *
+ * @return Error code (SR_ERR_OK on success). Any other value stops the export.
+ */
+typedef int (*sr_export_data_cb)(const void *chunk, size_t size, void *private_ctx);
+
+/**
+ * @brief Exports the complete data tree of a module stored in the session datastore.
+ *
+ * The data tree is serialized directly by the Sysrepo Engine and transferred in chunks
+ * of at most SR_EXPORT_CHUNK_SIZE bytes, each chunk is passed to the callback as soon as it arrives.
+ * Memory needed on the client side therefore does not depend on the size of the datastore.
+ * The Sysrepo Engine serializes the whole data tree at once and keeps the serialized data
+ * until the last chunk is transferred, its memory usage grows with the size of the data.
+ * State data are included unless the session was started with ::SR_SESS_CONFIG_ONLY flag.
+ *
+ * @param[in] session Session context acquired with ::sr_session_start call.
+ * @param[in] module_name Name of the module whose data are exported.
+ * @param[in] format Format of the exported data.
+ * @param[in] callback Callback called with each chunk of the serialized data.
+ * @param[in] private_ctx Private context passed to the callback, opaque to sysrepo.
+ *
+ * @return Error code (SR_ERR_OK on success). An empty data tree is not an error,
+ * the callback is not called in that case.
+ */
+int sr_export_data(sr_session_ctx_t *session, const char *module_name, sr_data_format_t format,
+        sr_export_data_cb callback, void *private_ctx);
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Data Manipulation API (edit-config functionality)
@@ -916,6 +1014,14 @@ typedef enum sr_move_position_e {
     SR_MOVE_LAST = 3,      /**< Move the specified item to the position of the last child. */
 } sr_move_position_t;
 
+/**
+ * @brief Options for specifying how the data are applied by ::sr_set_data_tree call.
+ */
+typedef enum sr_data_tree_mode_e {
+    SR_DATA_TREE_REPLACE = 0,  /**< Current data of the module are replaced by the provided data. */
+    SR_DATA_TREE_MERGE = 1,    /**< Provided data are merged into the current data of the module. */
+} sr_data_tree_mode_t;
+
 /**
  * @brief Sets the value of the leaf, leaf-list, list or presence container.
  *
@@ -985,6 +1091,24 @@ int sr_delete_item(sr_session_ctx_t *session, const char *xpath, const sr_edit_o
  */
 int sr_move_item(sr_session_ctx_t *session, const char *xpath, const sr_move_position_t position, const char *relative_item);
 
+/**
+ * @brief Replaces the configuration data of a module by the provided data, or merges the provided data
+ * into them, within a single request.
+ *
+ * Unlike setting the nodes one by one, the whole data tree is transferred in one message and applied
+ * as a single edit. The data are validated on ::sr_validate or ::sr_commit call together with the other
+ * changes made in the session. In running datastore all the affected nodes must be enabled.
+ * SR_ERR_UNAUTHORIZED will be returned if the user does not have write permission to the module.
+ *
+ * @param[in] session Session context acquired with ::sr_session_start call.
+ * @param[in] module_name Name of the module whose data are being set.
+ * @param[in] data Configuration data of the module in XML format (top-level nodes, possibly empty).
+ * @param[in] mode Whether the data replace or are merged into the current data of the module.
+ *
+ * @return Error code (SR_ERR_OK on success).
+ */
+int sr_set_data_tree(sr_session_ctx_t *session, const char *module_name, const char *data, const sr_data_tree_mode_t mode);
+
 /**
  * @brief Perform the validation of changes made in current session, but do not
  * commit nor discard them.
@@ -1040,7 +1164,9 @@ int sr_discard_changes(sr_session_ctx_t *session);
  * @note ::sr_session_refresh is needed to see the result of a copy-config operation
  * in a session apart from the case when SR_DS_CANDIDATE is the destination datastore.
  * Since the candidate is not shared among sessions, data trees are copied only to the
- * canidate in the session issuing the copy-config operation.
+ * canidate in the session issuing the copy-config operation. Modules not modified in the
+ * candidate mirror the running datastore, therefore copying candidate to running
+ * (with \p module_name not specified) commits only the modules modified in the candidate.
  *
  * @note Operation may fail, if it tries to copy a not enabled configuration to the
  * running datastore.
@@ -1058,6 +1184,61 @@ int sr_discard_changes(sr_session_ctx_t *session);
 int sr_copy_config(sr_session_ctx_t *session, const char *module_name,
         sr_datastore_t src_datastore, sr_datastore_t dst_datastore);
 
+/**
+ * @brief Copies the content of the source datastore into the running datastore
+ * the same way as ::sr_copy_config, but the change has to be confirmed within
+ * given timeout, otherwise the running datastore is rolled back to the state
+ * before the first unconfirmed copy.
+ *
+ * The pending copy is confirmed by any ::sr_copy_config into the running datastore,
+ * or extended by another ::sr_copy_config_confirmed call (the timeout is restarted
+ * and the rollback still restores the state before the first unconfirmed copy).
+ * Only one confirmed copy can be pending in the sysrepo engine at a time.
+ *
+ * @note When \p src_datastore is SR_DS_CANDIDATE, only the modules modified in the
+ * candidate datastore of the session are committed, the other modules are left untouched.
+ *
+ * @param[in] session Session context acquired with ::sr_session_start call.
+ * @param[in] module_name If specified, only limits the copy operation only to
+ * one specified module.
+ * @param[in] src_datastore Source datastore.
+ * @param[in] timeout Timeout in seconds within which the copy has to be confirmed (non-zero).
+ *
+ * @return Error code (SR_ERR_OK on success).
+ */
+int sr_copy_config_confirmed(sr_session_ctx_t *session, const char *module_name,
+        sr_datastore_t src_datastore, uint32_t timeout);
+
+/**
+ * @brief Immediately rolls back the running datastore to the state before the pending
+ * confirmed copy (see ::sr_copy_config_confirmed). The rollback is performed
+ * asynchronously in the sysrepo engine as a regular commit.
+ *
+ * @param[in] session Session context acquired with ::sr_session_start call.
+ *
+ * @return Error code (SR_ERR_OK on success, SR_ERR_NOT_FOUND if there is no pending confirmed copy).
+ */
+int sr_cancel_confirmed_commit(sr_session_ctx_t *session);
+
+/**
+ * @brief Rolls back the \p count most recent commits to the running datastore.
+ * The inverse of the changes made by each commit is kept by the sysrepo engine (up to
+ * SR_CHECKPOINT_COUNT commits), the inverse changes of the requested commits are loaded
+ * into the candidate datastore of the session and committed to running at once,
+ * only the modules touched by the rolled back commits are affected.
+ *
+ * @note Any changes made in the candidate datastore of the session are discarded.
+ * The rollback is a commit on its own, so rolling back one commit twice restores
+ * the original state.
+ *
+ * @param[in] session Session context acquired with ::sr_session_start call.
+ * @param[in] count Number of the most recent commits to be rolled back (at least 1).
+ *
+ * @return Error code (SR_ERR_OK on success, SR_ERR_NOT_FOUND if less than \p count
+ * commits can be rolled back).
+ */
+int sr_rollback(sr_session_ctx_t *session, uint32_t count);
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Locking API
@@ -1185,6 +1366,23 @@ typedef enum sr_subscr_flag_e {
      * and replay has finished (::SR_EV_NOTIF_T_REPLAY_COMPLETE is delivered).
      */
     SR_SUBSCR_NOTIF_REPLAY_FIRST = 32,
+
+    /**
+     * @brief Callbacks of the subscription will be called from a pool of worker threads instead of the thread
+     * with the event loop. Callbacks of a single subscription are never called concurrently and are called
+     * in the order in which the notifications / requests have arrived, but callbacks of different
+     * subscriptions may run in parallel. Has no effect if an application-local file descriptor watcher
+     * is used (see ::sr_fd_watcher_init).
+     */
+    SR_SUBSCR_THREADED = 64,
+
+    /**
+     * @brief Applicable only together with ::SR_SUBSCR_APPLY_ONLY. Changes committed in a quick succession
+     * (within a time window configured at build time, 50 ms by default) are notified by a single ::SR_EV_APPLY
+     * event, the changes retrieved by ::sr_get_changes_iter within the callback are the net changes of all
+     * merged commits. Commits with no net effect on the subscribed data are not notified at all.
+     */
+    SR_SUBSCR_COALESCE = 128,
 } sr_subscr_flag_t;
 
 /**
@@ -1972,6 +2170,15 @@ void sr_free_val(sr_val_t *value);
  */
 void sr_free_values(sr_val_t *values, size_t count);
 
+/**
+ * @brief Frees array of ::sr_val_set_t structures (and all values stored within
+ * each array element).
+ *
+ * @param[in] val_sets Array of value sets to be freed.
+ * @param[in] count Number of elements stored in the array.
+ */
+void sr_free_val_sets(sr_val_set_t *val_sets, size_t count);
+
 /**
  * @brief Frees ::sr_val_iter_t iterator and all memory allocated within it.
  *
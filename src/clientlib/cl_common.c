@@ -30,7 +30,8 @@
 #include "cl_common.h"
 
 /**
- * @brief Adds a new session to the session list of the connection.
+ * @brief Adds a new session to the session list of the connection and binds
+ * it to the socket with the least sessions.
  */
 static int
 cl_conn_add_session(sr_conn_ctx_t *connection, sr_session_ctx_t *session)
@@ -48,6 +49,15 @@ cl_conn_add_session(sr_conn_ctx_t *connection, sr_session_ctx_t *session)
 
     pthread_mutex_lock(&connection->lock);
 
+    /* bind the session to the least used socket */
+    session->socket = &connection->sockets[0];
+    for (size_t i = 1; i < connection->socket_cnt; ++i) {
+        if (connection->sockets[i].session_cnt < session->socket->session_cnt) {
+            session->socket = &connection->sockets[i];
+        }
+    }
+    session->socket->session_cnt += 1;
+
     /* append session entry at the end of list */
     if (NULL == connection->session_list) {
         connection->session_list = session_item;
@@ -76,6 +86,11 @@ cl_conn_remove_session(sr_conn_ctx_t *connection, sr_session_ctx_t *session)
 
     pthread_mutex_lock(&connection->lock);
 
+    if (NULL != session->socket) {
+        session->socket->session_cnt -= 1;
+        session->socket = NULL;
+    }
+
     /* find matching session in linked list */
     tmp = connection->session_list;
     while ((NULL != tmp) && (tmp->session != session)) {
@@ -104,39 +119,39 @@ cl_conn_remove_session(sr_conn_ctx_t *connection, sr_session_ctx_t *session)
 }
 
 /**
- * @brief Expands message buffer of a connection to fit given size, if needed.
+ * @brief Expands message buffer of a socket to fit given size, if needed.
  */
 static int
-cl_conn_msg_buf_expand(sr_conn_ctx_t *conn_ctx, size_t required_size)
+cl_socket_msg_buf_expand(cl_socket_t *sock, size_t required_size)
 {
     uint8_t *tmp = NULL;
 
-    CHECK_NULL_ARG(conn_ctx);
+    CHECK_NULL_ARG(sock);
 
-    if (conn_ctx->msg_buf_size < required_size) {
-        tmp = realloc(conn_ctx->msg_buf, required_size * sizeof(*tmp));
+    if (sock->msg_buf_size < required_size) {
+        tmp = realloc(sock->msg_buf, required_size * sizeof(*tmp));
         if (NULL == tmp) {
-            SR_LOG_ERR("Unable to expand message buffer of connection=%p.", (void*)conn_ctx);
+            SR_LOG_ERR("Unable to expand message buffer of socket fd=%d.", sock->fd);
             return SR_ERR_NOMEM;
         }
-        conn_ctx->msg_buf = tmp;
-        conn_ctx->msg_buf_size = required_size;
+        sock->msg_buf = tmp;
+        sock->msg_buf_size = required_size;
     }
 
     return SR_ERR_OK;
 }
 
 /**
- * @brief Sends a message via provided connection.
+ * @brief Sends a message via provided socket.
  */
 static int
-cl_message_send(sr_conn_ctx_t *conn_ctx, Sr__Msg *msg)
+cl_message_send(cl_socket_t *sock, Sr__Msg *msg)
 {
     size_t msg_size = 0;
     int pos = 0, sent = 0;
     int rc = SR_ERR_OK;
 
-    CHECK_NULL_ARG2(conn_ctx, msg);
+    CHECK_NULL_ARG2(sock, msg);
 
     /* find out required message size */
     msg_size = sr__msg__get_packed_size(msg);
@@ -146,21 +161,21 @@ cl_message_send(sr_conn_ctx_t *conn_ctx, Sr__Msg *msg)
     }
 
     /* expand the buffer if needed */
-    rc = cl_conn_msg_buf_expand(conn_ctx, msg_size + SR_MSG_PREAM_SIZE);
+    rc = cl_socket_msg_buf_expand(sock, msg_size + SR_MSG_PREAM_SIZE);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR_MSG("Cannot expand buffer for the message.");
         return rc;
     }
 
     /* write 4-byte length */
-    sr_uint32_to_buff(msg_size, conn_ctx->msg_buf);
+    sr_uint32_to_buff(msg_size, sock->msg_buf);
 
     /* pack the message */
-    sr__msg__pack(msg, (conn_ctx->msg_buf + SR_MSG_PREAM_SIZE));
+    sr__msg__pack(msg, (sock->msg_buf + SR_MSG_PREAM_SIZE));
 
     /* send the message */
     do {
-        sent = send(conn_ctx->fd, (conn_ctx->msg_buf + pos), (msg_size + SR_MSG_PREAM_SIZE - pos), 0);
+        sent = send(sock->fd, (sock->msg_buf + pos), (msg_size + SR_MSG_PREAM_SIZE - pos), 0);
         if (sent > 0) {
             pos += sent;
         } else {
@@ -176,10 +191,10 @@ cl_message_send(sr_conn_ctx_t *conn_ctx, Sr__Msg *msg)
 }
 
 /*
- * @brief Receives a message on provided connection (blocks until a message is received).
+ * @brief Receives a message on provided socket (blocks until a message is received).
  */
 static int
-cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_resp)
+cl_message_recv(cl_socket_t *sock, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_resp)
 {
     size_t len = 0, pos = 0;
     size_t msg_size = 0;
@@ -187,7 +202,7 @@ cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_res
     int rc = 0;
 
     /* expand the buffer if needed */
-    rc = cl_conn_msg_buf_expand(conn_ctx, SR_MSG_PREAM_SIZE);
+    rc = cl_socket_msg_buf_expand(sock, SR_MSG_PREAM_SIZE);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR_MSG("Cannot expand buffer for the message.");
         return rc;
@@ -195,7 +210,7 @@ cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_res
 
     /* read at least first 4 bytes with length of the message */
     while (pos < SR_MSG_PREAM_SIZE) {
-        len = recv(conn_ctx->fd, conn_ctx->msg_buf, conn_ctx->msg_buf_size, 0);
+        len = recv(sock->fd, (sock->msg_buf + pos), (sock->msg_buf_size - pos), 0);
         if (-1 == len) {
             if (errno == EINTR) {
                 continue;
@@ -213,7 +228,7 @@ cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_res
         }
         pos += len;
     }
-    msg_size = sr_buff_to_uint32(conn_ctx->msg_buf);
+    msg_size = sr_buff_to_uint32(sock->msg_buf);
 
     /* check message size bounds */
     if ((msg_size <= 0) || (msg_size > SR_MAX_MSG_SIZE)) {
@@ -222,7 +237,7 @@ cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_res
     }
 
     /* expand the buffer if needed */
-    rc = cl_conn_msg_buf_expand(conn_ctx, (msg_size + SR_MSG_PREAM_SIZE));
+    rc = cl_socket_msg_buf_expand(sock, (msg_size + SR_MSG_PREAM_SIZE));
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR_MSG("Cannot expand buffer for the message.");
         return rc;
@@ -230,7 +245,7 @@ cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_res
 
     /* read the rest of the message */
     while (pos < (msg_size + SR_MSG_PREAM_SIZE)) {
-        len = recv(conn_ctx->fd, (conn_ctx->msg_buf + pos), (conn_ctx->msg_buf_size - pos), 0);
+        len = recv(sock->fd, (sock->msg_buf + pos), (sock->msg_buf_size - pos), 0);
         if (-1 == len) {
             if (errno == EINTR) {
                 continue;
@@ -255,7 +270,7 @@ cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_res
         CHECK_RC_MSG_RETURN(rc, "Failed to create a new Sysrepo memory context.");
     }
     ProtobufCAllocator allocator = sr_get_protobuf_allocator(sr_mem);
-    *msg = sr__msg__unpack(&allocator, msg_size, (const uint8_t*)(conn_ctx->msg_buf + SR_MSG_PREAM_SIZE));
+    *msg = sr__msg__unpack(&allocator, msg_size, (const uint8_t*)(sock->msg_buf + SR_MSG_PREAM_SIZE));
     if (NULL == *msg) {
         if (NULL == sr_mem_resp) {
             sr_mem_free(sr_mem);
@@ -274,24 +289,45 @@ cl_message_recv(sr_conn_ctx_t *conn_ctx, Sr__Msg **msg, sr_mem_ctx_t *sr_mem_res
 }
 
 int
-cl_connection_create(sr_conn_ctx_t **conn_ctx_p)
+cl_connection_create(size_t socket_cnt, sr_conn_ctx_t **conn_ctx_p)
 {
     sr_conn_ctx_t *connection = NULL;
     int rc = 0;
 
+    if (0 == socket_cnt) {
+        socket_cnt = 1;
+    }
+
     /* initialize the context */
     connection = calloc(1, sizeof(*connection));
     CHECK_NULL_NOMEM_RETURN(connection);
 
+    connection->sockets = calloc(socket_cnt, sizeof(*connection->sockets));
+    if (NULL == connection->sockets) {
+        SR_LOG_ERR_MSG("Cannot allocate memory for the socket pool of the connection.");
+        free(connection);
+        return SR_ERR_NOMEM;
+    }
+
     /* init connection mutext */
     rc = pthread_mutex_init(&connection->lock, NULL);
     if (0 != rc) {
         SR_LOG_ERR_MSG("Cannot initialize connection mutex.");
+        free(connection->sockets);
         free(connection);
         return SR_ERR_INIT_FAILED;
     }
 
-    connection->fd = -1;
+    /* init the sockets of the pool */
+    for (connection->socket_cnt = 0; connection->socket_cnt < socket_cnt; ++connection->socket_cnt) {
+        rc = pthread_mutex_init(&connection->sockets[connection->socket_cnt].lock, NULL);
+        if (0 != rc) {
+            SR_LOG_ERR_MSG("Cannot initialize socket mutex.");
+            cl_connection_cleanup(connection);
+            return SR_ERR_INIT_FAILED;
+        }
+        connection->sockets[connection->socket_cnt].fd = -1;
+    }
 
     *conn_ctx_p = connection;
     return SR_ERR_OK;
@@ -311,12 +347,16 @@ cl_connection_cleanup(sr_conn_ctx_t *conn_ctx)
             cl_session_cleanup(tmp->session);
         }
 
+        for (size_t i = 0; i < conn_ctx->socket_cnt; ++i) {
+            pthread_mutex_destroy(&conn_ctx->sockets[i].lock);
+            free(conn_ctx->sockets[i].msg_buf);
+            if (-1 != conn_ctx->sockets[i].fd) {
+                close(conn_ctx->sockets[i].fd);
+            }
+        }
         pthread_mutex_destroy(&conn_ctx->lock);
-        free(conn_ctx->msg_buf);
+        free(conn_ctx->sockets);
         free((void*)conn_ctx->dst_address);
-        if (-1 != conn_ctx->fd) {
-            close(conn_ctx->fd);
-        }
         free(conn_ctx);
     }
 }
@@ -344,7 +384,10 @@ cl_session_create(sr_conn_ctx_t *conn_ctx, sr_session_ctx_t **session_p)
     /* store the session in the connection */
     rc = cl_conn_add_session(conn_ctx, session);
     if (SR_ERR_OK != rc) {
-        SR_LOG_WRN_MSG("Error by adding the session to the connection session list.");
+        SR_LOG_ERR_MSG("Error by adding the session to the connection session list.");
+        pthread_mutex_destroy(&session->lock);
+        free(session);
+        return rc;
     }
 
     *session_p = session;
@@ -364,16 +407,17 @@ cl_session_cleanup(sr_session_ctx_t *session)
     }
 }
 
-int
-cl_socket_connect(sr_conn_ctx_t *conn_ctx, const char *socket_path)
+/**
+ * @brief Opens a new unix-domain socket connected to provided socket path.
+ */
+static int
+cl_socket_open(const char *socket_path, int *fd_p)
 {
     struct sockaddr_un addr;
     struct timeval tv = { 0, };
     int fd = -1, rc = -1;
 
-    CHECK_NULL_ARG2(socket_path, socket_path);
-
-    SR_LOG_DBG("Connecting to socket=%s", socket_path);
+    CHECK_NULL_ARG2(socket_path, fd_p);
 
     /* prepare a socket */
     fd = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -406,7 +450,31 @@ cl_socket_connect(sr_conn_ctx_t *conn_ctx, const char *socket_path)
         }
     }
 
-    conn_ctx->fd = fd;
+    *fd_p = fd;
+    return SR_ERR_OK;
+}
+
+int
+cl_socket_connect(sr_conn_ctx_t *conn_ctx, const char *socket_path)
+{
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG2(conn_ctx, socket_path);
+
+    SR_LOG_DBG("Connecting to socket=%s (socket pool size=%zu)", socket_path, conn_ctx->socket_cnt);
+
+    for (size_t i = 0; i < conn_ctx->socket_cnt; ++i) {
+        rc = cl_socket_open(socket_path, &conn_ctx->sockets[i].fd);
+        if (SR_ERR_OK != rc) {
+            /* close already opened sockets, the connection may be retried */
+            for (size_t j = 0; j < i; ++j) {
+                close(conn_ctx->sockets[j].fd);
+                conn_ctx->sockets[j].fd = -1;
+            }
+            return rc;
+        }
+    }
+
     return SR_ERR_OK;
 }
 
@@ -430,26 +498,26 @@ cl_version_verify(sr_conn_ctx_t *connection)
     /* send the request */
     SR_LOG_DBG("Sending %s request.", sr_gpb_operation_name(SR__OPERATION__VERSION_VERIFY));
 
-    pthread_mutex_lock(&connection->lock);
-    rc = cl_message_send(connection, msg_req);
+    pthread_mutex_lock(&connection->sockets[0].lock);
+    rc = cl_message_send(&connection->sockets[0], msg_req);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR("Unable to send the message with request (operation=%s).",
                    sr_gpb_operation_name(msg_req->request->operation));
-        pthread_mutex_unlock(&connection->lock);
+        pthread_mutex_unlock(&connection->sockets[0].lock);
         goto cleanup;
     }
 
     SR_LOG_DBG("%s request sent, waiting for response.", sr_gpb_operation_name(SR__OPERATION__VERSION_VERIFY));
 
     /* receive the response */
-    rc = cl_message_recv(connection, &msg_resp, NULL);
+    rc = cl_message_recv(&connection->sockets[0], &msg_resp, NULL);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR("Unable to receive the message with response (operation=%s).",
                    sr_gpb_operation_name(msg_req->request->operation));
-        pthread_mutex_unlock(&connection->lock);
+        pthread_mutex_unlock(&connection->sockets[0].lock);
         goto cleanup;
     }
-    pthread_mutex_unlock(&connection->lock);
+    pthread_mutex_unlock(&connection->sockets[0].lock);
 
     SR_LOG_DBG("%s response received, processing.", sr_gpb_operation_name(SR__OPERATION__VERSION_VERIFY));
 
@@ -488,33 +556,33 @@ cl_request_process(sr_session_ctx_t *session, Sr__Msg *msg_req, Sr__Msg **msg_re
 {
     int rc = SR_ERR_OK;
 
-    CHECK_NULL_ARG4(session, session->conn_ctx, msg_req, msg_resp);
+    CHECK_NULL_ARG5(session, session->conn_ctx, session->socket, msg_req, msg_resp);
 
     SR_LOG_DBG("Sending %s request.", sr_gpb_operation_name(expected_response_op));
 
-    pthread_mutex_lock(&session->conn_ctx->lock);
+    pthread_mutex_lock(&session->socket->lock);
 
     /* send the request */
-    rc = cl_message_send(session->conn_ctx, msg_req);
+    rc = cl_message_send(session->socket, msg_req);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR("Unable to send the message with request (session id=%"PRIu32", operation=%s).",
                 session->id, sr_gpb_operation_name(msg_req->request->operation));
-        pthread_mutex_unlock(&session->conn_ctx->lock);
+        pthread_mutex_unlock(&session->socket->lock);
         return rc;
     }
 
     SR_LOG_DBG("%s request sent, waiting for response.", sr_gpb_operation_name(expected_response_op));
 
     /* receive the response */
-    rc = cl_message_recv(session->conn_ctx, msg_resp, sr_mem_resp);
+    rc = cl_message_recv(session->socket, msg_resp, sr_mem_resp);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR("Unable to receive the message with response (session id=%"PRIu32", operation=%s).",
                 session->id, sr_gpb_operation_name(msg_req->request->operation));
-        pthread_mutex_unlock(&session->conn_ctx->lock);
+        pthread_mutex_unlock(&session->socket->lock);
         return rc;
     }
 
-    pthread_mutex_unlock(&session->conn_ctx->lock);
+    pthread_mutex_unlock(&session->socket->lock);
 
     SR_LOG_DBG("%s response received, processing.", sr_gpb_operation_name(expected_response_op));
 
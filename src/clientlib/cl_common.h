@@ -30,18 +30,29 @@
  */
 typedef struct cm_ctx_s cm_ctx_t;
 
+/**
+ * @brief One socket of a connection to sysrepo engine.
+ */
+typedef struct cl_socket_s {
+    int fd;                                  /**< File descriptor of the socket. */
+    pthread_mutex_t lock;                    /**< Mutex of the socket to guarantee that requests on the
+                                                  same socket are processed serially (one after another). */
+    uint8_t *msg_buf;                        /**< Buffer used for sending / receiving messages. */
+    size_t msg_buf_size;                     /**< Length of the message buffer. */
+    size_t session_cnt;                      /**< Count of sessions bound to the socket. */
+} cl_socket_t;
+
 /**
  * @brief Connection context used to identify a connection to sysrepo datastore.
  */
 typedef struct sr_conn_ctx_s {
-    int fd;                                  /**< File descriptor of the connection. */
+    cl_socket_t *sockets;                    /**< Pool of sockets of the connection. */
+    size_t socket_cnt;                       /**< Count of sockets in the pool. */
     const char *dst_address;                 /**< Destination socket address. */
     uint32_t dst_pid;                        /**< Destination PID (used only to to guarantee that there is
                                                   still the same process at the dst_address). */
-    pthread_mutex_t lock;                    /**< Mutex of the connection to guarantee that requests on the
-                                                  same connection are processed serially (one after another). */
-    uint8_t *msg_buf;                        /**< Buffer used for sending / receiving messages. */
-    size_t msg_buf_size;                     /**< Length of the message buffer. */
+    pthread_mutex_t lock;                    /**< Mutex of the connection protecting the session list
+                                                  and binding of the sessions to the sockets. */
     struct sr_session_list_s *session_list;  /**< Linked-list of associated sessions. */
     bool library_mode;                       /**< Determine if we are connected to sysrepo daemon
                                                   or our own sysrepo engine (library mode). */
@@ -52,6 +63,7 @@ typedef struct sr_conn_ctx_s {
  */
 typedef struct sr_session_ctx_s {
     sr_conn_ctx_t *conn_ctx;      /**< Associated connection context. */
+    cl_socket_t *socket;          /**< Socket of the connection that the session is bound to. */
     uint32_t id;                  /**< Assigned session identifier. */
     pthread_mutex_t lock;         /**< Mutex for the session context content. */
     sr_error_t last_error;        /**< Latest error code returned from an API call. */
@@ -73,11 +85,12 @@ typedef struct sr_session_list_s {
 /**
  * @brief Creates a new client library -local connection.
  *
+ * @param[in] socket_cnt Count of sockets in the pool of the connection (0 is treated as 1).
  * @param[out] conn_ctx Allocated connection context.
  *
  * @return Error code (SR_ERR_OK on success).
  */
-int cl_connection_create(sr_conn_ctx_t **conn_ctx);
+int cl_connection_create(size_t socket_cnt, sr_conn_ctx_t **conn_ctx);
 
 /**
  * @brief Cleans up a client library -local connection.
@@ -87,7 +100,8 @@ int cl_connection_create(sr_conn_ctx_t **conn_ctx);
 void cl_connection_cleanup(sr_conn_ctx_t *conn_ctx);
 
 /**
- * @brief Creates a new client library -local session.
+ * @brief Creates a new client library -local session and binds it to the least
+ * used socket of the connection.
  *
  * @param[in] conn_ctx Connection context acquired by ::cl_connection_create call.
  * @param[out] session Allocated session context.
@@ -104,7 +118,7 @@ int cl_session_create(sr_conn_ctx_t *conn_ctx, sr_session_ctx_t **session);
 void cl_session_cleanup(sr_session_ctx_t *session);
 
 /**
- * @brief Connects the client to provided unix-domain socket.
+ * @brief Connects all sockets of the connection to provided unix-domain socket.
  *
  * @param[in] conn_ctx Connection context acquired by ::cl_connection_create call.
  * @param[in] socket_path Destination unix-domain socket path.
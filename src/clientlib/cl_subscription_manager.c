@@ -45,6 +45,40 @@
 #define CL_SM_SUBSCRIPTION_ID_INVALID 0         /**< Invalid value of subscription id. */
 #define CL_SM_SUBSCRIPTION_ID_MAX_ATTEMPTS 100  /**< Maximum number of attempts to generate unused random subscription id. */
 
+#define CL_SM_WORKER_THREAD_CNT 4  /**< Number of worker threads calling callbacks of ::SR_SUBSCR_THREADED subscriptions. */
+#define CL_SM_DATA_SESSION_POOL_SIZE 4  /**< Maximum number of idle data sessions kept per data connection. */
+
+/**
+ * @brief Message waiting for processing in a worker thread.
+ */
+typedef struct cl_sm_job_s {
+    Sr__Msg *msg;              /**< Message to be processed. */
+    int fd;                    /**< File descriptor of the connection where the message has been received. */
+    uint32_t conn_id;          /**< Identifier of the connection where the message has been received. */
+    struct cl_sm_job_s *next;  /**< Next message of the same subscription. */
+} cl_sm_job_t;
+
+/**
+ * @brief Message prepared by a worker thread, waiting to be sent from the event loop.
+ */
+typedef struct cl_sm_reply_s {
+    uint8_t *data;               /**< Packed message including the preamble. */
+    size_t size;                 /**< Size of the data. */
+    int fd;                      /**< File descriptor of the connection where the message should be sent. */
+    uint32_t conn_id;            /**< Identifier of the connection where the message should be sent. */
+    struct cl_sm_reply_s *next;  /**< Next message in the queue. */
+} cl_sm_reply_t;
+
+/**
+ * @brief Data connection to a notification originator, used by data sessions provided to the callbacks.
+ */
+typedef struct cl_sm_data_conn_s {
+    sr_conn_ctx_t *connection;      /**< Connection to the notification originator. */
+    sr_btree_t *commit_sessions;    /**< Data sessions bound to a commit, organized by commit ID. */
+    sr_session_ctx_t *pool[CL_SM_DATA_SESSION_POOL_SIZE];  /**< Started data sessions not bound to any commit. */
+    size_t pool_cnt;                /**< Count of sessions in the pool. */
+} cl_sm_data_conn_t;
+
 /**
  * @brief Subscription Manager's unix-domain server context.
  */
@@ -69,8 +103,10 @@ typedef struct cl_sm_ctx_s {
     /** Binary tree used for fast subscriber connection lookup by file descriptor. */
     sr_btree_t *fd_btree;
 
-    /** Binary tree of data connections to sysrepo, organized by destination socket address. */
+    /** Binary tree of data connections to sysrepo (::cl_sm_data_conn_t), organized by destination socket address. */
     sr_btree_t *data_connection_btree;
+    /** Lock for the data connections binary tree. */
+    pthread_mutex_t data_connection_lock;
 
     /** Binary tree used for fast subscription lookup by id. */
     sr_btree_t *subscriptions_btree;
@@ -98,6 +134,29 @@ typedef struct cl_sm_ctx_s {
     ev_async server_ctx_watcher;
     /** Blocking synchronization of processing of all pending events */
     sr_fd_sm_terminated_cb local_watcher_terminate_cb;
+    /** Counter used to assign identifiers to new subscriber connections. */
+    uint32_t conn_id_cnt;
+
+    /** Worker threads calling callbacks of ::SR_SUBSCR_THREADED subscriptions (started on demand). */
+    pthread_t workers[CL_SM_WORKER_THREAD_CNT];
+    /** Count of running worker threads. */
+    size_t worker_cnt;
+    /** Lock for the worker queue, job queues of the subscriptions and the reply queue. */
+    pthread_mutex_t worker_lock;
+    /** Condition signalled when a subscription is added into the worker queue. */
+    pthread_cond_t worker_cond;
+    /** First subscription with messages waiting for a worker thread. */
+    cl_sm_subscription_ctx_t *worker_queue_first;
+    /** Last subscription with messages waiting for a worker thread. */
+    cl_sm_subscription_ctx_t *worker_queue_last;
+    /** TRUE if the worker threads should terminate. */
+    bool workers_stop;
+    /** First message waiting to be sent from the event loop on behalf of a worker thread. */
+    cl_sm_reply_t *replies_first;
+    /** Last message waiting to be sent from the event loop on behalf of a worker thread. */
+    cl_sm_reply_t *replies_last;
+    /** Watcher for messages prepared by worker threads. */
+    ev_async reply_watcher;
 } cl_sm_ctx_t;
 
 /**
@@ -117,10 +176,13 @@ typedef struct cl_sm_conn_ctx_s {
     cl_sm_ctx_t *sm_ctx;      /**< Pointer to Subscription Manger context. */
     int fd;                   /**< File descriptor of the connection. */
     cl_sm_buffer_t in_buff;   /**< Input buffer. If not empty, there is some received data to be processed. */
+    size_t in_frame;          /**< Position of the message being received in the input buffer. */
     cl_sm_buffer_t out_buff;  /**< Output buffer. If not empty, there is some data to be sent when receiver is ready. */
     ev_io read_watcher;       /**< Watcher for readable events on connection's socket. */
     ev_io write_watcher;      /**< Watcher for writable events on connection's socket. */
     bool close_requested;     /**< TRUE if connection close has been requested. */
+    uint32_t id;              /**< Identifier of the connection (distinguishes connections reusing the same fd). */
+    bool detached;            /**< TRUE if this is a copy of the connection used from a worker thread. */
 } cl_sm_conn_ctx_t;
 
 /**
@@ -194,22 +256,93 @@ cl_sm_subscription_cmp_id(const void *a, const void *b)
     }
 }
 
+/**
+ * @brief Releases a reference to the subscription. Releases all resources
+ * held by the subscription when the last reference is released.
+ */
+static void
+cl_sm_subscription_unref(cl_sm_subscription_ctx_t *subscription)
+{
+    if ((NULL != subscription) && (1 == ATOMIC_DEC(&subscription->ref_count))) {
+        pthread_mutex_destroy(&subscription->cb_lock);
+        free((void*)subscription->module_name);
+        free((void*)subscription->xpath);
+        free(subscription);
+    }
+}
+
 /**
  * @brief Cleans up a subscription entry.
- * Releases all resources held Subscription Manager.
+ * Releases the reference held by the subscriptions binary tree.
  * @note Called automatically when a node from the binary tree is removed
  * (which is also when the tree itself is being destroyed).
  */
 static void
 cl_sm_subscription_cleanup_internal(void *subscription_p)
+{
+    cl_sm_subscription_unref((cl_sm_subscription_ctx_t *)subscription_p);
+}
+
+/**
+ * @brief Returns TRUE if callbacks of the subscription are called from worker threads.
+ */
+static bool
+cl_sm_subscription_threaded(const cl_sm_ctx_t *sm_ctx, const cl_sm_subscription_ctx_t *subscription)
+{
+    return (!sm_ctx->local_fd_watcher) && (subscription->opts & SR_SUBSCR_THREADED);
+}
+
+/**
+ * @brief Finds the subscription by its id and locks it for the execution of its callback.
+ * Callbacks of ::SR_SUBSCR_THREADED subscriptions are serialized per subscription,
+ * callbacks of all other subscriptions are serialized by the subscriptions lock.
+ * Returns NULL if no such subscription exists. Release by ::cl_sm_subscription_unlock.
+ */
+static cl_sm_subscription_ctx_t *
+cl_sm_subscription_lock(cl_sm_ctx_t *sm_ctx, uint32_t subscription_id)
 {
     cl_sm_subscription_ctx_t *subscription = NULL;
+    cl_sm_subscription_ctx_t subscription_lookup = { 0, };
 
-    if (NULL != subscription_p) {
-        subscription = (cl_sm_subscription_ctx_t *)subscription_p;
-        free((void*)subscription->module_name);
-        free((void*)subscription->xpath);
-        free(subscription);
+    pthread_mutex_lock(&sm_ctx->subscriptions_lock);
+
+    /* find the subscription according to id */
+    subscription_lookup.id = subscription_id;
+    subscription = sr_btree_search(sm_ctx->subscriptions_btree, &subscription_lookup);
+    if (NULL == subscription) {
+        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+        SR_LOG_ERR("No matching subscription for subscription id=%"PRIu32".", subscription_id);
+        return NULL;
+    }
+
+    if (cl_sm_subscription_threaded(sm_ctx, subscription)) {
+        /* do not block other subscriptions while the callback is running */
+        ATOMIC_INC(&subscription->ref_count);
+        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+        pthread_mutex_lock(&subscription->cb_lock);
+        if (subscription->removed) {
+            /* unsubscribed in the meantime */
+            pthread_mutex_unlock(&subscription->cb_lock);
+            cl_sm_subscription_unref(subscription);
+            SR_LOG_ERR("No matching subscription for subscription id=%"PRIu32".", subscription_id);
+            return NULL;
+        }
+    }
+
+    return subscription;
+}
+
+/**
+ * @brief Unlocks the subscription locked by ::cl_sm_subscription_lock.
+ */
+static void
+cl_sm_subscription_unlock(cl_sm_ctx_t *sm_ctx, cl_sm_subscription_ctx_t *subscription)
+{
+    if (cl_sm_subscription_threaded(sm_ctx, subscription)) {
+        pthread_mutex_unlock(&subscription->cb_lock);
+        cl_sm_subscription_unref(subscription);
+    } else {
+        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
     }
 }
 
@@ -222,15 +355,15 @@ cl_sm_data_connection_cmp_dst(const void *a, const void *b)
 {
     assert(a);
     assert(b);
-    sr_conn_ctx_t *conn_a = (sr_conn_ctx_t*)a;
-    sr_conn_ctx_t *conn_b = (sr_conn_ctx_t*)b;
+    cl_sm_data_conn_t *conn_a = (cl_sm_data_conn_t*)a;
+    cl_sm_data_conn_t *conn_b = (cl_sm_data_conn_t*)b;
 
     int res = 0;
 
-    assert(conn_a->dst_address);
-    assert(conn_b->dst_address);
+    assert(conn_a->connection && conn_a->connection->dst_address);
+    assert(conn_b->connection && conn_b->connection->dst_address);
 
-    res = strcmp(conn_a->dst_address, conn_b->dst_address);
+    res = strcmp(conn_a->connection->dst_address, conn_b->connection->dst_address);
     if (res == 0) {
         return 0;
     } else if (res < 0) {
@@ -246,9 +379,37 @@ cl_sm_data_connection_cmp_dst(const void *a, const void *b)
  * (which is also when the tree itself is being destroyed).
  */
 static void
-cl_sm_data_connection_cleanup(void *connection)
+cl_sm_data_connection_cleanup(void *data_conn_p)
+{
+    cl_sm_data_conn_t *data_conn = (cl_sm_data_conn_t*)data_conn_p;
+
+    if (NULL != data_conn) {
+        /* the sessions are owned by the connection */
+        sr_btree_cleanup(data_conn->commit_sessions);
+        cl_connection_cleanup(data_conn->connection);
+        free(data_conn);
+    }
+}
+
+/**
+ * @brief Compares two data sessions by the commit ID they are bound to
+ * (used by lookups in commit sessions binary tree).
+ */
+static int
+cl_sm_data_session_cmp_commit(const void *a, const void *b)
 {
-    cl_connection_cleanup(connection);
+    assert(a);
+    assert(b);
+    sr_session_ctx_t *sess_a = (sr_session_ctx_t*)a;
+    sr_session_ctx_t *sess_b = (sr_session_ctx_t*)b;
+
+    if (sess_a->commit_id == sess_b->commit_id) {
+        return 0;
+    } else if (sess_a->commit_id < sess_b->commit_id) {
+        return -1;
+    } else {
+        return 1;
+    }
 }
 
 /**
@@ -329,6 +490,7 @@ cl_sm_connection_add(cl_sm_ctx_t *sm_ctx, int fd, cl_sm_conn_ctx_t **conn_p)
 
     conn->sm_ctx = sm_ctx;
     conn->fd = fd;
+    conn->id = ++sm_ctx->conn_id_cnt;
 
     rc = sr_btree_insert(sm_ctx->fd_btree, conn);
     CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot insert new entry into fd binary tree (duplicate fd?).");
@@ -441,6 +603,131 @@ cl_sm_conn_out_buff_flush(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn)
     return rc;
 }
 
+/**
+ * @brief Connects to the notification originator at given address.
+ */
+static int
+cl_sm_data_connection_create(const char *source_address, uint32_t source_pid, cl_sm_data_conn_t **data_conn_p)
+{
+    cl_sm_data_conn_t *data_conn = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG2(source_address, data_conn_p);
+
+    SR_LOG_DBG("Connecting to the notification originator at '%s'.", source_address);
+
+    data_conn = calloc(1, sizeof(*data_conn));
+    CHECK_NULL_NOMEM_RETURN(data_conn);
+
+    rc = sr_btree_init(cl_sm_data_session_cmp_commit, NULL, &data_conn->commit_sessions);
+    if (SR_ERR_OK == rc) {
+        rc = cl_connection_create(1, &data_conn->connection);
+    }
+    if (SR_ERR_OK == rc) {
+        data_conn->connection->dst_address = strdup(source_address);
+        CHECK_NULL_NOMEM_ERROR(data_conn->connection->dst_address, rc);
+        data_conn->connection->dst_pid = source_pid;
+    }
+    if (SR_ERR_OK == rc) {
+        rc = cl_socket_connect(data_conn->connection, data_conn->connection->dst_address);
+    }
+    if (SR_ERR_OK == rc) {
+        rc = cl_version_verify(data_conn->connection);
+    }
+
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Unable to connect to the notification originator at '%s'.", source_address);
+        cl_sm_data_connection_cleanup(data_conn);
+        return rc;
+    }
+
+    *data_conn_p = data_conn;
+    return rc;
+}
+
+/**
+ * @brief Binds a data session to the specified commit. Starts a new session if needed,
+ * a session from the pool is just rebound to the commit by a session-set-opts request.
+ */
+static int
+cl_sm_data_session_bind(sr_conn_ctx_t *connection, sr_session_ctx_t *pooled_session, uint32_t commit_id,
+        sr_session_ctx_t **session_p)
+{
+    sr_session_ctx_t *session = pooled_session;
+    Sr__Msg *msg_req = NULL, *msg_resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG2(connection, session_p);
+
+    if (NULL == session) {
+        SR_LOG_DBG("Creating a new data session at '%s'.", connection->dst_address);
+        rc = cl_session_create(connection, &session);
+        CHECK_RC_MSG_RETURN(rc, "Unable to create a new data session.");
+    } else {
+        SR_LOG_DBG("Rebinding pooled data session id=%"PRIu32" to commit id=%"PRIu32".", session->id, commit_id);
+    }
+
+    /* prepare session_start / session_set_opts message */
+    rc = sr_mem_new(0, &sr_mem);
+    if (SR_ERR_OK == rc) {
+        if (NULL == pooled_session) {
+            rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__SESSION_START, /* undefined session id */ 0, &msg_req);
+        } else {
+            rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__SESSION_SET_OPTS, session->id, &msg_req);
+        }
+    }
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Cannot allocate data session request.");
+        sr_mem_free(sr_mem);
+        goto cleanup;
+    }
+
+    if (NULL == pooled_session) {
+        msg_req->request->session_start_req->options = SR__SESSION_FLAGS__SESS_NOTIFICATION;
+        if (0 != commit_id) {
+            msg_req->request->session_start_req->commit_id = commit_id;
+            msg_req->request->session_start_req->has_commit_id = true;
+        }
+        msg_req->request->session_start_req->datastore = SR__DATA_STORE__RUNNING;
+    } else {
+        msg_req->request->session_set_opts_req->options = SR__SESSION_FLAGS__SESS_NOTIFICATION;
+        msg_req->request->session_set_opts_req->commit_id = commit_id;
+        msg_req->request->session_set_opts_req->has_commit_id = true;
+    }
+
+    /* send the request and receive the response */
+    rc = cl_request_process(session, msg_req, &msg_resp, NULL, msg_req->request->operation);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Error by processing of the data session request.");
+
+    if (NULL == pooled_session) {
+        session->id = msg_resp->response->session_start_resp->session_id;
+        session->notif_session = true;
+    }
+    session->commit_id = commit_id;
+
+cleanup:
+    if (NULL != msg_req) {
+        sr_msg_free(msg_req);
+    }
+    if (NULL != msg_resp) {
+        sr_msg_free(msg_resp);
+    }
+    if (SR_ERR_OK != rc) {
+        if (NULL != pooled_session) {
+            /* the pooled session still exists in the engine, stop it there before dropping it */
+            if (SR_ERR_OK != sr_session_stop(session)) {
+                cl_session_cleanup(session);
+            }
+        } else {
+            cl_session_cleanup(session);
+        }
+    } else {
+        *session_p = session;
+    }
+    return rc;
+}
+
 /**
  * @brief Get (prepare) configuration session that can be used from notification callback.
  */
@@ -449,146 +736,204 @@ cl_sm_get_data_session(cl_sm_ctx_t *sm_ctx, cl_sm_subscription_ctx_t *subscripti
         const char *source_address, uint32_t source_pid, uint32_t commit_id,
         sr_session_ctx_t **config_session_p)
 {
-    sr_conn_ctx_t *connection = NULL;
+    cl_sm_data_conn_t *data_conn = NULL;
+    cl_sm_data_conn_t data_conn_lookup = { 0, };
     sr_conn_ctx_t connection_lookup = { 0, };
+    sr_session_ctx_t session_lookup = { 0, };
     sr_session_ctx_t *session = NULL;
-    sr_session_list_t *tmp = NULL;
-    Sr__Msg *msg_req = NULL, *msg_resp = NULL;
-    sr_mem_ctx_t *sr_mem = NULL;
     int rc = SR_ERR_OK;
 
     CHECK_NULL_ARG4(sm_ctx, subscription, source_address, config_session_p);
 
+    pthread_mutex_lock(&sm_ctx->data_connection_lock);
+
     /* find a connection matching with provided address */
     connection_lookup.dst_address = source_address;
-    connection = sr_btree_search(sm_ctx->data_connection_btree, &connection_lookup);
+    data_conn_lookup.connection = &connection_lookup;
+    data_conn = sr_btree_search(sm_ctx->data_connection_btree, &data_conn_lookup);
 
-    if (NULL != connection && connection->dst_pid != source_pid) {
+    if (NULL != data_conn && data_conn->connection->dst_pid != source_pid) {
         /* new PID on the destination address - reconnect */
         SR_LOG_DBG("New PID on the destination address '%s' - reconnect.", source_address);
-        sr_btree_delete(sm_ctx->data_connection_btree, connection);
-        connection = NULL;
+        sr_btree_delete(sm_ctx->data_connection_btree, data_conn);
+        data_conn = NULL;
     }
 
-    if (NULL == connection) {
+    if (NULL == data_conn) {
         /* connection not found, create a new one */
-        SR_LOG_DBG("Connecting to the notification originator at '%s'.", source_address);
-        rc = cl_connection_create(&connection);
+        rc = cl_sm_data_connection_create(source_address, source_pid, &data_conn);
         if (SR_ERR_OK == rc) {
-            connection->dst_address = strdup(source_address);
-            CHECK_NULL_NOMEM_ERROR(connection->dst_address, rc);
-            connection->dst_pid = source_pid;
-        }
-        if (SR_ERR_OK == rc) {
-            rc = cl_socket_connect(connection, connection->dst_address);
-        }
-        if (SR_ERR_OK == rc) {
-            rc = cl_version_verify(connection);
-        }
-        if (SR_ERR_OK == rc) {
-            rc = sr_btree_insert(sm_ctx->data_connection_btree, connection);
+            rc = sr_btree_insert(sm_ctx->data_connection_btree, data_conn);
+            if (SR_ERR_OK != rc) {
+                cl_sm_data_connection_cleanup(data_conn);
+            }
         }
         if (SR_ERR_OK != rc) {
-            SR_LOG_ERR("Unable to connect to the notification originator at '%s'.", source_address);
-            cl_connection_cleanup(connection);
+            pthread_mutex_unlock(&sm_ctx->data_connection_lock);
             return rc;
         }
     }
 
-    /* try to find the session matching with the commit ID in connection */
-    if (NULL != connection->session_list) {
-        tmp = connection->session_list;
-        while (NULL != tmp) {
-            if ((NULL != tmp->session) && (tmp->session->commit_id == commit_id)) {
-                session = tmp->session;
-                break;
-            }
-            tmp = tmp->next;
-        }
-    }
-    /* if the matching session is not already open, open a new session */
-    if (NULL == session) {
-        /* session not found, create a new one */
-        SR_LOG_DBG("Creating a new data session at '%s'.", source_address);
-        rc = cl_session_create(connection, &session);
+    /* try to find the session bound to the commit ID */
+    session_lookup.commit_id = commit_id;
+    session = sr_btree_search(data_conn->commit_sessions, &session_lookup);
 
-        /* prepare session_start message */
-        rc = sr_mem_new(0, &sr_mem);
+    /* if there is no session bound to the commit, bind a pooled one or start a new one */
+    if (NULL == session) {
+        rc = cl_sm_data_session_bind(data_conn->connection,
+                (data_conn->pool_cnt > 0 ? data_conn->pool[--data_conn->pool_cnt] : NULL), commit_id, &session);
         if (SR_ERR_OK == rc) {
-            rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__SESSION_START, /* undefined session id */ 0, &msg_req);
+            rc = sr_btree_insert(data_conn->commit_sessions, session);
+            if (SR_ERR_OK != rc) {
+                sr_session_stop(session);
+            }
         }
         if (SR_ERR_OK != rc) {
-            SR_LOG_ERR_MSG("Cannot allocate session_start message.");
-            cl_session_cleanup(session);
+            pthread_mutex_unlock(&sm_ctx->data_connection_lock);
             return rc;
         }
-        msg_req->request->session_start_req->options = SR__SESSION_FLAGS__SESS_NOTIFICATION;
-        if (0 != commit_id) {
-            msg_req->request->session_start_req->commit_id = commit_id;
-            msg_req->request->session_start_req->has_commit_id = true;
-        }
-        msg_req->request->session_start_req->datastore = SR__DATA_STORE__RUNNING;
-
-        /* send the request and receive the response */
-        rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__SESSION_START);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR_MSG("Error by processing of session_start request.");
-            sr_msg_free(msg_req);
-            cl_session_cleanup(session);
-            return rc;
-        }
-
-        session->id = msg_resp->response->session_start_resp->session_id;
-        session->notif_session = true;
-        session->commit_id = commit_id;
-
-        sr_msg_free(msg_req);
-        sr_msg_free(msg_resp);
     }
 
+    pthread_mutex_unlock(&sm_ctx->data_connection_lock);
+
     subscription->data_session = session;
     *config_session_p = session;
     return rc;
 }
 
+/**
+ * @brief Releases the data session bound to the commit. The session is returned
+ * to the pool of the connection, or stopped if the pool is full.
+ */
 static int
 cl_sm_close_data_session(cl_sm_ctx_t *sm_ctx, cl_sm_subscription_ctx_t *subscription,
         const char *source_address, uint32_t commit_id)
 {
-    sr_conn_ctx_t *connection = NULL;
+    cl_sm_data_conn_t *data_conn = NULL;
+    cl_sm_data_conn_t data_conn_lookup = { 0, };
     sr_conn_ctx_t connection_lookup = { 0, };
+    sr_session_ctx_t session_lookup = { 0, };
     sr_session_ctx_t *session = NULL;
-    sr_session_list_t *tmp = NULL;
 
     CHECK_NULL_ARG3(sm_ctx, subscription, source_address);
 
+    pthread_mutex_lock(&sm_ctx->data_connection_lock);
+
     /* find a connection matching with provided address */
     connection_lookup.dst_address = source_address;
-    connection = sr_btree_search(sm_ctx->data_connection_btree, &connection_lookup);
+    data_conn_lookup.connection = &connection_lookup;
+    data_conn = sr_btree_search(sm_ctx->data_connection_btree, &data_conn_lookup);
 
-    if (NULL == connection || NULL == connection->session_list) {
-        /* no connection / sessions for this source address */
-        return SR_ERR_OK;
+    if (NULL != data_conn) {
+        /* try to find the session bound to the commit ID */
+        session_lookup.commit_id = commit_id;
+        session = sr_btree_search(data_conn->commit_sessions, &session_lookup);
     }
 
-    /* try to find the session matching with the commit ID in connection */
-    tmp = connection->session_list;
-    while (NULL != tmp) {
-        if ((NULL != tmp->session) && (tmp->session->commit_id == commit_id)) {
-            session = tmp->session;
-            break;
+    if (NULL != session) {
+        sr_btree_delete(data_conn->commit_sessions, session);
+        if (data_conn->pool_cnt < CL_SM_DATA_SESSION_POOL_SIZE) {
+            /* keep the session for the next commit */
+            data_conn->pool[data_conn->pool_cnt++] = session;
+        } else {
+            /* stop the session including sending of a session-stop request */
+            sr_session_stop(session);
         }
-        tmp = tmp->next;
     }
 
-    if (NULL != session) {
-        /* stop the session including sending of a session-stop request */
-        sr_session_stop(session);
+    pthread_mutex_unlock(&sm_ctx->data_connection_lock);
+
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Packs a message produced by a worker thread and passes it to the event loop,
+ * which sends it to the connection it belongs to.
+ */
+static int
+cl_sm_reply_enqueue(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg, size_t msg_size)
+{
+    cl_sm_reply_t *reply = NULL;
+
+    CHECK_NULL_ARG3(sm_ctx, conn, msg);
+
+    reply = calloc(1, sizeof(*reply));
+    CHECK_NULL_NOMEM_RETURN(reply);
+
+    reply->data = malloc(SR_MSG_PREAM_SIZE + msg_size);
+    if (NULL == reply->data) {
+        free(reply);
+        SR_LOG_ERR_MSG("Unable to allocate memory for the message.");
+        return SR_ERR_NOMEM;
     }
 
+    /* write the preamble and the message */
+    sr_uint32_to_buff(msg_size, reply->data);
+    sr__msg__pack(msg, (reply->data + SR_MSG_PREAM_SIZE));
+    reply->size = SR_MSG_PREAM_SIZE + msg_size;
+    reply->fd = conn->fd;
+    reply->conn_id = conn->id;
+
+    pthread_mutex_lock(&sm_ctx->worker_lock);
+    if (NULL == sm_ctx->replies_last) {
+        sm_ctx->replies_first = reply;
+    } else {
+        sm_ctx->replies_last->next = reply;
+    }
+    sm_ctx->replies_last = reply;
+    pthread_mutex_unlock(&sm_ctx->worker_lock);
+
+    /* wake up the event loop */
+    ev_async_send(sm_ctx->event_loop, &sm_ctx->reply_watcher);
+
     return SR_ERR_OK;
 }
 
+/**
+ * @brief Callback called by the event loop watcher when worker threads have prepared some messages to be sent.
+ */
+static void
+cl_sm_reply_cb(struct ev_loop *loop, ev_async *w, int revents)
+{
+    cl_sm_ctx_t *sm_ctx = NULL;
+    cl_sm_reply_t *reply = NULL, *next = NULL;
+    cl_sm_conn_ctx_t tmp_conn = { 0, };
+    cl_sm_conn_ctx_t *conn = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG_VOID3(loop, w, w->data);
+    sm_ctx = (cl_sm_ctx_t*)w->data;
+
+    pthread_mutex_lock(&sm_ctx->worker_lock);
+    reply = sm_ctx->replies_first;
+    sm_ctx->replies_first = NULL;
+    sm_ctx->replies_last = NULL;
+    pthread_mutex_unlock(&sm_ctx->worker_lock);
+
+    while (NULL != reply) {
+        /* find matching connection context */
+        tmp_conn.fd = reply->fd;
+        conn = sr_btree_search(sm_ctx->fd_btree, &tmp_conn);
+        if ((NULL == conn) || (conn->id != reply->conn_id)) {
+            SR_LOG_WRN("Subscriber connection on fd=%d has been closed, dropping the message.", reply->fd);
+        } else {
+            rc = cl_sm_conn_buffer_expand(conn, &conn->out_buff, reply->size);
+            if (SR_ERR_OK == rc) {
+                memcpy((conn->out_buff.data + conn->out_buff.pos), reply->data, reply->size);
+                conn->out_buff.pos += reply->size;
+                rc = cl_sm_conn_out_buff_flush(sm_ctx, conn);
+            }
+            if ((conn->close_requested) || (SR_ERR_OK != rc)) {
+                cl_sm_conn_close(sm_ctx, conn);
+            }
+        }
+        next = reply->next;
+        free(reply->data);
+        free(reply);
+        reply = next;
+    }
+}
+
 /**
  * @brief Sends a message to the recipient identified by session context.
  */
@@ -610,6 +955,11 @@ cl_sm_msg_send_connection(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *
         return SR_ERR_INTERNAL;
     }
 
+    if (conn->detached) {
+        /* called from a worker thread - the connection is owned by the event loop */
+        return cl_sm_reply_enqueue(sm_ctx, conn, msg, msg_size);
+    }
+
     /* expand the buffer if needed */
     rc = cl_sm_conn_buffer_expand(conn, buff, SR_MSG_PREAM_SIZE + msg_size);
 
@@ -642,7 +992,6 @@ static int
 cl_sm_notif_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
 {
     cl_sm_subscription_ctx_t *subscription = NULL;
-    cl_sm_subscription_ctx_t subscription_lookup = { 0, };
     sr_session_ctx_t *data_session = NULL;
     Sr__Msg *ack_msg = NULL;
     sr_mem_ctx_t *sr_mem = NULL;
@@ -654,21 +1003,16 @@ cl_sm_notif_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
     SR_LOG_DBG("Received a notification for subscription id=%"PRIu32" (source address='%s').",
             msg->notification->subscription_id, msg->notification->source_address);
 
-    pthread_mutex_lock(&sm_ctx->subscriptions_lock);
-
     /* find the subscription according to id */
-    subscription_lookup.id = msg->notification->subscription_id;
-    subscription = sr_btree_search(sm_ctx->subscriptions_btree, &subscription_lookup);
+    subscription = cl_sm_subscription_lock(sm_ctx, msg->notification->subscription_id);
     if (NULL == subscription) {
-        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
-        SR_LOG_ERR("No matching subscription for subscription id=%"PRIu32".", msg->notification->subscription_id);
         return SR_ERR_INVAL_ARG;
     }
 
     /* validate the message according to the subscription type */
     rc = sr_gpb_msg_validate_notif(msg, subscription->type);
     if (SR_ERR_OK != rc) {
-        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+        cl_sm_subscription_unlock(sm_ctx, subscription);
         SR_LOG_ERR("Received notification message is not valid for subscription id=%"PRIu32".", msg->notification->subscription_id);
         return SR_ERR_INVAL_ARG;
     }
@@ -778,7 +1122,7 @@ ack:
         }
     }
 
-    pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+    cl_sm_subscription_unlock(sm_ctx, subscription);
 
     return rc;
 }
@@ -790,7 +1134,6 @@ static int
 cl_sm_dp_request_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
 {
     cl_sm_subscription_ctx_t *subscription = NULL;
-    cl_sm_subscription_ctx_t subscription_lookup = { 0, };
     Sr__Msg *resp = NULL;
     sr_mem_ctx_t *sr_mem_resp = NULL;
     sr_val_t *values = NULL;
@@ -801,14 +1144,9 @@ cl_sm_dp_request_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *m
 
     SR_LOG_DBG("Received a data-provide request for subscription id=%"PRIu32".", msg->request->data_provide_req->subscription_id);
 
-    pthread_mutex_lock(&sm_ctx->subscriptions_lock);
-
     /* find the subscription according to id */
-    subscription_lookup.id = msg->request->data_provide_req->subscription_id;
-    subscription = sr_btree_search(sm_ctx->subscriptions_btree, &subscription_lookup);
+    subscription = cl_sm_subscription_lock(sm_ctx, msg->request->data_provide_req->subscription_id);
     if (NULL == subscription) {
-        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
-        SR_LOG_ERR("No matching subscription for subscription id=%"PRIu32".", msg->request->data_provide_req->subscription_id);
         goto cleanup;
     }
 
@@ -821,7 +1159,7 @@ cl_sm_dp_request_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *m
             msg->request->data_provide_req->original_xpath,
             subscription->private_ctx);
 
-    pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+    cl_sm_subscription_unlock(sm_ctx, subscription);
 
     /* allocate the response and send it */
     if (NULL != values) {
@@ -860,7 +1198,6 @@ static int
 cl_sm_rpc_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
 {
     cl_sm_subscription_ctx_t *subscription = NULL;
-    cl_sm_subscription_ctx_t subscription_lookup = { 0, };
     Sr__Msg *resp = NULL;
     sr_val_t *input = NULL, *output = NULL;
     sr_node_t *input_tree = NULL, *output_tree = NULL;
@@ -889,14 +1226,9 @@ cl_sm_rpc_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
     }
     CHECK_RC_LOG_GOTO(rc, cleanup, "Error by copying %s input arguments from GPB.", op_name);
 
-    pthread_mutex_lock(&sm_ctx->subscriptions_lock);
-
     /* find the subscription according to id */
-    subscription_lookup.id = msg->request->rpc_req->subscription_id;
-    subscription = sr_btree_search(sm_ctx->subscriptions_btree, &subscription_lookup);
+    subscription = cl_sm_subscription_lock(sm_ctx, msg->request->rpc_req->subscription_id);
     if (NULL == subscription) {
-        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
-        SR_LOG_ERR("No matching subscription for subscription id=%"PRIu32".", msg->request->rpc_req->subscription_id);
         goto cleanup;
     }
 
@@ -916,7 +1248,7 @@ cl_sm_rpc_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
                         subscription->private_ctx);
     }
 
-    pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+    cl_sm_subscription_unlock(sm_ctx, subscription);
 
     /* allocate the response and send it */
     if (NULL != output) {
@@ -964,7 +1296,6 @@ static int
 cl_sm_event_notif_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
 {
     cl_sm_subscription_ctx_t *subscription = NULL;
-    cl_sm_subscription_ctx_t subscription_lookup = { 0, };
     sr_ev_notif_type_t notif_type = 0;
     sr_val_t *values = NULL;
     sr_node_t *trees = NULL;
@@ -990,15 +1321,9 @@ cl_sm_event_notif_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *
     }
     CHECK_RC_MSG_GOTO(rc, cleanup, "Error by copying event notification input data from GPB.");
 
-    pthread_mutex_lock(&sm_ctx->subscriptions_lock);
-
     /* find the subscription according to id */
-    subscription_lookup.id = msg->request->event_notif_req->subscription_id;
-    subscription = sr_btree_search(sm_ctx->subscriptions_btree, &subscription_lookup);
+    subscription = cl_sm_subscription_lock(sm_ctx, msg->request->event_notif_req->subscription_id);
     if (NULL == subscription) {
-        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
-        SR_LOG_ERR("No matching subscription for subscription id=%"PRIu32".",
-                msg->request->event_notif_req->subscription_id);
         goto cleanup;
     }
 
@@ -1040,7 +1365,7 @@ cl_sm_event_notif_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *
         }
     }
 
-    pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+    cl_sm_subscription_unlock(sm_ctx, subscription);
 
 cleanup:
     sr_free_values(values, values_cnt);
@@ -1048,6 +1373,271 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Processes an unpacked message received on the connection.
+ */
+static int
+cl_sm_msg_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, Sr__Msg *msg)
+{
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG3(sm_ctx, conn, msg);
+
+    /* check the message */
+    if (SR__MSG__MSG_TYPE__NOTIFICATION == msg->type) {
+        /* notification */
+        rc = cl_sm_notif_process(sm_ctx, conn, msg);
+    } else if ((SR__MSG__MSG_TYPE__REQUEST == msg->type) && (SR__OPERATION__DATA_PROVIDE == msg->request->operation)) {
+        /* data-provide request */
+        rc = cl_sm_dp_request_process(sm_ctx, conn, msg);
+    } else if ((SR__MSG__MSG_TYPE__REQUEST == msg->type) &&
+                (SR__OPERATION__RPC == msg->request->operation || SR__OPERATION__ACTION == msg->request->operation)) {
+        /* RPC/Action request */
+        rc = cl_sm_rpc_process(sm_ctx, conn, msg);
+    } else if ((SR__MSG__MSG_TYPE__REQUEST == msg->type) && (SR__OPERATION__EVENT_NOTIF == msg->request->operation)) {
+        /* event notification */
+        rc = cl_sm_event_notif_process(sm_ctx, conn, msg);
+    } else {
+        SR_LOG_ERR("Invalid or unexpected message received (conn=%p).", (void*)conn);
+        rc = SR_ERR_INVAL_ARG;
+    }
+
+    return rc;
+}
+
+/**
+ * @brief Returns the id of the subscription that the message is addressed to
+ * (CL_SM_SUBSCRIPTION_ID_INVALID if it cannot be determined).
+ */
+static uint32_t
+cl_sm_msg_subscription_id(const Sr__Msg *msg)
+{
+    if ((SR__MSG__MSG_TYPE__NOTIFICATION == msg->type) && (NULL != msg->notification)) {
+        return msg->notification->subscription_id;
+    }
+    if ((SR__MSG__MSG_TYPE__REQUEST == msg->type) && (NULL != msg->request)) {
+        if ((SR__OPERATION__DATA_PROVIDE == msg->request->operation) && (NULL != msg->request->data_provide_req)) {
+            return msg->request->data_provide_req->subscription_id;
+        }
+        if ((SR__OPERATION__RPC == msg->request->operation || SR__OPERATION__ACTION == msg->request->operation) &&
+                (NULL != msg->request->rpc_req)) {
+            return msg->request->rpc_req->subscription_id;
+        }
+        if ((SR__OPERATION__EVENT_NOTIF == msg->request->operation) && (NULL != msg->request->event_notif_req)) {
+            return msg->request->event_notif_req->subscription_id;
+        }
+    }
+    return CL_SM_SUBSCRIPTION_ID_INVALID;
+}
+
+/**
+ * @brief Processes the messages queued for a subscription, one at a time, in the worker thread.
+ */
+static void *
+cl_sm_worker_thread(void *sm_ctx_p)
+{
+    cl_sm_ctx_t *sm_ctx = (cl_sm_ctx_t*)sm_ctx_p;
+    cl_sm_subscription_ctx_t *subscription = NULL;
+    cl_sm_conn_ctx_t conn = { 0, };
+    cl_sm_job_t *job = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG_NORET(rc, sm_ctx);
+    if (SR_ERR_OK != rc) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&sm_ctx->worker_lock);
+
+    while (true) {
+        while (!sm_ctx->workers_stop && (NULL == sm_ctx->worker_queue_first)) {
+            pthread_cond_wait(&sm_ctx->worker_cond, &sm_ctx->worker_lock);
+        }
+        if (sm_ctx->workers_stop) {
+            break;
+        }
+
+        /* take the first subscription from the queue and its oldest message */
+        subscription = sm_ctx->worker_queue_first;
+        sm_ctx->worker_queue_first = subscription->next_scheduled;
+        if (NULL == sm_ctx->worker_queue_first) {
+            sm_ctx->worker_queue_last = NULL;
+        }
+        subscription->next_scheduled = NULL;
+
+        job = subscription->jobs_first;
+        subscription->jobs_first = job->next;
+        if (NULL == subscription->jobs_first) {
+            subscription->jobs_last = NULL;
+        }
+
+        pthread_mutex_unlock(&sm_ctx->worker_lock);
+
+        /* the connection itself is owned by the event loop, responses are passed back to it */
+        memset(&conn, 0, sizeof(conn));
+        conn.sm_ctx = sm_ctx;
+        conn.fd = job->fd;
+        conn.id = job->conn_id;
+        conn.detached = true;
+
+        rc = cl_sm_msg_process(sm_ctx, &conn, job->msg);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR("Error by processing of the message for subscription id=%"PRIu32".", subscription->id);
+        }
+        sr_msg_free(job->msg);
+        free(job);
+
+        pthread_mutex_lock(&sm_ctx->worker_lock);
+
+        if (NULL != subscription->jobs_first) {
+            /* more messages are waiting, put the subscription at the end of the queue */
+            if (NULL == sm_ctx->worker_queue_last) {
+                sm_ctx->worker_queue_first = subscription;
+            } else {
+                sm_ctx->worker_queue_last->next_scheduled = subscription;
+            }
+            sm_ctx->worker_queue_last = subscription;
+        } else {
+            subscription->job_scheduled = false;
+        }
+
+        /* release the reference held by the processed message */
+        cl_sm_subscription_unref(subscription);
+    }
+
+    pthread_mutex_unlock(&sm_ctx->worker_lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Starts the worker threads (if not already started).
+ */
+static int
+cl_sm_workers_start(cl_sm_ctx_t *sm_ctx)
+{
+    int ret = 0;
+
+    CHECK_NULL_ARG(sm_ctx);
+
+    while (sm_ctx->worker_cnt < CL_SM_WORKER_THREAD_CNT) {
+        ret = pthread_create(&sm_ctx->workers[sm_ctx->worker_cnt], NULL, cl_sm_worker_thread, sm_ctx);
+        if (0 != ret) {
+            SR_LOG_ERR("Error by creating a new thread: %s", sr_strerror_safe(ret));
+            break;
+        }
+        sm_ctx->worker_cnt += 1;
+    }
+
+    return (sm_ctx->worker_cnt > 0) ? SR_ERR_OK : SR_ERR_INTERNAL;
+}
+
+/**
+ * @brief Stops the worker threads and drops the messages that have not been processed yet.
+ */
+static void
+cl_sm_workers_stop(cl_sm_ctx_t *sm_ctx)
+{
+    cl_sm_subscription_ctx_t *subscription = NULL;
+    cl_sm_job_t *job = NULL;
+    cl_sm_reply_t *reply = NULL;
+    size_t job_cnt = 0;
+
+    if (0 == sm_ctx->worker_cnt) {
+        return;
+    }
+
+    pthread_mutex_lock(&sm_ctx->worker_lock);
+    sm_ctx->workers_stop = true;
+    pthread_cond_broadcast(&sm_ctx->worker_cond);
+    pthread_mutex_unlock(&sm_ctx->worker_lock);
+
+    for (size_t i = 0; i < sm_ctx->worker_cnt; ++i) {
+        pthread_join(sm_ctx->workers[i], NULL);
+    }
+    sm_ctx->worker_cnt = 0;
+
+    while (NULL != sm_ctx->worker_queue_first) {
+        subscription = sm_ctx->worker_queue_first;
+        sm_ctx->worker_queue_first = subscription->next_scheduled;
+        job_cnt = 0;
+        while (NULL != subscription->jobs_first) {
+            job = subscription->jobs_first;
+            subscription->jobs_first = job->next;
+            sr_msg_free(job->msg);
+            free(job);
+            ++job_cnt;
+        }
+        subscription->jobs_last = NULL;
+        subscription->job_scheduled = false;
+        subscription->next_scheduled = NULL;
+        /* release the references held by the dropped messages */
+        while (job_cnt-- > 0) {
+            cl_sm_subscription_unref(subscription);
+        }
+    }
+    sm_ctx->worker_queue_last = NULL;
+
+    while (NULL != sm_ctx->replies_first) {
+        reply = sm_ctx->replies_first;
+        sm_ctx->replies_first = reply->next;
+        free(reply->data);
+        free(reply);
+    }
+    sm_ctx->replies_last = NULL;
+}
+
+/**
+ * @brief Queues the message for processing in a worker thread.
+ * @note Subscriptions lock is expected to be held by the caller.
+ */
+static int
+cl_sm_job_enqueue(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, cl_sm_subscription_ctx_t *subscription, Sr__Msg *msg)
+{
+    cl_sm_job_t *job = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG4(sm_ctx, conn, subscription, msg);
+
+    rc = cl_sm_workers_start(sm_ctx);
+    CHECK_RC_MSG_RETURN(rc, "Unable to start worker threads.");
+
+    job = calloc(1, sizeof(*job));
+    CHECK_NULL_NOMEM_RETURN(job);
+
+    job->msg = msg;
+    job->fd = conn->fd;
+    job->conn_id = conn->id;
+
+    /* the message holds a reference to the subscription until it is processed */
+    ATOMIC_INC(&subscription->ref_count);
+
+    pthread_mutex_lock(&sm_ctx->worker_lock);
+
+    if (NULL == subscription->jobs_last) {
+        subscription->jobs_first = job;
+    } else {
+        subscription->jobs_last->next = job;
+    }
+    subscription->jobs_last = job;
+
+    if (!subscription->job_scheduled) {
+        /* the subscription is not being processed by any worker, queue it */
+        subscription->job_scheduled = true;
+        if (NULL == sm_ctx->worker_queue_last) {
+            sm_ctx->worker_queue_first = subscription;
+        } else {
+            sm_ctx->worker_queue_last->next_scheduled = subscription;
+        }
+        sm_ctx->worker_queue_last = subscription;
+        pthread_cond_signal(&sm_ctx->worker_cond);
+    }
+
+    pthread_mutex_unlock(&sm_ctx->worker_lock);
+
+    return SR_ERR_OK;
+}
+
 /**
  * @brief Processes a message received on the connection.
  */
@@ -1056,6 +1646,8 @@ cl_sm_conn_msg_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, uint8_t *msg
 {
     Sr__Msg *msg = NULL;
     sr_mem_ctx_t *sr_mem = NULL;
+    cl_sm_subscription_ctx_t *subscription = NULL;
+    cl_sm_subscription_ctx_t subscription_lookup = { 0, };
     int rc = SR_ERR_OK;
 
     CHECK_NULL_ARG3(sm_ctx, conn, msg_data);
@@ -1080,25 +1672,25 @@ cl_sm_conn_msg_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn, uint8_t *msg
         ATOMIC_INC(&sr_mem->obj_count);
     }
 
-    /* check the message */
-    if (SR__MSG__MSG_TYPE__NOTIFICATION == msg->type) {
-        /* notification */
-        rc = cl_sm_notif_process(sm_ctx, conn, msg);
-    } else if ((SR__MSG__MSG_TYPE__REQUEST == msg->type) && (SR__OPERATION__DATA_PROVIDE == msg->request->operation)) {
-        /* data-provide request */
-        rc = cl_sm_dp_request_process(sm_ctx, conn, msg);
-    } else if ((SR__MSG__MSG_TYPE__REQUEST == msg->type) &&
-                (SR__OPERATION__RPC == msg->request->operation || SR__OPERATION__ACTION == msg->request->operation)) {
-        /* RPC/Action request */
-        rc = cl_sm_rpc_process(sm_ctx, conn, msg);
-    } else if ((SR__MSG__MSG_TYPE__REQUEST == msg->type) && (SR__OPERATION__EVENT_NOTIF == msg->request->operation)) {
-        /* event notification */
-        rc = cl_sm_event_notif_process(sm_ctx, conn, msg);
-    } else {
-        SR_LOG_ERR("Invalid or unexpected message received (conn=%p).", (void*)conn);
-        rc = SR_ERR_INVAL_ARG;
+    /* pass the messages for threaded subscriptions to the worker threads */
+    if (!sm_ctx->local_fd_watcher) {
+        pthread_mutex_lock(&sm_ctx->subscriptions_lock);
+        subscription_lookup.id = cl_sm_msg_subscription_id(msg);
+        subscription = sr_btree_search(sm_ctx->subscriptions_btree, &subscription_lookup);
+        if ((NULL != subscription) && cl_sm_subscription_threaded(sm_ctx, subscription)) {
+            rc = cl_sm_job_enqueue(sm_ctx, conn, subscription, msg);
+            if (SR_ERR_OK == rc) {
+                pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+                return rc;
+            }
+            SR_LOG_WRN("Unable to pass the message to a worker thread, processing it in place (subscription id=%"PRIu32").",
+                    subscription->id);
+        }
+        pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
     }
 
+    rc = cl_sm_msg_process(sm_ctx, conn, msg);
+
     /* release the message */
     sr_msg_free(msg);
 
@@ -1132,7 +1724,7 @@ cl_sm_conn_in_buff_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn)
             /* invalid message size */
             SR_LOG_ERR("Invalid message size in the message preamble (%zu).", msg_size);
             return SR_ERR_MALFORMED_MSG;
-        } else if ((buff_size - buff_pos) >= msg_size) {
+        } else if ((buff_size - buff_pos - SR_MSG_PREAM_SIZE) >= msg_size) {
             /* the message is completely retrieved, parse it */
             SR_LOG_DBG("New message of size %zu bytes received.", msg_size);
             rc = cl_sm_conn_msg_process(sm_ctx, conn,
@@ -1156,11 +1748,41 @@ cl_sm_conn_in_buff_process(cl_sm_ctx_t *sm_ctx, cl_sm_conn_ctx_t *conn)
             memmove(buff->data, (buff->data + buff_pos), (buff_size - buff_pos));
         }
         buff->pos = buff_size - buff_pos;
+        /* only the partially received message (if any) left in the buffer */
+        conn->in_frame = 0;
     }
 
     return rc;
 }
 
+/**
+ * @brief Returns the size of free space needed in the input buffer of the connection. Once the length
+ * preamble of the message being received is known, the space for the whole rest of the message is requested,
+ * so that the buffer is expanded only once per message.
+ */
+static size_t
+cl_sm_conn_in_buff_required_space(cl_sm_conn_ctx_t *conn)
+{
+    cl_sm_buffer_t *buff = &conn->in_buff;
+    size_t msg_size = 0, received = 0;
+
+    while ((buff->pos - conn->in_frame) >= SR_MSG_PREAM_SIZE) {
+        msg_size = sr_buff_to_uint32(buff->data + conn->in_frame);
+        if ((msg_size <= 0) || (msg_size > SR_MAX_MSG_SIZE)) {
+            /* invalid message size, will be refused during processing */
+            break;
+        }
+        received = buff->pos - conn->in_frame - SR_MSG_PREAM_SIZE;
+        if (received < msg_size) {
+            return ((msg_size - received) > CL_SM_IN_BUFF_MIN_SPACE) ? (msg_size - received) : CL_SM_IN_BUFF_MIN_SPACE;
+        }
+        /* message completely received, continue with the next one */
+        conn->in_frame += SR_MSG_PREAM_SIZE + msg_size;
+    }
+
+    return CL_SM_IN_BUFF_MIN_SPACE;
+}
+
 /**
  * @brief Reads data from a subscriber connection file descriptor and processes them.
  */
@@ -1188,7 +1810,7 @@ cl_sm_fd_read_data(cl_sm_ctx_t *sm_ctx, int fd)
     buff = &conn->in_buff;
     do {
         /* expand input buffer if needed */
-        rc = cl_sm_conn_buffer_expand(conn, buff, CL_SM_IN_BUFF_MIN_SPACE);
+        rc = cl_sm_conn_buffer_expand(conn, buff, cl_sm_conn_in_buff_required_space(conn));
         if (SR_ERR_OK != rc) {
             conn->close_requested = true;
             break;
@@ -1721,6 +2343,12 @@ cl_sm_init(bool local_fd_watcher, sr_fd_sm_terminated_cb local_sm_terminate_cb,
     CHECK_ZERO_MSG_GOTO(ret, rc, SR_ERR_INIT_FAILED, cleanup, "Cannot initialize subscriptions server contexts mutex.");
     ret = pthread_mutex_init(&ctx->fd_changeset_lock, NULL);
     CHECK_ZERO_MSG_GOTO(ret, rc, SR_ERR_INIT_FAILED, cleanup, "Cannot initialize fd changeset mutex.");
+    ret = pthread_mutex_init(&ctx->data_connection_lock, NULL);
+    CHECK_ZERO_MSG_GOTO(ret, rc, SR_ERR_INIT_FAILED, cleanup, "Cannot initialize data connections mutex.");
+    ret = pthread_mutex_init(&ctx->worker_lock, NULL);
+    CHECK_ZERO_MSG_GOTO(ret, rc, SR_ERR_INIT_FAILED, cleanup, "Cannot initialize worker threads mutex.");
+    ret = pthread_cond_init(&ctx->worker_cond, NULL);
+    CHECK_ZERO_MSG_GOTO(ret, rc, SR_ERR_INIT_FAILED, cleanup, "Cannot initialize worker threads condition variable.");
     ret = pthread_mutexattr_init(&mattr);
     CHECK_ZERO_MSG_GOTO(ret, rc, SR_ERR_INIT_FAILED, cleanup, "Cannot initialize mutex attribute.");
     pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
@@ -1749,6 +2377,11 @@ cl_sm_init(bool local_fd_watcher, sr_fd_sm_terminated_cb local_sm_terminate_cb,
         ctx->server_ctx_watcher.data = (void*)ctx;
         ev_async_start(ctx->event_loop, &ctx->server_ctx_watcher);
 
+        /* initialize event watcher for messages prepared by worker threads */
+        ev_async_init(&ctx->reply_watcher, cl_sm_reply_cb);
+        ctx->reply_watcher.data = (void*)ctx;
+        ev_async_start(ctx->event_loop, &ctx->reply_watcher);
+
         /* start the event loop in a new thread */
         ret = pthread_create(&ctx->event_loop_thread, NULL, cl_sm_event_loop_threaded, ctx);
         CHECK_ZERO_LOG_GOTO(ret, rc, SR_ERR_INIT_FAILED, cleanup, "Error by creating a new thread: %s", sr_strerror_safe(errno));
@@ -1780,6 +2413,7 @@ cl_sm_cleanup(cl_sm_ctx_t *sm_ctx, bool join)
                 pthread_join(sm_ctx->event_loop_thread, NULL);
             }
         }
+        cl_sm_workers_stop(sm_ctx);
         cl_sm_servers_cleanup(sm_ctx);
 
         sr_btree_cleanup(sm_ctx->data_connection_btree);
@@ -1790,6 +2424,9 @@ cl_sm_cleanup(cl_sm_ctx_t *sm_ctx, bool join)
         pthread_mutex_destroy(&sm_ctx->server_ctx_lock);
         pthread_mutex_destroy(&sm_ctx->fd_changeset_lock);
         pthread_mutex_destroy(&sm_ctx->subscriptions_lock);
+        pthread_mutex_destroy(&sm_ctx->data_connection_lock);
+        pthread_mutex_destroy(&sm_ctx->worker_lock);
+        pthread_cond_destroy(&sm_ctx->worker_cond);
 
         if (sm_ctx->local_fd_watcher) {
             if (sm_ctx->fd_changeset_cnt > 0) {
@@ -1852,7 +2489,8 @@ int
 cl_sm_subscription_init(cl_sm_ctx_t *sm_ctx, cl_sm_server_ctx_t *server_ctx, cl_sm_subscription_ctx_t **subscription_p)
 {
     cl_sm_subscription_ctx_t *subscription = NULL;
-    int rc = SR_ERR_OK;
+    pthread_mutexattr_t mattr;
+    int ret = 0, rc = SR_ERR_OK;
 
     CHECK_NULL_ARG2(sm_ctx, subscription_p);
 
@@ -1860,6 +2498,19 @@ cl_sm_subscription_init(cl_sm_ctx_t *sm_ctx, cl_sm_server_ctx_t *server_ctx, cl_
     CHECK_NULL_NOMEM_RETURN(subscription);
 
     subscription->sm_ctx = sm_ctx;
+    subscription->ref_count = 1;
+
+    ret = pthread_mutexattr_init(&mattr);
+    if (0 == ret) {
+        pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+        ret = pthread_mutex_init(&subscription->cb_lock, &mattr);
+        pthread_mutexattr_destroy(&mattr);
+    }
+    if (0 != ret) {
+        SR_LOG_ERR_MSG("Cannot initialize subscription callback mutex.");
+        free(subscription);
+        return SR_ERR_INTERNAL;
+    }
 
     pthread_mutex_lock(&sm_ctx->subscriptions_lock);
 
@@ -1903,12 +2554,22 @@ cl_sm_subscription_cleanup(cl_sm_subscription_ctx_t *subscription)
 
     sm_ctx = subscription->sm_ctx;
 
+    /* keep the subscription alive until in-flight callbacks are finished */
+    ATOMIC_INC(&subscription->ref_count);
+
     pthread_mutex_lock(&sm_ctx->subscriptions_lock);
 
     /* cl_sm_subscription_cleanup_internal will be auto-invoked */
     sr_btree_delete(sm_ctx->subscriptions_btree, subscription);
 
     pthread_mutex_unlock(&sm_ctx->subscriptions_lock);
+
+    /* wait for the callback running in a worker thread (if any), prevent any further calls */
+    pthread_mutex_lock(&subscription->cb_lock);
+    subscription->removed = true;
+    pthread_mutex_unlock(&subscription->cb_lock);
+
+    cl_sm_subscription_unref(subscription);
 }
 
 int
@@ -78,6 +78,14 @@ typedef struct cl_sm_subscription_ctx_s {
     void *private_ctx;                           /**< Private context pointer, opaque to sysrepo. */
     int opts;                                    /**< Subscription options. */
     bool replaying;                              /**< TRUE in case of an event notification subscription, which is currently replaying notifications. */
+
+    ATOMIC_UINT32_T ref_count;                   /**< Count of references to the subscription (subscriptions tree + in-flight messages). */
+    pthread_mutex_t cb_lock;                     /**< Lock held while a callback of a ::SR_SUBSCR_THREADED subscription is running. */
+    bool removed;                                /**< TRUE if the subscription has been removed, its callback must not be called anymore. */
+    struct cl_sm_job_s *jobs_first;              /**< First message waiting for processing in a worker thread. */
+    struct cl_sm_job_s *jobs_last;               /**< Last message waiting for processing in a worker thread. */
+    bool job_scheduled;                          /**< TRUE if the subscription is queued for or being processed by a worker thread. */
+    struct cl_sm_subscription_ctx_s *next_scheduled;  /**< Next subscription in the worker queue. */
 } cl_sm_subscription_ctx_t;
 
 /**
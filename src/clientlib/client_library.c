@@ -140,6 +140,8 @@ cl_send_get_items_iter(sr_session_ctx_t *session, const char *xpath, size_t offs
     msg_req->request->get_items_req->offset = offset;
     msg_req->request->get_items_req->has_limit = true;
     msg_req->request->get_items_req->has_offset = true;
+    msg_req->request->get_items_req->compress_xpaths = true;
+    msg_req->request->get_items_req->has_compress_xpaths = true;
 
     /* send the request and receive the response */
     rc = cl_request_process(session, msg_req, msg_resp, NULL, SR__OPERATION__GET_ITEMS);
@@ -379,8 +381,8 @@ sr_connect(const char *app_name, const sr_conn_options_t opts, sr_conn_ctx_t **c
 
     SR_LOG_DBG_MSG("Connecting to Sysrepo Engine.");
 
-    /* create the connection */
-    rc = cl_connection_create(&connection);
+    /* create the connection with the requested socket pool */
+    rc = cl_connection_create((opts & SR_CONN_POOL_MASK) >> 16, &connection);
     CHECK_RC_MSG_RETURN(rc, "Unable to create new connection.");
 
     pthread_mutex_lock(&global_lock);
@@ -984,6 +986,10 @@ sr_get_items(sr_session_ctx_t *session, const char *xpath, sr_val_t **values, si
     sr_mem_edit_string(sr_mem, &msg_req->request->get_items_req->xpath, xpath);
     CHECK_NULL_NOMEM_GOTO(msg_req->request->get_items_req->xpath, rc, cleanup);
 
+    /* xpaths of the values can be sent relatively to the preceding value */
+    msg_req->request->get_items_req->compress_xpaths = true;
+    msg_req->request->get_items_req->has_compress_xpaths = true;
+
     /* send the request and receive the response */
     rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__GET_ITEMS);
     if (SR_ERR_NOT_FOUND == rc) {
@@ -1010,6 +1016,84 @@ cleanup:
     return cl_session_return(session, rc);
 }
 
+int
+sr_get_items_multi(sr_session_ctx_t *session, const char **xpaths, size_t xpath_cnt, sr_val_set_t **val_sets)
+{
+    Sr__Msg *msg_req = NULL, *msg_resp = NULL;
+    Sr__GetItemsMultiReq *multi_req = NULL;
+    Sr__GetItemsMultiResp *multi_resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    sr_val_set_t *sets = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG4(session, session->conn_ctx, xpaths, val_sets);
+
+    cl_session_clear_errors(session);
+
+    if (0 == xpath_cnt) {
+        SR_LOG_ERR_MSG("No xpath to be retrieved.");
+        return cl_session_return(session, SR_ERR_INVAL_ARG);
+    }
+    for (size_t i = 0; i < xpath_cnt; i++) {
+        CHECK_NULL_ARG(xpaths[i]);
+    }
+
+    /* prepare get_items_multi message */
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__GET_ITEMS_MULTI, session->id, &msg_req);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot allocate GPB message.");
+    multi_req = msg_req->request->get_items_multi_req;
+
+    /* fill in the paths */
+    multi_req->xpaths = sr_calloc(sr_mem, xpath_cnt, sizeof(*multi_req->xpaths));
+    CHECK_NULL_NOMEM_GOTO(multi_req->xpaths, rc, cleanup);
+    for (size_t i = 0; i < xpath_cnt; i++) {
+        sr_mem_edit_string(sr_mem, &multi_req->xpaths[i], xpaths[i]);
+        CHECK_NULL_NOMEM_GOTO(multi_req->xpaths[i], rc, cleanup);
+        multi_req->n_xpaths = i + 1;
+    }
+
+    /* xpaths of the values can be sent relatively to the preceding value */
+    multi_req->compress_xpaths = true;
+    multi_req->has_compress_xpaths = true;
+
+    /* send the request and receive the response */
+    rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__GET_ITEMS_MULTI);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Error by processing of the request.");
+
+    multi_resp = msg_resp->response->get_items_multi_resp;
+    if (xpath_cnt != multi_resp->n_value_sets) {
+        SR_LOG_ERR("Unexpected count of value sets in the response: %zu, expected %zu.", multi_resp->n_value_sets, xpath_cnt);
+        rc = SR_ERR_MALFORMED_MSG;
+        goto cleanup;
+    }
+
+    /* copy the content of gpb values to sr_val_t */
+    sets = calloc(xpath_cnt, sizeof(*sets));
+    CHECK_NULL_NOMEM_GOTO(sets, rc, cleanup);
+    for (size_t i = 0; i < xpath_cnt; i++) {
+        sets[i].result = multi_resp->value_sets[i]->result;
+        rc = sr_values_gpb_to_sr((sr_mem_ctx_t *)msg_resp->_sysrepo_mem_ctx, multi_resp->value_sets[i]->values,
+                multi_resp->value_sets[i]->n_values, &sets[i].values, &sets[i].value_cnt);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Error by copying the values from GPB.");
+    }
+    *val_sets = sets;
+    sets = NULL;
+
+cleanup:
+    sr_free_val_sets(sets, xpath_cnt);
+    if (NULL != msg_req) {
+        sr_msg_free(msg_req);
+    } else {
+        sr_mem_free(sr_mem);
+    }
+    if (NULL != msg_resp) {
+        sr_msg_free(msg_resp);
+    }
+    return cl_session_return(session, rc);
+}
+
 int
 sr_get_items_iter(sr_session_ctx_t *session, const char *xpath, sr_val_iter_t **iter)
 {
@@ -1047,6 +1131,13 @@ sr_get_items_iter(sr_session_ctx_t *session, const char *xpath, sr_val_iter_t **
     for (size_t i = 0; i < it->count; i++) {
         rc = sr_dup_gpb_to_val_t((sr_mem_ctx_t *)msg_resp->_sysrepo_mem_ctx,
                                  msg_resp->response->get_items_resp->values[i], &it->buff_values[i]);
+        if (SR_ERR_OK == rc) {
+            rc = sr_gpb_val_expand_xpath(msg_resp->response->get_items_resp->values[i],
+                    (i > 0) ? it->buff_values[i-1]->xpath : NULL, it->buff_values[i]);
+            if (SR_ERR_OK != rc) {
+                sr_free_val(it->buff_values[i]);
+            }
+        }
         if (SR_ERR_OK != rc) {
             SR_LOG_ERR_MSG("Copying from gpb to sr_val_t failed");
             sr_free_values_arr(it->buff_values, i);
@@ -1121,6 +1212,13 @@ sr_get_item_next(sr_session_ctx_t *session, sr_val_iter_t *iter, sr_val_t **valu
         for (size_t i = 0; i < iter->count; i++){
             rc = sr_dup_gpb_to_val_t((sr_mem_ctx_t *)msg_resp->_sysrepo_mem_ctx,
                     msg_resp->response->get_items_resp->values[i], &iter->buff_values[i]);
+            if (SR_ERR_OK == rc) {
+                rc = sr_gpb_val_expand_xpath(msg_resp->response->get_items_resp->values[i],
+                        (i > 0) ? iter->buff_values[i-1]->xpath : NULL, iter->buff_values[i]);
+                if (SR_ERR_OK != rc) {
+                    sr_free_val(iter->buff_values[i]);
+                }
+            }
             if (SR_ERR_OK != rc) {
                 SR_LOG_ERR_MSG("Copying from gpb to sr_val_t failed");
                 sr_free_values_arr(iter->buff_values, i);
@@ -1264,6 +1362,65 @@ cleanup:
     return cl_session_return(session, rc);
 }
 
+int
+sr_export_data(sr_session_ctx_t *session, const char *module_name, sr_data_format_t format,
+        sr_export_data_cb callback, void *private_ctx)
+{
+    Sr__Msg *msg_req = NULL, *msg_resp = NULL;
+    Sr__ExportDataResp *export_resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    uint64_t offset = 0;
+    bool last = false;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG4(session, session->conn_ctx, module_name, callback);
+
+    cl_session_clear_errors(session);
+
+    /* request the chunks one by one, only one of them is held in memory at a time */
+    while (!last) {
+        /* prepare export_data message */
+        rc = sr_mem_new(0, &sr_mem);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create a new Sysrepo memory context.");
+        rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__EXPORT_DATA, session->id, &msg_req);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot allocate GPB message.");
+
+        /* fill in the module name, format and offset of the chunk */
+        sr_mem_edit_string(sr_mem, &msg_req->request->export_data_req->module_name, module_name);
+        CHECK_NULL_NOMEM_GOTO(msg_req->request->export_data_req->module_name, rc, cleanup);
+        msg_req->request->export_data_req->format = sr_data_format_sr_to_gpb(format);
+        msg_req->request->export_data_req->offset = offset;
+
+        /* send the request and receive the response */
+        rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__EXPORT_DATA);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Error by processing of the request.");
+
+        export_resp = msg_resp->response->export_data_resp;
+        if (0 < export_resp->chunk.len) {
+            rc = callback(export_resp->chunk.data, export_resp->chunk.len, private_ctx);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Export data callback returned an error.");
+        }
+        offset += export_resp->chunk.len;
+        last = export_resp->last;
+
+        sr_msg_free(msg_req);
+        sr_msg_free(msg_resp);
+        msg_req = msg_resp = NULL;
+        sr_mem = NULL;
+    }
+
+cleanup:
+    if (NULL != msg_req) {
+        sr_msg_free(msg_req);
+    } else {
+        sr_mem_free(sr_mem);
+    }
+    if (NULL != msg_resp) {
+        sr_msg_free(msg_resp);
+    }
+    return cl_session_return(session, rc);
+}
+
 /**
  * @brief Returns true if the passed node could be an internal one (based on the type), false otherwise.
  */
@@ -2002,6 +2159,55 @@ cleanup:
     return cl_session_return(session, rc);
 }
 
+int
+sr_set_data_tree(sr_session_ctx_t *session, const char *module_name, const char *data, const sr_data_tree_mode_t mode)
+{
+    Sr__Msg *msg_req = NULL, *msg_resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG4(session, session->conn_ctx, module_name, data);
+
+    cl_session_clear_errors(session);
+
+    /* prepare set_data_tree message */
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__SET_DATA_TREE, session->id, &msg_req);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot allocate GPB message.");
+
+    /* fill in the module name and mode */
+    sr_mem_edit_string(sr_mem, &msg_req->request->set_data_tree_req->module_name, module_name);
+    CHECK_NULL_NOMEM_GOTO(msg_req->request->set_data_tree_req->module_name, rc, cleanup);
+
+    msg_req->request->set_data_tree_req->merge = (SR_DATA_TREE_MERGE == mode);
+
+    /* the data may be large, refer to them instead of copying, detached before the message is freed */
+    msg_req->request->set_data_tree_req->data = (char *) data;
+
+    /* send the request and receive the response */
+    rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__SET_DATA_TREE);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Error by processing of the request.");
+
+    msg_req->request->set_data_tree_req->data = NULL;
+    sr_msg_free(msg_req);
+    sr_msg_free(msg_resp);
+
+    return cl_session_return(session, SR_ERR_OK);
+
+cleanup:
+    if (NULL != msg_req) {
+        msg_req->request->set_data_tree_req->data = NULL;
+        sr_msg_free(msg_req);
+    } else {
+        sr_mem_free(sr_mem);
+    }
+    if (NULL != msg_resp) {
+        sr_msg_free(msg_resp);
+    }
+    return cl_session_return(session, rc);
+}
+
 int
 sr_validate(sr_session_ctx_t *session)
 {
@@ -2141,9 +2347,12 @@ cleanup:
     return cl_session_return(session, rc);
 }
 
-int
-sr_copy_config(sr_session_ctx_t *session, const char *module_name,
-        sr_datastore_t src_datastore, sr_datastore_t dst_datastore)
+/**
+ * @brief Sends copy-config request, optionally asking for a confirmed copy to running datastore.
+ */
+static int
+cl_copy_config(sr_session_ctx_t *session, const char *module_name,
+        sr_datastore_t src_datastore, sr_datastore_t dst_datastore, uint32_t confirm_timeout)
 {
     Sr__Msg *msg_req = NULL, *msg_resp = NULL;
     sr_mem_ctx_t *sr_mem = NULL;
@@ -2167,6 +2376,10 @@ sr_copy_config(sr_session_ctx_t *session, const char *module_name,
         sr_mem_edit_string(sr_mem, &msg_req->request->copy_config_req->module_name, module_name);
         CHECK_NULL_NOMEM_GOTO(msg_req->request->copy_config_req->module_name, rc, cleanup);
     }
+    if (0 != confirm_timeout) {
+        msg_req->request->copy_config_req->confirm_timeout = confirm_timeout;
+        msg_req->request->copy_config_req->has_confirm_timeout = true;
+    }
 
     /* send the request and receive the response */
     rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__COPY_CONFIG);
@@ -2195,6 +2408,111 @@ cleanup:
     return cl_session_return(session, rc);
 }
 
+int
+sr_copy_config(sr_session_ctx_t *session, const char *module_name,
+        sr_datastore_t src_datastore, sr_datastore_t dst_datastore)
+{
+    return cl_copy_config(session, module_name, src_datastore, dst_datastore, 0);
+}
+
+int
+sr_copy_config_confirmed(sr_session_ctx_t *session, const char *module_name,
+        sr_datastore_t src_datastore, uint32_t timeout)
+{
+    if (0 == timeout) {
+        SR_LOG_ERR_MSG("Confirm timeout of a confirmed copy-config must not be zero.");
+        return SR_ERR_INVAL_ARG;
+    }
+    return cl_copy_config(session, module_name, src_datastore, SR_DS_RUNNING, timeout);
+}
+
+int
+sr_cancel_confirmed_commit(sr_session_ctx_t *session)
+{
+    Sr__Msg *msg_req = NULL, *msg_resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG2(session, session->conn_ctx);
+
+    cl_session_clear_errors(session);
+
+    /* prepare cancel_confirmed_commit message */
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__CANCEL_CONFIRMED_COMMIT, session->id, &msg_req);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot allocate GPB message.");
+
+    /* send the request and receive the response */
+    rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__CANCEL_CONFIRMED_COMMIT);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Error by processing of the request.");
+
+    sr_msg_free(msg_req);
+    sr_msg_free(msg_resp);
+
+    return cl_session_return(session, SR_ERR_OK);
+
+cleanup:
+    if (NULL != msg_req) {
+        sr_msg_free(msg_req);
+    } else {
+        sr_mem_free(sr_mem);
+    }
+    if (NULL != msg_resp) {
+        sr_msg_free(msg_resp);
+    }
+    return cl_session_return(session, rc);
+}
+
+int
+sr_rollback(sr_session_ctx_t *session, uint32_t count)
+{
+    Sr__Msg *msg_req = NULL, *msg_resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    Sr__RollbackResp *rollback_resp = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG2(session, session->conn_ctx);
+
+    cl_session_clear_errors(session);
+
+    /* prepare rollback message */
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_req_alloc(sr_mem, SR__OPERATION__ROLLBACK, session->id, &msg_req);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot allocate GPB message.");
+
+    msg_req->request->rollback_req->count = count;
+
+    /* send the request and receive the response, the inverse changes are committed by the engine */
+    rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__ROLLBACK);
+    if (SR_ERR_OK != rc && NULL != msg_resp) {
+        rollback_resp = msg_resp->response->rollback_resp;
+        SR_LOG_ERR("Rollback operation failed with %zu error(s).", rollback_resp->n_errors);
+
+        /* store commit errors within the session */
+        if (rollback_resp->n_errors > 0) {
+            cl_session_set_errors(session, rollback_resp->errors, rollback_resp->n_errors);
+        }
+    }
+
+    sr_msg_free(msg_req);
+    sr_msg_free(msg_resp);
+
+    return cl_session_return(session, rc);
+
+cleanup:
+    if (NULL != msg_req) {
+        sr_msg_free(msg_req);
+    } else {
+        sr_mem_free(sr_mem);
+    }
+    if (NULL != msg_resp) {
+        sr_msg_free(msg_resp);
+    }
+    return cl_session_return(session, rc);
+}
+
 int
 sr_lock_datastore(sr_session_ctx_t *session)
 {
@@ -2540,6 +2858,8 @@ sr_module_change_subscribe(sr_session_ctx_t *session, const char *module_name, s
     msg_req->request->subscribe_req->enable_running = !(opts & SR_SUBSCR_PASSIVE);
     msg_req->request->subscribe_req->has_enable_event = true;
     msg_req->request->subscribe_req->enable_event = (opts & SR_SUBSCR_EV_ENABLED);
+    msg_req->request->subscribe_req->has_coalesce = true;
+    msg_req->request->subscribe_req->coalesce = ((opts & SR_SUBSCR_APPLY_ONLY) && (opts & SR_SUBSCR_COALESCE));
 
     /* send the request and receive the response */
     rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__SUBSCRIBE);
@@ -2613,6 +2933,8 @@ sr_subtree_change_subscribe(sr_session_ctx_t *session, const char *xpath, sr_sub
     msg_req->request->subscribe_req->enable_running = !(opts & SR_SUBSCR_PASSIVE);
     msg_req->request->subscribe_req->has_enable_event = true;
     msg_req->request->subscribe_req->enable_event = (opts & SR_SUBSCR_EV_ENABLED);
+    msg_req->request->subscribe_req->has_coalesce = true;
+    msg_req->request->subscribe_req->coalesce = ((opts & SR_SUBSCR_APPLY_ONLY) && (opts & SR_SUBSCR_COALESCE));
 
     /* send the request and receive the response */
     rc = cl_request_process(session, msg_req, &msg_resp, NULL, SR__OPERATION__SUBSCRIBE);
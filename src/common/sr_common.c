@@ -97,6 +97,17 @@ sr_free_values(sr_val_t *values, size_t count)
     }
 }
 
+void
+sr_free_val_sets(sr_val_set_t *val_sets, size_t count)
+{
+    if (NULL != val_sets) {
+        for (size_t i = 0; i < count; i++) {
+            sr_free_values(val_sets[i].values, val_sets[i].value_cnt);
+        }
+        free(val_sets);
+    }
+}
+
 void
 sr_free_schemas(sr_schema_t *schemas, size_t count)
 {
@@ -25,6 +25,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #include "sr_mem_mgmt.h"
 #include "sr_common.h"
@@ -38,6 +39,11 @@
 typedef struct fctx_pool_s {
     sr_llist_t *fctx_llist;  /**< Free memory contexts (items are of type sr_mem_ctx_t). */
     size_t count;            /**< Number of free memory contexts. */
+    size_t max_count;        /**< Maximum number of free memory contexts, adapts to the observed demand. */
+
+    size_t requests;         /**< Number of context requests in the current adaptation period. */
+    size_t misses;           /**< Number of requests in the current period that could not be served from any pool. */
+    size_t min_count;        /**< Lowest number of free memory contexts observed in the current period. */
 
     size_t peak_history[MEM_PEAK_USAGE_HISTORY_LENGTH];  /**< Recent history of peak memory usage
                                                               of the contexts freed by this thread. */
@@ -48,6 +54,32 @@ typedef struct fctx_pool_s {
     size_t pb_peak_history_head;                           /**< Head of the pb_peak_history queue. */
 } fctx_pool_t;
 
+/**
+ * @brief Pool of free memory contexts released by a thread different from the one that acquired them
+ * (e.g. allocated by the CM thread, released by a RP worker). Each size class is a lock-free stack:
+ * contexts are pushed using CAS and taken by detaching the whole chain at once, which is immune to ABA.
+ */
+static struct {
+    sr_mem_ctx_t *head[MEM_POOL_SIZE_CLASSES];    /**< Tops of the per-size-class stacks. */
+    ATOMIC_UINT32_T count[MEM_POOL_SIZE_CLASSES]; /**< Approximate number of contexts in each stack. */
+    ATOMIC_UINT32_T taken[MEM_POOL_SIZE_CLASSES]; /**< Number of contexts taken from each stack (wraps around). */
+    uint32_t taken_trimmed[MEM_POOL_SIZE_CLASSES]; /**< Value of taken at the last trim, written by the trimming thread only. */
+    uint32_t threads;                             /**< Number of threads with a thread-private pool. */
+    uint32_t periods;                             /**< Number of adaptation periods completed by all the threads (wraps around). */
+    uint32_t trim_period;                         /**< Value of periods at the last trim. */
+} shared_pool;
+
+/**
+ * @brief Statistics of the pools of free memory contexts.
+ */
+static struct {
+    ATOMIC_UINT64_T hits;
+    ATOMIC_UINT64_T shared_hits;
+    ATOMIC_UINT64_T misses;
+    ATOMIC_UINT64_T destroyed;
+    ATOMIC_UINT64_T bytes_retained;
+} pool_stats;
+
 static pthread_key_t fctx_key; /**< Key to the pool of free memory contexts. */
 static pthread_once_t fctx_init_once = PTHREAD_ONCE_INIT; /**< For initialization of the key. */
 
@@ -67,11 +99,13 @@ destroy_fctx_pool(void *fctx_pool_p)
         node_ll = fctx_pool->fctx_llist->first;
         while (node_ll) {
             sr_mem_ctx_t *sr_mem = (sr_mem_ctx_t *)node_ll->data;
+            ATOMIC_SUB(&pool_stats.bytes_retained, sr_mem->size_total);
             sr_mem_destroy(sr_mem);
             node_ll = node_ll->next;
         }
         sr_llist_cleanup(fctx_pool->fctx_llist);
         free(fctx_pool);
+        __atomic_sub_fetch(&shared_pool.threads, 1, __ATOMIC_RELAXED);
     }
 }
 
@@ -97,7 +131,10 @@ get_fctx_pool()
         fctx_pool = calloc(1, sizeof *fctx_pool);
         if (fctx_pool) {
             if (SR_ERR_OK == sr_llist_init(&fctx_pool->fctx_llist)) {
+                fctx_pool->max_count = MAX_FREE_MEM_CONTEXTS;
+                fctx_pool->min_count = SIZE_MAX;
                 (void)pthread_setspecific(fctx_key, fctx_pool);
+                __atomic_add_fetch(&shared_pool.threads, 1, __ATOMIC_RELAXED);
             } else {
                 free(fctx_pool);
                 fctx_pool = NULL;
@@ -107,6 +144,224 @@ get_fctx_pool()
     return fctx_pool;
 }
 
+/**
+ * @brief Returns size of the first memory block of a context (it is never released while the context exists).
+ */
+static size_t
+sr_mem_first_block_size(const sr_mem_ctx_t *sr_mem)
+{
+    return ((sr_mem_block_t *)sr_mem->mem_blocks->first->data)->size;
+}
+
+/**
+ * @brief Returns size class for the given size of the first memory block.
+ * Class *i* covers sizes from MEM_BLOCK_MIN_SIZE * 2^i, the last class is unbounded.
+ */
+static size_t
+sr_mem_size_class(size_t size)
+{
+    size_t size_class = 0;
+
+    while (size_class < MEM_POOL_SIZE_CLASSES - 1 && size >= ((size_t)MEM_BLOCK_MIN_SIZE << (size_class + 1))) {
+        ++size_class;
+    }
+    return size_class;
+}
+
+/**
+ * @brief Pushes a chain of free memory contexts into the given size class of the shared pool.
+ */
+static void
+shared_pool_push(size_t size_class, sr_mem_ctx_t *first, sr_mem_ctx_t *last)
+{
+    sr_mem_ctx_t *head = NULL;
+
+    head = __atomic_load_n(&shared_pool.head[size_class], __ATOMIC_RELAXED);
+    do {
+        last->next_free = head;
+    } while (!__atomic_compare_exchange_n(&shared_pool.head[size_class], &head, first, true,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+#ifdef USE_SR_MEM_MGMT
+/**
+ * @brief Takes a context with the first memory block of at least *min_size* bytes
+ * from the given size class of the shared pool.
+ */
+static sr_mem_ctx_t *
+shared_pool_take(size_t size_class, size_t min_size)
+{
+    sr_mem_ctx_t *chain = NULL, *prev = NULL, *sr_mem = NULL, *last = NULL;
+
+    if (NULL == __atomic_load_n(&shared_pool.head[size_class], __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+
+    /* detach the whole chain */
+    chain = __atomic_exchange_n(&shared_pool.head[size_class], NULL, __ATOMIC_ACQUIRE);
+
+    for (sr_mem = chain; NULL != sr_mem; prev = sr_mem, sr_mem = sr_mem->next_free) {
+        if (min_size <= sr_mem_first_block_size(sr_mem)) {
+            if (NULL != prev) {
+                prev->next_free = sr_mem->next_free;
+            } else {
+                chain = sr_mem->next_free;
+            }
+            sr_mem->next_free = NULL;
+            ATOMIC_DEC(&shared_pool.count[size_class]);
+            ATOMIC_INC(&shared_pool.taken[size_class]);
+            break;
+        }
+    }
+
+    /* return the rest */
+    if (NULL != chain) {
+        for (last = chain; NULL != last->next_free; last = last->next_free);
+        shared_pool_push(size_class, chain, last);
+    }
+    return sr_mem;
+}
+
+/**
+ * @brief Gets a free memory context from the shared pool, preferring contexts
+ * with the first memory block of at least *min_size* bytes.
+ */
+static sr_mem_ctx_t *
+shared_pool_get(size_t min_size)
+{
+    sr_mem_ctx_t *sr_mem = NULL;
+    size_t size_class = sr_mem_size_class(min_size);
+
+    for (size_t i = size_class; NULL == sr_mem && i < MEM_POOL_SIZE_CLASSES; ++i) {
+        sr_mem = shared_pool_take(i, min_size);
+    }
+    /* take also a non-suitable context */
+    for (size_t i = size_class + 1; NULL == sr_mem && i > 0; --i) {
+        sr_mem = shared_pool_take(i - 1, 0);
+    }
+    return sr_mem;
+}
+
+/**
+ * @brief Releases free memory contexts from the size classes of the shared pool
+ * that have not served any request during the whole last period. A period of the shared pool
+ * passes once as many thread-private periods have been completed as there are threads, only the thread
+ * completing it does the trim, so that the contexts just refilled by the other threads are not drained.
+ */
+static void
+shared_pool_trim()
+{
+    sr_mem_ctx_t *chain = NULL, *sr_mem = NULL;
+    uint32_t periods = 0, trim_period = 0, threads = 0, taken = 0;
+
+    periods = __atomic_add_fetch(&shared_pool.periods, 1, __ATOMIC_RELAXED);
+    trim_period = __atomic_load_n(&shared_pool.trim_period, __ATOMIC_RELAXED);
+    threads = __atomic_load_n(&shared_pool.threads, __ATOMIC_RELAXED);
+    /* unsigned difference is correct also when the counter wraps around */
+    if ((uint32_t)(periods - trim_period) < MAX(threads, 1) ||
+            !__atomic_compare_exchange_n(&shared_pool.trim_period, &trim_period, periods, false,
+                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    for (size_t i = 0; i < MEM_POOL_SIZE_CLASSES; ++i) {
+        taken = __atomic_load_n(&shared_pool.taken[i], __ATOMIC_RELAXED);
+        if (taken != shared_pool.taken_trimmed[i]) {
+            shared_pool.taken_trimmed[i] = taken;
+            continue;
+        }
+        if (NULL == __atomic_load_n(&shared_pool.head[i], __ATOMIC_RELAXED)) {
+            continue;
+        }
+        chain = __atomic_exchange_n(&shared_pool.head[i], NULL, __ATOMIC_ACQUIRE);
+        while (NULL != chain) {
+            sr_mem = chain;
+            chain = chain->next_free;
+            ATOMIC_DEC(&shared_pool.count[i]);
+            ATOMIC_SUB(&pool_stats.bytes_retained, sr_mem->size_total);
+            ATOMIC_INC(&pool_stats.destroyed);
+            sr_mem_destroy(sr_mem);
+        }
+    }
+}
+
+/**
+ * @brief Gets a free memory context from the thread-private pool, preferring contexts
+ * with the first memory block of at least *min_size* bytes.
+ */
+static sr_mem_ctx_t *
+fctx_pool_get(fctx_pool_t *fctx_pool, size_t min_size)
+{
+    sr_mem_ctx_t *sr_mem = NULL;
+    sr_llist_node_t *node_ll = NULL;
+
+    if (0 == fctx_pool->count) {
+        return NULL;
+    }
+
+    node_ll = fctx_pool->fctx_llist->last;
+    /* find the first suitable context starting from the last used (for cache locality) */
+    while (node_ll) {
+        sr_mem = (sr_mem_ctx_t *)node_ll->data;
+        if (min_size <= sr_mem_first_block_size(sr_mem)) {
+            sr_llist_rm(fctx_pool->fctx_llist, node_ll);
+            break;
+        } else {
+            sr_mem = NULL;
+        }
+        node_ll = node_ll->prev;
+    }
+    if (NULL == sr_mem) {
+        /* take also a non-suitable context */
+        sr_mem = (sr_mem_ctx_t *)fctx_pool->fctx_llist->last->data;
+        sr_llist_rm(fctx_pool->fctx_llist, fctx_pool->fctx_llist->last);
+    }
+    --fctx_pool->count;
+    return sr_mem;
+}
+
+/**
+ * @brief Adapts the maximum size of the thread-private pool to the observed demand. The pool grows
+ * if a significant portion of requests in the last period could not be served from any pool
+ * and shrinks by the number of free contexts that have not been needed during the whole period.
+ * Completes a period of the shared pool as well, see ::shared_pool_trim.
+ */
+static void
+fctx_pool_adapt(fctx_pool_t *fctx_pool, bool miss)
+{
+    sr_mem_ctx_t *sr_mem = NULL;
+
+    fctx_pool->min_count = MIN(fctx_pool->min_count, fctx_pool->count);
+    if (miss) {
+        ++fctx_pool->misses;
+    }
+    if (++fctx_pool->requests < MEM_POOL_ADAPT_PERIOD) {
+        return;
+    }
+
+    if (fctx_pool->misses > (MEM_POOL_ADAPT_PERIOD >> 3)) {
+        fctx_pool->max_count = MIN(fctx_pool->max_count << 1, MAX_FREE_MEM_CONTEXTS_LIMIT);
+    } else if (0 < fctx_pool->min_count) {
+        fctx_pool->max_count -= MIN(fctx_pool->min_count, fctx_pool->max_count);
+        fctx_pool->max_count = MAX(fctx_pool->max_count, MAX_FREE_MEM_CONTEXTS);
+        while (fctx_pool->count > fctx_pool->max_count) {
+            /* release the least recently used context */
+            sr_mem = (sr_mem_ctx_t *)fctx_pool->fctx_llist->first->data;
+            sr_llist_rm(fctx_pool->fctx_llist, fctx_pool->fctx_llist->first);
+            --fctx_pool->count;
+            ATOMIC_SUB(&pool_stats.bytes_retained, sr_mem->size_total);
+            ATOMIC_INC(&pool_stats.destroyed);
+            sr_mem_destroy(sr_mem);
+        }
+    }
+    shared_pool_trim();
+
+    fctx_pool->requests = 0;
+    fctx_pool->misses = 0;
+    fctx_pool->min_count = fctx_pool->count;
+}
+#endif /* USE_SR_MEM_MGMT */
+
 int
 sr_mem_new(size_t min_size, sr_mem_ctx_t **sr_mem_p)
 {
@@ -120,7 +375,6 @@ sr_mem_new(size_t min_size, sr_mem_ctx_t **sr_mem_p)
 
     sr_mem_ctx_t *sr_mem = NULL;
     sr_mem_block_t *mem_block = NULL;
-    sr_llist_node_t *node_ll = NULL;
     fctx_pool_t *fctx_pool = get_fctx_pool();
     size_t max_recent_peak = 0;
 
@@ -131,31 +385,34 @@ sr_mem_new(size_t min_size, sr_mem_ctx_t **sr_mem_p)
         for (size_t i = 0; i < MEM_PEAK_USAGE_HISTORY_LENGTH; ++i) {
             max_recent_peak = MAX(max_recent_peak, fctx_pool->peak_history[i]);
         }
-        if (0 < fctx_pool->count) {
-            node_ll = fctx_pool->fctx_llist->last;
-            /* find the first suitable context starting from the last used (for cache locality) */
-            while (node_ll) {
-                sr_mem = (sr_mem_ctx_t *)node_ll->data;
-                if (min_size <= ((sr_mem_block_t *)sr_mem->mem_blocks->first->data)->size) {
-                    sr_llist_rm(fctx_pool->fctx_llist, node_ll);
-                    break;
-                } else {
-                    sr_mem = NULL;
-                }
-                node_ll = node_ll->prev;
-            }
-            if (NULL == sr_mem) {
-                /* take also a non-suitable context */
-                sr_mem = (sr_mem_ctx_t *)fctx_pool->fctx_llist->last->data;
-                sr_llist_rm(fctx_pool->fctx_llist, fctx_pool->fctx_llist->last);
-            }
-            --fctx_pool->count;
-            sr_mem->piggy_back = max_recent_peak;
-            *sr_mem_p = sr_mem;
-            return SR_ERR_OK;
+        sr_mem = fctx_pool_get(fctx_pool, min_size);
+        if (NULL != sr_mem) {
+            ATOMIC_INC(&pool_stats.hits);
+        }
+    }
+
+    if (NULL == sr_mem) {
+        /* try contexts released by other threads */
+        sr_mem = shared_pool_get(min_size);
+        if (NULL != sr_mem) {
+            ATOMIC_INC(&pool_stats.shared_hits);
         }
     }
 
+    if (NULL != fctx_pool) {
+        fctx_pool_adapt(fctx_pool, NULL == sr_mem);
+    }
+
+    if (NULL != sr_mem) {
+        ATOMIC_SUB(&pool_stats.bytes_retained, sr_mem->size_total);
+        sr_mem->owner = fctx_pool;
+        sr_mem->piggy_back = max_recent_peak;
+        *sr_mem_p = sr_mem;
+        return SR_ERR_OK;
+    }
+
+    ATOMIC_INC(&pool_stats.misses);
+
     sr_mem = calloc(1, sizeof *sr_mem);
     CHECK_NULL_NOMEM_GOTO(sr_mem, rc, cleanup);
 
@@ -171,6 +428,7 @@ sr_mem_new(size_t min_size, sr_mem_ctx_t **sr_mem_p)
     sr_mem->size_total += mem_block->size;
 
     sr_mem->cursor = sr_mem->mem_blocks->last;
+    sr_mem->owner = fctx_pool;
     sr_mem->piggy_back = max_recent_peak;
     *sr_mem_p = sr_mem;
 
@@ -406,6 +664,8 @@ sr_mem_free(sr_mem_ctx_t *sr_mem)
     }
 
     fctx_pool_t *fctx_pool = get_fctx_pool();
+    bool local = false, shared = false;
+    size_t size_class = 0;
 
     if (sr_mem->obj_count) {
         SR_LOG_WRN_MSG("Deallocation of Sysrepo memory context with non-zero usage counter.");
@@ -424,7 +684,16 @@ sr_mem_free(sr_mem_ctx_t *sr_mem)
         for (size_t i = 0; i < MEM_PEAK_USAGE_HISTORY_LENGTH; ++i) {
             max_recent_peak = MAX(max_recent_peak, MAX(fctx_pool->pb_peak_history[i], fctx_pool->peak_history[i]));
         }
-        if (MAX_FREE_MEM_CONTEXTS > fctx_pool->count) {
+        if (MAX_RETAINED_FREE_MEM_BYTES < ATOMIC_LOAD(&pool_stats.bytes_retained) + sr_mem->size_total) {
+            /* the pools already hold too much memory (checked before trimming, the limit is approximate anyway) */
+        } else if (sr_mem->owner == fctx_pool) {
+            local = fctx_pool->max_count > fctx_pool->count;
+        } else {
+            /* acquired by another thread, return it via the shared pool */
+            size_class = sr_mem_size_class(sr_mem_first_block_size(sr_mem));
+            shared = MAX_SHARED_FREE_MEM_CONTEXTS > ATOMIC_LOAD(&shared_pool.count[size_class]);
+        }
+        if (local || shared) {
             /* remove extra trailing empty memory blocks based on the maximum peak memory usage in the recent history */
             sr_llist_node_t *node_ll = sr_mem->mem_blocks->last;
             while (node_ll->prev) {
@@ -447,15 +716,36 @@ sr_mem_free(sr_mem_ctx_t *sr_mem)
             sr_mem->peak = 0;
             sr_mem->piggy_back = 0;
             sr_mem->obj_count = 0;
-            sr_llist_add_new(fctx_pool->fctx_llist, sr_mem);
-            ++fctx_pool->count;
+            sr_mem->owner = NULL;
+            ATOMIC_ADD(&pool_stats.bytes_retained, sr_mem->size_total);
+            if (local) {
+                sr_llist_add_new(fctx_pool->fctx_llist, sr_mem);
+                ++fctx_pool->count;
+            } else {
+                ATOMIC_INC(&shared_pool.count[size_class]);
+                shared_pool_push(size_class, sr_mem, sr_mem);
+            }
             return;
         }
     }
 
+    ATOMIC_INC(&pool_stats.destroyed);
     sr_mem_destroy(sr_mem);
 }
 
+void
+sr_mem_pool_get_stats(sr_mem_pool_stats_t *stats)
+{
+    if (NULL == stats) {
+        return;
+    }
+    stats->hits = ATOMIC_LOAD(&pool_stats.hits);
+    stats->shared_hits = ATOMIC_LOAD(&pool_stats.shared_hits);
+    stats->misses = ATOMIC_LOAD(&pool_stats.misses);
+    stats->destroyed = ATOMIC_LOAD(&pool_stats.destroyed);
+    stats->bytes_retained = ATOMIC_LOAD(&pool_stats.bytes_retained);
+}
+
 static void
 *sr_protobuf_malloc(void *sr_mem, size_t size)
 {
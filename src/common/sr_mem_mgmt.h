@@ -24,6 +24,7 @@
 #define SR_MEM_MGMT_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "sr_data_structs.h"
 #include "sr_protobuf.h"
@@ -31,8 +32,13 @@
 /* Configuration */
 #define MEM_BLOCK_MIN_SIZE          256 /**< Minimal memory block size */
 #define MAX_BLOCKS_AVAIL_FOR_ALLOC    3 /**< Maximum number of memory block available for allocation */
-#define MAX_FREE_MEM_CONTEXTS         4 /**< Maximum number of free memory contexts */
+#define MAX_FREE_MEM_CONTEXTS         4 /**< Initial (and minimal) maximum number of free memory contexts kept by a thread */
+#define MAX_FREE_MEM_CONTEXTS_LIMIT  64 /**< Upper bound of the adaptive maximum number of free memory contexts kept by a thread */
 #define MEM_PEAK_USAGE_HISTORY_LENGTH 3 /**< Length of peak memory usage history */
+#define MEM_POOL_ADAPT_PERIOD        64 /**< Number of context requests after which a thread re-evaluates the size of its pool */
+#define MEM_POOL_SIZE_CLASSES         8 /**< Number of size classes of the shared pool (by the size of the first memory block) */
+#define MAX_SHARED_FREE_MEM_CONTEXTS 64 /**< Maximum number of free memory contexts in one size class of the shared pool */
+#define MAX_RETAINED_FREE_MEM_BYTES (4 * 1024 * 1024) /**< Maximum number of bytes held by free memory contexts in all pools */
 
 /**
  * @brief Internal structure representing a single memory block.
@@ -56,8 +62,22 @@ typedef struct sr_mem_ctx_s {
    size_t piggy_back;       /**< Piggybacking.
                                  Used for threads to exchange information about the recent peak memory usage. */
    ATOMIC_UINT32_T obj_count; /**< Object counter, i.e. how many values/trees/GPB messages use this context */
+   const void *owner;       /**< Pool of the thread that acquired the context (only compared, never dereferenced).
+                                 Contexts released by a different thread are returned via the shared pool. */
+   struct sr_mem_ctx_s *next_free; /**< Next context in the shared pool of free contexts. */
 } sr_mem_ctx_t;
 
+/**
+ * @brief Statistics of the pools of free memory contexts (summed over all threads).
+ */
+typedef struct sr_mem_pool_stats_s {
+    uint64_t hits;           /**< Number of contexts reused from the pool of the requesting thread. */
+    uint64_t shared_hits;    /**< Number of contexts reused from the shared pool (released by other threads). */
+    uint64_t misses;         /**< Number of contexts that had to be newly allocated. */
+    uint64_t destroyed;      /**< Number of released contexts that were not retained in any pool. */
+    uint64_t bytes_retained; /**< Number of bytes currently held by free contexts in all pools. */
+} sr_mem_pool_stats_t;
+
 /**
  * @brief Snapshot of a Sysrepo memory context.
  * Invalidated by sr_mem_free and sr_mem_restore for an older snapshot of the same context.
@@ -118,6 +138,13 @@ void *sr_calloc(sr_mem_ctx_t *sr_mem, size_t nmemb, size_t size);
  */
 void sr_mem_free(sr_mem_ctx_t *sr_mem);
 
+/**
+ * @brief Get statistics of the pools of free memory contexts.
+ *
+ * @param [out] stats Returned statistics.
+ */
+void sr_mem_pool_get_stats(sr_mem_pool_stats_t *stats);
+
 /**
  * @brief Get allocator for the protobuf-c library that will use specified Sysrepo
  * memory context for all the allocation.
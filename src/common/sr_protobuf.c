@@ -59,6 +59,10 @@ sr_gpb_operation_name(Sr__Operation operation)
         return "get-subtrees";
     case SR__OPERATION__GET_SUBTREE_CHUNK:
         return "get-subtree-chunk";
+    case SR__OPERATION__EXPORT_DATA:
+        return "export-data";
+    case SR__OPERATION__GET_ITEMS_MULTI:
+        return "get-items-multi";
     case SR__OPERATION__SET_ITEM:
         return "set-item";
     case SR__OPERATION__SET_ITEM_STR:
@@ -67,6 +71,8 @@ sr_gpb_operation_name(Sr__Operation operation)
         return "delete-item";
     case SR__OPERATION__MOVE_ITEM:
         return "move-item";
+    case SR__OPERATION__SET_DATA_TREE:
+        return "set-data-tree";
     case SR__OPERATION__VALIDATE:
         return "validate";
     case SR__OPERATION__COMMIT:
@@ -75,6 +81,10 @@ sr_gpb_operation_name(Sr__Operation operation)
         return "discard-changes";
     case SR__OPERATION__COPY_CONFIG:
         return "copy-config";
+    case SR__OPERATION__CANCEL_CONFIRMED_COMMIT:
+        return "cancel-confirmed-commit";
+    case SR__OPERATION__ROLLBACK:
+        return "rollback";
     case SR__OPERATION__LOCK:
         return "lock";
     case SR__OPERATION__UNLOCK:
@@ -113,6 +123,10 @@ sr_gpb_operation_name(Sr__Operation operation)
         return "delayed-msg";
     case SR__OPERATION__NACM_RELOAD:
         return "nacm-reload";
+    case SR__OPERATION__COMMIT_COALESCE:
+        return "commit-coalesce";
+    case SR__OPERATION__CONFIRMED_COMMIT_TIMEOUT:
+        return "confirmed-commit-timeout";
     case _SR__OPERATION_IS_INT_SIZE:
         return "unknown";
     }
@@ -246,6 +260,18 @@ sr_gpb_req_alloc(sr_mem_ctx_t *sr_mem, const Sr__Operation operation, const uint
             sr__get_subtree_chunk_req__init((Sr__GetSubtreeChunkReq*)sub_msg);
             req->get_subtree_chunk_req = (Sr__GetSubtreeChunkReq*)sub_msg;
             break;
+        case SR__OPERATION__EXPORT_DATA:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__ExportDataReq));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__export_data_req__init((Sr__ExportDataReq*)sub_msg);
+            req->export_data_req = (Sr__ExportDataReq*)sub_msg;
+            break;
+        case SR__OPERATION__GET_ITEMS_MULTI:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__GetItemsMultiReq));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__get_items_multi_req__init((Sr__GetItemsMultiReq*)sub_msg);
+            req->get_items_multi_req = (Sr__GetItemsMultiReq*)sub_msg;
+            break;
         case SR__OPERATION__SET_ITEM:
             sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__SetItemReq));
             CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
@@ -270,6 +296,12 @@ sr_gpb_req_alloc(sr_mem_ctx_t *sr_mem, const Sr__Operation operation, const uint
             sr__move_item_req__init((Sr__MoveItemReq*)sub_msg);
             req->move_item_req = (Sr__MoveItemReq*)sub_msg;
             break;
+        case SR__OPERATION__SET_DATA_TREE:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__SetDataTreeReq));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__set_data_tree_req__init((Sr__SetDataTreeReq*)sub_msg);
+            req->set_data_tree_req = (Sr__SetDataTreeReq*)sub_msg;
+            break;
         case SR__OPERATION__VALIDATE:
             sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__ValidateReq));
             CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
@@ -294,6 +326,18 @@ sr_gpb_req_alloc(sr_mem_ctx_t *sr_mem, const Sr__Operation operation, const uint
             sr__copy_config_req__init((Sr__CopyConfigReq*)sub_msg);
             req->copy_config_req = (Sr__CopyConfigReq*)sub_msg;
             break;
+        case SR__OPERATION__CANCEL_CONFIRMED_COMMIT:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__CancelConfirmedCommitReq));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__cancel_confirmed_commit_req__init((Sr__CancelConfirmedCommitReq*)sub_msg);
+            req->cancel_confirmed_commit_req = (Sr__CancelConfirmedCommitReq*)sub_msg;
+            break;
+        case SR__OPERATION__ROLLBACK:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__RollbackReq));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__rollback_req__init((Sr__RollbackReq*)sub_msg);
+            req->rollback_req = (Sr__RollbackReq*)sub_msg;
+            break;
         case SR__OPERATION__LOCK:
             sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__LockReq));
             CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
@@ -514,6 +558,18 @@ sr_gpb_resp_alloc(sr_mem_ctx_t *sr_mem, const Sr__Operation operation, const uin
             sr__get_subtree_chunk_resp__init((Sr__GetSubtreeChunkResp*)sub_msg);
             resp->get_subtree_chunk_resp = (Sr__GetSubtreeChunkResp*)sub_msg;
             break;
+        case SR__OPERATION__EXPORT_DATA:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__ExportDataResp));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__export_data_resp__init((Sr__ExportDataResp*)sub_msg);
+            resp->export_data_resp = (Sr__ExportDataResp*)sub_msg;
+            break;
+        case SR__OPERATION__GET_ITEMS_MULTI:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__GetItemsMultiResp));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__get_items_multi_resp__init((Sr__GetItemsMultiResp*)sub_msg);
+            resp->get_items_multi_resp = (Sr__GetItemsMultiResp*)sub_msg;
+            break;
         case SR__OPERATION__SET_ITEM:
             sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__SetItemResp));
             CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
@@ -538,6 +594,12 @@ sr_gpb_resp_alloc(sr_mem_ctx_t *sr_mem, const Sr__Operation operation, const uin
             sr__move_item_resp__init((Sr__MoveItemResp*)sub_msg);
             resp->move_item_resp = (Sr__MoveItemResp*)sub_msg;
             break;
+        case SR__OPERATION__SET_DATA_TREE:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__SetDataTreeResp));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__set_data_tree_resp__init((Sr__SetDataTreeResp*)sub_msg);
+            resp->set_data_tree_resp = (Sr__SetDataTreeResp*)sub_msg;
+            break;
         case SR__OPERATION__VALIDATE:
             sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__ValidateResp));
             CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
@@ -562,6 +624,18 @@ sr_gpb_resp_alloc(sr_mem_ctx_t *sr_mem, const Sr__Operation operation, const uin
             sr__copy_config_resp__init((Sr__CopyConfigResp*)sub_msg);
             resp->copy_config_resp = (Sr__CopyConfigResp*)sub_msg;
             break;
+        case SR__OPERATION__CANCEL_CONFIRMED_COMMIT:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__CancelConfirmedCommitResp));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__cancel_confirmed_commit_resp__init((Sr__CancelConfirmedCommitResp*)sub_msg);
+            resp->cancel_confirmed_commit_resp = (Sr__CancelConfirmedCommitResp*)sub_msg;
+            break;
+        case SR__OPERATION__ROLLBACK:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__RollbackResp));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__rollback_resp__init((Sr__RollbackResp*)sub_msg);
+            resp->rollback_resp = (Sr__RollbackResp*)sub_msg;
+            break;
         case SR__OPERATION__LOCK:
             sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__LockResp));
             CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
@@ -866,6 +940,18 @@ sr_gpb_internal_req_alloc(sr_mem_ctx_t *sr_mem, const Sr__Operation operation, S
             sr__nacm_reload_req__init((Sr__NacmReloadReq*)sub_msg);
             req->nacm_reload_req = (Sr__NacmReloadReq*)sub_msg;
             break;
+        case SR__OPERATION__COMMIT_COALESCE:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__CommitCoalesceReq));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__commit_coalesce_req__init((Sr__CommitCoalesceReq*)sub_msg);
+            req->commit_coalesce_req = (Sr__CommitCoalesceReq*)sub_msg;
+            break;
+        case SR__OPERATION__CONFIRMED_COMMIT_TIMEOUT:
+            sub_msg = sr_calloc(sr_mem, 1, sizeof(Sr__ConfirmedCommitTimeoutReq));
+            CHECK_NULL_NOMEM_GOTO(sub_msg, rc, error);
+            sr__confirmed_commit_timeout_req__init((Sr__ConfirmedCommitTimeoutReq*)sub_msg);
+            req->confirmed_commit_timeout_req = (Sr__ConfirmedCommitTimeoutReq*)sub_msg;
+            break;
 
         default:
             break;
@@ -951,6 +1037,12 @@ sr_gpb_msg_validate(const Sr__Msg *msg, const Sr__Msg__MsgType type, const Sr__O
             case SR__OPERATION__GET_SUBTREE_CHUNK:
                 CHECK_NULL_RETURN(msg->request->get_subtree_chunk_req, SR_ERR_MALFORMED_MSG);
                 break;
+            case SR__OPERATION__EXPORT_DATA:
+                CHECK_NULL_RETURN(msg->request->export_data_req, SR_ERR_MALFORMED_MSG);
+                break;
+            case SR__OPERATION__GET_ITEMS_MULTI:
+                CHECK_NULL_RETURN(msg->request->get_items_multi_req, SR_ERR_MALFORMED_MSG);
+                break;
             case SR__OPERATION__SET_ITEM:
                 CHECK_NULL_RETURN(msg->request->set_item_req, SR_ERR_MALFORMED_MSG);
                 break;
@@ -963,6 +1055,9 @@ sr_gpb_msg_validate(const Sr__Msg *msg, const Sr__Msg__MsgType type, const Sr__O
             case SR__OPERATION__MOVE_ITEM:
                 CHECK_NULL_RETURN(msg->request->move_item_req, SR_ERR_MALFORMED_MSG);
                 break;
+            case SR__OPERATION__SET_DATA_TREE:
+                CHECK_NULL_RETURN(msg->request->set_data_tree_req, SR_ERR_MALFORMED_MSG);
+                break;
             case SR__OPERATION__VALIDATE:
                 CHECK_NULL_RETURN(msg->request->validate_req, SR_ERR_MALFORMED_MSG);
                 break;
@@ -975,6 +1070,12 @@ sr_gpb_msg_validate(const Sr__Msg *msg, const Sr__Msg__MsgType type, const Sr__O
             case SR__OPERATION__COPY_CONFIG:
                 CHECK_NULL_RETURN(msg->request->copy_config_req, SR_ERR_MALFORMED_MSG);
                 break;
+            case SR__OPERATION__CANCEL_CONFIRMED_COMMIT:
+                CHECK_NULL_RETURN(msg->request->cancel_confirmed_commit_req, SR_ERR_MALFORMED_MSG);
+                break;
+            case SR__OPERATION__ROLLBACK:
+                CHECK_NULL_RETURN(msg->request->rollback_req, SR_ERR_MALFORMED_MSG);
+                break;
             case SR__OPERATION__LOCK:
                 CHECK_NULL_RETURN(msg->request->lock_req, SR_ERR_MALFORMED_MSG);
                 break;
@@ -1067,6 +1168,12 @@ sr_gpb_msg_validate(const Sr__Msg *msg, const Sr__Msg__MsgType type, const Sr__O
             case SR__OPERATION__GET_SUBTREE_CHUNK:
                 CHECK_NULL_RETURN(msg->response->get_subtree_chunk_resp, SR_ERR_MALFORMED_MSG);
                 break;
+            case SR__OPERATION__EXPORT_DATA:
+                CHECK_NULL_RETURN(msg->response->export_data_resp, SR_ERR_MALFORMED_MSG);
+                break;
+            case SR__OPERATION__GET_ITEMS_MULTI:
+                CHECK_NULL_RETURN(msg->response->get_items_multi_resp, SR_ERR_MALFORMED_MSG);
+                break;
             case SR__OPERATION__SET_ITEM:
                 CHECK_NULL_RETURN(msg->response->set_item_resp, SR_ERR_MALFORMED_MSG);
                 break;
@@ -1079,6 +1186,9 @@ sr_gpb_msg_validate(const Sr__Msg *msg, const Sr__Msg__MsgType type, const Sr__O
             case SR__OPERATION__MOVE_ITEM:
                 CHECK_NULL_RETURN(msg->response->move_item_resp, SR_ERR_MALFORMED_MSG);
                 break;
+            case SR__OPERATION__SET_DATA_TREE:
+                CHECK_NULL_RETURN(msg->response->set_data_tree_resp, SR_ERR_MALFORMED_MSG);
+                break;
             case SR__OPERATION__VALIDATE:
                 CHECK_NULL_RETURN(msg->response->validate_resp, SR_ERR_MALFORMED_MSG);
                 break;
@@ -1091,6 +1201,12 @@ sr_gpb_msg_validate(const Sr__Msg *msg, const Sr__Msg__MsgType type, const Sr__O
             case SR__OPERATION__COPY_CONFIG:
                 CHECK_NULL_RETURN(msg->response->copy_config_resp, SR_ERR_MALFORMED_MSG);
                 break;
+            case SR__OPERATION__CANCEL_CONFIRMED_COMMIT:
+                CHECK_NULL_RETURN(msg->response->cancel_confirmed_commit_resp, SR_ERR_MALFORMED_MSG);
+                break;
+            case SR__OPERATION__ROLLBACK:
+                CHECK_NULL_RETURN(msg->response->rollback_resp, SR_ERR_MALFORMED_MSG);
+                break;
             case SR__OPERATION__LOCK:
                 CHECK_NULL_RETURN(msg->response->lock_resp, SR_ERR_MALFORMED_MSG);
                 break;
@@ -1426,10 +1542,10 @@ cleanup:
 
 
 static int
-sr_set_gpb_type_in_val_t(const Sr__Value *gpb_value, sr_val_t *value){
-    CHECK_NULL_ARG2(value, gpb_value);
+sr_set_gpb_type_in_val_t(Sr__Value__Types gpb_type, sr_val_t *value){
+    CHECK_NULL_ARG(value);
     int rc = SR_ERR_OK;
-    switch (gpb_value->type) {
+    switch (gpb_type) {
     case SR__VALUE__TYPES__LIST:
         value->type = SR_LIST_T;
         break;
@@ -1633,7 +1749,7 @@ sr_copy_gpb_to_val_t(const Sr__Value *gpb_value, sr_val_t *value)
     CHECK_NULL_ARG2(gpb_value, value);
     int rc = SR_ERR_INTERNAL;
 
-    rc = sr_set_gpb_type_in_val_t(gpb_value, value);
+    rc = sr_set_gpb_type_in_val_t(gpb_value->type, value);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR_MSG("Setting type in for sr_value_t failed");
         return rc;
@@ -1681,6 +1797,36 @@ sr_dup_gpb_to_val_t(sr_mem_ctx_t *sr_mem, const Sr__Value *gpb_value, sr_val_t *
     return rc;
 }
 
+int
+sr_gpb_val_expand_xpath(const Sr__Value *gpb_value, const char *prev_xpath, sr_val_t *value)
+{
+    char *xpath = NULL;
+    size_t suffix_len = 0;
+
+    CHECK_NULL_ARG3(gpb_value, value, value->xpath);
+
+    if (!gpb_value->has_xpath_prefix_len || 0 == gpb_value->xpath_prefix_len) {
+        return SR_ERR_OK;
+    }
+    if (NULL == prev_xpath || gpb_value->xpath_prefix_len > strlen(prev_xpath)) {
+        SR_LOG_ERR("Relatively encoded xpath '%s' does not match the preceding value.", value->xpath);
+        return SR_ERR_MALFORMED_MSG;
+    }
+
+    suffix_len = strlen(value->xpath);
+    xpath = sr_malloc(value->_sr_mem, gpb_value->xpath_prefix_len + suffix_len + 1);
+    CHECK_NULL_NOMEM_RETURN(xpath);
+    memcpy(xpath, prev_xpath, gpb_value->xpath_prefix_len);
+    memcpy(xpath + gpb_value->xpath_prefix_len, value->xpath, suffix_len + 1);
+
+    if (NULL == value->_sr_mem) {
+        free(value->xpath);
+    }
+    value->xpath = xpath;
+
+    return SR_ERR_OK;
+}
+
 int
 sr_values_sr_to_gpb(const sr_val_t *sr_values, const size_t sr_value_cnt, Sr__Value ***gpb_values_p, size_t *gpb_value_cnt_p)
 {
@@ -1749,6 +1895,8 @@ sr_values_gpb_to_sr(sr_mem_ctx_t *sr_mem, Sr__Value **gpb_values, size_t gpb_val
         for (size_t i = 0; i < gpb_value_cnt; i++) {
             rc = sr_copy_gpb_to_val_t(gpb_values[i], &sr_values[i]);
             CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to duplicate GPB value to sr_val_t.");
+            rc = sr_gpb_val_expand_xpath(gpb_values[i], (i > 0) ? sr_values[i-1].xpath : NULL, &sr_values[i]);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to expand xpath of GPB value.");
         }
     }
 
@@ -1769,6 +1917,694 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Tag of a field in the GPB wire format.
+ */
+#define SR_GPB_WIRE_TAG(FIELD, WIRE_TYPE) ((uint64_t)(((FIELD) << 3) | (WIRE_TYPE)))
+
+/** Numbers of the fields of Sr__Value message that are always present. */
+#define SR_GPB_VALUE_XPATH_FIELD 1
+#define SR_GPB_VALUE_TYPE_FIELD  2
+#define SR_GPB_VALUE_DFLT_FIELD  3
+#define SR_GPB_VALUE_XPATH_PREFIX_LEN_FIELD 4
+
+/**
+ * @brief Minimal length of the xpath prefix shared with the preceding value, that is worth
+ * to be encoded relatively (the prefix length field itself takes at least two bytes).
+ */
+#define SR_GPB_XPATH_PREFIX_MIN 4
+
+/**
+ * @brief Writes a varint into the buffer (if provided) and returns its encoded size.
+ */
+static size_t
+sr_gpb_wire_put_varint(uint8_t *buf, uint64_t value)
+{
+    size_t len = 0;
+
+    while (value >= 0x80) {
+        if (NULL != buf) {
+            buf[len] = (uint8_t) (value | 0x80);
+        }
+        value >>= 7;
+        len++;
+    }
+    if (NULL != buf) {
+        buf[len] = (uint8_t) value;
+    }
+    return len + 1;
+}
+
+/**
+ * @brief Writes a length-prefixed string field into the buffer (if provided) and returns its encoded size.
+ */
+static size_t
+sr_gpb_wire_put_string(uint8_t *buf, uint32_t field, const char *str)
+{
+    size_t str_len = (NULL != str) ? strlen(str) : 0;
+    size_t len = 0;
+
+    len += sr_gpb_wire_put_varint(buf, SR_GPB_WIRE_TAG(field, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED));
+    len += sr_gpb_wire_put_varint((NULL != buf) ? buf + len : NULL, str_len);
+    if (NULL != buf && str_len > 0) {
+        memcpy(buf + len, str, str_len);
+    }
+    return len + str_len;
+}
+
+/**
+ * @brief Returns the length of the prefix that the xpath shares with the xpath of the preceding value,
+ * or 0 if the xpath should be sent as a whole.
+ */
+static size_t
+sr_gpb_xpath_prefix_len(const char *prev_xpath, const char *xpath)
+{
+    size_t len = 0;
+
+    if (NULL == prev_xpath || NULL == xpath) {
+        return 0;
+    }
+    while ('\0' != prev_xpath[len] && prev_xpath[len] == xpath[len]) {
+        len++;
+    }
+    return (len >= SR_GPB_XPATH_PREFIX_MIN) ? len : 0;
+}
+
+/**
+ * @brief Encodes sr_val_t as Sr__Value message in the GPB wire format. If the buffer is NULL,
+ * only the size of the encoded message is computed. Fields are written in the same order
+ * and with the same encoding as protobuf-c uses when packing the Sr__Value message.
+ * If the xpath of the preceding value is provided, the xpath may be encoded relatively to it.
+ */
+static int
+sr_gpb_wire_put_value(const sr_val_t *value, const char *prev_xpath, uint8_t *buf, size_t *size)
+{
+    Sr__Value gpb_value = SR__VALUE__INIT;
+    size_t prefix_len = sr_gpb_xpath_prefix_len(prev_xpath, value->xpath);
+    uint32_t data_field = 0;
+    uint64_t num = 0;
+    size_t len = 0;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG2(value, size);
+
+    rc = sr_set_val_t_type_in_gpb(value, &gpb_value);
+    if (SR_ERR_OK != rc) {
+        return rc;
+    }
+    /* data fields of Sr__Value are numbered after the corresponding value types */
+    data_field = gpb_value.type;
+
+#define SR_GPB_WIRE_POS ((NULL != buf) ? buf + len : NULL)
+    len += sr_gpb_wire_put_string(SR_GPB_WIRE_POS, SR_GPB_VALUE_XPATH_FIELD,
+            (NULL != value->xpath) ? value->xpath + prefix_len : NULL);
+    len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, SR_GPB_WIRE_TAG(SR_GPB_VALUE_TYPE_FIELD, PROTOBUF_C_WIRE_TYPE_VARINT));
+    len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, gpb_value.type);
+    len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, SR_GPB_WIRE_TAG(SR_GPB_VALUE_DFLT_FIELD, PROTOBUF_C_WIRE_TYPE_VARINT));
+    len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, value->dflt ? 1 : 0);
+    if (prefix_len > 0) {
+        len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS,
+                SR_GPB_WIRE_TAG(SR_GPB_VALUE_XPATH_PREFIX_LEN_FIELD, PROTOBUF_C_WIRE_TYPE_VARINT));
+        len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, prefix_len);
+    }
+
+    switch (value->type) {
+    case SR_LIST_T:
+    case SR_CONTAINER_T:
+    case SR_CONTAINER_PRESENCE_T:
+    case SR_LEAF_EMPTY_T:
+        *size = len;
+        return SR_ERR_OK;
+    case SR_BINARY_T:
+    case SR_BITS_T:
+    case SR_ENUM_T:
+    case SR_IDENTITYREF_T:
+    case SR_INSTANCEID_T:
+    case SR_STRING_T:
+    case SR_ANYXML_T:
+    case SR_ANYDATA_T:
+        /* all string values share the same member of the data union */
+        if (NULL != value->data.string_val) {
+            len += sr_gpb_wire_put_string(SR_GPB_WIRE_POS, data_field, value->data.string_val);
+        }
+        *size = len;
+        return SR_ERR_OK;
+    case SR_DECIMAL64_T:
+        memcpy(&num, &value->data.decimal64_val, sizeof num);
+        len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, SR_GPB_WIRE_TAG(data_field, PROTOBUF_C_WIRE_TYPE_64BIT));
+        if (NULL != buf) {
+            for (size_t i = 0; i < sizeof num; i++) {
+                buf[len + i] = (uint8_t) (num >> (8 * i));
+            }
+        }
+        *size = len + sizeof num;
+        return SR_ERR_OK;
+    case SR_BOOL_T:
+        num = value->data.bool_val ? 1 : 0;
+        break;
+    /* negative int32 values are sign-extended to 64 bits on the wire */
+    case SR_INT8_T:
+        num = (uint64_t) (int64_t) value->data.int8_val;
+        break;
+    case SR_INT16_T:
+        num = (uint64_t) (int64_t) value->data.int16_val;
+        break;
+    case SR_INT32_T:
+        num = (uint64_t) (int64_t) value->data.int32_val;
+        break;
+    case SR_INT64_T:
+        num = (uint64_t) value->data.int64_val;
+        break;
+    case SR_UINT8_T:
+        num = value->data.uint8_val;
+        break;
+    case SR_UINT16_T:
+        num = value->data.uint16_val;
+        break;
+    case SR_UINT32_T:
+        num = value->data.uint32_val;
+        break;
+    case SR_UINT64_T:
+        num = value->data.uint64_val;
+        break;
+    default:
+        SR_LOG_ERR("Conversion of value type not supported '%s'", value->xpath);
+        return SR_ERR_INTERNAL;
+    }
+
+    len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, SR_GPB_WIRE_TAG(data_field, PROTOBUF_C_WIRE_TYPE_VARINT));
+    len += sr_gpb_wire_put_varint(SR_GPB_WIRE_POS, num);
+#undef SR_GPB_WIRE_POS
+
+    *size = len;
+    return SR_ERR_OK;
+}
+
+int
+sr_values_sr_to_gpb_wire(sr_mem_ctx_t *sr_mem, const sr_val_t *sr_values, const size_t sr_value_cnt,
+        bool compress_xpaths, ProtobufCMessage *message, const char *field_name)
+{
+    const ProtobufCFieldDescriptor *field_desc = NULL;
+    ProtobufCMessageUnknownField *unknown_field = NULL;
+    sr_mem_snapshot_t snapshot = { 0, };
+    size_t *sizes = NULL;
+    size_t total = 0, pos = 0, i = 0;
+    uint8_t *data = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG3(message, message->descriptor, field_name);
+
+    field_desc = protobuf_c_message_descriptor_get_field_by_name(message->descriptor, field_name);
+    if (NULL == field_desc || PROTOBUF_C_LABEL_REPEATED != field_desc->label || PROTOBUF_C_TYPE_MESSAGE != field_desc->type
+            || &sr__value__descriptor != field_desc->descriptor) {
+        SR_LOG_ERR("'%s' is not a repeated Sr__Value field of the GPB message.", field_name);
+        return SR_ERR_INVAL_ARG;
+    }
+    if (0 != message->n_unknown_fields) {
+        SR_LOG_ERR_MSG("GPB message already contains unknown fields.");
+        return SR_ERR_INVAL_ARG;
+    }
+    if (NULL == sr_values || 0 == sr_value_cnt) {
+        return SR_ERR_OK;
+    }
+
+    /* compute sizes of the encoded values */
+    sizes = calloc(sr_value_cnt, sizeof(*sizes));
+    CHECK_NULL_NOMEM_RETURN(sizes);
+    for (i = 0; i < sr_value_cnt; i++) {
+        rc = sr_gpb_wire_put_value(&sr_values[i], (compress_xpaths && i > 0) ? sr_values[i-1].xpath : NULL,
+                NULL, &sizes[i]);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to encode sr_val_t to GPB.");
+        if (i > 0) {
+            total += sr_gpb_wire_put_varint(NULL, SR_GPB_WIRE_TAG(field_desc->id, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED));
+        }
+        total += sr_gpb_wire_put_varint(NULL, sizes[i]) + sizes[i];
+    }
+
+    if (NULL != sr_mem) {
+        sr_mem_snapshot(sr_mem, &snapshot);
+    }
+    unknown_field = sr_calloc(sr_mem, 1, sizeof(*unknown_field));
+    CHECK_NULL_NOMEM_GOTO(unknown_field, rc, cleanup);
+    data = sr_malloc(sr_mem, total);
+    CHECK_NULL_NOMEM_GOTO(data, rc, cleanup);
+
+    /* the tag of the first value is written by protobuf-c, the others are written as part of the data */
+    for (i = 0; i < sr_value_cnt; i++) {
+        if (i > 0) {
+            pos += sr_gpb_wire_put_varint(data + pos, SR_GPB_WIRE_TAG(field_desc->id, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED));
+        }
+        pos += sr_gpb_wire_put_varint(data + pos, sizes[i]);
+        rc = sr_gpb_wire_put_value(&sr_values[i], (compress_xpaths && i > 0) ? sr_values[i-1].xpath : NULL,
+                data + pos, &sizes[i]);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to encode sr_val_t to GPB.");
+        pos += sizes[i];
+    }
+
+    unknown_field->tag = field_desc->id;
+    unknown_field->wire_type = PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED;
+    unknown_field->len = total;
+    unknown_field->data = data;
+    message->unknown_fields = unknown_field;
+    message->n_unknown_fields = 1;
+
+cleanup:
+    free(sizes);
+    if (SR_ERR_OK != rc) {
+        if (NULL == sr_mem) {
+            free(unknown_field);
+            free(data);
+        } else {
+            sr_mem_restore(&snapshot);
+        }
+    }
+    return rc;
+}
+
+/**
+ * @brief Reads a varint from the buffer, returns false if the buffer ends prematurely.
+ */
+static bool
+sr_gpb_wire_get_varint(const uint8_t **pos, const uint8_t *end, uint64_t *value)
+{
+    uint64_t result = 0;
+
+    for (unsigned shift = 0; shift < 64 && *pos < end; shift += 7) {
+        uint8_t byte = *(*pos)++;
+        result |= (uint64_t) (byte & 0x7f) << shift;
+        if (0 == (byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Skips a field of the given wire type, returns false if the field can not be skipped.
+ */
+static bool
+sr_gpb_wire_skip(const uint8_t **pos, const uint8_t *end, unsigned wire_type)
+{
+    uint64_t len = 0;
+
+    switch (wire_type) {
+    case PROTOBUF_C_WIRE_TYPE_VARINT:
+        return sr_gpb_wire_get_varint(pos, end, &len);
+    case PROTOBUF_C_WIRE_TYPE_64BIT:
+        len = 8;
+        break;
+    case PROTOBUF_C_WIRE_TYPE_32BIT:
+        len = 4;
+        break;
+    case PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED:
+        if (!sr_gpb_wire_get_varint(pos, end, &len)) {
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+    if (len > (uint64_t) (end - *pos)) {
+        return false;
+    }
+    *pos += len;
+    return true;
+}
+
+/**
+ * @brief Copies a string from the wire into a newly allocated NUL-terminated string.
+ */
+static int
+sr_gpb_wire_dup_string(sr_mem_ctx_t *sr_mem, const uint8_t *data, size_t len, char **str)
+{
+    *str = sr_malloc(sr_mem, len + 1);
+    CHECK_NULL_NOMEM_RETURN(*str);
+    memcpy(*str, data, len);
+    (*str)[len] = '\0';
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Decodes a Sr__Value message from the GPB wire format into sr_val_t. The xpath of the preceding
+ * value is used to expand the xpath if it was encoded relatively.
+ */
+static int
+sr_gpb_wire_get_value(sr_mem_ctx_t *sr_mem, const uint8_t *pos, const uint8_t *end, const char *prev_xpath,
+        sr_val_t *value)
+{
+    Sr__Value__Types type = 0;
+    const uint8_t *str_data = NULL, *xpath_data = NULL;
+    size_t str_len = 0, xpath_len = 0;
+    uint32_t data_field = 0;
+    uint64_t tag = 0, num = 0, data_num = 0, prefix_len = 0;
+    bool has_type = false, has_dflt = false;
+    int rc = SR_ERR_OK;
+
+    while (pos < end) {
+        if (!sr_gpb_wire_get_varint(&pos, end, &tag) || tag > UINT32_MAX) {
+            return SR_ERR_MALFORMED_MSG;
+        }
+        uint32_t field = (uint32_t) (tag >> 3);
+        unsigned wire_type = (unsigned) (tag & 0x7);
+
+        if (SR_GPB_VALUE_XPATH_FIELD == field && PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED == wire_type) {
+            if (!sr_gpb_wire_get_varint(&pos, end, &num) || num > (uint64_t) (end - pos)) {
+                return SR_ERR_MALFORMED_MSG;
+            }
+            xpath_data = pos;
+            xpath_len = num;
+            pos += num;
+        } else if (SR_GPB_VALUE_TYPE_FIELD == field && PROTOBUF_C_WIRE_TYPE_VARINT == wire_type) {
+            if (!sr_gpb_wire_get_varint(&pos, end, &num)) {
+                return SR_ERR_MALFORMED_MSG;
+            }
+            type = (Sr__Value__Types) num;
+            has_type = true;
+        } else if (SR_GPB_VALUE_DFLT_FIELD == field && PROTOBUF_C_WIRE_TYPE_VARINT == wire_type) {
+            if (!sr_gpb_wire_get_varint(&pos, end, &num)) {
+                return SR_ERR_MALFORMED_MSG;
+            }
+            value->dflt = (0 != num);
+            has_dflt = true;
+        } else if (SR_GPB_VALUE_XPATH_PREFIX_LEN_FIELD == field && PROTOBUF_C_WIRE_TYPE_VARINT == wire_type) {
+            if (!sr_gpb_wire_get_varint(&pos, end, &prefix_len)) {
+                return SR_ERR_MALFORMED_MSG;
+            }
+        } else if (field >= SR__VALUE__TYPES__BINARY && field <= SR__VALUE__TYPES__ANYDATA) {
+            /* remember the data, it is interpreted once the type is known */
+            data_field = field;
+            if (PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED == wire_type) {
+                if (!sr_gpb_wire_get_varint(&pos, end, &num) || num > (uint64_t) (end - pos)) {
+                    return SR_ERR_MALFORMED_MSG;
+                }
+                str_data = pos;
+                str_len = num;
+                pos += num;
+            } else if (PROTOBUF_C_WIRE_TYPE_VARINT == wire_type) {
+                if (!sr_gpb_wire_get_varint(&pos, end, &data_num)) {
+                    return SR_ERR_MALFORMED_MSG;
+                }
+            } else if (PROTOBUF_C_WIRE_TYPE_64BIT == wire_type) {
+                if (8 > end - pos) {
+                    return SR_ERR_MALFORMED_MSG;
+                }
+                data_num = 0;
+                for (size_t i = 0; i < 8; i++) {
+                    data_num |= (uint64_t) pos[i] << (8 * i);
+                }
+                pos += 8;
+            } else {
+                return SR_ERR_MALFORMED_MSG;
+            }
+        } else if (!sr_gpb_wire_skip(&pos, end, wire_type)) {
+            return SR_ERR_MALFORMED_MSG;
+        }
+    }
+
+    if (NULL == xpath_data || !has_type || !has_dflt) {
+        SR_LOG_ERR_MSG("Required field of the GPB value is missing.");
+        return SR_ERR_MALFORMED_MSG;
+    }
+    if (prefix_len > 0 && (NULL == prev_xpath || prefix_len > strlen(prev_xpath))) {
+        SR_LOG_ERR_MSG("Relatively encoded xpath does not match the preceding value.");
+        return SR_ERR_MALFORMED_MSG;
+    }
+
+    rc = sr_set_gpb_type_in_val_t(type, value);
+    if (SR_ERR_OK != rc) {
+        return rc;
+    }
+    value->xpath = sr_malloc(sr_mem, prefix_len + xpath_len + 1);
+    CHECK_NULL_NOMEM_RETURN(value->xpath);
+    if (prefix_len > 0) {
+        memcpy(value->xpath, prev_xpath, prefix_len);
+    }
+    memcpy(value->xpath + prefix_len, xpath_data, xpath_len);
+    value->xpath[prefix_len + xpath_len] = '\0';
+
+    if (data_field != (uint32_t) type) {
+        /* no data for the value type, leave the data zeroed as the GPB conversion does */
+        return SR_ERR_OK;
+    }
+
+    switch (value->type) {
+    case SR_BINARY_T:
+    case SR_BITS_T:
+    case SR_ENUM_T:
+    case SR_IDENTITYREF_T:
+    case SR_INSTANCEID_T:
+    case SR_STRING_T:
+    case SR_ANYXML_T:
+    case SR_ANYDATA_T:
+        if (NULL != str_data) {
+            rc = sr_gpb_wire_dup_string(sr_mem, str_data, str_len, &value->data.string_val);
+        }
+        break;
+    case SR_BOOL_T:
+        value->data.bool_val = (0 != data_num);
+        break;
+    case SR_DECIMAL64_T:
+        memcpy(&value->data.decimal64_val, &data_num, sizeof data_num);
+        break;
+    case SR_INT8_T:
+        value->data.int8_val = (int8_t) data_num;
+        break;
+    case SR_INT16_T:
+        value->data.int16_val = (int16_t) data_num;
+        break;
+    case SR_INT32_T:
+        value->data.int32_val = (int32_t) data_num;
+        break;
+    case SR_INT64_T:
+        value->data.int64_val = (int64_t) data_num;
+        break;
+    case SR_UINT8_T:
+        value->data.uint8_val = (uint8_t) data_num;
+        break;
+    case SR_UINT16_T:
+        value->data.uint16_val = (uint16_t) data_num;
+        break;
+    case SR_UINT32_T:
+        value->data.uint32_val = (uint32_t) data_num;
+        break;
+    case SR_UINT64_T:
+        value->data.uint64_val = data_num;
+        break;
+    default:
+        break;
+    }
+
+    return rc;
+}
+
+int
+sr_values_gpb_wire_to_sr(sr_mem_ctx_t *sr_mem, const uint8_t *data, size_t len, uint32_t field_id,
+        sr_val_t **sr_values_p, size_t *sr_value_cnt_p)
+{
+    sr_val_t *sr_values = NULL;
+    sr_mem_snapshot_t snapshot = { 0, };
+    const uint8_t *pos = NULL, *end = NULL;
+    uint64_t tag = 0, value_len = 0;
+    size_t count = 0, i = 0;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG3(data, sr_values_p, sr_value_cnt_p);
+
+    /* count the values first, so that they can be allocated as one array */
+    pos = data;
+    end = data + len;
+    while (pos < end) {
+        if (!sr_gpb_wire_get_varint(&pos, end, &tag) || !sr_gpb_wire_skip(&pos, end, (unsigned) (tag & 0x7))) {
+            SR_LOG_ERR_MSG("Unable to decode GPB message.");
+            return SR_ERR_MALFORMED_MSG;
+        }
+        if (SR_GPB_WIRE_TAG(field_id, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED) == tag) {
+            count++;
+        }
+    }
+
+    if (count > 0) {
+        if (sr_mem) {
+            sr_mem_snapshot(sr_mem, &snapshot);
+        }
+        sr_values = sr_calloc(sr_mem, count, sizeof(*sr_values));
+        CHECK_NULL_NOMEM_RETURN(sr_values);
+        if (sr_mem) {
+            for (i = 0; i < count; i++) {
+                sr_values[i]._sr_mem = sr_mem;
+            }
+        }
+
+        pos = data;
+        i = 0;
+        while (pos < end) {
+            sr_gpb_wire_get_varint(&pos, end, &tag);
+            if (SR_GPB_WIRE_TAG(field_id, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED) != tag) {
+                sr_gpb_wire_skip(&pos, end, (unsigned) (tag & 0x7));
+                continue;
+            }
+            sr_gpb_wire_get_varint(&pos, end, &value_len);
+            rc = sr_gpb_wire_get_value(sr_mem, pos, pos + value_len, (i > 0) ? sr_values[i-1].xpath : NULL,
+                    &sr_values[i]);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to decode GPB value to sr_val_t.");
+            pos += value_len;
+            i++;
+        }
+    }
+
+    if (sr_mem && sr_values) {
+        ATOMIC_INC(&sr_mem->obj_count);
+    }
+    *sr_values_p = sr_values;
+    *sr_value_cnt_p = count;
+
+    return SR_ERR_OK;
+
+cleanup:
+    if (sr_mem) {
+        sr_mem_restore(&snapshot);
+    } else {
+        sr_free_values(sr_values, count);
+    }
+    return rc;
+}
+
+/** Numbers of the fields spliced around the shared parts of a multicast event notification. */
+#define SR_GPB_MSG_REQUEST_FIELD                 3
+#define SR_GPB_REQUEST_EVENT_NOTIF_FIELD        83
+#define SR_GPB_EVENT_NOTIF_ADDRESS_FIELD        10
+#define SR_GPB_EVENT_NOTIF_SUBSCRIPTION_ID_FIELD 11
+
+int
+sr_gpb_event_notif_multicast_init(Sr__Msg *msg, sr_gpb_multicast_t **multicast_p)
+{
+    sr_gpb_multicast_t *multicast = NULL;
+    Sr__Request *request = NULL;
+    Sr__EventNotifReq *notif = NULL;
+    Sr__EventNotifReq__Destination **destinations = NULL;
+    size_t n_destinations = 0;
+    char *subscriber_address = NULL;
+    protobuf_c_boolean has_subscription_id = false;
+
+    CHECK_NULL_ARG5(msg, msg->request, msg->request->event_notif_req, msg->request->event_notif_req->xpath, multicast_p);
+
+    request = msg->request;
+    notif = request->event_notif_req;
+
+    multicast = calloc(1, sizeof(*multicast));
+    CHECK_NULL_NOMEM_RETURN(multicast);
+
+    /* temporarily detach everything that is specific for a destination */
+    destinations = notif->destinations;
+    n_destinations = notif->n_destinations;
+    subscriber_address = notif->subscriber_address;
+    has_subscription_id = notif->has_subscription_id;
+    notif->destinations = NULL;
+    notif->n_destinations = 0;
+    notif->subscriber_address = NULL;
+    notif->has_subscription_id = false;
+    request->event_notif_req = NULL;
+    msg->request = NULL;
+
+    /* the parts are packed in the order in which they will be sent:
+     * the notification body, the rest of the request, the rest of the message */
+    multicast->body_size = sr__event_notif_req__get_packed_size(notif);
+    multicast->req_size = sr__request__get_packed_size(request);
+    multicast->msg_size = sr__msg__get_packed_size(msg);
+
+    multicast->data = malloc(multicast->body_size + multicast->req_size + multicast->msg_size);
+    if (NULL != multicast->data) {
+        sr__event_notif_req__pack(notif, multicast->data);
+        sr__request__pack(request, multicast->data + multicast->body_size);
+        sr__msg__pack(msg, multicast->data + multicast->body_size + multicast->req_size);
+    }
+
+    /* restore the message */
+    msg->request = request;
+    request->event_notif_req = notif;
+    notif->destinations = destinations;
+    notif->n_destinations = n_destinations;
+    notif->subscriber_address = subscriber_address;
+    notif->has_subscription_id = has_subscription_id;
+
+    if (NULL == multicast->data) {
+        free(multicast);
+        SR_LOG_ERR_MSG("Unable to allocate memory for the packed event notification.");
+        return SR_ERR_NOMEM;
+    }
+
+    *multicast_p = multicast;
+    return SR_ERR_OK;
+}
+
+int
+sr_gpb_event_notif_multicast_dst(const sr_gpb_multicast_t *multicast, const char *address, uint32_t subscription_id,
+        uint8_t *dst_buff, size_t dst_buff_size, struct iovec iov[SR_GPB_MULTICAST_IOV_CNT], size_t *msg_size)
+{
+    size_t notif_tail_size = 0, notif_len = 0, req_len = 0, total = 0, head_size = 0;
+    uint8_t *pos = NULL;
+
+    CHECK_NULL_ARG5(multicast, address, dst_buff, iov, msg_size);
+
+    if (dst_buff_size < SR_GPB_MULTICAST_DST_OVERHEAD + strlen(address)) {
+        SR_LOG_ERR("Destination address '%s' is too long.", address);
+        return SR_ERR_INVAL_ARG;
+    }
+
+    /* destination fields at the end of the notification body */
+    notif_tail_size = sr_gpb_wire_put_string(NULL, SR_GPB_EVENT_NOTIF_ADDRESS_FIELD, address) +
+            sr_gpb_wire_put_varint(NULL, SR_GPB_WIRE_TAG(SR_GPB_EVENT_NOTIF_SUBSCRIPTION_ID_FIELD, PROTOBUF_C_WIRE_TYPE_VARINT)) +
+            sr_gpb_wire_put_varint(NULL, subscription_id);
+
+    /* lengths of the embedded messages */
+    notif_len = multicast->body_size + notif_tail_size;
+    req_len = sr_gpb_wire_put_varint(NULL, SR_GPB_WIRE_TAG(SR_GPB_REQUEST_EVENT_NOTIF_FIELD, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED)) +
+            sr_gpb_wire_put_varint(NULL, notif_len) + notif_len + multicast->req_size;
+    total = sr_gpb_wire_put_varint(NULL, SR_GPB_WIRE_TAG(SR_GPB_MSG_REQUEST_FIELD, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED)) +
+            sr_gpb_wire_put_varint(NULL, req_len) + req_len + multicast->msg_size;
+    if (total > SR_MAX_MSG_SIZE) {
+        SR_LOG_ERR("Unable to send the message of size %zuB.", total);
+        return SR_ERR_INTERNAL;
+    }
+
+    /* preamble and headers of the embedded messages */
+    pos = dst_buff;
+    sr_uint32_to_buff(total, pos);
+    pos += SR_MSG_PREAM_SIZE;
+    pos += sr_gpb_wire_put_varint(pos, SR_GPB_WIRE_TAG(SR_GPB_MSG_REQUEST_FIELD, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED));
+    pos += sr_gpb_wire_put_varint(pos, req_len);
+    pos += sr_gpb_wire_put_varint(pos, SR_GPB_WIRE_TAG(SR_GPB_REQUEST_EVENT_NOTIF_FIELD, PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED));
+    pos += sr_gpb_wire_put_varint(pos, notif_len);
+    head_size = pos - dst_buff;
+
+    /* destination fields */
+    pos += sr_gpb_wire_put_string(pos, SR_GPB_EVENT_NOTIF_ADDRESS_FIELD, address);
+    pos += sr_gpb_wire_put_varint(pos, SR_GPB_WIRE_TAG(SR_GPB_EVENT_NOTIF_SUBSCRIPTION_ID_FIELD, PROTOBUF_C_WIRE_TYPE_VARINT));
+    pos += sr_gpb_wire_put_varint(pos, subscription_id);
+
+    iov[0].iov_base = dst_buff;
+    iov[0].iov_len = head_size;
+    iov[1].iov_base = multicast->data;
+    iov[1].iov_len = multicast->body_size;
+    iov[2].iov_base = dst_buff + head_size;
+    iov[2].iov_len = notif_tail_size;
+    iov[3].iov_base = multicast->data + multicast->body_size;
+    iov[3].iov_len = multicast->req_size + multicast->msg_size;
+
+    *msg_size = SR_MSG_PREAM_SIZE + total;
+    return SR_ERR_OK;
+}
+
+void
+sr_gpb_multicast_free(sr_gpb_multicast_t *multicast)
+{
+    if (NULL != multicast) {
+        free(multicast->data);
+        free(multicast);
+    }
+}
+
 int
 sr_dup_tree_to_gpb(const sr_node_t *sr_tree, Sr__Node **gpb_tree)
 {
@@ -1878,12 +2714,12 @@ sr_dup_gpb_to_tree(sr_mem_ctx_t *sr_mem, const Sr__Node *gpb_tree, sr_node_t **s
 int
 sr_copy_gpb_to_tree(const Sr__Node *gpb_tree, sr_node_t *sr_tree)
 {
-    CHECK_NULL_ARG2(gpb_tree, sr_tree);
+    CHECK_NULL_ARG3(gpb_tree, gpb_tree->value, sr_tree);
     sr_node_t *sr_subtree = NULL;
     int rc = SR_ERR_INTERNAL;
 
     /* members common with sr_val_t */
-    rc = sr_set_gpb_type_in_val_t(gpb_tree->value, (sr_val_t *)sr_tree);
+    rc = sr_set_gpb_type_in_val_t(gpb_tree->value->type, (sr_val_t *)sr_tree);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR_MSG("Setting value type in for sr_value_t failed");
         return rc;
@@ -2110,6 +2946,36 @@ sr_datastore_gpb_to_sr(Sr__DataStore gpb_ds)
     }
 }
 
+Sr__DataFormat
+sr_data_format_sr_to_gpb(const sr_data_format_t sr_format)
+{
+    switch (sr_format) {
+        case SR_DATA_JSON:
+            return SR__DATA_FORMAT__DATA_JSON;
+        case SR_DATA_LYB:
+            return SR__DATA_FORMAT__DATA_LYB;
+        case SR_DATA_XML:
+            /* fall through */
+        default:
+            return SR__DATA_FORMAT__DATA_XML;
+    }
+}
+
+sr_data_format_t
+sr_data_format_gpb_to_sr(Sr__DataFormat gpb_format)
+{
+    switch (gpb_format) {
+        case SR__DATA_FORMAT__DATA_JSON:
+            return SR_DATA_JSON;
+        case SR__DATA_FORMAT__DATA_LYB:
+            return SR_DATA_LYB;
+        case SR__DATA_FORMAT__DATA_XML:
+            /* fall through */
+        default:
+            return SR_DATA_XML;
+    }
+}
+
 sr_change_oper_t
 sr_change_op_gpb_to_sr(Sr__ChangeOperation gpb_ch)
 {
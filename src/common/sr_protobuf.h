@@ -22,6 +22,8 @@
 #ifndef SR_PROTOBUF_H_
 #define SR_PROTOBUF_H_
 
+#include <sys/uio.h>
+
 #include "sysrepo.pb-c.h"
 #include "sr_common.h"
 
@@ -142,6 +144,22 @@ int sr_dup_val_t_to_gpb(const sr_val_t *value, Sr__Value **gpb_value);
  */
 int sr_dup_gpb_to_val_t(sr_mem_ctx_t *sr_mem, const Sr__Value *gpb_value, sr_val_t **value);
 
+/**
+ * @brief Expands xpath of the value converted from GPB, if it was encoded relatively
+ * to the xpath of the preceding value (see Sr__Value::xpath_prefix_len).
+ *
+ * The expansion is eager, it is done while the values are converted. sr_val_t::xpath
+ * is a public member read directly by applications, there is no accessor that could
+ * expand it on the first access.
+ *
+ * @param[in] gpb_value GPB value the sysrepo value was converted from.
+ * @param[in] prev_xpath Expanded xpath of the preceding value, NULL for the first value.
+ * @param[in,out] value Sysrepo value with the xpath to expand.
+ *
+ * @return Error code (SR_ERR_OK on success), SR_ERR_MALFORMED_MSG if the xpath can not be expanded.
+ */
+int sr_gpb_val_expand_xpath(const Sr__Value *gpb_value, const char *prev_xpath, sr_val_t *value);
+
 /**
  * @brief Fills sr_val_t structure from gpb.
  * @param [in] gpb_value
@@ -178,6 +196,107 @@ int sr_values_sr_to_gpb(const sr_val_t *sr_values, const size_t sr_value_cnt, Sr
 int sr_values_gpb_to_sr(sr_mem_ctx_t *sr_mem, Sr__Value **gpb_values, size_t gpb_value_cnt, sr_val_t **sr_values,
         size_t *sr_value_cnt);
 
+/**
+ * @brief Serializes values from sysrepo values array directly into the wire format of a repeated
+ * Sr__Value field of the given GPB message, without creating intermediate GPB values. The encoded
+ * field is attached to the message as an unknown field, which protobuf-c packs verbatim, therefore
+ * (unless the xpaths are compressed) the packed message is identical to the one with the values
+ * filled in by ::sr_values_sr_to_gpb.
+ *
+ * @note The GPB message must not contain any other values in the field.
+ *
+ * @param[in] sr_mem Sysrepo memory context of the GPB message, used for memory allocation.
+ *                   If NULL then the standard malloc/calloc are used.
+ * @param[in] sr_values Array of sysrepo values.
+ * @param[in] sr_value_cnt Number of values in the input array.
+ * @param[in] compress_xpaths Encode xpaths relatively to the xpath of the preceding value
+ *                            where it saves space (see Sr__Value::xpath_prefix_len).
+ * @param[in] message GPB message where the values belong to.
+ * @param[in] field_name Name of the repeated Sr__Value field of the message.
+ *
+ * @return Error code (SR_ERR_OK on success).
+ */
+int sr_values_sr_to_gpb_wire(sr_mem_ctx_t *sr_mem, const sr_val_t *sr_values, const size_t sr_value_cnt,
+        bool compress_xpaths, ProtobufCMessage *message, const char *field_name);
+
+/**
+ * @brief Decodes values of a repeated Sr__Value field directly from a packed GPB message
+ * into sysrepo values array, without creating intermediate GPB values. Relatively encoded
+ * xpaths are expanded.
+ *
+ * @param[in] sr_mem Sysrepo memory context to use for memory allocation.
+ *                   If NULL then the standard malloc/calloc are used.
+ * @param[in] data Packed GPB message.
+ * @param[in] len Length of the packed message.
+ * @param[in] field_id Number of the repeated Sr__Value field in the message.
+ * @param[out] sr_values Array of sysrepo values.
+ * @param[out] sr_value_cnt Number of values in the output array.
+ *
+ * @return Error code (SR_ERR_OK on success), SR_ERR_MALFORMED_MSG if the data can not be decoded.
+ */
+int sr_values_gpb_wire_to_sr(sr_mem_ctx_t *sr_mem, const uint8_t *data, size_t len, uint32_t field_id,
+        sr_val_t **sr_values, size_t *sr_value_cnt);
+
+/**
+ * @brief Count of I/O vectors describing a multicast event notification for one destination.
+ */
+#define SR_GPB_MULTICAST_IOV_CNT 4
+
+/**
+ * @brief Maximal size of the destination-specific data of a multicast event notification,
+ * excluding the destination address itself.
+ */
+#define SR_GPB_MULTICAST_DST_OVERHEAD 32
+
+/**
+ * @brief Event notification request packed once for delivery to multiple subscribers.
+ *
+ * The message is split into parts that are shared by all destinations and a few bytes specific
+ * for each destination (preamble, lengths of the embedded messages, subscriber address and
+ * subscription id), which are spliced between the shared parts by ::sr_gpb_event_notif_multicast_dst.
+ */
+typedef struct sr_gpb_multicast_s {
+    uint8_t *data;     /**< Shared packed parts: EventNotifReq body, rest of the Request, rest of the Msg. */
+    size_t body_size;  /**< Size of the packed EventNotifReq (without the destination fields). */
+    size_t req_size;   /**< Size of the packed Request (without the event notification). */
+    size_t msg_size;   /**< Size of the packed Msg (without the request). */
+} sr_gpb_multicast_t;
+
+/**
+ * @brief Packs an event notification request once so that it can be sent to multiple subscribers.
+ * Subscriber address, subscription id and the list of destinations in the request are ignored.
+ *
+ * @param[in] msg Event notification request message.
+ * @param[out] multicast Packed event notification, release by ::sr_gpb_multicast_free.
+ *
+ * @return Error code (SR_ERR_OK on success).
+ */
+int sr_gpb_event_notif_multicast_init(Sr__Msg *msg, sr_gpb_multicast_t **multicast);
+
+/**
+ * @brief Prepares I/O vectors for sending of the packed event notification to a subscriber.
+ * The vectors describe the whole message including the preamble.
+ *
+ * @param[in] multicast Packed event notification.
+ * @param[in] address Address of the subscriber.
+ * @param[in] subscription_id Subscription identifier.
+ * @param[in] dst_buff Buffer for the destination-specific data, referenced from the vectors.
+ * @param[in] dst_buff_size Size of the buffer, at least SR_GPB_MULTICAST_DST_OVERHEAD + strlen(address).
+ * @param[out] iov I/O vectors of the message.
+ * @param[out] msg_size Total size of the message.
+ *
+ * @return Error code (SR_ERR_OK on success).
+ */
+int sr_gpb_event_notif_multicast_dst(const sr_gpb_multicast_t *multicast, const char *address, uint32_t subscription_id,
+        uint8_t *dst_buff, size_t dst_buff_size, struct iovec iov[SR_GPB_MULTICAST_IOV_CNT], size_t *msg_size);
+
+/**
+ * @brief Frees the packed event notification.
+ *
+ * @param[in] multicast Packed event notification.
+ */
+void sr_gpb_multicast_free(sr_gpb_multicast_t *multicast);
+
 /**
  * @brief Allocates and copies tree data from the sysrepo tree-representation (based on sr_node_t) into
  * the GPB tree-representation (based on Sr__Node).
@@ -261,6 +380,22 @@ Sr__DataStore sr_datastore_sr_to_gpb(const sr_datastore_t sr_ds);
  */
 sr_datastore_t sr_datastore_gpb_to_sr(Sr__DataStore gpb_ds);
 
+/**
+ * @brief Converts sysrepo data format to GPB data format.
+ *
+ * @param [in] sr_format Sysrepo data format.
+ * @return GPB data format.
+ */
+Sr__DataFormat sr_data_format_sr_to_gpb(const sr_data_format_t sr_format);
+
+/**
+ * @brief Converts GPB data format to sysrepo data format.
+ *
+ * @param [in] gpb_format GPB data format.
+ * @return Sysrepo data format.
+ */
+sr_data_format_t sr_data_format_gpb_to_sr(Sr__DataFormat gpb_format);
+
 /**
  * @brief Converts GPB change operation to sysrepo change
  *
@@ -1596,11 +1596,16 @@ sr_api_variant_from_str(const char *api_variant_str)
  * @param [in] slice_width Maximum number of child nodes of the chunk root to include.
  * @param [in] child_limit Limit on the number of copied children imposed on each node starting from 3rd level.
  * @param [in] depth_limit Maximum number of tree levels to copy.
+ * @param [in] first_child Child of the chunk root to start the iteration from (can be NULL).
+ * @param [in] first_offset Position of the first_child among the children of the chunk root.
+ * @param [out] next_child First child of the chunk root behind the slice (can be NULL).
+ * @param [out] next_offset Position of the next_child (can be NULL).
  * @param [out] sr_tree Returned sysrepo tree.
  */
 static int
 sr_copy_node_to_tree_internal(const struct lyd_node *top_parent, const struct lyd_node *node, size_t depth,
          size_t slice_offset, size_t slice_width, size_t child_limit, size_t depth_limit,
+         const struct lyd_node *first_child, size_t first_offset, const struct lyd_node **next_child, size_t *next_offset,
          sr_tree_pruning_cb pruning_cb, void *pruning_ctx, sr_node_t *sr_tree)
 {
     int rc = SR_ERR_OK;
@@ -1608,7 +1613,7 @@ sr_copy_node_to_tree_internal(const struct lyd_node *top_parent, const struct ly
     struct lys_node_container *cont = NULL;
     struct lyd_node_anydata *sch_any = NULL;
     const struct lyd_node *child = NULL;
-    size_t idx = 0;
+    size_t idx = 0, pos = 0;
     bool prune = false;
     sr_node_t *sr_subtree = NULL;
 
@@ -1660,38 +1665,60 @@ sr_copy_node_to_tree_internal(const struct lyd_node *top_parent, const struct ly
     }
 
     /* copy children */
-    if ((LYS_CONTAINER | LYS_LIST) & node->schema->nodetype) {
+    if (((LYS_CONTAINER | LYS_LIST) & node->schema->nodetype) && (depth_limit > depth + 1) /* depth limit */) {
         child = node->child;
         idx = 0;
+        if (0 == depth && NULL != first_child && first_offset <= slice_offset) {
+            /* continue from the child where the previous slice has ended */
+            child = first_child;
+            idx = pos = first_offset;
+        }
         while (child) {
-            if ((0 < depth || slice_offset <= idx) /* slice_offset */ &&
-                (0 < depth || slice_width > idx - slice_offset) /* slice width */ &&
-                (0 == depth || child_limit > idx) /* child_limit */ &&
-                (depth_limit > depth + 1) /* depth limit */) {
-                prune = false;
-                if (NULL != pruning_cb) {
-                    rc = pruning_cb(pruning_ctx, child, &prune);
-                    CHECK_RC_MSG_GOTO(rc, cleanup, "Tree pruning has failed.");
-                }
-                if (true == prune) {
-                    child = child->next;
-                    continue;
-                }
-                rc = sr_node_add_child(sr_tree, NULL, NULL, &sr_subtree);
-                if (SR_ERR_OK != rc) {
-                    goto cleanup;
-                }
-                rc = sr_copy_node_to_tree_internal(top_parent ? top_parent : node, child, depth + 1, slice_offset, slice_width,
-                        child_limit, depth_limit, pruning_cb, pruning_ctx, sr_subtree);
-                if (SR_ERR_OK != rc) {
-                    goto cleanup;
-                }
+            if (0 == depth && slice_offset > idx) {
+                /* slice_offset */
+                child = child->next;
+                ++idx;
+                ++pos;
+                continue;
+            }
+            if ((0 == depth && slice_width <= idx - slice_offset) /* slice width */ ||
+                (0 < depth && child_limit <= idx) /* child_limit */) {
+                /* the rest of the children would not be copied anyway */
+                break;
+            }
+            prune = false;
+            if (NULL != pruning_cb) {
+                rc = pruning_cb(pruning_ctx, child, &prune);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Tree pruning has failed.");
+            }
+            if (true == prune) {
+                child = child->next;
+                ++pos;
+                continue;
+            }
+            rc = sr_node_add_child(sr_tree, NULL, NULL, &sr_subtree);
+            if (SR_ERR_OK != rc) {
+                goto cleanup;
+            }
+            rc = sr_copy_node_to_tree_internal(top_parent ? top_parent : node, child, depth + 1, slice_offset, slice_width,
+                    child_limit, depth_limit, NULL, 0, NULL, NULL, pruning_cb, pruning_ctx, sr_subtree);
+            if (SR_ERR_OK != rc) {
+                goto cleanup;
             }
             child = child->next;
             ++idx;
+            ++pos;
         }
     }
 
+    if (0 == depth && NULL != next_child) {
+        *next_child = child;
+    }
+    if (0 == depth && NULL != next_offset) {
+        /* position of the next_child among all the children */
+        *next_offset = pos;
+    }
+
 cleanup:
     if (SR_ERR_OK != rc) {
         sr_free_tree_content(sr_tree);
@@ -1702,7 +1729,8 @@ cleanup:
 int
 sr_copy_node_to_tree(const struct lyd_node *node, sr_tree_pruning_cb pruning_cb, void *pruning_ctx, sr_node_t *sr_tree)
 {
-    return sr_copy_node_to_tree_internal(NULL, node, 0, 0, SIZE_MAX, SIZE_MAX, SIZE_MAX, pruning_cb, pruning_ctx, sr_tree);
+    return sr_copy_node_to_tree_internal(NULL, node, 0, 0, SIZE_MAX, SIZE_MAX, SIZE_MAX, NULL, 0, NULL, NULL,
+            pruning_cb, pruning_ctx, sr_tree);
 }
 
 int
@@ -1710,7 +1738,18 @@ sr_copy_node_to_tree_chunk(const struct lyd_node *node, size_t slice_offset, siz
         size_t depth_limit, sr_tree_pruning_cb pruning_cb, void *pruning_ctx, sr_node_t *sr_tree)
 {
     return sr_copy_node_to_tree_internal(NULL, node, 0, slice_offset, slice_width, child_limit, depth_limit,
-            pruning_cb, pruning_ctx, sr_tree);
+            NULL, 0, NULL, NULL, pruning_cb, pruning_ctx, sr_tree);
+}
+
+int
+sr_copy_node_to_tree_slice(const struct lyd_node *node, const struct lyd_node **slice_child, size_t *slice_child_offset,
+        size_t slice_offset, size_t slice_width, size_t child_limit, size_t depth_limit,
+        sr_tree_pruning_cb pruning_cb, void *pruning_ctx, sr_node_t *sr_tree)
+{
+    CHECK_NULL_ARG2(slice_child, slice_child_offset);
+
+    return sr_copy_node_to_tree_internal(NULL, node, 0, slice_offset, slice_width, child_limit, depth_limit,
+            *slice_child, *slice_child_offset, slice_child, slice_child_offset, pruning_cb, pruning_ctx, sr_tree);
 }
 
 int
@@ -1813,7 +1852,7 @@ sr_nodes_to_tree_chunks(struct ly_set *nodes, size_t slice_offset, size_t slice_
         }
         trees[j]._sr_mem = sr_mem;
         rc = sr_copy_node_to_tree_internal(NULL, nodes->set.d[i], 0, slice_offset, slice_width, child_limit,
-                depth_limit, pruning_cb, pruning_ctx, trees + j);
+                depth_limit, NULL, 0, NULL, NULL, pruning_cb, pruning_ctx, trees + j);
         ++j;
     }
 
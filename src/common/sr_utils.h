@@ -519,6 +519,27 @@ int sr_copy_node_to_tree(const struct lyd_node *node, sr_tree_pruning_cb pruning
 int sr_copy_node_to_tree_chunk(const struct lyd_node *node, size_t slice_offset, size_t slice_width, size_t child_limit,
         size_t depth_limit, sr_tree_pruning_cb pruning_cb, void *pruning_ctx, sr_node_t *sr_tree);
 
+/**
+ * @brief Copy and convert content of a libyang node and its descendands into a sysrepo tree chunk,
+ * starting the iteration over the children of the chunk root from a remembered position.
+ *
+ * @param [in] node libyang node.
+ * @param [in,out] slice_child Child of the chunk root to start from (NULL to start from the first child),
+ * on return set to the first child behind the slice (NULL if there is none).
+ * @param [in,out] slice_child_offset Position of the slice_child among all the children of the chunk root,
+ * updated on return.
+ * @param [in] slice_offset Number of child nodes of the chunk root to skip.
+ * @param [in] slice_width Maximum number of child nodes of the chunk root to include.
+ * @param [in] child_limit Limit on the number of copied children imposed on each node starting from the 3rd level.
+ * @param [in] depth_limit Maximum number of tree levels to copy.
+ * @param [in] pruning_cb For each subtree this callback decides if it should be pruned away.
+ * @param [in] pruning_ctx Context to pruning callback, opaque to this function.
+ * @param [out] sr_tree Returned sysrepo tree.
+ */
+int sr_copy_node_to_tree_slice(const struct lyd_node *node, const struct lyd_node **slice_child, size_t *slice_child_offset,
+        size_t slice_offset, size_t slice_width, size_t child_limit, size_t depth_limit,
+        sr_tree_pruning_cb pruning_cb, void *pruning_ctx, sr_node_t *sr_tree);
+
 /**
  * @brief Convert a set of libyang nodes into an array of sysrepo trees. For each node a corresponding
  * sysrepo (sub)tree is constructed. It is assumed that the input nodes are not descendands and predecessors
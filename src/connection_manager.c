@@ -28,6 +28,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <signal.h>
@@ -47,6 +48,41 @@
 
 #define CM_MAX_SIGNAL_WATCHERS 2  /**< Maximum number of signals that Connection Manager can watch for. */
 
+#define CM_STATS_LOG_INTERVAL 60  /**< Interval (in seconds) of logging the internal statistics. */
+
+#define CM_OUT_BLOCK_LIMIT (4 * (size_t)SR_OUT_BUFF_LIMIT)  /**< Amount of data buffered for a connection with paused
+                                                                 reading (::CM_OUT_BLOCK), over which it is closed. */
+
+/**
+ * @brief Policy applied to a slow receiver, when the output buffer of its connection
+ * would grow over ::SR_OUT_BUFF_LIMIT.
+ */
+typedef enum cm_out_policy_e {
+    CM_OUT_BLOCK,        /**< Keep the message, but stop reading new requests from the connection until the buffer drains.
+                              If the buffer still grows over ::CM_OUT_BLOCK_LIMIT, close the connection. */
+    CM_OUT_DROP_OLDEST,  /**< Drop the oldest buffered messages that have not started to be sent yet. */
+    CM_OUT_DISCONNECT,   /**< Close the connection (subscriptions of a subscriber connection are removed). */
+} cm_out_policy_t;
+
+/**
+ * @brief Slow-consumer policies of the messages sent to subscribers, per subscription type.
+ * Responses to the requests of client sessions use ::CM_OUT_BLOCK, subscription types
+ * not listed here use ::CM_OUT_DISCONNECT.
+ */
+static const struct {
+    Sr__SubscriptionType type;
+    cm_out_policy_t policy;
+} cm_out_policies[] = {
+    { SR__SUBSCRIPTION_TYPE__EVENT_NOTIF_SUBS, CM_OUT_DROP_OLDEST },
+    { SR__SUBSCRIPTION_TYPE__MODULE_INSTALL_SUBS, CM_OUT_DROP_OLDEST },
+    { SR__SUBSCRIPTION_TYPE__FEATURE_ENABLE_SUBS, CM_OUT_DROP_OLDEST },
+    { SR__SUBSCRIPTION_TYPE__MODULE_CHANGE_SUBS, CM_OUT_DISCONNECT },
+    { SR__SUBSCRIPTION_TYPE__SUBTREE_CHANGE_SUBS, CM_OUT_DISCONNECT },
+    { SR__SUBSCRIPTION_TYPE__DP_GET_ITEMS_SUBS, CM_OUT_DISCONNECT },
+    { SR__SUBSCRIPTION_TYPE__RPC_SUBS, CM_OUT_DISCONNECT },
+    { SR__SUBSCRIPTION_TYPE__ACTION_SUBS, CM_OUT_DISCONNECT },
+};
+
 /**
  * @brief Connection Manager context.
  */
@@ -89,6 +125,15 @@ typedef struct cm_ctx_s {
     ev_signal signal_watchers[CM_MAX_SIGNAL_WATCHERS];
     /** Callbacks called by individual signal watchers. */
     cm_signal_cb signal_callbacks[CM_MAX_SIGNAL_WATCHERS];
+    /** Timer used to periodically log the internal statistics. */
+    ev_timer stats_watcher;
+
+    /** Amount of data (in bytes) buffered for sending in all connections. */
+    ATOMIC_UINT64_T out_buffered_bytes;
+    /** Count of messages dropped due to slow receivers. */
+    ATOMIC_UINT64_T out_dropped_msg_cnt;
+    /** Count of connections closed due to slow receivers. */
+    ATOMIC_UINT64_T out_disconnect_cnt;
 } cm_ctx_t;
 
 /**
@@ -119,7 +164,11 @@ typedef struct cm_session_ctx_s {
 typedef struct cm_connection_ctx_s {
     cm_ctx_t *cm_ctx;      /**< Connection Manager context related to this connection. */
     cm_buffer_t in_buff;   /**< Input buffer. If not empty, there is some received data to be processed. */
+    size_t in_frame;       /**< Position of the message being received in the input buffer. */
     cm_buffer_t out_buff;  /**< Output buffer. If not empty, there is some data to be sent when receiver is ready. */
+    size_t out_head;       /**< Position of the first message in the output buffer that has not started to be sent yet. */
+    uint32_t out_dropped_msg_cnt;  /**< Count of messages to this connection dropped due to slow receiver. */
+    bool read_blocked;     /**< TRUE if reading from the connection is paused until its output buffer drains. */
     ev_io read_watcher;    /**< Watcher for readable events on connection's socket. */
     ev_io write_watcher;   /**< Watcher for writable events on connection's socket. */
 } cm_connection_ctx_t;
@@ -248,6 +297,8 @@ cm_connection_data_cleanup(void *connection)
 {
     sm_connection_t *sm_connection = (sm_connection_t*)connection;
     if ((NULL != sm_connection) && (NULL != sm_connection->cm_data)) {
+        ATOMIC_SUB(&sm_connection->cm_data->cm_ctx->out_buffered_bytes,
+                sm_connection->cm_data->out_buff.pos - sm_connection->cm_data->out_buff.start);
         free(sm_connection->cm_data->in_buff.data);
         free(sm_connection->cm_data->out_buff.data);
         free(sm_connection->cm_data);
@@ -408,6 +459,11 @@ cm_conn_close(cm_ctx_t *cm_ctx, sm_connection_t *conn)
     SR_LOG_INF("Closing the connection %p.", (void*)conn);
 
     if (NULL != conn->cm_data) {
+        if (conn->cm_data->out_dropped_msg_cnt > 0) {
+            SR_LOG_WRN("%"PRIu32" message(s) to the connection %p have been dropped due to slow receiver "
+                    "(%"PRIu64" in total).", conn->cm_data->out_dropped_msg_cnt, (void*)conn,
+                    (uint64_t)ATOMIC_LOAD(&cm_ctx->out_dropped_msg_cnt));
+        }
         ev_io_stop(cm_ctx->event_loop, &conn->cm_data->read_watcher);
         ev_io_stop(cm_ctx->event_loop, &conn->cm_data->write_watcher);
     }
@@ -454,6 +510,19 @@ cm_conn_close(cm_ctx_t *cm_ctx, sm_connection_t *conn)
     return SR_ERR_OK;
 }
 
+/**
+ * @brief Requests closing of the connection from the event loop, once the current callback has returned.
+ * Used from the send path, whose callers may still use the sessions of the connection.
+ */
+static void
+cm_conn_close_deferred(cm_ctx_t *cm_ctx, sm_connection_t *conn)
+{
+    conn->close_requested = true;
+    /* stop accepting new requests, the write callback closes the connection */
+    ev_io_stop(cm_ctx->event_loop, &conn->cm_data->read_watcher);
+    ev_feed_event(cm_ctx->event_loop, &conn->cm_data->write_watcher, EV_WRITE);
+}
+
 /**
  * @brief Expand the size of the buffer of given connection.
  */
@@ -492,14 +561,14 @@ cm_conn_out_buff_flush(cm_ctx_t *cm_ctx, sm_connection_t *connection)
 {
     cm_buffer_t *buff = NULL;
     int written = 0;
-    size_t buff_size = 0, buff_pos = 0;
+    size_t buff_size = 0, buff_pos = 0, buff_start = 0;
     int rc = SR_ERR_OK;
 
     CHECK_NULL_ARG3(cm_ctx, connection, connection->cm_data);
 
     buff = &connection->cm_data->out_buff;
     buff_size = buff->pos;
-    buff_pos = connection->cm_data->out_buff.start;
+    buff_pos = buff_start = connection->cm_data->out_buff.start;
 
     if (buff_size - buff_pos == 0) {
         return rc;
@@ -531,20 +600,124 @@ cm_conn_out_buff_flush(cm_ctx_t *cm_ctx, sm_connection_t *connection)
         }
     } while ((buff_pos < buff_size) && (written > 0));
 
+    ATOMIC_SUB(&cm_ctx->out_buffered_bytes, buff_pos - buff_start);
+
     if (buff_size == buff_pos) {
         /* no more data left in the buffer */
         buff->pos = 0;
         connection->cm_data->out_buff.start = 0;
+        connection->cm_data->out_head = 0;
+    } else {
+        buff->start = buff_pos;
+        /* skip the messages that have started to be sent */
+        while (connection->cm_data->out_head < buff->start) {
+            connection->cm_data->out_head += SR_MSG_PREAM_SIZE + sr_buff_to_uint32(buff->data + connection->cm_data->out_head);
+        }
+    }
+
+    if (connection->cm_data->read_blocked && (buff->pos - buff->start) <= (SR_OUT_BUFF_LIMIT / 2)) {
+        /* the receiver has caught up, resume reading of its requests */
+        SR_LOG_DBG("Output buffer of fd %d drained, resuming reading.", connection->fd);
+        connection->cm_data->read_blocked = false;
+        ev_io_start(cm_ctx->event_loop, &connection->cm_data->read_watcher);
     }
 
     return rc;
 }
 
+/**
+ * @brief Returns the slow-consumer policy of the messages delivered to subscriptions of given type.
+ */
+static cm_out_policy_t
+cm_out_policy_get(Sr__SubscriptionType type)
+{
+    for (size_t i = 0; i < sizeof(cm_out_policies) / sizeof(cm_out_policies[0]); i++) {
+        if (type == cm_out_policies[i].type) {
+            return cm_out_policies[i].policy;
+        }
+    }
+    return CM_OUT_DISCONNECT;
+}
+
+/**
+ * @brief Drops the oldest messages waiting in the output buffer of the connection, until
+ * a message of given size fits into ::SR_OUT_BUFF_LIMIT. Message that has started to be sent is never dropped.
+ */
+static void
+cm_conn_out_buff_drop_oldest(cm_ctx_t *cm_ctx, sm_connection_t *connection, size_t msg_size)
+{
+    cm_buffer_t *buff = &connection->cm_data->out_buff;
+    size_t head = connection->cm_data->out_head, drop_end = head;
+    uint32_t dropped = 0;
+
+    while ((drop_end < buff->pos) && (buff->pos - buff->start - (drop_end - head) + msg_size > SR_OUT_BUFF_LIMIT)) {
+        drop_end += SR_MSG_PREAM_SIZE + sr_buff_to_uint32(buff->data + drop_end);
+        dropped++;
+    }
+    if (0 == dropped) {
+        return;
+    }
+
+    memmove(buff->data + head, buff->data + drop_end, buff->pos - drop_end);
+    buff->pos -= drop_end - head;
+    ATOMIC_SUB(&cm_ctx->out_buffered_bytes, drop_end - head);
+    ATOMIC_ADD(&cm_ctx->out_dropped_msg_cnt, dropped);
+    connection->cm_data->out_dropped_msg_cnt += dropped;
+
+    SR_LOG_WRN("Slow receiver on fd %d, %"PRIu32" oldest message(s) (%zu bytes) dropped.",
+            connection->fd, dropped, drop_end - head);
+}
+
+/**
+ * @brief Applies the slow-consumer policy, if a message of given size would not fit into
+ * ::SR_OUT_BUFF_LIMIT of the connection. A message to a connection with empty output buffer is always accepted.
+ *
+ * @return SR_ERR_OK if the message can be sent, SR_ERR_DISCONNECT if the connection is being closed.
+ */
+static int
+cm_conn_out_budget_check(cm_ctx_t *cm_ctx, sm_connection_t *connection, size_t msg_size, cm_out_policy_t policy)
+{
+    cm_buffer_t *buff = &connection->cm_data->out_buff;
+    size_t buffered = buff->pos - buff->start;
+
+    if (connection->close_requested) {
+        return SR_ERR_DISCONNECT;
+    }
+    if ((0 == buffered) || (buffered + msg_size <= SR_OUT_BUFF_LIMIT)) {
+        return SR_ERR_OK;
+    }
+
+    if ((CM_OUT_BLOCK == policy) && (buffered + msg_size > CM_OUT_BLOCK_LIMIT)) {
+        /* responses to the requests accepted before reading was paused do not fit either */
+        policy = CM_OUT_DISCONNECT;
+    }
+
+    switch (policy) {
+        case CM_OUT_BLOCK:
+            if (!connection->cm_data->read_blocked) {
+                /* the receiver would not get any response faster, do not accept new requests from it */
+                SR_LOG_WRN("Slow receiver on fd %d (%zu bytes buffered), pausing reading.", connection->fd, buffered);
+                connection->cm_data->read_blocked = true;
+                ev_io_stop(cm_ctx->event_loop, &connection->cm_data->read_watcher);
+            }
+            return SR_ERR_OK;
+        case CM_OUT_DROP_OLDEST:
+            cm_conn_out_buff_drop_oldest(cm_ctx, connection, msg_size);
+            return SR_ERR_OK;
+        case CM_OUT_DISCONNECT:
+        default:
+            SR_LOG_WRN("Slow receiver on fd %d (%zu bytes buffered), closing the connection.", connection->fd, buffered);
+            ATOMIC_INC(&cm_ctx->out_disconnect_cnt);
+            cm_conn_close_deferred(cm_ctx, connection);
+            return SR_ERR_DISCONNECT;
+    }
+}
+
 /**
  * @brief Sends a message to the recipient identified by session context.
  */
 static int
-cm_msg_send_connection(cm_ctx_t *cm_ctx, sm_connection_t *connection, Sr__Msg *msg)
+cm_msg_send_connection(cm_ctx_t *cm_ctx, sm_connection_t *connection, Sr__Msg *msg, cm_out_policy_t policy)
 {
     cm_buffer_t *buff = NULL;
     size_t msg_size = 0;
@@ -561,6 +734,12 @@ cm_msg_send_connection(cm_ctx_t *cm_ctx, sm_connection_t *connection, Sr__Msg *m
         return SR_ERR_INTERNAL;
     }
 
+    /* check the receiver is not too slow */
+    rc = cm_conn_out_budget_check(cm_ctx, connection, SR_MSG_PREAM_SIZE + msg_size, policy);
+    if (SR_ERR_OK != rc) {
+        return rc;
+    }
+
     /* expand the buffer if needed */
     rc = cm_conn_buffer_expand(connection, buff, SR_MSG_PREAM_SIZE + msg_size);
 
@@ -572,11 +751,88 @@ cm_msg_send_connection(cm_ctx_t *cm_ctx, sm_connection_t *connection, Sr__Msg *m
         /* write the message */
         sr__msg__pack(msg, (buff->data + buff->pos));
         buff->pos += msg_size;
+        ATOMIC_ADD(&cm_ctx->out_buffered_bytes, SR_MSG_PREAM_SIZE + msg_size);
+
+        /* flush the buffer */
+        rc = cm_conn_out_buff_flush(cm_ctx, connection);
+        if ((connection->close_requested) || (SR_ERR_OK != rc)) {
+            cm_conn_close_deferred(cm_ctx, connection);
+            rc = SR_ERR_DISCONNECT;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * @brief Sends a message described by I/O vectors to the recipient identified by session context.
+ * If the output buffer is empty, the message is written directly from the vectors, otherwise
+ * (or if it cannot be written at once) the unsent part is appended to the output buffer.
+ */
+static int
+cm_msg_send_connection_iov(cm_ctx_t *cm_ctx, sm_connection_t *connection, const struct iovec *iov, size_t iov_cnt,
+        size_t msg_size, cm_out_policy_t policy)
+{
+    cm_buffer_t *buff = NULL;
+    ssize_t written = 0;
+    size_t skip = 0, len = 0;
+    bool partial = false;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG4(cm_ctx, connection, connection->cm_data, iov);
+
+    buff = &connection->cm_data->out_buff;
+
+    /* check the receiver is not too slow */
+    rc = cm_conn_out_budget_check(cm_ctx, connection, msg_size, policy);
+    if (SR_ERR_OK != rc) {
+        return rc;
+    }
+
+    if (buff->pos == buff->start) {
+        /* nothing is waiting in the output buffer, try to send the message right away */
+        do {
+            written = writev(connection->fd, iov, iov_cnt);
+        } while (-1 == written && EINTR == errno);
+        if (written > 0) {
+            SR_LOG_DBG("%zd bytes of data sent.", written);
+            skip = written;
+        } else if ((EWOULDBLOCK != errno) && (EAGAIN != errno)) {
+            /* error by writing - close the connection due to an error */
+            SR_LOG_ERR("Error by writing data to fd %d: %s.", connection->fd, sr_strerror_safe(errno));
+            cm_conn_close_deferred(cm_ctx, connection);
+            return SR_ERR_DISCONNECT;
+        }
+        if (skip == msg_size) {
+            return SR_ERR_OK;
+        }
+    }
+
+    /* copy the unsent part of the message into the output buffer */
+    rc = cm_conn_buffer_expand(connection, buff, msg_size - skip);
+    if (SR_ERR_OK == rc) {
+        ATOMIC_ADD(&cm_ctx->out_buffered_bytes, msg_size - skip);
+        partial = (skip > 0);
+        for (size_t i = 0; i < iov_cnt; ++i) {
+            if (skip >= iov[i].iov_len) {
+                skip -= iov[i].iov_len;
+                continue;
+            }
+            len = iov[i].iov_len - skip;
+            memcpy(buff->data + buff->pos, (uint8_t *)iov[i].iov_base + skip, len);
+            buff->pos += len;
+            skip = 0;
+        }
+        if (partial) {
+            /* the message has started to be sent, it must not be dropped */
+            connection->cm_data->out_head = buff->pos;
+        }
 
         /* flush the buffer */
         rc = cm_conn_out_buff_flush(cm_ctx, connection);
         if ((connection->close_requested) || (SR_ERR_OK != rc)) {
-            cm_conn_close(cm_ctx, connection);
+            cm_conn_close_deferred(cm_ctx, connection);
+            rc = SR_ERR_DISCONNECT;
         }
     }
 
@@ -679,7 +935,7 @@ cm_session_start_req_process(cm_ctx_t *cm_ctx, sm_connection_t *conn, Sr__Msg *m
     }
 
     /* send the response */
-    rc = cm_msg_send_connection(cm_ctx, conn, msg);
+    rc = cm_msg_send_connection(cm_ctx, conn, msg, CM_OUT_BLOCK);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR("Unable to send session_start response (conn=%p).", (void*)conn);
     }
@@ -749,7 +1005,7 @@ cm_session_stop_req_process(cm_ctx_t *cm_ctx, sm_session_t *session, Sr__Msg *ms
     }
 
     /* send the response */
-    rc = cm_msg_send_connection(cm_ctx, session->connection, msg_out);
+    rc = cm_msg_send_connection(cm_ctx, session->connection, msg_out, CM_OUT_BLOCK);
     if (SR_ERR_OK != rc) {
         SR_LOG_WRN("Unable to send session_stop response via session id=%"PRIu32".", session->id);
     }
@@ -794,7 +1050,7 @@ cm_session_check_req_process(cm_ctx_t *cm_ctx, sm_session_t *session, Sr__Msg *m
     msg->session_id = session->id;
 
     /* send the response */
-    rc = cm_msg_send_connection(cm_ctx, session->connection, msg);
+    rc = cm_msg_send_connection(cm_ctx, session->connection, msg, CM_OUT_BLOCK);
     if (SR_ERR_OK != rc) {
         SR_LOG_ERR("Unable to send session_check response (session id=%"PRIu32").", session->id);
     }
@@ -843,7 +1099,7 @@ cm_verify_version_req_process(cm_ctx_t *cm_ctx, sm_connection_t *conn, Sr__Msg *
     }
 
     /* send the response */
-    r = cm_msg_send_connection(cm_ctx, conn, msg);
+    r = cm_msg_send_connection(cm_ctx, conn, msg, CM_OUT_BLOCK);
     if (SR_ERR_OK != r) {
         if (SR_ERR_OK == rc) {
             rc = r;
@@ -1127,7 +1383,7 @@ cm_conn_in_buff_process(cm_ctx_t *cm_ctx, sm_connection_t *conn)
             /* invalid message size */
             SR_LOG_ERR("Invalid message size in the message preamble (%zu).", msg_size);
             return SR_ERR_MALFORMED_MSG;
-        } else if ((buff_size - buff_pos) >= msg_size) {
+        } else if ((buff_size - buff_pos - SR_MSG_PREAM_SIZE) >= msg_size) {
             /* the message is completely retrieved, parse it */
             SR_LOG_DBG("New message of size %zu bytes received.", msg_size);
             rc = cm_conn_msg_process(cm_ctx, conn,
@@ -1151,11 +1407,41 @@ cm_conn_in_buff_process(cm_ctx_t *cm_ctx, sm_connection_t *conn)
             memmove(buff->data, (buff->data + buff_pos), (buff_size - buff_pos));
         }
         buff->pos = buff_size - buff_pos;
+        /* only the partially received message (if any) left in the buffer */
+        conn->cm_data->in_frame = 0;
     }
 
     return rc;
 }
 
+/**
+ * @brief Returns the size of free space needed in the input buffer of the connection. Once the length
+ * preamble of the message being received is known, the space for the whole rest of the message is requested,
+ * so that the buffer is expanded only once per message.
+ */
+static size_t
+cm_conn_in_buff_required_space(cm_connection_ctx_t *cm_data)
+{
+    cm_buffer_t *buff = &cm_data->in_buff;
+    size_t msg_size = 0, received = 0;
+
+    while ((buff->pos - cm_data->in_frame) >= SR_MSG_PREAM_SIZE) {
+        msg_size = sr_buff_to_uint32(buff->data + cm_data->in_frame);
+        if ((msg_size <= 0) || (msg_size > SR_MAX_MSG_SIZE)) {
+            /* invalid message size, will be refused during processing */
+            break;
+        }
+        received = buff->pos - cm_data->in_frame - SR_MSG_PREAM_SIZE;
+        if (received < msg_size) {
+            return ((msg_size - received) > CM_IN_BUFF_MIN_SPACE) ? (msg_size - received) : CM_IN_BUFF_MIN_SPACE;
+        }
+        /* message completely received, continue with the next one */
+        cm_data->in_frame += SR_MSG_PREAM_SIZE + msg_size;
+    }
+
+    return CM_IN_BUFF_MIN_SPACE;
+}
+
 /**
  * @brief Callback called by the event loop watcher when the file descriptor of
  * a connection is readable (some data has arrived).
@@ -1180,7 +1466,7 @@ cm_conn_read_cb(struct ev_loop *loop, ev_io *w, int revents)
 
     do {
         /* expand input buffer if needed */
-        rc = cm_conn_buffer_expand(conn, buff, CM_IN_BUFF_MIN_SPACE);
+        rc = cm_conn_buffer_expand(conn, buff, cm_conn_in_buff_required_space(conn->cm_data));
         if (SR_ERR_OK != rc) {
             conn->close_requested = true;
             break;
@@ -1247,8 +1533,10 @@ cm_conn_write_cb(struct ev_loop *loop, ev_io *w, int revents)
 
     ev_io_stop(cm_ctx->event_loop, &conn->cm_data->write_watcher);
 
-    /* flush the output buffer */
-    rc = cm_conn_out_buff_flush(cm_ctx, conn);
+    /* flush the output buffer, unless the connection is to be closed */
+    if (!conn->close_requested) {
+        rc = cm_conn_out_buff_flush(cm_ctx, conn);
+    }
 
     /* close the connection if requested */
     if ((conn->close_requested) || (SR_ERR_OK != rc)) {
@@ -1467,7 +1755,7 @@ cm_out_notif_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
 
     /* send the message */
     if (SR_ERR_OK == rc) {
-        rc = cm_msg_send_connection(cm_ctx, connection, msg);
+        rc = cm_msg_send_connection(cm_ctx, connection, msg, cm_out_policy_get(msg->notification->type));
     }
 
     if (SR_ERR_OK != rc && SR_ERR_DISCONNECT != rc) {
@@ -1527,7 +1815,7 @@ cm_out_dp_request_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
 
     /* send the message */
     if (SR_ERR_OK == rc) {
-        rc = cm_msg_send_connection(cm_ctx, connection, msg);
+        rc = cm_msg_send_connection(cm_ctx, connection, msg, cm_out_policy_get(SR__SUBSCRIPTION_TYPE__DP_GET_ITEMS_SUBS));
     }
 
     if (SR_ERR_OK != rc && SR_ERR_DISCONNECT != rc) {
@@ -1589,7 +1877,8 @@ cm_out_rpc_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
 
     /* send the message */
     if (SR_ERR_OK == rc) {
-        rc = cm_msg_send_connection(cm_ctx, connection, msg);
+        rc = cm_msg_send_connection(cm_ctx, connection, msg, cm_out_policy_get(msg->request->rpc_req->action ?
+                SR__SUBSCRIPTION_TYPE__ACTION_SUBS : SR__SUBSCRIPTION_TYPE__RPC_SUBS));
     }
 
     if (SR_ERR_OK != rc && SR_ERR_DISCONNECT != rc) {
@@ -1602,6 +1891,77 @@ cm_out_rpc_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
     return rc;
 }
 
+/**
+ * @brief Returns a connection to the event notification destination, connects if needed.
+ */
+static int
+cm_event_notif_conn_get(cm_ctx_t *cm_ctx, const char *destination_address, sm_connection_t **connection)
+{
+    int rc = SR_ERR_OK;
+
+    rc = sm_connection_find_dst(cm_ctx->sm_ctx, destination_address, connection);
+    if (SR_ERR_OK == rc) {
+        /* a connection to the destination already exists - reuse */
+        SR_LOG_DBG("Reusing existing connection on fd=%d for the event notification destination '%s'",
+                (*connection)->fd, destination_address);
+    } else {
+        /* connection to that destination does not exist - connect */
+        SR_LOG_DBG("Creating a new connection for the event notification destination '%s'", destination_address);
+        rc = cm_subscr_conn_create(cm_ctx, destination_address, connection);
+    }
+
+    return rc;
+}
+
+/**
+ * @brief Sends an outgoing event notification to all destinations listed in the message.
+ * The notification is packed only once, destination-specific data are spliced in for each destination.
+ */
+static int
+cm_out_event_notif_multicast(cm_ctx_t *cm_ctx, Sr__Msg *msg)
+{
+    sr_gpb_multicast_t *multicast = NULL;
+    Sr__EventNotifReq__Destination *destination = NULL;
+    sm_connection_t *connection = NULL;
+    struct iovec iov[SR_GPB_MULTICAST_IOV_CNT];
+    uint8_t dst_buff[SR_GPB_MULTICAST_DST_OVERHEAD + sizeof(((struct sockaddr_un *)NULL)->sun_path)];
+    size_t msg_size = 0;
+    int rc = SR_ERR_OK, rc_tmp = SR_ERR_OK;
+
+    CHECK_NULL_ARG4(cm_ctx, msg, msg->request, msg->request->event_notif_req);
+
+    rc = sr_gpb_event_notif_multicast_init(msg, &multicast);
+    CHECK_RC_MSG_RETURN(rc, "Unable to pack the event notification.");
+
+    for (size_t i = 0; i < msg->request->event_notif_req->n_destinations; ++i) {
+        destination = msg->request->event_notif_req->destinations[i];
+
+        SR_LOG_DBG("Sending an event notification to '%s'.", destination->address);
+
+        rc_tmp = sr_gpb_event_notif_multicast_dst(multicast, destination->address, destination->subscription_id,
+                dst_buff, sizeof(dst_buff), iov, &msg_size);
+        if (SR_ERR_OK == rc_tmp) {
+            rc_tmp = cm_event_notif_conn_get(cm_ctx, destination->address, &connection);
+        }
+        if (SR_ERR_OK == rc_tmp) {
+            rc_tmp = cm_msg_send_connection_iov(cm_ctx, connection, iov, SR_GPB_MULTICAST_IOV_CNT, msg_size,
+                    cm_out_policy_get(SR__SUBSCRIPTION_TYPE__EVENT_NOTIF_SUBS));
+        }
+
+        if (SR_ERR_OK != rc_tmp && SR_ERR_DISCONNECT != rc_tmp) {
+            /* by error, remove subscriptions on this destination */
+            cm_subscr_unsubscribe_destination(cm_ctx, destination->address, 0);
+        }
+        if (SR_ERR_OK == rc) {
+            rc = rc_tmp;
+        }
+    }
+
+    sr_gpb_multicast_free(multicast);
+
+    return rc;
+}
+
 /**
  * @brief Processes an outgoing event notification (notification to be sent to the client library).
  */
@@ -1617,8 +1977,6 @@ cm_out_event_notif_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
 
     destination_address = msg->request->event_notif_req->subscriber_address;
 
-    SR_LOG_DBG("Sending an event notification to '%s'.", destination_address);
-
     /* find the session */
     if (0 != msg->session_id) {
         rc = sm_session_find_id(cm_ctx->sm_ctx, msg->session_id, &session);
@@ -1637,21 +1995,21 @@ cm_out_event_notif_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
         SR_LOG_DBG_MSG("Processing event notification without associated session");
     }
 
-    /* get a connection to the notification destination */
-    rc = sm_connection_find_dst(cm_ctx->sm_ctx, destination_address, &connection);
-    if (SR_ERR_OK == rc) {
-        /* a connection to the destination already exists - reuse */
-        SR_LOG_DBG("Reusing existing connection on fd=%d for the event notification destination '%s'",
-                connection->fd, destination_address);
-    } else {
-        /* connection to that destination does not exist - connect */
-        SR_LOG_DBG("Creating a new connection for the event notification destination '%s'", destination_address);
-        rc = cm_subscr_conn_create(cm_ctx, destination_address, &connection);
+    if (msg->request->event_notif_req->n_destinations > 0) {
+        /* deliver to multiple subscribers at once */
+        rc = cm_out_event_notif_multicast(cm_ctx, msg);
+        sr_msg_free(msg);
+        return rc;
     }
 
+    SR_LOG_DBG("Sending an event notification to '%s'.", destination_address);
+
+    /* get a connection to the notification destination */
+    rc = cm_event_notif_conn_get(cm_ctx, destination_address, &connection);
+
     /* send the message */
     if (SR_ERR_OK == rc) {
-        rc = cm_msg_send_connection(cm_ctx, connection, msg);
+        rc = cm_msg_send_connection(cm_ctx, connection, msg, cm_out_policy_get(SR__SUBSCRIPTION_TYPE__EVENT_NOTIF_SUBS));
     }
 
     if (SR_ERR_OK != rc && SR_ERR_DISCONNECT != rc) {
@@ -1690,6 +2048,10 @@ cm_internal_msg_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
         /* schedule delivery of message with postpone timeout */
         rc = cm_delayed_msg_process(cm_ctx, (NULL != session ? session->cm_data : NULL),
                 msg, msg->internal_request->postpone_timeout);
+    } else if (msg->internal_request->has_postpone_timeout_ms) {
+        /* schedule delivery of message with sub-second postpone timeout */
+        rc = cm_delayed_msg_process(cm_ctx, (NULL != session ? session->cm_data : NULL),
+                msg, msg->internal_request->postpone_timeout_ms / 1000.);
     } else {
         /* deliver the message immediately */
         rc = rp_msg_process(cm_ctx->rp_ctx, (NULL != session ? session->cm_data->rp_session : NULL), msg);
@@ -1746,7 +2108,7 @@ cm_out_msg_process(cm_ctx_t *cm_ctx, Sr__Msg *msg)
     /* send the message */
     if (!session->cm_data->stop_requested) {
         /* only if session_stop has not been requested */
-        rc = cm_msg_send_connection(cm_ctx, session->connection, msg);
+        rc = cm_msg_send_connection(cm_ctx, session->connection, msg, CM_OUT_BLOCK);
         if (SR_ERR_OK != rc) {
             SR_LOG_ERR("Unable to send the message over session (id=%"PRIu32").", msg->session_id);
         }
@@ -1838,6 +2200,29 @@ cm_stop_cb(struct ev_loop *loop, ev_async *w, int revents)
     ev_break(cm_ctx->event_loop, EVBREAK_ALL);
 }
 
+/**
+ * @brief Callback called by the event loop timer to log the internal statistics.
+ */
+static void
+cm_stats_cb(struct ev_loop *loop, ev_timer *w, int revents)
+{
+    cm_ctx_t *cm_ctx = NULL;
+    cm_out_stats_t out_stats = { 0, };
+    sr_mem_pool_stats_t mem_stats = { 0, };
+
+    CHECK_NULL_ARG_VOID3(loop, w, w->data);
+    cm_ctx = (cm_ctx_t*)w->data;
+
+    cm_get_out_stats(cm_ctx, &out_stats);
+    SR_LOG_INF("Output buffers: %"PRIu64" bytes buffered, %"PRIu64" messages dropped, %"PRIu64" connections closed "
+            "due to slow receivers.", out_stats.buffered_bytes, out_stats.dropped_msg_cnt, out_stats.disconnect_cnt);
+
+    sr_mem_pool_get_stats(&mem_stats);
+    SR_LOG_INF("Memory context pools: %"PRIu64" hits, %"PRIu64" shared hits, %"PRIu64" misses, "
+            "%"PRIu64" destroyed, %"PRIu64" bytes retained.", mem_stats.hits, mem_stats.shared_hits,
+            mem_stats.misses, mem_stats.destroyed, mem_stats.bytes_retained);
+}
+
 /**
  * @brief Callback called by the event loop watcher when a signal is caught.
  */
@@ -1953,6 +2338,11 @@ cm_init(const cm_connection_mode_t mode, const char *socket_path, cm_ctx_t **cm_
     ctx->msg_queue_watcher.data = (void*)ctx;
     ev_async_start(ctx->event_loop, &ctx->msg_queue_watcher);
 
+    /* initialize timer for logging of the internal statistics */
+    ev_timer_init(&ctx->stats_watcher, cm_stats_cb, CM_STATS_LOG_INTERVAL, CM_STATS_LOG_INTERVAL);
+    ctx->stats_watcher.data = (void*)ctx;
+    ev_timer_start(ctx->event_loop, &ctx->stats_watcher);
+
     /* initialize Request Processor */
     rc = rp_init(ctx, &ctx->rp_ctx);
     if (SR_ERR_OK != rc) {
@@ -2116,6 +2506,16 @@ cm_watch_signal(cm_ctx_t *cm_ctx, int signum, cm_signal_cb callback)
     return SR_ERR_INTERNAL; /* no space for more watchers */
 }
 
+void
+cm_get_out_stats(cm_ctx_t *cm_ctx, cm_out_stats_t *stats)
+{
+    CHECK_NULL_ARG_VOID2(cm_ctx, stats);
+
+    stats->buffered_bytes = ATOMIC_LOAD(&cm_ctx->out_buffered_bytes);
+    stats->dropped_msg_cnt = ATOMIC_LOAD(&cm_ctx->out_dropped_msg_cnt);
+    stats->disconnect_cnt = ATOMIC_LOAD(&cm_ctx->out_disconnect_cnt);
+}
+
 cm_connection_mode_t
 cm_get_connection_mode(cm_ctx_t *cm_ctx)
 {
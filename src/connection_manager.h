@@ -173,6 +173,25 @@ typedef void (*cm_signal_cb)(cm_ctx_t *cm_ctx, int signum);
  */
 int cm_watch_signal(cm_ctx_t *cm_ctx, int signum, cm_signal_cb callback);
 
+/**
+ * @brief Statistics of the data sent by Connection Manager to slow receivers.
+ */
+typedef struct cm_out_stats_s {
+    uint64_t buffered_bytes;   /**< Amount of data (in bytes) currently buffered for sending in all connections. */
+    uint64_t dropped_msg_cnt;  /**< Count of messages dropped due to slow receivers. */
+    uint64_t disconnect_cnt;   /**< Count of connections closed due to slow receivers. */
+} cm_out_stats_t;
+
+/**
+ * @brief Get statistics of the data sent to slow receivers.
+ *
+ * @note This function is thread safe, can be called from any thread.
+ *
+ * @param[in] cm_ctx Connection Manager context.
+ * @param[out] stats Statistics.
+ */
+void cm_get_out_stats(cm_ctx_t *cm_ctx, cm_out_stats_t *stats);
+
 /**
  * @brief Get connection mode in which the given instance of Connection Manager
  * operates.
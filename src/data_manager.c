@@ -27,6 +27,7 @@
 #include <dirent.h>
 #include <pthread.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <libyang/libyang.h>
 #include <string.h>
 #include <inttypes.h>
@@ -54,6 +55,34 @@ typedef struct dm_tmp_ly_ctx_s {
     sr_list_t *loaded_modules;
 } dm_tmp_ly_ctx_t;
 
+/**
+ * @brief Structure holding one epoch of the libyang context shared by all schema infos
+ * (used only if SHARED_LY_CTX is defined). A new epoch is created whenever the set
+ * of installed modules changes, the previous one is destroyed once it is no longer
+ * referenced by any schema info.
+ */
+typedef struct dm_shared_ly_ctx_s {
+    struct ly_ctx *ctx;           /**< libyang context with all installed modules loaded */
+    uint32_t epoch;               /**< sequence number of the context */
+    ATOMIC_UINT32_T ref_count;    /**< number of schema infos referencing the context, +1 for the current epoch */
+} dm_shared_ly_ctx_t;
+
+/**
+ * @brief Read-only data tree parsed from a datastore file. The tree is cached in the schema info
+ * and borrowed by auxiliary data infos (data of other modules needed only for validation),
+ * so that it is parsed only once while the file is unchanged. Validation in the shared context
+ * links the borrowed tree in place (::dm_validate_linked_data), the data appended to a session
+ * data info (::dm_append_data_tree) and the data validated in a temporary context are still
+ * copied out of it.
+ */
+typedef struct dm_rdonly_tree_s {
+    struct lyd_node *node;        /**< data tree, must not be modified */
+    struct timespec timestamp;    /**< modification time of the data file the tree was loaded from */
+    ATOMIC_UINT32_T ref_count;    /**< number of data infos borrowing the tree, +1 if it is cached in the schema info */
+    pthread_mutex_t lock;         /**< held by the readers of the tree and while the tree is temporarily linked
+                                       with the data of other modules for validation */
+} dm_rdonly_tree_t;
+
 /**
  * @brief Structure that holds Data Manager's per-session context.
  */
@@ -91,6 +120,15 @@ typedef enum dm_procedure_e {
     DM_PROCEDURE_ACTION,            /**< NETCONF RPC operation connected to a specific data node. */
 } dm_procedure_t;
 
+/**
+ * @brief Changes of recent commits of a module waiting to be notified to coalescing subscribers.
+ */
+typedef struct dm_coalesced_commit_s {
+    char *module_name;          /**< name of the module */
+    dm_commit_context_t *c_ctx; /**< commit context holding the data tree before the first and after the last merged commit */
+    size_t commit_cnt;          /**< number of merged commits */
+} dm_coalesced_commit_t;
+
 /** @brief Invalid value for the commit context id, used for signaling e.g.: duplicate id */
 #define DM_COMMIT_CTX_ID_INVALID 0
 /** @brief Number of attempts to generate unique id for commit context */
@@ -107,13 +145,31 @@ typedef enum dm_procedure_e {
  */
 #define NANOSEC_THRESHOLD 10000000
 
+/** @brief Name of the warm image file stored in the internal data directory */
+#define DM_WARM_IMAGE_FILENAME "sysrepo-warm-image.bin"
+/** @brief Magic number identifying the warm image file ("SRWI") */
+#define DM_WARM_IMAGE_MAGIC 0x49575253
+/** @brief Version of the warm image layout, images of another version are ignored */
+#define DM_WARM_IMAGE_VERSION 1
+
+/** @brief Name of the file locked while the rollback checkpoints are being accessed */
+#define DM_CHECKPOINT_LOCK_FILENAME "sysrepo-checkpoint.lock"
+/** @brief Format of the name of the rollback checkpoint file, the argument is the slot in the ring of checkpoints */
+#define DM_CHECKPOINT_FILENAME_FMT "sysrepo-checkpoint-%" PRIu64 ".bin"
+/** @brief Magic number identifying the rollback checkpoint file ("SRCP") */
+#define DM_CHECKPOINT_MAGIC 0x50435253
+/** @brief Version of the rollback checkpoint layout, checkpoints of another version are ignored */
+#define DM_CHECKPOINT_VERSION 1
+
 /**
  * @brief Maximum number of seconds that function will wait for ongoing commit
  * to finish when the cleanup was requested.
  */
 #define DM_COMMIT_MAX_WAIT_TIME 30
 
-static int dm_get_data_info_internal(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, bool skip_validation, bool *should_be_freed, dm_data_info_t **info);
+static int dm_get_data_info_internal(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, bool skip_validation, bool rdonly, bool *should_be_freed, dm_data_info_t **info);
+static int dm_is_info_copy_uptodate(dm_ctx_t *dm_ctx, const char *file_name, const dm_data_info_t *info, bool *res);
+static int dm_prepare_c_ctx_for_enable_notification(dm_ctx_t *dm_ctx, dm_commit_context_t **commit_context);
 
 /**
  * @brief Compares two data trees by module name
@@ -126,7 +182,7 @@ dm_data_info_cmp(const void *a, const void *b)
     dm_data_info_t *node_a = (dm_data_info_t *) a;
     dm_data_info_t *node_b = (dm_data_info_t *) b;
 
-    int res = strcmp(node_a->schema->module->name, node_b->schema->module->name);
+    int res = strcmp(node_a->schema->module_name, node_b->schema->module_name);
     if (res == 0) {
         return 0;
     } else if (res < 0) {
@@ -220,6 +276,38 @@ dm_c_ctx_id_cmp(const void *a, const void *b)
     }
 }
 
+/**
+ * @brief Compares two coalesced commits by module name
+ */
+static int
+dm_coalesced_commit_cmp(const void *a, const void *b)
+{
+    assert(a);
+    assert(b);
+    dm_coalesced_commit_t *cc_a = (dm_coalesced_commit_t *) a;
+    dm_coalesced_commit_t *cc_b = (dm_coalesced_commit_t *) b;
+
+    int res = strcmp(cc_a->module_name, cc_b->module_name);
+    if (0 == res) {
+        return 0;
+    } else if (res < 0) {
+        return -1;
+    } else {
+        return 1;
+    }
+}
+
+static void
+dm_coalesced_commit_free(void *item)
+{
+    dm_coalesced_commit_t *cc = (dm_coalesced_commit_t *) item;
+    if (NULL != cc) {
+        dm_free_commit_context(cc->c_ctx);
+        free(cc->module_name);
+        free(cc);
+    }
+}
+
 int
 dm_set_node_state(struct lys_node *node, dm_node_state_t state)
 {
@@ -270,15 +358,152 @@ dm_free_lys_private_data(const struct lys_node *node, void *private)
     }
 }
 
+/**
+ * @brief Releases one reference to the epoch of the shared libyang context,
+ * the context is destroyed once the last reference is dropped.
+ */
+static void
+dm_shared_ly_ctx_release(dm_shared_ly_ctx_t *shared_ctx)
+{
+    if (NULL != shared_ctx && 1 == ATOMIC_DEC(&shared_ctx->ref_count)) {
+        SR_LOG_DBG("Destroying shared libyang context (epoch %"PRIu32").", shared_ctx->epoch);
+        ly_ctx_destroy(shared_ctx->ctx, dm_free_lys_private_data);
+        free(shared_ctx);
+    }
+}
+
+/**
+ * @brief Marks the schema info as used by the data info (the module can not be uninstalled
+ * nor moved to another epoch of the shared libyang context until the data info is freed).
+ * The data info also takes a reference to the epoch of the shared context its data tree
+ * belongs to, so the tree stays valid even if it outlives the binding of the schema info.
+ */
+static void
+dm_data_info_use_schema(dm_data_info_t *di, dm_schema_info_t *si)
+{
+    pthread_mutex_lock(&si->usage_count_mutex);
+    si->usage_count++;
+    SR_LOG_DBG("Usage count %s incremented (value=%zu)", si->module_name, si->usage_count);
+    if (NULL != si->shared_ly_ctx) {
+        ATOMIC_INC(&si->shared_ly_ctx->ref_count);
+    }
+    di->shared_ly_ctx = si->shared_ly_ctx;
+    pthread_mutex_unlock(&si->usage_count_mutex);
+}
+
+dm_shared_ly_ctx_t *
+dm_schema_info_ctx_acquire(dm_schema_info_t *schema_info)
+{
+    dm_shared_ly_ctx_t *shared_ctx = NULL;
+
+    if (NULL == schema_info) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&schema_info->usage_count_mutex);
+    shared_ctx = schema_info->shared_ly_ctx;
+    if (NULL != shared_ctx) {
+        ATOMIC_INC(&shared_ctx->ref_count);
+    }
+    pthread_mutex_unlock(&schema_info->usage_count_mutex);
+
+    return shared_ctx;
+}
+
+void
+dm_schema_info_ctx_release(dm_shared_ly_ctx_t *shared_ctx)
+{
+    dm_shared_ly_ctx_release(shared_ctx);
+}
+
+/**
+ * @brief Releases one reference to the read-only data tree, the tree is freed once the last reference is dropped.
+ */
+static void
+dm_rdonly_tree_release(dm_rdonly_tree_t *tree)
+{
+    if (NULL != tree && 1 == ATOMIC_DEC(&tree->ref_count)) {
+        lyd_free_withsiblings(tree->node);
+        pthread_mutex_destroy(&tree->lock);
+        free(tree);
+    }
+}
+
+/**
+ * @brief Locks the read-only tree borrowed by the data info, does nothing if the data info owns its data tree.
+ * Any traversal of a borrowed tree must be done with the tree locked, see ::dm_validate_linked_data.
+ */
+static void
+dm_data_info_rdonly_lock(const dm_data_info_t *info)
+{
+    if (NULL != info->rdonly_tree) {
+        pthread_mutex_lock(&info->rdonly_tree->lock);
+    }
+}
+
+/**
+ * @brief Unlocks the read-only tree locked by ::dm_data_info_rdonly_lock.
+ */
+static void
+dm_data_info_rdonly_unlock(const dm_data_info_t *info)
+{
+    if (NULL != info->rdonly_tree) {
+        pthread_mutex_unlock(&info->rdonly_tree->lock);
+    }
+}
+
+/**
+ * @brief Drops read-only data trees cached in the schema info. Trees that are still borrowed
+ * are freed once released by the last data info.
+ *
+ * @note Function expects that the schema info is locked for writing or is not accessible by other threads.
+ */
+static void
+dm_rdonly_trees_invalidate(dm_schema_info_t *si)
+{
+    for (size_t i = 0; i < DM_DATASTORE_COUNT; i++) {
+        dm_rdonly_tree_release(si->rdonly_trees[i]);
+        si->rdonly_trees[i] = NULL;
+    }
+}
+
+void
+dm_dp_index_release(dm_dp_index_t *dp_index)
+{
+    if (NULL != dp_index && 1 == ATOMIC_DEC(&dp_index->ref_count)) {
+        np_subscriptions_list_cleanup(dp_index->subscriptions);
+        sr_list_cleanup(dp_index->nodes);
+        sr_btree_cleanup(dp_index->nodes_index);
+        free(dp_index);
+    }
+}
+
+/**
+ * @brief Drops the data cached in the schema info that references the schema tree
+ * (read-only data trees, data provider subscription index).
+ *
+ * @note Function expects that the schema info is locked for writing or is not accessible by other threads.
+ */
+static void
+dm_schema_info_caches_invalidate(dm_schema_info_t *si)
+{
+    dm_rdonly_trees_invalidate(si);
+    dm_dp_index_release(si->dp_index);
+    si->dp_index = NULL;
+}
+
 void
 dm_free_schema_info(void *schema_info)
 {
     CHECK_NULL_ARG_VOID(schema_info);
     dm_schema_info_t *si = (dm_schema_info_t *) schema_info;
+    dm_schema_info_caches_invalidate(si);
     free(si->module_name);
     pthread_rwlock_destroy(&si->model_lock);
     pthread_mutex_destroy(&si->usage_count_mutex);
-    if (NULL != si->ly_ctx) {
+    if (NULL != si->shared_ly_ctx) {
+        dm_shared_ly_ctx_release(si->shared_ly_ctx);
+    } else if (NULL != si->ly_ctx) {
         ly_ctx_destroy(si->ly_ctx, dm_free_lys_private_data);
     }
     free(si);
@@ -292,17 +517,57 @@ dm_data_info_free(void *item)
 {
     dm_data_info_t *info = (dm_data_info_t *) item;
     if (NULL != info && !info->rdonly_copy) {
-        lyd_free_withsiblings(info->node);
+        if (NULL != info->rdonly_tree) {
+            /* the node is borrowed, just drop the reference */
+            dm_rdonly_tree_release(info->rdonly_tree);
+        } else {
+            lyd_free_withsiblings(info->node);
+        }
         sr_free_list_of_strings(info->required_modules);
         /* decrement the number of usage of the module */
         pthread_mutex_lock(&info->schema->usage_count_mutex);
         info->schema->usage_count--;
         SR_LOG_DBG("Usage count %s decremented (value=%zu)", info->schema->module_name, info->schema->usage_count);
         pthread_mutex_unlock(&info->schema->usage_count_mutex);
+        dm_shared_ly_ctx_release(info->shared_ly_ctx);
     }
     free(info);
 }
 
+/**
+ * @brief Compares two index entries by the schema node
+ */
+static int
+dm_node_index_entry_cmp(const void *a, const void *b)
+{
+    assert(a);
+    assert(b);
+    const dm_node_index_entry_t *entry_a = (const dm_node_index_entry_t *) a;
+    const dm_node_index_entry_t *entry_b = (const dm_node_index_entry_t *) b;
+
+    if (entry_a->node == entry_b->node) {
+        return 0;
+    } else if ((uintptr_t) entry_a->node < (uintptr_t) entry_b->node) {
+        return -1;
+    } else {
+        return 1;
+    }
+}
+
+/**
+ * @brief Frees an index entry
+ */
+static void
+dm_node_index_entry_free(void *item)
+{
+    dm_node_index_entry_t *entry = (dm_node_index_entry_t *) item;
+    if (NULL != entry) {
+        free(entry->items);
+        free(entry->desc_items);
+    }
+    free(entry);
+}
+
 static void
 dm_model_subscription_free(void *sub)
 {
@@ -310,6 +575,9 @@ dm_model_subscription_free(void *sub)
     if (NULL != ms) {
         np_subscriptions_list_cleanup(ms->subscriptions);
         free(ms->nodes);
+        sr_btree_cleanup(ms->nodes_index);
+        free(ms->matched);
+        sr_btree_cleanup(ms->changes_index);
         lyd_free_diff(ms->difflist);
         if (NULL != ms->changes) {
             for (int i = 0; i < ms->changes->count; i++) {
@@ -698,10 +966,7 @@ dm_insert_data_info_copy(sr_btree_t *tree, const dm_data_info_t *di)
         CHECK_NULL_NOMEM_GOTO(copy->node, rc, cleanup);
     }
 
-    pthread_mutex_lock(&di->schema->usage_count_mutex);
-    di->schema->usage_count++;
-    SR_LOG_DBG("Usage count %s incremented (value=%zu)", di->schema->module_name, di->schema->usage_count);
-    pthread_mutex_unlock(&di->schema->usage_count_mutex);
+    dm_data_info_use_schema(copy, di->schema);
     copy->schema = di->schema;
     copy->timestamp = di->timestamp;
 
@@ -739,6 +1004,9 @@ dm_feature_enable_internal(dm_ctx_t *dm_ctx, dm_schema_info_t *schema_info, cons
         return SR_ERR_OPERATION_FAILED;
     }
 
+    /* cached data trees and indices reference the schema that is about to change */
+    dm_schema_info_caches_invalidate(schema_info);
+
     const struct lys_module *module = ly_ctx_get_module(schema_info->ly_ctx, module_name, NULL, 0);
     if (NULL != module) {
         rc = enable ? lys_features_enable(module, feature_name) : lys_features_disable(module, feature_name);
@@ -1216,133 +1484,419 @@ dm_compare_modules_cb(const void *a, const void *b) {
     }
 }
 
+#ifdef SHARED_LY_CTX
 /**
- * @brief Loads module and all its dependencies into the libyang context.
+ * @brief Tests whether the module depends on data from other modules.
+ */
+static bool
+dm_module_has_data_dependency(md_module_t *module)
+{
+    sr_llist_node_t *ll_node = module->deps->first;
+
+    while (ll_node) {
+        if (MD_DEP_DATA == ((md_dep_t *) ll_node->data)->type) {
+            return true;
+        }
+        ll_node = ll_node->next;
+    }
+    return false;
+}
+
+/**
+ * @brief Creates a new epoch of the shared libyang context with all installed modules loaded.
+ *
+ * @note Function expects that md_ctx is locked by the caller.
+ *
  * @param [in] dm_ctx
- * @param [in] module_name
- * @param [in] revision can be NULL
- * @param [out] module_schema
+ * @param [in] epoch - sequence number of the new context
+ * @param [out] shared_ctx
  * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_load_module(dm_ctx_t *dm_ctx, const char *module_name, const char *revision, dm_schema_info_t **schema_info)
+dm_shared_ly_ctx_new(dm_ctx_t *dm_ctx, uint32_t epoch, dm_shared_ly_ctx_t **shared_ctx)
 {
-    CHECK_NULL_ARG3(dm_ctx, module_name, schema_info); /* revision might be NULL*/
+    CHECK_NULL_ARG3(dm_ctx, dm_ctx->md_ctx, shared_ctx);
     int rc = SR_ERR_OK;
-    dm_schema_info_t *si = NULL;
+    dm_shared_ly_ctx_t *shared = NULL;
     md_module_t *module = NULL;
-    sr_btree_t *loaded_deps = NULL, *completed_deps = NULL;
-    md_dep_t *dep = NULL;
-    const struct lys_module *ly_mod = NULL;
-
-    /* search for the module to use */
-    md_ctx_lock(dm_ctx->md_ctx, false);
-    rc = md_get_module_info(dm_ctx->md_ctx, module_name, revision, NULL, &module);
-    if (SR_ERR_OK != rc) {
-        SR_LOG_ERR("Module '%s:%s' is not installed.", module_name, revision ? revision : "<latest>");
-        *schema_info = NULL;
-        md_ctx_unlock(dm_ctx->md_ctx);
-        return SR_ERR_UNKNOWN_MODEL;
-    }
-    if (module->submodule) {
-        SR_LOG_WRN("An attempt to load submodule %s", module_name);
-        rc = SR_ERR_INVAL_ARG;
-        goto cleanup;
-    }
-
-    /* allocate new structure where schemas will be loaded*/
-    rc = dm_schema_info_init(dm_ctx->schema_search_dir, &si);
-    CHECK_RC_MSG_RETURN(rc, "Schema info init failed");
-
-    /* load the module schema and all its dependencies */
-    rc = dm_load_schema_file(module->filepath, si, &ly_mod);
-    CHECK_RC_LOG_RETURN(rc, "Failed to load schema %s", dep->dest->filepath);
-
-    si->module_name = strdup(ly_mod->name);
-    CHECK_NULL_NOMEM_GOTO(si->module_name, rc, cleanup);
-    si->module = ly_mod;
-    si->has_instance_id = module->inst_ids->first != NULL;
-
-    /* load the module schema and all its dependencies */
-    rc = sr_btree_init(dm_compare_modules_cb, NULL, &loaded_deps);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
-
-    rc = dm_load_module_ident_deps_r(module, si, loaded_deps);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load identityref dependencies for module %s", module->name);
-
-    rc = dm_load_module_deps_r(module, si, loaded_deps);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load dependencies for module %s", module->name);
-
-    sr_btree_cleanup(loaded_deps);
-    loaded_deps = NULL;
-
-    /* compute xpath hashes for all schema nodes (referenced from data tree) */
-    rc = dm_init_missing_node_priv_data(si);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to initialize private data for module %s", module->name);
-
-    /* apply persist data enable features, running datastore */
-    rc = sr_btree_init(dm_compare_modules_cb, NULL, &loaded_deps);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
-    rc = sr_btree_init(dm_compare_modules_cb, NULL, &completed_deps);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
+    sr_llist_node_t *ll_node = NULL;
+    const char *rev = NULL;
+    uint32_t loaded_cnt = 0;
+    struct timespec ts_start = {0}, ts_end = {0};
 
-    rc = dm_apply_module_dep_persist_r(dm_ctx, module, si, loaded_deps, completed_deps);
-    sr_btree_cleanup(loaded_deps);
-    loaded_deps = NULL;
-    sr_btree_cleanup(completed_deps);
-    completed_deps = NULL;
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to apply persist data");
+    sr_clock_get_time(CLOCK_MONOTONIC, &ts_start);
 
-    /* distinguish between modules that can and cannot be locked */
-    si->can_not_be_locked = !module->has_data;
+    shared = calloc(1, sizeof *shared);
+    CHECK_NULL_NOMEM_RETURN(shared);
+    shared->epoch = epoch;
+    shared->ref_count = 1; /* reference held by dm_ctx */
 
-    /* insert schema info into schema tree */
-    RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&dm_ctx->schema_tree_lock, rc, cleanup);
+    shared->ctx = ly_ctx_new(dm_ctx->schema_search_dir, LY_CTX_NOYANGLIBRARY);
+    CHECK_NULL_NOMEM_GOTO(shared->ctx, rc, cleanup);
 
-    rc = sr_btree_insert(dm_ctx->schema_info_tree, si);
-    if (SR_ERR_OK != rc) {
-        if (SR_ERR_DATA_EXISTS != rc) {
-            SR_LOG_WRN("Insert into schema binary tree failed. %s", sr_strerror(rc));
-            goto unlock;
+    /* load all implemented modules, imports are loaded automatically by libyang */
+    for (ll_node = dm_ctx->md_ctx->modules->first; NULL != ll_node; ll_node = ll_node->next) {
+        module = (md_module_t *) ll_node->data;
+        if (module->submodule || !module->implemented) {
+            continue;
+        }
+        rev = ('\0' != module->revision_date[0]) ? module->revision_date : NULL;
+        if (NULL != ly_ctx_get_module(shared->ctx, module->name, rev, 1)) {
+            continue;
+        }
+        if (NULL == lys_parse_path(shared->ctx, module->filepath,
+                    sr_str_ends_with(module->filepath, SR_SCHEMA_YIN_FILE_EXT) ? LYS_IN_YIN : LYS_IN_YANG)) {
+            SR_LOG_WRN("Unable to load module %s into the shared context: %s", module->name, ly_errmsg(shared->ctx));
         } else {
-            /* if someone loaded schema meanwhile */
-            dm_schema_info_t *lookup = si;
-            si = sr_btree_search(dm_ctx->schema_info_tree, lookup);
-            dm_free_schema_info(lookup);
-            if (NULL != si) {
-                rc = SR_ERR_OK;
-            } else {
-                SR_LOG_ERR_MSG("Failed to find a schema in schema tree");
-            }
+            loaded_cnt++;
         }
     }
 
-unlock:
-    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
-cleanup:
-    sr_btree_cleanup(loaded_deps);
-    sr_btree_cleanup(completed_deps);
+    for (ll_node = dm_ctx->md_ctx->modules->first; NULL != ll_node; ll_node = ll_node->next) {
+        module = (md_module_t *) ll_node->data;
+        if (module->submodule || !module->implemented) {
+            continue;
+        }
+        rc = dm_mark_deps_as_implemented(module, shared->ctx);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to mark imports as implemented for module %s", module->name);
+    }
 
+    sr_clock_get_time(CLOCK_MONOTONIC, &ts_end);
+    SR_LOG_INF("Shared libyang context (epoch %"PRIu32") with %"PRIu32" modules created in %.3f seconds.", epoch,
+            loaded_cnt, (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9);
+
+cleanup:
     if (SR_ERR_OK == rc) {
-        *schema_info = si;
+        *shared_ctx = shared;
     } else {
-        dm_free_schema_info(si);
+        dm_shared_ly_ctx_release(shared);
     }
-    md_ctx_unlock(dm_ctx->md_ctx);
     return rc;
 }
 
 /**
- * @brief Function removes the subtrees that doesn't belong to the selected module.
+ * @brief Binds the schema info to the current epoch of the shared libyang context
+ * and fills in the module-related flags.
+ *
+ * @note Function expects that md_ctx is locked by the caller and that the schema info
+ * is either locked for writing or not accessible by other threads yet.
+ *
+ * @param [in] dm_ctx
+ * @param [in] module - module the schema info is created for
+ * @param [in] si
+ * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_remove_added_data_trees_by_module_name(const char *module_name, struct lyd_node **root)
+dm_shared_schema_info_bind(dm_ctx_t *dm_ctx, md_module_t *module, dm_schema_info_t *si)
 {
-    CHECK_NULL_ARG(module_name);
-    int rc = SR_ERR_OK;
-    if (NULL != *root) {
-        struct ly_ctx *ctx = (*root)->schema->module->ctx;
-        const struct lys_module *module = ly_ctx_get_module(ctx, module_name, NULL, 1);
+    CHECK_NULL_ARG4(dm_ctx, dm_ctx->shared_ly_ctx, module, si);
+    dm_shared_ly_ctx_t *shared = dm_ctx->shared_ly_ctx, *old_shared = si->shared_ly_ctx;
+    const struct lys_module *ly_mod = NULL;
+
+    ly_mod = ly_ctx_get_module(shared->ctx, module->name,
+            ('\0' != module->revision_date[0]) ? module->revision_date : NULL, 1);
+    if (NULL == ly_mod) {
+        SR_LOG_ERR("Module %s is missing in the shared context (epoch %"PRIu32").", module->name, shared->epoch);
+        return SR_ERR_INTERNAL;
+    }
+
+    ATOMIC_INC(&shared->ref_count);
+    si->shared_ly_ctx = shared;
+    si->ly_ctx = shared->ctx;
+    si->module = ly_mod;
+    si->has_instance_id = NULL != module->inst_ids->first;
+    si->cross_module_data_dependency = dm_module_has_data_dependency(module);
+    si->can_not_be_locked = !module->has_data;
+
+    /* the old epoch is destroyed once the readers holding a reference release it */
+    dm_shared_ly_ctx_release(old_shared);
+
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Detaches the schema info from the shared libyang context (the module has been uninstalled).
+ */
+static void
+dm_shared_schema_info_unbind(dm_schema_info_t *si)
+{
+    dm_schema_info_caches_invalidate(si);
+    dm_shared_ly_ctx_release(si->shared_ly_ctx);
+    si->shared_ly_ctx = NULL;
+    si->ly_ctx = NULL;
+    si->module = NULL;
+}
+
+/**
+ * @brief Moves an idle schema info that references an older epoch of the shared libyang
+ * context to the current one. Schema private data and persistent data (enabled features,
+ * enabled running subtrees) are applied again in the new context.
+ *
+ * @note Function expects that md_ctx is locked by the caller and that the schema info
+ * is locked for writing.
+ *
+ * @param [in] dm_ctx
+ * @param [in] si
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_shared_schema_info_rebind(dm_ctx_t *dm_ctx, dm_schema_info_t *si)
+{
+    CHECK_NULL_ARG2(dm_ctx, si);
+    int rc = SR_ERR_OK;
+    md_module_t *module = NULL;
+    sr_btree_t *applied_persist = NULL, *completed_deps = NULL;
+
+    if (si->shared_ly_ctx == dm_ctx->shared_ly_ctx && NULL != si->ly_ctx) {
+        return SR_ERR_OK;
+    }
+
+    /* the binding is swapped under usage_count_mutex, so that the readers taking a reference
+     * to the epoch (::dm_schema_info_ctx_acquire) see either the old or the new one */
+    pthread_mutex_lock(&si->usage_count_mutex);
+    if (0 != si->usage_count) {
+        SR_LOG_DBG("Module %s is in use, it will be moved to the shared context epoch %"PRIu32" once released.",
+                si->module_name, dm_ctx->shared_ly_ctx->epoch);
+        pthread_mutex_unlock(&si->usage_count_mutex);
+        return SR_ERR_OK;
+    }
+
+    rc = md_get_module_info(dm_ctx->md_ctx, si->module_name, NULL, NULL, &module);
+    if (SR_ERR_OK != rc) {
+        /* module is not installed anymore */
+        dm_shared_schema_info_unbind(si);
+        pthread_mutex_unlock(&si->usage_count_mutex);
+        return SR_ERR_OK;
+    }
+
+    dm_schema_info_caches_invalidate(si);
+    rc = dm_shared_schema_info_bind(dm_ctx, module, si);
+    pthread_mutex_unlock(&si->usage_count_mutex);
+    CHECK_RC_LOG_RETURN(rc, "Failed to bind module %s to the shared context", si->module_name);
+
+    rc = dm_init_missing_node_priv_data(si);
+    CHECK_RC_LOG_RETURN(rc, "Failed to initialize private data for module %s", si->module_name);
+
+    rc = sr_btree_init(dm_compare_modules_cb, NULL, &applied_persist);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
+    rc = sr_btree_init(dm_compare_modules_cb, NULL, &completed_deps);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
+
+    rc = dm_apply_module_dep_persist_r(dm_ctx, module, si, applied_persist, completed_deps);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to apply persist data for module %s", si->module_name);
+
+    SR_LOG_DBG("Module %s moved to the shared context epoch %"PRIu32".", si->module_name, si->shared_ly_ctx->epoch);
+
+cleanup:
+    sr_btree_cleanup(applied_persist);
+    sr_btree_cleanup(completed_deps);
+    return rc;
+}
+
+/**
+ * @brief Creates a new epoch of the shared libyang context reflecting the current set
+ * of installed modules, makes it current and moves all idle schema infos into it.
+ * Schema infos that are in use keep referencing the previous epoch until they are released.
+ *
+ * @note Function expects that md_ctx is locked for writing and schema_tree_lock
+ * is held for writing by the caller.
+ *
+ * @param [in] dm_ctx
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_shared_ly_ctx_swap(dm_ctx_t *dm_ctx)
+{
+    CHECK_NULL_ARG2(dm_ctx, dm_ctx->shared_ly_ctx);
+    int rc = SR_ERR_OK;
+    dm_shared_ly_ctx_t *shared = NULL;
+    dm_schema_info_t *si = NULL;
+    size_t i = 0;
+
+    rc = dm_shared_ly_ctx_new(dm_ctx, dm_ctx->shared_ly_ctx->epoch + 1, &shared);
+    CHECK_RC_MSG_RETURN(rc, "Failed to create a new epoch of the shared libyang context");
+
+    dm_shared_ly_ctx_release(dm_ctx->shared_ly_ctx);
+    dm_ctx->shared_ly_ctx = shared;
+
+    while (NULL != (si = sr_btree_get_at(dm_ctx->schema_info_tree, i++))) {
+        RWLOCK_WRLOCK_TIMED_CHECK_RETURN(&si->model_lock);
+        rc = dm_shared_schema_info_rebind(dm_ctx, si);
+        pthread_rwlock_unlock(&si->model_lock);
+        CHECK_RC_LOG_RETURN(rc, "Failed to move module %s to the new shared context", si->module_name);
+    }
+
+    return rc;
+}
+
+/**
+ * @brief Tries to move the schema info that still references an older epoch of the shared
+ * libyang context to the current one. Called without any lock held.
+ */
+static int
+dm_shared_schema_info_refresh(dm_ctx_t *dm_ctx, dm_schema_info_t *si)
+{
+    CHECK_NULL_ARG2(dm_ctx, si);
+    int rc = SR_ERR_OK;
+
+    md_ctx_lock(dm_ctx->md_ctx, false);
+    RWLOCK_RDLOCK_TIMED_CHECK_GOTO(&dm_ctx->schema_tree_lock, rc, unlock_md);
+    RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&si->model_lock, rc, unlock_tree);
+
+    if (NULL != si->shared_ly_ctx) {
+        rc = dm_shared_schema_info_rebind(dm_ctx, si);
+    }
+
+    pthread_rwlock_unlock(&si->model_lock);
+unlock_tree:
+    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+unlock_md:
+    md_ctx_unlock(dm_ctx->md_ctx);
+    return rc;
+}
+#endif
+
+/**
+ * @brief Loads module and all its dependencies into the libyang context.
+ * @param [in] dm_ctx
+ * @param [in] module_name
+ * @param [in] revision can be NULL
+ * @param [out] module_schema
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_load_module(dm_ctx_t *dm_ctx, const char *module_name, const char *revision, dm_schema_info_t **schema_info)
+{
+    CHECK_NULL_ARG3(dm_ctx, module_name, schema_info); /* revision might be NULL*/
+    int rc = SR_ERR_OK;
+    dm_schema_info_t *si = NULL;
+    md_module_t *module = NULL;
+    sr_btree_t *loaded_deps = NULL, *completed_deps = NULL;
+    const struct lys_module *ly_mod = NULL;
+
+    /* search for the module to use */
+    md_ctx_lock(dm_ctx->md_ctx, false);
+    rc = md_get_module_info(dm_ctx->md_ctx, module_name, revision, NULL, &module);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Module '%s:%s' is not installed.", module_name, revision ? revision : "<latest>");
+        *schema_info = NULL;
+        md_ctx_unlock(dm_ctx->md_ctx);
+        return SR_ERR_UNKNOWN_MODEL;
+    }
+    if (module->submodule) {
+        SR_LOG_WRN("An attempt to load submodule %s", module_name);
+        rc = SR_ERR_INVAL_ARG;
+        goto cleanup;
+    }
+
+#ifdef SHARED_LY_CTX
+    /* the module and all its dependencies are already loaded in the shared context */
+    si = calloc(1, sizeof(*si));
+    CHECK_NULL_NOMEM_GOTO(si, rc, cleanup);
+    pthread_rwlock_init(&si->model_lock, NULL);
+    pthread_mutex_init(&si->usage_count_mutex, NULL);
+
+    rc = dm_shared_schema_info_bind(dm_ctx, module, si);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to bind module %s to the shared context", module->name);
+    ly_mod = si->module;
+
+    si->module_name = strdup(ly_mod->name);
+    CHECK_NULL_NOMEM_GOTO(si->module_name, rc, cleanup);
+#else
+    /* allocate new structure where schemas will be loaded*/
+    rc = dm_schema_info_init(dm_ctx->schema_search_dir, &si);
+    CHECK_RC_MSG_RETURN(rc, "Schema info init failed");
+
+    /* load the module schema and all its dependencies */
+    rc = dm_load_schema_file(module->filepath, si, &ly_mod);
+    CHECK_RC_LOG_RETURN(rc, "Failed to load schema %s", module->filepath);
+
+    si->module_name = strdup(ly_mod->name);
+    CHECK_NULL_NOMEM_GOTO(si->module_name, rc, cleanup);
+    si->module = ly_mod;
+    si->has_instance_id = module->inst_ids->first != NULL;
+
+    /* load the module schema and all its dependencies */
+    rc = sr_btree_init(dm_compare_modules_cb, NULL, &loaded_deps);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
+
+    rc = dm_load_module_ident_deps_r(module, si, loaded_deps);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load identityref dependencies for module %s", module->name);
+
+    rc = dm_load_module_deps_r(module, si, loaded_deps);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load dependencies for module %s", module->name);
+
+    sr_btree_cleanup(loaded_deps);
+    loaded_deps = NULL;
+#endif
+
+    /* compute xpath hashes for all schema nodes (referenced from data tree) */
+    rc = dm_init_missing_node_priv_data(si);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to initialize private data for module %s", module->name);
+
+    /* apply persist data enable features, running datastore */
+    rc = sr_btree_init(dm_compare_modules_cb, NULL, &loaded_deps);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
+    rc = sr_btree_init(dm_compare_modules_cb, NULL, &completed_deps);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to init list");
+
+    rc = dm_apply_module_dep_persist_r(dm_ctx, module, si, loaded_deps, completed_deps);
+    sr_btree_cleanup(loaded_deps);
+    loaded_deps = NULL;
+    sr_btree_cleanup(completed_deps);
+    completed_deps = NULL;
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to apply persist data");
+
+    /* distinguish between modules that can and cannot be locked */
+    si->can_not_be_locked = !module->has_data;
+
+    /* insert schema info into schema tree */
+    RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&dm_ctx->schema_tree_lock, rc, cleanup);
+
+    rc = sr_btree_insert(dm_ctx->schema_info_tree, si);
+    if (SR_ERR_OK != rc) {
+        if (SR_ERR_DATA_EXISTS != rc) {
+            SR_LOG_WRN("Insert into schema binary tree failed. %s", sr_strerror(rc));
+            goto unlock;
+        } else {
+            /* if someone loaded schema meanwhile */
+            dm_schema_info_t *lookup = si;
+            si = sr_btree_search(dm_ctx->schema_info_tree, lookup);
+            dm_free_schema_info(lookup);
+            if (NULL != si) {
+                rc = SR_ERR_OK;
+            } else {
+                SR_LOG_ERR_MSG("Failed to find a schema in schema tree");
+            }
+        }
+    }
+
+unlock:
+    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+cleanup:
+    sr_btree_cleanup(loaded_deps);
+    sr_btree_cleanup(completed_deps);
+
+    if (SR_ERR_OK == rc) {
+        *schema_info = si;
+    } else {
+        dm_free_schema_info(si);
+    }
+    md_ctx_unlock(dm_ctx->md_ctx);
+    return rc;
+}
+
+/**
+ * @brief Function removes the subtrees that doesn't belong to the selected module.
+ */
+static int
+dm_remove_added_data_trees_by_module_name(const char *module_name, struct lyd_node **root)
+{
+    CHECK_NULL_ARG(module_name);
+    int rc = SR_ERR_OK;
+    if (NULL != *root) {
+        struct ly_ctx *ctx = (*root)->schema->module->ctx;
+        const struct lys_module *module = ly_ctx_get_module(ctx, module_name, NULL, 1);
         if (NULL == module) {
             SR_LOG_ERR("Module %s not found", module_name);
             return SR_ERR_INTERNAL;
@@ -1402,7 +1956,9 @@ dm_load_data_tree_file(dm_ctx_t *dm_ctx, int fd, const char *data_filename, dm_s
                 (long long) st.st_mtim.tv_sec,
                 (long long) st.st_mtim.tv_nsec);
 #endif
-        if (schema_info->has_instance_id) {
+        if (schema_info->has_instance_id && NULL == schema_info->shared_ly_ctx) {
+            /* instance identifiers may reference any installed module, parse in tmp context
+             * (not needed with the shared context where all installed modules are present) */
             struct lyd_node *tmp_node = NULL;
             dm_tmp_ly_ctx_t *tmp_ctx = NULL;
 
@@ -1482,10 +2038,7 @@ dm_load_data_tree_file(dm_ctx_t *dm_ctx, int fd, const char *data_filename, dm_s
     data->node = data_tree;
 
     /* increment counter of data tree using the module */
-    pthread_mutex_lock(&schema_info->usage_count_mutex);
-    schema_info->usage_count++;
-    SR_LOG_DBG("Usage count %s incremented (value=%zu)", schema_info->module_name, schema_info->usage_count);
-    pthread_mutex_unlock(&schema_info->usage_count_mutex);
+    dm_data_info_use_schema(data, schema_info);
 
     if (NULL == data_tree) {
         SR_LOG_INF("Data file %s is empty", data_filename);
@@ -1499,25 +2052,127 @@ dm_load_data_tree_file(dm_ctx_t *dm_ctx, int fd, const char *data_filename, dm_s
 }
 
 /**
- * @brief Loads data tree from file. Module and datastore argument are used to
- * determine the file name.
+ * @brief Stores the data tree of a freshly loaded data info into the read-only cache of the schema info,
+ * replacing the previously cached tree. The data info keeps a reference to the cached tree. If the cache entry
+ * can not be allocated the data info is left untouched.
  *
- * @note Function expects that a schema info is locked for reading.
+ * @param [in] schema_info
+ * @param [in] ds datastore the data tree belongs to
+ * @param [in] data_info
+ */
+static void
+dm_rdonly_tree_store(dm_schema_info_t *schema_info, sr_datastore_t ds, dm_data_info_t *data_info)
+{
+    dm_rdonly_tree_t *tree = NULL, *replaced = NULL;
+
+    tree = calloc(1, sizeof(*tree));
+    if (NULL == tree) {
+        return;
+    }
+    tree->node = data_info->node;
+    tree->timestamp = data_info->timestamp;
+    tree->ref_count = 2; /* the cache and the data info */
+    pthread_mutex_init(&tree->lock, NULL);
+    data_info->rdonly_tree = tree;
+
+    pthread_mutex_lock(&schema_info->usage_count_mutex);
+    replaced = schema_info->rdonly_trees[ds];
+    schema_info->rdonly_trees[ds] = tree;
+    pthread_mutex_unlock(&schema_info->usage_count_mutex);
+    dm_rdonly_tree_release(replaced);
+}
+
+/**
+ * @brief Provides a data info with a read-only data tree loaded from the opened file. The tree
+ * cached in the schema info is borrowed if the file has not been changed since it was parsed,
+ * otherwise the file is parsed and the new tree replaces the cached one.
+ *
+ * @note Function expects that a schema info is locked for reading and the file is locked.
  *
  * @param [in] dm_ctx
- * @param [in] dm_session_ctx
+ * @param [in] fd opened data file, function does not close it
+ * @param [in] data_filename
  * @param [in] schema_info
- * @param [in] ds
+ * @param [in] ds datastore the file belongs to
  * @param [out] data_info
- * @return Error code (SR_ERR_OK on success), SR_ERR_INTERAL if the parsing of the data tree fails.
+ * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_load_data_tree(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, dm_schema_info_t *schema_info, sr_datastore_t ds, dm_data_info_t **data_info)
+dm_load_rdonly_data_tree(dm_ctx_t *dm_ctx, int fd, const char *data_filename, dm_schema_info_t *schema_info,
+        sr_datastore_t ds, dm_data_info_t **data_info)
 {
-    CHECK_NULL_ARG4(dm_ctx, schema_info, schema_info->module, schema_info->module->name);
+    CHECK_NULL_ARG4(dm_ctx, data_filename, schema_info, data_info);
+    int rc = SR_ERR_OK;
+    dm_rdonly_tree_t *tree = NULL;
+    dm_data_info_t *di = NULL;
+    bool uptodate = false;
 
-    char *data_filename = NULL;
-    int rc = 0;
+    pthread_mutex_lock(&schema_info->usage_count_mutex);
+    tree = schema_info->rdonly_trees[ds];
+    if (NULL != tree) {
+        ATOMIC_INC(&tree->ref_count);
+    }
+    pthread_mutex_unlock(&schema_info->usage_count_mutex);
+
+    if (NULL != tree) {
+        dm_data_info_t lookup = {0};
+        lookup.schema = schema_info;
+        lookup.timestamp = tree->timestamp;
+        rc = dm_is_info_copy_uptodate(dm_ctx, data_filename, &lookup, &uptodate);
+        if (SR_ERR_OK == rc && uptodate) {
+            di = calloc(1, sizeof(*di));
+            if (NULL == di) {
+                dm_rdonly_tree_release(tree);
+                SR_LOG_ERR_MSG("Unable to allocate memory.");
+                return SR_ERR_NOMEM;
+            }
+            di->schema = schema_info;
+            di->node = tree->node;
+            di->timestamp = tree->timestamp;
+            di->rdonly_tree = tree;
+            dm_data_info_use_schema(di, schema_info);
+
+            SR_LOG_DBG("Cached read-only data tree of %s reused", data_filename);
+            *data_info = di;
+            return SR_ERR_OK;
+        }
+        dm_rdonly_tree_release(tree);
+        tree = NULL;
+    }
+
+    /* the file has been changed (or not loaded yet), parse it */
+    rc = dm_load_data_tree_file(dm_ctx, fd, data_filename, schema_info, &di);
+    CHECK_RC_LOG_RETURN(rc, "Failed to load data file %s", data_filename);
+
+    dm_rdonly_tree_store(schema_info, ds, di);
+
+    *data_info = di;
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Loads data tree from file. Module and datastore argument are used to
+ * determine the file name.
+ *
+ * @note Function expects that a schema info is locked for reading.
+ *
+ * @param [in] dm_ctx
+ * @param [in] dm_session_ctx
+ * @param [in] schema_info
+ * @param [in] ds
+ * @param [in] rdonly flag denoting that the data tree will not be modified, the returned data info
+ * may borrow the tree cached in the schema info
+ * @param [out] data_info
+ * @return Error code (SR_ERR_OK on success), SR_ERR_INTERAL if the parsing of the data tree fails.
+ */
+static int
+dm_load_data_tree_internal(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, dm_schema_info_t *schema_info, sr_datastore_t ds,
+        bool rdonly, dm_data_info_t **data_info)
+{
+    CHECK_NULL_ARG4(dm_ctx, schema_info, schema_info->module, schema_info->module->name);
+
+    char *data_filename = NULL;
+    int rc = 0;
     *data_info = NULL;
     rc = sr_get_data_file_name(dm_ctx->data_search_dir, schema_info->module->name, ds, &data_filename);
     CHECK_RC_LOG_RETURN(rc, "Get data_filename failed for %s", schema_info->module->name);
@@ -1539,7 +2194,15 @@ dm_load_data_tree(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, dm_schema_info
         return SR_ERR_UNAUTHORIZED;
     }
 
-    rc = dm_load_data_tree_file(dm_ctx, fd, data_filename, schema_info, data_info);
+#ifdef HAVE_STAT_ST_MTIM
+    if (rdonly && -1 != fd) {
+        /* file modification time is needed to decide whether the cached tree is up to date */
+        rc = dm_load_rdonly_data_tree(dm_ctx, fd, data_filename, schema_info, ds, data_info);
+    } else
+#endif
+    {
+        rc = dm_load_data_tree_file(dm_ctx, fd, data_filename, schema_info, data_info);
+    }
 
     if (-1 != fd) {
         sr_unlock_fd(fd);
@@ -1550,3464 +2213,5723 @@ dm_load_data_tree(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, dm_schema_info
     return rc;
 }
 
-static void
-dm_free_sess_op(dm_sess_op_t *op)
+/**
+ * @brief Loads data tree from file. Module and datastore argument are used to
+ * determine the file name.
+ *
+ * @note Function expects that a schema info is locked for reading.
+ *
+ * @param [in] dm_ctx
+ * @param [in] dm_session_ctx
+ * @param [in] schema_info
+ * @param [in] ds
+ * @param [out] data_info
+ * @return Error code (SR_ERR_OK on success), SR_ERR_INTERAL if the parsing of the data tree fails.
+ */
+static int
+dm_load_data_tree(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, dm_schema_info_t *schema_info, sr_datastore_t ds, dm_data_info_t **data_info)
 {
-    if (NULL == op) {
-        return;
-    }
-    free(op->xpath);
-    if (DM_SET_OP == op->op) {
-        sr_free_val(op->detail.set.val);
-        free(op->detail.set.str_val);
-    } else if (DM_MOVE_OP == op->op) {
-        free(op->detail.mov.relative_item);
-        op->detail.mov.relative_item = NULL;
-    }
+    return dm_load_data_tree_internal(dm_ctx, dm_session_ctx, schema_info, ds, false, data_info);
 }
 
-static void
-dm_free_sess_operations(dm_sess_op_t *ops, size_t count)
-{
-    if (NULL == ops) {
-        return;
-    }
-
-    for (size_t i = 0; i < count; i++) {
-        dm_free_sess_op(&ops[i]);
-    }
-    free(ops);
-}
+/**
+ * @brief Data file to be parsed by ::dm_load_data_tree_files.
+ */
+typedef struct dm_load_job_s {
+    int fd;                             /**< Opened and locked data file, -1 if the file does not exist. */
+    const char *file_name;              /**< Name of the data file. */
+    dm_schema_info_t *schema_info;      /**< Schema info of the module the data belong to. */
+    dm_data_info_t *data_info;          /**< Loaded data, NULL if the loading failed. */
+    int rc;                             /**< Result of the loading. */
+} dm_load_job_t;
 
 /**
- * @brief Locks a file based on provided file name.
- * @param [in] lock_ctx
- * @param [in] filename
- * @return Error code (SR_ERR_OK on success), SR_ERR_LOCKED if the file is already locked,
- * SR_ERR_UNATHORIZED if the file can not be locked because of the permission.
+ * @brief Context shared by the threads executing ::dm_load_job_t jobs.
  */
-static int
-dm_lock_file(sr_locking_set_t *lock_ctx, char *filename)
-{
-    CHECK_NULL_ARG2(lock_ctx, filename);
-    return sr_locking_set_lock_file_open(lock_ctx, filename, true, false, NULL);
-}
+typedef struct dm_load_pool_s {
+    dm_ctx_t *dm_ctx;                   /**< Data manager context. */
+    dm_load_job_t *jobs;                /**< Jobs to be executed. */
+    size_t job_cnt;                     /**< Number of jobs. */
+    size_t next_job;                    /**< Index of the first job not taken by any thread yet. */
+    pthread_mutex_t lock;               /**< Mutex protecting next_job. */
+} dm_load_pool_t;
 
 /**
- * @brief Unlocks the file based on the filename
- * @param [in] lock_ctx
- * @param [in] filename
- * @return Error code (SR_ERR_OK on success) SR_ERR_INVAL_ARG if the
- * file had not been locked in provided context
+ * @brief Returns TRUE if the data file of the module can be parsed concurrently with the other modules.
+ * Modules with instance identifiers or with data depending on other modules may load further modules
+ * into the (temporary or shared) libyang context while parsing, they are loaded by the calling thread only.
  */
-static int
-dm_unlock_file(sr_locking_set_t *lock_ctx, char *filename)
+static bool
+dm_load_job_is_parallel(const dm_load_job_t *job)
 {
-    CHECK_NULL_ARG2(lock_ctx, filename);
-    return sr_locking_set_unlock_close_file(lock_ctx, filename);
+    return -1 == job->fd || (!job->schema_info->has_instance_id && !job->schema_info->cross_module_data_dependency);
 }
 
 /**
- * @brief Logging callback called from libyang for each log entry.
+ * @brief Takes the jobs from the pool and executes them until there is none left.
  */
-static void
-dm_ly_log_cb(LY_LOG_LEVEL level, const char *msg, const char *path)
+static void *
+dm_load_worker(void *arg)
 {
-    if (LY_LLERR == level) {
-        SR_LOG_ERR("libyang error: %s", msg);
+    dm_load_pool_t *pool = (dm_load_pool_t *) arg;
+    dm_load_job_t *job = NULL;
+
+    while (true) {
+        job = NULL;
+        pthread_mutex_lock(&pool->lock);
+        while (pool->next_job < pool->job_cnt && NULL == job) {
+            if (NULL == pool->jobs[pool->next_job].data_info && dm_load_job_is_parallel(&pool->jobs[pool->next_job])) {
+                job = &pool->jobs[pool->next_job];
+            }
+            ++pool->next_job;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (NULL == job) {
+            break;
+        }
+        job->rc = dm_load_data_tree_file(pool->dm_ctx, job->fd, job->file_name, job->schema_info, &job->data_info);
     }
+
+    return NULL;
 }
 
-int
-dm_lock_module(dm_ctx_t *dm_ctx, dm_session_t *session, const char *modul_name)
+/**
+ * @brief Parses and validates the data files of independent modules in parallel. The data files are expected
+ * to be opened and locked and the schema infos locked for reading. Cross-module dependencies are not resolved
+ * here (the data trees are validated only if they do not depend on other modules, just as in ::dm_load_data_tree_file),
+ * so the order of the jobs does not matter. Jobs that already carry a data info are skipped.
+ *
+ * @param [in] dm_ctx
+ * @param [in,out] jobs Files to be loaded, the result of each job is stored in it.
+ * @param [in] job_cnt
+ * @return Error code (SR_ERR_OK on success), the first failure of a job is returned.
+ */
+static int
+dm_load_data_tree_files(dm_ctx_t *dm_ctx, dm_load_job_t *jobs, size_t job_cnt)
 {
-    CHECK_NULL_ARG3(dm_ctx, session, modul_name);
+    CHECK_NULL_ARG2(dm_ctx, jobs);
+    dm_load_pool_t pool = {0};
+    pthread_t *threads = NULL;
+    size_t thread_cnt = 0, parallel_cnt = 0;
     int rc = SR_ERR_OK;
-    char *lock_file = NULL;
-    dm_schema_info_t *si = NULL;
 
-    /* check if module name is valid */
-    rc = dm_get_module_and_lock(dm_ctx, modul_name, &si);
-    CHECK_RC_LOG_RETURN(rc, "Unknown module %s to lock", modul_name);
+    pool.dm_ctx = dm_ctx;
+    pool.jobs = jobs;
+    pool.job_cnt = job_cnt;
+    pthread_mutex_init(&pool.lock, NULL);
 
-    if (si->can_not_be_locked) {
-        SR_LOG_DBG("Module %s contains no data, locking for the module is no operation.", modul_name);
-        goto cleanup;
+    for (size_t i = 0; i < job_cnt; ++i) {
+        jobs[i].rc = SR_ERR_OK;
+        if (NULL == jobs[i].data_info && dm_load_job_is_parallel(&jobs[i])) {
+            ++parallel_cnt;
+        }
     }
 
-    rc = sr_get_lock_data_file_name(dm_ctx->data_search_dir, modul_name, session->datastore, &lock_file);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Lock file name can not be created");
+    /* the calling thread takes part in the loading as well */
+    if (1 < dm_ctx->data_load_threads && 1 < parallel_cnt) {
+        threads = calloc(dm_ctx->data_load_threads - 1, sizeof(*threads));
+        if (NULL == threads) {
+            SR_LOG_WRN_MSG("Failed to allocate data loading threads, loading sequentially.");
+        }
+    }
+    while (NULL != threads && thread_cnt + 1 < dm_ctx->data_load_threads && thread_cnt + 1 < parallel_cnt) {
+        if (0 != pthread_create(&threads[thread_cnt], NULL, dm_load_worker, &pool)) {
+            SR_LOG_WRN("Failed to start a data loading thread, continuing with %zu thread(s).", thread_cnt + 1);
+            break;
+        }
+        ++thread_cnt;
+    }
+    dm_load_worker(&pool);
+    for (size_t i = 0; i < thread_cnt; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&pool.lock);
 
-    /* check if already locked by this session */
-    for (size_t i = 0; i < session->locked_files->count; i++) {
-        if (0 == strcmp(lock_file, (char *) session->locked_files->data[i])) {
-            SR_LOG_INF("File %s is already locked by this session", lock_file);
-            free(lock_file);
-            goto cleanup;
+    /* the rest is loaded sequentially */
+    for (size_t i = 0; i < job_cnt; ++i) {
+        if (NULL == jobs[i].data_info && !dm_load_job_is_parallel(&jobs[i])) {
+            jobs[i].rc = dm_load_data_tree_file(dm_ctx, jobs[i].fd, jobs[i].file_name, jobs[i].schema_info,
+                    &jobs[i].data_info);
+        }
+        if (SR_ERR_OK != jobs[i].rc && SR_ERR_OK == rc) {
+            SR_LOG_ERR("Loading of data file %s failed", jobs[i].file_name);
+            rc = jobs[i].rc;
         }
     }
 
-    if (session->datastore != SR_DS_CANDIDATE) {
-        /* switch identity */
-        ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+    SR_LOG_DBG("%zu data file(s) loaded using %zu thread(s).", job_cnt, thread_cnt + 1);
+    return rc;
+}
 
-        rc = dm_lock_file(dm_ctx->locking_ctx, lock_file);
+/**
+ * @brief Header of the warm image file. The image holds validated running data trees of the modules
+ * loaded at the daemon startup so that the next startup does not need to parse and validate them again
+ * as long as none of the schema, data and persist files has changed. The header is followed by the entries,
+ * each of them aligned to 8 bytes.
+ */
+typedef struct dm_warm_image_hdr_s {
+    uint32_t magic;         /**< ::DM_WARM_IMAGE_MAGIC */
+    uint32_t version;       /**< ::DM_WARM_IMAGE_VERSION */
+    uint64_t schema_key;    /**< key of all the installed schema files */
+    uint64_t entry_cnt;     /**< number of entries following the header */
+} dm_warm_image_hdr_t;
 
-        /* switch identity back */
-        ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+/**
+ * @brief Entry of the warm image, followed by the module name (including the terminating zero)
+ * and by the data tree in LYB format.
+ */
+typedef struct dm_warm_image_entry_s {
+    uint64_t data_key;      /**< key of the running data file and the persist file of the module */
+    uint64_t name_size;     /**< size of the module name including the terminating zero */
+    uint64_t tree_size;     /**< size of the data tree, 0 if the data tree is empty */
+} dm_warm_image_entry_t;
+
+/**
+ * @brief Warm image mapped into the memory.
+ */
+typedef struct dm_warm_image_s {
+    void *addr;             /**< address of the mapping, NULL if there is no usable image */
+    size_t size;            /**< size of the mapping */
+} dm_warm_image_t;
+
+#define DM_WARM_IMAGE_ALIGN(SIZE) (((SIZE) + 7) & ~((size_t) 7))
+
+/**
+ * @brief Updates FNV-1a hash with the provided bytes.
+ */
+static uint64_t
+dm_warm_image_hash(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
     }
+    return hash;
+}
 
-    /* log information about locked model */
-    if (SR_ERR_OK != rc) {
-        free(lock_file);
-    } else {
-        rc = sr_list_add(session->locked_files, lock_file);
-        CHECK_RC_MSG_RETURN(rc, "List add failed");
+/**
+ * @brief Updates the hash with the identity of the file (inode, size and modification time).
+ * A missing file changes the hash as well.
+ */
+static uint64_t
+dm_warm_image_file_key(uint64_t hash, const char *file_path)
+{
+    struct stat st = {0};
+    int64_t values[5] = {-1, -1, -1, -1, -1};
 
-        pthread_mutex_lock(&si->usage_count_mutex);
-        si->usage_count++;
-        SR_LOG_DBG("Usage count %s incremented (value=%zu)", si->module_name, si->usage_count);
-        pthread_mutex_unlock(&si->usage_count_mutex);
+    if (NULL != file_path && 0 == stat(file_path, &st)) {
+        values[0] = (int64_t) st.st_ino;
+        values[1] = (int64_t) st.st_size;
+#ifdef HAVE_STAT_ST_MTIM
+        values[2] = (int64_t) st.st_mtim.tv_sec;
+        values[3] = (int64_t) st.st_mtim.tv_nsec;
+#else
+        values[2] = (int64_t) st.st_mtime;
+#endif
+        values[4] = (int64_t) st.st_dev;
     }
-cleanup:
-    pthread_rwlock_unlock(&si->model_lock);
-    return rc;
+    return dm_warm_image_hash(hash, values, sizeof values);
 }
 
-int
-dm_unlock_module(dm_ctx_t *dm_ctx, dm_session_t *session, char *modul_name)
+/**
+ * @brief Computes the key of the data of a module from its running data file and its persist file
+ * (the persist file holds the enabled subtrees and features the data tree depends on).
+ */
+static int
+dm_warm_image_data_key(dm_ctx_t *dm_ctx, const char *module_name, const char *data_file_name, uint64_t *data_key)
 {
-    CHECK_NULL_ARG3(dm_ctx, session, modul_name);
+    char *persist_file_name = NULL;
     int rc = SR_ERR_OK;
-    dm_schema_info_t *si = NULL;
-    char *lock_file = NULL;
-    size_t i = 0;
 
-    SR_LOG_INF("Unlock request module='%s'", modul_name);
+    rc = sr_get_persist_data_file_name(dm_ctx->data_search_dir, module_name, &persist_file_name);
+    CHECK_RC_LOG_RETURN(rc, "Unable to compose persist data file name for '%s'.", module_name);
 
-    rc = dm_get_module_and_lock(dm_ctx, modul_name, &si);
-    CHECK_RC_LOG_RETURN(rc, "Unknown module %s to unlock", modul_name);
+    *data_key = dm_warm_image_hash(0xcbf29ce484222325ULL, module_name, strlen(module_name));
+    *data_key = dm_warm_image_file_key(*data_key, data_file_name);
+    *data_key = dm_warm_image_file_key(*data_key, persist_file_name);
 
-    rc = sr_get_lock_data_file_name(dm_ctx->data_search_dir, modul_name, session->datastore, &lock_file);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Lock file name can not be created");
+    free(persist_file_name);
+    return rc;
+}
 
-    /* check if already locked */
-    bool found = false;
-    for (i = 0; i < session->locked_files->count; i++) {
-        if (0 == strcmp(lock_file, (char *) session->locked_files->data[i])) {
-            found = true;
-            break;
-        }
+/**
+ * @brief Maps the warm image file into the memory. If the image does not exist or it was created
+ * for different schemas, no image is provided.
+ *
+ * @param [in] dm_ctx
+ * @param [in] schema_key key of all currently installed schema files
+ * @param [out] image
+ */
+static void
+dm_warm_image_open(dm_ctx_t *dm_ctx, uint64_t schema_key, dm_warm_image_t *image)
+{
+    const dm_warm_image_hdr_t *hdr = NULL;
+    char *file_name = NULL;
+    struct stat st = {0};
+    void *addr = NULL;
+    int fd = -1;
+
+    image->addr = NULL;
+    image->size = 0;
+
+    if (SR_ERR_OK != sr_path_join(dm_ctx->internal_data_search_dir, DM_WARM_IMAGE_FILENAME, &file_name)) {
+        return;
+    }
+    fd = open(file_name, O_RDONLY);
+    if (-1 == fd) {
+        SR_LOG_DBG("Warm image %s can not be opened, the data files will be parsed.", file_name);
+        goto cleanup;
+    }
+    if (-1 == fstat(fd, &st) || (size_t) st.st_size < sizeof *hdr) {
+        SR_LOG_WRN("Warm image %s is truncated, ignoring it.", file_name);
+        goto cleanup;
+    }
+    addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == addr) {
+        SR_LOG_WRN("Unable to map warm image %s: %s", file_name, sr_strerror_safe(errno));
+        goto cleanup;
     }
 
-    if (!found) {
-        SR_LOG_ERR("File %s has not been locked in this context", lock_file);
-        rc = SR_ERR_INVAL_ARG;
-    } else {
-        if (session->datastore != SR_DS_CANDIDATE) {
-            rc = dm_unlock_file(dm_ctx->locking_ctx, lock_file);
-        }
-        free(session->locked_files->data[i]);
-        sr_list_rm_at(session->locked_files, i);
-        pthread_mutex_lock(&si->usage_count_mutex);
-        si->usage_count--;
-        SR_LOG_DBG("Usage count %s decremented (value=%zu)", si->module_name, si->usage_count);
-        pthread_mutex_unlock(&si->usage_count_mutex);
+    hdr = (const dm_warm_image_hdr_t *) addr;
+    if (DM_WARM_IMAGE_MAGIC != hdr->magic || DM_WARM_IMAGE_VERSION != hdr->version || schema_key != hdr->schema_key) {
+        SR_LOG_DBG("Warm image %s is outdated, the data files will be parsed.", file_name);
+        munmap(addr, st.st_size);
+        goto cleanup;
     }
+    image->addr = addr;
+    image->size = st.st_size;
+
 cleanup:
-    free(lock_file);
-    pthread_rwlock_unlock(&si->model_lock);
-    return rc;
+    if (-1 != fd) {
+        close(fd);
+    }
+    free(file_name);
 }
 
-int
-dm_lock_datastore(dm_ctx_t *dm_ctx, dm_session_t *session)
+/**
+ * @brief Unmaps the warm image.
+ */
+static void
+dm_warm_image_close(dm_warm_image_t *image)
 {
-    CHECK_NULL_ARG2(dm_ctx, session);
-    int rc = SR_ERR_OK;
-    sr_schema_t *schemas = NULL;
-    size_t schema_count = 0;
+    if (NULL != image->addr) {
+        munmap(image->addr, image->size);
+        image->addr = NULL;
+        image->size = 0;
+    }
+}
 
-    sr_list_t *locked = NULL;
-    rc = sr_list_init(&locked);
-    CHECK_RC_MSG_RETURN(rc, "List init failed");
+/**
+ * @brief Creates the data info of the job from the warm image if the image holds the data tree of the module
+ * with matching key. The data tree is trusted, it has been validated before the image was written.
+ *
+ * @param [in] image
+ * @param [in] job job with opened and locked data file, data info is set on success
+ * @param [in] data_key key of the data of the module
+ * @return Error code (SR_ERR_OK on success), SR_ERR_NOT_FOUND if the image does not contain up-to-date data
+ */
+static int
+dm_warm_image_load(const dm_warm_image_t *image, dm_load_job_t *job, uint64_t data_key)
+{
+    const dm_warm_image_hdr_t *hdr = (const dm_warm_image_hdr_t *) image->addr;
+    const dm_warm_image_entry_t *entry = NULL;
+    const char *name = NULL, *tree = NULL;
+    struct lyd_node *data_tree = NULL;
+    dm_data_info_t *data = NULL;
+    struct stat st = {0};
+    size_t offset = sizeof *hdr;
 
-    rc = dm_list_schemas(dm_ctx, session, &schemas, &schema_count);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "List schemas failed");
+    if (NULL == image->addr) {
+        return SR_ERR_NOT_FOUND;
+    }
 
-    if (session->datastore != SR_DS_CANDIDATE) {
-        pthread_mutex_lock(&dm_ctx->ds_lock_mutex);
-        if (dm_ctx->ds_lock[session->datastore]) {
-            SR_LOG_ERR_MSG("Datastore lock is held by another session");
-            rc = SR_ERR_LOCKED;
-            pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
-            goto cleanup;
+    for (uint64_t i = 0; i < hdr->entry_cnt; ++i) {
+        if (image->size - offset < sizeof *entry) {
+            SR_LOG_WRN_MSG("Warm image is corrupted.");
+            return SR_ERR_NOT_FOUND;
+        }
+        entry = (const dm_warm_image_entry_t *) ((const char *) image->addr + offset);
+        offset += sizeof *entry;
+        if (entry->name_size > image->size - offset || entry->tree_size > image->size - offset - entry->name_size) {
+            SR_LOG_WRN_MSG("Warm image is corrupted.");
+            return SR_ERR_NOT_FOUND;
+        }
+        name = (const char *) image->addr + offset;
+        tree = name + entry->name_size;
+        offset += DM_WARM_IMAGE_ALIGN(entry->name_size + entry->tree_size);
+        if (offset > image->size) {
+            offset = image->size;
         }
-        dm_ctx->ds_lock[session->datastore] = true;
-        pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
-    }
-    session->holds_ds_lock[session->datastore] = true;
 
-    for (size_t i = 0; i < schema_count; i++) {
-        if (!schemas[i].implemented) {
-            /* nothing to lock */
+        if (0 == entry->name_size || '\0' != name[entry->name_size - 1]
+                || 0 != strcmp(name, job->schema_info->module_name)) {
             continue;
         }
+        if (data_key != entry->data_key) {
+            return SR_ERR_NOT_FOUND;
+        }
+        if (-1 == fstat(job->fd, &st)) {
+            return SR_ERR_NOT_FOUND;
+        }
+        if (0 < entry->tree_size) {
+            ly_errno = LY_SUCCESS;
+            data_tree = lyd_parse_mem(job->schema_info->ly_ctx, tree, LYD_LYB,
+                    LYD_OPT_TRUSTED | LYD_OPT_STRICT | LYD_OPT_CONFIG);
+            if (NULL == data_tree) {
+                SR_LOG_WRN("Data of module %s can not be loaded from the warm image.", name);
+                return SR_ERR_NOT_FOUND;
+            }
+        }
 
-        rc = dm_lock_module(dm_ctx, session, (char *) schemas[i].module_name);
-        if (SR_ERR_OK != rc) {
-            if (SR_ERR_UNAUTHORIZED == rc) {
-                SR_LOG_INF("Not allowed to lock %s, skipping", schemas[i].module_name);
+        data = calloc(1, sizeof *data);
+        if (NULL == data) {
+            lyd_free_withsiblings(data_tree);
+            return SR_ERR_NOMEM;
+        }
+        data->schema = job->schema_info;
+        data->node = data_tree;
+#ifdef HAVE_STAT_ST_MTIM
+        data->timestamp = st.st_mtim;
+#endif
+
+        dm_data_info_use_schema(data, job->schema_info);
+
+        job->data_info = data;
+        return SR_ERR_OK;
+    }
+
+    return SR_ERR_NOT_FOUND;
+}
+
+/**
+ * @brief Writes all the bytes into the file.
+ */
+static int
+dm_write_buf(int fd, const void *buf, size_t size)
+{
+    const char *ptr = (const char *) buf;
+    ssize_t ret = 0;
+
+    while (0 < size) {
+        ret = write(fd, ptr, size);
+        if (-1 == ret) {
+            if (EINTR == errno) {
                 continue;
-            } else if (SR_ERR_LOCKED == rc) {
-                SR_LOG_ERR("Model %s is already locked by another session", schemas[i].module_name);
             }
-            for (size_t l = 0; l < locked->count; l++) {
-                dm_unlock_module(dm_ctx, session, (char *) locked->data[l]);
+            SR_LOG_ERR("Writing of the file failed: %s", sr_strerror_safe(errno));
+            return SR_ERR_IO;
+        }
+        ptr += ret;
+        size -= ret;
+    }
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Reads exactly the requested number of bytes from the file.
+ * @return Error code (SR_ERR_OK on success), SR_ERR_IO if the file is shorter or can not be read
+ */
+static int
+dm_read_buf(int fd, void *buf, size_t size)
+{
+    char *ptr = (char *) buf;
+    ssize_t ret = 0;
+
+    while (0 < size) {
+        ret = read(fd, ptr, size);
+        if (-1 == ret) {
+            if (EINTR == errno) {
+                continue;
             }
-            pthread_mutex_lock(&dm_ctx->ds_lock_mutex);
-            dm_ctx->ds_lock[session->datastore] = false;
-            pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
-            session->holds_ds_lock[session->datastore] = false;
-            goto cleanup;
+            SR_LOG_ERR("Reading of the file failed: %s", sr_strerror_safe(errno));
+            return SR_ERR_IO;
         }
-        SR_LOG_DBG("Module %s locked", schemas[i].module_name);
-        rc = sr_list_add(locked, (char *) schemas[i].module_name);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
+        if (0 == ret) {
+            return SR_ERR_IO;
+        }
+        ptr += ret;
+        size -= ret;
     }
-cleanup:
-    sr_free_schemas(schemas, schema_count);
-    sr_list_cleanup(locked);
-    return rc;
+    return SR_ERR_OK;
 }
 
 /**
- *
- * @brief Extracts the name of the module and lookups the schema info from lock files.
- *
- * Expectes that lock file name are in form [DATA_DIR][MODULE_NAME][DATASTORE].lock
- *
- * @note Schema info read lock is acquired on successful return from function. Must be released by caller.
+ * @brief Writes a new warm image with the data trees of the successfully loaded jobs. The image is written
+ * into a temporary file which then atomically replaces the previous image.
  *
  * @param [in] dm_ctx
- * @param [in] lock_file
- * @param [out] schema_info
+ * @param [in] schema_key key of all currently installed schema files
+ * @param [in] jobs
+ * @param [in] data_keys keys of the data of the jobs
+ * @param [in] job_cnt
  * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_get_schema_info_by_lock_file(dm_ctx_t *dm_ctx, const char *lock_file, dm_schema_info_t **schema_info)
+dm_warm_image_write(dm_ctx_t *dm_ctx, uint64_t schema_key, const dm_load_job_t *jobs, const uint64_t *data_keys, size_t job_cnt)
 {
-    CHECK_NULL_ARG3(dm_ctx, lock_file, schema_info);
+    static const char padding[8] = {0};
+    dm_warm_image_hdr_t hdr = {0};
+    dm_warm_image_entry_t entry = {0};
+    char *file_name = NULL, *tmp_file_name = NULL, *tree = NULL;
+    int tree_size = 0;
+    int fd = -1;
     int rc = SR_ERR_OK;
-    char *begin = NULL;
-    char *end = NULL;
-    char *module_name = NULL;
 
-    if (NULL == strstr(lock_file, dm_ctx->data_search_dir)){
-        return SR_ERR_INTERNAL;
-    }
-    begin = (char *)lock_file + strlen(dm_ctx->data_search_dir);
-    if ((end = strstr(begin, SR_STARTUP_FILE_EXT SR_LOCK_FILE_EXT))
-            || (end = strstr(begin, SR_RUNNING_FILE_EXT SR_LOCK_FILE_EXT))
-            || (end = strstr(begin, ".candidate" SR_LOCK_FILE_EXT))) {
-        /* dup the module name */
-        module_name = strndup(begin, end-begin);
-        CHECK_NULL_NOMEM_RETURN(module_name);
+    rc = sr_path_join(dm_ctx->internal_data_search_dir, DM_WARM_IMAGE_FILENAME, &file_name);
+    CHECK_RC_MSG_RETURN(rc, "Unable to compose the warm image file name.");
+    rc = sr_asprintf(&tmp_file_name, "%s.tmp", file_name);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to compose the warm image file name.");
 
-        rc = dm_get_module_and_lock(dm_ctx, module_name, schema_info);
-        free(module_name);
-    } else {
-        SR_LOG_ERR("Unable to extract module name %s", lock_file);
-        rc = SR_ERR_INTERNAL;
+    fd = open(tmp_file_name, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (-1 == fd) {
+        SR_LOG_WRN("Unable to create warm image %s: %s", tmp_file_name, sr_strerror_safe(errno));
+        rc = SR_ERR_IO;
+        goto cleanup;
     }
 
-    return rc;
-}
+    hdr.magic = DM_WARM_IMAGE_MAGIC;
+    hdr.version = DM_WARM_IMAGE_VERSION;
+    hdr.schema_key = schema_key;
+    for (size_t i = 0; i < job_cnt; ++i) {
+        if (NULL != jobs[i].data_info) {
+            ++hdr.entry_cnt;
+        }
+    }
+    rc = dm_write_buf(fd, &hdr, sizeof hdr);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to write the warm image header.");
 
-int
-dm_unlock_datastore(dm_ctx_t *dm_ctx, dm_session_t *session)
-{
-    CHECK_NULL_ARG2(dm_ctx, session);
-    SR_LOG_INF_MSG("Unlock datastore request");
-    int rc = SR_ERR_OK;
-    char *file_path = NULL;
-    dm_schema_info_t *si = NULL;
+    for (size_t i = 0; i < job_cnt; ++i) {
+        if (NULL == jobs[i].data_info) {
+            continue;
+        }
+        if (NULL != jobs[i].data_info->node
+                && 0 != lyd_print_mem(&tree, jobs[i].data_info->node, LYD_LYB, LYP_WITHSIBLINGS)) {
+            SR_LOG_ERR("Unable to print data of module %s into the warm image.", jobs[i].schema_info->module_name);
+            rc = SR_ERR_INTERNAL;
+            goto cleanup;
+        }
+        tree_size = NULL != tree ? lyd_lyb_data_length(tree) : 0;
+        if (0 > tree_size) {
+            SR_LOG_ERR("Unable to print data of module %s into the warm image.", jobs[i].schema_info->module_name);
+            free(tree);
+            rc = SR_ERR_INTERNAL;
+            goto cleanup;
+        }
+        entry.data_key = data_keys[i];
+        entry.name_size = strlen(jobs[i].schema_info->module_name) + 1;
+        entry.tree_size = tree_size;
 
-    while (session->locked_files->count > 0) {
-        si = NULL;
-        file_path = (char *)session->locked_files->data[0];
-        rc = dm_get_schema_info_by_lock_file(dm_ctx, file_path, &si);
+        rc = dm_write_buf(fd, &entry, sizeof entry);
         if (SR_ERR_OK == rc) {
-            SR_LOG_DBG("Module_name %s", si->module_name);
-            pthread_mutex_lock(&si->usage_count_mutex);
-            si->usage_count--;
-            SR_LOG_DBG("Usage count %s decremented (value=%zu)", si->module_name, si->usage_count);
-            pthread_mutex_unlock(&si->usage_count_mutex);
-            pthread_rwlock_unlock(&si->model_lock);
-        } else {
-            SR_LOG_WRN("Get schema info by lock file failed %s", file_path);
+            rc = dm_write_buf(fd, jobs[i].schema_info->module_name, entry.name_size);
         }
-
-        if (strlen(file_path) < 15 || 0 != strcmp(file_path + strlen(file_path) - 15, ".candidate.lock")) {
-            dm_unlock_file(dm_ctx->locking_ctx, file_path);
+        if (SR_ERR_OK == rc && 0 < entry.tree_size) {
+            rc = dm_write_buf(fd, tree, entry.tree_size);
         }
-
-        free(session->locked_files->data[0]);
-        sr_list_rm_at(session->locked_files, 0);
-    }
-    for (int i = 0; i < DM_DATASTORE_COUNT; i++) {
-        if (session->holds_ds_lock[i]) {
-            pthread_mutex_lock(&dm_ctx->ds_lock_mutex);
-            dm_ctx->ds_lock[i] = false;
-            session->holds_ds_lock[i] = false;
-            pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
+        if (SR_ERR_OK == rc) {
+            rc = dm_write_buf(fd, padding,
+                    DM_WARM_IMAGE_ALIGN(entry.name_size + entry.tree_size) - (entry.name_size + entry.tree_size));
         }
+        free(tree);
+        tree = NULL;
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to write the warm image entry.");
     }
-    return SR_ERR_OK;
-}
-
-/**
- * @brief Returns the state of node. If the NULL is provided as an argument
- * DM_NODE_DISABLED is returned.
- */
-static dm_node_state_t
-dm_get_node_state(struct lys_node *node)
-{
-    if (NULL == node || NULL == node->priv) {
-        return DM_NODE_DISABLED;
-    }
-    dm_node_info_t *n_info = (dm_node_info_t *) node->priv;
 
-    if (NULL == n_info) {
-        return DM_NODE_DISABLED;
+    if (0 != fsync(fd)) {
+        SR_LOG_WRN("Unable to flush warm image %s: %s", tmp_file_name, sr_strerror_safe(errno));
+        rc = SR_ERR_IO;
+        goto cleanup;
     }
-    return n_info->state;
-}
-
-uint32_t
-dm_get_node_xpath_hash(struct lys_node *node)
-{
-    if (NULL == node || NULL == node->priv) {
-        return 0;
+    if (0 != rename(tmp_file_name, file_name)) {
+        SR_LOG_WRN("Unable to replace warm image %s: %s", file_name, sr_strerror_safe(errno));
+        rc = SR_ERR_IO;
+        goto cleanup;
     }
-    dm_node_info_t *n_info = (dm_node_info_t *) node->priv;
-    return n_info->xpath_hash;
-}
+    SR_LOG_DBG("Warm image %s with data of %" PRIu64 " module(s) written.", file_name, hdr.entry_cnt);
 
-uint16_t
-dm_get_node_data_depth(struct lys_node *node)
-{
-    if (NULL == node || NULL == node->priv) {
-        return 0;
+cleanup:
+    if (-1 != fd) {
+        close(fd);
+        if (SR_ERR_OK != rc) {
+            unlink(tmp_file_name);
+        }
     }
-    dm_node_info_t *n_info = (dm_node_info_t *) node->priv;
-    return n_info->data_depth;
+    free(tmp_file_name);
+    free(file_name);
+    return rc;
 }
 
-static int
-dm_alloc_operation(dm_session_t *session, dm_operation_t op, const char *xpath)
-{
+int
+dm_load_running_enabled_data(dm_ctx_t *dm_ctx)
+{
+    CHECK_NULL_ARG2(dm_ctx, dm_ctx->md_ctx);
+    sr_list_t *module_names = NULL;
+    dm_load_job_t *jobs = NULL;
+    uint64_t *data_keys = NULL, schema_key = 0xcbf29ce484222325ULL;
+    dm_warm_image_t image = {0};
+    size_t job_cnt = 0, loaded_cnt = 0, image_cnt = 0;
+    md_module_t *module = NULL;
+    sr_llist_node_t *ll_node = NULL;
+    dm_schema_info_t *schema_info = NULL;
+    char *module_name = NULL, *file_name = NULL;
+    bool running_enabled = false;
+    int fd = -1;
     int rc = SR_ERR_OK;
-    CHECK_NULL_ARG2(session, xpath);
+    struct timespec ts_start = {0}, ts_end = {0};
 
-    if (NULL == session->operations[session->datastore]) {
-        session->oper_size[session->datastore] = 1;
-        session->operations[session->datastore] = calloc(session->oper_size[session->datastore], sizeof(*session->operations[session->datastore]));
-        CHECK_NULL_NOMEM_RETURN(session->operations[session->datastore]);
-    } else if (session->oper_count[session->datastore] == session->oper_size[session->datastore]) {
-        session->oper_size[session->datastore] *= 2;
-        dm_sess_op_t *tmp_op = realloc(session->operations[session->datastore], session->oper_size[session->datastore] * sizeof(*session->operations[session->datastore]));
-        CHECK_NULL_NOMEM_RETURN(tmp_op);
-        session->operations[session->datastore] = tmp_op;
+    if (NULL == dm_ctx->pm_ctx) {
+        return SR_ERR_OK;
     }
-    int index = session->oper_count[session->datastore];
-    session->operations[session->datastore][index].op = op;
-    session->operations[session->datastore][index].has_error = false;
-    session->operations[session->datastore][index].xpath = strdup(xpath);
-    CHECK_NULL_NOMEM_RETURN(session->operations[session->datastore][index].xpath);
 
-    return rc;
-}
+    sr_clock_get_time(CLOCK_MONOTONIC, &ts_start);
 
-int
-dm_add_set_operation(dm_session_t *session, const char *xpath, sr_val_t *val, char *str_val, sr_edit_options_t opts)
-{
-    int rc = SR_ERR_OK;
-    CHECK_NULL_ARG_NORET2(rc, session, xpath); /* value, str_val can be NULL*/
-    if (SR_ERR_OK != rc) {
+    rc = sr_list_init(&module_names);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
+
+    /* collect all implemented modules carrying some data, compute the key of all installed schemas */
+    md_ctx_lock(dm_ctx->md_ctx, false);
+    for (ll_node = dm_ctx->md_ctx->modules->first; NULL != ll_node; ll_node = ll_node->next) {
+        module = (md_module_t *) ll_node->data;
+        schema_key = dm_warm_image_hash(schema_key, module->name, strlen(module->name) + 1);
+        if (NULL != module->revision_date) {
+            schema_key = dm_warm_image_hash(schema_key, module->revision_date, strlen(module->revision_date));
+        }
+        schema_key = dm_warm_image_hash(schema_key, &module->implemented, sizeof module->implemented);
+        schema_key = dm_warm_image_file_key(schema_key, module->filepath);
+        if (module->submodule || !module->implemented || !module->has_data) {
+            continue;
+        }
+        module_name = strdup(module->name);
+        if (NULL == module_name || SR_ERR_OK != sr_list_add(module_names, module_name)) {
+            free(module_name);
+            md_ctx_unlock(dm_ctx->md_ctx);
+            SR_LOG_ERR_MSG("Unable to collect the installed modules.");
+            rc = SR_ERR_NOMEM;
+            goto cleanup;
+        }
+    }
+    md_ctx_unlock(dm_ctx->md_ctx);
+
+    if (0 == module_names->count) {
         goto cleanup;
     }
+    jobs = calloc(module_names->count, sizeof(*jobs));
+    CHECK_NULL_NOMEM_GOTO(jobs, rc, cleanup);
+    data_keys = calloc(module_names->count, sizeof(*data_keys));
+    CHECK_NULL_NOMEM_GOTO(data_keys, rc, cleanup);
 
-    rc = dm_alloc_operation(session, DM_SET_OP, xpath);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to allocate operation");
+    dm_warm_image_open(dm_ctx, schema_key, &image);
 
-    int index = session->oper_count[session->datastore];
+    for (size_t i = 0; i < module_names->count; ++i) {
+        module_name = (char *) module_names->data[i];
 
-    session->operations[session->datastore][index].detail.set.val = val;
-    session->operations[session->datastore][index].detail.set.options = opts;
-    session->operations[session->datastore][index].detail.set.str_val = str_val;
+        rc = pm_has_running_enabled(dm_ctx->pm_ctx, module_name, &running_enabled);
+        if (SR_ERR_OK != rc || !running_enabled) {
+            rc = SR_ERR_OK;
+            continue;
+        }
 
-    session->oper_count[session->datastore]++;
-    return rc;
-cleanup:
-    sr_free_val(val);
-    free(str_val);
-    return rc;
-}
+        /* loading of the schema applies the persistent data, running datastore gets enabled */
+        rc = dm_get_module_and_lock(dm_ctx, module_name, &schema_info);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_WRN("Unable to load module %s, its data will be loaded on demand.", module_name);
+            rc = SR_ERR_OK;
+            continue;
+        }
+        if (schema_info->cross_module_data_dependency || schema_info->has_instance_id) {
+            /* the data need to be validated together with the other modules, leave them for the first request */
+            pthread_rwlock_unlock(&schema_info->model_lock);
+            continue;
+        }
 
-int
-dm_add_del_operation(dm_session_t *session, const char *xpath, sr_edit_options_t opts)
-{
-    int rc = SR_ERR_OK;
-    CHECK_NULL_ARG2(session, xpath);
+        rc = sr_get_data_file_name(dm_ctx->data_search_dir, module_name, SR_DS_RUNNING, &file_name);
+        if (SR_ERR_OK != rc) {
+            pthread_rwlock_unlock(&schema_info->model_lock);
+            SR_LOG_ERR("Get data_filename failed for %s", module_name);
+            goto cleanup;
+        }
+        fd = open(file_name, O_RDWR);
+        if (-1 == fd) {
+            SR_LOG_DBG("Data file %s can not be opened, skipping", file_name);
+            pthread_rwlock_unlock(&schema_info->model_lock);
+            free(file_name);
+            file_name = NULL;
+            continue;
+        }
+        /* lock, read-only, blocking */
+        sr_lock_fd(fd, false, true);
 
-    rc = dm_alloc_operation(session, DM_DELETE_OP, xpath);
-    CHECK_RC_MSG_RETURN(rc, "Failed to allocate operation");
+        jobs[job_cnt].fd = fd;
+        jobs[job_cnt].file_name = file_name;
+        jobs[job_cnt].schema_info = schema_info;
+        file_name = NULL;
 
-    int index = session->oper_count[session->datastore];
-    session->operations[session->datastore][index].detail.del.options = opts;
-    session->oper_count[session->datastore]++;
-    return rc;
-}
+        /* take the data from the warm image if the files have not changed since it was written */
+        rc = dm_warm_image_data_key(dm_ctx, module_name, jobs[job_cnt].file_name, &data_keys[job_cnt]);
+        if (SR_ERR_OK == rc && SR_ERR_OK == dm_warm_image_load(&image, &jobs[job_cnt], data_keys[job_cnt])) {
+            ++image_cnt;
+        }
+        rc = SR_ERR_OK;
+        ++job_cnt;
+    }
+    dm_warm_image_close(&image);
 
-int
-dm_add_move_operation(dm_session_t *session, const char *xpath, sr_move_position_t pos, const char *rel_item)
-{
-    int rc = SR_ERR_OK;
-    CHECK_NULL_ARG2(session, xpath);
+    if (0 < job_cnt && SR_ERR_OK != dm_load_data_tree_files(dm_ctx, jobs, job_cnt)) {
+        SR_LOG_WRN_MSG("Some running data could not be loaded, they will be loaded on demand.");
+    }
 
-    rc = dm_alloc_operation(session, DM_MOVE_OP, xpath);
-    CHECK_RC_MSG_RETURN(rc, "Failed to allocate operation");
+    /* keep the data trees in the cache of read-only trees */
+    for (size_t i = 0; i < job_cnt; ++i) {
+        if (NULL != jobs[i].data_info) {
+            dm_rdonly_tree_store(jobs[i].schema_info, SR_DS_RUNNING, jobs[i].data_info);
+            ++loaded_cnt;
+        }
+    }
 
-    int index = session->oper_count[session->datastore];
+    sr_clock_get_time(CLOCK_MONOTONIC, &ts_end);
+    SR_LOG_INF("Running data of %zu module(s) enabled in running datastore loaded in %.3f seconds "
+            "(%zu of them from the warm image).", loaded_cnt,
+            (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9, image_cnt);
 
-    session->operations[session->datastore][index].detail.mov.position = pos;
-    if (NULL != rel_item) {
-        session->operations[session->datastore][index].detail.mov.relative_item = strdup(rel_item);
-        CHECK_NULL_NOMEM_RETURN(session->operations[session->datastore][index].detail.mov.relative_item);
-    } else {
-        session->operations[session->datastore][index].detail.mov.relative_item = NULL;
+    if (image_cnt < loaded_cnt) {
+        /* refresh the image for the next startup, failure only costs parsing of the files next time */
+        dm_warm_image_write(dm_ctx, schema_key, jobs, data_keys, job_cnt);
     }
 
-    session->oper_count[session->datastore]++;
+cleanup:
+    for (size_t i = 0; i < job_cnt; ++i) {
+        sr_unlock_fd(jobs[i].fd);
+        close(jobs[i].fd);
+        dm_data_info_free(jobs[i].data_info);
+        free((char *) jobs[i].file_name);
+        pthread_rwlock_unlock(&jobs[i].schema_info->model_lock);
+    }
+    free(jobs);
+    free(data_keys);
+    dm_warm_image_close(&image);
+    if (NULL != module_names) {
+        for (size_t i = 0; i < module_names->count; ++i) {
+            free(module_names->data[i]);
+        }
+        sr_list_cleanup(module_names);
+    }
     return rc;
 }
 
-void
-dm_remove_last_operation(dm_session_t *session)
+static void
+dm_free_sess_op(dm_sess_op_t *op)
 {
-    CHECK_NULL_ARG_VOID(session);
-    if (session->oper_count[session->datastore] > 0) {
-        session->oper_count[session->datastore]--;
-        int index = session->oper_count[session->datastore];
-        dm_free_sess_op(&session->operations[session->datastore][index]);
-        session->operations[session->datastore][index].xpath = NULL;
-        session->operations[session->datastore][index].detail.set.val = NULL;
-        session->operations[session->datastore][index].detail.set.str_val = NULL;
+    if (NULL == op) {
+        return;
+    }
+    free(op->xpath);
+    if (DM_SET_OP == op->op) {
+        sr_free_val(op->detail.set.val);
+        free(op->detail.set.str_val);
+    } else if (DM_MOVE_OP == op->op) {
+        free(op->detail.mov.relative_item);
+        op->detail.mov.relative_item = NULL;
+    } else if (DM_SET_TREE_OP == op->op) {
+        free(op->detail.tree.data);
+        op->detail.tree.data = NULL;
     }
 }
 
-void
-dm_get_session_operations(dm_session_t *session, dm_sess_op_t **ops, size_t *count)
-{
-    CHECK_NULL_ARG_VOID3(session, ops, count);
-    *ops = session->operations[session->datastore];
-    *count = session->oper_count[session->datastore];
-}
-
-void
-dm_clear_session_errors(dm_session_t *session)
+static void
+dm_free_sess_operations(dm_sess_op_t *ops, size_t count)
 {
-    if (NULL == session) {
+    if (NULL == ops) {
         return;
     }
 
-    if (NULL != session->error_msg) {
-        free(session->error_msg);
-        session->error_msg = NULL;
-    }
-
-    if (NULL != session->error_xpath) {
-        free(session->error_xpath);
-        session->error_xpath = NULL;
+    for (size_t i = 0; i < count; i++) {
+        dm_free_sess_op(&ops[i]);
     }
+    free(ops);
 }
 
-int
-dm_report_error(dm_session_t *session, const char *msg, const char *err_path, int rc)
+/**
+ * @brief Locks a file based on provided file name.
+ * @param [in] lock_ctx
+ * @param [in] filename
+ * @return Error code (SR_ERR_OK on success), SR_ERR_LOCKED if the file is already locked,
+ * SR_ERR_UNATHORIZED if the file can not be locked because of the permission.
+ */
+static int
+dm_lock_file(sr_locking_set_t *lock_ctx, char *filename)
 {
-    if (NULL == session) {
-        return SR_ERR_INTERNAL;
-    }
-
-    /* if NULL is provided, message will be generated according to the error code */
-    if (NULL == msg) {
-        msg = sr_strerror(rc);
-    }
-
-    /* error mesage */
-    if (NULL != session->error_msg) {
-        SR_LOG_DBG("Overwriting session error message %s", session->error_msg);
-        free(session->error_msg);
-    }
-    session->error_msg = strdup(msg);
-    CHECK_NULL_NOMEM_RETURN(session->error_msg);
-
-    /* error xpath */
-    if (NULL != err_path) {
-        if (NULL != session->error_xpath) {
-            SR_LOG_DBG("Overwriting session error xpath %s", session->error_xpath);
-            free(session->error_xpath);
-        }
-        session->error_xpath = strdup(err_path);
-        CHECK_NULL_NOMEM_RETURN(session->error_xpath);
-    } else {
-        SR_LOG_DBG_MSG("Error xpath passed to dm_report is NULL");
-    }
-
-    return rc;
+    CHECK_NULL_ARG2(lock_ctx, filename);
+    return sr_locking_set_lock_file_open(lock_ctx, filename, true, false, NULL);
 }
 
-bool
-dm_has_error(dm_session_t *session)
+/**
+ * @brief Unlocks the file based on the filename
+ * @param [in] lock_ctx
+ * @param [in] filename
+ * @return Error code (SR_ERR_OK on success) SR_ERR_INVAL_ARG if the
+ * file had not been locked in provided context
+ */
+static int
+dm_unlock_file(sr_locking_set_t *lock_ctx, char *filename)
 {
-    if (NULL == session) {
-        return false;
-    }
-    return NULL != session->error_msg || NULL != session->error_xpath;
+    CHECK_NULL_ARG2(lock_ctx, filename);
+    return sr_locking_set_unlock_close_file(lock_ctx, filename);
 }
 
-int
-dm_copy_errors(dm_session_t *session, sr_mem_ctx_t *sr_mem, char **error_msg, char **err_xpath)
+/**
+ * @brief Logging callback called from libyang for each log entry.
+ */
+static void
+dm_ly_log_cb(LY_LOG_LEVEL level, const char *msg, const char *path)
 {
-    CHECK_NULL_ARG3(session, error_msg, err_xpath);
-    if (NULL != session->error_msg) {
-        sr_mem_edit_string(sr_mem, error_msg, session->error_msg);
-    }
-    if (NULL != session->error_xpath) {
-        sr_mem_edit_string(sr_mem, err_xpath, session->error_xpath);
-    }
-    if ((NULL != session->error_msg && NULL == *error_msg) || (NULL != session->error_xpath && NULL == *err_xpath)) {
-        SR_LOG_ERR_MSG("Error duplication failed");
-        return SR_ERR_INTERNAL;
+    if (LY_LLERR == level) {
+        SR_LOG_ERR("libyang error: %s", msg);
     }
-    return SR_ERR_OK;
 }
 
-bool
-dm_is_node_enabled(struct lys_node* node)
+int
+dm_lock_module(dm_ctx_t *dm_ctx, dm_session_t *session, const char *modul_name)
 {
-    if (node->nodetype & (LYS_GROUPING | LYS_USES | LYS_CHOICE | LYS_CASE)) {
-        return false;
-    }
+    CHECK_NULL_ARG3(dm_ctx, session, modul_name);
+    int rc = SR_ERR_OK;
+    char *lock_file = NULL;
+    dm_schema_info_t *si = NULL;
 
-    dm_node_state_t state = dm_get_node_state(node);
-    return DM_NODE_ENABLED == state || DM_NODE_ENABLED_WITH_CHILDREN == state;
-}
+    /* check if module name is valid */
+    rc = dm_get_module_and_lock(dm_ctx, modul_name, &si);
+    CHECK_RC_LOG_RETURN(rc, "Unknown module %s to lock", modul_name);
 
-bool
-dm_is_node_enabled_with_children(struct lys_node* node)
-{
-    if (node->nodetype & (LYS_GROUPING | LYS_USES | LYS_CHOICE | LYS_CASE)) {
-        return false;
+    if (si->can_not_be_locked) {
+        SR_LOG_DBG("Module %s contains no data, locking for the module is no operation.", modul_name);
+        goto cleanup;
     }
 
-    return DM_NODE_ENABLED_WITH_CHILDREN == dm_get_node_state(node);
-}
+    rc = sr_get_lock_data_file_name(dm_ctx->data_search_dir, modul_name, session->datastore, &lock_file);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Lock file name can not be created");
 
-bool
-dm_is_enabled_check_recursively(struct lys_node *node)
-{
-    if (dm_is_node_enabled(node)) {
-        return true;
-    }
-    for (node = lys_parent(node); node; node = lys_parent(node)) {
-        if (dm_is_node_enabled_with_children(node)) {
-            return true;
+    /* check if already locked by this session */
+    for (size_t i = 0; i < session->locked_files->count; i++) {
+        if (0 == strcmp(lock_file, (char *) session->locked_files->data[i])) {
+            SR_LOG_INF("File %s is already locked by this session", lock_file);
+            free(lock_file);
+            goto cleanup;
         }
     }
-    return false;
-}
 
-bool
-dm_is_running_ds_session(dm_session_t *session)
-{
-    if (NULL != session) {
-        return SR_DS_RUNNING == session->datastore;
+    if (session->datastore != SR_DS_CANDIDATE) {
+        /* switch identity */
+        ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+
+        rc = dm_lock_file(dm_ctx->locking_ctx, lock_file);
+
+        /* switch identity back */
+        ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
     }
-    return false;
-}
 
-/**
- * @brief Function appends data tree from different context to validate
- * cross-module reference
- *
- * @param [in] session
- * @param [in] data_info
- * @param [in] module_name
- *
- * @return Error code (SR_ERR_OK on success)
- */
-static int
-dm_append_data_tree(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *data_info, const char *module_name)
+    /* log information about locked model */
+    if (SR_ERR_OK != rc) {
+        free(lock_file);
+    } else {
+        rc = sr_list_add(session->locked_files, lock_file);
+        CHECK_RC_MSG_RETURN(rc, "List add failed");
+
+        pthread_mutex_lock(&si->usage_count_mutex);
+        si->usage_count++;
+        SR_LOG_DBG("Usage count %s incremented (value=%zu)", si->module_name, si->usage_count);
+        pthread_mutex_unlock(&si->usage_count_mutex);
+    }
+cleanup:
+    pthread_rwlock_unlock(&si->model_lock);
+    return rc;
+}
+
+int
+dm_unlock_module(dm_ctx_t *dm_ctx, dm_session_t *session, char *modul_name)
 {
-    CHECK_NULL_ARG4(dm_ctx, session, data_info, module_name);
+    CHECK_NULL_ARG3(dm_ctx, session, modul_name);
     int rc = SR_ERR_OK;
-    int ret = 0;
-    dm_data_info_t *di = NULL;
-    bool must_be_freed = false;
+    dm_schema_info_t *si = NULL;
+    char *lock_file = NULL;
+    size_t i = 0;
 
-    rc = dm_get_data_info_internal(dm_ctx, session, module_name, true, &must_be_freed, &di);
-    CHECK_RC_LOG_RETURN(rc, "Get data info failed for module %s", module_name);
+    SR_LOG_INF("Unlock request module='%s'", modul_name);
 
-    /* transform data from one ctx to another */
-    if (NULL != di->node) {
-        ly_ctx_set_module_data_clb(data_info->schema->ly_ctx, dm_module_clb, dm_ctx);
+    rc = dm_get_module_and_lock(dm_ctx, modul_name, &si);
+    CHECK_RC_LOG_RETURN(rc, "Unknown module %s to unlock", modul_name);
 
-        if (NULL == data_info->node) {
-            data_info->node = sr_dup_datatree_to_ctx(di->node, data_info->schema->ly_ctx);
-            if (NULL == data_info->node) {
-                SR_LOG_ERR("Failed to duplicate %s data tree into another context", di->schema->module->name);
-                return SR_ERR_INTERNAL;
-            }
-        } else {
-            ret = lyd_merge_to_ctx(&data_info->node, di->node, LYD_OPT_EXPLICIT, data_info->schema->ly_ctx);
-            CHECK_ZERO_LOG_RETURN(ret, SR_ERR_INTERNAL, "Failed to merge %s data tree", di->schema->module->name);
+    rc = sr_get_lock_data_file_name(dm_ctx->data_search_dir, modul_name, session->datastore, &lock_file);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Lock file name can not be created");
+
+    /* check if already locked */
+    bool found = false;
+    for (i = 0; i < session->locked_files->count; i++) {
+        if (0 == strcmp(lock_file, (char *) session->locked_files->data[i])) {
+            found = true;
+            break;
         }
-    } else {
-        SR_LOG_DBG("Dependant module %s is empty", di->schema->module->name);
     }
 
-    if (must_be_freed) {
-        dm_data_info_free(di);
+    if (!found) {
+        SR_LOG_ERR("File %s has not been locked in this context", lock_file);
+        rc = SR_ERR_INVAL_ARG;
+    } else {
+        if (session->datastore != SR_DS_CANDIDATE) {
+            rc = dm_unlock_file(dm_ctx->locking_ctx, lock_file);
+        }
+        free(session->locked_files->data[i]);
+        sr_list_rm_at(session->locked_files, i);
+        pthread_mutex_lock(&si->usage_count_mutex);
+        si->usage_count--;
+        SR_LOG_DBG("Usage count %s decremented (value=%zu)", si->module_name, si->usage_count);
+        pthread_mutex_unlock(&si->usage_count_mutex);
     }
-
+cleanup:
+    free(lock_file);
+    pthread_rwlock_unlock(&si->model_lock);
     return rc;
 }
 
-
-/**
- * @brief Function deletes data that do not belong to the main module and was added due to
- * validation of cross-module dependant data
- *
- * @param [in] session
- * @param [in] data_info
- *
- * @return Error code (SR_ERR_OK on success)
- */
-static int
-dm_remove_added_data_trees(dm_session_t *session, dm_data_info_t *data_info)
+int
+dm_lock_datastore(dm_ctx_t *dm_ctx, dm_session_t *session)
 {
-    CHECK_NULL_ARG2(session, data_info);
-    if (NULL != data_info->node) {
-        if (data_info->schema->module != LYS_MAIN_MODULE(data_info->node->schema)) {
-            /* verify that the module referencing others has some data */
-            lyd_free_withsiblings(data_info->node);
-            data_info->node = NULL;
-            return SR_ERR_OK;
+    CHECK_NULL_ARG2(dm_ctx, session);
+    int rc = SR_ERR_OK;
+    sr_schema_t *schemas = NULL;
+    size_t schema_count = 0;
+
+    sr_list_t *locked = NULL;
+    rc = sr_list_init(&locked);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
+
+    rc = dm_list_schemas(dm_ctx, session, &schemas, &schema_count);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List schemas failed");
+
+    if (session->datastore != SR_DS_CANDIDATE) {
+        pthread_mutex_lock(&dm_ctx->ds_lock_mutex);
+        if (dm_ctx->ds_lock[session->datastore]) {
+            SR_LOG_ERR_MSG("Datastore lock is held by another session");
+            rc = SR_ERR_LOCKED;
+            pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
+            goto cleanup;
         }
-        const struct lys_module *module = data_info->node->schema->module;
-        struct lyd_node *n = data_info->node;
-        struct lyd_node *tmp = NULL;
+        dm_ctx->ds_lock[session->datastore] = true;
+        pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
+    }
+    session->holds_ds_lock[session->datastore] = true;
 
-        while (n) {
-           tmp = n;
-           n = n->next;
-           if (module != tmp->schema->module) {
-              lyd_free(tmp);
-           }
+    for (size_t i = 0; i < schema_count; i++) {
+        if (!schemas[i].implemented) {
+            /* nothing to lock */
+            continue;
+        }
+
+        rc = dm_lock_module(dm_ctx, session, (char *) schemas[i].module_name);
+        if (SR_ERR_OK != rc) {
+            if (SR_ERR_UNAUTHORIZED == rc) {
+                SR_LOG_INF("Not allowed to lock %s, skipping", schemas[i].module_name);
+                continue;
+            } else if (SR_ERR_LOCKED == rc) {
+                SR_LOG_ERR("Model %s is already locked by another session", schemas[i].module_name);
+            }
+            for (size_t l = 0; l < locked->count; l++) {
+                dm_unlock_module(dm_ctx, session, (char *) locked->data[l]);
+            }
+            pthread_mutex_lock(&dm_ctx->ds_lock_mutex);
+            dm_ctx->ds_lock[session->datastore] = false;
+            pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
+            session->holds_ds_lock[session->datastore] = false;
+            goto cleanup;
         }
+        SR_LOG_DBG("Module %s locked", schemas[i].module_name);
+        rc = sr_list_add(locked, (char *) schemas[i].module_name);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
     }
-    return SR_ERR_OK;
+cleanup:
+    sr_free_schemas(schemas, schema_count);
+    sr_list_cleanup(locked);
+    return rc;
 }
 
 /**
- * @brief Append all dependant data.
+ *
+ * @brief Extracts the name of the module and lookups the schema info from lock files.
+ *
+ * Expectes that lock file name are in form [DATA_DIR][MODULE_NAME][DATASTORE].lock
+ *
+ * @note Schema info read lock is acquired on successful return from function. Must be released by caller.
  *
  * @param [in] dm_ctx
- * @param [in] session
- * @param [in] info
+ * @param [in] lock_file
+ * @param [out] schema_info
  * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_load_dependant_data(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *info)
+dm_get_schema_info_by_lock_file(dm_ctx_t *dm_ctx, const char *lock_file, dm_schema_info_t **schema_info)
 {
-    CHECK_NULL_ARG3(dm_ctx, session, info);
-    sr_llist_node_t *ll_node = NULL;
-    md_module_t *module = NULL;
-    md_dep_t *dep = NULL;
+    CHECK_NULL_ARG3(dm_ctx, lock_file, schema_info);
     int rc = SR_ERR_OK;
+    char *begin = NULL;
+    char *end = NULL;
+    char *module_name = NULL;
 
-    /* remove previously appended data */
-    rc = dm_remove_added_data_trees(session, info);
-    CHECK_RC_MSG_RETURN(rc, "Removing of added data trees failed");
+    if (NULL == strstr(lock_file, dm_ctx->data_search_dir)){
+        return SR_ERR_INTERNAL;
+    }
+    begin = (char *)lock_file + strlen(dm_ctx->data_search_dir);
+    if ((end = strstr(begin, SR_STARTUP_FILE_EXT SR_LOCK_FILE_EXT))
+            || (end = strstr(begin, SR_RUNNING_FILE_EXT SR_LOCK_FILE_EXT))
+            || (end = strstr(begin, ".candidate" SR_LOCK_FILE_EXT))) {
+        /* dup the module name */
+        module_name = strndup(begin, end-begin);
+        CHECK_NULL_NOMEM_RETURN(module_name);
 
-    if (info->schema->cross_module_data_dependency) {
-        md_ctx_lock(dm_ctx->md_ctx, false);
-        rc = md_get_module_info(dm_ctx->md_ctx, info->schema->module_name, NULL, NULL, &module);
-        CHECK_RC_LOG_GOTO(rc, unlock, "Unable to get the list of dependencies for module '%s'.", info->schema->module_name);
-        ll_node = module->deps->first;
-        while (ll_node) {
-            dep = (md_dep_t *)ll_node->data;
-            if (MD_DEP_DATA == dep->type && dep->dest->implemented && dep->dest->has_data) {
-                const char *dependant_module = dep->dest->name;
-                rc = dm_append_data_tree(session->dm_ctx, session, info, dependant_module);
-                CHECK_RC_LOG_GOTO(rc, unlock, "Failed to append data tree %s", dependant_module);
-                SR_LOG_DBG("Data tree %s appended because of validation", dependant_module);
-            }
-            ll_node = ll_node->next;
-        }
-unlock:
-        md_ctx_unlock(dm_ctx->md_ctx);
+        rc = dm_get_module_and_lock(dm_ctx, module_name, schema_info);
+        free(module_name);
+    } else {
+        SR_LOG_ERR("Unable to extract module name %s", lock_file);
+        rc = SR_ERR_INTERNAL;
     }
+
     return rc;
 }
 
 int
-dm_init(ac_ctx_t *ac_ctx, np_ctx_t *np_ctx, pm_ctx_t *pm_ctx, const cm_connection_mode_t conn_mode,
-        const char *schema_search_dir, const char *data_search_dir, dm_ctx_t **dm_ctx)
+dm_unlock_datastore(dm_ctx_t *dm_ctx, dm_session_t *session)
 {
-    CHECK_NULL_ARG3(schema_search_dir, data_search_dir, dm_ctx);
-
-    SR_LOG_INF("Initializing Data Manager, schema_search_dir=%s, data_search_dir=%s", schema_search_dir, data_search_dir);
-
-    dm_ctx_t *ctx = NULL;
-    dm_tmp_ly_ctx_t *t_ctx = NULL;
+    CHECK_NULL_ARG2(dm_ctx, session);
+    SR_LOG_INF_MSG("Unlock datastore request");
     int rc = SR_ERR_OK;
-    pthread_rwlockattr_t attr;
-    pthread_rwlockattr_init(&attr);
-    char *internal_schema_search_dir = NULL, *internal_data_search_dir = NULL;
-    ctx = calloc(1, sizeof(*ctx));
-    CHECK_NULL_NOMEM_GOTO(ctx, rc, cleanup);
-    ctx->ac_ctx = ac_ctx;
-    ctx->np_ctx = np_ctx;
-    ctx->pm_ctx = pm_ctx;
-    ctx->conn_mode = conn_mode;
-
-    ly_set_log_clb(dm_ly_log_cb, 1);
+    char *file_path = NULL;
+    dm_schema_info_t *si = NULL;
 
-    ctx->schema_search_dir = strdup(schema_search_dir);
-    CHECK_NULL_NOMEM_GOTO(ctx->schema_search_dir, rc, cleanup);
+    while (session->locked_files->count > 0) {
+        si = NULL;
+        file_path = (char *)session->locked_files->data[0];
+        rc = dm_get_schema_info_by_lock_file(dm_ctx, file_path, &si);
+        if (SR_ERR_OK == rc) {
+            SR_LOG_DBG("Module_name %s", si->module_name);
+            pthread_mutex_lock(&si->usage_count_mutex);
+            si->usage_count--;
+            SR_LOG_DBG("Usage count %s decremented (value=%zu)", si->module_name, si->usage_count);
+            pthread_mutex_unlock(&si->usage_count_mutex);
+            pthread_rwlock_unlock(&si->model_lock);
+        } else {
+            SR_LOG_WRN("Get schema info by lock file failed %s", file_path);
+        }
 
-    ctx->data_search_dir = strdup(data_search_dir);
-    CHECK_NULL_NOMEM_GOTO(ctx->data_search_dir, rc, cleanup);
+        if (strlen(file_path) < 15 || 0 != strcmp(file_path + strlen(file_path) - 15, ".candidate.lock")) {
+            dm_unlock_file(dm_ctx->locking_ctx, file_path);
+        }
 
-    ctx->ds_lock = calloc(DM_DATASTORE_COUNT, sizeof(*ctx->ds_lock));
-    CHECK_NULL_NOMEM_GOTO(ctx->ds_lock, rc, cleanup);
-
-    rc = sr_locking_set_init(&ctx->locking_ctx);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Locking set init failed");
-
-#if defined(HAVE_PTHREAD_RWLOCKATTR_SETKIND_NP)
-    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
-#endif
-
-    rc = pthread_rwlock_init(&ctx->schema_tree_lock, &attr);
-    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "lyctx mutex initialization failed");
-
-    rc = sr_btree_init(dm_schema_info_cmp, dm_free_schema_info, &ctx->schema_info_tree);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Schema binary tree allocation failed");
-
-    rc = sr_btree_init(dm_c_ctx_id_cmp, dm_free_commit_context, &ctx->commit_ctxs.tree);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit context binary tree initialization failed");
-
-    rc = pthread_rwlock_init(&ctx->commit_ctxs.lock, &attr);
-    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "c_ctxs_lock init failed");
+        free(session->locked_files->data[0]);
+        sr_list_rm_at(session->locked_files, 0);
+    }
+    for (int i = 0; i < DM_DATASTORE_COUNT; i++) {
+        if (session->holds_ds_lock[i]) {
+            pthread_mutex_lock(&dm_ctx->ds_lock_mutex);
+            dm_ctx->ds_lock[i] = false;
+            session->holds_ds_lock[i] = false;
+            pthread_mutex_unlock(&dm_ctx->ds_lock_mutex);
+        }
+    }
+    return SR_ERR_OK;
+}
 
-    rc = pthread_mutex_init(&ctx->commit_ctxs.empty_mutex, NULL);
-    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "c_ctxs_empty_mutex init failed");
+/**
+ * @brief Returns the state of node. If the NULL is provided as an argument
+ * DM_NODE_DISABLED is returned.
+ */
+static dm_node_state_t
+dm_get_node_state(struct lys_node *node)
+{
+    if (NULL == node || NULL == node->priv) {
+        return DM_NODE_DISABLED;
+    }
+    dm_node_info_t *n_info = (dm_node_info_t *) node->priv;
 
-    rc = pthread_cond_init(&ctx->commit_ctxs.empty_cond, NULL);
-    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "c_ctxs_empty_cond init failed");
+    if (NULL == n_info) {
+        return DM_NODE_DISABLED;
+    }
+    return n_info->state;
+}
 
-    ctx->commit_ctxs.empty = true;
+uint32_t
+dm_get_node_xpath_hash(struct lys_node *node)
+{
+    if (NULL == node || NULL == node->priv) {
+        return 0;
+    }
+    dm_node_info_t *n_info = (dm_node_info_t *) node->priv;
+    return n_info->xpath_hash;
+}
 
-    rc = sr_str_join(schema_search_dir, "internal", &internal_schema_search_dir);
-    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "sr_str_join failed");
-    rc = sr_str_join(data_search_dir, "internal", &internal_data_search_dir);
-    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "sr_str_join failed");
+uint16_t
+dm_get_node_data_depth(struct lys_node *node)
+{
+    if (NULL == node || NULL == node->priv) {
+        return 0;
+    }
+    dm_node_info_t *n_info = (dm_node_info_t *) node->priv;
+    return n_info->data_depth;
+}
 
-    rc = md_init(schema_search_dir, internal_schema_search_dir,
-                 internal_data_search_dir, false, &ctx->md_ctx);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to initialize Module Dependencies context.");
+static int
+dm_alloc_operation(dm_session_t *session, dm_operation_t op, const char *xpath)
+{
+    int rc = SR_ERR_OK;
+    CHECK_NULL_ARG2(session, xpath);
 
-#ifdef ENABLE_NACM
-    if (CM_MODE_DAEMON == conn_mode) {
-        rc = nacm_init(ctx, ctx->data_search_dir, &ctx->nacm_ctx);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to initialize NACM context.");
-    } else {
-        SR_LOG_INF_MSG("Sysrepo is running in the local mode => NACM will be disabled.");
+    if (NULL == session->operations[session->datastore]) {
+        session->oper_size[session->datastore] = 1;
+        session->operations[session->datastore] = calloc(session->oper_size[session->datastore], sizeof(*session->operations[session->datastore]));
+        CHECK_NULL_NOMEM_RETURN(session->operations[session->datastore]);
+    } else if (session->oper_count[session->datastore] == session->oper_size[session->datastore]) {
+        session->oper_size[session->datastore] *= 2;
+        dm_sess_op_t *tmp_op = realloc(session->operations[session->datastore], session->oper_size[session->datastore] * sizeof(*session->operations[session->datastore]));
+        CHECK_NULL_NOMEM_RETURN(tmp_op);
+        session->operations[session->datastore] = tmp_op;
     }
-#endif
+    int index = session->oper_count[session->datastore];
+    session->operations[session->datastore][index].op = op;
+    session->operations[session->datastore][index].has_error = false;
+    session->operations[session->datastore][index].xpath = strdup(xpath);
+    CHECK_NULL_NOMEM_RETURN(session->operations[session->datastore][index].xpath);
 
-    t_ctx = calloc(1, sizeof(*t_ctx));
-    CHECK_NULL_NOMEM_GOTO(t_ctx, rc, cleanup);
+    return rc;
+}
 
-    pthread_mutex_init(&t_ctx->mutex, NULL);
-    rc = sr_list_init(&t_ctx->loaded_modules);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to initialize a list");
+int
+dm_add_set_operation(dm_session_t *session, const char *xpath, sr_val_t *val, char *str_val, sr_edit_options_t opts)
+{
+    int rc = SR_ERR_OK;
+    CHECK_NULL_ARG_NORET2(rc, session, xpath); /* value, str_val can be NULL*/
+    if (SR_ERR_OK != rc) {
+        goto cleanup;
+    }
 
-    t_ctx->ctx = ly_ctx_new(ctx->schema_search_dir, LY_CTX_NOYANGLIBRARY);
-    CHECK_NULL_NOMEM_GOTO(t_ctx->ctx, rc, cleanup);
+    rc = dm_alloc_operation(session, DM_SET_OP, xpath);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to allocate operation");
 
-    ctx->tmp_ly_ctx = t_ctx;
-    t_ctx = NULL;
+    int index = session->oper_count[session->datastore];
 
-    *dm_ctx = ctx;
+    session->operations[session->datastore][index].detail.set.val = val;
+    session->operations[session->datastore][index].detail.set.options = opts;
+    session->operations[session->datastore][index].detail.set.str_val = str_val;
 
+    session->oper_count[session->datastore]++;
+    return rc;
 cleanup:
-    free(internal_schema_search_dir);
-    free(internal_data_search_dir);
-    pthread_rwlockattr_destroy(&attr);
-    if (SR_ERR_OK != rc) {
-        dm_cleanup(ctx);
-        dm_free_tmp_ly_ctx(t_ctx);
-    }
+    sr_free_val(val);
+    free(str_val);
     return rc;
-
 }
 
-void
-dm_cleanup(dm_ctx_t *dm_ctx)
+int
+dm_add_del_operation(dm_session_t *session, const char *xpath, sr_edit_options_t opts)
 {
-    if (NULL != dm_ctx) {
-        nacm_cleanup(dm_ctx->nacm_ctx);
-        sr_btree_cleanup(dm_ctx->commit_ctxs.tree);
-        free(dm_ctx->schema_search_dir);
-        free(dm_ctx->data_search_dir);
-        free(dm_ctx->ds_lock);
-        sr_btree_cleanup(dm_ctx->schema_info_tree);
-        md_destroy(dm_ctx->md_ctx);
-        pthread_rwlock_destroy(&dm_ctx->schema_tree_lock);
-        sr_locking_set_cleanup(dm_ctx->locking_ctx);
-        pthread_mutex_destroy(&dm_ctx->ds_lock_mutex);
-        pthread_rwlock_destroy(&dm_ctx->commit_ctxs.lock);
-        pthread_mutex_destroy(&dm_ctx->commit_ctxs.empty_mutex);
-        pthread_cond_destroy(&dm_ctx->commit_ctxs.empty_cond);
-        dm_free_tmp_ly_ctx(dm_ctx->tmp_ly_ctx);
-        free(dm_ctx);
-    }
+    int rc = SR_ERR_OK;
+    CHECK_NULL_ARG2(session, xpath);
+
+    rc = dm_alloc_operation(session, DM_DELETE_OP, xpath);
+    CHECK_RC_MSG_RETURN(rc, "Failed to allocate operation");
+
+    int index = session->oper_count[session->datastore];
+    session->operations[session->datastore][index].detail.del.options = opts;
+    session->oper_count[session->datastore]++;
+    return rc;
 }
 
 int
-dm_session_start(dm_ctx_t *dm_ctx, const ac_ucred_t *user_credentials, const sr_datastore_t ds, dm_session_t **dm_session_ctx)
+dm_add_move_operation(dm_session_t *session, const char *xpath, sr_move_position_t pos, const char *rel_item)
 {
-    CHECK_NULL_ARG(dm_session_ctx);
+    int rc = SR_ERR_OK;
+    CHECK_NULL_ARG2(session, xpath);
 
-    dm_session_t *session_ctx = NULL;
-    session_ctx = calloc(1, sizeof(*session_ctx));
-    CHECK_NULL_NOMEM_RETURN(session_ctx);
-    session_ctx->dm_ctx = dm_ctx;
-    session_ctx->user_credentials = user_credentials;
-    session_ctx->datastore = ds;
+    rc = dm_alloc_operation(session, DM_MOVE_OP, xpath);
+    CHECK_RC_MSG_RETURN(rc, "Failed to allocate operation");
 
-    int rc = SR_ERR_OK;
-    session_ctx->session_modules = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->session_modules));
-    CHECK_NULL_NOMEM_GOTO(session_ctx->session_modules, rc, cleanup);
+    int index = session->oper_count[session->datastore];
 
-    for (size_t i = 0; i < DM_DATASTORE_COUNT; i++) {
-        rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &session_ctx->session_modules[i]);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Session module binary tree init failed");
+    session->operations[session->datastore][index].detail.mov.position = pos;
+    if (NULL != rel_item) {
+        session->operations[session->datastore][index].detail.mov.relative_item = strdup(rel_item);
+        CHECK_NULL_NOMEM_RETURN(session->operations[session->datastore][index].detail.mov.relative_item);
+    } else {
+        session->operations[session->datastore][index].detail.mov.relative_item = NULL;
     }
 
-    rc = sr_list_init(&session_ctx->locked_files);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+    session->oper_count[session->datastore]++;
+    return rc;
+}
 
-    session_ctx->holds_ds_lock = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->holds_ds_lock));
-    CHECK_NULL_NOMEM_GOTO(session_ctx->holds_ds_lock, rc, cleanup);
-    session_ctx->operations = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->operations));
-    CHECK_NULL_NOMEM_GOTO(session_ctx->operations, rc, cleanup);
-    session_ctx->oper_count = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->oper_count));
-    CHECK_NULL_NOMEM_GOTO(session_ctx->oper_count, rc, cleanup);
-    session_ctx->oper_size = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->oper_size));
-    CHECK_NULL_NOMEM_GOTO(session_ctx->oper_size, rc, cleanup);
+int
+dm_add_set_tree_operation(dm_session_t *session, const char *xpath, char *data, bool merge)
+{
+    int rc = SR_ERR_OK;
+    CHECK_NULL_ARG_NORET3(rc, session, xpath, data);
+    if (SR_ERR_OK != rc) {
+        goto cleanup;
+    }
+
+    rc = dm_alloc_operation(session, DM_SET_TREE_OP, xpath);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to allocate operation");
+
+    int index = session->oper_count[session->datastore];
 
+    session->operations[session->datastore][index].detail.tree.data = data;
+    session->operations[session->datastore][index].detail.tree.merge = merge;
 
+    session->oper_count[session->datastore]++;
+    return rc;
 cleanup:
-    if (SR_ERR_OK == rc) {
-        *dm_session_ctx = session_ctx;
-    } else {
-        dm_session_stop((dm_ctx_t *) dm_ctx, session_ctx);
-    }
+    free(data);
     return rc;
 }
 
 void
-dm_session_stop(dm_ctx_t *dm_ctx, dm_session_t *session)
+dm_remove_last_operation(dm_session_t *session)
 {
-    CHECK_NULL_ARG_VOID2(dm_ctx, session);
-    if (NULL != session->locked_files) {
-        dm_unlock_datastore(dm_ctx, session);
-        sr_list_cleanup(session->locked_files);
-    }
-    for (size_t i = 0; i < DM_DATASTORE_COUNT; i++) {
-        sr_btree_cleanup(session->session_modules[i]);
-    }
-    free(session->session_modules);
-    dm_clear_session_errors(session);
-    for (size_t i = 0; i < DM_DATASTORE_COUNT; i++) {
-        dm_free_sess_operations(session->operations[i], session->oper_count[i]);
+    CHECK_NULL_ARG_VOID(session);
+    if (session->oper_count[session->datastore] > 0) {
+        session->oper_count[session->datastore]--;
+        int index = session->oper_count[session->datastore];
+        dm_free_sess_op(&session->operations[session->datastore][index]);
+        session->operations[session->datastore][index].xpath = NULL;
+        session->operations[session->datastore][index].detail.set.val = NULL;
+        session->operations[session->datastore][index].detail.set.str_val = NULL;
     }
-    free(session->holds_ds_lock);
-    free(session->operations);
-    free(session->oper_count);
-    free(session->oper_size);
-    free(session);
 }
 
-/**
- * @brief Removes not enabled leaves from data tree.
- *
- * @note Function expects that a schema info is locked for reading.
- *
- * @param [in] info
- * @return Error code (SR_ERR_OK on success)
- */
-static int
-dm_remove_not_enabled_nodes(dm_data_info_t *info)
+void
+dm_get_session_operations(dm_session_t *session, dm_sess_op_t **ops, size_t *count)
 {
-    CHECK_NULL_ARG(info);
-    struct lyd_node *iter = NULL, *child = NULL, *next = NULL;
-    sr_list_t *stack = NULL;
-    int rc = SR_ERR_OK;
+    CHECK_NULL_ARG_VOID3(session, ops, count);
+    *ops = session->operations[session->datastore];
+    *count = session->oper_count[session->datastore];
+}
 
-    rc = sr_list_init(&stack);
-    CHECK_RC_MSG_RETURN(rc, "List init failed");
+void
+dm_clear_session_errors(dm_session_t *session)
+{
+    if (NULL == session) {
+        return;
+    }
 
-    /* iterate through top-level nodes */
-    LY_TREE_FOR_SAFE(info->node, next, iter)
-    {
-        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
-            if (dm_is_node_enabled(iter->schema)) {
-                if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
-                    LY_TREE_FOR(iter->child, child)
-                    {
-                        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype) && dm_is_node_enabled(child->schema)) {
-                            rc = sr_list_add(stack, child);
-                            CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
-                        }
-                    }
-                }
-            } else {
-                sr_lyd_unlink(info, iter);
-                lyd_free_withsiblings(iter);
-            }
+    if (NULL != session->error_msg) {
+        free(session->error_msg);
+        session->error_msg = NULL;
+    }
 
-        }
+    if (NULL != session->error_xpath) {
+        free(session->error_xpath);
+        session->error_xpath = NULL;
     }
+}
 
-    while (stack->count != 0) {
-        iter = stack->data[stack->count - 1];
-        if (dm_is_node_enabled(iter->schema)) {
-            if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
+int
+dm_report_error(dm_session_t *session, const char *msg, const char *err_path, int rc)
+{
+    if (NULL == session) {
+        return SR_ERR_INTERNAL;
+    }
 
-                LY_TREE_FOR(iter->child, child)
-                {
-                    if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
-                        rc = sr_list_add(stack, child);
-                        CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
-                    }
-                }
-            }
-        } else {
-            sr_lyd_unlink(info, iter);
-            lyd_free_withsiblings(iter);
+    /* if NULL is provided, message will be generated according to the error code */
+    if (NULL == msg) {
+        msg = sr_strerror(rc);
+    }
+
+    /* error mesage */
+    if (NULL != session->error_msg) {
+        SR_LOG_DBG("Overwriting session error message %s", session->error_msg);
+        free(session->error_msg);
+    }
+    session->error_msg = strdup(msg);
+    CHECK_NULL_NOMEM_RETURN(session->error_msg);
+
+    /* error xpath */
+    if (NULL != err_path) {
+        if (NULL != session->error_xpath) {
+            SR_LOG_DBG("Overwriting session error xpath %s", session->error_xpath);
+            free(session->error_xpath);
         }
-        sr_list_rm(stack, iter);
+        session->error_xpath = strdup(err_path);
+        CHECK_NULL_NOMEM_RETURN(session->error_xpath);
+    } else {
+        SR_LOG_DBG_MSG("Error xpath passed to dm_report is NULL");
     }
 
-cleanup:
-    sr_list_cleanup(stack);
     return rc;
 }
 
+bool
+dm_has_error(dm_session_t *session)
+{
+    if (NULL == session) {
+        return false;
+    }
+    return NULL != session->error_msg || NULL != session->error_xpath;
+}
 
-/**
- * @brief Test if there is not enabled leaf in the provided data tree
- *
- * @note Function expects that a schema info is locked for reading.
- *
- * @param [in] info
- * @param [out] res
- * @return Error code (SR_ERR_OK on success)
- */
-static int
-dm_has_not_enabled_nodes(dm_data_info_t *info, bool *res)
+int
+dm_copy_errors(dm_session_t *session, sr_mem_ctx_t *sr_mem, char **error_msg, char **err_xpath)
 {
-    CHECK_NULL_ARG2(info, res);
-    struct lyd_node *iter = NULL, *child = NULL, *next = NULL;
-    sr_list_t *stack = NULL;
-    int rc = SR_ERR_OK;
+    CHECK_NULL_ARG3(session, error_msg, err_xpath);
+    if (NULL != session->error_msg) {
+        sr_mem_edit_string(sr_mem, error_msg, session->error_msg);
+    }
+    if (NULL != session->error_xpath) {
+        sr_mem_edit_string(sr_mem, err_xpath, session->error_xpath);
+    }
+    if ((NULL != session->error_msg && NULL == *error_msg) || (NULL != session->error_xpath && NULL == *err_xpath)) {
+        SR_LOG_ERR_MSG("Error duplication failed");
+        return SR_ERR_INTERNAL;
+    }
+    return SR_ERR_OK;
+}
 
-    rc = sr_list_init(&stack);
-    CHECK_RC_MSG_RETURN(rc, "List init failed");
+bool
+dm_is_node_enabled(struct lys_node* node)
+{
+    if (node->nodetype & (LYS_GROUPING | LYS_USES | LYS_CHOICE | LYS_CASE)) {
+        return false;
+    }
 
-    /* iterate through top-level nodes */
-    LY_TREE_FOR_SAFE(info->node, next, iter)
-    {
-        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
-            if (dm_is_node_enabled(iter->schema) || iter->dflt) {
-                if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
-                    LY_TREE_FOR(iter->child, child)
-                    {
-                        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
-                            rc = sr_list_add(stack, child);
-                            CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
-                        }
-                    }
-                }
-            } else {
-                SR_LOG_DBG("Found not enabled node %s in module %s", iter->schema->name, iter->schema->module->name);
-                *res = true;
-                goto cleanup;
-            }
+    dm_node_state_t state = dm_get_node_state(node);
+    return DM_NODE_ENABLED == state || DM_NODE_ENABLED_WITH_CHILDREN == state;
+}
 
-        }
+bool
+dm_is_node_enabled_with_children(struct lys_node* node)
+{
+    if (node->nodetype & (LYS_GROUPING | LYS_USES | LYS_CHOICE | LYS_CASE)) {
+        return false;
     }
 
-    while (stack->count != 0) {
-        iter = stack->data[stack->count - 1];
-        if (dm_is_node_enabled(iter->schema) || iter->dflt) {
-            if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
+    return DM_NODE_ENABLED_WITH_CHILDREN == dm_get_node_state(node);
+}
 
-                LY_TREE_FOR(iter->child, child)
-                {
-                    if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
-                        rc = sr_list_add(stack, child);
-                        CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
-                    }
-                }
-            }
-        } else {
-            SR_LOG_DBG("Found not enabled node %s in module %s", iter->schema->name, iter->schema->module->name);
-            *res = true;
-            goto cleanup;
+bool
+dm_is_enabled_check_recursively(struct lys_node *node)
+{
+    if (dm_is_node_enabled(node)) {
+        return true;
+    }
+    for (node = lys_parent(node); node; node = lys_parent(node)) {
+        if (dm_is_node_enabled_with_children(node)) {
+            return true;
         }
-        sr_list_rm(stack, iter);
     }
-    *res = false;
-
-cleanup:
-    sr_list_cleanup(stack);
-    return rc;
+    return false;
 }
 
-static int
-dm_string_cmp(void *a, void *b)
+bool
+dm_is_running_ds_session(dm_session_t *session)
 {
-    assert(a);
-    assert(b);
-
-    int result = strcmp(a, b);
-    if (result < 0) {
-        return -1;
-    } else if (result > 0) {
-        return 1;
-    } else {
-        return 0;
+    if (NULL != session) {
+        return SR_DS_RUNNING == session->datastore;
     }
-
+    return false;
 }
 
 /**
- * @brief Tests if the data requires some schemas to pass the validation. If yes, it collects
- * all required ones into the list.
+ * @brief Function appends data tree from different context to validate
+ * cross-module reference
  *
- * @param [in] dm_ctx
  * @param [in] session
- * @param [in] di
- * @param [out] required_data - subset of modules that require also data to be loaded, the list contains the same strings as required_modules (do not free the content)
- * @param [out] required_modules - if a module different from the installation-time dependencies is required to pass the validation
+ * @param [in] data_info
+ * @param [in] module_name
+ *
  * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_requires_tmp_context(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *di, sr_list_t **required_data, sr_list_t **required_modules)
+dm_append_data_tree(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *data_info, const char *module_name)
 {
-    CHECK_NULL_ARG4(dm_ctx, session, di, required_modules);
-
+    CHECK_NULL_ARG4(dm_ctx, session, data_info, module_name);
     int rc = SR_ERR_OK;
-    md_module_t *module = NULL;
-    sr_llist_node_t *ll_node = NULL;
-    md_subtree_ref_t *id = NULL;
-    struct lys_node *sch_node = NULL;
-    struct ly_set *set = NULL;
-    const char *id_val = NULL;
-    sr_llist_node_t *ll_dep = NULL;
-    md_dep_t *dep = NULL;
-    char *namespace = NULL;
-    char *inserted_namespace = NULL;
-    bool inserted = false, must_be_freed = false;
-    char *module_name = NULL;
-    dm_data_info_t *recursive_info = NULL;
+    int ret = 0;
+    dm_data_info_t *di = NULL;
+    bool must_be_freed = false;
 
-    md_ctx_lock(dm_ctx->md_ctx, false);
+    rc = dm_get_data_info_internal(dm_ctx, session, module_name, true, true, &must_be_freed, &di);
+    CHECK_RC_LOG_RETURN(rc, "Get data info failed for module %s", module_name);
 
-    if (!di->schema->has_instance_id) {
-        /* if there is no instance id all dependencies are known on schema installation time */
+    /* transform data from one ctx to another */
+    if (NULL != di->node) {
+        ly_ctx_set_module_data_clb(data_info->schema->ly_ctx, dm_module_clb, dm_ctx);
 
-        if (NULL != *required_modules) {
-            /* list is already initialized that means we'll use temp ctx, append install time deps */
-            rc = md_get_module_info(dm_ctx->md_ctx, di->schema->module_name, NULL, NULL, &module);
-            CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to retrieve md info for %s module", di->schema->module_name);
+        /* the appended data stay in the data info until removed, they can not be linked in place */
+        dm_data_info_rdonly_lock(di);
+        if (NULL == data_info->node) {
+            data_info->node = sr_dup_datatree_to_ctx(di->node, data_info->schema->ly_ctx);
+            ret = NULL == data_info->node;
+        } else {
+            ret = lyd_merge_to_ctx(&data_info->node, di->node, LYD_OPT_EXPLICIT, data_info->schema->ly_ctx);
+        }
+        dm_data_info_rdonly_unlock(di);
+        if (0 != ret) {
+            SR_LOG_ERR("Failed to append %s data tree", di->schema->module->name);
+            if (must_be_freed) {
+                dm_data_info_free(di);
+            }
+            return SR_ERR_INTERNAL;
+        }
+    } else {
+        SR_LOG_DBG("Dependant module %s is empty", di->schema->module->name);
+    }
 
-            /* installation time dependencies */
-            ll_dep = module->deps->first;
-            while (ll_dep) {
-                dep = (md_dep_t *) ll_dep->data;
-                ll_dep = ll_dep->next;
+    if (must_be_freed) {
+        dm_data_info_free(di);
+    }
 
-                module_name = strdup(dep->dest->name);
-                CHECK_NULL_NOMEM_GOTO(module_name, rc, cleanup);
+    return rc;
+}
 
-                rc = sr_list_insert_unique_ord(*required_modules, module_name, dm_string_cmp, &inserted);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
 
-                /* if dep has instanced id and it was inserted call recursively */
-                if (inserted && NULL != dep->dest->inst_ids->first) {
-                    rc = dm_get_data_info_internal(dm_ctx, session, dep->dest->name, true, &must_be_freed, &recursive_info);
-                    CHECK_RC_LOG_GOTO(rc, cleanup, "Get data info failed for %s", dep->dest->name);
+/**
+ * @brief Function deletes data that do not belong to the main module and was added due to
+ * validation of cross-module dependant data
+ *
+ * @param [in] session
+ * @param [in] data_info
+ *
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_remove_added_data_trees(dm_session_t *session, dm_data_info_t *data_info)
+{
+    CHECK_NULL_ARG2(session, data_info);
+    if (NULL != data_info->node) {
+        if (data_info->schema->module != LYS_MAIN_MODULE(data_info->node->schema)) {
+            /* verify that the module referencing others has some data */
+            lyd_free_withsiblings(data_info->node);
+            data_info->node = NULL;
+            return SR_ERR_OK;
+        }
+        const struct lys_module *module = data_info->node->schema->module;
+        struct lyd_node *n = data_info->node;
+        struct lyd_node *tmp = NULL;
 
-                    rc = dm_requires_tmp_context(dm_ctx, session, recursive_info, required_data, required_modules);
-                    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to resolve recusrive deps in %s", recursive_info->schema->module_name);
+        while (n) {
+           tmp = n;
+           n = n->next;
+           if (module != tmp->schema->module) {
+              lyd_free(tmp);
+           }
+        }
+    }
+    return SR_ERR_OK;
+}
 
-                    if (must_be_freed) {
-                        dm_data_info_free(recursive_info);
-                    }
-                } else if (!inserted){
-                    free(module_name);
-                }
-            }
+/**
+ * @brief Collects names of the modules whose data are referenced by the data of the module
+ * (dependencies known since installation time).
+ *
+ * @param [in] dm_ctx
+ * @param [in] info
+ * @param [out] modules - list of module names, to be freed by ::sr_free_list_of_strings
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_get_dependant_modules(dm_ctx_t *dm_ctx, dm_data_info_t *info, sr_list_t **modules)
+{
+    CHECK_NULL_ARG3(dm_ctx, info, modules);
+    sr_llist_node_t *ll_node = NULL;
+    md_module_t *module = NULL;
+    md_dep_t *dep = NULL;
+    sr_list_t *names = NULL;
+    char *name = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = sr_list_init(&names);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
 
+    md_ctx_lock(dm_ctx->md_ctx, false);
+    rc = md_get_module_info(dm_ctx->md_ctx, info->schema->module_name, NULL, NULL, &module);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Unable to get the list of dependencies for module '%s'.", info->schema->module_name);
+    ll_node = module->deps->first;
+    while (ll_node) {
+        dep = (md_dep_t *)ll_node->data;
+        if (MD_DEP_DATA == dep->type && dep->dest->implemented && dep->dest->has_data) {
+            name = strdup(dep->dest->name);
+            CHECK_NULL_NOMEM_GOTO(name, rc, cleanup);
+            rc = sr_list_add(names, name);
+            if (SR_ERR_OK != rc) {
+                free(name);
+                goto cleanup;
+            }
         }
-        goto cleanup;
+        ll_node = ll_node->next;
     }
 
+cleanup:
+    md_ctx_unlock(dm_ctx->md_ctx);
+    if (SR_ERR_OK != rc) {
+        sr_free_list_of_strings(names);
+        names = NULL;
+    }
+    *modules = names;
+    return rc;
+}
 
-    rc = md_get_module_info(dm_ctx->md_ctx, di->schema->module_name, NULL, NULL, &module);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to retrieve md info for %s module", di->schema->module_name);
+/**
+ * @brief Append all dependant data.
+ *
+ * @param [in] dm_ctx
+ * @param [in] session
+ * @param [in] info
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_load_dependant_data(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *info)
+{
+    CHECK_NULL_ARG3(dm_ctx, session, info);
+    sr_list_t *modules = NULL;
+    int rc = SR_ERR_OK;
 
-    /* loop through instance ids */
-    ll_node = module->inst_ids->first;
+    /* remove previously appended data */
+    rc = dm_remove_added_data_trees(session, info);
+    CHECK_RC_MSG_RETURN(rc, "Removing of added data trees failed");
 
-    while (ll_node) {
-        id = (md_subtree_ref_t *) ll_node->data;
-        ll_node = ll_node->next;
+    if (info->schema->cross_module_data_dependency) {
+        rc = dm_get_dependant_modules(dm_ctx, info, &modules);
+        CHECK_RC_MSG_RETURN(rc, "Failed to collect dependant modules");
 
-        rc = sr_find_schema_node(di->schema->module, NULL, id->xpath, 0, &set);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR("Sch node not found for xpath %s", id->xpath);
-            rc = SR_ERR_INTERNAL;
-            goto cleanup;
+        for (size_t i = 0; i < modules->count; i++) {
+            const char *dependant_module = (const char *) modules->data[i];
+            rc = dm_append_data_tree(session->dm_ctx, session, info, dependant_module);
+            CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to append data tree %s", dependant_module);
+            SR_LOG_DBG("Data tree %s appended because of validation", dependant_module);
         }
+    }
 
-        sch_node = set->set.s[0];
-        ly_set_free(set);
-        set = NULL;
+cleanup:
+    sr_free_list_of_strings(modules);
+    return rc;
+}
 
-        /* find instance id nodes and check their content */
-        if (di->node == NULL || (set = lyd_find_instance(di->node, sch_node)) == NULL) {
-            continue;
-        }
+int
+dm_init(ac_ctx_t *ac_ctx, np_ctx_t *np_ctx, pm_ctx_t *pm_ctx, const cm_connection_mode_t conn_mode,
+        const char *schema_search_dir, const char *data_search_dir, dm_ctx_t **dm_ctx)
+{
+    CHECK_NULL_ARG3(schema_search_dir, data_search_dir, dm_ctx);
 
-        /* loop through instance id nodes */
-        for (unsigned int i = 0; i < set->number; i++) {
-            id_val = ((struct lyd_node_leaf_list *) set->set.d[i])->value_str;
+    SR_LOG_INF("Initializing Data Manager, schema_search_dir=%s, data_search_dir=%s", schema_search_dir, data_search_dir);
 
-            rc = sr_copy_first_ns(id_val, &namespace);
-            CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to retrieve first namespace from %s", id_val);
+    dm_ctx_t *ctx = NULL;
+    dm_tmp_ly_ctx_t *t_ctx = NULL;
+    int rc = SR_ERR_OK;
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    char *internal_schema_search_dir = NULL, *internal_data_search_dir = NULL;
+    ctx = calloc(1, sizeof(*ctx));
+    CHECK_NULL_NOMEM_GOTO(ctx, rc, cleanup);
+    ctx->ac_ctx = ac_ctx;
+    ctx->np_ctx = np_ctx;
+    ctx->pm_ctx = pm_ctx;
+    ctx->conn_mode = conn_mode;
+    ctx->data_load_threads = SR_DATA_LOAD_THREADS;
 
-            /* Test if it is among known dependencies */
-            if (0 == strcmp(namespace, di->schema->module_name)) {
-                free(namespace);
-                namespace = NULL;
-                continue;
-            }
+    ly_set_log_clb(dm_ly_log_cb, 1);
 
-            ll_dep = module->deps->first;
-            bool found = false;
+    ctx->schema_search_dir = strdup(schema_search_dir);
+    CHECK_NULL_NOMEM_GOTO(ctx->schema_search_dir, rc, cleanup);
 
-            while (ll_dep) {
-               dep = (md_dep_t *) ll_dep->data;
-               ll_dep = ll_dep->next;
+    ctx->data_search_dir = strdup(data_search_dir);
+    CHECK_NULL_NOMEM_GOTO(ctx->data_search_dir, rc, cleanup);
 
-               if (0 == strcmp(namespace, dep->dest->name)) {
-                   found = true;
-                   free(namespace);
-                   namespace = NULL;
-                   break;
-               }
-            }
-            /* else append to required modules */
-            if (!found) {
-                if (NULL == *required_modules) {
-                    rc = sr_list_init(required_modules);
-                    CHECK_RC_MSG_GOTO(rc, cleanup, "List initialization failed");
+    ctx->ds_lock = calloc(DM_DATASTORE_COUNT, sizeof(*ctx->ds_lock));
+    CHECK_NULL_NOMEM_GOTO(ctx->ds_lock, rc, cleanup);
 
-                    if (required_data) {
-                        rc = sr_list_init(required_data);
-                        CHECK_RC_MSG_GOTO(rc, cleanup, "List initialization failed");
-                    }
+    rc = sr_locking_set_init(&ctx->locking_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Locking set init failed");
 
-                    /* insert module itself */
-                    module_name = strdup(di->schema->module_name);
-                    CHECK_NULL_NOMEM_GOTO(module_name, rc, cleanup);
+#if defined(HAVE_PTHREAD_RWLOCKATTR_SETKIND_NP)
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
 
-                    rc = sr_list_insert_unique_ord(*required_modules, module_name, dm_string_cmp, &inserted);
-                    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
+    rc = pthread_rwlock_init(&ctx->schema_tree_lock, &attr);
+    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "lyctx mutex initialization failed");
 
-                    if (required_data) {
-                        rc = sr_list_add(*required_data, module_name);
-                        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
-                    }
+    rc = sr_btree_init(dm_schema_info_cmp, dm_free_schema_info, &ctx->schema_info_tree);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Schema binary tree allocation failed");
 
-                    /* add installation time dependencies */
-                    ll_dep = module->deps->first;
-                    while (ll_dep) {
-                        dep = (md_dep_t *) ll_dep->data;
-                        ll_dep = ll_dep->next;
+    rc = sr_btree_init(dm_c_ctx_id_cmp, dm_free_commit_context, &ctx->commit_ctxs.tree);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit context binary tree initialization failed");
 
-                        module_name = strdup(dep->dest->name);
-                        CHECK_NULL_NOMEM_GOTO(module_name, rc, cleanup);
+    rc = pthread_rwlock_init(&ctx->commit_ctxs.lock, &attr);
+    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "c_ctxs_lock init failed");
 
-                        rc = sr_list_insert_unique_ord(*required_modules, module_name, dm_string_cmp, &inserted);
-                        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
+    rc = pthread_mutex_init(&ctx->commit_ctxs.empty_mutex, NULL);
+    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "c_ctxs_empty_mutex init failed");
 
-                        if (inserted && dep->dest->has_data && required_data) {
-                            rc = sr_list_add(*required_data, module_name);
-                            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to add item into the list");
-                        }
+    rc = pthread_cond_init(&ctx->commit_ctxs.empty_cond, NULL);
+    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "c_ctxs_empty_cond init failed");
 
-                        /* if dep has instanced id and it was inserted call recursively */
-                        if (inserted && NULL != dep->dest->inst_ids->first) {
-                            rc = dm_get_data_info_internal(dm_ctx, session, dep->dest->name, true, &must_be_freed, &recursive_info);
-                            CHECK_RC_LOG_GOTO(rc, cleanup, "Get data info failed for %s", dep->dest->name);
+    ctx->commit_ctxs.empty = true;
 
-                            rc = dm_requires_tmp_context(dm_ctx, session, recursive_info, required_data, required_modules);
-                            CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to resolve recusrive deps in %s", recursive_info->schema->module_name);
+    rc = sr_btree_init(dm_coalesced_commit_cmp, dm_coalesced_commit_free, &ctx->coalesced_commits);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Coalesced commits binary tree initialization failed");
 
-                            if (must_be_freed) {
-                                dm_data_info_free(recursive_info);
-                            }
-                        } else if (!inserted){
-                            free(module_name);
-                        }
-                    }
-                }
-                inserted = false;
-                rc = sr_list_insert_unique_ord(*required_modules, namespace, dm_string_cmp, &inserted);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
-                inserted_namespace = namespace;
-                namespace = NULL; /* do not free namespace in this function case of cleanup */
+    rc = pthread_mutex_init(&ctx->coalesce_lock, NULL);
+    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "coalesce_lock init failed");
 
-                if (inserted) {
-                    if (required_data) {
-                        rc = sr_list_add(*required_data, inserted_namespace);
-                        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert an item into the list");
-                    }
+    rc = sr_str_join(schema_search_dir, "internal", &internal_schema_search_dir);
+    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "sr_str_join failed");
+    rc = sr_str_join(data_search_dir, "internal", &internal_data_search_dir);
+    CHECK_ZERO_MSG_GOTO(rc, rc, SR_ERR_INTERNAL, cleanup, "sr_str_join failed");
 
-                    /* call recursively */
-                    rc = dm_get_data_info_internal(dm_ctx, session, inserted_namespace, true, &must_be_freed, &recursive_info);
-                    CHECK_RC_LOG_GOTO(rc, cleanup, "Get data info failed for %s", inserted_namespace);
+    rc = md_init(schema_search_dir, internal_schema_search_dir,
+                 internal_data_search_dir, false, &ctx->md_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to initialize Module Dependencies context.");
+    ctx->internal_data_search_dir = internal_data_search_dir;
+    internal_data_search_dir = NULL;
 
-                    rc = dm_requires_tmp_context(dm_ctx, session, recursive_info, required_data, required_modules);
-                    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to resolve recusrive deps in %s", recursive_info->schema->module_name);
+#ifdef SHARED_LY_CTX
+    md_ctx_lock(ctx->md_ctx, false);
+    rc = dm_shared_ly_ctx_new(ctx, 1, &ctx->shared_ly_ctx);
+    md_ctx_unlock(ctx->md_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to initialize the shared libyang context.");
+#endif
 
-                    if (must_be_freed) {
-                        dm_data_info_free(recursive_info);
-                    }
-                }
-            }
-        }
-        ly_set_free(set);
-        set = NULL;
+#ifdef ENABLE_NACM
+    if (CM_MODE_DAEMON == conn_mode) {
+        rc = nacm_init(ctx, ctx->data_search_dir, &ctx->nacm_ctx);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to initialize NACM context.");
+    } else {
+        SR_LOG_INF_MSG("Sysrepo is running in the local mode => NACM will be disabled.");
     }
+#endif
+
+    t_ctx = calloc(1, sizeof(*t_ctx));
+    CHECK_NULL_NOMEM_GOTO(t_ctx, rc, cleanup);
+
+    pthread_mutex_init(&t_ctx->mutex, NULL);
+    rc = sr_list_init(&t_ctx->loaded_modules);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to initialize a list");
+
+    t_ctx->ctx = ly_ctx_new(ctx->schema_search_dir, LY_CTX_NOYANGLIBRARY);
+    CHECK_NULL_NOMEM_GOTO(t_ctx->ctx, rc, cleanup);
+
+    ctx->tmp_ly_ctx = t_ctx;
+    t_ctx = NULL;
+
+    *dm_ctx = ctx;
 
 cleanup:
+    free(internal_schema_search_dir);
+    free(internal_data_search_dir);
+    pthread_rwlockattr_destroy(&attr);
     if (SR_ERR_OK != rc) {
-        sr_free_list_of_strings(*required_modules);
-        *required_modules = NULL;
+        dm_cleanup(ctx);
+        dm_free_tmp_ly_ctx(t_ctx);
     }
-    free(namespace);
-    ly_set_free(set);
-    md_ctx_unlock(dm_ctx->md_ctx);
     return rc;
+
 }
 
-/**
- * @brief Validates one data_info_t record. It might temporarily load also different data
- * if there is cross_module dependency or instance id.
- */
-static int
-dm_validate_data_info(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *info)
+void
+dm_cleanup(dm_ctx_t *dm_ctx)
 {
-    CHECK_NULL_ARG3(dm_ctx, session, info);
-    int rc = SR_ERR_OK;
-    sr_list_t *required_data = NULL;
-    sr_list_t *data_for_validation = NULL;
-    dm_tmp_ly_ctx_t *tmp_ctx = NULL;
-    dm_data_info_t *dep_di = NULL;
-    const struct lys_module *mod;
-    struct lyd_node *data_tree = NULL;
-    bool validation_failed = false;
-    bool *should_be_freed = NULL;
-
-    /* cleanup the list of dependant modules */
-    sr_free_list_of_strings(info->required_modules);
-    info->required_modules = NULL;
-
-    if (NULL == info->schema->module || NULL == info->schema->module->name) {
-        SR_LOG_ERR_MSG("Missing schema information");
-        rc = SR_ERR_INTERNAL;
-        goto cleanup;
+    if (NULL != dm_ctx) {
+        nacm_cleanup(dm_ctx->nacm_ctx);
+        sr_btree_cleanup(dm_ctx->coalesced_commits);
+        sr_btree_cleanup(dm_ctx->commit_ctxs.tree);
+        free(dm_ctx->schema_search_dir);
+        free(dm_ctx->data_search_dir);
+        free(dm_ctx->internal_data_search_dir);
+        free(dm_ctx->ds_lock);
+        sr_btree_cleanup(dm_ctx->schema_info_tree);
+#ifdef SHARED_LY_CTX
+        dm_shared_ly_ctx_release(dm_ctx->shared_ly_ctx);
+#endif
+        md_destroy(dm_ctx->md_ctx);
+        pthread_rwlock_destroy(&dm_ctx->schema_tree_lock);
+        sr_locking_set_cleanup(dm_ctx->locking_ctx);
+        pthread_mutex_destroy(&dm_ctx->ds_lock_mutex);
+        pthread_rwlock_destroy(&dm_ctx->commit_ctxs.lock);
+        pthread_mutex_destroy(&dm_ctx->commit_ctxs.empty_mutex);
+        pthread_cond_destroy(&dm_ctx->commit_ctxs.empty_cond);
+        pthread_mutex_destroy(&dm_ctx->coalesce_lock);
+        dm_free_tmp_ly_ctx(dm_ctx->tmp_ly_ctx);
+        free(dm_ctx);
     }
+}
 
-    /* attach data dependant modules */
-    if (info->schema->has_instance_id || info->schema->cross_module_data_dependency) {
-
-        rc = dm_requires_tmp_context(dm_ctx, session, info, &required_data, &info->required_modules);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "Require tmp ctx check failed for module %s", info->schema->module_name);
-
-        if (NULL == info->required_modules) {
-            /* only dependencies know since installation time are needed */
-            rc = dm_load_dependant_data(dm_ctx, session, info);
-            CHECK_RC_LOG_GOTO(rc, cleanup, "Loading dependant modules failed for %s", info->schema->module_name);
-
-            if (0 != lyd_validate_modules(&info->node, &info->schema->module, 1, LYD_OPT_STRICT | LYD_OPT_WHENAUTODEL | LYD_OPT_CONFIG)) {
-                SR_LOG_DBG("Validation failed for %s module", info->schema->module->name);
-                validation_failed = true;
-            } else {
-                SR_LOG_DBG("Validation succeeded for '%s' module", info->schema->module->name);
-            }
-            if (info->schema->cross_module_data_dependency) {
-                /* remove data appended from other modules for the purpose of validation */
-                rc = dm_remove_added_data_trees(session, info);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "Removing of added data trees failed");
-            }
-        } else {
-            /* validate using tmp ly_ctx */
-
-            rc = sr_list_init(&data_for_validation);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
-
-            /* if requested data has not be loaded into the session yet, the validation is skipped
-             * it is only appended to the validated data_info and removed afterwards. we have to track
-             * which data should be freed and which not */
-            should_be_freed = calloc(required_data->count, sizeof(*should_be_freed));
-            CHECK_NULL_NOMEM_GOTO(should_be_freed, rc, cleanup);
-
-            /* retrieve all required data */
-            for (size_t i = 0; i < required_data->count; i++) {
-                SR_LOG_DBG("To pass the validation of '%s' data from module %s is needed", info->schema->module_name, (char *) required_data->data[i]);
-                rc = dm_get_data_info_internal(dm_ctx, session, (char *) required_data->data[i], true, &should_be_freed[i], &dep_di);
-                CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to get data infor for module %s", (char *) required_data->data[i]);
-
-                rc = sr_list_add(data_for_validation, dep_di);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "List insert failed");
-            }
+void
+dm_set_data_load_threads(dm_ctx_t *dm_ctx, size_t thread_cnt)
+{
+    if (NULL != dm_ctx) {
+        dm_ctx->data_load_threads = 0 < thread_cnt ? thread_cnt : 1;
+    }
+}
 
-            /* prepare working context*/
-            rc = dm_get_tmp_ly_ctx(dm_ctx, info->required_modules, &tmp_ctx);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to acquire tmp ctx");
+int
+dm_session_start(dm_ctx_t *dm_ctx, const ac_ucred_t *user_credentials, const sr_datastore_t ds, dm_session_t **dm_session_ctx)
+{
+    CHECK_NULL_ARG(dm_session_ctx);
 
-            /* get module from tmp_ctx */
-            mod = ly_ctx_get_module(tmp_ctx->ctx, info->schema->module->name, NULL, 1);
-            if (!mod) {
-                SR_LOG_ERR("Failed to find module '%s' in temtporary context", info->schema->module->name);
-                goto cleanup;
-            }
+    dm_session_t *session_ctx = NULL;
+    session_ctx = calloc(1, sizeof(*session_ctx));
+    CHECK_NULL_NOMEM_RETURN(session_ctx);
+    session_ctx->dm_ctx = dm_ctx;
+    session_ctx->user_credentials = user_credentials;
+    session_ctx->datastore = ds;
 
-            /* migrate data to working context */
-            for (size_t i = 0; i < data_for_validation->count; i++) {
-                dm_data_info_t *d = (dm_data_info_t *) data_for_validation->data[i];
-                if (NULL != d->node) {
-                    if (NULL == data_tree) {
-                        data_tree = sr_dup_datatree_to_ctx(d->node, tmp_ctx->ctx);
-                    } else {
-                        int ret = lyd_merge_to_ctx(&data_tree, d->node, LYD_OPT_EXPLICIT, tmp_ctx->ctx);
-                        CHECK_ZERO_LOG_GOTO(ret, rc, SR_ERR_INTERNAL, cleanup, "Failed to merge data tree '%s'", d->schema->module_name);
-                    }
-                }
-                if (should_be_freed[i]) {
-                    dm_data_info_free(d);
-                }
-            }
+    int rc = SR_ERR_OK;
+    session_ctx->session_modules = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->session_modules));
+    CHECK_NULL_NOMEM_GOTO(session_ctx->session_modules, rc, cleanup);
 
-            /* start validation */
-            if (0 != lyd_validate_modules(&data_tree, &mod, 1, LYD_OPT_STRICT | LYD_OPT_WHENAUTODEL | LYD_OPT_CONFIG)) {
-                SR_LOG_DBG("Validation failed for %s module", info->schema->module->name);
-                validation_failed = true;
-            } else {
-                SR_LOG_DBG("Validation succeeded for '%s' module", info->schema->module->name);
-            }
+    for (size_t i = 0; i < DM_DATASTORE_COUNT; i++) {
+        rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &session_ctx->session_modules[i]);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Session module binary tree init failed");
+    }
 
-            /* remove data from different modules and replace data in data_info to have default nodes in place */
-            rc = dm_remove_added_data_trees_by_module_name(info->schema->module_name, &data_tree);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to remove added data trees");
+    rc = sr_list_init(&session_ctx->locked_files);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
 
-            lyd_free_withsiblings(info->node);
+    session_ctx->holds_ds_lock = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->holds_ds_lock));
+    CHECK_NULL_NOMEM_GOTO(session_ctx->holds_ds_lock, rc, cleanup);
+    session_ctx->operations = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->operations));
+    CHECK_NULL_NOMEM_GOTO(session_ctx->operations, rc, cleanup);
+    session_ctx->oper_count = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->oper_count));
+    CHECK_NULL_NOMEM_GOTO(session_ctx->oper_count, rc, cleanup);
+    session_ctx->oper_size = calloc(DM_DATASTORE_COUNT, sizeof(*session_ctx->oper_size));
+    CHECK_NULL_NOMEM_GOTO(session_ctx->oper_size, rc, cleanup);
 
-            info->node = sr_dup_datatree_to_ctx(data_tree, info->schema->ly_ctx);
-        }
-    } else {
-        if (0 != lyd_validate_modules(&info->node, &info->schema->module, 1, LYD_OPT_STRICT | LYD_OPT_WHENAUTODEL | LYD_OPT_CONFIG)) {
-            SR_LOG_DBG("Validation failed for %s module", info->schema->module->name);
-            validation_failed = true;
-        } else {
-            SR_LOG_DBG("Validation succeeded for '%s' module", info->schema->module->name);
-        }
-    }
 
 cleanup:
-    sr_list_cleanup(required_data);
-    sr_list_cleanup(data_for_validation);
-    free(should_be_freed);
-    lyd_free_withsiblings(data_tree);
-    if (tmp_ctx) {
-        dm_release_tmp_ly_ctx(dm_ctx, tmp_ctx);
-    }
-    if (validation_failed) {
-        rc = SR_ERR_VALIDATION_FAILED;
+    if (SR_ERR_OK == rc) {
+        *dm_session_ctx = session_ctx;
+    } else {
+        dm_session_stop((dm_ctx_t *) dm_ctx, session_ctx);
     }
     return rc;
 }
 
-/**
- * @note if skip_validation is false, must_be_freed will not be set to true
- */
-static int
-dm_get_data_info_internal(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, bool skip_validation, bool *must_be_freed, dm_data_info_t **info)
+void
+dm_session_stop(dm_ctx_t *dm_ctx, dm_session_t *session)
 {
-    int rc = SR_ERR_OK;
-    dm_data_info_t *exisiting_data_info = NULL;
-    dm_schema_info_t *schema_info = NULL;
-
-    rc = dm_get_module_and_lock(dm_ctx, module_name, &schema_info);
-    CHECK_RC_LOG_RETURN(rc, "Get module '%s' failed", module_name);
-
-    dm_data_info_t lookup_data = {0};
-    lookup_data.schema = schema_info;
-    exisiting_data_info = sr_btree_search(dm_session_ctx->session_modules[dm_session_ctx->datastore], &lookup_data);
-
-    if (NULL != must_be_freed) {
-        *must_be_freed = false;
-    }
-
-    if (NULL != exisiting_data_info) {
-        *info = exisiting_data_info;
-        SR_LOG_DBG("Module %s already loaded", module_name);
-        goto cleanup;
+    CHECK_NULL_ARG_VOID2(dm_ctx, session);
+    if (NULL != session->locked_files) {
+        dm_unlock_datastore(dm_ctx, session);
+        sr_list_cleanup(session->locked_files);
     }
-
-    /* session copy not found load it from file system */
-    dm_data_info_t *di = NULL;
-    if (SR_DS_CANDIDATE == dm_session_ctx->datastore) {
-        rc = dm_load_data_tree(dm_ctx, dm_session_ctx, schema_info, SR_DS_RUNNING, &di);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "Getting data tree for %s failed.", module_name);
-        rc = dm_remove_not_enabled_nodes(di);
-        if (SR_ERR_OK != rc) {
-            dm_data_info_free(di);
-            SR_LOG_ERR("Removing of not enabled nodes in model %s failed", di->schema->module->name);
-            goto cleanup;
-        }
+    for (size_t i = 0; i < DM_DATASTORE_COUNT; i++) {
+        sr_btree_cleanup(session->session_modules[i]);
     }
-    else {
-        rc = dm_load_data_tree(dm_ctx, dm_session_ctx, schema_info, dm_session_ctx->datastore, &di);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "Getting data tree for %s failed.", module_name);
+    free(session->session_modules);
+    dm_clear_session_errors(session);
+    for (size_t i = 0; i < DM_DATASTORE_COUNT; i++) {
+        dm_free_sess_operations(session->operations[i], session->oper_count[i]);
     }
+    free(session->holds_ds_lock);
+    free(session->operations);
+    free(session->oper_count);
+    free(session->oper_size);
+    free(session);
+}
 
-    if (!skip_validation) {
-        if (di->schema->cross_module_data_dependency || di->schema->has_instance_id) {
-            /* do the validation that was skipped, mainly to add default nodes */
-            rc = dm_validate_data_info(dm_ctx, dm_session_ctx, di);
-            /* validation might fails on rare occasion - working copy of dependant module was
-             * already modified i.e.: referenced node was deleted. Thus errors are ignored. */
-            if (SR_ERR_OK != rc) {
-                SR_LOG_WRN("Validation of module with instance_id or cross-module deps %s failed", di->schema->module_name);
+/**
+ * @brief Removes not enabled leaves from data tree.
+ *
+ * @note Function expects that a schema info is locked for reading.
+ *
+ * @param [in] info
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_remove_not_enabled_nodes(dm_data_info_t *info)
+{
+    CHECK_NULL_ARG(info);
+    struct lyd_node *iter = NULL, *child = NULL, *next = NULL;
+    sr_list_t *stack = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = sr_list_init(&stack);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
+
+    /* iterate through top-level nodes */
+    LY_TREE_FOR_SAFE(info->node, next, iter)
+    {
+        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
+            if (dm_is_node_enabled(iter->schema)) {
+                if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
+                    LY_TREE_FOR(iter->child, child)
+                    {
+                        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype) && dm_is_node_enabled(child->schema)) {
+                            rc = sr_list_add(stack, child);
+                            CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+                        }
+                    }
+                }
+            } else {
+                sr_lyd_unlink(info, iter);
+                lyd_free_withsiblings(iter);
             }
-        }
-        /* we do not insert data_info_t if it was loaded only as auxiliary cause of validation */
-        rc = sr_btree_insert(dm_session_ctx->session_modules[dm_session_ctx->datastore], (void *) di);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR("Insert into session avl failed module %s", module_name);
-            dm_data_info_free(di);
-            goto cleanup;
-        }
 
-    } else {
-        if (NULL != must_be_freed) {
-            /* let the caller know that he has to free the content */
-            *must_be_freed = true;
         }
     }
 
+    while (stack->count != 0) {
+        iter = stack->data[stack->count - 1];
+        if (dm_is_node_enabled(iter->schema)) {
+            if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
 
-    SR_LOG_DBG("Module %s has been loaded", module_name);
-    *info = di;
+                LY_TREE_FOR(iter->child, child)
+                {
+                    if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
+                        rc = sr_list_add(stack, child);
+                        CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+                    }
+                }
+            }
+        } else {
+            sr_lyd_unlink(info, iter);
+            lyd_free_withsiblings(iter);
+        }
+        sr_list_rm(stack, iter);
+    }
 
 cleanup:
-    pthread_rwlock_unlock(&schema_info->model_lock);
+    sr_list_cleanup(stack);
     return rc;
 }
 
-int
-dm_get_data_info(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, dm_data_info_t **info)
-{
-    CHECK_NULL_ARG4(dm_ctx, dm_session_ctx, module_name, info);
-    return dm_get_data_info_internal(dm_ctx, dm_session_ctx, module_name, false, NULL, info);
-}
-
-int
-dm_get_datatree(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, struct lyd_node **data_tree)
-{
-    CHECK_NULL_ARG4(dm_ctx, dm_session_ctx, module_name, data_tree);
-    int rc = SR_ERR_OK;
-    dm_data_info_t *info = NULL;
-    rc = dm_get_data_info(dm_ctx, dm_session_ctx, module_name, &info);
-    CHECK_RC_LOG_RETURN(rc, "Get data info failed for module %s", module_name);
-    *data_tree = info->node;
-    if (NULL == info->node) {
-        return SR_ERR_NOT_FOUND;
-    }
-    return rc;
-}
 
+/**
+ * @brief Test if there is not enabled leaf in the provided data tree
+ *
+ * @note Function expects that a schema info is locked for reading.
+ *
+ * @param [in] info
+ * @param [out] res
+ * @return Error code (SR_ERR_OK on success)
+ */
 static int
-dm_get_module_internal(dm_ctx_t *dm_ctx, const char *module_name, bool lock, bool write, dm_schema_info_t **schema_info)
+dm_has_not_enabled_nodes(dm_data_info_t *info, bool *res)
 {
-    CHECK_NULL_ARG3(dm_ctx, module_name, schema_info);
-
+    CHECK_NULL_ARG2(info, res);
+    struct lyd_node *iter = NULL, *child = NULL, *next = NULL;
+    sr_list_t *stack = NULL;
     int rc = SR_ERR_OK;
-    dm_schema_info_t lookup = {0};
-    dm_schema_info_t *sch_info = NULL;
-
-    lookup.module_name = (char *) module_name;
-    RWLOCK_RDLOCK_TIMED_CHECK_RETURN(&dm_ctx->schema_tree_lock);
-    sch_info = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
 
-    if (NULL != sch_info) {
-        /* there is matching item in schema info tree */
-        if (lock) {
+    rc = sr_list_init(&stack);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
 
-            if (write) {
-                RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
+    /* iterate through top-level nodes */
+    LY_TREE_FOR_SAFE(info->node, next, iter)
+    {
+        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
+            if (dm_is_node_enabled(iter->schema) || iter->dflt) {
+                if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
+                    LY_TREE_FOR(iter->child, child)
+                    {
+                        if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
+                            rc = sr_list_add(stack, child);
+                            CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+                        }
+                    }
+                }
             } else {
-                RWLOCK_RDLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
-            }
-
-            if (NULL == sch_info->ly_ctx) {
-                SR_LOG_DBG("Module %s has been uninstalled", sch_info->module_name);
-                pthread_rwlock_unlock(&sch_info->model_lock);
-                rc = SR_ERR_UNKNOWN_MODEL;
+                SR_LOG_DBG("Found not enabled node %s in module %s", iter->schema->name, iter->schema->module->name);
+                *res = true;
                 goto cleanup;
             }
+
         }
-        *schema_info = sch_info;
-        goto cleanup;
-    } else {
-        /* try to load schema */
-        pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
-        rc = dm_load_module(dm_ctx, module_name, NULL, &sch_info);
-        if (SR_ERR_OK == rc && lock) {
-            if (write) {
-                RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
-            } else {
-                RWLOCK_RDLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
-            }
+    }
 
-            if (NULL == sch_info->ly_ctx) {
-                SR_LOG_DBG("Module %s has been uninstalled", sch_info->module_name);
-                pthread_rwlock_unlock(&sch_info->model_lock);
-                rc = SR_ERR_UNKNOWN_MODEL;
-            } else {
-                *schema_info = sch_info;
-            }
+    while (stack->count != 0) {
+        iter = stack->data[stack->count - 1];
+        if (dm_is_node_enabled(iter->schema) || iter->dflt) {
+            if (!dm_is_node_enabled_with_children(iter->schema) && (LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
 
+                LY_TREE_FOR(iter->child, child)
+                {
+                    if (((LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST) & iter->schema->nodetype)) {
+                        rc = sr_list_add(stack, child);
+                        CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+                    }
+                }
+            }
+        } else {
+            SR_LOG_DBG("Found not enabled node %s in module %s", iter->schema->name, iter->schema->module->name);
+            *res = true;
+            goto cleanup;
         }
+        sr_list_rm(stack, iter);
     }
-
-    return rc;
+    *res = false;
 
 cleanup:
-    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+    sr_list_cleanup(stack);
     return rc;
 }
 
-int
-dm_get_module_and_lockw(dm_ctx_t *dm_ctx, const char *module_name, dm_schema_info_t **schema_info)
+static int
+dm_string_cmp(void *a, void *b)
 {
-    return dm_get_module_internal(dm_ctx, module_name, true, true, schema_info);
-}
+    assert(a);
+    assert(b);
+
+    int result = strcmp(a, b);
+    if (result < 0) {
+        return -1;
+    } else if (result > 0) {
+        return 1;
+    } else {
+        return 0;
+    }
 
-int
-dm_get_module_and_lock(dm_ctx_t *dm_ctx, const char *module_name, dm_schema_info_t **schema_info)
-{
-    return dm_get_module_internal(dm_ctx, module_name, true, false, schema_info);
-}
-
-int
-dm_get_module_without_lock(dm_ctx_t *dm_ctx, const char *module_name, dm_schema_info_t **schema_info)
-{
-    CHECK_NULL_ARG3(dm_ctx, module_name, schema_info);
-    int rc = SR_ERR_OK;
-
-    rc = dm_get_module_and_lock(dm_ctx, module_name, schema_info);
-    if (SR_ERR_OK == rc) {
-        pthread_rwlock_unlock(&(*schema_info)->model_lock);
-    }
-    return rc;
-}
-
-static int
-dm_list_rev_file(dm_ctx_t *dm_ctx, sr_mem_ctx_t *sr_mem, const char *module_name, const char *rev_date, sr_sch_revision_t *rev)
-{
-    CHECK_NULL_ARG3(dm_ctx, module_name, rev);
-    int rc = SR_ERR_OK;
-    char *file_name = NULL;
-
-    if (NULL != rev_date && 0 != strcmp("", rev_date)) {
-        sr_mem_edit_string(sr_mem, (char **)&rev->revision, rev_date);
-        CHECK_NULL_NOMEM_GOTO(rev->revision, rc, cleanup);
-    }
-
-    rc = sr_get_schema_file_name(dm_ctx->schema_search_dir, module_name, rev_date, true, &file_name);
-    if (SR_ERR_OK == rc) {
-        if (-1 != access(file_name, F_OK)) {
-            rc = sr_mem_edit_string(sr_mem, (char **)&rev->file_path_yang, file_name);
-        }
-    }
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Get schema file name failed");
-
-    free(file_name);
-    file_name = NULL;
-
-    rc = sr_get_schema_file_name(dm_ctx->schema_search_dir, module_name, rev_date, false, &file_name);
-    if (SR_ERR_OK == rc) {
-        if (-1 != access(file_name, F_OK)) {
-            sr_mem_edit_string(sr_mem, (char **)&rev->file_path_yin, file_name);
-        }
-    }
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Get schema file name failed");
-
-    free(file_name);
-    return rc;
-
-cleanup:
-    free(file_name);
-    if (NULL == sr_mem) {
-        free((void*) rev->revision);
-        free((void*) rev->file_path_yang);
-        free((void*) rev->file_path_yin);
-    }
-    return rc;
 }
 
 /**
- * @brief Fills the schema_t structure for one module all its revisions and submodules
+ * @brief Tests if the data requires some schemas to pass the validation. If yes, it collects
+ * all required ones into the list.
+ *
  * @param [in] dm_ctx
- * @param [in] dm_session
- * @param [in] module
- * @param [in] schs
+ * @param [in] session
+ * @param [in] di
+ * @param [out] required_data - subset of modules that require also data to be loaded, the list contains the same strings as required_modules (do not free the content)
+ * @param [out] required_modules - if a module different from the installation-time dependencies is required to pass the validation
  * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_list_module(dm_ctx_t *dm_ctx, dm_session_t *dm_session, md_module_t *module, sr_schema_t *schema)
+dm_requires_tmp_context(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *di, sr_list_t **required_data, sr_list_t **required_modules)
 {
-    CHECK_NULL_ARG4(dm_ctx, dm_session, module, schema);
-    int rc = SR_ERR_OK;
-    bool module_enabled = false;
-    size_t enabled_subtrees_cnt = 0;
-    char **enabled_subtrees = NULL;
-    sr_llist_node_t *dep = NULL;
-    md_dep_t *dep_mod = NULL;
-    size_t submod_cnt = 0;
-    sr_mem_ctx_t *sr_mem = schema->_sr_mem;
+    CHECK_NULL_ARG4(dm_ctx, session, di, required_modules);
 
-    sr_mem_edit_string(sr_mem, (char **)&schema->module_name, module->name);
-    CHECK_NULL_NOMEM_GOTO(schema->module_name, rc, cleanup);
+    int rc = SR_ERR_OK;
+    md_module_t *module = NULL;
+    sr_llist_node_t *ll_node = NULL;
+    md_subtree_ref_t *id = NULL;
+    struct lys_node *sch_node = NULL;
+    struct ly_set *set = NULL;
+    const char *id_val = NULL;
+    sr_llist_node_t *ll_dep = NULL;
+    md_dep_t *dep = NULL;
+    char *namespace = NULL;
+    char *inserted_namespace = NULL;
+    bool inserted = false, must_be_freed = false;
+    char *module_name = NULL;
+    dm_data_info_t *recursive_info = NULL;
 
-    sr_mem_edit_string(sr_mem, (char **)&schema->ns, module->ns);
-    CHECK_NULL_NOMEM_GOTO(schema->ns, rc, cleanup);
+    md_ctx_lock(dm_ctx->md_ctx, false);
 
-    sr_mem_edit_string(sr_mem, (char **)&schema->prefix, module->prefix);
-    CHECK_NULL_NOMEM_GOTO(schema->prefix, rc, cleanup);
+    if (!di->schema->has_instance_id) {
+        /* if there is no instance id all dependencies are known on schema installation time */
 
-    schema->installed = module->installed;
-    schema->implemented = module->implemented;
+        if (NULL != *required_modules) {
+            /* list is already initialized that means we'll use temp ctx, append install time deps */
+            rc = md_get_module_info(dm_ctx->md_ctx, di->schema->module_name, NULL, NULL, &module);
+            CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to retrieve md info for %s module", di->schema->module_name);
 
-    rc = dm_list_rev_file(dm_ctx, sr_mem, module->name, module->revision_date, &schema->revision);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "List rev file failed module %s", module->name);
+            /* installation time dependencies */
+            ll_dep = module->deps->first;
+            while (ll_dep) {
+                dep = (md_dep_t *) ll_dep->data;
+                ll_dep = ll_dep->next;
 
-    dep = module->deps->first;
-    while (NULL != dep) {
-        dep_mod = (md_dep_t *) dep->data;
-        dep = dep->next;
-        if (!dep_mod->dest->submodule) {
-            continue;
-        }
-        submod_cnt++;
-    }
+                module_name = strdup(dep->dest->name);
+                CHECK_NULL_NOMEM_GOTO(module_name, rc, cleanup);
 
-    if (0 < submod_cnt) {
-        schema->submodules = sr_calloc(sr_mem, submod_cnt, sizeof(*schema->submodules));
-        CHECK_NULL_NOMEM_GOTO(schema->submodules, rc, cleanup);
-    }
+                rc = sr_list_insert_unique_ord(*required_modules, module_name, dm_string_cmp, &inserted);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
 
-    dep = module->deps->first;
-    size_t s = 0;
-    while (NULL != dep) {
-        dep_mod = (md_dep_t *) dep->data;
-        dep = dep->next;
-        if (!dep_mod->dest->submodule) {
-            continue;
-        }
-        sr_mem_edit_string(sr_mem, (char **)&schema->submodules[s].submodule_name, dep_mod->dest->name);
-        CHECK_NULL_NOMEM_GOTO(schema->submodules[s].submodule_name, rc, cleanup);
+                /* if dep has instanced id and it was inserted call recursively */
+                if (inserted && NULL != dep->dest->inst_ids->first) {
+                    rc = dm_get_data_info_internal(dm_ctx, session, dep->dest->name, true, true, &must_be_freed, &recursive_info);
+                    CHECK_RC_LOG_GOTO(rc, cleanup, "Get data info failed for %s", dep->dest->name);
 
-        rc = dm_list_rev_file(dm_ctx, sr_mem, dep_mod->dest->name, dep_mod->dest->revision_date, &schema->submodules[s].revision);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "List rev file failed module %s", module->name);
+                    rc = dm_requires_tmp_context(dm_ctx, session, recursive_info, required_data, required_modules);
+                    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to resolve recusrive deps in %s", recursive_info->schema->module_name);
 
-        schema->submodule_count++;
-        s++;
-    }
+                    if (must_be_freed) {
+                        dm_data_info_free(recursive_info);
+                    }
+                } else if (!inserted){
+                    free(module_name);
+                }
+            }
 
-    rc = pm_get_module_info(dm_ctx->pm_ctx, dm_session->user_credentials, module->name, sr_mem, &module_enabled,
-            &enabled_subtrees, &enabled_subtrees_cnt, &schema->enabled_features, &schema->enabled_feature_cnt);
-    if (SR_ERR_OK == rc) {
-        /* release memory */
-        for (size_t i = 0; i < enabled_subtrees_cnt; i++) {
-            free(enabled_subtrees[i]);
         }
-        free(enabled_subtrees);
-    } else {
-        /* ignore errors in pm */
-        rc = SR_ERR_OK;
+        goto cleanup;
     }
 
-cleanup:
-    if (SR_ERR_OK != rc) {
-        sr_free_schema(schema);
-    }
-    return rc;
-}
 
-int
-dm_list_schemas(dm_ctx_t *dm_ctx, dm_session_t *dm_session, sr_schema_t **schemas, size_t *schema_count)
-{
-    CHECK_NULL_ARG4(dm_ctx, dm_session, schemas, schema_count);
-    int rc = SR_ERR_OK;
-    md_module_t *module = NULL;
-    sr_llist_node_t *module_ll_node = NULL;
-    size_t i = 0;
+    rc = md_get_module_info(dm_ctx->md_ctx, di->schema->module_name, NULL, NULL, &module);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to retrieve md info for %s module", di->schema->module_name);
 
-    sr_schema_t *sch = NULL;
-    size_t sch_count = 0;
-    sr_mem_ctx_t *sr_mem = NULL;
+    /* loop through instance ids */
+    ll_node = module->inst_ids->first;
 
-    md_ctx_lock(dm_ctx->md_ctx, false);
-    module_ll_node = dm_ctx->md_ctx->modules->first;
-    while (module_ll_node) {
-        module = (md_module_t *) module_ll_node->data;
-        module_ll_node = module_ll_node->next;
-        if (module->submodule) {
-            continue;
+    while (ll_node) {
+        id = (md_subtree_ref_t *) ll_node->data;
+        ll_node = ll_node->next;
+
+        rc = sr_find_schema_node(di->schema->module, NULL, id->xpath, 0, &set);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR("Sch node not found for xpath %s", id->xpath);
+            rc = SR_ERR_INTERNAL;
+            goto cleanup;
         }
-        sch_count++;
-    }
-    if (0 == sch_count) {
-        goto cleanup;
-    }
 
-    rc = sr_mem_new(0, &sr_mem);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create a new Sysrepo memory context.");
-    sch = sr_calloc(sr_mem, sch_count, sizeof(*sch));
-    CHECK_NULL_NOMEM_GOTO(sch, rc, cleanup);
+        sch_node = set->set.s[0];
+        ly_set_free(set);
+        set = NULL;
 
-    module_ll_node = dm_ctx->md_ctx->modules->first;
-    while (module_ll_node) {
-        module = (md_module_t *) module_ll_node->data;
-        module_ll_node = module_ll_node->next;
-        if (module->submodule) {
-            /* skip submodules */
+        /* find instance id nodes and check their content, the nodes are not freed until di is */
+        if (di->node == NULL) {
+            continue;
+        }
+        dm_data_info_rdonly_lock(di);
+        set = lyd_find_instance(di->node, sch_node);
+        dm_data_info_rdonly_unlock(di);
+        if (NULL == set) {
             continue;
         }
 
-        sch[i]._sr_mem = sr_mem;
-        rc = dm_list_module(dm_ctx, dm_session, module, &sch[i]);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "List module %s failed", module->name);
+        /* loop through instance id nodes */
+        for (unsigned int i = 0; i < set->number; i++) {
+            id_val = ((struct lyd_node_leaf_list *) set->set.d[i])->value_str;
 
-        i++;
-    }
+            rc = sr_copy_first_ns(id_val, &namespace);
+            CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to retrieve first namespace from %s", id_val);
 
-cleanup:
-    md_ctx_unlock(dm_ctx->md_ctx);
-    if (SR_ERR_OK == rc) {
-        if (NULL != sr_mem) {
-            sr_mem->obj_count = 1; /* 1 for the entire array */
-        }
-        *schemas = sch;
-        *schema_count = sch_count;
-    } else {
-        sr_mem_free(sr_mem);
-    }
-    return rc;
-}
+            /* Test if it is among known dependencies */
+            if (0 == strcmp(namespace, di->schema->module_name)) {
+                free(namespace);
+                namespace = NULL;
+                continue;
+            }
 
-int
-dm_get_schema(dm_ctx_t *dm_ctx, const char *module_name, const char *module_revision, const char *submodule_name, const char *submodule_revision, bool yang_format, char **schema)
-{
-    CHECK_NULL_ARG2(dm_ctx, schema);
-    int rc = SR_ERR_OK;
-    int ret = 0;
-    dm_schema_info_t *si = NULL;
-    const struct lys_module *module = NULL;
-    md_module_t *md_module = NULL;
-    sr_llist_node_t *dep_node = NULL;
-    md_dep_t *dependency = NULL;
-    const char *main_module = module_name;
+            ll_dep = module->deps->first;
+            bool found = false;
 
-    SR_LOG_INF("Get schema '%s', revision: '%s', submodule: '%s', submodule revision: '%s'", module_name, module_revision, submodule_name, submodule_revision);
+            while (ll_dep) {
+               dep = (md_dep_t *) ll_dep->data;
+               ll_dep = ll_dep->next;
 
-    md_ctx_lock(dm_ctx->md_ctx, false);
-    if (submodule_revision || !module_name) {
-        rc = md_get_module_info(dm_ctx->md_ctx, submodule_name, submodule_revision, NULL, &md_module);
+               if (0 == strcmp(namespace, dep->dest->name)) {
+                   found = true;
+                   free(namespace);
+                   namespace = NULL;
+                   break;
+               }
+            }
+            /* else append to required modules */
+            if (!found) {
+                if (NULL == *required_modules) {
+                    rc = sr_list_init(required_modules);
+                    CHECK_RC_MSG_GOTO(rc, cleanup, "List initialization failed");
 
-        /* find the top main module */
-        while ((NULL != md_module) && (NULL != md_module->inv_deps->first)) {
-            dep_node = md_module->inv_deps->first;
-            while (NULL != dep_node) {
-                dependency = dep_node->data;
-                if (MD_DEP_INCLUDE == dependency->type || MD_DEP_IMPORT == dependency->type) {
-                    break;
-                } else {
-                    dep_node = dep_node->next;
+                    if (required_data) {
+                        rc = sr_list_init(required_data);
+                        CHECK_RC_MSG_GOTO(rc, cleanup, "List initialization failed");
+                    }
+
+                    /* insert module itself */
+                    module_name = strdup(di->schema->module_name);
+                    CHECK_NULL_NOMEM_GOTO(module_name, rc, cleanup);
+
+                    rc = sr_list_insert_unique_ord(*required_modules, module_name, dm_string_cmp, &inserted);
+                    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
+
+                    if (required_data) {
+                        rc = sr_list_add(*required_data, module_name);
+                        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
+                    }
+
+                    /* add installation time dependencies */
+                    ll_dep = module->deps->first;
+                    while (ll_dep) {
+                        dep = (md_dep_t *) ll_dep->data;
+                        ll_dep = ll_dep->next;
+
+                        module_name = strdup(dep->dest->name);
+                        CHECK_NULL_NOMEM_GOTO(module_name, rc, cleanup);
+
+                        rc = sr_list_insert_unique_ord(*required_modules, module_name, dm_string_cmp, &inserted);
+                        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert item into the list");
+
+                        if (inserted && dep->dest->has_data && required_data) {
+                            rc = sr_list_add(*required_data, module_name);
+                            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to add item into the list");
+                        }
+
+                        /* if dep has instanced id and it was inserted call recursively */
+                        if (inserted && NULL != dep->dest->inst_ids->first) {
+                            rc = dm_get_data_info_internal(dm_ctx, session, dep->dest->name, true, true, &must_be_freed, &recursive_info);
+                            CHECK_RC_LOG_GOTO(rc, cleanup, "Get data info failed for %s", dep->dest->name);
+
+                            rc = dm_requires_tmp_context(dm_ctx, session, recursive_info, required_data, required_modules);
+                            CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to resolve recusrive deps in %s", recursive_info->schema->module_name);
+
+                            if (must_be_freed) {
+                                dm_data_info_free(recursive_info);
+                            }
+                        } else if (!inserted){
+                            free(module_name);
+                        }
+                    }
                 }
-            }
-            if (NULL != dep_node) {
-                md_module = dependency->dest;
-            } else {
-                break;
-            }
-        }
-        if (NULL != md_module) {
-            main_module = md_module->name;
-        }
+                inserted = false;
+                rc = sr_list_insert_unique_ord(*required_modules, namespace, dm_string_cmp, &inserted);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
+                inserted_namespace = namespace;
+                namespace = NULL; /* do not free namespace in this function case of cleanup */
 
-        md_ctx_unlock(dm_ctx->md_ctx);
-        CHECK_RC_LOG_RETURN(rc, "Submodule %s in revision %s not found", submodule_name, submodule_revision);
-    } else {
-        rc = md_get_module_info(dm_ctx->md_ctx, module_name, module_revision, NULL, &md_module);
+                if (inserted) {
+                    if (required_data) {
+                        rc = sr_list_add(*required_data, inserted_namespace);
+                        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert an item into the list");
+                    }
 
-        if (NULL != md_module && !md_module->latest_revision) {
-            /* find a module in latest revision that includes the requested module
-             * this handles the case that requested module is included in older revision by other module */
-            dep_node = md_module->inv_deps->first;
-            while (NULL != dep_node) {
-                dependency = dep_node->data;
-                dep_node = dep_node->next;
-                if (!dependency->dest->submodule && dependency->dest->latest_revision) {
-                    main_module = dependency->dest->name;
-                    break;
+                    /* call recursively */
+                    rc = dm_get_data_info_internal(dm_ctx, session, inserted_namespace, true, true, &must_be_freed, &recursive_info);
+                    CHECK_RC_LOG_GOTO(rc, cleanup, "Get data info failed for %s", inserted_namespace);
+
+                    rc = dm_requires_tmp_context(dm_ctx, session, recursive_info, required_data, required_modules);
+                    CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to resolve recusrive deps in %s", recursive_info->schema->module_name);
+
+                    if (must_be_freed) {
+                        dm_data_info_free(recursive_info);
+                    }
                 }
             }
         }
+        ly_set_free(set);
+        set = NULL;
+    }
 
-        md_ctx_unlock(dm_ctx->md_ctx);
-        CHECK_RC_LOG_RETURN(rc, "Module %s in revision %s not found", module_name, module_revision);
+cleanup:
+    if (SR_ERR_OK != rc) {
+        sr_free_list_of_strings(*required_modules);
+        *required_modules = NULL;
     }
+    free(namespace);
+    ly_set_free(set);
+    md_ctx_unlock(dm_ctx->md_ctx);
+    return rc;
+}
 
-    rc = dm_get_module_and_lockw(dm_ctx, main_module, &si);
-    CHECK_RC_LOG_RETURN(rc, "Get module failed for %s", main_module);
+/**
+ * @brief Retrieves data infos of the listed modules needed for validation of the data info.
+ * If the data of a module has not been loaded into the session yet, the tree cached
+ * in the schema info is borrowed and the returned data info has to be freed.
+ *
+ * @param [in] dm_ctx
+ * @param [in] session
+ * @param [in] info
+ * @param [in] modules - names of the modules
+ * @param [out] data_for_validation - list of data infos in the order of modules
+ * @param [out] should_be_freed - flags denoting which of the data infos have to be freed
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_get_data_for_validation(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *info, sr_list_t *modules,
+        sr_list_t **data_for_validation, bool **should_be_freed)
+{
+    CHECK_NULL_ARG5(dm_ctx, session, info, modules, data_for_validation);
+    CHECK_NULL_ARG(should_be_freed);
+    dm_data_info_t *dep_di = NULL;
+    int rc = SR_ERR_OK;
 
-    if (NULL != submodule_name) {
-        module = (const struct lys_module *) ly_ctx_get_submodule(si->ly_ctx, module_name, module_revision, submodule_name, submodule_revision);
-    } else {
-        module = ly_ctx_get_module(si->ly_ctx, module_name, module_revision, 0);
-    }
+    rc = sr_list_init(data_for_validation);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
 
-    if (NULL == module) {
-        SR_LOG_ERR("Not found module %s (revision %s) submodule %s (revision %s)", module_name, module_revision, submodule_name, submodule_revision);
-        rc = SR_ERR_NOT_FOUND;
-        goto cleanup;
-    }
-    ret = lys_print_mem(schema, module, yang_format ? LYS_OUT_YANG : LYS_OUT_YIN, NULL, 0, 0);
-    CHECK_ZERO_LOG_GOTO(ret, rc, SR_ERR_INTERNAL, cleanup, "Module %s print failed.", si->module_name);
+    *should_be_freed = calloc(modules->count, sizeof(**should_be_freed));
+    CHECK_NULL_NOMEM_RETURN(*should_be_freed);
 
-cleanup:
-    pthread_rwlock_unlock(&si->model_lock);
+    for (size_t i = 0; i < modules->count; i++) {
+        SR_LOG_DBG("To pass the validation of '%s' data from module %s is needed", info->schema->module_name, (char *) modules->data[i]);
+        rc = dm_get_data_info_internal(dm_ctx, session, (char *) modules->data[i], true, true, &(*should_be_freed)[i], &dep_di);
+        CHECK_RC_LOG_RETURN(rc, "Failed to get data info for module %s", (char *) modules->data[i]);
+
+        rc = sr_list_add(*data_for_validation, dep_di);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR_MSG("List insert failed");
+            if ((*should_be_freed)[i]) {
+                dm_data_info_free(dep_di);
+            }
+            return rc;
+        }
+    }
     return rc;
 }
 
+/**
+ * @brief Compares two read-only trees by their address, defines the order in which they are locked.
+ */
+static int
+dm_rdonly_tree_ptr_cmp(const void *a, const void *b)
+{
+    uintptr_t tree_a = (uintptr_t) *(dm_rdonly_tree_t * const *) a;
+    uintptr_t tree_b = (uintptr_t) *(dm_rdonly_tree_t * const *) b;
+
+    return (tree_a > tree_b) - (tree_a < tree_b);
+}
+
+/**
+ * @brief Links siblings at the end of the top-level sibling list starting with first.
+ */
 static void
-dm_record_errors(int rc, sr_error_info_t **errors, size_t *err_cnt, dm_data_info_t *info)
+dm_siblings_link(struct lyd_node **first, struct lyd_node *siblings)
 {
-    if (SR_ERR_VALIDATION_FAILED == rc) {
-        if (SR_ERR_OK != sr_add_error(errors, err_cnt, ly_errpath(info->schema->module->ctx), "%s",
-                                        ly_errmsg(info->schema->module->ctx))) {
-            SR_LOG_WRN_MSG("Failed to record validation error");
-        }
+    struct lyd_node *last = NULL;
+
+    if (NULL == *first) {
+        *first = siblings;
+        return;
+    }
+    last = (*first)->prev;
+    last->next = siblings;
+    (*first)->prev = siblings->prev;
+    siblings->prev = last;
+}
+
+/**
+ * @brief Appends a single top-level node at the end of the sibling list starting with first.
+ */
+static void
+dm_siblings_append(struct lyd_node **first, struct lyd_node *node)
+{
+    node->next = NULL;
+    if (NULL == *first) {
+        node->prev = node;
+        *first = node;
     } else {
-        if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, "Validation failed: %s",
-                                        sr_strerror(rc))) {
-            SR_LOG_WRN_MSG("Failed to record validation error");
+        node->prev = (*first)->prev;
+        (*first)->prev->next = node;
+        (*first)->prev = node;
+    }
+}
+
+/**
+ * @brief Tests whether the module (or any of its submodules) augments some schema nodes.
+ * Validation of such module can modify data of the augmented modules.
+ */
+static bool
+dm_module_has_augments(const struct lys_module *module)
+{
+    if (module->augment_size > 0) {
+        return true;
+    }
+    for (uint8_t i = 0; i < module->inc_size; i++) {
+        if (NULL != module->inc[i].submodule && module->inc[i].submodule->augment_size > 0) {
+            return true;
         }
     }
+    return false;
 }
 
-static void
-dm_invalidate_leaf_refs(struct lyd_node *root)
+/**
+ * @brief Tests whether the data info can be validated against data of the dependant modules
+ * linked in place, i.e. all the data belong to the same libyang context and the validation
+ * modifies only the data of the validated module.
+ */
+static bool
+dm_can_validate_linked_data(dm_data_info_t *info, sr_list_t *data_for_validation)
 {
-    struct lyd_node *data = NULL, *next = NULL, *iter = NULL;
-    LY_TREE_FOR(root, data) {
-        LY_TREE_DFS_BEGIN(data, next, iter) {
-            switch (iter->schema->nodetype) {
-            case LYS_LEAFLIST:
-            case LYS_LEAF:
-                if (((struct lys_node_leaf *)iter->schema)->type.base == LY_TYPE_LEAFREF) {
-                    iter->validity |= LYD_VAL_LEAFREF;
-                }
-                break;
-            default:
-                break;
-            }
-            LY_TREE_DFS_END(data, next, iter)
+    if (NULL == info->schema->shared_ly_ctx || dm_module_has_augments(info->schema->module)) {
+        return false;
+    }
+    for (size_t i = 0; i < data_for_validation->count; i++) {
+        dm_data_info_t *d = (dm_data_info_t *) data_for_validation->data[i];
+        if (NULL != d->node && d->schema->ly_ctx != info->schema->ly_ctx) {
+            /* installed in a different epoch of the shared context */
+            return false;
         }
     }
+    return true;
 }
 
+/**
+ * @brief Validates the data info with the data of the dependant modules linked as siblings
+ * of its data tree. The data of the dependant modules are unlinked afterwards, so they do not
+ * have to be copied. Read-only trees are locked while linked (in the order of their address
+ * so that concurrent validations can not deadlock), other readers lock them as well.
+ *
+ * @param [in] info
+ * @param [in] data_for_validation - data infos of the required modules, the entry of the validated
+ * module is skipped, info->node is used instead
+ * @param [out] validation_failed
+ * @return Error code (SR_ERR_OK on success)
+ */
 static int
-dm_validate_module_inv_data_deps(dm_ctx_t *dm_ctx, dm_session_t *session, sr_error_info_t **errors,
-                                 size_t *err_cnt, const char *module_name)
+dm_validate_linked_data(dm_data_info_t *info, sr_list_t *data_for_validation, bool *validation_failed)
 {
-    dm_data_info_t *info = NULL;
-    bool must_free_info = false;
+    CHECK_NULL_ARG3(info, data_for_validation, validation_failed);
     int rc = SR_ERR_OK;
-    md_module_t *module = NULL;
-    sr_llist_node_t *ll_node = NULL;
-    md_dep_t *dep = NULL;
-    bool validation_failed = false;
-    bool is_enabled = false;
-    sr_datastore_t ds = session->datastore;
-
-    md_ctx_lock(dm_ctx->md_ctx, false);
-    rc = md_get_module_info(dm_ctx->md_ctx, module_name, NULL, NULL, &module);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module %s info failed", module_name);
-
-    ll_node = module->inv_deps->first;
-    while (ll_node) {
-        dep = (md_dep_t *)ll_node->data;
-        ll_node = ll_node->next;
-
-        if (dep->type != MD_DEP_DATA || !dep->dest->has_data) {
+    dm_data_info_t **deps = NULL;
+    dm_rdonly_tree_t **trees = NULL;
+    struct lyd_node *data_tree = NULL, *iter = NULL, *next = NULL, **segment = NULL;
+    size_t dep_cnt = 0, tree_cnt = 0;
+
+    deps = calloc(data_for_validation->count, sizeof(*deps));
+    CHECK_NULL_NOMEM_GOTO(deps, rc, cleanup);
+    trees = calloc(data_for_validation->count, sizeof(*trees));
+    CHECK_NULL_NOMEM_GOTO(trees, rc, cleanup);
+
+    for (size_t i = 0; i < data_for_validation->count; i++) {
+        dm_data_info_t *d = (dm_data_info_t *) data_for_validation->data[i];
+        if (d->schema == info->schema || NULL == d->node) {
             continue;
         }
-
-        rc = dm_has_enabled_subtree(dm_ctx, dep->dest->name, NULL, &is_enabled);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to check whether module is enabled for %s", dep->dest->name);
-        if (!is_enabled && (ds == SR_DS_RUNNING)) {
-            /* use startup data in this case */
-            session->datastore = SR_DS_STARTUP;
+        deps[dep_cnt++] = d;
+        if (NULL != d->rdonly_tree) {
+            trees[tree_cnt++] = d->rdonly_tree;
         }
+    }
+    qsort(trees, tree_cnt, sizeof(*trees), dm_rdonly_tree_ptr_cmp);
+    for (size_t i = 0; i < tree_cnt; i++) {
+        pthread_mutex_lock(&trees[i]->lock);
+    }
 
-        rc = dm_get_data_info_internal(dm_ctx, session, dep->dest->name, true, &must_free_info, &info);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load data info for %s", dep->dest->name);
+    /* link the data of the validated module first */
+    data_tree = info->node;
+    for (size_t i = 0; i < dep_cnt; i++) {
+        dm_siblings_link(&data_tree, deps[i]->node);
+    }
 
-        session->datastore = ds;
+    if (0 != lyd_validate_modules(&data_tree, &info->schema->module, 1, LYD_OPT_STRICT | LYD_OPT_WHENAUTODEL | LYD_OPT_CONFIG)) {
+        SR_LOG_DBG("Validation failed for %s module", info->schema->module->name);
+        *validation_failed = true;
+    } else {
+        SR_LOG_DBG("Validation succeeded for '%s' module", info->schema->module->name);
+    }
 
-        /* The dependent data has changed, so leaf refs might not be valid anymore */
-        dm_invalidate_leaf_refs(info->node);
-        rc = dm_validate_data_info(dm_ctx, session, info);
-        if (rc != SR_ERR_OK) {
-            dm_record_errors(rc, errors, err_cnt, info);
-            validation_failed = true;
-            rc = SR_ERR_OK;
+    /* split the siblings back by module, only the nodes of the validated module could have been
+     * added (default nodes) or removed (when condition) */
+    info->node = NULL;
+    for (size_t i = 0; i < dep_cnt; i++) {
+        deps[i]->node = NULL;
+    }
+    if (NULL != data_tree) {
+        while (NULL != data_tree->prev->next) {
+            data_tree = data_tree->prev;
         }
-
-        if (must_free_info) {
-            dm_data_info_free(info);
+    }
+    for (iter = data_tree; NULL != iter; iter = next) {
+        next = iter->next;
+        segment = &info->node;
+        for (size_t i = 0; i < dep_cnt; i++) {
+            if (LYS_MAIN_MODULE(iter->schema) == deps[i]->schema->module) {
+                segment = &deps[i]->node;
+                break;
+            }
         }
+        dm_siblings_append(segment, iter);
     }
 
-cleanup:
-    md_ctx_unlock(dm_ctx->md_ctx);
-    if(validation_failed) {
-        rc = SR_ERR_VALIDATION_FAILED;
+    for (size_t i = tree_cnt; i > 0; i--) {
+        pthread_mutex_unlock(&trees[i - 1]->lock);
     }
+
+cleanup:
+    free(deps);
+    free(trees);
     return rc;
 }
 
-int
-dm_validate_session_data_trees(dm_ctx_t *dm_ctx, dm_session_t *session, sr_error_info_t **errors, size_t *err_cnt)
+/**
+ * @brief Validates one data_info_t record. It might temporarily load also different data
+ * if there is cross_module dependency or instance id.
+ */
+static int
+dm_validate_data_info(dm_ctx_t *dm_ctx, dm_session_t *session, dm_data_info_t *info)
 {
-    CHECK_NULL_ARG4(dm_ctx, session, errors, err_cnt);
+    CHECK_NULL_ARG3(dm_ctx, session, info);
     int rc = SR_ERR_OK;
-
-    size_t cnt = 0;
-    *err_cnt = 0;
-    dm_data_info_t *info = NULL;
-    sr_llist_t *session_modules = NULL;
-    sr_llist_node_t *node = NULL;
+    sr_list_t *required_data = NULL;
+    sr_list_t *dependant_modules = NULL;
+    sr_list_t *data_for_validation = NULL;
+    dm_tmp_ly_ctx_t *tmp_ctx = NULL;
+    struct ly_ctx *work_ctx = NULL;
+    const struct lys_module *mod;
+    struct lyd_node *data_tree = NULL;
     bool validation_failed = false;
+    bool *should_be_freed = NULL;
 
-    rc = sr_llist_init(&session_modules);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot initialize temporary linked-list for session modules.");
+    /* cleanup the list of dependant modules */
+    sr_free_list_of_strings(info->required_modules);
+    info->required_modules = NULL;
 
-    /* collect the list of modules first, it may change during the validation */
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], cnt))) {
-        sr_llist_add_new(session_modules, info);
-        cnt++;
+    if (NULL == info->schema->module || NULL == info->schema->module->name) {
+        SR_LOG_ERR_MSG("Missing schema information");
+        rc = SR_ERR_INTERNAL;
+        goto cleanup;
     }
 
-    node = session_modules->first;
-    while (NULL != node) {
-        info = (dm_data_info_t *)node->data;
-        /* loaded data trees are valid, so check only the modified ones */
-        if (info->modified) {
-            rc = dm_validate_data_info(dm_ctx, session, info);
-            if (rc != SR_ERR_OK) {
-                dm_record_errors(rc, errors, err_cnt, info);
+    /* attach data dependant modules */
+    if (info->schema->has_instance_id || info->schema->cross_module_data_dependency) {
+
+        rc = dm_requires_tmp_context(dm_ctx, session, info, &required_data, &info->required_modules);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Require tmp ctx check failed for module %s", info->schema->module_name);
+
+        if (NULL == info->required_modules) {
+            /* only dependencies know since installation time are needed */
+            if (info->schema->cross_module_data_dependency && NULL != info->schema->shared_ly_ctx) {
+                rc = dm_get_dependant_modules(dm_ctx, info, &dependant_modules);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to collect dependant modules");
+
+                rc = dm_get_data_for_validation(dm_ctx, session, info, dependant_modules, &data_for_validation, &should_be_freed);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to retrieve dependant data");
+
+                if (dm_can_validate_linked_data(info, data_for_validation)) {
+                    /* remove data appended by ::dm_load_dependant_data before */
+                    rc = dm_remove_added_data_trees(session, info);
+                    CHECK_RC_MSG_GOTO(rc, cleanup, "Removing of added data trees failed");
+
+                    rc = dm_validate_linked_data(info, data_for_validation, &validation_failed);
+                    CHECK_RC_MSG_GOTO(rc, cleanup, "Validation of linked data trees failed");
+                    goto cleanup;
+                }
+            }
+
+            rc = dm_load_dependant_data(dm_ctx, session, info);
+            CHECK_RC_LOG_GOTO(rc, cleanup, "Loading dependant modules failed for %s", info->schema->module_name);
+
+            if (0 != lyd_validate_modules(&info->node, &info->schema->module, 1, LYD_OPT_STRICT | LYD_OPT_WHENAUTODEL | LYD_OPT_CONFIG)) {
+                SR_LOG_DBG("Validation failed for %s module", info->schema->module->name);
                 validation_failed = true;
-                rc = SR_ERR_OK;
+            } else {
+                SR_LOG_DBG("Validation succeeded for '%s' module", info->schema->module->name);
             }
-            rc = dm_validate_module_inv_data_deps(dm_ctx, session, errors, err_cnt, info->schema->module_name);
-            if (rc != SR_ERR_OK) {
+            if (info->schema->cross_module_data_dependency) {
+                /* remove data appended from other modules for the purpose of validation */
+                rc = dm_remove_added_data_trees(session, info);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Removing of added data trees failed");
+            }
+        } else {
+            /* validate using tmp ly_ctx */
+
+            /* if requested data has not be loaded into the session yet, the validation is skipped
+             * it is only appended to the validated data_info and removed afterwards. we have to track
+             * which data should be freed and which not */
+            rc = dm_get_data_for_validation(dm_ctx, session, info, required_data, &data_for_validation, &should_be_freed);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to retrieve required data");
+
+            if (dm_can_validate_linked_data(info, data_for_validation)) {
+                /* all required modules are present in the shared context, no data have to be copied */
+                rc = dm_validate_linked_data(info, data_for_validation, &validation_failed);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Validation of linked data trees failed");
+                goto cleanup;
+            }
+
+            if (NULL != info->schema->shared_ly_ctx) {
+                /* required modules installed in different epochs of the shared context, copy
+                 * the data into the context of the validated module */
+                work_ctx = info->schema->ly_ctx;
+                mod = info->schema->module;
+            } else {
+                /* prepare working context*/
+                rc = dm_get_tmp_ly_ctx(dm_ctx, info->required_modules, &tmp_ctx);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to acquire tmp ctx");
+                work_ctx = tmp_ctx->ctx;
+
+                /* get module from tmp_ctx */
+                mod = ly_ctx_get_module(tmp_ctx->ctx, info->schema->module->name, NULL, 1);
+                if (!mod) {
+                    SR_LOG_ERR("Failed to find module '%s' in temtporary context", info->schema->module->name);
+                    goto cleanup;
+                }
+            }
+
+            /* migrate data to working context */
+            for (size_t i = 0; i < data_for_validation->count; i++) {
+                dm_data_info_t *d = (dm_data_info_t *) data_for_validation->data[i];
+                if (NULL != d->node) {
+                    int ret = 0;
+                    dm_data_info_rdonly_lock(d);
+                    if (NULL == data_tree) {
+                        data_tree = sr_dup_datatree_to_ctx(d->node, work_ctx);
+                    } else {
+                        ret = lyd_merge_to_ctx(&data_tree, d->node, LYD_OPT_EXPLICIT, work_ctx);
+                    }
+                    dm_data_info_rdonly_unlock(d);
+                    CHECK_ZERO_LOG_GOTO(ret, rc, SR_ERR_INTERNAL, cleanup, "Failed to merge data tree '%s'", d->schema->module_name);
+                }
+            }
+
+            /* start validation */
+            if (0 != lyd_validate_modules(&data_tree, &mod, 1, LYD_OPT_STRICT | LYD_OPT_WHENAUTODEL | LYD_OPT_CONFIG)) {
+                SR_LOG_DBG("Validation failed for %s module", info->schema->module->name);
                 validation_failed = true;
-                rc = SR_ERR_OK;
+            } else {
+                SR_LOG_DBG("Validation succeeded for '%s' module", info->schema->module->name);
+            }
+
+            /* remove data from different modules and replace data in data_info to have default nodes in place */
+            rc = dm_remove_added_data_trees_by_module_name(info->schema->module_name, &data_tree);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to remove added data trees");
+
+            lyd_free_withsiblings(info->node);
+
+            if (NULL != info->schema->shared_ly_ctx) {
+                /* validated tree already belongs to the schema context */
+                info->node = data_tree;
+                data_tree = NULL;
+            } else {
+                info->node = sr_dup_datatree_to_ctx(data_tree, info->schema->ly_ctx);
             }
         }
-        node = node->next;
+    } else {
+        if (0 != lyd_validate_modules(&info->node, &info->schema->module, 1, LYD_OPT_STRICT | LYD_OPT_WHENAUTODEL | LYD_OPT_CONFIG)) {
+            SR_LOG_DBG("Validation failed for %s module", info->schema->module->name);
+            validation_failed = true;
+        } else {
+            SR_LOG_DBG("Validation succeeded for '%s' module", info->schema->module->name);
+        }
     }
 
 cleanup:
+    if (NULL != data_for_validation) {
+        for (size_t i = 0; i < data_for_validation->count; i++) {
+            if (should_be_freed[i]) {
+                dm_data_info_free((dm_data_info_t *) data_for_validation->data[i]);
+            }
+        }
+    }
+    sr_list_cleanup(required_data);
+    sr_free_list_of_strings(dependant_modules);
+    sr_list_cleanup(data_for_validation);
+    free(should_be_freed);
+    lyd_free_withsiblings(data_tree);
+    if (tmp_ctx) {
+        dm_release_tmp_ly_ctx(dm_ctx, tmp_ctx);
+    }
     if (validation_failed) {
         rc = SR_ERR_VALIDATION_FAILED;
     }
-    sr_llist_cleanup(session_modules);
     return rc;
 }
 
-int
-dm_discard_changes(dm_ctx_t *dm_ctx, dm_session_t *session, const char *module_name)
+/**
+ * @note if skip_validation is false, must_be_freed will not be set to true
+ * @note if skip_validation and rdonly are true, the data tree of the returned data info
+ * must not be modified (it may be shared)
+ */
+static int
+dm_get_data_info_internal(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, bool skip_validation, bool rdonly, bool *must_be_freed, dm_data_info_t **info)
 {
-    CHECK_NULL_ARG2(dm_ctx, session);
-    int rc = SR_ERR_OK, i;
-    dm_data_info_t *info = NULL;
-
-    if (NULL == module_name) {
-        sr_btree_cleanup(session->session_modules[session->datastore]);
-        session->session_modules[session->datastore] = NULL;
+    int rc = SR_ERR_OK;
+    dm_data_info_t *exisiting_data_info = NULL;
+    dm_schema_info_t *schema_info = NULL;
+    dm_schema_info_t lookup_schema = {0};
+    dm_data_info_t lookup_data = {0};
 
-        rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &session->session_modules[session->datastore]);
-        CHECK_RC_MSG_RETURN(rc, "Binary tree allocation failed");
-        dm_free_sess_operations(session->operations[session->datastore], session->oper_count[session->datastore]);
-        session->operations[session->datastore] = NULL;
-        session->oper_count[session->datastore] = 0;
-        session->oper_size[session->datastore] = 0;
-    } else {
-        i = 0;
-        while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-            if (0 == strcmp(info->schema->module->name, module_name)) {
-                sr_btree_delete(session->session_modules[session->datastore], info);
-                break;
-            }
-        }
+    if (NULL != must_be_freed) {
+        *must_be_freed = false;
+    }
 
-        for (i = session->oper_count[session->datastore] - 1; i >= 0; i--) {
-            dm_sess_op_t *op = &session->operations[session->datastore][i];
-            if (0 == sr_cmp_first_ns(op->xpath, module_name)) {
-                dm_free_sess_op(op);
-                memmove(&session->operations[session->datastore][i],
-                        &session->operations[session->datastore][i + 1],
-                        (session->oper_count[session->datastore] - i - 1) * sizeof(*op));
-                session->oper_count[session->datastore]--;
-            }
-        }
+    /* The session copy pins its schema info (usage_count), module can be neither uninstalled nor
+     * its features changed until the copy is released. Thus the session copy can be returned without
+     * touching the schema tree lock and the model lock shared by all sessions. */
+    lookup_schema.module_name = (char *) module_name;
+    lookup_data.schema = &lookup_schema;
+    exisiting_data_info = sr_btree_search(dm_session_ctx->session_modules[dm_session_ctx->datastore], &lookup_data);
+    if (NULL != exisiting_data_info) {
+        *info = exisiting_data_info;
+        SR_LOG_DBG("Module %s already loaded", module_name);
+        return rc;
     }
 
-    return SR_ERR_OK;
-}
+    rc = dm_get_module_and_lock(dm_ctx, module_name, &schema_info);
+    CHECK_RC_LOG_RETURN(rc, "Get module '%s' failed", module_name);
 
-int
-dm_remove_modified_flag(dm_session_t* session)
-{
-    int rc = SR_ERR_OK;
-    dm_data_info_t *info = NULL;
-    size_t cnt = 0;
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], cnt))) {
-        /* remove modified flag */
-        info->modified = false;
-        cnt++;
+    /* session copy not found load it from file system */
+    dm_data_info_t *di = NULL;
+    if (SR_DS_CANDIDATE == dm_session_ctx->datastore) {
+        rc = dm_load_data_tree(dm_ctx, dm_session_ctx, schema_info, SR_DS_RUNNING, &di);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Getting data tree for %s failed.", module_name);
+        rc = dm_remove_not_enabled_nodes(di);
+        if (SR_ERR_OK != rc) {
+            dm_data_info_free(di);
+            SR_LOG_ERR("Removing of not enabled nodes in model %s failed", di->schema->module->name);
+            goto cleanup;
+        }
+    }
+    else {
+        /* auxiliary data loaded only for reading can be shared */
+        rc = dm_load_data_tree_internal(dm_ctx, dm_session_ctx, schema_info, dm_session_ctx->datastore,
+                skip_validation && rdonly, &di);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Getting data tree for %s failed.", module_name);
     }
-    return rc;
-}
 
-int
-dm_remove_session_operations(dm_session_t *session)
-{
-    CHECK_NULL_ARG(session);
-    while (session->oper_count[session->datastore] > 0) {
-        dm_remove_last_operation(session);
-    }
-    return SR_ERR_OK;
-}
-
-static int
-dm_is_info_copy_uptodate(dm_ctx_t *dm_ctx, const char *file_name, const dm_data_info_t *info, bool *res)
-{
-    CHECK_NULL_ARG4(dm_ctx, file_name, info, res);
-    int rc = SR_ERR_OK;
-#ifdef HAVE_STAT_ST_MTIM
-    struct stat st = {0};
-    rc = stat(file_name, &st);
-    if (-1 == rc) {
-        SR_LOG_ERR_MSG("Stat failed");
-        return SR_ERR_INTERNAL;
-    }
-    struct timespec now;
-    clock_gettime(CLOCK_REALTIME, &now);
-    SR_LOG_DBG("Session copy %s: mtime sec=%lld nsec=%lld", info->schema->module->name,
-            (long long) info->timestamp.tv_sec,
-            (long long) info->timestamp.tv_nsec);
-    SR_LOG_DBG("Loaded module %s: mtime sec=%lld nsec=%lld", info->schema->module->name,
-            (long long) st.st_mtim.tv_sec,
-            (long long) st.st_mtim.tv_nsec);
-    SR_LOG_DBG("Current time: mtime sec=%lld nsec=%lld",
-            (long long) now.tv_sec,
-            (long long) now.tv_nsec);
-    /* check if we should update session copy conditions
-     * is the negation of the optimized commit */
-    if (info->timestamp.tv_sec != st.st_mtim.tv_sec ||
-            info->timestamp.tv_nsec != st.st_mtim.tv_nsec ||
-            (now.tv_sec == st.st_mtim.tv_sec && difftime(now.tv_nsec, st.st_mtim.tv_nsec) < NANOSEC_THRESHOLD) ||
-            info->timestamp.tv_sec < dm_ctx->last_commit_time.tv_sec ||
-            (info->timestamp.tv_sec == dm_ctx->last_commit_time.tv_sec && info->timestamp.tv_nsec <= dm_ctx->last_commit_time.tv_nsec) ||
-            info->timestamp.tv_nsec == 0) {
-        SR_LOG_DBG("Module %s will be refreshed", info->schema->module->name);
-        *res = false;
+    if (!skip_validation) {
+        if (di->schema->cross_module_data_dependency || di->schema->has_instance_id) {
+            /* do the validation that was skipped, mainly to add default nodes */
+            rc = dm_validate_data_info(dm_ctx, dm_session_ctx, di);
+            /* validation might fails on rare occasion - working copy of dependant module was
+             * already modified i.e.: referenced node was deleted. Thus errors are ignored. */
+            if (SR_ERR_OK != rc) {
+                SR_LOG_WRN("Validation of module with instance_id or cross-module deps %s failed", di->schema->module_name);
+            }
+        }
+        /* we do not insert data_info_t if it was loaded only as auxiliary cause of validation */
+        rc = sr_btree_insert(dm_session_ctx->session_modules[dm_session_ctx->datastore], (void *) di);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR("Insert into session avl failed module %s", module_name);
+            dm_data_info_free(di);
+            goto cleanup;
+        }
 
     } else {
-        *res = true;
+        if (NULL != must_be_freed) {
+            /* let the caller know that he has to free the content */
+            *must_be_freed = true;
+        }
     }
-#else
-    *res = false;
-#endif
+
+
+    SR_LOG_DBG("Module %s has been loaded", module_name);
+    *info = di;
+
+cleanup:
+    pthread_rwlock_unlock(&schema_info->model_lock);
     return rc;
+}
 
+int
+dm_get_data_info(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, dm_data_info_t **info)
+{
+    CHECK_NULL_ARG4(dm_ctx, dm_session_ctx, module_name, info);
+    return dm_get_data_info_internal(dm_ctx, dm_session_ctx, module_name, false, false, NULL, info);
 }
 
 int
-dm_update_session_data_trees(dm_ctx_t *dm_ctx, dm_session_t *session, sr_list_t **up_to_date_models)
+dm_get_datatree(dm_ctx_t *dm_ctx, dm_session_t *dm_session_ctx, const char *module_name, struct lyd_node **data_tree)
 {
-    CHECK_NULL_ARG3(dm_ctx, session, up_to_date_models);
+    CHECK_NULL_ARG4(dm_ctx, dm_session_ctx, module_name, data_tree);
     int rc = SR_ERR_OK;
-    int fd = -1;
-    char *file_name = NULL;
     dm_data_info_t *info = NULL;
-    size_t i = 0;
-    sr_list_t *to_be_refreshed = NULL, *up_to_date = NULL;
-    rc = sr_list_init(&to_be_refreshed);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+    rc = dm_get_data_info(dm_ctx, dm_session_ctx, module_name, &info);
+    CHECK_RC_LOG_RETURN(rc, "Get data info failed for module %s", module_name);
+    *data_tree = info->node;
+    if (NULL == info->node) {
+        return SR_ERR_NOT_FOUND;
+    }
+    return rc;
+}
 
-    rc = sr_list_init(&up_to_date);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+static int
+dm_get_module_internal(dm_ctx_t *dm_ctx, const char *module_name, bool lock, bool write, dm_schema_info_t **schema_info)
+{
+    CHECK_NULL_ARG3(dm_ctx, module_name, schema_info);
 
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        rc = sr_get_data_file_name(dm_ctx->data_search_dir,
-                info->schema->module->name,
-                SR_DS_CANDIDATE == session->datastore ? SR_DS_RUNNING : session->datastore,
-                &file_name);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Get data file name failed");
-        ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
-        fd = open(file_name, O_RDONLY);
-        ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+    int rc = SR_ERR_OK;
+    dm_schema_info_t lookup = {0};
+    dm_schema_info_t *sch_info = NULL;
 
-        if (-1 == fd) {
-            SR_LOG_DBG("File %s can not be opened for read write", file_name);
-            if (EACCES == errno) {
-                SR_LOG_WRN("File %s can not be opened because of authorization", file_name);
-            } else if (ENOENT == errno) {
-                SR_LOG_DBG("File %s does not exist, trying to create an empty one", file_name);
-            }
-            /* skip data trees that was not successfully opened */
-            free(file_name);
-            file_name = NULL;
-            continue;
-        }
+    lookup.module_name = (char *) module_name;
+    RWLOCK_RDLOCK_TIMED_CHECK_RETURN(&dm_ctx->schema_tree_lock);
+    sch_info = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
 
-        /* lock for read, blocking - guards access to the file among processes.
-         * Inside the process access to data files is protected by commit_lock in rp.
-         * Each request that might need to read data file locks it for read at the beginning
-         * of request processing. */
-        rc = sr_lock_fd(fd, false, true);
+#ifdef SHARED_LY_CTX
+    if (NULL != sch_info && NULL != sch_info->shared_ly_ctx && sch_info->shared_ly_ctx != dm_ctx->shared_ly_ctx) {
+        /* schema info references an older epoch of the shared context, move it to the current one if possible */
+        pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+        rc = dm_shared_schema_info_refresh(dm_ctx, sch_info);
+        CHECK_RC_LOG_RETURN(rc, "Failed to refresh shared context of module %s", module_name);
+        RWLOCK_RDLOCK_TIMED_CHECK_RETURN(&dm_ctx->schema_tree_lock);
+    }
+#endif
 
-        bool copy_uptodate = false;
-        rc = dm_is_info_copy_uptodate(dm_ctx, file_name, info, &copy_uptodate);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR_MSG("File up to date check failed");
-            close(fd);
-            goto cleanup;
-        }
+    if (NULL != sch_info) {
+        /* there is matching item in schema info tree */
+        if (lock) {
 
-        if (copy_uptodate) {
-            if (info->modified) {
-                rc = sr_list_add(up_to_date, (void *) info->schema->module->name);
+            if (write) {
+                RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
+            } else {
+                RWLOCK_RDLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
+            }
+
+            if (NULL == sch_info->ly_ctx) {
+                SR_LOG_DBG("Module %s has been uninstalled", sch_info->module_name);
+                pthread_rwlock_unlock(&sch_info->model_lock);
+                rc = SR_ERR_UNKNOWN_MODEL;
+                goto cleanup;
             }
-        } else {
-            SR_LOG_DBG("Module %s will be refreshed", info->schema->module->name);
-            rc = sr_list_add(to_be_refreshed, info);
         }
-        free(file_name);
-        file_name = NULL;
-        close(fd);
+        *schema_info = sch_info;
+        goto cleanup;
+    } else {
+        /* try to load schema */
+        pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+        rc = dm_load_module(dm_ctx, module_name, NULL, &sch_info);
+        if (SR_ERR_OK == rc && lock) {
+            if (write) {
+                RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
+            } else {
+                RWLOCK_RDLOCK_TIMED_CHECK_GOTO(&sch_info->model_lock, rc, cleanup);
+            }
 
-        CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
+            if (NULL == sch_info->ly_ctx) {
+                SR_LOG_DBG("Module %s has been uninstalled", sch_info->module_name);
+                pthread_rwlock_unlock(&sch_info->model_lock);
+                rc = SR_ERR_UNKNOWN_MODEL;
+            } else {
+                *schema_info = sch_info;
+            }
 
+        }
     }
 
-    for (i = 0; i < to_be_refreshed->count; i++) {
-        sr_btree_delete(session->session_modules[session->datastore], to_be_refreshed->data[i]);
-    }
+    return rc;
 
 cleanup:
-    sr_list_cleanup(to_be_refreshed);
-    if (SR_ERR_OK == rc) {
-        *up_to_date_models = up_to_date;
-    } else {
-        sr_list_cleanup(up_to_date);
-    }
-    free(file_name);
+    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
     return rc;
 }
 
-void
-dm_remove_operations_with_error(dm_session_t *session)
+int
+dm_get_module_and_lockw(dm_ctx_t *dm_ctx, const char *module_name, dm_schema_info_t **schema_info)
 {
-    CHECK_NULL_ARG_VOID(session);
-    for (int i = session->oper_count[session->datastore] - 1; i >= 0; i--) {
-        dm_sess_op_t *op = &session->operations[session->datastore][i];
-        if (op->has_error) {
-            dm_free_sess_op(op);
-            memmove(&session->operations[session->datastore][i],
-                    &session->operations[session->datastore][i + 1],
-                    (session->oper_count[session->datastore] - i - 1) * sizeof(*op));
-            session->oper_count[session->datastore]--;
-        }
+    return dm_get_module_internal(dm_ctx, module_name, true, true, schema_info);
+}
+
+int
+dm_get_module_and_lock(dm_ctx_t *dm_ctx, const char *module_name, dm_schema_info_t **schema_info)
+{
+    return dm_get_module_internal(dm_ctx, module_name, true, false, schema_info);
+}
+
+int
+dm_get_module_without_lock(dm_ctx_t *dm_ctx, const char *module_name, dm_schema_info_t **schema_info)
+{
+    CHECK_NULL_ARG3(dm_ctx, module_name, schema_info);
+    int rc = SR_ERR_OK;
+
+    rc = dm_get_module_and_lock(dm_ctx, module_name, schema_info);
+    if (SR_ERR_OK == rc) {
+        pthread_rwlock_unlock(&(*schema_info)->model_lock);
     }
+    return rc;
 }
 
-/**
- * @brief whether the node match the subscribed one - if it is the same node or children
- * of the subscribed one
- * @param [in] sub_node
- * @param [in] node tested node
- * @param [out] res
- * @return Error code (SR_ERR_OK on success)
- */
 static int
-dm_match_subscription(const struct lys_node *sub_node, const struct lyd_node *node, bool *res)
+dm_list_rev_file(dm_ctx_t *dm_ctx, sr_mem_ctx_t *sr_mem, const char *module_name, const char *rev_date, sr_sch_revision_t *rev)
 {
-    CHECK_NULL_ARG2(node, res);
+    CHECK_NULL_ARG3(dm_ctx, module_name, rev);
+    int rc = SR_ERR_OK;
+    char *file_name = NULL;
 
-    if (NULL == sub_node) {
-        *res = true;
-        return SR_ERR_OK;
+    if (NULL != rev_date && 0 != strcmp("", rev_date)) {
+        sr_mem_edit_string(sr_mem, (char **)&rev->revision, rev_date);
+        CHECK_NULL_NOMEM_GOTO(rev->revision, rc, cleanup);
     }
 
-    /* check if a node has been changes under subscriptions */
-    struct lys_node *n = (struct lys_node *) node->schema;
-    while (NULL != n) {
-        if (sub_node == n) {
-            *res = true;
-            return SR_ERR_OK;
+    rc = sr_get_schema_file_name(dm_ctx->schema_search_dir, module_name, rev_date, true, &file_name);
+    if (SR_ERR_OK == rc) {
+        if (-1 != access(file_name, F_OK)) {
+            rc = sr_mem_edit_string(sr_mem, (char **)&rev->file_path_yang, file_name);
         }
-        n = lys_parent(n);
     }
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Get schema file name failed");
 
-    /* if a container/list has been created/deleted check if there
-     * a more specific subscription
-     * e.g: subscription to /container/list/leaf
-     *      container has been deleted
-     */
-    if ((LYS_CONTAINER | LYS_LIST) & node->schema->nodetype) {
-        struct lys_node *n = (struct lys_node *) sub_node;
-        bool subsc_under_modif = false;
-        while (NULL != n) {
-            if (node->schema == n) {
-                subsc_under_modif = true;
-                break;
-            }
-            n = lys_parent(n);
-        }
-
-        if (!subsc_under_modif) {
-            goto not_matched;
-        }
+    free(file_name);
+    file_name = NULL;
 
-        /* check whether a subscribed children has been created/deleted */
-        struct lyd_node *next = NULL, *iter = NULL;
-        LY_TREE_DFS_BEGIN((struct lyd_node *) node, next, iter){
-            if (sub_node == iter->schema){
-                *res = true;
-                return SR_ERR_OK;
-            }
-            LYD_TREE_DFS_END(node, next, iter);
+    rc = sr_get_schema_file_name(dm_ctx->schema_search_dir, module_name, rev_date, false, &file_name);
+    if (SR_ERR_OK == rc) {
+        if (-1 != access(file_name, F_OK)) {
+            sr_mem_edit_string(sr_mem, (char **)&rev->file_path_yin, file_name);
         }
-
-    }
-
-not_matched:
-    *res = false;
-    return SR_ERR_OK;
-}
-
-/**
- * @brief Returns the node to be tested whether the changes matches the subscription
- * @param [in] diff
- * @param [in] index
- * @return  Schema node of the change
- */
-static const struct lyd_node *
-dm_get_notification_match_node(struct lyd_difflist *diff, size_t index)
-{
-    if (NULL == diff) {
-        return NULL;
-    }
-    switch (diff->type[index]) {
-    case LYD_DIFF_MOVEDAFTER2:
-    case LYD_DIFF_CREATED:
-        return diff->second[index];
-    case LYD_DIFF_MOVEDAFTER1:
-    case LYD_DIFF_CHANGED:
-    case LYD_DIFF_DELETED:
-        return diff->first[index];
-    default:
-        /* LYD_DIFF_END */
-        return NULL;
-    }
-}
-
-/**
- * @brief Returns the xpath of the change
- * @param [in] diff
- * @param [in] index
- * @return Allocated xpath of the changed node
- */
-static char *
-dm_get_notification_changed_xpath(struct lyd_difflist *diff, size_t index)
-{
-    if (NULL == diff) {
-        return NULL;
-    }
-    switch (diff->type[index]) {
-    case LYD_DIFF_MOVEDAFTER2:
-    case LYD_DIFF_CREATED:
-        return lyd_path(diff->second[index]);
-    case LYD_DIFF_MOVEDAFTER1:
-    case LYD_DIFF_CHANGED:
-    case LYD_DIFF_DELETED:
-        return lyd_path(diff->first[index]);
-    default:
-        /* LYD_DIFF_END */
-        return NULL;
-    }
-}
-
-/**
- * @brief Returns string representation of the change type
- * @param [in] type
- * @return statically allocated string
- */
-static const char *
-dm_get_diff_type_to_string(LYD_DIFFTYPE type)
-{
-    const char *diff_states[] = {
-        "End",      /* LYD_DIFF_END = 0*/
-        "Deleted",  /* LYD_DIFF_DELETED */
-        "Changed",  /* LYD_DIFF_CHANGED */
-        "Moved1",   /* LYD_DIFF_MOVEDAFTER1 */
-        "Created",  /* LYD_DIFF_CREATED */
-        "Moved2",   /* LYD_DIFF_MOVEDAFTER2 */
-    };
-    if (type >= sizeof(diff_states)/sizeof(*diff_states)){
-        return "Unknown";
     }
-    return diff_states[type];
-}
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Get schema file name failed");
 
-/**
- * @brief Compares subscriptions by priority.
- */
-int
-dm_subs_cmp(const void *a, const void *b)
-{
-    np_subscription_t **sub_a = (np_subscription_t **) a;
-    np_subscription_t **sub_b = (np_subscription_t **) b;
+    free(file_name);
+    return rc;
 
-    if ((*sub_b)->priority == (*sub_a)->priority) {
-        return 0;
-    } else if ((*sub_b)->priority > (*sub_a)->priority) {
-        return 1;
-    } else {
-        return -1;
+cleanup:
+    free(file_name);
+    if (NULL == sr_mem) {
+        free((void*) rev->revision);
+        free((void*) rev->file_path_yang);
+        free((void*) rev->file_path_yin);
     }
+    return rc;
 }
 
 /**
- *
- * @note Function acquires and releases read lock for the schema info.
- *
- * @param dm_ctx
- * @param schema_info
- * @param model_sub
+ * @brief Fills the schema_t structure for one module all its revisions and submodules
+ * @param [in] dm_ctx
+ * @param [in] dm_session
+ * @param [in] module
+ * @param [in] schs
  * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_prepare_module_subscriptions(dm_ctx_t *dm_ctx, dm_session_t *session, dm_schema_info_t *schema_info,
-        dm_model_subscription_t **model_sub)
+dm_list_module(dm_ctx_t *dm_ctx, dm_session_t *dm_session, md_module_t *module, sr_schema_t *schema)
 {
-    CHECK_NULL_ARG3(dm_ctx, schema_info, model_sub);
+    CHECK_NULL_ARG4(dm_ctx, dm_session, module, schema);
     int rc = SR_ERR_OK;
-    dm_model_subscription_t *ms = NULL;
-    np_subscription_t *sub = NULL;
+    bool module_enabled = false;
+    size_t enabled_subtrees_cnt = 0;
+    char **enabled_subtrees = NULL;
+    sr_llist_node_t *dep = NULL;
+    md_dep_t *dep_mod = NULL;
+    size_t submod_cnt = 0;
+    sr_mem_ctx_t *sr_mem = schema->_sr_mem;
 
-    ms = calloc(1, sizeof(*ms));
-    CHECK_NULL_NOMEM_RETURN(ms);
+    sr_mem_edit_string(sr_mem, (char **)&schema->module_name, module->name);
+    CHECK_NULL_NOMEM_GOTO(schema->module_name, rc, cleanup);
 
-    pthread_rwlock_init(&ms->changes_lock, NULL);
+    sr_mem_edit_string(sr_mem, (char **)&schema->ns, module->ns);
+    CHECK_NULL_NOMEM_GOTO(schema->ns, rc, cleanup);
 
-    rc = np_get_module_change_subscriptions(dm_ctx->np_ctx,
-            session->user_credentials,
-            schema_info->module_name,
-            &ms->subscriptions);
+    sr_mem_edit_string(sr_mem, (char **)&schema->prefix, module->prefix);
+    CHECK_NULL_NOMEM_GOTO(schema->prefix, rc, cleanup);
 
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module subscription failed for module %s", schema_info->module_name);
+    schema->installed = module->installed;
+    schema->implemented = module->implemented;
 
-    if (NULL != ms->subscriptions && ms->subscriptions->count > 0) {
-        qsort(ms->subscriptions->data, ms->subscriptions->count, sizeof(*ms->subscriptions->data), dm_subs_cmp);
+    rc = dm_list_rev_file(dm_ctx, sr_mem, module->name, module->revision_date, &schema->revision);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "List rev file failed module %s", module->name);
 
-        ms->nodes = calloc(ms->subscriptions->count, sizeof(*ms->nodes));
-        CHECK_NULL_NOMEM_GOTO(ms->nodes, rc, cleanup);
+    dep = module->deps->first;
+    while (NULL != dep) {
+        dep_mod = (md_dep_t *) dep->data;
+        dep = dep->next;
+        if (!dep_mod->dest->submodule) {
+            continue;
+        }
+        submod_cnt++;
+    }
 
-        for (size_t s = 0; s < ms->subscriptions->count; s++) {
-            sub = ms->subscriptions->data[s];
-            if (NULL == sub->xpath) {
-                ms->nodes[s] = NULL;
-            } else {
-                rc = rp_dt_validate_node_xpath(dm_ctx, NULL,
-                        sub->xpath,
-                        NULL,
-                        &ms->nodes[s]);
-                if (SR_ERR_OK != rc || NULL == ms->nodes[s]) {
-                    SR_LOG_WRN("Node for xpath %s has not been found", sub->xpath);
-                }
-            }
+    if (0 < submod_cnt) {
+        schema->submodules = sr_calloc(sr_mem, submod_cnt, sizeof(*schema->submodules));
+        CHECK_NULL_NOMEM_GOTO(schema->submodules, rc, cleanup);
+    }
+
+    dep = module->deps->first;
+    size_t s = 0;
+    while (NULL != dep) {
+        dep_mod = (md_dep_t *) dep->data;
+        dep = dep->next;
+        if (!dep_mod->dest->submodule) {
+            continue;
         }
+        sr_mem_edit_string(sr_mem, (char **)&schema->submodules[s].submodule_name, dep_mod->dest->name);
+        CHECK_NULL_NOMEM_GOTO(schema->submodules[s].submodule_name, rc, cleanup);
+
+        rc = dm_list_rev_file(dm_ctx, sr_mem, dep_mod->dest->name, dep_mod->dest->revision_date, &schema->submodules[s].revision);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "List rev file failed module %s", module->name);
+
+        schema->submodule_count++;
+        s++;
     }
 
-    ms->schema_info = schema_info;
+    rc = pm_get_module_info(dm_ctx->pm_ctx, dm_session->user_credentials, module->name, sr_mem, &module_enabled,
+            &enabled_subtrees, &enabled_subtrees_cnt, &schema->enabled_features, &schema->enabled_feature_cnt);
+    if (SR_ERR_OK == rc) {
+        /* release memory */
+        for (size_t i = 0; i < enabled_subtrees_cnt; i++) {
+            free(enabled_subtrees[i]);
+        }
+        free(enabled_subtrees);
+    } else {
+        /* ignore errors in pm */
+        rc = SR_ERR_OK;
+    }
 
 cleanup:
     if (SR_ERR_OK != rc) {
-        dm_model_subscription_free(ms);
-    } else {
-        *model_sub = ms;
+        sr_free_schema(schema);
     }
     return rc;
 }
 
-void
-dm_free_commit_context(void *commit_ctx)
+int
+dm_list_schemas(dm_ctx_t *dm_ctx, dm_session_t *dm_session, sr_schema_t **schemas, size_t *schema_count)
 {
-    if (NULL != commit_ctx) {
+    CHECK_NULL_ARG4(dm_ctx, dm_session, schemas, schema_count);
+    int rc = SR_ERR_OK;
+    md_module_t *module = NULL;
+    sr_llist_node_t *module_ll_node = NULL;
+    size_t i = 0;
+
+    sr_schema_t *sch = NULL;
+    size_t sch_count = 0;
+    sr_mem_ctx_t *sr_mem = NULL;
+
+    md_ctx_lock(dm_ctx->md_ctx, false);
+    module_ll_node = dm_ctx->md_ctx->modules->first;
+    while (module_ll_node) {
+        module = (md_module_t *) module_ll_node->data;
+        module_ll_node = module_ll_node->next;
+        if (module->submodule) {
+            continue;
+        }
+        sch_count++;
+    }
+    if (0 == sch_count) {
+        goto cleanup;
+    }
+
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create a new Sysrepo memory context.");
+    sch = sr_calloc(sr_mem, sch_count, sizeof(*sch));
+    CHECK_NULL_NOMEM_GOTO(sch, rc, cleanup);
+
+    module_ll_node = dm_ctx->md_ctx->modules->first;
+    while (module_ll_node) {
+        module = (md_module_t *) module_ll_node->data;
+        module_ll_node = module_ll_node->next;
+        if (module->submodule) {
+            /* skip submodules */
+            continue;
+        }
+
+        sch[i]._sr_mem = sr_mem;
+        rc = dm_list_module(dm_ctx, dm_session, module, &sch[i]);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "List module %s failed", module->name);
+
+        i++;
+    }
+
+cleanup:
+    md_ctx_unlock(dm_ctx->md_ctx);
+    if (SR_ERR_OK == rc) {
+        if (NULL != sr_mem) {
+            sr_mem->obj_count = 1; /* 1 for the entire array */
+        }
+        *schemas = sch;
+        *schema_count = sch_count;
+    } else {
+        sr_mem_free(sr_mem);
+    }
+    return rc;
+}
+
+int
+dm_get_schema(dm_ctx_t *dm_ctx, const char *module_name, const char *module_revision, const char *submodule_name, const char *submodule_revision, bool yang_format, char **schema)
+{
+    CHECK_NULL_ARG2(dm_ctx, schema);
+    int rc = SR_ERR_OK;
+    int ret = 0;
+    dm_schema_info_t *si = NULL;
+    const struct lys_module *module = NULL;
+    md_module_t *md_module = NULL;
+    sr_llist_node_t *dep_node = NULL;
+    md_dep_t *dependency = NULL;
+    const char *main_module = module_name;
+
+    SR_LOG_INF("Get schema '%s', revision: '%s', submodule: '%s', submodule revision: '%s'", module_name, module_revision, submodule_name, submodule_revision);
+
+    md_ctx_lock(dm_ctx->md_ctx, false);
+    if (submodule_revision || !module_name) {
+        rc = md_get_module_info(dm_ctx->md_ctx, submodule_name, submodule_revision, NULL, &md_module);
+
+        /* find the top main module */
+        while ((NULL != md_module) && (NULL != md_module->inv_deps->first)) {
+            dep_node = md_module->inv_deps->first;
+            while (NULL != dep_node) {
+                dependency = dep_node->data;
+                if (MD_DEP_INCLUDE == dependency->type || MD_DEP_IMPORT == dependency->type) {
+                    break;
+                } else {
+                    dep_node = dep_node->next;
+                }
+            }
+            if (NULL != dep_node) {
+                md_module = dependency->dest;
+            } else {
+                break;
+            }
+        }
+        if (NULL != md_module) {
+            main_module = md_module->name;
+        }
+
+        md_ctx_unlock(dm_ctx->md_ctx);
+        CHECK_RC_LOG_RETURN(rc, "Submodule %s in revision %s not found", submodule_name, submodule_revision);
+    } else {
+        rc = md_get_module_info(dm_ctx->md_ctx, module_name, module_revision, NULL, &md_module);
+
+        if (NULL != md_module && !md_module->latest_revision) {
+            /* find a module in latest revision that includes the requested module
+             * this handles the case that requested module is included in older revision by other module */
+            dep_node = md_module->inv_deps->first;
+            while (NULL != dep_node) {
+                dependency = dep_node->data;
+                dep_node = dep_node->next;
+                if (!dependency->dest->submodule && dependency->dest->latest_revision) {
+                    main_module = dependency->dest->name;
+                    break;
+                }
+            }
+        }
+
+        md_ctx_unlock(dm_ctx->md_ctx);
+        CHECK_RC_LOG_RETURN(rc, "Module %s in revision %s not found", module_name, module_revision);
+    }
+
+    rc = dm_get_module_and_lockw(dm_ctx, main_module, &si);
+    CHECK_RC_LOG_RETURN(rc, "Get module failed for %s", main_module);
+
+    if (NULL != submodule_name) {
+        module = (const struct lys_module *) ly_ctx_get_submodule(si->ly_ctx, module_name, module_revision, submodule_name, submodule_revision);
+    } else {
+        module = ly_ctx_get_module(si->ly_ctx, module_name, module_revision, 0);
+    }
+
+    if (NULL == module) {
+        SR_LOG_ERR("Not found module %s (revision %s) submodule %s (revision %s)", module_name, module_revision, submodule_name, submodule_revision);
+        rc = SR_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    ret = lys_print_mem(schema, module, yang_format ? LYS_OUT_YANG : LYS_OUT_YIN, NULL, 0, 0);
+    CHECK_ZERO_LOG_GOTO(ret, rc, SR_ERR_INTERNAL, cleanup, "Module %s print failed.", si->module_name);
+
+cleanup:
+    pthread_rwlock_unlock(&si->model_lock);
+    return rc;
+}
+
+static void
+dm_record_errors(int rc, sr_error_info_t **errors, size_t *err_cnt, dm_data_info_t *info)
+{
+    if (SR_ERR_VALIDATION_FAILED == rc) {
+        if (SR_ERR_OK != sr_add_error(errors, err_cnt, ly_errpath(info->schema->module->ctx), "%s",
+                                        ly_errmsg(info->schema->module->ctx))) {
+            SR_LOG_WRN_MSG("Failed to record validation error");
+        }
+    } else {
+        if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, "Validation failed: %s",
+                                        sr_strerror(rc))) {
+            SR_LOG_WRN_MSG("Failed to record validation error");
+        }
+    }
+}
+
+static void
+dm_invalidate_leaf_refs(struct lyd_node *root)
+{
+    struct lyd_node *data = NULL, *next = NULL, *iter = NULL;
+    LY_TREE_FOR(root, data) {
+        LY_TREE_DFS_BEGIN(data, next, iter) {
+            switch (iter->schema->nodetype) {
+            case LYS_LEAFLIST:
+            case LYS_LEAF:
+                if (((struct lys_node_leaf *)iter->schema)->type.base == LY_TYPE_LEAFREF) {
+                    iter->validity |= LYD_VAL_LEAFREF;
+                }
+                break;
+            default:
+                break;
+            }
+            LY_TREE_DFS_END(data, next, iter)
+        }
+    }
+}
+
+static int
+dm_validate_module_inv_data_deps(dm_ctx_t *dm_ctx, dm_session_t *session, sr_error_info_t **errors,
+                                 size_t *err_cnt, const char *module_name)
+{
+    dm_data_info_t *info = NULL;
+    bool must_free_info = false;
+    int rc = SR_ERR_OK;
+    md_module_t *module = NULL;
+    sr_llist_node_t *ll_node = NULL;
+    md_dep_t *dep = NULL;
+    bool validation_failed = false;
+    bool is_enabled = false;
+    sr_datastore_t ds = session->datastore;
+
+    md_ctx_lock(dm_ctx->md_ctx, false);
+    rc = md_get_module_info(dm_ctx->md_ctx, module_name, NULL, NULL, &module);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module %s info failed", module_name);
+
+    ll_node = module->inv_deps->first;
+    while (ll_node) {
+        dep = (md_dep_t *)ll_node->data;
+        ll_node = ll_node->next;
+
+        if (dep->type != MD_DEP_DATA || !dep->dest->has_data) {
+            continue;
+        }
+
+        rc = dm_has_enabled_subtree(dm_ctx, dep->dest->name, NULL, &is_enabled);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to check whether module is enabled for %s", dep->dest->name);
+        if (!is_enabled && (ds == SR_DS_RUNNING)) {
+            /* use startup data in this case */
+            session->datastore = SR_DS_STARTUP;
+        }
+
+        rc = dm_get_data_info_internal(dm_ctx, session, dep->dest->name, true, false, &must_free_info, &info);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load data info for %s", dep->dest->name);
+
+        session->datastore = ds;
+
+        /* The dependent data has changed, so leaf refs might not be valid anymore */
+        dm_invalidate_leaf_refs(info->node);
+        rc = dm_validate_data_info(dm_ctx, session, info);
+        if (rc != SR_ERR_OK) {
+            dm_record_errors(rc, errors, err_cnt, info);
+            validation_failed = true;
+            rc = SR_ERR_OK;
+        }
+
+        if (must_free_info) {
+            dm_data_info_free(info);
+        }
+    }
+
+cleanup:
+    md_ctx_unlock(dm_ctx->md_ctx);
+    if(validation_failed) {
+        rc = SR_ERR_VALIDATION_FAILED;
+    }
+    return rc;
+}
+
+int
+dm_validate_session_data_trees(dm_ctx_t *dm_ctx, dm_session_t *session, sr_error_info_t **errors, size_t *err_cnt)
+{
+    CHECK_NULL_ARG4(dm_ctx, session, errors, err_cnt);
+    int rc = SR_ERR_OK;
+
+    size_t cnt = 0;
+    *err_cnt = 0;
+    dm_data_info_t *info = NULL;
+    sr_llist_t *session_modules = NULL;
+    sr_llist_node_t *node = NULL;
+    bool validation_failed = false;
+
+    rc = sr_llist_init(&session_modules);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Cannot initialize temporary linked-list for session modules.");
+
+    /* collect the list of modules first, it may change during the validation */
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], cnt))) {
+        sr_llist_add_new(session_modules, info);
+        cnt++;
+    }
+
+    node = session_modules->first;
+    while (NULL != node) {
+        info = (dm_data_info_t *)node->data;
+        /* loaded data trees are valid, so check only the modified ones */
+        if (info->modified) {
+            rc = dm_validate_data_info(dm_ctx, session, info);
+            if (rc != SR_ERR_OK) {
+                dm_record_errors(rc, errors, err_cnt, info);
+                validation_failed = true;
+                rc = SR_ERR_OK;
+            }
+            rc = dm_validate_module_inv_data_deps(dm_ctx, session, errors, err_cnt, info->schema->module_name);
+            if (rc != SR_ERR_OK) {
+                validation_failed = true;
+                rc = SR_ERR_OK;
+            }
+        }
+        node = node->next;
+    }
+
+cleanup:
+    if (validation_failed) {
+        rc = SR_ERR_VALIDATION_FAILED;
+    }
+    sr_llist_cleanup(session_modules);
+    return rc;
+}
+
+int
+dm_discard_changes(dm_ctx_t *dm_ctx, dm_session_t *session, const char *module_name)
+{
+    CHECK_NULL_ARG2(dm_ctx, session);
+    int rc = SR_ERR_OK, i;
+    dm_data_info_t *info = NULL;
+
+    if (NULL == module_name) {
+        sr_btree_cleanup(session->session_modules[session->datastore]);
+        session->session_modules[session->datastore] = NULL;
+
+        rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &session->session_modules[session->datastore]);
+        CHECK_RC_MSG_RETURN(rc, "Binary tree allocation failed");
+        dm_free_sess_operations(session->operations[session->datastore], session->oper_count[session->datastore]);
+        session->operations[session->datastore] = NULL;
+        session->oper_count[session->datastore] = 0;
+        session->oper_size[session->datastore] = 0;
+    } else {
+        i = 0;
+        while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+            if (0 == strcmp(info->schema->module->name, module_name)) {
+                sr_btree_delete(session->session_modules[session->datastore], info);
+                break;
+            }
+        }
+
+        for (i = session->oper_count[session->datastore] - 1; i >= 0; i--) {
+            dm_sess_op_t *op = &session->operations[session->datastore][i];
+            if (0 == sr_cmp_first_ns(op->xpath, module_name)) {
+                dm_free_sess_op(op);
+                memmove(&session->operations[session->datastore][i],
+                        &session->operations[session->datastore][i + 1],
+                        (session->oper_count[session->datastore] - i - 1) * sizeof(*op));
+                session->oper_count[session->datastore]--;
+            }
+        }
+    }
+
+    return SR_ERR_OK;
+}
+
+int
+dm_remove_modified_flag(dm_session_t* session)
+{
+    int rc = SR_ERR_OK;
+    dm_data_info_t *info = NULL;
+    size_t cnt = 0;
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], cnt))) {
+        /* remove modified flag */
+        info->modified = false;
+        cnt++;
+    }
+    return rc;
+}
+
+int
+dm_remove_session_operations(dm_session_t *session)
+{
+    CHECK_NULL_ARG(session);
+    while (session->oper_count[session->datastore] > 0) {
+        dm_remove_last_operation(session);
+    }
+    return SR_ERR_OK;
+}
+
+static int
+dm_is_info_copy_uptodate(dm_ctx_t *dm_ctx, const char *file_name, const dm_data_info_t *info, bool *res)
+{
+    CHECK_NULL_ARG4(dm_ctx, file_name, info, res);
+    int rc = SR_ERR_OK;
+#ifdef HAVE_STAT_ST_MTIM
+    struct stat st = {0};
+    rc = stat(file_name, &st);
+    if (-1 == rc) {
+        SR_LOG_ERR_MSG("Stat failed");
+        return SR_ERR_INTERNAL;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    SR_LOG_DBG("Session copy %s: mtime sec=%lld nsec=%lld", info->schema->module->name,
+            (long long) info->timestamp.tv_sec,
+            (long long) info->timestamp.tv_nsec);
+    SR_LOG_DBG("Loaded module %s: mtime sec=%lld nsec=%lld", info->schema->module->name,
+            (long long) st.st_mtim.tv_sec,
+            (long long) st.st_mtim.tv_nsec);
+    SR_LOG_DBG("Current time: mtime sec=%lld nsec=%lld",
+            (long long) now.tv_sec,
+            (long long) now.tv_nsec);
+    /* check if we should update session copy conditions
+     * is the negation of the optimized commit */
+    if (info->timestamp.tv_sec != st.st_mtim.tv_sec ||
+            info->timestamp.tv_nsec != st.st_mtim.tv_nsec ||
+            (now.tv_sec == st.st_mtim.tv_sec && difftime(now.tv_nsec, st.st_mtim.tv_nsec) < NANOSEC_THRESHOLD) ||
+            info->timestamp.tv_sec < dm_ctx->last_commit_time.tv_sec ||
+            (info->timestamp.tv_sec == dm_ctx->last_commit_time.tv_sec && info->timestamp.tv_nsec <= dm_ctx->last_commit_time.tv_nsec) ||
+            info->timestamp.tv_nsec == 0) {
+        SR_LOG_DBG("Module %s will be refreshed", info->schema->module->name);
+        *res = false;
+
+    } else {
+        *res = true;
+    }
+#else
+    *res = false;
+#endif
+    return rc;
+
+}
+
+int
+dm_update_session_data_trees(dm_ctx_t *dm_ctx, dm_session_t *session, sr_list_t **up_to_date_models)
+{
+    CHECK_NULL_ARG3(dm_ctx, session, up_to_date_models);
+    int rc = SR_ERR_OK;
+    int fd = -1;
+    char *file_name = NULL;
+    dm_data_info_t *info = NULL;
+    size_t i = 0;
+    sr_list_t *to_be_refreshed = NULL, *up_to_date = NULL;
+    rc = sr_list_init(&to_be_refreshed);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+
+    rc = sr_list_init(&up_to_date);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        rc = sr_get_data_file_name(dm_ctx->data_search_dir,
+                info->schema->module->name,
+                SR_DS_CANDIDATE == session->datastore ? SR_DS_RUNNING : session->datastore,
+                &file_name);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Get data file name failed");
+        ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+        fd = open(file_name, O_RDONLY);
+        ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+
+        if (-1 == fd) {
+            SR_LOG_DBG("File %s can not be opened for read write", file_name);
+            if (EACCES == errno) {
+                SR_LOG_WRN("File %s can not be opened because of authorization", file_name);
+            } else if (ENOENT == errno) {
+                SR_LOG_DBG("File %s does not exist, trying to create an empty one", file_name);
+            }
+            /* skip data trees that was not successfully opened */
+            free(file_name);
+            file_name = NULL;
+            continue;
+        }
+
+        /* lock for read, blocking - guards access to the file among processes.
+         * Inside the process access to data files is protected by commit_lock in rp.
+         * Each request that might need to read data file locks it for read at the beginning
+         * of request processing. */
+        rc = sr_lock_fd(fd, false, true);
+
+        bool copy_uptodate = false;
+        rc = dm_is_info_copy_uptodate(dm_ctx, file_name, info, &copy_uptodate);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR_MSG("File up to date check failed");
+            close(fd);
+            goto cleanup;
+        }
+
+        if (copy_uptodate) {
+            if (info->modified) {
+                rc = sr_list_add(up_to_date, (void *) info->schema->module->name);
+            }
+        } else {
+            SR_LOG_DBG("Module %s will be refreshed", info->schema->module->name);
+            rc = sr_list_add(to_be_refreshed, info);
+        }
+        free(file_name);
+        file_name = NULL;
+        close(fd);
+
+        CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
+
+    }
+
+    for (i = 0; i < to_be_refreshed->count; i++) {
+        sr_btree_delete(session->session_modules[session->datastore], to_be_refreshed->data[i]);
+    }
+
+cleanup:
+    sr_list_cleanup(to_be_refreshed);
+    if (SR_ERR_OK == rc) {
+        *up_to_date_models = up_to_date;
+    } else {
+        sr_list_cleanup(up_to_date);
+    }
+    free(file_name);
+    return rc;
+}
+
+void
+dm_remove_operations_with_error(dm_session_t *session)
+{
+    CHECK_NULL_ARG_VOID(session);
+    for (int i = session->oper_count[session->datastore] - 1; i >= 0; i--) {
+        dm_sess_op_t *op = &session->operations[session->datastore][i];
+        if (op->has_error) {
+            dm_free_sess_op(op);
+            memmove(&session->operations[session->datastore][i],
+                    &session->operations[session->datastore][i + 1],
+                    (session->oper_count[session->datastore] - i - 1) * sizeof(*op));
+            session->oper_count[session->datastore]--;
+        }
+    }
+}
+
+/**
+ * @brief whether the node match the subscribed one - if it is the same node or children
+ * of the subscribed one
+ * @param [in] sub_node
+ * @param [in] node tested node
+ * @param [out] res
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_match_subscription(const struct lys_node *sub_node, const struct lyd_node *node, bool *res)
+{
+    CHECK_NULL_ARG2(node, res);
+
+    if (NULL == sub_node) {
+        *res = true;
+        return SR_ERR_OK;
+    }
+
+    /* check if a node has been changes under subscriptions */
+    struct lys_node *n = (struct lys_node *) node->schema;
+    while (NULL != n) {
+        if (sub_node == n) {
+            *res = true;
+            return SR_ERR_OK;
+        }
+        n = lys_parent(n);
+    }
+
+    /* if a container/list has been created/deleted check if there
+     * a more specific subscription
+     * e.g: subscription to /container/list/leaf
+     *      container has been deleted
+     */
+    if ((LYS_CONTAINER | LYS_LIST) & node->schema->nodetype) {
+        struct lys_node *n = (struct lys_node *) sub_node;
+        bool subsc_under_modif = false;
+        while (NULL != n) {
+            if (node->schema == n) {
+                subsc_under_modif = true;
+                break;
+            }
+            n = lys_parent(n);
+        }
+
+        if (!subsc_under_modif) {
+            goto not_matched;
+        }
+
+        /* check whether a subscribed children has been created/deleted */
+        struct lyd_node *next = NULL, *iter = NULL;
+        LY_TREE_DFS_BEGIN((struct lyd_node *) node, next, iter){
+            if (sub_node == iter->schema){
+                *res = true;
+                return SR_ERR_OK;
+            }
+            LYD_TREE_DFS_END(node, next, iter);
+        }
+
+    }
+
+not_matched:
+    *res = false;
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Returns the node to be tested whether the changes matches the subscription
+ * @param [in] diff
+ * @param [in] index
+ * @return  Schema node of the change
+ */
+static const struct lyd_node *
+dm_get_notification_match_node(struct lyd_difflist *diff, size_t index)
+{
+    if (NULL == diff) {
+        return NULL;
+    }
+    switch (diff->type[index]) {
+    case LYD_DIFF_MOVEDAFTER2:
+    case LYD_DIFF_CREATED:
+        return diff->second[index];
+    case LYD_DIFF_MOVEDAFTER1:
+    case LYD_DIFF_CHANGED:
+    case LYD_DIFF_DELETED:
+        return diff->first[index];
+    default:
+        /* LYD_DIFF_END */
+        return NULL;
+    }
+}
+
+/**
+ * @brief Returns the xpath of the change
+ * @param [in] diff
+ * @param [in] index
+ * @return Allocated xpath of the changed node
+ */
+static char *
+dm_get_notification_changed_xpath(struct lyd_difflist *diff, size_t index)
+{
+    if (NULL == diff) {
+        return NULL;
+    }
+    switch (diff->type[index]) {
+    case LYD_DIFF_MOVEDAFTER2:
+    case LYD_DIFF_CREATED:
+        return lyd_path(diff->second[index]);
+    case LYD_DIFF_MOVEDAFTER1:
+    case LYD_DIFF_CHANGED:
+    case LYD_DIFF_DELETED:
+        return lyd_path(diff->first[index]);
+    default:
+        /* LYD_DIFF_END */
+        return NULL;
+    }
+}
+
+/**
+ * @brief Returns string representation of the change type
+ * @param [in] type
+ * @return statically allocated string
+ */
+static const char *
+dm_get_diff_type_to_string(LYD_DIFFTYPE type)
+{
+    const char *diff_states[] = {
+        "End",      /* LYD_DIFF_END = 0*/
+        "Deleted",  /* LYD_DIFF_DELETED */
+        "Changed",  /* LYD_DIFF_CHANGED */
+        "Moved1",   /* LYD_DIFF_MOVEDAFTER1 */
+        "Created",  /* LYD_DIFF_CREATED */
+        "Moved2",   /* LYD_DIFF_MOVEDAFTER2 */
+    };
+    if (type >= sizeof(diff_states)/sizeof(*diff_states)){
+        return "Unknown";
+    }
+    return diff_states[type];
+}
+
+/**
+ * @brief Compares subscriptions by priority.
+ */
+int
+dm_subs_cmp(const void *a, const void *b)
+{
+    np_subscription_t **sub_a = (np_subscription_t **) a;
+    np_subscription_t **sub_b = (np_subscription_t **) b;
+
+    if ((*sub_b)->priority == (*sub_a)->priority) {
+        return 0;
+    } else if ((*sub_b)->priority > (*sub_a)->priority) {
+        return 1;
+    } else {
+        return -1;
+    }
+}
+
+/**
+ *
+ * @note Function acquires and releases read lock for the schema info.
+ *
+ * @param dm_ctx
+ * @param schema_info
+ * @param model_sub
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_prepare_module_subscriptions(dm_ctx_t *dm_ctx, dm_session_t *session, dm_schema_info_t *schema_info,
+        dm_model_subscription_t **model_sub)
+{
+    CHECK_NULL_ARG3(dm_ctx, schema_info, model_sub);
+    int rc = SR_ERR_OK;
+    dm_model_subscription_t *ms = NULL;
+    np_subscription_t *sub = NULL;
+
+    ms = calloc(1, sizeof(*ms));
+    CHECK_NULL_NOMEM_RETURN(ms);
+
+    pthread_rwlock_init(&ms->changes_lock, NULL);
+
+    rc = np_get_module_change_subscriptions(dm_ctx->np_ctx,
+            session->user_credentials,
+            schema_info->module_name,
+            &ms->subscriptions);
+
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module subscription failed for module %s", schema_info->module_name);
+
+    if (NULL != ms->subscriptions && ms->subscriptions->count > 0) {
+        qsort(ms->subscriptions->data, ms->subscriptions->count, sizeof(*ms->subscriptions->data), dm_subs_cmp);
+
+        ms->nodes = calloc(ms->subscriptions->count, sizeof(*ms->nodes));
+        CHECK_NULL_NOMEM_GOTO(ms->nodes, rc, cleanup);
+
+        for (size_t s = 0; s < ms->subscriptions->count; s++) {
+            sub = ms->subscriptions->data[s];
+            if (NULL == sub->xpath) {
+                ms->nodes[s] = NULL;
+            } else {
+                rc = rp_dt_validate_node_xpath(dm_ctx, NULL,
+                        sub->xpath,
+                        NULL,
+                        &ms->nodes[s]);
+                if (SR_ERR_OK != rc || NULL == ms->nodes[s]) {
+                    SR_LOG_WRN("Node for xpath %s has not been found", sub->xpath);
+                }
+            }
+        }
+
+        /* index the subscriptions by their nodes and by the ancestors of their nodes,
+         * so that each change is matched against the interested subscriptions only */
+        rc = dm_node_index_init(&ms->nodes_index);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Node index init failed");
+        for (size_t s = 0; s < ms->subscriptions->count; s++) {
+            rc = dm_node_index_add(ms->nodes_index, ms->nodes[s], s, false);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Node index add failed");
+            if (NULL == ms->nodes[s]) {
+                continue;
+            }
+            for (struct lys_node *n = lys_parent(ms->nodes[s]); NULL != n; n = lys_parent(n)) {
+                rc = dm_node_index_add(ms->nodes_index, n, s, true);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Node index add failed");
+            }
+        }
+    }
+
+    ms->schema_info = schema_info;
+
+cleanup:
+    if (SR_ERR_OK != rc) {
+        dm_model_subscription_free(ms);
+    } else {
+        *model_sub = ms;
+    }
+    return rc;
+}
+
+void
+dm_free_commit_context(void *commit_ctx)
+{
+    if (NULL != commit_ctx) {
         dm_commit_context_t *c_ctx = commit_ctx;
         for (size_t i = 0; i < c_ctx->modif_count; i++) {
             close(c_ctx->fds[i]);
         }
-        pthread_mutex_destroy(&c_ctx->mutex);
-        free(c_ctx->fds);
-        free(c_ctx->existed);
-        sr_list_cleanup(c_ctx->up_to_date_models);
-        c_ctx->up_to_date_models = NULL;
-        c_ctx->fds = NULL;
-        c_ctx->existed = NULL;
-        c_ctx->modif_count = 0;
+        pthread_mutex_destroy(&c_ctx->mutex);
+        free(c_ctx->fds);
+        free(c_ctx->existed);
+        sr_list_cleanup(c_ctx->up_to_date_models);
+        c_ctx->up_to_date_models = NULL;
+        c_ctx->fds = NULL;
+        c_ctx->existed = NULL;
+        c_ctx->modif_count = 0;
+
+        sr_btree_cleanup(c_ctx->subscriptions);
+        sr_btree_cleanup(c_ctx->prev_data_trees);
+        if (NULL != c_ctx->session) {
+            dm_session_stop(c_ctx->session->dm_ctx, c_ctx->session);
+        }
+        if (NULL != c_ctx->err_subs_xpaths) {
+            for (size_t i = 0; i < c_ctx->err_subs_xpaths->count; i++) {
+                free(c_ctx->err_subs_xpaths->data[i]);
+            }
+            sr_list_cleanup(c_ctx->err_subs_xpaths);
+        }
+        if (NULL != c_ctx->errors && 0 != c_ctx->err_cnt) {
+            sr_free_errors(c_ctx->errors, c_ctx->err_cnt);
+        }
+        c_ctx->session = NULL;
+        sr_btree_cleanup(c_ctx->difflists);
+        if (NULL != c_ctx->backup_session) {
+            dm_session_stop(c_ctx->backup_session->dm_ctx, c_ctx->backup_session);
+        }
+        free(c_ctx);
+    }
+}
+
+int
+dm_node_index_init(sr_btree_t **index)
+{
+    CHECK_NULL_ARG(index);
+    return sr_btree_init(dm_node_index_entry_cmp, dm_node_index_entry_free, index);
+}
+
+int
+dm_node_index_add(sr_btree_t *index, const struct lys_node *node, size_t item, bool descendant)
+{
+    CHECK_NULL_ARG(index);
+    int rc = SR_ERR_OK;
+    dm_node_index_entry_t *entry = NULL, lookup = {0};
+    size_t **items = NULL, *cnt = NULL, *tmp = NULL;
+
+    lookup.node = node;
+    entry = sr_btree_search(index, &lookup);
+    if (NULL == entry) {
+        entry = calloc(1, sizeof(*entry));
+        CHECK_NULL_NOMEM_RETURN(entry);
+        entry->node = node;
+        rc = sr_btree_insert(index, entry);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR_MSG("Insert into the node index failed");
+            free(entry);
+            return rc;
+        }
+    }
+
+    items = descendant ? &entry->desc_items : &entry->items;
+    cnt = descendant ? &entry->desc_item_cnt : &entry->item_cnt;
+
+    /* an item is usually added several times in a row for the same node */
+    if (0 < *cnt && item == (*items)[*cnt - 1]) {
+        return rc;
+    }
+
+    tmp = realloc(*items, (*cnt + 1) * sizeof(**items));
+    CHECK_NULL_NOMEM_RETURN(tmp);
+    *items = tmp;
+    (*items)[(*cnt)++] = item;
+
+    return rc;
+}
+
+dm_node_index_entry_t *
+dm_node_index_get(sr_btree_t *index, const struct lys_node *node)
+{
+    dm_node_index_entry_t lookup = {0};
+
+    if (NULL == index) {
+        return NULL;
+    }
+    lookup.node = node;
+    return sr_btree_search(index, &lookup);
+}
+
+/**
+ * @brief Tests whether the data provider subscription index has been built from the given subscriptions.
+ * The index holds references to its subscriptions, so a pointer comparison is sufficient.
+ */
+static bool
+dm_dp_index_matches(dm_dp_index_t *dp_index, sr_list_t *subscriptions)
+{
+    if (NULL == dp_index || NULL == subscriptions || dp_index->subscriptions->count != subscriptions->count) {
+        return false;
+    }
+    for (size_t i = 0; i < subscriptions->count; i++) {
+        if (dp_index->subscriptions->data[i] != subscriptions->data[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the index of data provider subscriptions by their schema nodes.
+ */
+static int
+dm_dp_index_build(dm_ctx_t *dm_ctx, sr_list_t *subscriptions, dm_dp_index_t **dp_index)
+{
+    CHECK_NULL_ARG3(dm_ctx, subscriptions, dp_index);
+    int rc = SR_ERR_OK;
+    dm_dp_index_t *index = NULL;
+    np_subscription_t *subscription = NULL;
+    struct lys_node *node = NULL;
+
+    index = calloc(1, sizeof(*index));
+    CHECK_NULL_NOMEM_RETURN(index);
+    index->ref_count = 1;
+
+    rc = sr_list_init(&index->subscriptions);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+
+    rc = sr_list_init(&index->nodes);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+
+    rc = dm_node_index_init(&index->nodes_index);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Node index init failed");
+
+    for (size_t i = 0; i < subscriptions->count; i++) {
+        subscription = subscriptions->data[i];
+        rc = rp_dt_validate_node_xpath(dm_ctx, NULL, subscription->xpath, NULL, &node);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Node validation failed for xpath %s", subscription->xpath);
+
+        rc = sr_list_add(index->subscriptions, subscription);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
+        ATOMIC_INC(&subscription->copy_cnt);
+
+        rc = sr_list_add(index->nodes, node);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
+
+        if (NULL == node) {
+            continue;
+        }
+        /* the subscription covers its node, its ancestors can be partially provided by it */
+        rc = dm_node_index_add(index->nodes_index, node, i, false);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Node index add failed");
+        for (struct lys_node *n = lys_parent(node); NULL != n; n = lys_parent(n)) {
+            rc = dm_node_index_add(index->nodes_index, n, i, true);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Node index add failed");
+        }
+    }
+
+cleanup:
+    if (SR_ERR_OK != rc) {
+        dm_dp_index_release(index);
+    } else {
+        *dp_index = index;
+    }
+    return rc;
+}
+
+int
+dm_get_dp_index(dm_ctx_t *dm_ctx, dm_schema_info_t *schema_info, sr_list_t *subscriptions, dm_dp_index_t **dp_index)
+{
+    CHECK_NULL_ARG4(dm_ctx, schema_info, subscriptions, dp_index);
+    int rc = SR_ERR_OK;
+    dm_dp_index_t *index = NULL, *replaced = NULL;
+
+    pthread_mutex_lock(&schema_info->usage_count_mutex);
+    if (dm_dp_index_matches(schema_info->dp_index, subscriptions)) {
+        index = schema_info->dp_index;
+        ATOMIC_INC(&index->ref_count);
+    }
+    pthread_mutex_unlock(&schema_info->usage_count_mutex);
+
+    if (NULL != index) {
+        SR_LOG_DBG("Cached index of %zu data provider subscriptions of %s reused", subscriptions->count,
+                schema_info->module_name);
+        *dp_index = index;
+        return SR_ERR_OK;
+    }
+
+    rc = dm_dp_index_build(dm_ctx, subscriptions, &index);
+    CHECK_RC_LOG_RETURN(rc, "Failed to index data provider subscriptions of %s", schema_info->module_name);
+
+    ATOMIC_INC(&index->ref_count); /* the cache and the caller */
+    pthread_mutex_lock(&schema_info->usage_count_mutex);
+    replaced = schema_info->dp_index;
+    schema_info->dp_index = index;
+    pthread_mutex_unlock(&schema_info->usage_count_mutex);
+    dm_dp_index_release(replaced);
+
+    *dp_index = index;
+    return rc;
+}
+
+void
+dm_dp_index_invalidate(dm_ctx_t *dm_ctx, const char *module_name)
+{
+    CHECK_NULL_ARG_VOID2(dm_ctx, module_name);
+    dm_schema_info_t lookup = {0}, *si = NULL;
+    dm_dp_index_t *dropped = NULL;
+
+    lookup.module_name = (char *) module_name;
+    pthread_rwlock_rdlock(&dm_ctx->schema_tree_lock);
+    si = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
+    if (NULL != si) {
+        pthread_mutex_lock(&si->usage_count_mutex);
+        dropped = si->dp_index;
+        si->dp_index = NULL;
+        pthread_mutex_unlock(&si->usage_count_mutex);
+    }
+    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+
+    dm_dp_index_release(dropped);
+}
+
+static int
+dm_insert_commit_context(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
+{
+    CHECK_NULL_ARG2(dm_ctx, c_ctx);
+    int rc = SR_ERR_OK;
+    RWLOCK_WRLOCK_TIMED_CHECK_RETURN(&dm_ctx->commit_ctxs.lock);
+    pthread_mutex_lock(&dm_ctx->commit_ctxs.empty_mutex);
+    if (!dm_ctx->commit_ctxs.commits_blocked) {
+        rc = sr_btree_insert(dm_ctx->commit_ctxs.tree, c_ctx);
+        if (SR_ERR_OK == rc) {
+            c_ctx->in_btree = true;
+            dm_ctx->commit_ctxs.empty = false;
+        }
+    } else {
+        SR_LOG_ERR_MSG("Commit context can not be inserted, commits are blocked cleanup was requested");
+        rc = SR_ERR_OPERATION_FAILED;
+    }
+    pthread_mutex_unlock(&dm_ctx->commit_ctxs.empty_mutex);
+    pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
+    return rc;
+}
+
+static int
+dm_remove_commit_context(dm_ctx_t *dm_ctx, uint32_t c_ctx_id)
+{
+    pthread_rwlock_wrlock(&dm_ctx->commit_ctxs.lock);
+    dm_commit_context_t *c_ctx = NULL;
+    dm_commit_context_t lookup = {0};
+    lookup.id = c_ctx_id;
+    c_ctx = sr_btree_search(dm_ctx->commit_ctxs.tree, &lookup);
+    if (NULL == c_ctx) {
+        SR_LOG_WRN("Commit context with id %d not found", c_ctx_id);
+    } else {
+        sr_btree_delete(dm_ctx->commit_ctxs.tree, c_ctx);
+        SR_LOG_DBG("Commit context with id %"PRIu32" removed", c_ctx_id);
+        pthread_mutex_lock(&dm_ctx->commit_ctxs.empty_mutex);
+        if (NULL == sr_btree_get_at(dm_ctx->commit_ctxs.tree, 0)) {
+            dm_ctx->commit_ctxs.empty = true;
+            pthread_cond_broadcast(&dm_ctx->commit_ctxs.empty_cond);
+        }
+        pthread_mutex_unlock(&dm_ctx->commit_ctxs.empty_mutex);
+    }
+    pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
+    return SR_ERR_OK;
+}
+
+int
+dm_commit_notifications_complete(dm_ctx_t *dm_ctx, uint32_t c_ctx_id)
+{
+    return dm_remove_commit_context(dm_ctx, c_ctx_id);
+}
+
+/**
+ * @brief Releases resources that are no more needed after SR_EV_APPLY or SR_EV_ABORT
+ *
+ */
+static int
+dm_release_resources_commit_context(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
+{
+    CHECK_NULL_ARG(c_ctx);
+    for (size_t i = 0; i < c_ctx->modif_count; i++) {
+        close(c_ctx->fds[i]);
+    }
+    free(c_ctx->fds);
+    free(c_ctx->existed);
+    sr_list_cleanup(c_ctx->up_to_date_models);
+    c_ctx->up_to_date_models = NULL;
+    c_ctx->fds = NULL;
+    c_ctx->existed = NULL;
+    c_ctx->modif_count = 0;
+
+    dm_unlock_datastore(dm_ctx, c_ctx->session);
+
+    return SR_ERR_OK;
+}
+
+static int
+dm_save_commit_context(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
+{
+    CHECK_NULL_ARG(c_ctx);
+    int rc = SR_ERR_OK;
+    /* assign id to the commit context and save it to th dm_ctx */
+    rc = dm_insert_commit_context(dm_ctx, c_ctx);
+
+    return rc;
+
+}
+
+static int
+dm_create_commit_ctx_id(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
+{
+    CHECK_NULL_ARG2(dm_ctx, c_ctx);
+
+    pthread_rwlock_rdlock(&dm_ctx->commit_ctxs.lock);
+    size_t attempts = 0;
+    /* generate unique id */
+    do {
+        c_ctx->id = rand();
+        if (NULL != sr_btree_search(dm_ctx->commit_ctxs.tree, c_ctx)) {
+            c_ctx->id = DM_COMMIT_CTX_ID_INVALID;
+        }
+        if (++attempts > DM_COMMIT_CTX_ID_MAX_ATTEMPTS) {
+            SR_LOG_ERR_MSG("Unable to generate an unique session_id.");
+            pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
+            return SR_ERR_INTERNAL;
+        }
+    } while (DM_COMMIT_CTX_ID_INVALID == c_ctx->id);
+
+    pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
+    return SR_ERR_OK;
+}
+
+
+int
+dm_commit_prepare_context(dm_ctx_t *dm_ctx, dm_session_t *session, dm_commit_context_t **commit_ctx)
+{
+    CHECK_NULL_ARG2(session, commit_ctx);
+    dm_data_info_t *info = NULL;
+    size_t i = 0;
+    int rc = SR_ERR_OK;
+    dm_model_subscription_t *ms = NULL;
+    dm_commit_context_t *c_ctx = NULL;
+    c_ctx = calloc(1, sizeof(*c_ctx));
+    CHECK_NULL_NOMEM_RETURN(c_ctx);
+
+    rc = dm_create_commit_ctx_id(dm_ctx, c_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit context id generating failed");
+
+    pthread_mutex_init(&c_ctx->mutex, NULL);
+
+    rc = sr_btree_init(dm_module_subscription_cmp, dm_model_subscription_free, &c_ctx->subscriptions);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+
+    rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &c_ctx->prev_data_trees);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+
+    rc = sr_btree_init(dm_module_difflist_cmp, dm_module_difflist_free, &c_ctx->difflists);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+
+    c_ctx->modif_count = 0;
+    /* count modified files */
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i))) {
+        if (info->modified) {
+            c_ctx->modif_count++;
+
+            if (SR_DS_RUNNING == session->datastore) {
+                rc = dm_prepare_module_subscriptions(dm_ctx, session, info->schema, &ms);
+                CHECK_RC_LOG_GOTO(rc, cleanup, "Prepare module subscription failed %s", info->schema->module->name);
+
+                rc = sr_btree_insert(c_ctx->subscriptions, ms);
+                CHECK_RC_LOG_GOTO(rc, cleanup, "Insert into subscription tree failed module %s", info->schema->module->name);
+            }
+            ms = NULL;
+        }
+        i++;
+    }
+
+    SR_LOG_DBG("Commit: In the session there are %zu / %zu modified models", c_ctx->modif_count, i);
+
+    if (0 == session->oper_count[session->datastore] && 0 != c_ctx->modif_count && SR_DS_RUNNING != session->datastore) {
+        SR_LOG_WRN_MSG("No operation logged, however data tree marked as modified");
+        c_ctx->modif_count = 0;
+        *commit_ctx = c_ctx;
+        return SR_ERR_OK;
+    }
+
+    c_ctx->fds = calloc(c_ctx->modif_count, sizeof(*c_ctx->fds));
+    CHECK_NULL_NOMEM_GOTO(c_ctx->fds, rc, cleanup);
+    for (size_t i = 0; i < c_ctx->modif_count; i++) {
+        c_ctx->fds[i] = -1;
+    }
+
+    c_ctx->existed = calloc(c_ctx->modif_count, sizeof(*c_ctx->existed));
+    CHECK_NULL_NOMEM_GOTO(c_ctx->existed, rc, cleanup);
+
+    /* create commit session */
+    rc = dm_session_start(dm_ctx, session->user_credentials, session->datastore, &c_ctx->session);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit session initialization failed");
+
+    rc = sr_list_init(&c_ctx->up_to_date_models);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+
+    /* set pointer to the list of operations to be committed */
+    c_ctx->operations = session->operations[session->datastore];
+    c_ctx->oper_count = session->oper_count[session->datastore];
+
+    *commit_ctx = c_ctx;
+    return rc;
+
+cleanup:
+    c_ctx->modif_count = 0; /* no fd to be closed*/
+    dm_model_subscription_free(ms);
+    dm_free_commit_context(c_ctx);
+    return rc;
+}
+
+static int
+dm_dup_required_models_list(dm_data_info_t *src, dm_data_info_t *dest)
+{
+    CHECK_NULL_ARG2(src, dest);
+    int rc = SR_ERR_OK;
+    if (NULL != src->required_modules) {
+        rc = sr_list_init(&dest->required_modules);
+        CHECK_RC_MSG_RETURN(rc, "Failed to create list");
+
+        for (size_t r = 0; r < src->required_modules->count; r++) {
+            char *tmp_module = strdup((char *) src->required_modules->data[r]);
+            CHECK_NULL_NOMEM_GOTO(tmp_module, rc, cleanup);
+
+            rc = sr_list_add(dest->required_modules, tmp_module);
+            if (SR_ERR_OK != rc) {
+                free(tmp_module);
+            }
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert into the list");
+        }
+    }
+cleanup:
+    if (SR_ERR_OK != rc) {
+        sr_free_list_of_strings(dest->required_modules);
+        dest->required_modules = NULL;
+    }
+    return rc;
+}
+
+int
+dm_commit_load_session_module_deps(dm_ctx_t *dm_ctx, dm_session_t *session)
+{
+    CHECK_NULL_ARG2(dm_ctx, session);
+    dm_data_info_t *info = NULL;
+    size_t i = 0;
+    int rc = SR_ERR_OK;
+
+    i = 0;
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        if (!info->modified) {
+            continue;
+        }
+
+        /* get the list of required modules */
+        rc = dm_requires_tmp_context(dm_ctx, session, info, NULL, &info->required_modules);
+        CHECK_RC_LOG_RETURN(rc, "Failed to get module dependencies of '%s'.", info->schema->module->name);
+    }
+
+    return SR_ERR_OK;
+}
+
+int
+dm_commit_load_modified_models(dm_ctx_t *dm_ctx, const dm_session_t *session, dm_commit_context_t *c_ctx,
+        bool force_copy_uptodate, sr_error_info_t **errors, size_t *err_cnt)
+{
+    CHECK_NULL_ARG3(c_ctx, errors, err_cnt);
+    CHECK_NULL_ARG5(dm_ctx, session, c_ctx->session, c_ctx->fds, c_ctx->existed);
+    CHECK_NULL_ARG(c_ctx->up_to_date_models);
+    dm_data_info_t *info = NULL, *di = NULL;
+    size_t i = 0;
+    size_t count = 0, modified_cnt = 0;
+    int rc = SR_ERR_OK;
+    char *file_name = NULL;
+    dm_load_job_t *jobs = NULL;
+    bool *jobs_prev = NULL;
+    size_t job_cnt = 0;
+    bool save_prev = false;
+    c_ctx->modif_count = 0; /* how many file descriptors should be closed on cleanup */
+
+    /* lock models that should be committed */
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        if (!info->modified) {
+            continue;
+        }
+        rc = dm_lock_module(dm_ctx, c_ctx->session, info->schema->module->name);
+        if (SR_ERR_LOCKED == rc) {
+            /* check if the lock is hold by session that issued commit */
+            rc = dm_lock_module(dm_ctx, (dm_session_t *)session, info->schema->module->name);
+        }
+        CHECK_RC_LOG_RETURN(rc, "Module %s can not be locked", info->schema->module->name);
+        ++modified_cnt;
+        if (SR_DS_RUNNING == session->datastore) {
+            /* check if all subtrees are enabled */
+            bool has_not_enabled = true;
+            rc = dm_has_not_enabled_nodes(info, &has_not_enabled);
+            CHECK_RC_LOG_RETURN(rc, "Has not enabled check failed for module %s", info->schema->module->name);
+            if (has_not_enabled) {
+//! @cond doxygen_suppress
+#define ERR_FMT "There is a not enabled node in %s module, it can not be committed to the running"
+//! @endcond
+                if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, ERR_FMT, info->schema->module->name)) {
+                    SR_LOG_WRN_MSG("Failed to record commit operation error");
+                }
+                SR_LOG_ERR(ERR_FMT, info->schema->module->name);
+                return SR_ERR_OPERATION_FAILED;
+#undef ERR_FMT
+            }
+        }
+    }
+
+    /* data files that need to be parsed are collected and loaded in parallel afterwards */
+    if (0 < modified_cnt) {
+        jobs = calloc(modified_cnt, sizeof(*jobs));
+        CHECK_NULL_NOMEM_RETURN(jobs);
+        jobs_prev = calloc(modified_cnt, sizeof(*jobs_prev));
+        if (NULL == jobs_prev) {
+            free(jobs);
+            SR_LOG_ERR("Unable to allocate memory in %s", __func__);
+            return SR_ERR_NOMEM;
+        }
+    }
+
+    /* for running and candidate we save previous state,
+     * if config change notifications are generated we have to save prev state for startup as well,
+     * if NACM is enabled, we need to get the previous state in any case */
+    save_prev = SR_DS_STARTUP != session->datastore || !c_ctx->disabled_config_change ||
+            (NULL != dm_ctx->nacm_ctx && (c_ctx->init_session->options & SR_SESS_ENABLE_NACM));
+
+    ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+
+    i = 0;
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        if (!info->modified) {
+            continue;
+        }
+
+        /* do not create or do anything with candidate data file, it does not exist and never should */
+        if (session->datastore != SR_DS_CANDIDATE) {
+            rc = sr_get_data_file_name(dm_ctx->data_search_dir, info->schema->module->name, c_ctx->session->datastore, &file_name);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data file name failed");
+
+            c_ctx->fds[count] = open(file_name, O_RDWR);
+            if (-1 == c_ctx->fds[count]) {
+                SR_LOG_DBG("File %s can not be opened for read write", file_name);
+                if (EACCES == errno) {
+//! @cond doxygen_suppress
+#define ERR_FMT "File %s can not be opened because of authorization"
+//! @endcond
+                    if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, ERR_FMT, file_name)) {
+                        SR_LOG_WRN_MSG("Failed to record commit operation error");
+                    }
+                    SR_LOG_ERR(ERR_FMT, file_name);
+                    rc = SR_ERR_UNAUTHORIZED;
+                    goto cleanup;
+#undef ERR_FMT
+                }
+
+                if (ENOENT == errno) {
+                    SR_LOG_DBG("File %s does not exist, trying to create an empty one", file_name);
+                    c_ctx->fds[count] = open(file_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+                    CHECK_NOT_MINUS1_LOG_GOTO(c_ctx->fds[count], rc, SR_ERR_IO, cleanup, "File %s can not be created", file_name);
+                }
+            } else {
+                c_ctx->existed[count] = true;
+            }
+            /* file was opened successfully increment the number of files to be closed */
+            c_ctx->modif_count++;
+            /* try to lock for read, non-blocking */
+            rc = sr_lock_fd(c_ctx->fds[count], false, false);
+            if (SR_ERR_OK != rc) {
+//! @cond doxygen_suppress
+#define ERR_FMT "Locking of file '%s' failed: %s."
+//! @endcond
+                if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, ERR_FMT, file_name, sr_strerror(rc))) {
+                    SR_LOG_WRN_MSG("Failed to record commit operation error");
+                }
+                SR_LOG_ERR(ERR_FMT, file_name, sr_strerror(rc));
+                rc = SR_ERR_OPERATION_FAILED;
+                goto cleanup;
+#undef ERR_FMT
+            }
+        }
+
+        bool copy_uptodate;
+        if (session->datastore == SR_DS_CANDIDATE || force_copy_uptodate) {
+            /* candidate datatree is always up-to-date, there is only one copy */
+            copy_uptodate = true;
+        } else {
+            rc = dm_is_info_copy_uptodate(dm_ctx, file_name, info, &copy_uptodate);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "File up to date check failed");
+        }
+
+        if (session->datastore == SR_DS_CANDIDATE || copy_uptodate) {
+            SR_LOG_DBG("Timestamp for the model %s matches, ops will be skipped", info->schema->module->name);
+            rc = sr_list_add(c_ctx->up_to_date_models, (void *)info->schema->module->name);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+
+            di = calloc(1, sizeof(*di));
+            CHECK_NULL_NOMEM_GOTO(di, rc, cleanup);
+            di->node = sr_dup_datatree(info->node);
+            if (NULL != info->node && NULL == di->node) {
+                SR_LOG_ERR_MSG("Data tree duplication failed");
+                rc = SR_ERR_INTERNAL;
+                dm_data_info_free(di);
+                goto cleanup;
+            }
+            dm_data_info_use_schema(di, info->schema);
+            di->schema = info->schema;
+            di->modified = info->modified;
+
+            /* duplicate also the list of required modules */
+            rc = dm_dup_required_models_list(info, di);
+            if (SR_ERR_OK != rc) {
+                SR_LOG_ERR_MSG("Duplication of required models list failed");
+                dm_data_info_free(di);
+                goto cleanup;
+            }
+
+            rc = sr_btree_insert(c_ctx->session->session_modules[c_ctx->session->datastore], (void *)di);
+            if (SR_ERR_OK != rc) {
+                SR_LOG_ERR("Insert into commit session avl failed module %s", info->schema->module->name);
+                dm_data_info_free(di);
+                goto cleanup;
+            }
+
+            if (save_prev && session->datastore != SR_DS_CANDIDATE) {
+                /* previous state has to be loaded from file system */
+                jobs[job_cnt].fd = c_ctx->existed[count] ? c_ctx->fds[count] : -1;
+                jobs[job_cnt].file_name = file_name;
+                jobs[job_cnt].schema_info = info->schema;
+                jobs_prev[job_cnt] = true;
+                ++job_cnt;
+                file_name = NULL;
+            } else if (save_prev) {
+                rc = dm_insert_data_info_copy(c_ctx->prev_data_trees, di);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Insert data info copy failed");
+            }
+        } else {
+            /* if the file existed pass FILE 'r+', otherwise pass -1 because there is 'w' fd already */
+            jobs[job_cnt].fd = c_ctx->existed[count] ? c_ctx->fds[count] : -1;
+            jobs[job_cnt].file_name = file_name;
+            jobs[job_cnt].schema_info = info->schema;
+            ++job_cnt;
+            file_name = NULL;
+        }
+
+        free(file_name);
+        file_name = NULL;
+
+        count++;
+    }
+
+    /* parse the data files of all the modules at once */
+    if (0 < job_cnt) {
+        rc = dm_load_data_tree_files(dm_ctx, jobs, job_cnt);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Loading data file failed");
+    }
+
+    for (i = 0; i < job_cnt; ++i) {
+        di = jobs[i].data_info;
+        jobs[i].data_info = NULL;
+        if (jobs_prev[i]) {
+            rc = sr_btree_insert(c_ctx->prev_data_trees, (void *)di);
+            if (SR_ERR_OK != rc) {
+                SR_LOG_ERR("Insert into prev data trees failed module %s", di->schema->module->name);
+                dm_data_info_free(di);
+                goto cleanup;
+            }
+            continue;
+        }
+        rc = sr_btree_insert(c_ctx->session->session_modules[c_ctx->session->datastore], (void *)di);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR("Insert into commit session avl failed module %s", di->schema->module->name);
+            dm_data_info_free(di);
+            goto cleanup;
+        }
+        if (save_prev) {
+            /* we can reuse data that were just read from file system */
+            rc = dm_insert_data_info_copy(c_ctx->prev_data_trees, di);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Insert data info copy failed");
+        }
+    }
+
+cleanup:
+    ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+    free(file_name);
+    for (i = 0; i < job_cnt; ++i) {
+        dm_data_info_free(jobs[i].data_info);
+        free((char *) jobs[i].file_name);
+    }
+    free(jobs);
+    free(jobs_prev);
+    return rc;
+}
+
+int
+dm_commit_writelock_fds(dm_session_t *session, dm_commit_context_t *commit_ctx)
+{
+    CHECK_NULL_ARG2(session, commit_ctx);
+    int rc = SR_ERR_OK;
+    int cnt = 0;
+    size_t i = 0;
+    dm_data_info_t *info = NULL;
+
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        if (!info->modified) {
+            continue;
+        }
+        /* try to lock for write, non-blocking */
+        rc = sr_lock_fd(commit_ctx->fds[cnt], true, false);
+        CHECK_RC_LOG_RETURN(rc, "Locking of file for module '%s' failed: %s.", info->schema->module_name, sr_strerror(rc));
+        cnt++;
+    }
+    return rc;
+}
+
+int
+dm_commit_write_files(dm_session_t *session, dm_commit_context_t *c_ctx)
+{
+    CHECK_NULL_ARG2(session, c_ctx);
+    int rc = SR_ERR_OK;
+    int ret = 0;
+    size_t i = 0;
+    size_t count = 0;
+    dm_data_info_t *info = NULL;
+    dm_tmp_ly_ctx_t *tmp_ctx = NULL;
+    struct lyd_node *tmp_data_tree = NULL;
+    struct ly_ctx *ly_ctx = NULL;
+
+    /* write data trees */
+    i = 0;
+    dm_data_info_t *merged_info = NULL;
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        if (info->modified) {
+            /* get merged info */
+            merged_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], info);
+            if (NULL == merged_info) {
+                SR_LOG_ERR("Merged data info %s not found", info->schema->module->name);
+                rc = SR_ERR_INTERNAL;
+                continue;
+            }
+            /* remove attached data trees */
+            ret = dm_remove_added_data_trees(session, info);
+
+            /* print using tmp context if schemas different from installation time deps are needed
+             * (the shared context contains all installed modules) */
+            if (NULL != merged_info->required_modules && NULL == merged_info->schema->shared_ly_ctx) {
+                SR_LOG_DBG("Additional schemas are needed to print data of modules %s", merged_info->schema->module_name);
+                rc = dm_get_tmp_ly_ctx(session->dm_ctx, merged_info->required_modules, &tmp_ctx);
+                if (SR_ERR_OK == rc) {
+                    tmp_data_tree = sr_dup_datatree_to_ctx(merged_info->node, tmp_ctx->ctx);
+                } else {
+                    SR_LOG_ERR_MSG("Failed to acquired tmp ly_ctx");
+                    continue;
+                }
+            }
+
+            if (SR_ERR_OK == ret) {
+                ret = ftruncate(c_ctx->fds[count], 0);
+            }
+            if (0 == ret) {
+                ly_errno = LY_SUCCESS; /* needed to check if the error was in libyang or not below */
+                ret = lyd_print_fd(c_ctx->fds[count], NULL == tmp_ctx ? merged_info->node : tmp_data_tree,
+                            SR_FILE_FORMAT_LY, LYP_WITHSIBLINGS | LYP_FORMAT);
+            }
+
+            if (NULL != tmp_ctx) {
+                lyd_free_withsiblings(tmp_data_tree);
+                tmp_data_tree = NULL;
+                dm_release_tmp_ly_ctx(session->dm_ctx, tmp_ctx);
+                tmp_ctx = NULL;
+            }
+
+            if (0 == ret) {
+                ret = fsync(c_ctx->fds[count]);
+            }
+            if (0 != ret) {
+                if (ly_errno) {
+                    ly_ctx = merged_info->schema->ly_ctx;
+                }
+                SR_LOG_ERR("Failed to write data of '%s' module: %s", info->schema->module->name,
+                        (ly_errno != LY_SUCCESS) ? ly_errmsg(ly_ctx) : sr_strerror_safe(errno));
+                rc = SR_ERR_INTERNAL;
+            } else {
+                SR_LOG_DBG("Data successfully written for module '%s'", info->schema->module->name);
+            }
+            if (0 == ret && SR_DS_RUNNING == c_ctx->session->datastore) {
+                if (0 == strcmp("ietf-netconf-acm", info->schema->module_name)) {
+                    c_ctx->nacm_edited = true;
+                }
+            }
+            count++;
+        }
+    }
+    /* save time of the last commit */
+    sr_clock_get_time(CLOCK_REALTIME, &session->dm_ctx->last_commit_time);
+
+    return rc;
+}
+
+/**
+ * @brief Find equal \p node instance in \p data tree. Be careful, this implementation
+ * is tailored for use on 2 diffed trees, so some additional assumptions hold that are
+ * taken into consideration.
+ */
+static struct lyd_node *
+dm_find_data_instance(const struct lyd_node *data, const struct lyd_node *node)
+{
+    struct ly_set *set = NULL;
+    struct lyd_node *ret = NULL;
+    struct lyd_node_leaf_list *k1, *k2;
+    uint32_t i, j;
+
+    if (data == NULL || (set = lyd_find_instance(data, node->schema)) == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; !ret && (i < set->number); ++i) {
+        switch (node->schema->nodetype) {
+        case LYS_CONTAINER:
+        case LYS_LEAF:
+        case LYS_ANYXML:
+        case LYS_ANYDATA:
+            /* it is assumed that if leaf, anyxml, anydata exist, they have the same value */
+            ret = set->set.d[0];
+            break;
+        case LYS_LEAFLIST:
+            if (!strcmp(((struct lyd_node_leaf_list *)node)->value_str,
+                        ((struct lyd_node_leaf_list *)set->set.d[i])->value_str)) {
+                ret = set->set.d[i];
+            }
+            break;
+        case LYS_LIST:
+            k1 = (struct lyd_node_leaf_list *)node->child;
+            k2 = (struct lyd_node_leaf_list *)set->set.d[i]->child;
+            for (j = 0; j < ((struct lys_node_list *)node->schema)->keys_size; ++j) {
+                if (strcmp(k1->value_str, k2->value_str)) {
+                    break;
+                }
+                k1 = (struct lyd_node_leaf_list *)k1->next;
+                k2 = (struct lyd_node_leaf_list *)k2->next;
+            }
+            if (j < ((struct lys_node_list *)node->schema)->keys_size) {
+                ret = set->set.d[i];
+            }
+            break;
+        default:
+            assert(0);
+        }
+    }
 
-        sr_btree_cleanup(c_ctx->subscriptions);
-        sr_btree_cleanup(c_ctx->prev_data_trees);
-        if (NULL != c_ctx->session) {
-            dm_session_stop(c_ctx->session->dm_ctx, c_ctx->session);
-        }
-        if (NULL != c_ctx->err_subs_xpaths) {
-            for (size_t i = 0; i < c_ctx->err_subs_xpaths->count; i++) {
-                free(c_ctx->err_subs_xpaths->data[i]);
+    return ret;
+}
+
+/**
+ * @brief Perform read NACM check on a single node, revert it if read access is not granted.
+ */
+static int
+dm_copy_config_read_nacm_single_node(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx,
+        const struct lyd_node *node, struct lyd_difflist *diff, size_t diff_idx, size_t *diff_size,
+        struct lyd_node *cc_tree, bool *denied)
+{
+    int rc = SR_ERR_OK;
+    nacm_action_t nacm_action = NACM_ACTION_PERMIT;
+    const char *rule_name = NULL, *rule_info = NULL;
+    void *tmp = NULL;
+    struct lyd_node_anydata *tmp_node = NULL;
+    struct lyd_node *cc_first = NULL, *cc_second = NULL;
+
+    rc = nacm_check_data(nacm_data_val_ctx, NACM_ACCESS_READ, node, &nacm_action, &rule_name, &rule_info);
+    CHECK_RC_LOG_RETURN(rc, "NACM data validation failed for node: %s.", node->schema->name);
+
+    if (NACM_ACTION_DENY == nacm_action) {
+        /* report check fail */
+        nacm_report_read_access_denied(session->user_credentials, node, rule_name, rule_info);
+
+        /* revert the change in the copy-config (cc)tree */
+        switch (diff->type[diff_idx]) {
+        case LYD_DIFF_CHANGED:
+            if (node->schema->nodetype == LYS_LEAF) {
+                if (lyd_change_leaf((struct lyd_node_leaf_list *)diff->second[diff_idx],
+                            ((struct lyd_node_leaf_list *)diff->first[diff_idx])->value_str) < 0) {
+                    return SR_ERR_INTERNAL;
+                }
+            } else { /* LYS_ANYXML, LYS_ANYDATA */
+                tmp_node = (struct lyd_node_anydata *)lyd_dup(diff->first[diff_idx], 0);
+                /* switch values and free the copy */
+                tmp = (void *)((struct lyd_node_anydata *)diff->second[diff_idx])->value_type;
+                ((struct lyd_node_anydata *)diff->second[diff_idx])->value_type = tmp_node->value_type;
+                tmp_node->value_type = (LYD_ANYDATA_VALUETYPE)tmp;
+
+                memcpy(&tmp, &((struct lyd_node_anydata *)diff->second[diff_idx])->value, sizeof tmp);
+                ((struct lyd_node_anydata *)diff->second[diff_idx])->value = tmp_node->value;
+                memcpy(&tmp_node->value, &tmp, sizeof tmp);
+
+                lyd_free((struct lyd_node *)tmp_node);
             }
-            sr_list_cleanup(c_ctx->err_subs_xpaths);
-        }
-        if (NULL != c_ctx->errors && 0 != c_ctx->err_cnt) {
-            sr_free_errors(c_ctx->errors, c_ctx->err_cnt);
+            break;
+        case LYD_DIFF_MOVEDAFTER1:
+            cc_first = dm_find_data_instance(cc_tree, diff->first[diff_idx]);
+            if (diff->first[diff_idx]->prev != diff->first[diff_idx]) {
+                cc_second = dm_find_data_instance(cc_tree, diff->first[diff_idx]->prev);
+                lyd_insert_after(cc_second, cc_first);
+            } else {
+                cc_second = dm_find_data_instance(cc_tree, diff->first[diff_idx]->next);
+                lyd_insert_before(cc_second, cc_first);
+            }
+            break;
+        case LYD_DIFF_DELETED:
+            if (diff->first[diff_idx]->parent) {
+                cc_first = dm_find_data_instance(cc_tree, diff->first[diff_idx]->parent);
+                lyd_insert(cc_first, lyd_dup(diff->first[diff_idx], 1));
+            } else {
+                lyd_insert_sibling(&cc_tree, lyd_dup(diff->first[diff_idx], 1));
+            }
+            break;
+        case LYD_DIFF_CREATED:
+            lyd_free(diff->second[diff_idx]);
+            break;
+        default:
+            /* LYD_DIFF_MOVEDAFTER2 should not be passed to this function,
+             * access control performed already for LYD_DIFF_CREATED of this node */
+            assert(0);
         }
-        c_ctx->session = NULL;
-        sr_btree_cleanup(c_ctx->difflists);
-        if (NULL != c_ctx->backup_session) {
-            dm_session_stop(c_ctx->backup_session->dm_ctx, c_ctx->backup_session);
+
+        /* remove this diff item */
+        --(*diff_size);
+        memmove(&diff->type[diff_idx], &diff->type[diff_idx + 1], (*diff_size - diff_idx) * sizeof *diff->type);
+        memmove(&diff->first[diff_idx], &diff->first[diff_idx + 1], (*diff_size - diff_idx) * sizeof *diff->first);
+        memmove(&diff->second[diff_idx], &diff->second[diff_idx + 1], (*diff_size - diff_idx) * sizeof *diff->second);
+
+        if (denied) {
+            *denied = true;
         }
-        free(c_ctx);
+    } else if (denied) {
+        *denied = false;
     }
+
+    return SR_ERR_OK;
 }
 
+/**
+ * @brief Perform read NACM check on every node in the subtree, revert any subtrees with read access not granted.
+ */
 static int
-dm_insert_commit_context(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
+dm_copy_config_read_nacm_subtree(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx,
+        const struct lyd_node *root, struct lyd_difflist *diff, size_t diff_idx, size_t *diff_size)
 {
-    CHECK_NULL_ARG2(dm_ctx, c_ctx);
     int rc = SR_ERR_OK;
-    RWLOCK_WRLOCK_TIMED_CHECK_RETURN(&dm_ctx->commit_ctxs.lock);
-    pthread_mutex_lock(&dm_ctx->commit_ctxs.empty_mutex);
-    if (!dm_ctx->commit_ctxs.commits_blocked) {
-        rc = sr_btree_insert(dm_ctx->commit_ctxs.tree, c_ctx);
-        if (SR_ERR_OK == rc) {
-            c_ctx->in_btree = true;
-            dm_ctx->commit_ctxs.empty = false;
+    bool backtracking = false, denied = false;
+    const struct lyd_node *node = NULL;
+
+    assert(diff->type[diff_idx] == LYD_DIFF_CREATED);
+
+    node = root;
+    while (!backtracking || node != root) {
+        if (false == backtracking) {
+            rc = dm_copy_config_read_nacm_single_node(session, nacm_data_val_ctx, node, diff, diff_idx, diff_size, NULL, &denied);
+            if (SR_ERR_OK != rc) {
+                return rc;
+            }
+            if (!denied && !(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) && node->child) {
+                node = node->child;
+            } else if (node->next && node != root) {
+                node = node->next;
+            } else {
+                backtracking = true;
+            }
+        } else {
+            if (node->next) {
+                node = node->next;
+                backtracking = false;
+            } else {
+                node = node->parent;
+            }
         }
-    } else {
-        SR_LOG_ERR_MSG("Commit context can not be inserted, commits are blocked cleanup was requested");
-        rc = SR_ERR_OPERATION_FAILED;
     }
-    pthread_mutex_unlock(&dm_ctx->commit_ctxs.empty_mutex);
-    pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
-    return rc;
+
+    return SR_ERR_OK;
 }
 
+/**
+ * @brief Perform NETCONF access control for a single node.
+ */
 static int
-dm_remove_commit_context(dm_ctx_t *dm_ctx, uint32_t c_ctx_id)
+dm_commit_nacm_single_node(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx, const struct lyd_node *node,
+        nacm_access_flag_t access_type, bool *denied, sr_error_info_t **errors, size_t *err_cnt)
 {
-    pthread_rwlock_wrlock(&dm_ctx->commit_ctxs.lock);
-    dm_commit_context_t *c_ctx = NULL;
-    dm_commit_context_t lookup = {0};
-    lookup.id = c_ctx_id;
-    c_ctx = sr_btree_search(dm_ctx->commit_ctxs.tree, &lookup);
-    if (NULL == c_ctx) {
-        SR_LOG_WRN("Commit context with id %d not found", c_ctx_id);
-    } else {
-        sr_btree_delete(dm_ctx->commit_ctxs.tree, c_ctx);
-        SR_LOG_DBG("Commit context with id %"PRIu32" removed", c_ctx_id);
-        pthread_mutex_lock(&dm_ctx->commit_ctxs.empty_mutex);
-        if (NULL == sr_btree_get_at(dm_ctx->commit_ctxs.tree, 0)) {
-            dm_ctx->commit_ctxs.empty = true;
-            pthread_cond_broadcast(&dm_ctx->commit_ctxs.empty_cond);
+    int rc = SR_ERR_OK;
+    nacm_action_t nacm_action = NACM_ACTION_PERMIT;
+    const char *rule_name = NULL, *rule_info = NULL;
+
+    CHECK_NULL_ARG4(session, nacm_data_val_ctx, node, denied);
+    CHECK_NULL_ARG2(errors, err_cnt);
+
+    *denied = false;
+    rc = nacm_check_data(nacm_data_val_ctx, access_type, node, &nacm_action, &rule_name, &rule_info);
+    CHECK_RC_LOG_RETURN(rc, "NACM data validation failed for node: %s.", node->schema->name);
+
+    if (NACM_ACTION_DENY == nacm_action) {
+        nacm_report_edit_access_denied(session->user_credentials, session, node, access_type,
+                rule_name, rule_info);
+        if (SR_ERR_OK != sr_add_error(errors, err_cnt, session->error_xpath, "%s", session->error_msg)) {
+            SR_LOG_WRN_MSG("Failed to record authorization error");
         }
-        pthread_mutex_unlock(&dm_ctx->commit_ctxs.empty_mutex);
+        *denied = true;
     }
-    pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
     return SR_ERR_OK;
 }
 
-int
-dm_commit_notifications_complete(dm_ctx_t *dm_ctx, uint32_t c_ctx_id)
+/**
+ * @brief Perform NETCONF access control for all nodes inside a subtree.
+ */
+static int
+dm_commit_nacm_subtree(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx, const struct lyd_node *root,
+        nacm_access_flag_t access_type, int *denied_cnt, sr_error_info_t **errors, size_t *err_cnt)
 {
-    return dm_remove_commit_context(dm_ctx, c_ctx_id);
+    int rc = SR_ERR_OK;
+    bool denied = false;
+    bool backtracking = false;
+    const struct lyd_node *node = NULL;
+
+    node = root;
+    while (!backtracking || node != root) {
+        if (false == backtracking) {
+            rc = dm_commit_nacm_single_node(session, nacm_data_val_ctx, node, access_type, &denied, errors, err_cnt);
+            *denied_cnt += denied;
+            if (SR_ERR_OK != rc) {
+                return rc;
+            }
+            if (!denied && !(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) && node->child) {
+                node = node->child;
+            } else if (node->next && node != root) {
+                node = node->next;
+            } else {
+                backtracking = true;
+            }
+        } else {
+            if (node->next) {
+                node = node->next;
+                backtracking = false;
+            } else {
+                node = node->parent;
+            }
+        }
+    }
+
+    return SR_ERR_OK;
 }
 
-/**
- * @brief Releases resources that are no more needed after SR_EV_APPLY or SR_EV_ABORT
- *
- */
 static int
-dm_release_resources_commit_context(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
+dm_perform_netconf_access_control(nacm_ctx_t *nacm_ctx, dm_session_t *session, dm_data_info_t *prev_info,
+                                  dm_data_info_t *new_info, bool copy_config, sr_error_info_t **errors, size_t *err_cnt,
+                                  dm_commit_context_t *c_ctx)
 {
-    CHECK_NULL_ARG(c_ctx);
-    for (size_t i = 0; i < c_ctx->modif_count; i++) {
-        close(c_ctx->fds[i]);
+    CHECK_NULL_ARG4(nacm_ctx, session, prev_info, new_info);
+    int rc = SR_ERR_OK;
+    size_t d_cnt = 0, d_idx = 0;
+    bool denied = false, saved_diff = false;
+    int denied_cnt = 0;
+    nacm_data_val_ctx_t *nacm_data_val_ctx = NULL;
+    struct lyd_difflist *diff = NULL;
+    dm_module_difflist_t *module_difflist = NULL;
+
+    /* get the set of changes */
+    saved_diff = false;
+    diff = lyd_diff(prev_info->node, new_info->node, LYD_DIFFOPT_WITHDEFAULTS);
+    if (NULL == diff) {
+        SR_LOG_ERR("Lyd diff failed for module %s", prev_info->schema->module->name);
+        rc = SR_ERR_INTERNAL;
+        goto cleanup;
     }
-    free(c_ctx->fds);
-    free(c_ctx->existed);
-    sr_list_cleanup(c_ctx->up_to_date_models);
-    c_ctx->up_to_date_models = NULL;
-    c_ctx->fds = NULL;
-    c_ctx->existed = NULL;
-    c_ctx->modif_count = 0;
 
-    dm_unlock_datastore(dm_ctx, c_ctx->session);
+    if (NULL != c_ctx) {
+        /* save diff for VERIFY notifications (even if the set is empty) */
+        module_difflist = calloc(1, sizeof *module_difflist);
+        CHECK_NULL_NOMEM_GOTO(module_difflist, rc, cleanup);
+        module_difflist->schema_info = prev_info->schema;
+        module_difflist->difflist = diff;
+        saved_diff = true;
+        rc = sr_btree_insert(c_ctx->difflists, (void *)module_difflist);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to insert diff-list for module %s into the binary tree",
+                    prev_info->schema->module->name);
+        module_difflist = NULL;
+    }
 
-    return SR_ERR_OK;
-}
+    if (diff->type[0] == LYD_DIFF_END) {
+        SR_LOG_DBG("No changes in module %s", prev_info->schema->module->name);
+        return SR_ERR_OK;
+    }
 
-static int
-dm_save_commit_context(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
-{
-    CHECK_NULL_ARG(c_ctx);
-    int rc = SR_ERR_OK;
-    /* assign id to the commit context and save it to th dm_ctx */
-    rc = dm_insert_commit_context(dm_ctx, c_ctx);
+    /* start NACM data access validation for this module */
+    struct lys_node *schema = new_info->node == NULL ? prev_info->node->schema : new_info->node->schema;
+    rc = nacm_data_validation_start(nacm_ctx, session->user_credentials, schema,
+            &nacm_data_val_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to start NACM data validation.");
 
-    return rc;
+    if (copy_config) {
+        /* count diff items */
+        for (d_cnt = 0; LYD_DIFF_END != diff->type[d_cnt]; ++d_cnt);
+        ++d_cnt;
 
-}
+        /* for copy_config perform read access checks */
+        d_idx = d_cnt - 1;
+        do {
+            --d_idx;
+            switch (diff->type[d_idx]) {
+            case LYD_DIFF_CHANGED:
+            case LYD_DIFF_MOVEDAFTER1:
+            case LYD_DIFF_DELETED:
+                rc = dm_copy_config_read_nacm_single_node(session, nacm_data_val_ctx, diff->first[d_idx],
+                        diff, d_idx, &d_cnt, new_info->node, NULL);
+                break;
+            case LYD_DIFF_CREATED:
+                rc = dm_copy_config_read_nacm_subtree(session, nacm_data_val_ctx, diff->second[d_idx],
+                        diff, d_idx, &d_cnt);
+                break;
+            case LYD_DIFF_MOVEDAFTER2:
+                break;
+            default:
+                assert(0 && "not reachable");
+            }
+            if (SR_ERR_OK != rc) {
+                goto cleanup;
+            }
+        } while (d_idx > 0);
 
-static int
-dm_create_commit_ctx_id(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx)
-{
-    CHECK_NULL_ARG2(dm_ctx, c_ctx);
+        if (diff->type[0] == LYD_DIFF_END) {
+            SR_LOG_DBG("No changes in module %s", prev_info->schema->module->name);
+            rc = SR_ERR_OK;
+            goto cleanup;
+        }
+    }
 
-    pthread_rwlock_rdlock(&dm_ctx->commit_ctxs.lock);
-    size_t attempts = 0;
-    /* generate unique id */
-    do {
-        c_ctx->id = rand();
-        if (NULL != sr_btree_search(dm_ctx->commit_ctxs.tree, c_ctx)) {
-            c_ctx->id = DM_COMMIT_CTX_ID_INVALID;
+    /* Iterate over all changes. Some changes may include whole subtrees. */
+    for (d_idx = 0; LYD_DIFF_END != diff->type[d_idx]; d_idx++) {
+        /* get node, access_type */
+        switch (diff->type[d_idx]) {
+        case LYD_DIFF_CHANGED:
+        case LYD_DIFF_MOVEDAFTER1:
+            rc = dm_commit_nacm_single_node(session, nacm_data_val_ctx, diff->first[d_idx],
+                    NACM_ACCESS_UPDATE, &denied, errors, err_cnt);
+            denied_cnt += denied;
+            break;
+        case LYD_DIFF_DELETED:
+            rc = dm_commit_nacm_subtree(session, nacm_data_val_ctx, diff->first[d_idx],
+                    NACM_ACCESS_DELETE, &denied_cnt, errors, err_cnt);
+            break;
+        case LYD_DIFF_CREATED:
+            rc = dm_commit_nacm_subtree(session, nacm_data_val_ctx, diff->second[d_idx],
+                    NACM_ACCESS_CREATE, &denied_cnt, errors, err_cnt);
+            break;
+        case LYD_DIFF_MOVEDAFTER2:
+            continue; /* access control performed already for LYD_DIFF_CREATED of this node */
+            break;
+        default:
+            assert(0 && "not reachable");
         }
-        if (++attempts > DM_COMMIT_CTX_ID_MAX_ATTEMPTS) {
-            SR_LOG_ERR_MSG("Unable to generate an unique session_id.");
-            pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
-            return SR_ERR_INTERNAL;
+        if (SR_ERR_OK != rc) {
+            goto cleanup;
         }
-    } while (DM_COMMIT_CTX_ID_INVALID == c_ctx->id);
+    }
 
-    pthread_rwlock_unlock(&dm_ctx->commit_ctxs.lock);
-    return SR_ERR_OK;
+cleanup:
+    if (SR_ERR_OK == rc && denied_cnt > 0) {
+        rc = SR_ERR_UNAUTHORIZED;
+        /* update NACM stats */
+        (void)nacm_stats_add_denied_data_write(nacm_ctx);
+    }
+    if (!saved_diff && NULL != diff) {
+        lyd_free_diff(diff);
+    }
+    dm_module_difflist_free(module_difflist);
+    nacm_data_validation_stop(nacm_data_val_ctx);
+    return rc;
 }
 
-
 int
-dm_commit_prepare_context(dm_ctx_t *dm_ctx, dm_session_t *session, dm_commit_context_t **commit_ctx)
+dm_commit_netconf_access_control(nacm_ctx_t *nacm_ctx, dm_session_t *session, dm_commit_context_t *c_ctx, bool copy_config,
+                                 sr_error_info_t **errors, size_t *err_cnt)
 {
-    CHECK_NULL_ARG2(session, commit_ctx);
-    dm_data_info_t *info = NULL;
-    size_t i = 0;
+    CHECK_NULL_ARG3(nacm_ctx, session, c_ctx);
     int rc = SR_ERR_OK;
-    dm_model_subscription_t *ms = NULL;
-    dm_commit_context_t *c_ctx = NULL;
-    c_ctx = calloc(1, sizeof(*c_ctx));
-    CHECK_NULL_NOMEM_RETURN(c_ctx);
-
-    rc = dm_create_commit_ctx_id(dm_ctx, c_ctx);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit context id generating failed");
-
-    pthread_mutex_init(&c_ctx->mutex, NULL);
-
-    rc = sr_btree_init(dm_module_subscription_cmp, dm_model_subscription_free, &c_ctx->subscriptions);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+    size_t i = 0;
+    dm_data_info_t *info = NULL, *new_info = NULL, *prev_info = NULL, lookup_info = {0};
 
-    rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &c_ctx->prev_data_trees);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        lookup_info.schema = info->schema;
+        if (!info->modified) {
+            continue;
+        }
 
-    rc = sr_btree_init(dm_module_difflist_cmp, dm_module_difflist_free, &c_ctx->difflists);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+        /* configuration before commit */
+        prev_info = sr_btree_search(c_ctx->prev_data_trees, &lookup_info);
+        if (NULL == prev_info) {
+            SR_LOG_ERR("Current data tree for module %s not found", info->schema->module->name);
+            return SR_ERR_INTERNAL;
+        }
 
-    c_ctx->modif_count = 0;
-    /* count modified files */
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i))) {
-        if (info->modified) {
-            c_ctx->modif_count++;
+        /* configuration after commit */
+        new_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], &lookup_info);
+        if (NULL == new_info) {
+            SR_LOG_ERR("Commit data tree for module %s not found", info->schema->module->name);
+            return SR_ERR_INTERNAL;
+        }
 
-            if (SR_DS_RUNNING == session->datastore) {
-                rc = dm_prepare_module_subscriptions(dm_ctx, session, info->schema, &ms);
-                CHECK_RC_LOG_GOTO(rc, cleanup, "Prepare module subscription failed %s", info->schema->module->name);
+        rc = dm_remove_added_data_trees(c_ctx->session, new_info);
+        CHECK_RC_MSG_RETURN(rc, "Removing of added data trees failed");
 
-                rc = sr_btree_insert(c_ctx->subscriptions, ms);
-                CHECK_RC_LOG_GOTO(rc, cleanup, "Insert into subscription tree failed module %s", info->schema->module->name);
-            }
-            ms = NULL;
+        rc = dm_perform_netconf_access_control(nacm_ctx, session, prev_info, new_info, copy_config, errors, err_cnt, c_ctx);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR_MSG("NACM access check failed");
+            return rc;
         }
-        i++;
     }
 
-    SR_LOG_DBG("Commit: In the session there are %zu / %zu modified models", c_ctx->modif_count, i);
+    return SR_ERR_OK;
+}
 
-    if (0 == session->oper_count[session->datastore] && 0 != c_ctx->modif_count && SR_DS_RUNNING != session->datastore) {
-        SR_LOG_WRN_MSG("No operation logged, however data tree marked as modified");
-        c_ctx->modif_count = 0;
-        *commit_ctx = c_ctx;
-        return SR_ERR_OK;
+/**
+ * @brief Decides whether a subscription should be skipped or not. Takes into account:
+ * SR_EV_VERIFY: skip SR_SUBSCR_APPLY_ONLY subscription
+ * SR_EV_ABORT: skip subscription that returned an error and specified SR_SUBSCR_NO_ABORT_FOR_REFUSED_CFG flag
+ */
+static bool
+dm_should_skip_subscription(np_subscription_t *subscription, dm_commit_context_t *c_ctx, sr_notif_event_t ev)
+{
+    if (NULL == subscription || NULL == c_ctx) {
+        return false;
     }
 
-    c_ctx->fds = calloc(c_ctx->modif_count, sizeof(*c_ctx->fds));
-    CHECK_NULL_NOMEM_GOTO(c_ctx->fds, rc, cleanup);
-    for (size_t i = 0; i < c_ctx->modif_count; i++) {
-        c_ctx->fds[i] = -1;
+    if (SR_EV_VERIFY == ev || SR_EV_ABORT == ev) {
+        if (SR__NOTIFICATION_EVENT__VERIFY_EV != subscription->notif_event) {
+            return true;
+        }
     }
 
-    c_ctx->existed = calloc(c_ctx->modif_count, sizeof(*c_ctx->existed));
-    CHECK_NULL_NOMEM_GOTO(c_ctx->existed, rc, cleanup);
-
-    /* create commit session */
-    rc = dm_session_start(dm_ctx, session->user_credentials, session->datastore, &c_ctx->session);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit session initialization failed");
-
-    rc = sr_list_init(&c_ctx->up_to_date_models);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
+    /* if subscription returned an error don't send him abort */
+    if (SR_EV_ABORT == ev && c_ctx->err_subs_xpaths != NULL) {
+        for (size_t e = 0; e < c_ctx->err_subs_xpaths->count; e++) {
+            if (0 == strcmp((char *) c_ctx->err_subs_xpaths->data[e],
+                    NULL == subscription->xpath ?
+                    subscription->module_name :
+                    subscription->xpath)) {
+                return true;
+            }
+        }
+    }
 
-    /* set pointer to the list of operations to be committed */
-    c_ctx->operations = session->operations[session->datastore];
-    c_ctx->oper_count = session->oper_count[session->datastore];
+    return false;
+}
 
-    *commit_ctx = c_ctx;
-    return rc;
+/**
+ * @brief Tests whether the change in the diff-list only switches an implicit default value
+ * to an explicit one or vice versa. Such changes are not notified.
+ */
+static bool
+dm_is_dflt_only_change(struct lyd_difflist *difflist, size_t d_cnt)
+{
+    if ((difflist->type[d_cnt] == LYD_DIFF_CHANGED)
+            && ((difflist->first[d_cnt]->schema->nodetype == LYS_LEAF)
+            || (difflist->first[d_cnt]->schema->nodetype == LYS_LEAFLIST))
+            && !strcmp(((struct lyd_node_leaf_list *)difflist->first[d_cnt])->value_str,
+                       ((struct lyd_node_leaf_list *)difflist->second[d_cnt])->value_str)) {
+        if (((struct lyd_node_leaf_list *)difflist->first[d_cnt])->dflt
+                == ((struct lyd_node_leaf_list *)difflist->second[d_cnt])->dflt) {
+            SR_LOG_ERR_MSG("Invalid lyd_diff() return value");
+        }
+        return true;
+    }
+    return false;
+}
 
-cleanup:
-    c_ctx->modif_count = 0; /* no fd to be closed*/
-    dm_model_subscription_free(ms);
-    dm_free_commit_context(c_ctx);
-    return rc;
+/**
+ * @brief Marks the subscriptions from the index entry as matched.
+ */
+static void
+dm_mark_matched_subscriptions(dm_model_subscription_t *ms, const dm_node_index_entry_t *entry, size_t *matched_cnt)
+{
+    if (NULL == entry) {
+        return;
+    }
+    for (size_t i = 0; i < entry->item_cnt; i++) {
+        if (!ms->matched[entry->items[i]]) {
+            ms->matched[entry->items[i]] = true;
+            ++(*matched_cnt);
+        }
+    }
 }
 
+/**
+ * @brief Evaluates which subscriptions of the model subscription structure are matched by any
+ * of the changes in the diff-list. Instead of testing each change against each subscription,
+ * the subscriptions tied to the changed node and its ancestors are looked up in the node index.
+ * Only the subscriptions to descendants of a created/deleted container or list need to be tested
+ * against the data subtree.
+ */
 static int
-dm_dup_required_models_list(dm_data_info_t *src, dm_data_info_t *dest)
+dm_match_subscriptions_difflist(dm_model_subscription_t *ms)
 {
-    CHECK_NULL_ARG2(src, dest);
+    CHECK_NULL_ARG3(ms, ms->subscriptions, ms->difflist);
+    const struct lyd_node *cmp_node = NULL;
+    const struct lys_node *n = NULL;
+    dm_node_index_entry_t *entry = NULL;
+    size_t sub_cnt = ms->subscriptions->count, matched_cnt = 0, s = 0;
+    bool match = false;
     int rc = SR_ERR_OK;
-    if (NULL != src->required_modules) {
-        rc = sr_list_init(&dest->required_modules);
-        CHECK_RC_MSG_RETURN(rc, "Failed to create list");
 
-        for (size_t r = 0; r < src->required_modules->count; r++) {
-            char *tmp_module = strdup((char *) src->required_modules->data[r]);
-            CHECK_NULL_NOMEM_GOTO(tmp_module, rc, cleanup);
+    ms->matched = calloc(sub_cnt, sizeof(*ms->matched));
+    CHECK_NULL_NOMEM_RETURN(ms->matched);
 
-            rc = sr_list_add(dest->required_modules, tmp_module);
-            if (SR_ERR_OK != rc) {
-                free(tmp_module);
+    for (size_t d_cnt = 0; LYD_DIFF_END != ms->difflist->type[d_cnt] && matched_cnt < sub_cnt; d_cnt++) {
+        if (dm_is_dflt_only_change(ms->difflist, d_cnt)) {
+            continue;
+        }
+        cmp_node = dm_get_notification_match_node(ms->difflist, d_cnt);
+        if (NULL == cmp_node) {
+            continue;
+        }
+
+        /* subscriptions to the whole module, to the changed node or to any of its ancestors */
+        dm_mark_matched_subscriptions(ms, dm_node_index_get(ms->nodes_index, NULL), &matched_cnt);
+        for (n = cmp_node->schema; NULL != n; n = lys_parent(n)) {
+            dm_mark_matched_subscriptions(ms, dm_node_index_get(ms->nodes_index, n), &matched_cnt);
+        }
+
+        /* subscriptions to a descendant of a created/deleted container or list */
+        if ((LYS_CONTAINER | LYS_LIST) & cmp_node->schema->nodetype) {
+            entry = dm_node_index_get(ms->nodes_index, cmp_node->schema);
+            for (size_t i = 0; NULL != entry && i < entry->desc_item_cnt; i++) {
+                s = entry->desc_items[i];
+                if (ms->matched[s]) {
+                    continue;
+                }
+                rc = dm_match_subscription(ms->nodes[s], cmp_node, &match);
+                CHECK_RC_MSG_RETURN(rc, "Subscription match failed");
+                if (match) {
+                    ms->matched[s] = true;
+                    ++matched_cnt;
+                }
             }
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert into the list");
         }
     }
-cleanup:
-    if (SR_ERR_OK != rc) {
-        sr_free_list_of_strings(dest->required_modules);
-        dest->required_modules = NULL;
-    }
+
     return rc;
 }
 
-int
-dm_commit_load_session_module_deps(dm_ctx_t *dm_ctx, dm_session_t *session)
+/**
+ * @brief Tests whether any of the changes in the diff-list of the model subscription structure
+ * matches the s-th subscription. All the subscriptions are evaluated on the first call.
+ */
+static void
+dm_match_subscription_difflist(dm_model_subscription_t *ms, size_t s, bool *match)
 {
-    CHECK_NULL_ARG2(dm_ctx, session);
-    dm_data_info_t *info = NULL;
-    size_t i = 0;
     int rc = SR_ERR_OK;
 
-    i = 0;
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        if (!info->modified) {
-            continue;
+    if (NULL == ms->matched) {
+        rc = dm_match_subscriptions_difflist(ms);
+        if (SR_ERR_OK != rc) {
+            /* rather notify the subscriber needlessly than miss a change */
+            SR_LOG_WRN_MSG("Subscription match failed");
+            free(ms->matched);
+            ms->matched = NULL;
+            *match = true;
+            return;
         }
-
-        /* get the list of required modules */
-        rc = dm_requires_tmp_context(dm_ctx, session, info, NULL, &info->required_modules);
-        CHECK_RC_LOG_RETURN(rc, "Failed to get module dependencies of '%s'.", info->schema->module->name);
     }
-
-    return SR_ERR_OK;
+    *match = ms->matched[s];
 }
 
-int
-dm_commit_load_modified_models(dm_ctx_t *dm_ctx, const dm_session_t *session, dm_commit_context_t *c_ctx,
-        bool force_copy_uptodate, sr_error_info_t **errors, size_t *err_cnt)
+/**
+ * @brief Merges the changes of a module made by the commit into the pending coalesced commit
+ * of the module. If there is no pending coalesced commit, it is created and its notification
+ * is scheduled to be sent after ::SR_COMMIT_COALESCE_WINDOW.
+ */
+static int
+dm_commit_coalesce_add(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx, dm_schema_info_t *schema_info)
 {
-    CHECK_NULL_ARG3(c_ctx, errors, err_cnt);
-    CHECK_NULL_ARG5(dm_ctx, session, c_ctx->session, c_ctx->fds, c_ctx->existed);
-    CHECK_NULL_ARG(c_ctx->up_to_date_models);
-    dm_data_info_t *info = NULL, *di = NULL;
-    size_t i = 0;
-    size_t count = 0;
+    CHECK_NULL_ARG3(dm_ctx, c_ctx, schema_info);
     int rc = SR_ERR_OK;
-    char *file_name = NULL;
-    c_ctx->modif_count = 0; /* how many file descriptors should be closed on cleanup */
-
-    /* lock models that should be committed */
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        if (!info->modified) {
-            continue;
-        }
-        rc = dm_lock_module(dm_ctx, c_ctx->session, info->schema->module->name);
-        if (SR_ERR_LOCKED == rc) {
-            /* check if the lock is hold by session that issued commit */
-            rc = dm_lock_module(dm_ctx, (dm_session_t *)session, info->schema->module->name);
-        }
-        CHECK_RC_LOG_RETURN(rc, "Module %s can not be locked", info->schema->module->name);
-        if (SR_DS_RUNNING == session->datastore) {
-            /* check if all subtrees are enabled */
-            bool has_not_enabled = true;
-            rc = dm_has_not_enabled_nodes(info, &has_not_enabled);
-            CHECK_RC_LOG_RETURN(rc, "Has not enabled check failed for module %s", info->schema->module->name);
-            if (has_not_enabled) {
-//! @cond doxygen_suppress
-#define ERR_FMT "There is a not enabled node in %s module, it can not be committed to the running"
-//! @endcond
-                if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, ERR_FMT, info->schema->module->name)) {
-                    SR_LOG_WRN_MSG("Failed to record commit operation error");
-                }
-                SR_LOG_ERR(ERR_FMT, info->schema->module->name);
-                return SR_ERR_OPERATION_FAILED;
-#undef ERR_FMT
-            }
-        }
+    dm_coalesced_commit_t *coalesced = NULL, lookup = {0};
+    dm_data_info_t *prev_info = NULL, *commit_info = NULL, *info = NULL, lookup_info = {0};
+    dm_session_t *merged_session = NULL;
+    bool created = false;
+
+    lookup_info.schema = schema_info;
+    prev_info = sr_btree_search(c_ctx->prev_data_trees, &lookup_info);
+    commit_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], &lookup_info);
+    if (NULL == prev_info || NULL == commit_info) {
+        SR_LOG_ERR("Data trees of module %s not found in the commit context", schema_info->module_name);
+        return SR_ERR_INTERNAL;
     }
 
-    ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+    pthread_mutex_lock(&dm_ctx->coalesce_lock);
 
-    i = 0;
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        if (!info->modified) {
-            continue;
-        }
+    lookup.module_name = schema_info->module_name;
+    coalesced = sr_btree_search(dm_ctx->coalesced_commits, &lookup);
+    if (NULL == coalesced) {
+        /* first commit within the window - remember the state before the commit */
+        coalesced = calloc(1, sizeof(*coalesced));
+        CHECK_NULL_NOMEM_GOTO(coalesced, rc, cleanup);
+        coalesced->module_name = strdup(schema_info->module_name);
+        CHECK_NULL_NOMEM_GOTO(coalesced->module_name, rc, cleanup);
 
-        /* do not create or do anything with candidate data file, it does not exist and never should */
-        if (session->datastore != SR_DS_CANDIDATE) {
-            rc = sr_get_data_file_name(dm_ctx->data_search_dir, info->schema->module->name, c_ctx->session->datastore, &file_name);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data file name failed");
+        rc = dm_prepare_c_ctx_for_enable_notification(dm_ctx, &coalesced->c_ctx);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Preparing of commit context failed");
+        rc = dm_session_start(dm_ctx, NULL, SR_DS_RUNNING, &coalesced->c_ctx->session);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Start session failed");
+        rc = dm_insert_data_info_copy(coalesced->c_ctx->prev_data_trees, prev_info);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Insert data info copy failed");
 
-            c_ctx->fds[count] = open(file_name, O_RDWR);
-            if (-1 == c_ctx->fds[count]) {
-                SR_LOG_DBG("File %s can not be opened for read write", file_name);
-                if (EACCES == errno) {
-//! @cond doxygen_suppress
-#define ERR_FMT "File %s can not be opened because of authorization"
-//! @endcond
-                    if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, ERR_FMT, file_name)) {
-                        SR_LOG_WRN_MSG("Failed to record commit operation error");
-                    }
-                    SR_LOG_ERR(ERR_FMT, file_name);
-                    rc = SR_ERR_UNAUTHORIZED;
-                    goto cleanup;
-#undef ERR_FMT
-                }
+        rc = sr_btree_insert(dm_ctx->coalesced_commits, coalesced);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Insert into coalesced commits failed");
+        created = true;
+    }
 
-                if (ENOENT == errno) {
-                    SR_LOG_DBG("File %s does not exist, trying to create an empty one", file_name);
-                    c_ctx->fds[count] = open(file_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
-                    CHECK_NOT_MINUS1_LOG_GOTO(c_ctx->fds[count], rc, SR_ERR_IO, cleanup, "File %s can not be created", file_name);
-                }
-            } else {
-                c_ctx->existed[count] = true;
-            }
-            /* file was opened successfully increment the number of files to be closed */
-            c_ctx->modif_count++;
-            /* try to lock for read, non-blocking */
-            rc = sr_lock_fd(c_ctx->fds[count], false, false);
-            if (SR_ERR_OK != rc) {
-//! @cond doxygen_suppress
-#define ERR_FMT "Locking of file '%s' failed: %s."
-//! @endcond
-                if (SR_ERR_OK != sr_add_error(errors, err_cnt, NULL, ERR_FMT, file_name, sr_strerror(rc))) {
-                    SR_LOG_WRN_MSG("Failed to record commit operation error");
-                }
-                SR_LOG_ERR(ERR_FMT, file_name, sr_strerror(rc));
-                rc = SR_ERR_OPERATION_FAILED;
-                goto cleanup;
-#undef ERR_FMT
+    /* replace the state after the commit */
+    merged_session = coalesced->c_ctx->session;
+    info = sr_btree_search(merged_session->session_modules[merged_session->datastore], &lookup_info);
+    if (NULL != info) {
+        sr_btree_delete(merged_session->session_modules[merged_session->datastore], info);
+    }
+    rc = dm_insert_data_info_copy(merged_session->session_modules[merged_session->datastore], commit_info);
+    if (SR_ERR_OK != rc) {
+        /* the pending notification would not carry the latest changes - drop it */
+        SR_LOG_ERR("Unable to merge the changes of module %s into the coalesced commit", schema_info->module_name);
+        sr_btree_delete(dm_ctx->coalesced_commits, coalesced);
+        created = false;
+        goto unlock;
+    }
+    coalesced->commit_cnt++;
+    SR_LOG_DBG("Commit id=%"PRIu32" coalesced with %zu other commit(s) of module %s", c_ctx->id,
+            coalesced->commit_cnt - 1, schema_info->module_name);
+
+cleanup:
+    if (SR_ERR_OK != rc && !created) {
+        /* not inserted into the tree yet */
+        dm_coalesced_commit_free(coalesced);
+    }
+unlock:
+    pthread_mutex_unlock(&dm_ctx->coalesce_lock);
+
+    if (created) {
+        rc = np_commit_coalesce_schedule(dm_ctx->np_ctx, schema_info->module_name);
+        if (SR_ERR_OK != rc) {
+            /* the coalesced commit would never be flushed - drop it */
+            SR_LOG_ERR("Unable to schedule the coalesced notification of module %s", schema_info->module_name);
+            pthread_mutex_lock(&dm_ctx->coalesce_lock);
+            if (coalesced == sr_btree_search(dm_ctx->coalesced_commits, &lookup)) {
+                sr_btree_delete(dm_ctx->coalesced_commits, coalesced);
             }
+            pthread_mutex_unlock(&dm_ctx->coalesce_lock);
         }
+    }
+    return rc;
+}
 
-        bool copy_uptodate;
-        if (session->datastore == SR_DS_CANDIDATE || force_copy_uptodate) {
-            /* candidate datatree is always up-to-date, there is only one copy */
-            copy_uptodate = true;
-        } else {
-            rc = dm_is_info_copy_uptodate(dm_ctx, file_name, info, &copy_uptodate);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "File up to date check failed");
-        }
+int
+dm_commit_coalesce_flush(dm_ctx_t *dm_ctx, const char *module_name)
+{
+    CHECK_NULL_ARG2(dm_ctx, module_name);
+    int rc = SR_ERR_OK;
+    dm_coalesced_commit_t *coalesced = NULL, lookup = {0};
+    dm_commit_context_t *c_ctx = NULL;
+    dm_data_info_t *prev_info = NULL, *commit_info = NULL, lookup_info = {0};
+    dm_model_subscription_t *ms = NULL;
+    sr_list_t *notified_notif = NULL;
+    size_t commit_cnt = 0, attempts = 0;
+    uint32_t commit_id = 0;
+    bool match = false;
 
-        if (session->datastore == SR_DS_CANDIDATE || copy_uptodate) {
-            SR_LOG_DBG("Timestamp for the model %s matches, ops will be skipped", info->schema->module->name);
-            rc = sr_list_add(c_ctx->up_to_date_models, (void *)info->schema->module->name);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+    /* take over the pending coalesced commit */
+    pthread_mutex_lock(&dm_ctx->coalesce_lock);
+    lookup.module_name = (char *) module_name;
+    coalesced = sr_btree_search(dm_ctx->coalesced_commits, &lookup);
+    if (NULL != coalesced) {
+        c_ctx = coalesced->c_ctx;
+        commit_cnt = coalesced->commit_cnt;
+        coalesced->c_ctx = NULL;
+        sr_btree_delete(dm_ctx->coalesced_commits, coalesced);
+    }
+    pthread_mutex_unlock(&dm_ctx->coalesce_lock);
 
-            di = calloc(1, sizeof(*di));
-            CHECK_NULL_NOMEM_GOTO(di, rc, cleanup);
-            di->node = sr_dup_datatree(info->node);
-            if (NULL != info->node && NULL == di->node) {
-                SR_LOG_ERR_MSG("Data tree duplication failed");
-                rc = SR_ERR_INTERNAL;
-                dm_data_info_free(di);
-                goto cleanup;
-            }
-            pthread_mutex_lock(&info->schema->usage_count_mutex);
-            info->schema->usage_count++;
-            SR_LOG_DBG("Usage count %s incremented (value=%zu)", info->schema->module_name, info->schema->usage_count);
-            pthread_mutex_unlock(&info->schema->usage_count_mutex);
-            di->schema = info->schema;
-            di->modified = info->modified;
+    if (NULL == c_ctx) {
+        SR_LOG_DBG("No coalesced commit of module %s", module_name);
+        return SR_ERR_OK;
+    }
 
-            /* duplicate also the list of required modules */
-            rc = dm_dup_required_models_list(info, di);
-            if (SR_ERR_OK != rc) {
-                SR_LOG_ERR_MSG("Duplication of required models list failed");
-                dm_data_info_free(di);
-                goto cleanup;
-            }
+    /* changes between the state before the first and after the last merged commit */
+    prev_info = sr_btree_get_at(c_ctx->prev_data_trees, 0);
+    if (NULL != prev_info) {
+        lookup_info.schema = prev_info->schema;
+        commit_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], &lookup_info);
+    }
+    if (NULL == prev_info || NULL == commit_info) {
+        SR_LOG_ERR("Data trees of the coalesced commit of module %s not found", module_name);
+        rc = SR_ERR_INTERNAL;
+        goto cleanup;
+    }
 
-        } else {
-            /* if the file existed pass FILE 'r+', otherwise pass -1 because there is 'w' fd already */
-            rc = dm_load_data_tree_file(dm_ctx, c_ctx->existed[count] ? c_ctx->fds[count] : -1, file_name, info->schema, &di);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Loading data file failed");
-        }
+    rc = dm_prepare_module_subscriptions(dm_ctx, c_ctx->session, prev_info->schema, &ms);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Prepare module subscriptions failed for module %s", module_name);
 
-        rc = sr_btree_insert(c_ctx->session->session_modules[c_ctx->session->datastore], (void *)di);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR("Insert into commit session avl failed module %s", info->schema->module->name);
-            dm_data_info_free(di);
-            goto cleanup;
-        }
+    ms->difflist = lyd_diff(prev_info->node, commit_info->node, LYD_DIFFOPT_WITHDEFAULTS);
+    if (NULL == ms->difflist) {
+        SR_LOG_ERR("Lyd diff failed for module %s", module_name);
+        dm_model_subscription_free(ms);
+        rc = SR_ERR_INTERNAL;
+        goto cleanup;
+    }
+    rc = sr_btree_insert(c_ctx->subscriptions, ms);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Failed to insert model subscription structure");
+        dm_model_subscription_free(ms);
+        goto cleanup;
+    }
 
-        if (SR_DS_STARTUP != session->datastore || !c_ctx->disabled_config_change ||
-                (NULL != dm_ctx->nacm_ctx && (c_ctx->init_session->options & SR_SESS_ENABLE_NACM))) {
-            /**
-             * For running and candidate we save previous state.
-             * If config change notifications are generated we have to save prev state for startup as well.
-             * if NACM is enabled, we need to get the previous state in any case.
-             */
-            if (session->datastore != SR_DS_CANDIDATE && copy_uptodate) {
-                /* load data tree from file system */
-                rc = dm_load_data_tree_file(dm_ctx, c_ctx->existed[count] ? c_ctx->fds[count] : -1, file_name, info->schema, &di);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "Loading data file failed");
+    rc = sr_list_init(&notified_notif);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
 
-                rc = sr_btree_insert(c_ctx->prev_data_trees, (void *)di);
-                if (SR_ERR_OK != rc) {
-                    SR_LOG_ERR("Insert into prev data trees failed module %s", info->schema->module->name);
-                    dm_data_info_free(di);
-                    goto cleanup;
-                }
-            } else {
-                /* we can reuse data that were just read from file system */
-                rc = dm_insert_data_info_copy(c_ctx->prev_data_trees, di);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "Insert data info copy failed");
-            }
+    /* find coalescing subscriptions matching the net changes */
+    for (size_t s = 0; NULL != ms->subscriptions && s < ms->subscriptions->count; s++) {
+        np_subscription_t *sub = ms->subscriptions->data[s];
+        if (!sub->coalesce || SR__NOTIFICATION_EVENT__APPLY_EV != sub->notif_event) {
+            continue;
         }
+        dm_match_subscription_difflist(ms, s, &match);
+        if (match) {
+            rc = sr_list_add(notified_notif, sub);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
+        }
+    }
 
-        free(file_name);
-        file_name = NULL;
-
-        count++;
+    if (0 == notified_notif->count) {
+        SR_LOG_DBG("No net changes for coalescing subscribers of module %s in %zu commit(s)", module_name, commit_cnt);
+        goto cleanup;
     }
 
-    ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+    /* the id drawn when the coalesced commit was created has not been reserved in commit_ctxs
+     * and a regular commit may have taken it meanwhile, draw it again and retry if it is taken
+     * before the insert */
+    do {
+        rc = dm_create_commit_ctx_id(dm_ctx, c_ctx);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to generate commit id");
+        rc = dm_insert_commit_context(dm_ctx, c_ctx);
+    } while (SR_ERR_DATA_EXISTS == rc && ++attempts < DM_COMMIT_CTX_ID_MAX_ATTEMPTS);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert commit context");
+    commit_id = c_ctx->id;
+    /* the commit context is released once all notifications are acknowledged */
+    c_ctx = NULL;
 
-    return rc;
+    SR_LOG_DBG("Sending coalesced apply notifications of %zu commit(s) of module %s (commit id=%"PRIu32")",
+            commit_cnt, module_name, commit_id);
+    for (size_t i = 0; i < notified_notif->count; i++) {
+        np_subscription_t *sub = notified_notif->data[i];
+        rc = np_subscription_notify(dm_ctx->np_ctx, sub, SR_EV_APPLY, commit_id);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_WRN("Unable to send notifications about the changes for the subscription in module %s xpath %s.",
+                    sub->module_name, sub->xpath);
+        }
+    }
+    rc = np_commit_notifications_sent(dm_ctx->np_ctx, commit_id, true, notified_notif);
 
 cleanup:
-    ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
-    free(file_name);
+    dm_free_commit_context(c_ctx);
+    sr_list_cleanup(notified_notif);
     return rc;
 }
 
 int
-dm_commit_writelock_fds(dm_session_t *session, dm_commit_context_t *commit_ctx)
+dm_commit_notify(dm_ctx_t *dm_ctx, dm_session_t *session, sr_notif_event_t ev, dm_commit_context_t *c_ctx)
 {
-    CHECK_NULL_ARG2(session, commit_ctx);
+    CHECK_NULL_ARG3(dm_ctx, session, c_ctx);
     int rc = SR_ERR_OK;
-    int cnt = 0;
     size_t i = 0;
-    dm_data_info_t *info = NULL;
+    dm_data_info_t *info = NULL, *commit_info = NULL, *prev_info = NULL, lookup_info = {0};
+    dm_model_subscription_t *ms = NULL;
+    bool match = false;
+    sr_list_t *notified_notif = NULL;
+    dm_module_difflist_t *module_difflist = NULL, lookup_difflist = {0};
+
+    c_ctx->should_be_removed = false;
+
+    /* notification are sent only when running or candidate is committed*/
+    if (SR_DS_STARTUP == session->datastore) {
+        c_ctx->state = DM_COMMIT_WRITE;
+        return SR_ERR_OK;
+    }
+
+    rc = sr_list_init(&notified_notif);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
 
+    SR_LOG_DBG("Sending %s notifications about the changes made in running datastore...", sr_notification_event_sr_to_str(ev));
     while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
         if (!info->modified) {
             continue;
         }
-        /* try to lock for write, non-blocking */
-        rc = sr_lock_fd(commit_ctx->fds[cnt], true, false);
-        CHECK_RC_LOG_RETURN(rc, "Locking of file for module '%s' failed: %s.", info->schema->module_name, sr_strerror(rc));
-        cnt++;
-    }
-    return rc;
-}
+        size_t d_cnt = 0;
+        dm_model_subscription_t lookup = {0};
+        struct lyd_difflist *diff = NULL;
 
-int
-dm_commit_write_files(dm_session_t *session, dm_commit_context_t *c_ctx)
-{
-    CHECK_NULL_ARG2(session, c_ctx);
-    int rc = SR_ERR_OK;
-    int ret = 0;
-    size_t i = 0;
-    size_t count = 0;
-    dm_data_info_t *info = NULL;
-    dm_tmp_ly_ctx_t *tmp_ctx = NULL;
-    struct lyd_node *tmp_data_tree = NULL;
-    struct ly_ctx *ly_ctx = NULL;
+        lookup.schema_info = info->schema;
 
-    /* write data trees */
-    i = 0;
-    dm_data_info_t *merged_info = NULL;
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        if (info->modified) {
-            /* get merged info */
-            merged_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], info);
-            if (NULL == merged_info) {
-                SR_LOG_ERR("Merged data info %s not found", info->schema->module->name);
-                rc = SR_ERR_INTERNAL;
+        ms = sr_btree_search(c_ctx->subscriptions, &lookup);
+        if (NULL == ms) {
+            SR_LOG_WRN("No subscription found for %s", info->schema->module->name);
+            lyd_free_diff(diff);
+            continue;
+        }
+
+        /* changes are generated only for SR_EV_VERIFY and SR_EV_ABORT */
+        if (SR_EV_VERIFY == ev || SR_EV_ABORT == ev) {
+            lookup_info.schema = info->schema;
+            /* configuration before commit */
+            prev_info = sr_btree_search(c_ctx->prev_data_trees, &lookup_info);
+            if (NULL == prev_info) {
+                SR_LOG_ERR("Current data tree for module %s not found", info->schema->module->name);
+                continue;
+            }
+            /* configuration after commit */
+            commit_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], &lookup_info);
+            if (NULL == commit_info) {
+                SR_LOG_ERR("Commit data tree for module %s not found", info->schema->module->name);
                 continue;
             }
-            /* remove attached data trees */
-            ret = dm_remove_added_data_trees(session, info);
 
-            /* print using tmp context if schemas different from installation time deps are needed */
-            if (NULL != merged_info->required_modules) {
-                SR_LOG_DBG("Additional schemas are needed to print data of modules %s", merged_info->schema->module_name);
-                rc = dm_get_tmp_ly_ctx(session->dm_ctx, merged_info->required_modules, &tmp_ctx);
-                if (SR_ERR_OK == rc) {
-                    tmp_data_tree = sr_dup_datatree_to_ctx(merged_info->node, tmp_ctx->ctx);
+            /* for SR_EV_ABORT inverse changes are generated */
+            if (SR_EV_VERIFY == ev) {
+                if (NULL != dm_ctx->nacm_ctx && (c_ctx->init_session->options & SR_SESS_ENABLE_NACM)) {
+                    /* already obtained in the NACM phase */
+                    lookup_difflist.schema_info = info->schema;
+                    module_difflist = sr_btree_search(c_ctx->difflists, &lookup_difflist);
+                    if (NULL == module_difflist || NULL == module_difflist->difflist) {
+                        SR_LOG_ERR("Diff-list for module %s not found", info->schema->module->name);
+                        continue;
+                    }
+                    diff = module_difflist->difflist;
+                    module_difflist->difflist = NULL; /* remove diff from the binary tree */
                 } else {
-                    SR_LOG_ERR_MSG("Failed to acquired tmp ly_ctx");
-                    continue;
+                    diff = lyd_diff(prev_info->node, commit_info->node, LYD_DIFFOPT_WITHDEFAULTS);
                 }
+            } else {
+                diff = lyd_diff(commit_info->node, prev_info->node, LYD_DIFFOPT_WITHDEFAULTS);
             }
-
-            if (SR_ERR_OK == ret) {
-                ret = ftruncate(c_ctx->fds[count], 0);
-            }
-            if (0 == ret) {
-                ly_errno = LY_SUCCESS; /* needed to check if the error was in libyang or not below */
-                ret = lyd_print_fd(c_ctx->fds[count], NULL == merged_info->required_modules ? merged_info->node : tmp_data_tree,
-                            SR_FILE_FORMAT_LY, LYP_WITHSIBLINGS | LYP_FORMAT);
+            if (NULL == diff) {
+                SR_LOG_ERR("Lyd diff failed for module %s", info->schema->module->name);
+                continue;
             }
 
-            if (NULL != merged_info->required_modules) {
-                lyd_free_withsiblings(tmp_data_tree);
-                tmp_data_tree = NULL;
-                dm_release_tmp_ly_ctx(session->dm_ctx, tmp_ctx);
+            if (diff->type[d_cnt] == LYD_DIFF_END) {
+                SR_LOG_DBG("No changes in module %s", info->schema->module->name);
+                lyd_free_diff(diff);
+                continue;
             }
 
-            if (0 == ret) {
-                ret = fsync(c_ctx->fds[count]);
-            }
-            if (0 != ret) {
-                if (ly_errno) {
-                    ly_ctx = (NULL == merged_info->required_modules ? merged_info->node->schema->module->ctx :
-                          tmp_data_tree->schema->module->ctx);
+            /* remove changes generated during verify phase */
+            if (NULL != ms->changes) {
+                for (int i = 0; i < ms->changes->count; i++) {
+                    sr_free_changes(ms->changes->data[i], 1);
                 }
-                SR_LOG_ERR("Failed to write data of '%s' module: %s", info->schema->module->name,
-                        (ly_errno != LY_SUCCESS) ? ly_errmsg(ly_ctx) : sr_strerror_safe(errno));
-                rc = SR_ERR_INTERNAL;
-            } else {
-                SR_LOG_DBG("Data successfully written for module '%s'", info->schema->module->name);
+                sr_list_cleanup(ms->changes);
             }
-            if (0 == ret && SR_DS_RUNNING == c_ctx->session->datastore) {
-                if (0 == strcmp("ietf-netconf-acm", info->schema->module_name)) {
-                    c_ctx->nacm_edited = true;
-                }
+            ms->changes = NULL;
+
+            lyd_free_diff(ms->difflist);
+            ms->changes_generated = false;
+            /* store differences in commit context */
+            ms->difflist = diff;
+        }
+
+        /* Log changes */
+        if (NULL != diff && (SR_LL_DBG == sr_ll_stderr || SR_LL_DBG == sr_ll_syslog)) {
+            while (LYD_DIFF_END != diff->type[d_cnt]) {
+                char *path = dm_get_notification_changed_xpath(diff, d_cnt);
+                SR_LOG_DBG("%s: %s", dm_get_diff_type_to_string(diff->type[d_cnt]), path);
+                free(path);
+                d_cnt++;
             }
-            count++;
         }
     }
-    /* save time of the last commit */
-    sr_clock_get_time(CLOCK_REALTIME, &session->dm_ctx->last_commit_time);
 
-    return rc;
-}
+    if (SR_EV_VERIFY == ev) {
+        rc = dm_save_commit_context(dm_ctx, c_ctx);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR_MSG("Saving of commit context failed");
+        }
+    } else {
+        /* apply abort */
+        dm_release_resources_commit_context(dm_ctx, c_ctx);
+        rc = dm_save_commit_context(dm_ctx, c_ctx);
+        /* if there is a verify subscription commit context is already saved */
+        if (SR_ERR_DATA_EXISTS == rc) {
+            rc = SR_ERR_OK;
+        }
+    }
 
-/**
- * @brief Find equal \p node instance in \p data tree. Be careful, this implementation
- * is tailored for use on 2 diffed trees, so some additional assumptions hold that are
- * taken into consideration.
- */
-static struct lyd_node *
-dm_find_data_instance(const struct lyd_node *data, const struct lyd_node *node)
-{
-    struct ly_set *set = NULL;
-    struct lyd_node *ret = NULL;
-    struct lyd_node_leaf_list *k1, *k2;
-    uint32_t i, j;
+    i = 0;
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        if (!info->modified) {
+            continue;
+        }
+        bool coalesce = false;
+        dm_model_subscription_t lookup = {0};
 
-    if (data == NULL || (set = lyd_find_instance(data, node->schema)) == NULL) {
-        return NULL;
-    }
+        lookup.schema_info = info->schema;
 
-    for (i = 0; !ret && (i < set->number); ++i) {
-        switch (node->schema->nodetype) {
-        case LYS_CONTAINER:
-        case LYS_LEAF:
-        case LYS_ANYXML:
-        case LYS_ANYDATA:
-            /* it is assumed that if leaf, anyxml, anydata exist, they have the same value */
-            ret = set->set.d[0];
-            break;
-        case LYS_LEAFLIST:
-            if (!strcmp(((struct lyd_node_leaf_list *)node)->value_str,
-                        ((struct lyd_node_leaf_list *)set->set.d[i])->value_str)) {
-                ret = set->set.d[i];
-            }
-            break;
-        case LYS_LIST:
-            k1 = (struct lyd_node_leaf_list *)node->child;
-            k2 = (struct lyd_node_leaf_list *)set->set.d[i]->child;
-            for (j = 0; j < ((struct lys_node_list *)node->schema)->keys_size; ++j) {
-                if (strcmp(k1->value_str, k2->value_str)) {
-                    break;
+        ms = sr_btree_search(c_ctx->subscriptions, &lookup);
+        if (NULL == ms) {
+            SR_LOG_WRN("No subscription found for %s", info->schema->module->name);
+            continue;
+        }
+        if (NULL == ms->difflist) {
+            continue;
+        }
+
+        /* loop through subscription test if they should be notified */
+        if (NULL != ms->subscriptions) {
+            for (size_t s = 0; s < ms->subscriptions->count; s++) {
+                np_subscription_t *sub = ms->subscriptions->data[s];
+                if (dm_should_skip_subscription(sub, c_ctx, ev)) {
+                    continue;
+                }
+                if (SR_EV_APPLY == ev && sub->coalesce) {
+                    /* notified later, together with the following commits */
+                    coalesce = true;
+                    continue;
+                }
+
+                dm_match_subscription_difflist(ms, s, &match);
+
+                if (match) {
+                    /* something has been changed for this subscription, send notification */
+                    rc = np_subscription_notify(dm_ctx->np_ctx, sub, ev, c_ctx->id);
+                    if (SR_ERR_OK != rc) {
+                       SR_LOG_WRN("Unable to send notifications about the changes for the subscription in module %s xpath %s.",
+                               sub->module_name,
+                               sub->xpath);
+                    }
+                    rc = sr_list_add(notified_notif, sub);
+                    if (SR_ERR_OK != rc) {
+                       SR_LOG_WRN_MSG("List add failed");
+                    }
                 }
-                k1 = (struct lyd_node_leaf_list *)k1->next;
-                k2 = (struct lyd_node_leaf_list *)k2->next;
             }
-            if (j < ((struct lys_node_list *)node->schema)->keys_size) {
-                ret = set->set.d[i];
+        }
+
+        if (coalesce) {
+            /* coalescing subscribers are notified about the net changes after the coalescing window */
+            if (SR_ERR_OK != dm_commit_coalesce_add(dm_ctx, c_ctx, info->schema)) {
+                SR_LOG_WRN("Unable to coalesce the changes of module %s", info->schema->module->name);
             }
-            break;
-        default:
-            assert(0);
         }
     }
 
-    return ret;
+    if (SR_EV_VERIFY == ev ){
+        if (notified_notif->count > 0) {
+            c_ctx->state = DM_COMMIT_WAIT_FOR_NOTIFICATIONS;
+        } else {
+            c_ctx->state = DM_COMMIT_WRITE;
+        }
+    } else {
+        c_ctx->state = DM_COMMIT_FINISHED;
+    }
+
+    /* let the np know that the commit has finished */
+    if (SR_ERR_OK == rc && notified_notif->count > 0) {
+        c_ctx->should_be_removed = false;
+        rc = np_commit_notifications_sent(dm_ctx->np_ctx, c_ctx->id, SR_EV_VERIFY != ev, notified_notif);
+    } else {
+        c_ctx->should_be_removed = true;
+    }
+
+    sr_list_cleanup(notified_notif);
+    return rc;
 }
 
-/**
- * @brief Perform read NACM check on a single node, revert it if read access is not granted.
- */
-static int
-dm_copy_config_read_nacm_single_node(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx,
-        const struct lyd_node *node, struct lyd_difflist *diff, size_t diff_idx, size_t *diff_size,
-        struct lyd_node *cc_tree, bool *denied)
+int
+dm_feature_enable(dm_ctx_t *dm_ctx, const char *module_name, const char *feature_name, bool enable)
 {
+    CHECK_NULL_ARG3(dm_ctx, module_name, feature_name);
     int rc = SR_ERR_OK;
-    nacm_action_t nacm_action = NACM_ACTION_PERMIT;
-    const char *rule_name = NULL, *rule_info = NULL;
-    void *tmp = NULL;
-    struct lyd_node_anydata *tmp_node = NULL;
-    struct lyd_node *cc_first = NULL, *cc_second = NULL;
+    dm_schema_info_t *schema_info = NULL;
+    md_module_t *module = NULL;
+    md_dep_t *dep = NULL;
+    sr_llist_node_t *ll_node = NULL;
+    dm_schema_info_t *si = NULL;
+    dm_schema_info_t lookup = {0};
 
-    rc = nacm_check_data(nacm_data_val_ctx, NACM_ACCESS_READ, node, &nacm_action, &rule_name, &rule_info);
-    CHECK_RC_LOG_RETURN(rc, "NACM data validation failed for node: %s.", node->schema->name);
+    rc = dm_get_module_and_lockw(dm_ctx, module_name, &schema_info);
+    CHECK_RC_LOG_RETURN(rc, "dm_get_module %s and lock failed", module_name);
 
-    if (NACM_ACTION_DENY == nacm_action) {
-        /* report check fail */
-        nacm_report_read_access_denied(session->user_credentials, node, rule_name, rule_info);
+    rc = dm_feature_enable_internal(dm_ctx, schema_info, module_name, feature_name, enable);
+    pthread_rwlock_unlock(&schema_info->model_lock);
+    CHECK_RC_LOG_RETURN(rc, "Failed to %s feature '%s' in module '%s'.", enable ? "enable" : "disable", feature_name, module_name);
 
-        /* revert the change in the copy-config (cc)tree */
-        switch (diff->type[diff_idx]) {
-        case LYD_DIFF_CHANGED:
-            if (node->schema->nodetype == LYS_LEAF) {
-                if (lyd_change_leaf((struct lyd_node_leaf_list *)diff->second[diff_idx],
-                            ((struct lyd_node_leaf_list *)diff->first[diff_idx])->value_str) < 0) {
-                    return SR_ERR_INTERNAL;
-                }
-            } else { /* LYS_ANYXML, LYS_ANYDATA */
-                tmp_node = (struct lyd_node_anydata *)lyd_dup(diff->first[diff_idx], 0);
-                /* switch values and free the copy */
-                tmp = (void *)((struct lyd_node_anydata *)diff->second[diff_idx])->value_type;
-                ((struct lyd_node_anydata *)diff->second[diff_idx])->value_type = tmp_node->value_type;
-                tmp_node->value_type = (LYD_ANYDATA_VALUETYPE)tmp;
+    /* apply the change in all loaded schema infos */
+    md_ctx_lock(dm_ctx->md_ctx, true);
+    pthread_rwlock_wrlock(&dm_ctx->schema_tree_lock);
+    rc = md_get_module_info(dm_ctx->md_ctx, module_name, NULL, NULL, &module);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module %s info failed", module_name);
 
-                memcpy(&tmp, &((struct lyd_node_anydata *)diff->second[diff_idx])->value, sizeof tmp);
-                ((struct lyd_node_anydata *)diff->second[diff_idx])->value = tmp_node->value;
-                memcpy(&tmp_node->value, &tmp, sizeof tmp);
+    /* enable feature in all modules augmented by this module */
+    ll_node = module->inv_deps->first;
+    while (ll_node) {
+        dep = (md_dep_t *) ll_node->data;
+        if (dep->type == MD_DEP_EXTENSION && dep->dest->implemented) {
+            lookup.module_name = (char *) dep->dest->name;
+            si = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
+            if (NULL != si && NULL != si->ly_ctx) {
+                rc = dm_lock_schema_info_write(si);
+                CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to lock schema info %s", si->module_name);
 
-                lyd_free((struct lyd_node *)tmp_node);
-            }
-            break;
-        case LYD_DIFF_MOVEDAFTER1:
-            cc_first = dm_find_data_instance(cc_tree, diff->first[diff_idx]);
-            if (diff->first[diff_idx]->prev != diff->first[diff_idx]) {
-                cc_second = dm_find_data_instance(cc_tree, diff->first[diff_idx]->prev);
-                lyd_insert_after(cc_second, cc_first);
-            } else {
-                cc_second = dm_find_data_instance(cc_tree, diff->first[diff_idx]->next);
-                lyd_insert_before(cc_second, cc_first);
-            }
-            break;
-        case LYD_DIFF_DELETED:
-            if (diff->first[diff_idx]->parent) {
-                cc_first = dm_find_data_instance(cc_tree, diff->first[diff_idx]->parent);
-                lyd_insert(cc_first, lyd_dup(diff->first[diff_idx], 1));
-            } else {
-                lyd_insert_sibling(&cc_tree, lyd_dup(diff->first[diff_idx], 1));
+                rc = dm_feature_enable_internal(dm_ctx, si, module_name, feature_name, enable);
+                pthread_rwlock_unlock(&si->model_lock);
+                CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load schema %s", module->filepath);
             }
-            break;
-        case LYD_DIFF_CREATED:
-            lyd_free(diff->second[diff_idx]);
-            break;
-        default:
-            /* LYD_DIFF_MOVEDAFTER2 should not be passed to this function,
-             * access control performed already for LYD_DIFF_CREATED of this node */
-            assert(0);
-        }
-
-        /* remove this diff item */
-        --(*diff_size);
-        memmove(&diff->type[diff_idx], &diff->type[diff_idx + 1], (*diff_size - diff_idx) * sizeof *diff->type);
-        memmove(&diff->first[diff_idx], &diff->first[diff_idx + 1], (*diff_size - diff_idx) * sizeof *diff->first);
-        memmove(&diff->second[diff_idx], &diff->second[diff_idx + 1], (*diff_size - diff_idx) * sizeof *diff->second);
-
-        if (denied) {
-            *denied = true;
         }
-    } else if (denied) {
-        *denied = false;
+        ll_node = ll_node->next;
     }
 
-    return SR_ERR_OK;
+cleanup:
+    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+    md_ctx_unlock(dm_ctx->md_ctx);
+
+    return rc;
 }
 
-/**
- * @brief Perform read NACM check on every node in the subtree, revert any subtrees with read access not granted.
- */
-static int
-dm_copy_config_read_nacm_subtree(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx,
-        const struct lyd_node *root, struct lyd_difflist *diff, size_t diff_idx, size_t *diff_size)
+int
+dm_install_module(dm_ctx_t *dm_ctx, dm_session_t *session, const char *module_name,
+        const char *revision, const char *file_name, sr_list_t **implicitly_installed_p)
 {
-    int rc = SR_ERR_OK;
-    bool backtracking = false, denied = false;
-    const struct lyd_node *node = NULL;
+    CHECK_NULL_ARG5(dm_ctx, session, module_name, file_name, implicitly_installed_p); /* revision can be NULL */
 
-    assert(diff->type[diff_idx] == LYD_DIFF_CREATED);
+    int rc = 0;
+    md_module_t *module = NULL;
+#ifndef SHARED_LY_CTX
+    md_dep_t *dep = NULL;
+    sr_llist_node_t *ll_node = NULL;
+    dm_schema_info_t *si = NULL, *si_ext = NULL;
+    dm_schema_info_t lookup = {0};
+#endif
+    sr_list_t *implicitly_installed = NULL;
 
-    node = root;
-    while (!backtracking || node != root) {
-        if (false == backtracking) {
-            rc = dm_copy_config_read_nacm_single_node(session, nacm_data_val_ctx, node, diff, diff_idx, diff_size, NULL, &denied);
-            if (SR_ERR_OK != rc) {
-                return rc;
-            }
-            if (!denied && !(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) && node->child) {
-                node = node->child;
-            } else if (node->next && node != root) {
-                node = node->next;
-            } else {
-                backtracking = true;
-            }
-        } else {
-            if (node->next) {
-                node = node->next;
-                backtracking = false;
-            } else {
-                node = node->parent;
+    /* insert module into the dependency graph */
+    md_ctx_lock(dm_ctx->md_ctx, true);
+    pthread_rwlock_wrlock(&dm_ctx->schema_tree_lock);
+
+    rc = md_insert_module(dm_ctx->md_ctx, file_name, &implicitly_installed);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert module into the dependency graph");
+
+    rc = md_get_module_info(dm_ctx->md_ctx, module_name, revision, NULL, &module);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module %s info failed", module_name);
+
+#ifdef SHARED_LY_CTX
+    /* switch to a new epoch of the shared context containing the installed module,
+     * the loaded schema infos (including the augmented ones) are moved into it */
+    rc = dm_shared_ly_ctx_swap(dm_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to swap the shared libyang context");
+#else
+
+    lookup.module_name = (char *) module_name;
+    si = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
+    if (NULL != si) {
+        RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&si->model_lock, rc, cleanup);
+        if (NULL != si->ly_ctx) {
+            SR_LOG_WRN("Module %s already loaded", si->module_name);
+            goto unlock;
+        }
+        /* load module and its dependencies into si */
+        si->ly_ctx = ly_ctx_new(dm_ctx->schema_search_dir, LY_CTX_NOYANGLIBRARY);
+        CHECK_NULL_NOMEM_GOTO(si->ly_ctx, rc, unlock);
+
+        rc = dm_load_schema_file(module->filepath, si, NULL);
+        CHECK_RC_LOG_GOTO(rc, unlock, "Failed to load schema %s", module->filepath);
+
+        si->module = ly_ctx_get_module(si->ly_ctx, module_name, NULL, 1);
+        if (NULL == si->module){
+            rc = SR_ERR_INTERNAL;
+            goto unlock;
+        }
+
+        ll_node = module->deps->first;
+        while (ll_node) {
+            dep = (md_dep_t *)ll_node->data;
+            if (dep->type == MD_DEP_DATA) {
+                /* mark this module as dependent on data from other modules */
+                si->cross_module_data_dependency = true;
+                break;
             }
+            ll_node = ll_node->next;
         }
-    }
 
-    return SR_ERR_OK;
-}
+        /* compute xpath hashes for all schema nodes (referenced from data tree) */
+        rc = dm_init_missing_node_priv_data(si);
+        CHECK_RC_LOG_GOTO(rc, unlock, "Failed to initialize private data for module %s", module->name);
 
-/**
- * @brief Perform NETCONF access control for a single node.
- */
-static int
-dm_commit_nacm_single_node(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx, const struct lyd_node *node,
-        nacm_access_flag_t access_type, bool *denied, sr_error_info_t **errors, size_t *err_cnt)
-{
-    int rc = SR_ERR_OK;
-    nacm_action_t nacm_action = NACM_ACTION_PERMIT;
-    const char *rule_name = NULL, *rule_info = NULL;
+        if (dm_module_has_persist(module)) {
+            rc = dm_apply_persist_data_for_model(dm_ctx, session, module->name, si, false);
+            CHECK_RC_LOG_GOTO(rc, unlock, "Failed to apply persist data for %s", module->name);
+        }
+
+        /* distinguish between modules that can and cannot be locked */
+        si->can_not_be_locked = !module->has_data;
+unlock:
+        if (si) {
+            pthread_rwlock_unlock(&si->model_lock);
+        }
+    } else {
+        /* module is installed for the first time, will be loaded when a request
+         * into this module is received */
+        SR_LOG_DBG("Module %s will be loaded when a request for it comes", module_name);
+    }
 
-    CHECK_NULL_ARG4(session, nacm_data_val_ctx, node, denied);
-    CHECK_NULL_ARG2(errors, err_cnt);
+    /* load this module also into contexts of newly augmented modules */
+    ll_node = module->inv_deps->first;
+    while (ll_node) {
+        dep = (md_dep_t *)ll_node->data;
+        if (dep->type == MD_DEP_EXTENSION && dep->dest->implemented) {
+            lookup.module_name = (char *)dep->dest->name;
+            si_ext = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
+            if (NULL != si_ext && NULL != si_ext->ly_ctx) {
+                rc = dm_load_schema_file(module->filepath, si_ext, NULL);
+                CHECK_RC_LOG_GOTO(rc, unlock, "Failed to load schema %s", module->filepath);
 
-    *denied = false;
-    rc = nacm_check_data(nacm_data_val_ctx, access_type, node, &nacm_action, &rule_name, &rule_info);
-    CHECK_RC_LOG_RETURN(rc, "NACM data validation failed for node: %s.", node->schema->name);
+                /* compute xpath hashes for all newly added schema nodes (through augment) */
+                rc = dm_init_missing_node_priv_data(si_ext);
+                CHECK_RC_LOG_GOTO(rc, unlock, "Failed to initialize private data for module %s", dep->dest->name);
 
-    if (NACM_ACTION_DENY == nacm_action) {
-        nacm_report_edit_access_denied(session->user_credentials, session, node, access_type,
-                rule_name, rule_info);
-        if (SR_ERR_OK != sr_add_error(errors, err_cnt, session->error_xpath, "%s", session->error_msg)) {
-            SR_LOG_WRN_MSG("Failed to record authorization error");
+                if (dm_module_has_persist(module)) {
+                    rc = dm_apply_persist_data_for_model(dm_ctx, session, module->name, si_ext, false);
+                    CHECK_RC_LOG_GOTO(rc, unlock, "Failed to apply persist data for %s", module->name);
+                }
+            }
         }
-        *denied = true;
+        ll_node = ll_node->next;
     }
-    return SR_ERR_OK;
+#endif
+
+cleanup:
+    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+    md_ctx_unlock(dm_ctx->md_ctx);
+    if (SR_ERR_OK == rc) {
+        *implicitly_installed_p = implicitly_installed;
+    } else {
+        md_free_module_key_list(implicitly_installed);
+    }
+    return rc;
 }
 
 /**
- * @brief Perform NETCONF access control for all nodes inside a subtree.
+ * @brief Disables module
+ * @param [in] dm_ctx
+ * @param [in] module_name
+ * @param [in] revision
+ * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_commit_nacm_subtree(dm_session_t *session, nacm_data_val_ctx_t *nacm_data_val_ctx, const struct lyd_node *root,
-        nacm_access_flag_t access_type, int *denied_cnt, sr_error_info_t **errors, size_t *err_cnt)
+dm_uninstall_module_schema(dm_ctx_t *dm_ctx, const char *module_name, const char *revision)
 {
+    CHECK_NULL_ARG2(dm_ctx, module_name);
     int rc = SR_ERR_OK;
-    bool denied = false;
-    bool backtracking = false;
-    const struct lyd_node *node = NULL;
+    dm_schema_info_t lookup = {0};
+    dm_schema_info_t *schema_info = NULL;
 
-    node = root;
-    while (!backtracking || node != root) {
-        if (false == backtracking) {
-            rc = dm_commit_nacm_single_node(session, nacm_data_val_ctx, node, access_type, &denied, errors, err_cnt);
-            *denied_cnt += denied;
-            if (SR_ERR_OK != rc) {
-                return rc;
-            }
-            if (!denied && !(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) && node->child) {
-                node = node->child;
-            } else if (node->next && node != root) {
-                node = node->next;
-            } else {
-                backtracking = true;
-            }
-        } else {
-            if (node->next) {
-                node = node->next;
-                backtracking = false;
+    RWLOCK_RDLOCK_TIMED_CHECK_RETURN(&dm_ctx->schema_tree_lock);
+    lookup.module_name = (char *) module_name;
+
+    schema_info = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
+    if (NULL != schema_info) {
+        pthread_rwlock_wrlock(&schema_info->model_lock);
+        if (NULL != schema_info->ly_ctx){
+            pthread_mutex_lock(&schema_info->usage_count_mutex);
+            if (0 != schema_info->usage_count) {
+                rc = SR_ERR_OPERATION_FAILED;
+                SR_LOG_ERR("Module %s can not be uninstalled because it is being used. (referenced by %zu)", module_name, schema_info->usage_count);
             } else {
-                node = node->parent;
+#ifdef SHARED_LY_CTX
+                dm_shared_schema_info_unbind(schema_info);
+#else
+                dm_schema_info_caches_invalidate(schema_info);
+                ly_ctx_destroy(schema_info->ly_ctx, dm_free_lys_private_data);
+                schema_info->ly_ctx = NULL;
+                schema_info->module = NULL;
+#endif
+                SR_LOG_DBG("Module %s uninstalled", module_name);
             }
+            pthread_mutex_unlock(&schema_info->usage_count_mutex);
         }
+        pthread_rwlock_unlock(&schema_info->model_lock);
+    } else {
+        SR_LOG_DBG("Module %s is not loaded, can be uninstalled safely", module_name);
     }
 
-    return SR_ERR_OK;
+    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+
+    CHECK_RC_LOG_RETURN(rc, "Uninstallation of module %s was not successful", module_name);
+    return rc;
 }
 
-static int
-dm_perform_netconf_access_control(nacm_ctx_t *nacm_ctx, dm_session_t *session, dm_data_info_t *prev_info,
-                                  dm_data_info_t *new_info, bool copy_config, sr_error_info_t **errors, size_t *err_cnt,
-                                  dm_commit_context_t *c_ctx)
+int
+dm_uninstall_module(dm_ctx_t *dm_ctx, const char *module_name, const char *revision,
+        sr_list_t **implicitly_removed_p)
 {
-    CHECK_NULL_ARG4(nacm_ctx, session, prev_info, new_info);
+    CHECK_NULL_ARG2(dm_ctx, module_name);
     int rc = SR_ERR_OK;
-    size_t d_cnt = 0, d_idx = 0;
-    bool denied = false, saved_diff = false;
-    int denied_cnt = 0;
-    nacm_data_val_ctx_t *nacm_data_val_ctx = NULL;
-    struct lyd_difflist *diff = NULL;
-    dm_module_difflist_t *module_difflist = NULL;
+    md_module_t *module = NULL;
+    md_module_key_t *module_key = NULL;
+    sr_list_t *implicitly_removed = NULL;
 
-    /* get the set of changes */
-    saved_diff = false;
-    diff = lyd_diff(prev_info->node, new_info->node, LYD_DIFFOPT_WITHDEFAULTS);
-    if (NULL == diff) {
-        SR_LOG_ERR("Lyd diff failed for module %s", prev_info->schema->module->name);
-        rc = SR_ERR_INTERNAL;
+    /* uninstall context with module schema */
+    rc = dm_uninstall_module_schema(dm_ctx, module_name, revision);
+    if (SR_ERR_OK != rc) {
         goto cleanup;
     }
 
-    if (NULL != c_ctx) {
-        /* save diff for VERIFY notifications (even if the set is empty) */
-        module_difflist = calloc(1, sizeof *module_difflist);
-        CHECK_NULL_NOMEM_GOTO(module_difflist, rc, cleanup);
-        module_difflist->schema_info = prev_info->schema;
-        module_difflist->difflist = diff;
-        saved_diff = true;
-        rc = sr_btree_insert(c_ctx->difflists, (void *)module_difflist);
-        CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to insert diff-list for module %s into the binary tree",
-                    prev_info->schema->module->name);
-        module_difflist = NULL;
-    }
+    md_ctx_lock(dm_ctx->md_ctx, true);
+    rc = md_get_module_info(dm_ctx->md_ctx, module_name, revision, NULL, &module);
 
-    if (diff->type[0] == LYD_DIFF_END) {
-        SR_LOG_DBG("No changes in module %s", prev_info->schema->module->name);
-        return SR_ERR_OK;
+    /* remove module from the dependency graph */
+    if (NULL == module) {
+        SR_LOG_ERR("Module %s with revision %s was not found", module_name, revision);
+        rc = SR_ERR_NOT_FOUND;
+    } else {
+        rc = md_remove_modules(dm_ctx->md_ctx, &module_name, &revision, 1, &implicitly_removed);
     }
 
-    /* start NACM data access validation for this module */
-    struct lys_node *schema = new_info->node == NULL ? prev_info->node->schema : new_info->node->schema;
-    rc = nacm_data_validation_start(nacm_ctx, session->user_credentials, schema,
-            &nacm_data_val_ctx);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to start NACM data validation.");
+    /* uninstall also modules that were "silently" removed */
+    for (size_t i = 0; rc == SR_ERR_OK && NULL != implicitly_removed && i < implicitly_removed->count; ++i) {
+        module_key = (md_module_key_t *)implicitly_removed->data[i];
+        rc = dm_uninstall_module_schema(dm_ctx, module_key->name, module_key->revision_date);
+    }
 
-    if (copy_config) {
-        /* count diff items */
-        for (d_cnt = 0; LYD_DIFF_END != diff->type[d_cnt]; ++d_cnt);
-        ++d_cnt;
+#ifdef SHARED_LY_CTX
+    if (SR_ERR_OK == rc) {
+        /* switch to a new epoch of the shared context without the removed modules */
+        pthread_rwlock_wrlock(&dm_ctx->schema_tree_lock);
+        rc = dm_shared_ly_ctx_swap(dm_ctx);
+        pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
+    }
+#endif
 
-        /* for copy_config perform read access checks */
-        d_idx = d_cnt - 1;
-        do {
-            --d_idx;
-            switch (diff->type[d_idx]) {
-            case LYD_DIFF_CHANGED:
-            case LYD_DIFF_MOVEDAFTER1:
-            case LYD_DIFF_DELETED:
-                rc = dm_copy_config_read_nacm_single_node(session, nacm_data_val_ctx, diff->first[d_idx],
-                        diff, d_idx, &d_cnt, new_info->node, NULL);
-                break;
-            case LYD_DIFF_CREATED:
-                rc = dm_copy_config_read_nacm_subtree(session, nacm_data_val_ctx, diff->second[d_idx],
-                        diff, d_idx, &d_cnt);
-                break;
-            case LYD_DIFF_MOVEDAFTER2:
-                break;
-            default:
-                assert(0 && "not reachable");
-            }
-            if (SR_ERR_OK != rc) {
-                goto cleanup;
-            }
-        } while (d_idx > 0);
+    md_ctx_unlock(dm_ctx->md_ctx);
 
-        if (diff->type[0] == LYD_DIFF_END) {
-            SR_LOG_DBG("No changes in module %s", prev_info->schema->module->name);
-            rc = SR_ERR_OK;
-            goto cleanup;
-        }
+cleanup:
+    if (SR_ERR_OK == rc) {
+        *implicitly_removed_p = implicitly_removed;
+    } else {
+        md_free_module_key_list(implicitly_removed);
     }
+    return rc;
+}
 
-    /* Iterate over all changes. Some changes may include whole subtrees. */
-    for (d_idx = 0; LYD_DIFF_END != diff->type[d_idx]; d_idx++) {
-        /* get node, access_type */
-        switch (diff->type[d_idx]) {
-        case LYD_DIFF_CHANGED:
-        case LYD_DIFF_MOVEDAFTER1:
-            rc = dm_commit_nacm_single_node(session, nacm_data_val_ctx, diff->first[d_idx],
-                    NACM_ACCESS_UPDATE, &denied, errors, err_cnt);
-            denied_cnt += denied;
-            break;
-        case LYD_DIFF_DELETED:
-            rc = dm_commit_nacm_subtree(session, nacm_data_val_ctx, diff->first[d_idx],
-                    NACM_ACCESS_DELETE, &denied_cnt, errors, err_cnt);
-            break;
-        case LYD_DIFF_CREATED:
-            rc = dm_commit_nacm_subtree(session, nacm_data_val_ctx, diff->second[d_idx],
-                    NACM_ACCESS_CREATE, &denied_cnt, errors, err_cnt);
-            break;
-        case LYD_DIFF_MOVEDAFTER2:
-            continue; /* access control performed already for LYD_DIFF_CREATED of this node */
-            break;
-        default:
-            assert(0 && "not reachable");
-        }
-        if (SR_ERR_OK != rc) {
-            goto cleanup;
-        }
-    }
+/**
+ * @brief Initializes the commit context structure for the purposes of sending
+ * SR_EV_ENABLED notification.
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_prepare_c_ctx_for_enable_notification(dm_ctx_t *dm_ctx, dm_commit_context_t **commit_context)
+{
+    CHECK_NULL_ARG(commit_context);
+
+    int rc = SR_ERR_OK;
+    dm_commit_context_t *c_ctx = calloc(1, sizeof(*c_ctx));
+    CHECK_NULL_NOMEM_RETURN(c_ctx);
+
+    rc = dm_create_commit_ctx_id(dm_ctx, c_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit context id generating failed");
+
+    pthread_mutex_init(&c_ctx->mutex, NULL);
+
+    rc = sr_btree_init(dm_module_subscription_cmp, dm_model_subscription_free, &c_ctx->subscriptions);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+
+    rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &c_ctx->prev_data_trees);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+
+    c_ctx->state = DM_COMMIT_FINISHED;
+
+    *commit_context = c_ctx;
+    return rc;
 
 cleanup:
-    if (SR_ERR_OK == rc && denied_cnt > 0) {
-        rc = SR_ERR_UNAUTHORIZED;
-        /* update NACM stats */
-        (void)nacm_stats_add_denied_data_write(nacm_ctx);
-    }
-    if (!saved_diff && NULL != diff) {
-        lyd_free_diff(diff);
-    }
-    dm_module_difflist_free(module_difflist);
-    nacm_data_validation_stop(nacm_data_val_ctx);
+    dm_free_commit_context(c_ctx);
     return rc;
 }
-
-int
-dm_commit_netconf_access_control(nacm_ctx_t *nacm_ctx, dm_session_t *session, dm_commit_context_t *c_ctx, bool copy_config,
-                                 sr_error_info_t **errors, size_t *err_cnt)
+/**
+ * @brief Removes diff entries that does not match an xpath.
+ * @param [in] ms
+ * @param [in] subscription
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_remove_non_matching_diff(dm_model_subscription_t *ms, const np_subscription_t *subscription)
 {
-    CHECK_NULL_ARG3(nacm_ctx, session, c_ctx);
+    CHECK_NULL_ARG2(ms, subscription);
     int rc = SR_ERR_OK;
-    size_t i = 0;
-    dm_data_info_t *info = NULL, *new_info = NULL, *prev_info = NULL, lookup_info = {0};
-
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        lookup_info.schema = info->schema;
-        if (!info->modified) {
-            continue;
-        }
+    struct ly_set *set = NULL;
 
-        /* configuration before commit */
-        prev_info = sr_btree_search(c_ctx->prev_data_trees, &lookup_info);
-        if (NULL == prev_info) {
-            SR_LOG_ERR("Current data tree for module %s not found", info->schema->module->name);
+    if (NULL != subscription->xpath) {
+        rc = sr_find_schema_node(ms->schema_info->module, NULL, subscription->xpath, 0, &set);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR("Schema node not found for xpath %s", subscription->xpath);
             return SR_ERR_INTERNAL;
         }
 
-        /* configuration after commit */
-        new_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], &lookup_info);
-        if (NULL == new_info) {
-            SR_LOG_ERR("Commit data tree for module %s not found", info->schema->module->name);
-            return SR_ERR_INTERNAL;
-        }
+        const struct lys_node *sub_node = set->set.s[0];
+        ly_set_free(set);
+        int diff_count = 0;
+        while (LYD_DIFF_END != ms->difflist->type[diff_count++]);
 
-        rc = dm_remove_added_data_trees(c_ctx->session, new_info);
-        CHECK_RC_MSG_RETURN(rc, "Removing of added data trees failed");
+        for (int i = diff_count - 2; i >= 0; i--) {
+            bool match = false;
+            const struct lyd_node *cmp_node = dm_get_notification_match_node(ms->difflist, i);
+            rc = dm_match_subscription(sub_node, cmp_node, &match);
+            CHECK_RC_MSG_RETURN(rc, "Subscription match failed");
 
-        rc = dm_perform_netconf_access_control(nacm_ctx, session, prev_info, new_info, copy_config, errors, err_cnt, c_ctx);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR_MSG("NACM access check failed");
-            return rc;
+            if (!match) {
+                memmove(&ms->difflist->type[i],
+                        &ms->difflist->type[i + 1],
+                        (diff_count - i - 1) * sizeof(*ms->difflist->type));
+                /* there is no items for LYD_DIFF_END in first and second arrays,
+                 * these arrays are shorter thats why there is -2 instead of -1 */
+                memmove(&ms->difflist->first[i],
+                        &ms->difflist->first[i + 1],
+                        (diff_count - i - 2) * sizeof(*ms->difflist->first));
+                memmove(&ms->difflist->second[i],
+                        &ms->difflist->second[i + 1],
+                        (diff_count - i - 2) * sizeof(*ms->difflist->second));
+                diff_count--;
+            }
         }
     }
 
@@ -5015,1255 +7937,1451 @@ dm_commit_netconf_access_control(nacm_ctx_t *nacm_ctx, dm_session_t *session, dm
 }
 
 /**
- * @brief Decides whether a subscription should be skipped or not. Takes into account:
- * SR_EV_VERIFY: skip SR_SUBSCR_APPLY_ONLY subscription
- * SR_EV_ABORT: skip subscription that returned an error and specified SR_SUBSCR_NO_ABORT_FOR_REFUSED_CFG flag
+ * @brief Fills dm_model_subscription_t structure for the purposes of browsing changes
+ * after SR_EV_ENABLED is sent.
+ *
+ * @param [in] dm_ctx
+ * @param [in] user_credentials
+ * @param [in] src_session
+ * @param [in] module_name
+ * @param [in] subscription
+ * @param [in] c_ctx
+ * @return Error code (SR_ERR_OK on success).
  */
-static bool
-dm_should_skip_subscription(np_subscription_t *subscription, dm_commit_context_t *c_ctx, sr_notif_event_t ev)
+static int
+dm_create_difflist_for_enabled_notif(dm_ctx_t *dm_ctx, const ac_ucred_t *user_credentials, dm_session_t *src_session,
+        const char *module_name, const np_subscription_t *subscription, dm_commit_context_t *c_ctx)
 {
-    if (NULL == subscription || NULL == c_ctx) {
-        return false;
+
+    CHECK_NULL_ARG5(dm_ctx, src_session, module_name, subscription, c_ctx);
+
+    int rc = SR_ERR_OK;
+    dm_model_subscription_t *ms = NULL;
+
+    rc = dm_session_start(dm_ctx, user_credentials, SR_DS_RUNNING, &c_ctx->session);
+    CHECK_RC_MSG_RETURN(rc, "Start session failed");
+
+    rc = dm_copy_session_tree(dm_ctx, src_session, c_ctx->session, module_name);
+    CHECK_RC_MSG_RETURN(rc, "Data tree copy failed");
+
+    /* there is only one data tree in session */
+    dm_data_info_t *copied_di = (dm_data_info_t *) sr_btree_get_at(c_ctx->session->session_modules[SR_DS_RUNNING], 0);
+    if (NULL == copied_di) {
+        SR_LOG_ERR("Data tree for module %s not found", module_name);
+        return SR_ERR_INTERNAL;
     }
 
-    if (SR_EV_VERIFY == ev || SR_EV_ABORT == ev) {
-        if (SR__NOTIFICATION_EVENT__VERIFY_EV != subscription->notif_event) {
-            return true;
-        }
+    ms = calloc(1, sizeof(*ms));
+    CHECK_NULL_NOMEM_RETURN(ms);
+
+    ms->schema_info = copied_di->schema;
+
+    ms->difflist = lyd_diff(NULL, copied_di->node, LYD_DIFFOPT_WITHDEFAULTS);
+    if (NULL == ms->difflist) {
+        SR_LOG_ERR_MSG("Error while generating diff");
+        rc = SR_ERR_INTERNAL;
+        goto cleanup;
     }
 
-    /* if subscription returned an error don't send him abort */
-    if (SR_EV_ABORT == ev && c_ctx->err_subs_xpaths != NULL) {
-        for (size_t e = 0; e < c_ctx->err_subs_xpaths->count; e++) {
-            if (0 == strcmp((char *) c_ctx->err_subs_xpaths->data[e],
-                    NULL == subscription->xpath ?
-                    subscription->module_name :
-                    subscription->xpath)) {
-                return true;
-            }
-        }
+    rc = dm_remove_non_matching_diff(ms, subscription);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Dm remove non match diff failed");
+        goto cleanup;
     }
 
-    return false;
+    rc = sr_btree_insert(c_ctx->subscriptions, ms);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert model subscription structure");
+    return rc;
+
+cleanup:
+    dm_model_subscription_free(ms);
+    return rc;
 }
 
-int
-dm_commit_notify(dm_ctx_t *dm_ctx, dm_session_t *session, sr_notif_event_t ev, dm_commit_context_t *c_ctx)
+/**
+ * @brief Sends enabled notification.
+ *
+ * @param [in] dm_ctx
+ * @param [in] c_ctx - do not use after return from the function
+ * @param [in] subscription
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+dm_send_enabled_notification(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx, const np_subscription_t *subscription)
 {
-    CHECK_NULL_ARG3(dm_ctx, session, c_ctx);
     int rc = SR_ERR_OK;
-    size_t i = 0;
-    dm_data_info_t *info = NULL, *commit_info = NULL, *prev_info = NULL, lookup_info = {0};
-    dm_model_subscription_t *ms = NULL;
-    bool match = false;
-    sr_list_t *notified_notif = NULL;
-    dm_module_difflist_t *module_difflist = NULL, lookup_difflist = {0};
-
-    c_ctx->should_be_removed = false;
+    sr_list_t *notif_list = NULL;
 
-    /* notification are sent only when running or candidate is committed*/
-    if (SR_DS_STARTUP == session->datastore) {
-        c_ctx->state = DM_COMMIT_WRITE;
-        return SR_ERR_OK;
+    CHECK_NULL_ARG_NORET3(rc, dm_ctx, c_ctx, subscription);
+    if (SR_ERR_OK != rc) {
+        goto cleanup;
     }
 
-    rc = sr_list_init(&notified_notif);
-    CHECK_RC_MSG_RETURN(rc, "List init failed");
-
-    SR_LOG_DBG("Sending %s notifications about the changes made in running datastore...", sr_notification_event_sr_to_str(ev));
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        if (!info->modified) {
-            continue;
-        }
-        size_t d_cnt = 0;
-        dm_model_subscription_t lookup = {0};
-        struct lyd_difflist *diff = NULL;
-
-        lookup.schema_info = info->schema;
-
-        ms = sr_btree_search(c_ctx->subscriptions, &lookup);
-        if (NULL == ms) {
-            SR_LOG_WRN("No subscription found for %s", info->schema->module->name);
-            lyd_free_diff(diff);
-            continue;
-        }
+    rc = dm_insert_commit_context(dm_ctx, c_ctx);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert commit context");
 
-        /* changes are generated only for SR_EV_VERIFY and SR_EV_ABORT */
-        if (SR_EV_VERIFY == ev || SR_EV_ABORT == ev) {
-            lookup_info.schema = info->schema;
-            /* configuration before commit */
-            prev_info = sr_btree_search(c_ctx->prev_data_trees, &lookup_info);
-            if (NULL == prev_info) {
-                SR_LOG_ERR("Current data tree for module %s not found", info->schema->module->name);
-                continue;
-            }
-            /* configuration after commit */
-            commit_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], &lookup_info);
-            if (NULL == commit_info) {
-                SR_LOG_ERR("Commit data tree for module %s not found", info->schema->module->name);
-                continue;
-            }
+    uint32_t commit_id = c_ctx->id;
+    /* do not free commit context in cleanup */
+    c_ctx = NULL;
 
-            /* for SR_EV_ABORT inverse changes are generated */
-            if (SR_EV_VERIFY == ev) {
-                if (NULL != dm_ctx->nacm_ctx && (c_ctx->init_session->options & SR_SESS_ENABLE_NACM)) {
-                    /* already obtained in the NACM phase */
-                    lookup_difflist.schema_info = info->schema;
-                    module_difflist = sr_btree_search(c_ctx->difflists, &lookup_difflist);
-                    if (NULL == module_difflist || NULL == module_difflist->difflist) {
-                        SR_LOG_ERR("Diff-list for module %s not found", info->schema->module->name);
-                        continue;
-                    }
-                    diff = module_difflist->difflist;
-                    module_difflist->difflist = NULL; /* remove diff from the binary tree */
-                } else {
-                    diff = lyd_diff(prev_info->node, commit_info->node, LYD_DIFFOPT_WITHDEFAULTS);
-                }
-            } else {
-                diff = lyd_diff(commit_info->node, prev_info->node, LYD_DIFFOPT_WITHDEFAULTS);
-            }
-            if (NULL == diff) {
-                SR_LOG_ERR("Lyd diff failed for module %s", info->schema->module->name);
-                continue;
-            }
+    rc = sr_list_init(&notif_list);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
 
-            if (diff->type[d_cnt] == LYD_DIFF_END) {
-                SR_LOG_DBG("No changes in module %s", info->schema->module->name);
-                lyd_free_diff(diff);
-                continue;
-            }
+    rc = sr_list_add(notif_list, (void *) subscription);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "List insert failed");
 
-            /* remove changes generated during verify phase */
-            if (NULL != ms->changes) {
-                for (int i = 0; i < ms->changes->count; i++) {
-                    sr_free_changes(ms->changes->data[i], 1);
-                }
-                sr_list_cleanup(ms->changes);
-            }
-            ms->changes = NULL;
+    rc = np_subscription_notify(dm_ctx->np_ctx, (np_subscription_t *) subscription, SR_EV_ENABLED, commit_id);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Sending of SR_EV_ENABLED notification failed");
 
-            lyd_free_diff(ms->difflist);
-            ms->changes_generated = false;
-            /* store differences in commit context */
-            ms->difflist = diff;
-        }
+    rc = np_commit_notifications_sent(dm_ctx->np_ctx, commit_id, true, notif_list);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Notification sent failed");
 
-        /* Log changes */
-        if (NULL != diff && (SR_LL_DBG == sr_ll_stderr || SR_LL_DBG == sr_ll_syslog)) {
-            while (LYD_DIFF_END != diff->type[d_cnt]) {
-                char *path = dm_get_notification_changed_xpath(diff, d_cnt);
-                SR_LOG_DBG("%s: %s", dm_get_diff_type_to_string(diff->type[d_cnt]), path);
-                free(path);
-                d_cnt++;
-            }
-        }
+cleanup:
+    if (SR_ERR_OK != rc) {
+        dm_free_commit_context(c_ctx);
     }
+    sr_list_cleanup(notif_list);
+    return rc;
+}
 
-    if (SR_EV_VERIFY == ev) {
-        rc = dm_save_commit_context(dm_ctx, c_ctx);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR_MSG("Saving of commit context failed");
-        }
-    } else {
-        /* apply abort */
-        dm_release_resources_commit_context(dm_ctx, c_ctx);
-        rc = dm_save_commit_context(dm_ctx, c_ctx);
-        /* if there is a verify subscription commit context is already saved */
-        if (SR_ERR_DATA_EXISTS == rc) {
-            rc = SR_ERR_OK;
-        }
+/**
+ * @brief Loads data trees of the listed modules into the session (if not loaded yet), parsing the data files
+ * of independent modules in parallel. Data of modules with cross-module dependencies or instance identifiers
+ * are not loaded here, they need to be validated against the other modules and are left to ::dm_get_data_info.
+ */
+static int
+dm_preload_data_infos(dm_ctx_t *dm_ctx, dm_session_t *session, const sr_list_t *module_names)
+{
+    CHECK_NULL_ARG3(dm_ctx, session, module_names);
+    dm_load_job_t *jobs = NULL;
+    size_t job_cnt = 0;
+    dm_schema_info_t *schema_info = NULL;
+    dm_data_info_t lookup = {0};
+    char *file_name = NULL;
+    int fd = -1;
+    int rc = SR_ERR_OK;
+
+    if (SR_DS_CANDIDATE == session->datastore || 2 > module_names->count || 2 > dm_ctx->data_load_threads) {
+        /* nothing to be gained */
+        return SR_ERR_OK;
     }
 
-    i = 0;
-    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
-        if (!info->modified) {
-            continue;
-        }
-        size_t d_cnt = 0;
-        dm_model_subscription_t lookup = {0};
+    jobs = calloc(module_names->count, sizeof(*jobs));
+    CHECK_NULL_NOMEM_RETURN(jobs);
 
-        lookup.schema_info = info->schema;
+    for (size_t i = 0; i < module_names->count; ++i) {
+        rc = dm_get_module_and_lock(dm_ctx, (char *) module_names->data[i], &schema_info);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Get module '%s' failed", (char *) module_names->data[i]);
 
-        ms = sr_btree_search(c_ctx->subscriptions, &lookup);
-        if (NULL == ms) {
-            SR_LOG_WRN("No subscription found for %s", info->schema->module->name);
-            continue;
-        }
-        if (NULL == ms->difflist) {
+        lookup.schema = schema_info;
+        if (schema_info->cross_module_data_dependency || schema_info->has_instance_id ||
+                NULL != sr_btree_search(session->session_modules[session->datastore], &lookup)) {
+            pthread_rwlock_unlock(&schema_info->model_lock);
             continue;
         }
 
-        /* loop through subscription test if they should be notified */
-        if (NULL != ms->subscriptions) {
-            for (size_t s = 0; s < ms->subscriptions->count; s++) {
-                np_subscription_t *sub = ms->subscriptions->data[s];
-                if (dm_should_skip_subscription(sub, c_ctx, ev)) {
-                    continue;
-                }
-
-                for (d_cnt = 0; LYD_DIFF_END != ms->difflist->type[d_cnt]; d_cnt++) {
-                    if ((ms->difflist->type[d_cnt] == LYD_DIFF_CHANGED)
-                            && ((ms->difflist->first[d_cnt]->schema->nodetype == LYS_LEAF)
-                            || (ms->difflist->first[d_cnt]->schema->nodetype == LYS_LEAFLIST))
-                            && !strcmp(((struct lyd_node_leaf_list *)ms->difflist->first[d_cnt])->value_str,
-                                       ((struct lyd_node_leaf_list *)ms->difflist->second[d_cnt])->value_str)) {
-                        /* skip implicit default changed to explicit or vice versa */
-                        if (((struct lyd_node_leaf_list *)ms->difflist->first[d_cnt])->dflt
-                                == ((struct lyd_node_leaf_list *)ms->difflist->second[d_cnt])->dflt) {
-                            SR_LOG_ERR_MSG("Invalid lyd_diff() return value");
-                            continue;
-                        }
-                        continue;
-                    }
+        rc = sr_get_data_file_name(dm_ctx->data_search_dir, schema_info->module->name, session->datastore, &file_name);
+        if (SR_ERR_OK != rc) {
+            pthread_rwlock_unlock(&schema_info->model_lock);
+            SR_LOG_ERR("Get data_filename failed for %s", schema_info->module->name);
+            goto cleanup;
+        }
 
-                    const struct lyd_node *cmp_node = dm_get_notification_match_node(ms->difflist, d_cnt);
-                    rc = dm_match_subscription(ms->nodes[s], cmp_node, &match);
-                    if (SR_ERR_OK != rc) {
-                        SR_LOG_WRN_MSG("Subscription match failed");
-                        continue;
-                    }
-                    if (match) {
-                        break;
-                    }
-                }
+        ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+        fd = open(file_name, O_RDWR);
+        ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
 
-                if (match) {
-                    /* something has been changed for this subscription, send notification */
-                    rc = np_subscription_notify(dm_ctx->np_ctx, sub, ev, c_ctx->id);
-                    if (SR_ERR_OK != rc) {
-                       SR_LOG_WRN("Unable to send notifications about the changes for the subscription in module %s xpath %s.",
-                               sub->module_name,
-                               sub->xpath);
-                    }
-                    rc = sr_list_add(notified_notif, sub);
-                    if (SR_ERR_OK != rc) {
-                       SR_LOG_WRN_MSG("List add failed");
-                    }
-                }
-            }
+        if (-1 != fd) {
+            /* lock, read-only, blocking */
+            sr_lock_fd(fd, false, true);
+        } else if (ENOENT != errno) {
+            /* let the error be reported when the data are requested */
+            pthread_rwlock_unlock(&schema_info->model_lock);
+            free(file_name);
+            file_name = NULL;
+            continue;
         }
+
+        jobs[job_cnt].fd = fd;
+        jobs[job_cnt].file_name = file_name;
+        jobs[job_cnt].schema_info = schema_info;
+        ++job_cnt;
+        file_name = NULL;
     }
 
-    if (SR_EV_VERIFY == ev ){
-        if (notified_notif->count > 0) {
-            c_ctx->state = DM_COMMIT_WAIT_FOR_NOTIFICATIONS;
-        } else {
-            c_ctx->state = DM_COMMIT_WRITE;
+    rc = dm_load_data_tree_files(dm_ctx, jobs, job_cnt);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Loading of data files failed");
+
+    for (size_t i = 0; i < job_cnt; ++i) {
+        rc = sr_btree_insert(session->session_modules[session->datastore], (void *) jobs[i].data_info);
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR("Insert into session avl failed module %s", jobs[i].schema_info->module_name);
+            goto cleanup;
         }
-    } else {
-        c_ctx->state = DM_COMMIT_FINISHED;
+        jobs[i].data_info = NULL;
     }
 
-    /* let the np know that the commit has finished */
-    if (SR_ERR_OK == rc && notified_notif->count > 0) {
-        c_ctx->should_be_removed = false;
-        rc = np_commit_notifications_sent(dm_ctx->np_ctx, c_ctx->id, SR_EV_VERIFY != ev, notified_notif);
-    } else {
-        c_ctx->should_be_removed = true;
+cleanup:
+    for (size_t i = 0; i < job_cnt; ++i) {
+        if (-1 != jobs[i].fd) {
+            sr_unlock_fd(jobs[i].fd);
+            close(jobs[i].fd);
+        }
+        dm_data_info_free(jobs[i].data_info);
+        free((char *) jobs[i].file_name);
+        pthread_rwlock_unlock(&jobs[i].schema_info->model_lock);
     }
-
-    sr_list_cleanup(notified_notif);
+    free(jobs);
     return rc;
 }
 
-int
-dm_feature_enable(dm_ctx_t *dm_ctx, const char *module_name, const char *feature_name, bool enable)
+static int
+dm_copy_config(dm_ctx_t *dm_ctx, dm_session_t *session, const sr_list_t *module_names, sr_datastore_t src,
+               sr_datastore_t dst, const np_subscription_t *subscription, bool nacm_on, sr_error_info_t **errors, size_t *err_cnt)
 {
-    CHECK_NULL_ARG3(dm_ctx, module_name, feature_name);
+    CHECK_NULL_ARG2(dm_ctx, module_names);
     int rc = SR_ERR_OK;
-    dm_schema_info_t *schema_info = NULL;
-    md_module_t *module = NULL;
-    md_dep_t *dep = NULL;
-    sr_llist_node_t *ll_node = NULL;
-    dm_schema_info_t *si = NULL;
-    dm_schema_info_t lookup = {0};
-
-    rc = dm_get_module_and_lockw(dm_ctx, module_name, &schema_info);
-    CHECK_RC_LOG_RETURN(rc, "dm_get_module %s and lock failed", module_name);
-
-    rc = dm_feature_enable_internal(dm_ctx, schema_info, module_name, feature_name, enable);
-    pthread_rwlock_unlock(&schema_info->model_lock);
-    CHECK_RC_LOG_RETURN(rc, "Failed to %s feature '%s' in module '%s'.", enable ? "enable" : "disable", feature_name, module_name);
-
-    /* apply the change in all loaded schema infos */
-    md_ctx_lock(dm_ctx->md_ctx, true);
-    pthread_rwlock_wrlock(&dm_ctx->schema_tree_lock);
-    rc = md_get_module_info(dm_ctx->md_ctx, module_name, NULL, NULL, &module);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module %s info failed", module_name);
+    dm_session_t *src_session = NULL;
+    dm_session_t *dst_session = NULL;
+    char *module_name = NULL;
+    dm_data_info_t **src_infos = NULL, *dst_info = NULL;
+    size_t opened_files = 0;
+    char *file_name = NULL;
+    int *fds = NULL;
+    dm_commit_context_t *c_ctx = NULL;
+    sr_datastore_t prev_ds = 0;
 
-    /* enable feature in all modules augmented by this module */
-    ll_node = module->inv_deps->first;
-    while (ll_node) {
-        dep = (md_dep_t *) ll_node->data;
-        if (dep->type == MD_DEP_EXTENSION && dep->dest->implemented) {
-            lookup.module_name = (char *) dep->dest->name;
-            si = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
-            if (NULL != si && NULL != si->ly_ctx) {
-                rc = dm_lock_schema_info_write(si);
-                CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to lock schema info %s", si->module_name);
+    if (src == dst || 0 == module_names->count) {
+        return rc;
+    }
 
-                rc = dm_feature_enable_internal(dm_ctx, si, module_name, feature_name, enable);
-                pthread_rwlock_unlock(&si->model_lock);
-                CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to load schema %s", module->filepath);
-            }
+    if (SR_DS_RUNNING == src && SR_DS_CANDIDATE == dst && NULL != session && !(NULL != dm_ctx->nacm_ctx && nacm_on)) {
+        /* candidate keeps only the modules modified against running, the others are loaded
+         * from running on demand - dropping the session copies resets the candidate */
+        for (size_t i = 0; i < module_names->count; i++) {
+            rc = dm_discard_changes(dm_ctx, session, module_names->data[i]);
+            CHECK_RC_LOG_RETURN(rc, "Discard of candidate changes failed %s", (char *) module_names->data[i]);
         }
-        ll_node = ll_node->next;
+        return dm_remove_session_operations(session);
     }
 
-cleanup:
-    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
-    md_ctx_unlock(dm_ctx->md_ctx);
+    if (NULL != subscription) {
+        if (SR_DS_RUNNING != dst) {
+            SR_LOG_ERR_MSG("Notification cannot be sent for datastore different from running");
+            return SR_ERR_INVAL_ARG;
+        }
+        rc = dm_prepare_c_ctx_for_enable_notification(dm_ctx, &c_ctx);
+        CHECK_RC_MSG_RETURN(rc, "Preparing of commit context failed");
+    }
 
-    return rc;
-}
+    src_infos = calloc(module_names->count, sizeof(*src_infos));
+    CHECK_NULL_NOMEM_GOTO(src_infos, rc, cleanup);
+    fds = calloc(module_names->count, sizeof(*fds));
+    CHECK_NULL_NOMEM_GOTO(fds, rc, cleanup);
 
-int
-dm_install_module(dm_ctx_t *dm_ctx, dm_session_t *session, const char *module_name,
-        const char *revision, const char *file_name, sr_list_t **implicitly_installed_p)
-{
-    CHECK_NULL_ARG5(dm_ctx, session, module_name, file_name, implicitly_installed_p); /* revision can be NULL */
+    /* create source session */
+    if (SR_DS_CANDIDATE != src) {
+        rc = dm_session_start(dm_ctx, (session != NULL ? session->user_credentials : NULL), src, &src_session);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Creating of temporary session failed");
 
-    int rc = 0;
-    md_module_t *module = NULL;
-    md_dep_t *dep = NULL;
-    sr_llist_node_t *ll_node = NULL;
-    dm_schema_info_t *si = NULL, *si_ext = NULL;
-    dm_schema_info_t lookup = {0};
-    sr_list_t *implicitly_installed = NULL;
+        /* parse the source data files at once */
+        rc = dm_preload_data_infos(dm_ctx, src_session, module_names);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Loading of source data failed");
+    } else {
+        src_session = session;
+        sr_error_info_t *errors = NULL;
+        size_t e_cnt = 0;
+        rc = dm_validate_session_data_trees(dm_ctx, session, &errors, &e_cnt);
+        if (SR_ERR_OK != rc) {
+            if (NULL != errors) {
+                rc = dm_report_error(session, errors[0].message, errors[0].xpath, SR_ERR_VALIDATION_FAILED);
+                sr_free_errors(errors, e_cnt);
+            }
+            SR_LOG_ERR_MSG("There is a invalid data tree, can not be copied");
+            goto cleanup;
+        }
+    }
 
-    /* insert module into the dependency graph */
-    md_ctx_lock(dm_ctx->md_ctx, true);
-    pthread_rwlock_wrlock(&dm_ctx->schema_tree_lock);
+    /* create destination session */
+    if (SR_DS_CANDIDATE != dst) {
+        rc = dm_session_start(dm_ctx, (session != NULL ? session->user_credentials : NULL), dst, &dst_session);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Creating of temporary session failed");
+    } else {
+        dst_session = session;
+    }
 
-    rc = md_insert_module(dm_ctx->md_ctx, file_name, &implicitly_installed);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert module into the dependency graph");
+    for (size_t i = 0; i < module_names->count; i++) {
+        module_name = module_names->data[i];
 
-    rc = md_get_module_info(dm_ctx->md_ctx, module_name, revision, NULL, &module);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Get module %s info failed", module_name);
+        /* lock module in destination */
+        if (SR_DS_CANDIDATE != dst) {
+            rc = dm_lock_module(dm_ctx, dst_session, (char *) module_name);
+            if (SR_ERR_LOCKED == rc && NULL != session) {
+                prev_ds = session->datastore;
+                if (dst != session->datastore) {
+                    /* temporary switch DS to check locks */
+                    prev_ds = session->datastore;
+                    dm_session_switch_ds(session, dst);
+                }
+                /* check if the lock is hold by session that issued copy-config */
+                rc = dm_lock_module(dm_ctx, session, (char *) module_name);
 
-    lookup.module_name = (char *) module_name;
-    si = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
-    if (NULL != si) {
-        RWLOCK_WRLOCK_TIMED_CHECK_GOTO(&si->model_lock, rc, cleanup);
-        if (NULL != si->ly_ctx) {
-            SR_LOG_WRN("Module %s already loaded", si->module_name);
-            goto unlock;
+                if (prev_ds != session->datastore) {
+                    dm_session_switch_ds(session, prev_ds);
+                }
+            }
+            if (rc != SR_ERR_OK) {
+                SR_LOG_WRN("Module %s can not be locked in destination datastore", module_name);
+                goto cleanup;
+            }
         }
-        /* load module and its dependencies into si */
-        si->ly_ctx = ly_ctx_new(dm_ctx->schema_search_dir, LY_CTX_NOYANGLIBRARY);
-        CHECK_NULL_NOMEM_GOTO(si->ly_ctx, rc, unlock);
 
-        rc = dm_load_schema_file(module->filepath, si, NULL);
-        CHECK_RC_LOG_GOTO(rc, unlock, "Failed to load schema %s", module->filepath);
+        /* load data tree to be copied */
+        rc = dm_get_data_info(dm_ctx, src_session, module_name, &(src_infos[i]));
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Get data info failed");
 
-        si->module = ly_ctx_get_module(si->ly_ctx, module_name, NULL, 1);
-        if (NULL == si->module){
-            rc = SR_ERR_INTERNAL;
-            goto unlock;
+        if (NULL != session && NULL != dm_ctx->nacm_ctx && nacm_on) {
+            /* load data tree to be replaced */
+            rc = dm_get_data_info(dm_ctx, session, module_name, &dst_info);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data info failed");
+
+            rc = dm_perform_netconf_access_control(dm_ctx->nacm_ctx, session, dst_info, src_infos[i], true, errors, err_cnt, NULL);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Checking NACM failed");
         }
 
-        ll_node = module->deps->first;
-        while (ll_node) {
-            dep = (md_dep_t *)ll_node->data;
-            if (dep->type == MD_DEP_DATA) {
-                /* mark this module as dependent on data from other modules */
-                si->cross_module_data_dependency = true;
-                break;
-            }
-            ll_node = ll_node->next;
+        if (NULL != subscription && 0 == i) {
+            /* subscription is supposed to be used when only one module/subtree is copied */
+            rc = dm_create_difflist_for_enabled_notif(dm_ctx, session->user_credentials, src_session, module_name, subscription, c_ctx);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create difflist");
         }
 
-        /* compute xpath hashes for all schema nodes (referenced from data tree) */
-        rc = dm_init_missing_node_priv_data(si);
-        CHECK_RC_LOG_GOTO(rc, unlock, "Failed to initialize private data for module %s", module->name);
+        if (SR_DS_CANDIDATE != dst) {
+            /* create data file name */
+            rc = sr_get_data_file_name(dm_ctx->data_search_dir, module_name, dst_session->datastore, &file_name);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data file name failed");
 
-        if (dm_module_has_persist(module)) {
-            rc = dm_apply_persist_data_for_model(dm_ctx, session, module->name, si, false);
-            CHECK_RC_LOG_GOTO(rc, unlock, "Failed to apply persist data for %s", module->name);
+            if (NULL != session) {
+                ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+            }
+            fds[opened_files] = open(file_name, O_RDWR);
+            if (NULL != session) {
+                ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
+            }
+            if (-1 == fds[opened_files]) {
+                SR_LOG_ERR("File %s can not be opened", file_name);
+                free(file_name);
+                goto cleanup;
+            }
+            /* lock, write, blocking */
+            sr_lock_fd(fds[opened_files], true, true);
+            if (ftruncate(fds[opened_files], 0) != 0) {
+                SR_LOG_ERR("File %s can not be truncated: %s", file_name, sr_strerror_safe(errno));
+                free(file_name);
+                opened_files++;
+                goto cleanup;
+            }
+            opened_files++;
+            free(file_name);
         }
+    }
 
-        /* distinguish between modules that can and cannot be locked */
-        si->can_not_be_locked = !module->has_data;
-unlock:
-        if (si) {
-            pthread_rwlock_unlock(&si->model_lock);
+    int ret = 0;
+    for (size_t i = 0; i < module_names->count; i++) {
+        module_name = module_names->data[i];
+        if (SR_DS_CANDIDATE != dst) {
+            /* write dest file, dst is either startup or running */
+            if (0 != lyd_print_fd(fds[i], src_infos[i]->node, SR_FILE_FORMAT_LY, LYP_WITHSIBLINGS | LYP_FORMAT)) {
+                SR_LOG_ERR("Copy of module %s failed", module_name);
+                rc = SR_ERR_INTERNAL;
+            }
+            ret = fsync(fds[i]);
+            if (0 != ret) {
+                SR_LOG_ERR("Failed to write data of '%s' module: %s", src_infos[i]->schema->module->name,
+                        (ly_errno != LY_SUCCESS) ? ly_errmsg(src_infos[i]->node->schema->module->ctx) : sr_strerror_safe(errno));
+                rc = SR_ERR_INTERNAL;
+            }
+        } else {
+            /* copy data tree into candidate session */
+            struct lyd_node *dup = sr_dup_datatree(src_infos[i]->node);
+            dm_data_info_t *di_tmp = NULL;
+            if (NULL != src_infos[i]->node && NULL == dup) {
+                SR_LOG_ERR("Duplication of data tree %s failed", src_infos[i]->schema->module->name);
+                rc = SR_ERR_INTERNAL;
+                goto cleanup;
+            }
+            /* load data tree to be copied*/
+            rc = dm_get_data_info(dm_ctx, dst_session, module_name, &di_tmp);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data info failed");
+            lyd_free_withsiblings(di_tmp->node);
+            di_tmp->node = dup;
+            di_tmp->modified = true;
         }
-    } else {
-        /* module is installed for the first time, will be loaded when a request
-         * into this module is received */
-        SR_LOG_DBG("Module %s will be loaded when a request for it comes", module_name);
     }
 
-    /* load this module also into contexts of newly augmented modules */
-    ll_node = module->inv_deps->first;
-    while (ll_node) {
-        dep = (md_dep_t *)ll_node->data;
-        if (dep->type == MD_DEP_EXTENSION && dep->dest->implemented) {
-            lookup.module_name = (char *)dep->dest->name;
-            si_ext = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
-            if (NULL != si_ext && NULL != si_ext->ly_ctx) {
-                rc = dm_load_schema_file(module->filepath, si_ext, NULL);
-                CHECK_RC_LOG_GOTO(rc, unlock, "Failed to load schema %s", module->filepath);
+    if (SR_DS_CANDIDATE == dst) {
+        dm_remove_session_operations(dst_session);
+    }
 
-                /* compute xpath hashes for all newly added schema nodes (through augment) */
-                rc = dm_init_missing_node_priv_data(si_ext);
-                CHECK_RC_LOG_GOTO(rc, unlock, "Failed to initialize private data for module %s", dep->dest->name);
+    if (NULL != subscription) {
+        rc = dm_send_enabled_notification(dm_ctx, c_ctx, subscription);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Sending of enable notification failed");
 
-                if (dm_module_has_persist(module)) {
-                    rc = dm_apply_persist_data_for_model(dm_ctx, session, module->name, si_ext, false);
-                    CHECK_RC_LOG_GOTO(rc, unlock, "Failed to apply persist data for %s", module->name);
-                }
-            }
-        }
-        ll_node = ll_node->next;
+        /* do not free commit context in cleanup */
+        c_ctx = NULL;
     }
 
 cleanup:
-    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
-    md_ctx_unlock(dm_ctx->md_ctx);
-    if (SR_ERR_OK == rc) {
-        *implicitly_installed_p = implicitly_installed;
-    } else {
-        md_free_module_key_list(implicitly_installed);
+    if (SR_DS_CANDIDATE != src) {
+        dm_session_stop(dm_ctx, src_session);
+    }
+    if (SR_DS_CANDIDATE != dst) {
+        dm_session_stop(dm_ctx, dst_session);
+    }
+    for (size_t i = 0; i < opened_files; i++) {
+        close(fds[i]);
     }
+    free(fds);
+    free(src_infos);
+    dm_free_commit_context(c_ctx);
     return rc;
 }
 
-/**
- * @brief Disables module
- * @param [in] dm_ctx
- * @param [in] module_name
- * @param [in] revision
- * @return Error code (SR_ERR_OK on success)
- */
-static int
-dm_uninstall_module_schema(dm_ctx_t *dm_ctx, const char *module_name, const char *revision)
+int
+dm_has_state_data(dm_ctx_t *ctx, const char *module_name, bool *res)
 {
-    CHECK_NULL_ARG2(dm_ctx, module_name);
+    CHECK_NULL_ARG3(ctx, module_name, res);
+    md_module_t *module = NULL;
     int rc = SR_ERR_OK;
-    dm_schema_info_t lookup = {0};
-    dm_schema_info_t *schema_info = NULL;
-
-    RWLOCK_RDLOCK_TIMED_CHECK_RETURN(&dm_ctx->schema_tree_lock);
-    lookup.module_name = (char *) module_name;
 
-    schema_info = sr_btree_search(dm_ctx->schema_info_tree, &lookup);
-    if (NULL != schema_info) {
-        pthread_rwlock_wrlock(&schema_info->model_lock);
-        if (NULL != schema_info->ly_ctx){
-            pthread_mutex_lock(&schema_info->usage_count_mutex);
-            if (0 != schema_info->usage_count) {
-                rc = SR_ERR_OPERATION_FAILED;
-                SR_LOG_ERR("Module %s can not be uninstalled because it is being used. (referenced by %zu)", module_name, schema_info->usage_count);
-            } else {
-                ly_ctx_destroy(schema_info->ly_ctx, dm_free_lys_private_data);
-                schema_info->ly_ctx = NULL;
-                schema_info->module = NULL;
-                SR_LOG_DBG("Module %s uninstalled", module_name);
-            }
-            pthread_mutex_unlock(&schema_info->usage_count_mutex);
-        }
-        pthread_rwlock_unlock(&schema_info->model_lock);
-    } else {
-        SR_LOG_DBG("Module %s is not loaded, can be uninstalled safely", module_name);
+    md_ctx_lock(ctx->md_ctx, false);
+    rc = md_get_module_info(ctx->md_ctx, module_name, NULL, NULL, &module);
+    if (SR_ERR_OK == rc) {
+        *res = (module->op_data_subtrees->first != NULL);
     }
+    md_ctx_unlock(ctx->md_ctx);
 
-    pthread_rwlock_unlock(&dm_ctx->schema_tree_lock);
-
-    CHECK_RC_LOG_RETURN(rc, "Uninstallation of module %s was not successful", module_name);
     return rc;
 }
 
 int
-dm_uninstall_module(dm_ctx_t *dm_ctx, const char *module_name, const char *revision,
-        sr_list_t **implicitly_removed_p)
+dm_has_enabled_subtree(dm_ctx_t *ctx, const char *module_name, dm_schema_info_t **schema, bool *res)
 {
-    CHECK_NULL_ARG2(dm_ctx, module_name);
+    CHECK_NULL_ARG3(ctx, module_name, res);
     int rc = SR_ERR_OK;
-    md_module_t *module = NULL;
-    md_module_key_t *module_key = NULL;
-    sr_list_t *implicitly_removed = NULL;
-
-    /* uninstall context with module schema */
-    rc = dm_uninstall_module_schema(dm_ctx, module_name, revision);
-    if (SR_ERR_OK != rc) {
-        goto cleanup;
-    }
+    dm_schema_info_t *schema_info = NULL;
+    const struct lys_node *node = NULL;
 
-    md_ctx_lock(dm_ctx->md_ctx, true);
-    rc = md_get_module_info(dm_ctx->md_ctx, module_name, revision, NULL, &module);
+    rc = dm_get_module_and_lock(ctx, module_name, &schema_info);
+    CHECK_RC_MSG_RETURN(rc, "Get module failed");
 
-    /* remove module from the dependency graph */
-    if (NULL == module) {
-        SR_LOG_ERR("Module %s with revision %s was not found", module_name, revision);
-        rc = SR_ERR_NOT_FOUND;
-    } else {
-        rc = md_remove_modules(dm_ctx->md_ctx, &module_name, &revision, 1, &implicitly_removed);
-    }
+    *res = false;
 
-    /* uninstall also modules that were "silently" removed */
-    for (size_t i = 0; rc == SR_ERR_OK && NULL != implicitly_removed && i < implicitly_removed->count; ++i) {
-        module_key = (md_module_key_t *)implicitly_removed->data[i];
-        rc = dm_uninstall_module_schema(dm_ctx, module_key->name, module_key->revision_date);
+    while ((node = lys_getnext(node, NULL, schema_info->module, 0))) {
+        if (dm_is_enabled_check_recursively((struct lys_node *)node)) {
+            *res = true;
+            break;
+        }
     }
 
-    md_ctx_unlock(dm_ctx->md_ctx);
-
-cleanup:
-    if (SR_ERR_OK == rc) {
-        *implicitly_removed_p = implicitly_removed;
-    } else {
-        md_free_module_key_list(implicitly_removed);
+    if (NULL != schema) {
+        *schema = schema_info;
     }
+    pthread_rwlock_unlock(&schema_info->model_lock);
     return rc;
 }
 
-/**
- * @brief Initializes the commit context structure for the purposes of sending
- * SR_EV_ENABLED notification.
- * @return Error code (SR_ERR_OK on success)
- */
-static int
-dm_prepare_c_ctx_for_enable_notification(dm_ctx_t *dm_ctx, dm_commit_context_t **commit_context)
+int
+dm_enable_module_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name,
+        const np_subscription_t *subscription)
 {
-    CHECK_NULL_ARG(commit_context);
-
+    CHECK_NULL_ARG2(ctx, module_name); /* schema_info, session can be NULL */
+    dm_schema_info_t *si = NULL;
     int rc = SR_ERR_OK;
-    dm_commit_context_t *c_ctx = calloc(1, sizeof(*c_ctx));
-    CHECK_NULL_NOMEM_RETURN(c_ctx);
-
-    rc = dm_create_commit_ctx_id(dm_ctx, c_ctx);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Commit context id generating failed");
+    bool res = false;
 
-    pthread_mutex_init(&c_ctx->mutex, NULL);
+    rc = dm_has_enabled_subtree(ctx, module_name, &si, &res);
+    CHECK_RC_LOG_RETURN(rc, "Has enabled subtree check for %s failed", module_name);
 
-    rc = sr_btree_init(dm_module_subscription_cmp, dm_model_subscription_free, &c_ctx->subscriptions);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+    /* lock again */
+    RWLOCK_RDLOCK_TIMED_CHECK_RETURN(&si->model_lock);
 
-    rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, &c_ctx->prev_data_trees);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Binary tree allocation failed");
+    rc = dm_enable_module_running_internal(ctx, session, si, module_name);
+    pthread_rwlock_unlock(&si->model_lock);
+    CHECK_RC_LOG_RETURN(rc, "Enable module %s running failed", module_name);
 
-    c_ctx->state = DM_COMMIT_FINISHED;
+    if (!res) {
+        rc = dm_copy_module(ctx, session, module_name, SR_DS_STARTUP, SR_DS_RUNNING, subscription, 0, NULL, NULL);
+    }
 
-    *commit_context = c_ctx;
     return rc;
+}
+
+static int
+dm_copy_instances_of_the_sch_node(dm_data_info_t *src_info, dm_data_info_t *dst_info, struct lys_node *node)
+{
+    CHECK_NULL_ARG3(src_info, dst_info, node);
+    int rc = SR_ERR_OK;
+
+    if (src_info->node == NULL) {
+        return SR_ERR_OK;
+    }
+
+    struct ly_set *set = lyd_find_instance(src_info->node, node);
+    if (NULL != set) {
+        for (unsigned i = 0; i < set->number; i++) {
+            char *node_xpath = lyd_path(set->set.d[i]);
+            CHECK_NULL_NOMEM_GOTO(node_xpath, rc, cleanup);
+            dm_lyd_new_path(dst_info, node_xpath,
+                    ((struct lyd_node_leaf_list *) set->set.d[i])->value_str, LYD_PATH_OPT_UPDATE);
+            free(node_xpath);
+        }
+    }
 
 cleanup:
-    dm_free_commit_context(c_ctx);
+    ly_set_free(set);
     return rc;
 }
-/**
- * @brief Removes diff entries that does not match an xpath.
- * @param [in] ms
- * @param [in] subscription
- * @return Error code (SR_ERR_OK on success)
- */
+
 static int
-dm_remove_non_matching_diff(dm_model_subscription_t *ms, const np_subscription_t *subscription)
+dm_copy_mandatory_for_subtree(dm_ctx_t *dm_ctx, const char *xpath, dm_data_info_t *startup_info, dm_data_info_t *candidate_info)
 {
-    CHECK_NULL_ARG2(ms, subscription);
+    CHECK_NULL_ARG4(dm_ctx, xpath, startup_info, candidate_info);
     int rc = SR_ERR_OK;
     struct ly_set *set = NULL;
+    struct lys_node *node = NULL;
 
-    if (NULL != subscription->xpath) {
-        rc = sr_find_schema_node(ms->schema_info->module, NULL, subscription->xpath, 0, &set);
-        if (SR_ERR_OK != rc) {
-            SR_LOG_ERR("Schema node not found for xpath %s", subscription->xpath);
-            return SR_ERR_INTERNAL;
-        }
-
-        const struct lys_node *sub_node = set->set.s[0];
-        ly_set_free(set);
-        int diff_count = 0;
-        while (LYD_DIFF_END != ms->difflist->type[diff_count++]);
-
-        for (int i = diff_count - 2; i >= 0; i--) {
-            bool match = false;
-            const struct lyd_node *cmp_node = dm_get_notification_match_node(ms->difflist, i);
-            rc = dm_match_subscription(sub_node, cmp_node, &match);
-            CHECK_RC_MSG_RETURN(rc, "Subscription match failed");
+    rc = sr_find_schema_node(startup_info->schema->module, NULL, xpath, 0, &set);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Schema node not found for %s", xpath);
+        return SR_ERR_INTERNAL;
+    }
+    node = set->set.s[0]->parent;
+    ly_set_free(set);
 
-            if (!match) {
-                memmove(&ms->difflist->type[i],
-                        &ms->difflist->type[i + 1],
-                        (diff_count - i - 1) * sizeof(*ms->difflist->type));
-                /* there is no items for LYD_DIFF_END in first and second arrays,
-                 * these arrays are shorter thats why there is -2 instead of -1 */
-                memmove(&ms->difflist->first[i],
-                        &ms->difflist->first[i + 1],
-                        (diff_count - i - 2) * sizeof(*ms->difflist->first));
-                memmove(&ms->difflist->second[i],
-                        &ms->difflist->second[i + 1],
-                        (diff_count - i - 2) * sizeof(*ms->difflist->second));
-                diff_count--;
+    while (NULL != node) {
+        if (NULL == node->parent && LYS_AUGMENT == node->nodetype) {
+            node = ((struct lys_node_augment *) node)->target;
+            continue;
+        }
+        struct lys_node *n = NULL;
+        if ((LYS_LIST | LYS_CONTAINER) & node->nodetype) {
+            /* enable mandatory leaves */
+            n = node->child;
+            while (NULL != n) {
+                if ((LYS_LEAF | LYS_LEAFLIST) & n->nodetype &&
+                        LYS_MAND_MASK & n->flags) {
+                    rc = dm_copy_instances_of_the_sch_node(startup_info, candidate_info, n);
+                    CHECK_RC_LOG_RETURN(rc, "Copying of instances of sch node '%s' failed", n->name);
+                }
+                n = n->next;
             }
         }
+        node = node->parent;
     }
 
-    return SR_ERR_OK;
+    return rc;
 }
 
 /**
- * @brief Fills dm_model_subscription_t structure for the purposes of browsing changes
- * after SR_EV_ENABLED is sent.
+ * @brief Copies a subtree (specified by xpath) of configuration from startup to running. Replaces
+ * the previous configuration under the xpath.
  *
- * @param [in] dm_ctx
- * @param [in] user_credentials
- * @param [in] src_session
- * @param [in] module_name
+ * @param [in] ctx
+ * @param [in] session
+ * @param [in] module
+ * @param [in] xpath
  * @param [in] subscription
- * @param [in] c_ctx
- * @return Error code (SR_ERR_OK on success).
+ * @return Error code (SR_ERR_OK on success)
  */
 static int
-dm_create_difflist_for_enabled_notif(dm_ctx_t *dm_ctx, const ac_ucred_t *user_credentials, dm_session_t *src_session,
-        const char *module_name, const np_subscription_t *subscription, dm_commit_context_t *c_ctx)
+dm_copy_subtree_startup_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name, dm_schema_info_t *schema_info, const char *xpath, const np_subscription_t *subscription)
 {
-
-    CHECK_NULL_ARG5(dm_ctx, src_session, module_name, subscription, c_ctx);
-
+    CHECK_NULL_ARG5(ctx, session, module_name, schema_info, xpath);
     int rc = SR_ERR_OK;
-    dm_model_subscription_t *ms = NULL;
+    struct ly_set *nodes = NULL;
+    dm_session_t *tmp_session = NULL;
+    dm_data_info_t *startup_info = NULL;
+    dm_data_info_t *candidate_info = NULL;
+    struct lyd_node *node = NULL, *parent = NULL;
 
-    rc = dm_session_start(dm_ctx, user_credentials, SR_DS_RUNNING, &c_ctx->session);
-    CHECK_RC_MSG_RETURN(rc, "Start session failed");
+    rc = dm_session_start(ctx, session->user_credentials, SR_DS_STARTUP, &tmp_session);
+    CHECK_RC_MSG_RETURN(rc, "Failed to start a temporary session");
 
-    rc = dm_copy_session_tree(dm_ctx, src_session, c_ctx->session, module_name);
-    CHECK_RC_MSG_RETURN(rc, "Data tree copy failed");
+    /* select nodes by xpath from startup */
+    rc = dm_get_data_info(ctx, tmp_session, module_name, &startup_info);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Get info for startup config failed");
 
-    /* there is only one data tree in session */
-    dm_data_info_t *copied_di = (dm_data_info_t *) sr_btree_get_at(c_ctx->session->session_modules[SR_DS_RUNNING], 0);
-    if (NULL == copied_di) {
-        SR_LOG_ERR("Data tree for module %s not found", module_name);
-        return SR_ERR_INTERNAL;
+    if (NULL == startup_info->node) {
+        SR_LOG_DBG("Startup config for module '%s' is empty nothing to copy", module_name);
     }
 
-    ms = calloc(1, sizeof(*ms));
-    CHECK_NULL_NOMEM_RETURN(ms);
+    /* switch to candidate */
+    tmp_session->datastore = SR_DS_CANDIDATE;
+    rc = dm_get_data_info(ctx, tmp_session, module_name, &candidate_info);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Get info failed");
 
-    ms->schema_info = copied_di->schema;
+    /* remove previous config from running */
+    SR_LOG_DBG("Remove previous content of running configuration under %s.", xpath);
+    rc = rp_dt_delete_item(ctx, tmp_session, xpath, SR_EDIT_DEFAULT, false);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Delete of previous values in running failed xpath %s", xpath);
 
-    ms->difflist = lyd_diff(NULL, copied_di->node, LYD_DIFFOPT_WITHDEFAULTS);
-    if (NULL == ms->difflist) {
-        SR_LOG_ERR_MSG("Error while generating diff");
-        rc = SR_ERR_INTERNAL;
-        goto cleanup;
+    /* select a part of configuration to be enabled */
+    rc = rp_dt_find_nodes(ctx, startup_info->node, xpath, false, &nodes);
+    if (SR_ERR_NOT_FOUND == rc) {
+        SR_LOG_DBG("Subtree %s of enabled configuration is empty", xpath);
+        rc = SR_ERR_OK;
     }
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Find nodes for configuration to be enabled failed");
+    candidate_info->modified = true;
 
-    rc = dm_remove_non_matching_diff(ms, subscription);
-    if (SR_ERR_OK != rc) {
-        SR_LOG_ERR_MSG("Dm remove non match diff failed");
-        goto cleanup;
+    /* insert selected nodes */
+    for (unsigned i = 0; NULL != nodes && i < nodes->number; i++) {
+        node = nodes->set.d[i];
+        if ((LYS_LEAF | LYS_LEAFLIST) & node->schema->nodetype) {
+            char *node_xpath = lyd_path(node);
+            CHECK_NULL_NOMEM_GOTO(node_xpath, rc, cleanup);
+            dm_lyd_new_path(candidate_info, node_xpath,
+                    ((struct lyd_node_leaf_list *) node)->value_str, LYD_PATH_OPT_UPDATE);
+            free(node_xpath);
+        } else {
+            /* list or container */
+            if (NULL != node->parent) {
+                char *parent_xpath = lyd_path(node->parent);
+                dm_lyd_new_path(candidate_info, parent_xpath, NULL, LYD_PATH_OPT_UPDATE);
+                /* create or find parent node */
+                rc = rp_dt_find_node(ctx, candidate_info->node, parent_xpath, false, &parent);
+                free(parent_xpath);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to find parent node");
+            }
+            /* unlink data tree from session */
+            sr_lyd_unlink(startup_info, node);
+
+            /* attach to parent */
+            if (NULL != parent) {
+                if (0 != lyd_insert(parent, node)) {
+                    SR_LOG_ERR_MSG("Node insert failed");
+                    lyd_free_withsiblings(node);
+                }
+            } else {
+                rc = sr_lyd_insert_after(candidate_info, candidate_info->node, node);
+                if (SR_ERR_OK != rc) {
+                    lyd_free_withsiblings(node);
+                    SR_LOG_ERR_MSG("Node insert failed");
+                }
+            }
+        }
     }
 
-    rc = sr_btree_insert(c_ctx->subscriptions, ms);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert model subscription structure");
-    return rc;
+    /* copy mandatory nodes that were enabled automatically */
+    rc = dm_copy_mandatory_for_subtree(ctx, xpath, startup_info, candidate_info);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to copy mandatory nodes for subtree");
+
+    /* swap candidate and startup data info nodes so we can do the copy from SR_DS_STARTUP
+     * otherwise validation will get messed up since all startup config has not necessarily been
+     * loaded yet
+     */
+    node = startup_info->node;
+    startup_info->node = candidate_info->node;
+    candidate_info->node = node;
+    tmp_session->datastore = SR_DS_STARTUP;
+
+    /* copy module startup -> running */
+    rc = dm_copy_module(ctx, tmp_session, module_name, SR_DS_STARTUP, SR_DS_RUNNING, subscription, 0, NULL, NULL);
 
 cleanup:
-    dm_model_subscription_free(ms);
+    ly_set_free(nodes);
+    dm_session_stop(ctx, tmp_session);
+
     return rc;
 }
 
-/**
- * @brief Sends enabled notification.
- *
- * @param [in] dm_ctx
- * @param [in] c_ctx - do not use after return from the function
- * @param [in] subscription
- * @return Error code (SR_ERR_OK on success)
- */
-static int
-dm_send_enabled_notification(dm_ctx_t *dm_ctx, dm_commit_context_t *c_ctx, const np_subscription_t *subscription)
+int
+dm_enable_module_subtree_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name, const char *xpath,
+        const np_subscription_t *subscription)
 {
+    CHECK_NULL_ARG3(ctx, module_name, xpath); /* session can be NULL */
+    dm_schema_info_t *si = NULL;
     int rc = SR_ERR_OK;
-    sr_list_t *notif_list = NULL;
-
-    CHECK_NULL_ARG_NORET3(rc, dm_ctx, c_ctx, subscription);
-    if (SR_ERR_OK != rc) {
-        goto cleanup;
-    }
-
-    rc = dm_insert_commit_context(dm_ctx, c_ctx);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to insert commit context");
-
-    uint32_t commit_id = c_ctx->id;
-    /* do not free commit context in cleanup */
-    c_ctx = NULL;
 
-    rc = sr_list_init(&notif_list);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "List init failed");
-
-    rc = sr_list_add(notif_list, (void *) subscription);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "List insert failed");
+    rc = dm_get_module_and_lockw(ctx, module_name, &si);
+    CHECK_RC_LOG_RETURN(rc, "Lock schema %s for write failed", module_name);
 
-    rc = np_subscription_notify(dm_ctx->np_ctx, (np_subscription_t *) subscription, SR_EV_ENABLED, commit_id);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Sending of SR_EV_ENABLED notification failed");
+    rc = rp_dt_enable_xpath(ctx, session, si, xpath);
+    pthread_rwlock_unlock(&si->model_lock);
+    CHECK_RC_LOG_RETURN(rc, "Enabling of xpath %s failed", xpath);
 
-    rc = np_commit_notifications_sent(dm_ctx->np_ctx, commit_id, true, notif_list);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Notification sent failed");
+    rc = dm_copy_subtree_startup_running(ctx, session, module_name, si, xpath, subscription);
 
-cleanup:
-    if (SR_ERR_OK != rc) {
-        dm_free_commit_context(c_ctx);
-    }
-    sr_list_cleanup(notif_list);
     return rc;
 }
 
-static int
-dm_copy_config(dm_ctx_t *dm_ctx, dm_session_t *session, const sr_list_t *module_names, sr_datastore_t src,
-               sr_datastore_t dst, const np_subscription_t *subscription, bool nacm_on, sr_error_info_t **errors, size_t *err_cnt)
+int
+dm_disable_module_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name)
 {
-    CHECK_NULL_ARG2(dm_ctx, module_names);
+    CHECK_NULL_ARG2(ctx, module_name);
     int rc = SR_ERR_OK;
-    dm_session_t *src_session = NULL;
-    dm_session_t *dst_session = NULL;
-    char *module_name = NULL;
-    dm_data_info_t **src_infos = NULL, *dst_info = NULL;
-    size_t opened_files = 0;
-    char *file_name = NULL;
-    int *fds = NULL;
-    dm_commit_context_t *c_ctx = NULL;
-    sr_datastore_t prev_ds = 0;
-
-    if (src == dst || 0 == module_names->count) {
-        return rc;
-    }
-
-    if (NULL != subscription) {
-        if (SR_DS_RUNNING != dst) {
-            SR_LOG_ERR_MSG("Notification cannot be sent for datastore different from running");
-            return SR_ERR_INVAL_ARG;
-        }
-        rc = dm_prepare_c_ctx_for_enable_notification(dm_ctx, &c_ctx);
-        CHECK_RC_MSG_RETURN(rc, "Preparing of commit context failed");
-    }
-
-    src_infos = calloc(module_names->count, sizeof(*src_infos));
-    CHECK_NULL_NOMEM_GOTO(src_infos, rc, cleanup);
-    fds = calloc(module_names->count, sizeof(*fds));
-    CHECK_NULL_NOMEM_GOTO(fds, rc, cleanup);
-
-    /* create source session */
-    if (SR_DS_CANDIDATE != src) {
-        rc = dm_session_start(dm_ctx, (session != NULL ? session->user_credentials : NULL), src, &src_session);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Creating of temporary session failed");
-    } else {
-        src_session = session;
-        sr_error_info_t *errors = NULL;
-        size_t e_cnt = 0;
-        rc = dm_validate_session_data_trees(dm_ctx, session, &errors, &e_cnt);
-        if (SR_ERR_OK != rc) {
-            if (NULL != errors) {
-                rc = dm_report_error(session, errors[0].message, errors[0].xpath, SR_ERR_VALIDATION_FAILED);
-                sr_free_errors(errors, e_cnt);
-            }
-            SR_LOG_ERR_MSG("There is a invalid data tree, can not be copied");
-            goto cleanup;
-        }
-    }
+    dm_schema_info_t *schema_info = NULL;
 
-    /* create destination session */
-    if (SR_DS_CANDIDATE != dst) {
-        rc = dm_session_start(dm_ctx, (session != NULL ? session->user_credentials : NULL), dst, &dst_session);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Creating of temporary session failed");
-    } else {
-        dst_session = session;
-    }
+    rc = dm_get_module_and_lockw(ctx, module_name, &schema_info);
+    CHECK_RC_LOG_RETURN(rc, "Get module failed for module %s", module_name);
 
-    for (size_t i = 0; i < module_names->count; i++) {
-        module_name = module_names->data[i];
+    struct lys_node *iter = NULL, *child;
+    sr_list_t *stack = NULL;
+    rc = sr_list_init(&stack);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
 
-        /* lock module in destination */
-        if (SR_DS_CANDIDATE != dst) {
-            rc = dm_lock_module(dm_ctx, dst_session, (char *) module_name);
-            if (SR_ERR_LOCKED == rc && NULL != session) {
-                prev_ds = session->datastore;
-                if (dst != session->datastore) {
-                    /* temporary switch DS to check locks */
-                    prev_ds = session->datastore;
-                    dm_session_switch_ds(session, dst);
-                }
-                /* check if the lock is hold by session that issued copy-config */
-                rc = dm_lock_module(dm_ctx, session, (char *) module_name);
+    /* iterate through top-level nodes */
+    while ((iter = (struct lys_node *)lys_getnext(iter, NULL, schema_info->module, 0))) {
+        if (dm_is_node_enabled(iter)) {
+            rc = dm_set_node_state(iter, DM_NODE_DISABLED);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Set node state failed");
 
-                if (prev_ds != session->datastore) {
-                    dm_session_switch_ds(session, prev_ds);
+            child = NULL;
+            while ((child = (struct lys_node *)lys_getnext(child, iter, NULL, 0))) {
+                if (dm_is_node_enabled(child)) {
+                    rc = sr_list_add(stack, child);
+                    CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
                 }
             }
-            if (rc != SR_ERR_OK) {
-                SR_LOG_WRN("Module %s can not be locked in destination datastore", module_name);
-                goto cleanup;
-            }
-        }
-
-        /* load data tree to be copied */
-        rc = dm_get_data_info(dm_ctx, src_session, module_name, &(src_infos[i]));
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Get data info failed");
-
-        if (NULL != session && NULL != dm_ctx->nacm_ctx && nacm_on) {
-            /* load data tree to be replaced */
-            rc = dm_get_data_info(dm_ctx, session, module_name, &dst_info);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data info failed");
-
-            rc = dm_perform_netconf_access_control(dm_ctx->nacm_ctx, session, dst_info, src_infos[i], true, errors, err_cnt, NULL);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Checking NACM failed");
         }
+    }
 
-        if (NULL != subscription && 0 == i) {
-            /* subscription is supposed to be used when only one module/subtree is copied */
-            rc = dm_create_difflist_for_enabled_notif(dm_ctx, session->user_credentials, src_session, module_name, subscription, c_ctx);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to create difflist");
-        }
+    /* recursively disable all enabled children*/
+    while (stack->count != 0) {
+        iter = stack->data[stack->count - 1];
+        rc = dm_set_node_state(iter, DM_NODE_DISABLED);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Set node state failed");
 
-        if (SR_DS_CANDIDATE != dst) {
-            /* create data file name */
-            rc = sr_get_data_file_name(dm_ctx->data_search_dir, module_name, dst_session->datastore, &file_name);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data file name failed");
+        sr_list_rm_at(stack, stack->count - 1);
 
-            if (NULL != session) {
-                ac_set_user_identity(dm_ctx->ac_ctx, session->user_credentials);
-            }
-            fds[opened_files] = open(file_name, O_RDWR);
-            if (NULL != session) {
-                ac_unset_user_identity(dm_ctx->ac_ctx, session->user_credentials);
-            }
-            if (-1 == fds[opened_files]) {
-                SR_LOG_ERR("File %s can not be opened", file_name);
-                free(file_name);
-                goto cleanup;
-            }
-            /* lock, write, blocking */
-            sr_lock_fd(fds[opened_files], true, true);
-            if (ftruncate(fds[opened_files], 0) != 0) {
-                SR_LOG_ERR("File %s can not be truncated: %s", file_name, sr_strerror_safe(errno));
-                free(file_name);
-                opened_files++;
-                goto cleanup;
+        child = NULL;
+        while ((child = (struct lys_node *)lys_getnext(child, iter, NULL, 0))) {
+            if (dm_is_node_enabled(child)) {
+                rc = sr_list_add(stack, child);
+                CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
             }
-            opened_files++;
-            free(file_name);
         }
     }
+cleanup:
+    pthread_rwlock_unlock(&schema_info->model_lock);
+    sr_list_cleanup(stack);
 
-    int ret = 0;
-    for (size_t i = 0; i < module_names->count; i++) {
-        module_name = module_names->data[i];
-        if (SR_DS_CANDIDATE != dst) {
-            /* write dest file, dst is either startup or running */
-            if (0 != lyd_print_fd(fds[i], src_infos[i]->node, SR_FILE_FORMAT_LY, LYP_WITHSIBLINGS | LYP_FORMAT)) {
-                SR_LOG_ERR("Copy of module %s failed", module_name);
-                rc = SR_ERR_INTERNAL;
-            }
-            ret = fsync(fds[i]);
-            if (0 != ret) {
-                SR_LOG_ERR("Failed to write data of '%s' module: %s", src_infos[i]->schema->module->name,
-                        (ly_errno != LY_SUCCESS) ? ly_errmsg(src_infos[i]->node->schema->module->ctx) : sr_strerror_safe(errno));
-                rc = SR_ERR_INTERNAL;
-            }
-        } else {
-            /* copy data tree into candidate session */
-            struct lyd_node *dup = sr_dup_datatree(src_infos[i]->node);
-            dm_data_info_t *di_tmp = NULL;
-            if (NULL != src_infos[i]->node && NULL == dup) {
-                SR_LOG_ERR("Duplication of data tree %s failed", src_infos[i]->schema->module->name);
-                rc = SR_ERR_INTERNAL;
-                goto cleanup;
-            }
-            /* load data tree to be copied*/
-            rc = dm_get_data_info(dm_ctx, dst_session, module_name, &di_tmp);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Get data info failed");
-            lyd_free_withsiblings(di_tmp->node);
-            di_tmp->node = dup;
-            di_tmp->modified = true;
-        }
-    }
+    return rc;
+}
+
+int
+dm_copy_module(dm_ctx_t *dm_ctx, dm_session_t *session, const char *module_name, sr_datastore_t src, sr_datastore_t dst,
+        const np_subscription_t *subscription, bool nacm_on, sr_error_info_t **errors, size_t *err_cnt)
+{
+    CHECK_NULL_ARG2(dm_ctx, module_name);
+    sr_list_t *module_list = NULL;
+    dm_schema_info_t *schema_info = NULL;
+    int rc = SR_ERR_OK;
+    bool enabled = false;
 
-    if (SR_DS_CANDIDATE == dst) {
-        dm_remove_session_operations(dst_session);
+    /* the module must be enabled */
+    rc = dm_has_enabled_subtree(dm_ctx, module_name, NULL, &enabled);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Has enabled subtree failed %s", module_name);
+    if (!enabled) {
+        SR_LOG_ERR("Cannot copy module '%s', it is not enabled.", module_name);
+        rc = SR_ERR_OPERATION_FAILED;
+        goto cleanup;
     }
 
-    if (NULL != subscription) {
-        rc = dm_send_enabled_notification(dm_ctx, c_ctx, subscription);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Sending of enable notification failed");
+    rc = sr_list_init(&module_list);
+    CHECK_RC_MSG_RETURN(rc, "List init failed");
 
-        /* do not free commit context in cleanup */
-        c_ctx = NULL;
-    }
+    rc = dm_get_module_without_lock(dm_ctx, module_name, &schema_info);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "dm_get_module failed");
+
+    rc = sr_list_add(module_list, (void *) module_name);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+
+    rc = dm_copy_config(dm_ctx, session, module_list, src, dst, subscription, nacm_on, errors, err_cnt);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Dm copy config failed");
 
 cleanup:
-    if (SR_DS_CANDIDATE != src) {
-        dm_session_stop(dm_ctx, src_session);
-    }
-    if (SR_DS_CANDIDATE != dst) {
-        dm_session_stop(dm_ctx, dst_session);
-    }
-    for (size_t i = 0; i < opened_files; i++) {
-        close(fds[i]);
-    }
-    free(fds);
-    free(src_infos);
-    dm_free_commit_context(c_ctx);
+    sr_list_cleanup(module_list);
     return rc;
 }
 
 int
-dm_has_state_data(dm_ctx_t *ctx, const char *module_name, bool *res)
+dm_commit_save_snapshot(dm_ctx_t *dm_ctx, const dm_commit_context_t *c_ctx, sr_btree_t **snapshot)
 {
-    CHECK_NULL_ARG3(ctx, module_name, res);
-    md_module_t *module = NULL;
+    CHECK_NULL_ARG4(dm_ctx, c_ctx, c_ctx->prev_data_trees, snapshot);
+    dm_data_info_t *prev_info = NULL;
+    size_t i = 0;
     int rc = SR_ERR_OK;
 
-    md_ctx_lock(ctx->md_ctx, false);
-    rc = md_get_module_info(ctx->md_ctx, module_name, NULL, NULL, &module);
-    if (SR_ERR_OK == rc) {
-        *res = (module->op_data_subtrees->first != NULL);
+    if (NULL == *snapshot) {
+        rc = sr_btree_init(dm_data_info_cmp, dm_data_info_free, snapshot);
+        CHECK_RC_MSG_RETURN(rc, "Binary tree allocation failed");
+    }
+
+    while (NULL != (prev_info = sr_btree_get_at(c_ctx->prev_data_trees, i++))) {
+        if (NULL != sr_btree_search(*snapshot, prev_info)) {
+            /* the state before an earlier commit has been already saved */
+            continue;
+        }
+        rc = dm_insert_data_info_copy(*snapshot, prev_info);
+        CHECK_RC_LOG_RETURN(rc, "Saving of data tree %s failed", prev_info->schema->module->name);
     }
-    md_ctx_unlock(ctx->md_ctx);
 
     return rc;
 }
 
 int
-dm_has_enabled_subtree(dm_ctx_t *ctx, const char *module_name, dm_schema_info_t **schema, bool *res)
+dm_restore_snapshot(dm_ctx_t *dm_ctx, dm_session_t *session, sr_btree_t *snapshot)
 {
-    CHECK_NULL_ARG3(ctx, module_name, res);
+    CHECK_NULL_ARG3(dm_ctx, session, snapshot);
+    dm_data_info_t *saved = NULL, *info = NULL;
+    struct lyd_node *dup = NULL;
+    size_t i = 0;
     int rc = SR_ERR_OK;
-    dm_schema_info_t *schema_info = NULL;
-    const struct lys_node *node = NULL;
 
-    rc = dm_get_module_and_lock(ctx, module_name, &schema_info);
-    CHECK_RC_MSG_RETURN(rc, "Get module failed");
+    while (NULL != (saved = sr_btree_get_at(snapshot, i++))) {
+        rc = dm_get_data_info(dm_ctx, session, saved->schema->module->name, &info);
+        CHECK_RC_LOG_RETURN(rc, "Get data info failed %s", saved->schema->module->name);
 
-    *res = false;
+        dup = NULL;
+        if (NULL != saved->node) {
+            dup = sr_dup_datatree(saved->node);
+            CHECK_NULL_NOMEM_RETURN(dup);
+        }
+        lyd_free_withsiblings(info->node);
+        info->node = dup;
+        info->modified = true;
+    }
 
-    while ((node = lys_getnext(node, NULL, schema_info->module, 0))) {
-        if (dm_is_enabled_check_recursively((struct lys_node *)node)) {
-            *res = true;
-            break;
+    return rc;
+}
+
+/**
+ * @brief Header of the rollback checkpoint file. The checkpoint holds the inverse of the changes made by one commit
+ * to running datastore, as a sequence of edit entries that bring the data back to the state before the commit.
+ * The header is followed by the entries.
+ */
+typedef struct dm_checkpoint_hdr_s {
+    uint32_t magic;         /**< ::DM_CHECKPOINT_MAGIC */
+    uint32_t version;       /**< ::DM_CHECKPOINT_VERSION */
+    uint64_t id;            /**< sequence number of the commit, the checkpoint is stored in the slot id % ::SR_CHECKPOINT_COUNT */
+    uint64_t entry_cnt;     /**< number of entries following the header */
+    uint64_t data_size;     /**< size of all the entries */
+} dm_checkpoint_hdr_t;
+
+/**
+ * @brief Operation of the rollback checkpoint entry.
+ */
+typedef enum dm_checkpoint_op_e {
+    DM_CHECKPOINT_SET,      /**< create the node or set the value of the leaf */
+    DM_CHECKPOINT_DELETE,   /**< remove the node */
+    DM_CHECKPOINT_MOVE,     /**< move the user-ordered instance after the value, to the first position if there is no value */
+} dm_checkpoint_op_t;
+
+/**
+ * @brief Entry of the rollback checkpoint, followed by the xpath and the value (both including the terminating zero).
+ */
+typedef struct dm_checkpoint_entry_s {
+    uint32_t op;            /**< ::dm_checkpoint_op_t */
+    uint32_t xpath_size;    /**< size of the xpath including the terminating zero */
+    uint32_t value_size;    /**< size of the value including the terminating zero, 0 if there is no value */
+    uint32_t reserved;      /**< unused */
+} dm_checkpoint_entry_t;
+
+/**
+ * @brief Buffer the checkpoint entries are serialized into.
+ */
+typedef struct dm_checkpoint_buf_s {
+    char *data;             /**< serialized entries */
+    size_t size;            /**< used size of the data */
+    size_t capacity;        /**< allocated size of the data */
+    uint64_t entry_cnt;     /**< number of the serialized entries */
+    sr_list_t *lists;       /**< first instances of the user-ordered lists whose order has been recorded */
+} dm_checkpoint_buf_t;
+
+/**
+ * @brief Appends an entry to the checkpoint buffer.
+ */
+static int
+dm_checkpoint_add(dm_checkpoint_buf_t *buf, dm_checkpoint_op_t op, const char *xpath, const char *value)
+{
+    dm_checkpoint_entry_t entry = {0};
+    size_t needed = 0, capacity = 0;
+    char *tmp = NULL;
+
+    entry.op = op;
+    entry.xpath_size = strlen(xpath) + 1;
+    entry.value_size = NULL != value ? strlen(value) + 1 : 0;
+
+    needed = buf->size + sizeof entry + entry.xpath_size + entry.value_size;
+    if (needed > buf->capacity) {
+        capacity = 0 != buf->capacity ? buf->capacity : 1024;
+        while (capacity < needed) {
+            capacity *= 2;
         }
+        tmp = realloc(buf->data, capacity);
+        CHECK_NULL_NOMEM_RETURN(tmp);
+        buf->data = tmp;
+        buf->capacity = capacity;
     }
 
-    if (NULL != schema) {
-        *schema = schema_info;
+    memcpy(buf->data + buf->size, &entry, sizeof entry);
+    buf->size += sizeof entry;
+    memcpy(buf->data + buf->size, xpath, entry.xpath_size);
+    buf->size += entry.xpath_size;
+    if (NULL != value) {
+        memcpy(buf->data + buf->size, value, entry.value_size);
+        buf->size += entry.value_size;
     }
-    pthread_rwlock_unlock(&schema_info->model_lock);
+    ++buf->entry_cnt;
+
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Appends an entry identifying the node to the checkpoint buffer.
+ */
+static int
+dm_checkpoint_add_node(dm_checkpoint_buf_t *buf, dm_checkpoint_op_t op, const struct lyd_node *node, const char *value)
+{
+    char *xpath = NULL;
+    int rc = SR_ERR_OK;
+
+    xpath = lyd_path((struct lyd_node *) node);
+    CHECK_NULL_NOMEM_RETURN(xpath);
+
+    rc = dm_checkpoint_add(buf, op, xpath, value);
+    free(xpath);
     return rc;
 }
 
-int
-dm_enable_module_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name,
-        const np_subscription_t *subscription)
+/**
+ * @brief Appends the entries restoring the order of all the instances of the user-ordered list or leaf-list
+ * the node belongs to: the first instance is moved to the first position, each next one after its predecessor.
+ * Applied in this order, the entries restore the original order whatever the order of the instances is.
+ * The order of each list is recorded only once, nothing is appended for other nodes.
+ */
+static int
+dm_checkpoint_add_position(dm_checkpoint_buf_t *buf, const struct lyd_node *node)
 {
-    CHECK_NULL_ARG2(ctx, module_name); /* schema_info, session can be NULL */
-    dm_schema_info_t *si = NULL;
+    const struct lyd_node *first = NULL, *sibling = NULL;
+    char *xpath = NULL, *prev_xpath = NULL;
     int rc = SR_ERR_OK;
-    bool res = false;
 
-    rc = dm_has_enabled_subtree(ctx, module_name, &si, &res);
-    CHECK_RC_LOG_RETURN(rc, "Has enabled subtree check for %s failed", module_name);
+    if (!((LYS_LIST | LYS_LEAFLIST) & node->schema->nodetype) || !(LYS_USERORDERED & node->schema->flags)) {
+        return SR_ERR_OK;
+    }
 
-    /* lock again */
-    RWLOCK_RDLOCK_TIMED_CHECK_RETURN(&si->model_lock);
+    /* prev of the first sibling points to the last one */
+    for (first = node; NULL != first->prev->next; first = first->prev);
+    while (first->schema != node->schema) {
+        first = first->next;
+    }
 
-    rc = dm_enable_module_running_internal(ctx, session, si, module_name);
-    pthread_rwlock_unlock(&si->model_lock);
-    CHECK_RC_LOG_RETURN(rc, "Enable module %s running failed", module_name);
+    if (NULL == buf->lists) {
+        rc = sr_list_init(&buf->lists);
+        CHECK_RC_MSG_RETURN(rc, "List init failed");
+    }
+    for (size_t i = 0; i < buf->lists->count; ++i) {
+        if (first == buf->lists->data[i]) {
+            return SR_ERR_OK;
+        }
+    }
+    rc = sr_list_add(buf->lists, (void *) first);
+    CHECK_RC_MSG_RETURN(rc, "List add failed");
 
-    if (!res) {
-        rc = dm_copy_module(ctx, session, module_name, SR_DS_STARTUP, SR_DS_RUNNING, subscription, 0, NULL, NULL);
+    LY_TREE_FOR(first, sibling) {
+        if (sibling->schema != node->schema) {
+            continue;
+        }
+        xpath = lyd_path((struct lyd_node *) sibling);
+        CHECK_NULL_NOMEM_GOTO(xpath, rc, cleanup);
+        rc = dm_checkpoint_add(buf, DM_CHECKPOINT_MOVE, xpath, prev_xpath);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Recording of the list order failed");
+        free(prev_xpath);
+        prev_xpath = xpath;
+        xpath = NULL;
     }
 
+cleanup:
+    free(prev_xpath);
+    free(xpath);
     return rc;
 }
 
+/**
+ * @brief Returns true if the leaf is a key of its parent list instance.
+ */
+static bool
+dm_checkpoint_is_key(const struct lyd_node *node)
+{
+    const struct lys_node_list *list = NULL;
+
+    if (NULL == node->parent || LYS_LIST != node->parent->schema->nodetype) {
+        return false;
+    }
+    list = (const struct lys_node_list *) node->parent->schema;
+    for (uint8_t i = 0; i < list->keys_size; ++i) {
+        if ((const struct lys_node *) list->keys[i] == node->schema) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Appends the entries recreating the subtree, parents are created before their children.
+ * The positions of the user-ordered instances are appended into the separate buffer so that they are
+ * restored once all the instances exist.
+ */
 static int
-dm_copy_instances_of_the_sch_node(dm_data_info_t *src_info, dm_data_info_t *dst_info, struct lys_node *node)
+dm_checkpoint_add_subtree(dm_checkpoint_buf_t *buf, dm_checkpoint_buf_t *moves, const struct lyd_node *node)
 {
-    CHECK_NULL_ARG3(src_info, dst_info, node);
+    const struct lyd_node *child = NULL;
+    char *xpath = NULL;
     int rc = SR_ERR_OK;
 
-    if (src_info->node == NULL) {
+    if (node->dflt) {
+        /* default nodes are added back by the validation */
         return SR_ERR_OK;
     }
 
-    struct ly_set *set = lyd_find_instance(src_info->node, node);
-    if (NULL != set) {
-        for (unsigned i = 0; i < set->number; i++) {
-            char *node_xpath = lyd_path(set->set.d[i]);
-            CHECK_NULL_NOMEM_GOTO(node_xpath, rc, cleanup);
-            dm_lyd_new_path(dst_info, node_xpath,
-                    ((struct lyd_node_leaf_list *) set->set.d[i])->value_str, LYD_PATH_OPT_UPDATE);
-            free(node_xpath);
+    switch (node->schema->nodetype) {
+    case LYS_LEAF:
+        if (!dm_checkpoint_is_key(node)) {
+            rc = dm_checkpoint_add_node(buf, DM_CHECKPOINT_SET, node, ((const struct lyd_node_leaf_list *) node)->value_str);
+        }
+        return rc;
+    case LYS_LEAFLIST:
+        rc = dm_checkpoint_add_node(buf, DM_CHECKPOINT_SET, node, NULL);
+        if (SR_ERR_OK == rc) {
+            rc = dm_checkpoint_add_position(moves, node);
+        }
+        return rc;
+    case LYS_CONTAINER:
+        if (NULL != ((const struct lys_node_container *) node->schema)->presence) {
+            rc = dm_checkpoint_add_node(buf, DM_CHECKPOINT_SET, node, NULL);
+        }
+        break;
+    case LYS_LIST:
+        rc = dm_checkpoint_add_node(buf, DM_CHECKPOINT_SET, node, NULL);
+        if (SR_ERR_OK == rc) {
+            rc = dm_checkpoint_add_position(moves, node);
         }
+        break;
+    default:
+        xpath = lyd_path((struct lyd_node *) node);
+        SR_LOG_WRN("Node %s can not be recorded in a rollback checkpoint", xpath);
+        free(xpath);
+        return SR_ERR_OK;
     }
+    CHECK_RC_MSG_RETURN(rc, "Recording of the deleted node failed");
 
-cleanup:
-    ly_set_free(set);
+    LY_TREE_FOR(node->child, child) {
+        rc = dm_checkpoint_add_subtree(buf, moves, child);
+        CHECK_RC_MSG_RETURN(rc, "Recording of the deleted subtree failed");
+    }
     return rc;
 }
 
+/**
+ * @brief Appends the entries reverting the changes in the diff list.
+ */
 static int
-dm_copy_mandatory_for_subtree(dm_ctx_t *dm_ctx, const char *xpath, dm_data_info_t *startup_info, dm_data_info_t *candidate_info)
+dm_checkpoint_add_diff(dm_checkpoint_buf_t *buf, dm_checkpoint_buf_t *moves, const struct lyd_difflist *diff)
 {
-    CHECK_NULL_ARG4(dm_ctx, xpath, startup_info, candidate_info);
+    const struct lyd_node *node = NULL;
     int rc = SR_ERR_OK;
-    struct ly_set *set = NULL;
-    struct lys_node *node = NULL;
 
-    rc = sr_find_schema_node(startup_info->schema->module, NULL, xpath, 0, &set);
+    for (size_t d = 0; LYD_DIFF_END != diff->type[d]; ++d) {
+        switch (diff->type[d]) {
+        case LYD_DIFF_CREATED:
+            if (!diff->second[d]->dflt) {
+                rc = dm_checkpoint_add_node(buf, DM_CHECKPOINT_DELETE, diff->second[d], NULL);
+            }
+            break;
+        case LYD_DIFF_DELETED:
+            rc = dm_checkpoint_add_subtree(buf, moves, diff->first[d]);
+            break;
+        case LYD_DIFF_CHANGED:
+            node = diff->first[d];
+            if (node->dflt) {
+                /* removing the explicit value brings the default back */
+                rc = dm_checkpoint_add_node(buf, DM_CHECKPOINT_DELETE, node, NULL);
+            } else if (LYS_LEAF == node->schema->nodetype) {
+                rc = dm_checkpoint_add_node(buf, DM_CHECKPOINT_SET, node, ((const struct lyd_node_leaf_list *) node)->value_str);
+            }
+            break;
+        case LYD_DIFF_MOVEDAFTER1:
+            rc = dm_checkpoint_add_position(moves, diff->first[d]);
+            break;
+        default:
+            /* created instances (LYD_DIFF_MOVEDAFTER2) are removed anyway */
+            break;
+        }
+        CHECK_RC_MSG_RETURN(rc, "Recording of the inverse change failed");
+    }
+    return rc;
+}
+
+/**
+ * @brief Opens and locks the checkpoint lock file, the lock is released by closing the file.
+ */
+static int
+dm_checkpoint_lock(dm_ctx_t *dm_ctx, bool write, int *fd)
+{
+    char *file_name = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = sr_path_join(dm_ctx->internal_data_search_dir, DM_CHECKPOINT_LOCK_FILENAME, &file_name);
+    CHECK_RC_MSG_RETURN(rc, "Unable to compose the checkpoint lock file name.");
+
+    *fd = open(file_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    if (-1 == *fd) {
+        SR_LOG_WRN("Unable to open checkpoint lock file %s: %s", file_name, sr_strerror_safe(errno));
+        free(file_name);
+        return SR_ERR_IO;
+    }
+    free(file_name);
+
+    rc = sr_lock_fd(*fd, write, true);
     if (SR_ERR_OK != rc) {
-        SR_LOG_ERR("Schema node not found for %s", xpath);
-        return SR_ERR_INTERNAL;
+        SR_LOG_ERR_MSG("Locking of the checkpoint lock file failed");
+        close(*fd);
+        *fd = -1;
     }
-    node = set->set.s[0]->parent;
-    ly_set_free(set);
+    return rc;
+}
 
-    while (NULL != node) {
-        if (NULL == node->parent && LYS_AUGMENT == node->nodetype) {
-            node = ((struct lys_node_augment *) node)->target;
-            continue;
-        }
-        struct lys_node *n = NULL;
-        if ((LYS_LIST | LYS_CONTAINER) & node->nodetype) {
-            /* enable mandatory leaves */
-            n = node->child;
-            while (NULL != n) {
-                if ((LYS_LEAF | LYS_LEAFLIST) & n->nodetype &&
-                        LYS_MAND_MASK & n->flags) {
-                    rc = dm_copy_instances_of_the_sch_node(startup_info, candidate_info, n);
-                    CHECK_RC_LOG_RETURN(rc, "Copying of instances of sch node '%s' failed", n->name);
-                }
-                n = n->next;
-            }
+/**
+ * @brief Opens the checkpoint file of the slot and reads its header.
+ * @param [in] dm_ctx
+ * @param [in] slot
+ * @param [out] hdr
+ * @param [out] fd Opened file positioned at the first entry, can be NULL if only the header is needed
+ * @return Error code (SR_ERR_OK on success), SR_ERR_NOT_FOUND if there is no valid checkpoint in the slot
+ */
+static int
+dm_checkpoint_open(dm_ctx_t *dm_ctx, uint64_t slot, dm_checkpoint_hdr_t *hdr, int *fd)
+{
+    char name[PATH_MAX] = {0};
+    char *file_name = NULL;
+    struct stat st = {0};
+    int file_fd = -1;
+    int rc = SR_ERR_OK;
+
+    snprintf(name, PATH_MAX, DM_CHECKPOINT_FILENAME_FMT, slot);
+    rc = sr_path_join(dm_ctx->internal_data_search_dir, name, &file_name);
+    CHECK_RC_MSG_RETURN(rc, "Unable to compose the checkpoint file name.");
+
+    file_fd = open(file_name, O_RDONLY);
+    if (-1 == file_fd) {
+        free(file_name);
+        return SR_ERR_NOT_FOUND;
+    }
+    if (SR_ERR_OK != dm_read_buf(file_fd, hdr, sizeof *hdr)
+            || DM_CHECKPOINT_MAGIC != hdr->magic || DM_CHECKPOINT_VERSION != hdr->version
+            || -1 == fstat(file_fd, &st) || (uint64_t) st.st_size != sizeof *hdr + hdr->data_size) {
+        SR_LOG_WRN("Ignoring invalid checkpoint file %s", file_name);
+        rc = SR_ERR_NOT_FOUND;
+    }
+    free(file_name);
+
+    if (SR_ERR_OK == rc && NULL != fd) {
+        *fd = file_fd;
+    } else {
+        close(file_fd);
+    }
+    return rc;
+}
+
+/**
+ * @brief Returns the id of the most recent checkpoint, 0 if there is none. Expects the checkpoint lock to be held.
+ */
+static uint64_t
+dm_checkpoint_last_id(dm_ctx_t *dm_ctx)
+{
+    dm_checkpoint_hdr_t hdr = {0};
+    uint64_t last_id = 0;
+
+    for (uint64_t slot = 0; slot < SR_CHECKPOINT_COUNT; ++slot) {
+        if (SR_ERR_OK == dm_checkpoint_open(dm_ctx, slot, &hdr, NULL) && hdr.id > last_id) {
+            last_id = hdr.id;
         }
-        node = node->parent;
     }
-
-    return rc;
+    return last_id;
 }
 
 /**
- * @brief Copies a subtree (specified by xpath) of configuration from startup to running. Replaces
- * the previous configuration under the xpath.
- *
- * @param [in] ctx
- * @param [in] session
- * @param [in] module
- * @param [in] xpath
- * @param [in] subscription
- * @return Error code (SR_ERR_OK on success)
+ * @brief Writes the checkpoint into its slot. The checkpoint is written into a temporary file which then
+ * atomically replaces the oldest checkpoint. Expects the checkpoint lock to be held.
  */
 static int
-dm_copy_subtree_startup_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name, dm_schema_info_t *schema_info, const char *xpath, const np_subscription_t *subscription)
+dm_checkpoint_write(dm_ctx_t *dm_ctx, const dm_checkpoint_hdr_t *hdr, const dm_checkpoint_buf_t *buf, const dm_checkpoint_buf_t *moves)
 {
-    CHECK_NULL_ARG5(ctx, session, module_name, schema_info, xpath);
+    char name[PATH_MAX] = {0};
+    char *file_name = NULL, *tmp_file_name = NULL;
+    int fd = -1;
     int rc = SR_ERR_OK;
-    struct ly_set *nodes = NULL;
-    dm_session_t *tmp_session = NULL;
-    dm_data_info_t *startup_info = NULL;
-    dm_data_info_t *candidate_info = NULL;
-    struct lyd_node *node = NULL, *parent = NULL;
-
-    rc = dm_session_start(ctx, session->user_credentials, SR_DS_STARTUP, &tmp_session);
-    CHECK_RC_MSG_RETURN(rc, "Failed to start a temporary session");
 
-    /* select nodes by xpath from startup */
-    rc = dm_get_data_info(ctx, tmp_session, module_name, &startup_info);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Get info for startup config failed");
+    snprintf(name, PATH_MAX, DM_CHECKPOINT_FILENAME_FMT, hdr->id % SR_CHECKPOINT_COUNT);
+    rc = sr_path_join(dm_ctx->internal_data_search_dir, name, &file_name);
+    CHECK_RC_MSG_RETURN(rc, "Unable to compose the checkpoint file name.");
+    rc = sr_asprintf(&tmp_file_name, "%s.tmp", file_name);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to compose the checkpoint file name.");
 
-    if (NULL == startup_info->node) {
-        SR_LOG_DBG("Startup config for module '%s' is empty nothing to copy", module_name);
+    fd = open(tmp_file_name, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (-1 == fd) {
+        SR_LOG_WRN("Unable to create checkpoint %s: %s", tmp_file_name, sr_strerror_safe(errno));
+        rc = SR_ERR_IO;
+        goto cleanup;
     }
 
-    /* switch to candidate */
-    tmp_session->datastore = SR_DS_CANDIDATE;
-    rc = dm_get_data_info(ctx, tmp_session, module_name, &candidate_info);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Get info failed");
-
-    /* remove previous config from running */
-    SR_LOG_DBG("Remove previous content of running configuration under %s.", xpath);
-    rc = rp_dt_delete_item(ctx, tmp_session, xpath, SR_EDIT_DEFAULT, false);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Delete of previous values in running failed xpath %s", xpath);
-
-    /* select a part of configuration to be enabled */
-    rc = rp_dt_find_nodes(ctx, startup_info->node, xpath, false, &nodes);
-    if (SR_ERR_NOT_FOUND == rc) {
-        SR_LOG_DBG("Subtree %s of enabled configuration is empty", xpath);
-        rc = SR_ERR_OK;
+    rc = dm_write_buf(fd, hdr, sizeof *hdr);
+    if (SR_ERR_OK == rc) {
+        rc = dm_write_buf(fd, buf->data, buf->size);
     }
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Find nodes for configuration to be enabled failed");
-    candidate_info->modified = true;
-
-    /* insert selected nodes */
-    for (unsigned i = 0; NULL != nodes && i < nodes->number; i++) {
-        node = nodes->set.d[i];
-        if ((LYS_LEAF | LYS_LEAFLIST) & node->schema->nodetype) {
-            char *node_xpath = lyd_path(node);
-            CHECK_NULL_NOMEM_GOTO(node_xpath, rc, cleanup);
-            dm_lyd_new_path(candidate_info, node_xpath,
-                    ((struct lyd_node_leaf_list *) node)->value_str, LYD_PATH_OPT_UPDATE);
-            free(node_xpath);
-        } else {
-            /* list or container */
-            if (NULL != node->parent) {
-                char *parent_xpath = lyd_path(node->parent);
-                dm_lyd_new_path(candidate_info, parent_xpath, NULL, LYD_PATH_OPT_UPDATE);
-                /* create or find parent node */
-                rc = rp_dt_find_node(ctx, candidate_info->node, parent_xpath, false, &parent);
-                free(parent_xpath);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to find parent node");
-            }
-            /* unlink data tree from session */
-            sr_lyd_unlink(startup_info, node);
-
-            /* attach to parent */
-            if (NULL != parent) {
-                if (0 != lyd_insert(parent, node)) {
-                    SR_LOG_ERR_MSG("Node insert failed");
-                    lyd_free_withsiblings(node);
-                }
-            } else {
-                rc = sr_lyd_insert_after(candidate_info, candidate_info->node, node);
-                if (SR_ERR_OK != rc) {
-                    lyd_free_withsiblings(node);
-                    SR_LOG_ERR_MSG("Node insert failed");
-                }
-            }
-        }
+    if (SR_ERR_OK == rc) {
+        rc = dm_write_buf(fd, moves->data, moves->size);
     }
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Unable to write checkpoint %s", tmp_file_name);
 
-    /* copy mandatory nodes that were enabled automatically */
-    rc = dm_copy_mandatory_for_subtree(ctx, xpath, startup_info, candidate_info);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to copy mandatory nodes for subtree");
-
-    /* swap candidate and startup data info nodes so we can do the copy from SR_DS_STARTUP
-     * otherwise validation will get messed up since all startup config has not necessarily been
-     * loaded yet
-     */
-    node = startup_info->node;
-    startup_info->node = candidate_info->node;
-    candidate_info->node = node;
-    tmp_session->datastore = SR_DS_STARTUP;
-
-    /* copy module startup -> running */
-    rc = dm_copy_module(ctx, tmp_session, module_name, SR_DS_STARTUP, SR_DS_RUNNING, subscription, 0, NULL, NULL);
+    if (0 != rename(tmp_file_name, file_name)) {
+        SR_LOG_WRN("Unable to replace checkpoint %s: %s", file_name, sr_strerror_safe(errno));
+        rc = SR_ERR_IO;
+        goto cleanup;
+    }
+    SR_LOG_DBG("Checkpoint %" PRIu64 " with %" PRIu64 " change(s) written into %s.", hdr->id, hdr->entry_cnt, file_name);
 
 cleanup:
-    ly_set_free(nodes);
-    dm_session_stop(ctx, tmp_session);
-
+    if (-1 != fd) {
+        close(fd);
+        if (SR_ERR_OK != rc) {
+            unlink(tmp_file_name);
+        }
+    }
+    free(tmp_file_name);
+    free(file_name);
     return rc;
 }
 
-int
-dm_enable_module_subtree_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name, const char *xpath,
-        const np_subscription_t *subscription)
+/**
+ * @brief Returns the changes of the module made by the commit. The diff list obtained by the earlier
+ * phases of the commit (NACM check, verify notifications) is reused, otherwise it is computed once
+ * and kept in the commit context.
+ */
+static int
+dm_commit_get_difflist(dm_commit_context_t *c_ctx, const dm_data_info_t *prev_info, const dm_data_info_t *commit_info,
+        const struct lyd_difflist **diff)
 {
-    CHECK_NULL_ARG3(ctx, module_name, xpath); /* session can be NULL */
-    dm_schema_info_t *si = NULL;
+    dm_module_difflist_t lookup_difflist = {0}, *module_difflist = NULL;
+    dm_model_subscription_t lookup_ms = {0}, *ms = NULL;
     int rc = SR_ERR_OK;
 
-    rc = dm_get_module_and_lockw(ctx, module_name, &si);
-    CHECK_RC_LOG_RETURN(rc, "Lock schema %s for write failed", module_name);
-
-    rc = rp_dt_enable_xpath(ctx, session, si, xpath);
-    pthread_rwlock_unlock(&si->model_lock);
-    CHECK_RC_LOG_RETURN(rc, "Enabling of xpath %s failed", xpath);
+    lookup_difflist.schema_info = prev_info->schema;
+    module_difflist = sr_btree_search(c_ctx->difflists, &lookup_difflist);
+    if (NULL != module_difflist && NULL != module_difflist->difflist) {
+        *diff = module_difflist->difflist;
+        return SR_ERR_OK;
+    }
 
-    rc = dm_copy_subtree_startup_running(ctx, session, module_name, si, xpath, subscription);
+    /* the verify phase moves the diff list to the subscriptions of the module */
+    lookup_ms.schema_info = prev_info->schema;
+    ms = sr_btree_search(c_ctx->subscriptions, &lookup_ms);
+    if (NULL != ms && NULL != ms->difflist) {
+        *diff = ms->difflist;
+        return SR_ERR_OK;
+    }
 
+    if (NULL == module_difflist) {
+        module_difflist = calloc(1, sizeof *module_difflist);
+        CHECK_NULL_NOMEM_RETURN(module_difflist);
+        module_difflist->schema_info = prev_info->schema;
+        rc = sr_btree_insert(c_ctx->difflists, module_difflist);
+        if (SR_ERR_OK != rc) {
+            free(module_difflist);
+            SR_LOG_ERR("Failed to insert diff-list for module %s into the binary tree", prev_info->schema->module->name);
+            return rc;
+        }
+    }
+    module_difflist->difflist = lyd_diff(prev_info->node, commit_info->node, LYD_DIFFOPT_WITHDEFAULTS);
+    if (NULL == module_difflist->difflist) {
+        SR_LOG_ERR("Lyd diff failed for module %s", prev_info->schema->module->name);
+        return SR_ERR_INTERNAL;
+    }
+    *diff = module_difflist->difflist;
     return rc;
 }
 
 int
-dm_disable_module_running(dm_ctx_t *ctx, dm_session_t *session, const char *module_name)
+dm_checkpoint_save(dm_ctx_t *dm_ctx, dm_session_t *session, dm_commit_context_t *c_ctx)
 {
-    CHECK_NULL_ARG2(ctx, module_name);
+    CHECK_NULL_ARG5(dm_ctx, session, c_ctx, c_ctx->prev_data_trees, c_ctx->difflists);
+    dm_checkpoint_buf_t buf = {0}, moves = {0};
+    dm_checkpoint_hdr_t hdr = {0};
+    dm_data_info_t *info = NULL, *prev_info = NULL, *commit_info = NULL, lookup_info = {0};
+    const struct lyd_difflist *diff = NULL;
+    size_t i = 0;
+    int lock_fd = -1;
     int rc = SR_ERR_OK;
-    dm_schema_info_t *schema_info = NULL;
 
-    rc = dm_get_module_and_lockw(ctx, module_name, &schema_info);
-    CHECK_RC_LOG_RETURN(rc, "Get module failed for module %s", module_name);
+    if (0 == SR_CHECKPOINT_COUNT) {
+        return SR_ERR_OK;
+    }
 
-    struct lys_node *iter = NULL, *child;
-    sr_list_t *stack = NULL;
-    rc = sr_list_init(&stack);
-    CHECK_RC_MSG_RETURN(rc, "List init failed");
+    while (NULL != (info = sr_btree_get_at(session->session_modules[session->datastore], i++))) {
+        if (!info->modified) {
+            continue;
+        }
+        lookup_info.schema = info->schema;
+        prev_info = sr_btree_search(c_ctx->prev_data_trees, &lookup_info);
+        commit_info = sr_btree_search(c_ctx->session->session_modules[c_ctx->session->datastore], &lookup_info);
+        if (NULL == prev_info || NULL == commit_info) {
+            SR_LOG_ERR("Data trees of module %s not found", info->schema->module->name);
+            rc = SR_ERR_INTERNAL;
+            goto cleanup;
+        }
 
-    /* iterate through top-level nodes */
-    while ((iter = (struct lys_node *)lys_getnext(iter, NULL, schema_info->module, 0))) {
-        if (dm_is_node_enabled(iter)) {
-            rc = dm_set_node_state(iter, DM_NODE_DISABLED);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "Set node state failed");
+        rc = dm_commit_get_difflist(c_ctx, prev_info, commit_info, &diff);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Changes of module %s could not be obtained", info->schema->module->name);
+        rc = dm_checkpoint_add_diff(&buf, &moves, diff);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Recording of the changes in module %s failed", info->schema->module->name);
+    }
 
-            child = NULL;
-            while ((child = (struct lys_node *)lys_getnext(child, iter, NULL, 0))) {
-                if (dm_is_node_enabled(child)) {
-                    rc = sr_list_add(stack, child);
-                    CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
-                }
-            }
-        }
+    if (0 == buf.entry_cnt + moves.entry_cnt) {
+        SR_LOG_DBG_MSG("No changes to be recorded in a checkpoint.");
+        goto cleanup;
     }
 
-    /* recursively disable all enabled children*/
-    while (stack->count != 0) {
-        iter = stack->data[stack->count - 1];
-        rc = dm_set_node_state(iter, DM_NODE_DISABLED);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Set node state failed");
+    rc = dm_checkpoint_lock(dm_ctx, true, &lock_fd);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to lock the checkpoints");
 
-        sr_list_rm_at(stack, stack->count - 1);
+    hdr.magic = DM_CHECKPOINT_MAGIC;
+    hdr.version = DM_CHECKPOINT_VERSION;
+    hdr.id = dm_checkpoint_last_id(dm_ctx) + 1;
+    hdr.entry_cnt = buf.entry_cnt + moves.entry_cnt;
+    hdr.data_size = buf.size + moves.size;
+
+    rc = dm_checkpoint_write(dm_ctx, &hdr, &buf, &moves);
 
-        child = NULL;
-        while ((child = (struct lys_node *)lys_getnext(child, iter, NULL, 0))) {
-            if (dm_is_node_enabled(child)) {
-                rc = sr_list_add(stack, child);
-                CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
-            }
-        }
-    }
 cleanup:
-    pthread_rwlock_unlock(&schema_info->model_lock);
-    sr_list_cleanup(stack);
+    if (-1 != lock_fd) {
+        close(lock_fd);
+    }
+    sr_list_cleanup(moves.lists);
+    free(moves.data);
+    free(buf.data);
+    return rc;
+}
+
+/**
+ * @brief Applies the entries of the checkpoint on the data trees of the session.
+ */
+static int
+dm_checkpoint_apply(dm_ctx_t *dm_ctx, dm_session_t *session, const dm_checkpoint_hdr_t *hdr, const char *data)
+{
+    dm_checkpoint_entry_t entry = {0};
+    const char *xpath = NULL, *value = NULL;
+    size_t offset = 0;
+    int rc = SR_ERR_OK;
+
+    for (uint64_t i = 0; i < hdr->entry_cnt; ++i) {
+        if (offset + sizeof entry > hdr->data_size) {
+            goto corrupted;
+        }
+        memcpy(&entry, data + offset, sizeof entry);
+        offset += sizeof entry;
+        if (0 == entry.xpath_size || offset + entry.xpath_size + entry.value_size > hdr->data_size) {
+            goto corrupted;
+        }
+        xpath = data + offset;
+        offset += entry.xpath_size;
+        value = 0 != entry.value_size ? data + offset : NULL;
+        offset += entry.value_size;
+        if ('\0' != xpath[entry.xpath_size - 1] || (NULL != value && '\0' != value[entry.value_size - 1])) {
+            goto corrupted;
+        }
 
+        switch (entry.op) {
+        case DM_CHECKPOINT_SET:
+            rc = rp_dt_set_item(dm_ctx, session, xpath, SR_EDIT_DEFAULT, NULL, value, false);
+            break;
+        case DM_CHECKPOINT_DELETE:
+            rc = rp_dt_delete_item(dm_ctx, session, xpath, SR_EDIT_DEFAULT, false);
+            break;
+        case DM_CHECKPOINT_MOVE:
+            rc = rp_dt_move_list(dm_ctx, session, xpath, NULL != value ? SR_MOVE_AFTER : SR_MOVE_FIRST, value);
+            break;
+        default:
+            goto corrupted;
+        }
+        CHECK_RC_LOG_RETURN(rc, "Rolling back of %s failed", xpath);
+    }
     return rc;
+
+corrupted:
+    SR_LOG_ERR("Checkpoint %" PRIu64 " is corrupted", hdr->id);
+    return SR_ERR_INTERNAL;
 }
 
 int
-dm_copy_module(dm_ctx_t *dm_ctx, dm_session_t *session, const char *module_name, sr_datastore_t src, sr_datastore_t dst,
-        const np_subscription_t *subscription, bool nacm_on, sr_error_info_t **errors, size_t *err_cnt)
+dm_checkpoint_load(dm_ctx_t *dm_ctx, dm_session_t *session, uint32_t count)
 {
-    CHECK_NULL_ARG2(dm_ctx, module_name);
-    sr_list_t *module_list = NULL;
-    dm_schema_info_t *schema_info = NULL;
+    CHECK_NULL_ARG2(dm_ctx, session);
+    dm_checkpoint_hdr_t hdr = {0};
+    uint64_t last_id = 0;
+    char *data = NULL;
+    int lock_fd = -1, fd = -1;
     int rc = SR_ERR_OK;
-    bool enabled = false;
 
-    /* the module must be enabled */
-    rc = dm_has_enabled_subtree(dm_ctx, module_name, NULL, &enabled);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Has enabled subtree failed %s", module_name);
-    if (!enabled) {
-        SR_LOG_ERR("Cannot copy module '%s', it is not enabled.", module_name);
-        rc = SR_ERR_OPERATION_FAILED;
-        goto cleanup;
+    if (0 == count || count > SR_CHECKPOINT_COUNT) {
+        SR_LOG_ERR("Only up to %d commit(s) can be rolled back", SR_CHECKPOINT_COUNT);
+        return SR_ERR_INVAL_ARG;
     }
 
-    rc = sr_list_init(&module_list);
-    CHECK_RC_MSG_RETURN(rc, "List init failed");
+    rc = dm_checkpoint_lock(dm_ctx, false, &lock_fd);
+    CHECK_RC_MSG_RETURN(rc, "Unable to lock the checkpoints");
 
-    rc = dm_get_module_without_lock(dm_ctx, module_name, &schema_info);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "dm_get_module failed");
+    last_id = dm_checkpoint_last_id(dm_ctx);
+    if (last_id < count) {
+        SR_LOG_ERR("Only %" PRIu64 " commit(s) can be rolled back", last_id);
+        rc = SR_ERR_NOT_FOUND;
+        goto cleanup;
+    }
 
-    rc = sr_list_add(module_list, (void *) module_name);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Adding to sr_list failed");
+    /* the most recent commit is reverted first */
+    for (uint64_t id = last_id; id > last_id - count; --id) {
+        rc = dm_checkpoint_open(dm_ctx, id % SR_CHECKPOINT_COUNT, &hdr, &fd);
+        if (SR_ERR_OK == rc && id != hdr.id) {
+            rc = SR_ERR_NOT_FOUND;
+        }
+        if (SR_ERR_OK != rc) {
+            SR_LOG_ERR("Checkpoint %" PRIu64 " is not available", id);
+            rc = SR_ERR_NOT_FOUND;
+            goto cleanup;
+        }
 
-    rc = dm_copy_config(dm_ctx, session, module_list, src, dst, subscription, nacm_on, errors, err_cnt);
-    CHECK_RC_MSG_GOTO(rc, cleanup, "Dm copy config failed");
+        data = malloc(hdr.data_size);
+        CHECK_NULL_NOMEM_GOTO(data, rc, cleanup);
+        rc = dm_read_buf(fd, data, hdr.data_size);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Reading of checkpoint %" PRIu64 " failed", id);
+        close(fd);
+        fd = -1;
+
+        rc = dm_checkpoint_apply(dm_ctx, session, &hdr, data);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Applying of checkpoint %" PRIu64 " failed", id);
+        free(data);
+        data = NULL;
+    }
 
 cleanup:
-    sr_list_cleanup(module_list);
+    if (-1 != fd) {
+        close(fd);
+    }
+    if (-1 != lock_fd) {
+        close(lock_fd);
+    }
+    free(data);
     return rc;
 }
 
@@ -6565,7 +9683,7 @@ dm_validate_procedure_content(rp_ctx_t *rp_ctx, rp_session_t *session, dm_data_i
             /* retrieve all required data */
             for (size_t i = 0; i < required_data->count; i++) {
                 SR_LOG_DBG("To pass the validation of '%s' data from module %s is needed", di->schema->module_name, (char *)required_data->data[i]);
-                rc = dm_get_data_info_internal(rp_ctx->dm_ctx, session->dm_session, (char *)required_data->data[i], true, &should_be_freed[i], &dep_di);
+                rc = dm_get_data_info_internal(rp_ctx->dm_ctx, session->dm_session, (char *)required_data->data[i], true, false, &should_be_freed[i], &dep_di);
                 CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to get data info for module %s", (char *)required_data->data[i]);
 
                 rc = sr_list_add(data_for_validation, dep_di);
@@ -7039,10 +10157,7 @@ dm_copy_modified_session_trees(dm_ctx_t *dm_ctx, dm_session_t *from, dm_session_
         }
 
         if (!existed) {
-            pthread_mutex_lock(&info->schema->usage_count_mutex);
-            info->schema->usage_count++;
-            SR_LOG_DBG("Usage count %s deccremented (value=%zu)", info->schema->module_name, info->schema->usage_count);
-            pthread_mutex_unlock(&info->schema->usage_count_mutex);
+            dm_data_info_use_schema(new_info, info->schema);
 
             rc = sr_btree_insert(to->session_modules[to->datastore], new_info);
             CHECK_RC_MSG_GOTO(rc, fail, "Adding data tree to session modules failed");
@@ -7100,10 +10215,7 @@ dm_copy_session_tree(dm_ctx_t *dm_ctx, dm_session_t *from, dm_session_t *to, con
     }
 
     if (!existed) {
-        pthread_mutex_lock(&info->schema->usage_count_mutex);
-        info->schema->usage_count++;
-        SR_LOG_DBG("Usage count %s decremented (value=%zu)", info->schema->module_name, info->schema->usage_count);
-        pthread_mutex_unlock(&info->schema->usage_count_mutex);
+        dm_data_info_use_schema(new_info, info->schema);
         if (SR_ERR_OK == rc) {
             rc = sr_btree_insert(to->session_modules[to->datastore], new_info);
         } else {
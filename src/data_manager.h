@@ -61,6 +61,15 @@ typedef struct dm_c_ctxs_s {
 /** defined in data_manager.c */
 typedef struct dm_tmp_ly_ctx_s dm_tmp_ly_ctx_t;
 
+/** defined in data_manager.c */
+typedef struct dm_shared_ly_ctx_s dm_shared_ly_ctx_t;
+
+/** defined in data_manager.c */
+typedef struct dm_rdonly_tree_s dm_rdonly_tree_t;
+
+/** defined below */
+typedef struct dm_dp_index_s dm_dp_index_t;
+
 /**
  * @brief Data manager context holding loaded schemas, data trees
  * and corresponding locks
@@ -74,6 +83,7 @@ typedef struct dm_ctx_s {
     cm_connection_mode_t conn_mode;  /**< Mode in which Connection Manager operates */
     char *schema_search_dir;      /**< location where schema files are located */
     char *data_search_dir;        /**< location where data files are located */
+    char *internal_data_search_dir; /**< location where internal data files are located (warm image, checkpoints) */
     sr_locking_set_t *locking_ctx;/**< lock context for lock/unlock/commit operations */
     bool *ds_lock;                /**< Flags if the ds lock is hold by a session*/
     pthread_mutex_t ds_lock_mutex;/**< Data store lock mutex */
@@ -83,6 +93,11 @@ typedef struct dm_ctx_s {
     struct timespec last_commit_time;  /**< Time of the last commit */
     dm_tmp_ly_ctx_t *tmp_ly_ctx;  /**< Structure wrapping libyang context that is used to validate/print/parse date
                                    * where the set of required yang module can vary */
+    dm_shared_ly_ctx_t *shared_ly_ctx; /**< Current epoch of the libyang context shared by all schema infos
+                                   * (used only if SHARED_LY_CTX is defined), guarded by schema_tree_lock */
+    sr_btree_t *coalesced_commits;/**< Changes of recent commits waiting to be notified to coalescing subscribers, per module */
+    pthread_mutex_t coalesce_lock;/**< Mutex guarding coalesced_commits */
+    size_t data_load_threads;     /**< Number of threads used to load the data files of multiple modules at once */
 
 } dm_ctx_t;
 
@@ -110,6 +125,12 @@ typedef struct dm_schema_info_s {
                                          * Can be NULL if module has been uninstalled
                                          * during sysrepo-engine lifetime */
     const struct lys_module *module;    /**< Pointer to the module, might be NULL if module has been uninstalled*/
+    dm_shared_ly_ctx_t *shared_ly_ctx;  /**< Epoch of the shared context ly_ctx belongs to, NULL if the schema info
+                                         * owns its ly_ctx */
+    dm_rdonly_tree_t *rdonly_trees[DM_DATASTORE_COUNT]; /**< Cached read-only data trees per datastore, updated under
+                                         * read lock of the model_lock and usage_count_mutex, dropped under write lock */
+    dm_dp_index_t *dp_index;            /**< Cached index of the data provider subscriptions of the module, replaced under
+                                         * usage_count_mutex, dropped under write lock of the model_lock */
     bool cross_module_data_dependency;  /**< Flag whether data from different module is needed for validation */
     bool has_instance_id;               /**< Flag whether the module contains a node of type instance identifier */
     bool can_not_be_locked;             /**< If true module contains no data and lock_module for the module is NOP */
@@ -125,6 +146,9 @@ typedef struct dm_data_info_s{
     struct timespec timestamp;          /**< timestamp of this copy (used only if HAVE_ST_MTIM is defined) */
     bool modified;                      /**< flag denoting whether a change has been made*/
     sr_list_t *required_modules;        /**< schemas that needs to be in context to print data */
+    dm_rdonly_tree_t *rdonly_tree;      /**< read-only tree the node is borrowed from, NULL if the node is owned */
+    dm_shared_ly_ctx_t *shared_ly_ctx;  /**< reference to the epoch of the shared libyang context the node belongs to
+                                             (NULL if the schema has its own context) */
 }dm_data_info_t;
 
 /**
@@ -143,6 +167,7 @@ typedef enum dm_operation_e {
     DM_SET_OP,
     DM_DELETE_OP,
     DM_MOVE_OP,
+    DM_SET_TREE_OP,
 } dm_operation_t;
 
 /**
@@ -182,9 +207,36 @@ typedef struct dm_sess_op_s{
             sr_move_position_t position; /**< Position */
             char *relative_item;         /**< Xpath of item used for relative moves*/
         }mov;
+        struct tree{
+            char *data;                  /**< Data tree of the module in XML format */
+            bool merge;                  /**< Merge the data instead of replacing the data of the module */
+        }tree;
     }detail;
 }dm_sess_op_t;
 
+/**
+ * @brief Entry of an index of items (subscriptions, changes) by schema nodes
+ */
+typedef struct dm_node_index_entry_s {
+    const struct lys_node *node;        /**< schema node the items are tied to, key of the entry */
+    size_t *items;                      /**< indices of the items tied to the node, in the order of insertion */
+    size_t item_cnt;                    /**< number of items */
+    size_t *desc_items;                 /**< indices of the items tied to a descendant of the node */
+    size_t desc_item_cnt;               /**< number of items tied to descendants */
+} dm_node_index_entry_t;
+
+/**
+ * @brief Index of the data provider subscriptions of a module by their schema nodes.
+ * The index is shared by the requests loading state data and must not be modified.
+ */
+typedef struct dm_dp_index_s {
+    sr_list_t *subscriptions;           /**< data provider subscriptions (copies of np subscriptions) */
+    sr_list_t *nodes;                   /**< schema nodes corresponding to the subscriptions */
+    sr_btree_t *nodes_index;            /**< indices of the subscriptions by their schema nodes and by the ancestors of
+                                         * the nodes (::dm_node_index_entry_t) */
+    ATOMIC_UINT32_T ref_count;          /**< number of requests using the index, +1 if it is cached in the schema info */
+} dm_dp_index_t;
+
 /**
  * @brief Holds subscriptions for the particular model
  * used in commit context
@@ -193,8 +245,11 @@ typedef struct dm_model_subscription_s {
     dm_schema_info_t *schema_info;      /**< schema info identifying the module to which the subscriptions are tied to */
     sr_list_t *subscriptions;           /**< list of struct received from np */
     struct lys_node **nodes;            /**< array of schema nodes corresponding to the subscription */
+    sr_btree_t *nodes_index;            /**< indices of the subscriptions by their schema nodes (::dm_node_index_entry_t) */
+    bool *matched;                      /**< per-subscription flag whether the diff list matches it, evaluated on first use */
     struct lyd_difflist *difflist;      /**< diff list */
     sr_list_t *changes;                 /**< set of changes for the model */
+    sr_btree_t *changes_index;          /**< positions of the changes by the schema nodes selecting them (::dm_node_index_entry_t) */
     bool changes_generated;             /**< Flag signalizing that changes has been generated */
     pthread_rwlock_t changes_lock;      /**< Lock guarding the changes member of structure */
 }dm_model_subscription_t;
@@ -303,6 +358,26 @@ int dm_init(ac_ctx_t *ac_ctx, np_ctx_t *np_ctx, pm_ctx_t *pm_ctx, cm_connection_
  */
 void dm_cleanup(dm_ctx_t *dm_ctx);
 
+/**
+ * @brief Sets the number of threads used to load the data files of multiple modules at once
+ * (SR_DATA_LOAD_THREADS by default). Value 1 disables the parallel loading.
+ * @param [in] dm_ctx
+ * @param [in] thread_cnt
+ */
+void dm_set_data_load_threads(dm_ctx_t *dm_ctx, size_t thread_cnt);
+
+/**
+ * @brief Loads running data of all modules that have running datastore enabled by some subscription and
+ * keeps them cached, so that the first requests do not need to parse them. Data files of modules
+ * without cross-module data dependencies are parsed and validated in parallel, the other
+ * modules are left for on-demand loading. Data trees stored in the warm image by the previous startup
+ * are taken from it without parsing if none of the schema, data and persist files has changed, the image
+ * is rewritten whenever some data had to be parsed. Failures to load the data are only logged.
+ * @param [in] dm_ctx
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_load_running_enabled_data(dm_ctx_t *dm_ctx);
+
 /**
  * @brief Allocates resources for the session in Data manger.
  * @param [in] dm_ctx
@@ -379,7 +454,8 @@ int dm_get_module_and_lockw(dm_ctx_t *dm_ctx, const char *module_name, dm_schema
 /**
  * @brief Retrieves schema info using ::dm_get_module_and_lock. Lock is released. Function can be used to verify
  * that module existed during function execution. To use schema_info afterward, lock must be acquired
- * using ::dm_lock_schema_info or ::dm_lock_schema_info_write.
+ * using ::dm_lock_schema_info or ::dm_lock_schema_info_write, or the libyang context must be
+ * referenced using ::dm_schema_info_ctx_acquire.
  *
  * @note Function acquires and releases read lock for the schema info.
  *
@@ -390,6 +466,25 @@ int dm_get_module_and_lockw(dm_ctx_t *dm_ctx, const char *module_name, dm_schema
  */
 int dm_get_module_without_lock(dm_ctx_t *dm_ctx, const char *module_name, dm_schema_info_t **schema_info);
 
+/**
+ * @brief Takes a reference to the epoch of the shared libyang context the schema info
+ * is currently bound to. Schema nodes of the module obtained while the reference is held
+ * stay valid even if the schema info is moved to a newer epoch meanwhile. Intended for
+ * readers that do not hold the model lock (e.g. after ::dm_get_module_without_lock).
+ *
+ * @param [in] schema_info
+ * @return Referenced epoch, to be released by ::dm_schema_info_ctx_release. NULL if the schema
+ * info has its own libyang context (SHARED_LY_CTX not defined).
+ */
+dm_shared_ly_ctx_t *dm_schema_info_ctx_acquire(dm_schema_info_t *schema_info);
+
+/**
+ * @brief Releases the reference acquired by ::dm_schema_info_ctx_acquire.
+ *
+ * @param [in] shared_ctx Referenced epoch (can be NULL).
+ */
+void dm_schema_info_ctx_release(dm_shared_ly_ctx_t *shared_ctx);
+
 /**
  * @brief Returns an array that contains information about schemas supported by sysrepo.
  * @param [in] dm_ctx
@@ -552,6 +647,60 @@ int dm_commit_notify(dm_ctx_t *dm_ctx, dm_session_t *session, sr_notif_event_t e
  */
 void dm_free_commit_context(void *commit_ctx);
 
+/**
+ * @brief Allocates an empty index of items by schema nodes.
+ * @param [out] index
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_node_index_init(sr_btree_t **index);
+
+/**
+ * @brief Adds an item into the index entry of the schema node. The entry is created if it does not exist.
+ * @param [in] index
+ * @param [in] node - schema node, NULL is a valid key
+ * @param [in] item - index of the item
+ * @param [in] descendant - add the item among the items tied to a descendant of the node
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_node_index_add(sr_btree_t *index, const struct lys_node *node, size_t item, bool descendant);
+
+/**
+ * @brief Looks up the index entry of the schema node.
+ * @param [in] index
+ * @param [in] node
+ * @return The entry, NULL if there are no items tied to the node.
+ */
+dm_node_index_entry_t *dm_node_index_get(sr_btree_t *index, const struct lys_node *node);
+
+/**
+ * @brief Provides the index of the data provider subscriptions of the module. The index cached
+ * in the schema info is reused if it has been built from the same subscriptions, otherwise
+ * a new index is built and cached.
+ *
+ * @note Function expects that the schema info can not be uninstalled (data of the module is in use).
+ *
+ * @param [in] dm_ctx
+ * @param [in] schema_info
+ * @param [in] subscriptions - data provider subscriptions of the module acquired from np
+ * @param [out] dp_index - release by ::dm_dp_index_release
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_get_dp_index(dm_ctx_t *dm_ctx, dm_schema_info_t *schema_info, sr_list_t *subscriptions, dm_dp_index_t **dp_index);
+
+/**
+ * @brief Releases a reference to the data provider subscription index.
+ * @param [in] dp_index
+ */
+void dm_dp_index_release(dm_dp_index_t *dp_index);
+
+/**
+ * @brief Drops the data provider subscription index cached for the module, called
+ * when a data provider subscribes or unsubscribes.
+ * @param [in] dm_ctx
+ * @param [in] module_name
+ */
+void dm_dp_index_invalidate(dm_ctx_t *dm_ctx, const char *module_name);
+
 /**
  * @brief Logs add operation into session operation list. The operation list is used
  * during the commit. Passed allocated arguments are freed in case of error also.
@@ -585,6 +734,17 @@ int dm_add_del_operation(dm_session_t *session, const char *xpath, sr_edit_optio
  */
 int dm_add_move_operation(dm_session_t *session, const char *xpath, sr_move_position_t pos, const char *rel_item);
 
+/**
+ * @brief Logs set tree operation into session operation list. The operation list is used
+ * during the commit. Passed allocated arguments are freed in case of error also.
+ * @param [in] session
+ * @param [in] xpath xpath matching all the nodes of the module (/module:*)
+ * @param [in] data - must be allocated, will be freed with operation list
+ * @param [in] merge
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_add_set_tree_operation(dm_session_t *session, const char *xpath, char *data, bool merge);
+
 /**
  * @brief Removes last logged operation in session
  * @param [in] session
@@ -872,6 +1032,50 @@ int dm_copy_module(dm_ctx_t *dm_ctx, dm_session_t *session, const char *module_n
 int dm_copy_all_models(dm_ctx_t *dm_ctx, dm_session_t *session, sr_datastore_t src, sr_datastore_t dst, bool nacm_on,
                        sr_error_info_t **errors, size_t *err_cnt);
 
+/**
+ * @brief Saves copies of the data trees in the state before the commit into the snapshot.
+ * Modules already present in the snapshot are kept untouched, so that the snapshot
+ * holds the state before the first of consecutive commits.
+ * @param [in] dm_ctx
+ * @param [in] c_ctx Commit context with the previous data trees loaded
+ * @param [in,out] snapshot Binary tree of data infos, allocated if NULL
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_commit_save_snapshot(dm_ctx_t *dm_ctx, const dm_commit_context_t *c_ctx, sr_btree_t **snapshot);
+
+/**
+ * @brief Replaces the data trees of the session's current datastore with copies of
+ * the trees saved in the snapshot and marks them as modified.
+ * @param [in] dm_ctx
+ * @param [in] session
+ * @param [in] snapshot Snapshot filled by ::dm_commit_save_snapshot
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_restore_snapshot(dm_ctx_t *dm_ctx, dm_session_t *session, sr_btree_t *snapshot);
+
+/**
+ * @brief Stores the inverse of the changes made by a commit to running datastore as the newest rollback
+ * checkpoint. Only the changed nodes are stored, the oldest checkpoint is overwritten once there are
+ * ::SR_CHECKPOINT_COUNT of them. Must be called after the data have been written.
+ * @param [in] dm_ctx
+ * @param [in] session Session whose modified data trees have been committed
+ * @param [in] c_ctx Commit context with the previous data trees loaded, the diff lists of the commit are reused
+ * (and kept in the context if they need to be computed)
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_checkpoint_save(dm_ctx_t *dm_ctx, dm_session_t *session, dm_commit_context_t *c_ctx);
+
+/**
+ * @brief Applies the inverse changes of the \p count most recent commits to running datastore
+ * on the data trees of the session's current datastore, starting with the most recent commit.
+ * @param [in] dm_ctx
+ * @param [in] session
+ * @param [in] count Number of commits to be rolled back
+ * @return Error code (SR_ERR_OK on success), SR_ERR_INVAL_ARG if more commits than ::SR_CHECKPOINT_COUNT are requested,
+ * SR_ERR_NOT_FOUND if not enough checkpoints are available
+ */
+int dm_checkpoint_load(dm_ctx_t *dm_ctx, dm_session_t *session, uint32_t count);
+
 /**
  * @brief Validates content of a RPC request or reply.
  * @param [in] rp_ctx RP context.
@@ -1111,6 +1315,16 @@ int dm_is_model_modified(dm_ctx_t *dm_ctx, dm_session_t *session, const char *mo
  */
 int dm_commit_notifications_complete(dm_ctx_t *dm_ctx, uint32_t c_ctx_id);
 
+/**
+ * @brief Sends one apply notification with the net changes of all commits of the module
+ * merged since the last call to the coalescing subscribers. Called once the coalescing window
+ * of the module has elapsed.
+ * @param [in] dm_ctx
+ * @param [in] module_name
+ * @return Error code (SR_ERR_OK on success)
+ */
+int dm_commit_coalesce_flush(dm_ctx_t *dm_ctx, const char *module_name);
+
 /**
  * @brief Looks up commit context identified by id
  * @param [in] dm_ctx
@@ -1030,6 +1030,7 @@ np_notification_subscribe(np_ctx_t *np_ctx, const rp_session_t *rp_session, Sr__
     subscription->priority = priority;
     subscription->enable_running = (opts & NP_SUBSCR_ENABLE_RUNNING);
     subscription->enable_nacm = (rp_session->options & SR_SESS_ENABLE_NACM);
+    subscription->coalesce = (opts & NP_SUBSCR_COALESCE);
     subscription->api_variant = api_variant;
 
     if (NULL != xpath) {
@@ -1066,6 +1067,11 @@ np_notification_subscribe(np_ctx_t *np_ctx, const rp_session_t *rp_session, Sr__
                 (opts & NP_SUBSCR_EXCLUSIVE));
         CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to save the subscription into persistent data file.");
 
+        if (SR__SUBSCRIPTION_TYPE__DP_GET_ITEMS_SUBS == type) {
+            /* the data provider index of the module has to be rebuilt */
+            dm_dp_index_invalidate(np_ctx->rp_ctx->dm_ctx, module_name);
+        }
+
         goto cleanup; /* subscription not needed anymore */
     } else {
         /* add the subscription to in-memory subscription list */
@@ -1124,6 +1130,9 @@ np_notification_unsubscribe(np_ctx_t *np_ctx,  const rp_session_t *rp_session, S
         rc = pm_remove_subscription(np_ctx->rp_ctx->pm_ctx, rp_session->user_credentials, module_name,
                 &subscription_lookup, &disable_running);
         if (SR_ERR_OK == rc) {
+            if (SR__SUBSCRIPTION_TYPE__DP_GET_ITEMS_SUBS == notif_type) {
+                dm_dp_index_invalidate(np_ctx->rp_ctx->dm_ctx, module_name);
+            }
             pthread_rwlock_wrlock(&np_ctx->lock);
             rc = np_dst_info_remove(np_ctx, dst_address, module_name);
             pthread_rwlock_unlock(&np_ctx->lock);
@@ -1186,6 +1195,7 @@ np_unsubscribe_destination(np_ctx_t *np_ctx, const char *dst_address)
                     info->subscribed_modules[i], dst_address, &disable_running);
             CHECK_RC_LOG_GOTO(rc, cleanup, "Unable to remove subscriptions for destination '%s' from '%s'.", dst_address,
                     info->subscribed_modules[i]);
+            dm_dp_index_invalidate(np_ctx->rp_ctx->dm_ctx, info->subscribed_modules[i]);
             if (disable_running) {
                 SR_LOG_DBG("Disabling running datastore fo module '%s'.", info->subscribed_modules[i]);
                 rc = dm_disable_module_running(np_ctx->rp_ctx->dm_ctx, NULL, info->subscribed_modules[i]);
@@ -1500,6 +1510,14 @@ np_data_provider_request(np_ctx_t *np_ctx, np_subscription_t *subscription, rp_s
                     CHECK_NULL_NOMEM_ERROR(req->request->data_provide_req->original_xpath, rc);
                 }
                 break;
+            case SR__OPERATION__GET_ITEMS_MULTI:
+                /* xpath of the request currently waiting for the data */
+                if (session->get_items_multi_ctx.index < session->req->request->get_items_multi_req->n_xpaths) {
+                    req->request->data_provide_req->original_xpath =
+                            strdup(session->req->request->get_items_multi_req->xpaths[session->get_items_multi_ctx.index]);
+                    CHECK_NULL_NOMEM_ERROR(req->request->data_provide_req->original_xpath, rc);
+                }
+                break;
             default:
                 break;
             }
@@ -1584,6 +1602,35 @@ np_commit_notifications_sent(np_ctx_t *np_ctx, uint32_t commit_id, bool commit_f
     return rc;
 }
 
+int
+np_commit_coalesce_schedule(np_ctx_t *np_ctx, const char *module_name)
+{
+    Sr__Msg *req = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG3(np_ctx, np_ctx->rp_ctx, module_name);
+
+    rc = sr_gpb_internal_req_alloc(NULL, SR__OPERATION__COMMIT_COALESCE, &req);
+    if (SR_ERR_OK == rc) {
+        req->internal_request->commit_coalesce_req->module_name = strdup(module_name);
+        CHECK_NULL_NOMEM_ERROR(req->internal_request->commit_coalesce_req->module_name, rc);
+    }
+    if (SR_ERR_OK == rc) {
+        req->internal_request->postpone_timeout_ms = SR_COMMIT_COALESCE_WINDOW;
+        req->internal_request->has_postpone_timeout_ms = true;
+        rc = cm_msg_send(np_ctx->rp_ctx->cm_ctx, req);
+        req = NULL;
+    }
+    if (SR_ERR_OK == rc) {
+        SR_LOG_DBG("Coalesced apply notifications of module %s scheduled in %d ms.", module_name, SR_COMMIT_COALESCE_WINDOW);
+    } else {
+        SR_LOG_ERR("Unable to schedule coalesced apply notifications of module %s.", module_name);
+        sr_msg_free(req);
+    }
+
+    return rc;
+}
+
 int
 np_commit_notification_ack(np_ctx_t *np_ctx, uint32_t commit_id, char *subs_xpath, sr_notif_event_t event, int result,
         bool do_not_send_abort, const char *err_msg, const char *err_xpath)
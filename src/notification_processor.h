@@ -55,6 +55,7 @@ typedef struct np_subscription_s {
     uint32_t priority;                 /**< Priority of the subscription by delivering notifications (0 is the lowest priority). */
     bool enable_running;               /**< TRUE if the subscription enables specified subtree in the running datastore. */
     bool enable_nacm;                  /**< TRUE if the NETCONF Access Control is enabled for this subscription. */
+    bool coalesce;                     /**< TRUE if apply notifications of close commits can be merged into one. */
     sr_api_variant_t api_variant;      /**< API variant -- values vs. trees (relevant for the callback type only). */
     ATOMIC_UINT32_T copy_cnt;          /**< Count of other references to the primary structure. 0 means no other copies exist. */
 } np_subscription_t;
@@ -115,6 +116,7 @@ typedef enum np_subscr_flag_e {
     NP_SUBSCR_ENABLE_RUNNING = 1,
     NP_SUBSCR_EXCLUSIVE = 2,
     NP_SUBSCR_EV_EVENT = 4,
+    NP_SUBSCR_COALESCE = 8,
 } np_subscr_flag_t;
 
 /**
@@ -275,6 +277,17 @@ int np_data_provider_request(np_ctx_t *np_ctx, np_subscription_t *subscription,
  */
 int np_commit_notifications_sent(np_ctx_t *np_ctx, uint32_t commit_id,  bool commit_finished, sr_list_t *subscriptions);
 
+/**
+ * @brief Schedules delivery of the coalesced apply notifications of the module
+ * after ::SR_COMMIT_COALESCE_WINDOW milliseconds.
+ *
+ * @param[in] np_ctx Notification Processor context acquired by ::np_init call.
+ * @param[in] module_name Name of the module whose changes are being coalesced.
+ *
+ * @return Error code (SR_ERR_OK on success).
+ */
+int np_commit_coalesce_schedule(np_ctx_t *np_ctx, const char *module_name);
+
 /**
  * @brief Release the commit context related to specified commit ID.
  *
@@ -55,6 +55,7 @@
 #define PM_XPATH_SUBSCRIPTION_PRIORITY        PM_XPATH_SUBSCRIPTION      "/priority"
 #define PM_XPATH_SUBSCRIPTION_ENABLE_RUNNING  PM_XPATH_SUBSCRIPTION      "/enable-running"
 #define PM_XPATH_SUBSCRIPTION_ENABLE_NACM     PM_XPATH_SUBSCRIPTION      "/enable-nacm"
+#define PM_XPATH_SUBSCRIPTION_COALESCE        PM_XPATH_SUBSCRIPTION      "/coalesce"
 #define PM_XPATH_SUBSCRIPTION_API_VARIANT     PM_XPATH_SUBSCRIPTION      "/api-variant"
 
 #define PM_XPATH_SUBSCRIPTIONS_BY_TYPE        PM_XPATH_SUBSCRIPTION_LIST "[type='" PM_MODULE_NAME ":%s']"
@@ -472,6 +473,9 @@ pm_subscription_entry_fill(const char *module_name, np_subscription_t *subscript
             if (0 == strcmp(node->schema->name, "enable-nacm")) {
                 subscription->enable_nacm = true;
             }
+            if (0 == strcmp(node->schema->name, "coalesce")) {
+                subscription->coalesce = true;
+            }
             if (0 == strcmp(node->schema->name, "api-variant") && NULL != node_ll->value_str) {
                 subscription->api_variant = sr_api_variant_from_str(node_ll->value_str);
             }
@@ -1090,6 +1094,30 @@ cleanup:
     return rc;
 }
 
+int
+pm_has_running_enabled(pm_ctx_t *pm_ctx, const char *module_name, bool *running_enabled)
+{
+    struct lyd_node *data_tree = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG3(pm_ctx, module_name, running_enabled);
+
+    *running_enabled = false;
+
+    rc = pm_load_data_tree(pm_ctx, NULL, module_name, true, &data_tree, NULL);
+    if (SR_ERR_DATA_MISSING == rc) {
+        return SR_ERR_OK;
+    }
+    CHECK_RC_LOG_RETURN(rc, "Unable to load persist data tree for module '%s'.", module_name);
+
+    if (NULL != data_tree) {
+        rc = pm_dt_has_running_enable_susbscriptions(data_tree, module_name, running_enabled);
+        lyd_free_withsiblings(data_tree);
+    }
+
+    return rc;
+}
+
 int
 pm_add_subscription(pm_ctx_t *pm_ctx, const ac_ucred_t *user_cred, const char *module_name,
         const np_subscription_t *subscription, const bool exclusive)
@@ -1147,6 +1175,14 @@ pm_add_subscription(pm_ctx_t *pm_ctx, const ac_ucred_t *user_cred, const char *m
         rc = pm_modify_persist_data_tree(pm_ctx, &data_tree, xpath, NULL, true, true, NULL);
         CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to add new leaf into the data tree.");
     }
+    if (subscription->coalesce && (
+            SR__SUBSCRIPTION_TYPE__MODULE_CHANGE_SUBS == subscription->type ||
+            SR__SUBSCRIPTION_TYPE__SUBTREE_CHANGE_SUBS == subscription->type)) {
+        snprintf(xpath, PATH_MAX, PM_XPATH_SUBSCRIPTION_COALESCE, module_name,
+                sr_subscription_type_gpb_to_str(subscription->type), subscription->dst_address, subscription->dst_id);
+        rc = pm_modify_persist_data_tree(pm_ctx, &data_tree, xpath, NULL, true, true, NULL);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to add new leaf into the data tree.");
+    }
     if (NULL != subscription->xpath) {
         snprintf(xpath, PATH_MAX, PM_XPATH_SUBSCRIPTION_XPATH, module_name,
                 sr_subscription_type_gpb_to_str(subscription->type), subscription->dst_address, subscription->dst_id);
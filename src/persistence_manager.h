@@ -92,6 +92,18 @@ int pm_get_module_info(pm_ctx_t *pm_ctx, const ac_ucred_t *user_cred, const char
         sr_mem_ctx_t *sr_mem_features, bool *module_enabled, char ***subtrees_enabled, size_t *subtrees_enabled_cnt,
         char ***features, size_t *features_cnt);
 
+/**
+ * @brief Checks whether running datastore is enabled for the module (or some of its subtrees)
+ * by any subscription stored in module's persistent storage.
+ *
+ * @param[in] pm_ctx Persistence Manager context acquired by ::pm_init call.
+ * @param[in] module_name Name of the module.
+ * @param[out] running_enabled TRUE if there is a subscription enabling running datastore.
+ *
+ * @return Error code (SR_ERR_OK on success).
+ */
+int pm_has_running_enabled(pm_ctx_t *pm_ctx, const char *module_name, bool *running_enabled);
+
 /**
  * @brief Adds a new subscription into module's persistent storage.
  *
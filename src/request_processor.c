@@ -24,6 +24,7 @@
 #include <unistd.h>
 #include <inttypes.h>
 #include <pthread.h>
+#include <sched.h>
 
 #include "sr_common.h"
 #include "access_control.h"
@@ -37,6 +38,8 @@
 
 #define RP_INIT_REQ_QUEUE_SIZE   10  /**< Initial size of the request queue. */
 
+static __thread int rp_reader_slot = -1;  /**< Index of the read-side slot of the worker thread, -1 if it has none. */
+
 /*
  * Attributes that can significantly affect performance of the threadpool.
  */
@@ -140,12 +143,22 @@ rp_check_notif_session(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg)
         xpath = msg->request->get_subtrees_req->xpath;
     } else if (SR__OPERATION__GET_SUBTREE_CHUNK == msg->request->operation) {
         xpath = msg->request->get_subtree_chunk_req->xpath;
+    } else if (SR__OPERATION__EXPORT_DATA == msg->request->operation) {
+        /* the request addresses the whole module */
+        module_name = strdup(msg->request->export_data_req->module_name);
+        CHECK_NULL_NOMEM_GOTO(module_name, rc, cleanup);
     } else {
-        SR_LOG_WRN_MSG("Check notif session called for unknown operation");
+        SR_LOG_ERR("Check notif session called for unsupported operation %s",
+                sr_gpb_operation_name(msg->request->operation));
+        rc = dm_report_error(session->dm_session, "Operation can not be issued on notification session",
+                NULL, SR_ERR_UNSUPPORTED);
+        goto cleanup;
     }
 
-    rc = sr_copy_first_ns(xpath, &module_name);
-    CHECK_RC_LOG_GOTO(rc, cleanup, "Copy first ns failed for xpath %s", xpath);
+    if (NULL == module_name) {
+        rc = sr_copy_first_ns(xpath, &module_name);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Copy first ns failed for xpath %s", xpath);
+    }
 
     /* copy requested model from commit context */
     rc = dm_copy_if_not_loaded(rp_ctx->dm_ctx,  c_ctx->session, session->dm_session, module_name);
@@ -157,7 +170,8 @@ cleanup:
 }
 
 /**
- * @brief Sets a timeout for processing of a operational data request.
+ * @brief Sets a timeout for processing of a operational data request. Only the timeout set
+ * by the last call for the session is effective, cur_req_mutex must be held.
  */
 static int
 rp_set_oper_request_timeout(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *request, uint32_t timeout)
@@ -177,6 +191,8 @@ rp_set_oper_request_timeout(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *re
     if (SR_ERR_OK == rc) {
         msg->session_id = session->id;
         msg->internal_request->oper_data_timeout_req->request_id = request->request->_id;
+        msg->internal_request->oper_data_timeout_req->wait_id = ++session->oper_data_wait_id;
+        msg->internal_request->oper_data_timeout_req->has_wait_id = true;
         msg->internal_request->postpone_timeout = timeout;
         msg->internal_request->has_postpone_timeout = true;
         rc = cm_msg_send(rp_ctx->cm_ctx, msg);
@@ -848,8 +864,9 @@ rp_get_items_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg,
     SR_LOG_DBG("%zu items found for '%s', session id=%"PRIu32".", count, xpath, session->id);
     pthread_mutex_unlock(&session->cur_req_mutex);
 
-    /* copy values to gpb */
-    rc = sr_values_sr_to_gpb(values, count, &resp->response->get_items_resp->values, &resp->response->get_items_resp->n_values);
+    /* serialize values directly into the response, avoiding the allocation of GPB values */
+    rc = sr_values_sr_to_gpb_wire(sr_mem, values, count, msg->request->get_items_req->compress_xpaths,
+            &resp->response->get_items_resp->base, "values");
     CHECK_RC_MSG_GOTO(rc, cleanup, "Copying values to GPB failed.");
 
 cleanup:
@@ -869,6 +886,242 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Collects the xpaths of a get_items_multi request that have not been processed yet
+ * and address the same module as the first of them. The union of the xpaths is used to request
+ * the operational data of the whole group at once.
+ *
+ * @param [in] req
+ * @param [in] value_sets - value sets of the response, NULL for the xpaths not processed yet
+ * @param [in] first - index of the first xpath of the group
+ * @param [out] indices - indices of the xpaths in the group
+ * @param [out] count - number of the xpaths in the group
+ * @param [out] xpath - union of the xpaths in the group
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+rp_get_items_multi_group(Sr__GetItemsMultiReq *req, Sr__GetItemsMultiResp__ValueSet **value_sets, size_t first,
+        size_t **indices, size_t *count, char **xpath)
+{
+    char *module_name = NULL, *ns = NULL, *group_xpath = NULL;
+    size_t *group = NULL, cnt = 0, len = 0;
+    int rc = SR_ERR_OK;
+
+    group = calloc(req->n_xpaths - first, sizeof(*group));
+    CHECK_NULL_NOMEM_RETURN(group);
+
+    group[cnt++] = first;
+    len = strlen(req->xpaths[first]);
+
+    /* an xpath without a module name is left alone, its processing reports the error */
+    if (SR_ERR_OK == sr_copy_first_ns(req->xpaths[first], &module_name)) {
+        for (size_t i = first + 1; i < req->n_xpaths; ++i) {
+            if (NULL != value_sets[i] || SR_ERR_OK != sr_copy_first_ns(req->xpaths[i], &ns)) {
+                continue;
+            }
+            if (0 == strcmp(ns, module_name)) {
+                group[cnt++] = i;
+                len += strlen(" | ") + strlen(req->xpaths[i]);
+            }
+            free(ns);
+            ns = NULL;
+        }
+    }
+
+    group_xpath = calloc(len + 1, sizeof(*group_xpath));
+    CHECK_NULL_NOMEM_GOTO(group_xpath, rc, cleanup);
+    for (size_t i = 0; i < cnt; ++i) {
+        if (i > 0) {
+            strcat(group_xpath, " | ");
+        }
+        strcat(group_xpath, req->xpaths[group[i]]);
+    }
+
+cleanup:
+    free(module_name);
+    if (SR_ERR_OK != rc) {
+        free(group);
+        group = NULL;
+        cnt = 0;
+    }
+    *indices = group;
+    *count = cnt;
+    *xpath = group_xpath;
+    return rc;
+}
+
+/**
+ * @brief Processes a get_items_multi request. The xpaths are processed within the same session
+ * data, grouped by module: the operational data of all the xpaths of a module are requested
+ * at once, so the processing is paused at most once per module and resumed with the same group
+ * once the data are provided. The value sets keep the order of the xpaths in the request.
+ */
+static int
+rp_get_items_multi_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *skip_msg_cleanup)
+{
+    Sr__GetItemsMultiReq *req = NULL;
+    Sr__GetItemsMultiResp__ValueSet *value_set = NULL, **value_sets = NULL;
+    rp_dt_get_items_multi_ctx_t *multi_ctx = NULL;
+    Sr__Msg *resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    struct lyd_node *data_tree = NULL;
+    sr_val_t *values = NULL;
+    size_t count = 0, group_cnt = 0, *group = NULL;
+    char *xpath = NULL, *group_xpath = NULL;
+    int rc = SR_ERR_OK, prepare_rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG5(rp_ctx, session, msg, msg->request, msg->request->get_items_multi_req);
+
+    SR_LOG_DBG_MSG("Processing get_items_multi request.");
+
+    req = msg->request->get_items_multi_req;
+    multi_ctx = &session->get_items_multi_ctx;
+
+    MUTEX_LOCK_TIMED_CHECK_RETURN(&session->cur_req_mutex);
+    rp_handle_get_call_state(session);
+
+    if (RP_REQ_NEW == session->state) {
+        /* start a new request, drop the progress of an abandoned one */
+        sr_msg_free(multi_ctx->resp);
+        multi_ctx->resp = NULL;
+        multi_ctx->index = 0;
+
+        rc = sr_mem_new(0, &sr_mem);
+        CHECK_RC_MSG_GOTO(rc, unlock, "Failed to create a new Sysrepo memory context.");
+        rc = sr_gpb_resp_alloc(sr_mem, SR__OPERATION__GET_ITEMS_MULTI, session->id, &multi_ctx->resp);
+        if (SR_ERR_OK != rc) {
+            sr_mem_free(sr_mem);
+            SR_LOG_ERR_MSG("Gpb response allocation failed");
+            goto unlock;
+        }
+        resp = multi_ctx->resp;
+        if (req->n_xpaths > 0) {
+            resp->response->get_items_multi_resp->value_sets =
+                    sr_calloc(sr_mem, req->n_xpaths, sizeof(*resp->response->get_items_multi_resp->value_sets));
+            CHECK_NULL_NOMEM_GOTO(resp->response->get_items_multi_resp->value_sets, rc, cleanup);
+        }
+        if (session->options & SR__SESSION_FLAGS__SESS_NOTIFICATION) {
+            /* the xpaths may span several modules, only the data of the commit context are available */
+            rc = dm_report_error(session->dm_session, "Get items multi call can not be issued on notification session",
+                    NULL, SR_ERR_UNSUPPORTED);
+            goto cleanup;
+        }
+    } else if (NULL == multi_ctx->resp) {
+        SR_LOG_ERR("Session id = %u is in invalid state.", session->id);
+        rc = SR_ERR_INTERNAL;
+        goto unlock;
+    } else {
+        /* resume the paused request */
+        resp = multi_ctx->resp;
+        sr_mem = (sr_mem_ctx_t *) resp->_sysrepo_mem_ctx;
+    }
+
+    /* store current request to session */
+    session->req = msg;
+
+    value_sets = resp->response->get_items_multi_resp->value_sets;
+    while (multi_ctx->index < req->n_xpaths) {
+        if (NULL != value_sets[multi_ctx->index]) {
+            /* already processed with the group of an earlier xpath */
+            ++multi_ctx->index;
+            continue;
+        }
+        rp_handle_get_call_state(session);
+
+        /* the group is the same when the paused request is resumed, the value sets are filled only afterwards */
+        rc = rp_get_items_multi_group(req, value_sets, multi_ctx->index, &group, &group_cnt, &group_xpath);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to group the xpaths by module.");
+
+        prepare_rc = rp_dt_prepare_data(rp_ctx, session, group_xpath, SR_API_VALUES, 0, &data_tree);
+        if (SR_ERR_OK == prepare_rc && RP_REQ_WAITING_FOR_DATA == session->state) {
+            SR_LOG_DBG("Request paused at xpath '%s', waiting for data", group_xpath);
+            /* we are waiting for operational data do not free the request,
+             * the new timeout supersedes the one of an earlier pause */
+            *skip_msg_cleanup = true;
+            rc = rp_set_oper_request_timeout(rp_ctx, session, msg, SR_OPER_DATA_PROVIDE_TIMEOUT);
+            free(group);
+            free(group_xpath);
+            pthread_mutex_unlock(&session->cur_req_mutex);
+            return rc;
+        }
+
+        for (size_t i = 0; i < group_cnt; ++i) {
+            xpath = req->xpaths[group[i]];
+            SR_LOG_INF("Get items request %s datastore, xpath: %s", sr_ds_to_str(session->datastore), xpath);
+
+            /* the result of each xpath is reported separately */
+            if (SR_ERR_OK != prepare_rc) {
+                rc = prepare_rc;
+            } else if (NULL == data_tree) {
+                rc = SR_ERR_NOT_FOUND;
+            } else {
+                rc = rp_dt_get_values(rp_ctx->dm_ctx, session, data_tree, sr_mem, xpath,
+                        dm_is_running_ds_session(session->dm_session), &values, &count);
+                if (SR_ERR_UNAUTHORIZED == rc) {
+                    rc = SR_ERR_NOT_FOUND;
+                }
+            }
+            if (SR_ERR_OK != rc && SR_ERR_NOT_FOUND != rc) {
+                SR_LOG_ERR("Get items failed for '%s', session id=%"PRIu32".", xpath, session->id);
+            }
+
+            value_set = sr_calloc(sr_mem, 1, sizeof(*value_set));
+            CHECK_NULL_NOMEM_GOTO(value_set, rc, cleanup);
+            sr__get_items_multi_resp__value_set__init(value_set);
+            value_sets[group[i]] = value_set;
+
+            value_set->result = rc;
+            rc = SR_ERR_OK;
+            if (SR_ERR_OK == value_set->result) {
+                /* serialize values directly into the response, avoiding the allocation of GPB values */
+                rc = sr_values_sr_to_gpb_wire(sr_mem, values, count, req->compress_xpaths, &value_set->base, "values");
+            }
+            sr_free_values(values, count);
+            values = NULL;
+            count = 0;
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Copying values to GPB failed.");
+        }
+
+        session->state = RP_REQ_FINISHED;
+        free(session->module_name);
+        session->module_name = NULL;
+        free(group);
+        group = NULL;
+        free(group_xpath);
+        group_xpath = NULL;
+        data_tree = NULL;
+    }
+    /* all the value sets are filled only now, since the xpaths are processed out of order */
+    resp->response->get_items_multi_resp->n_value_sets = req->n_xpaths;
+
+cleanup:
+    if (RP_REQ_WAITING_FOR_DATA != session->state) {
+        session->state = RP_REQ_FINISHED;
+    }
+    free(session->module_name);
+    session->module_name = NULL;
+    free(group);
+    free(group_xpath);
+    session->req = NULL;
+    multi_ctx->resp = NULL;
+    multi_ctx->index = 0;
+    pthread_mutex_unlock(&session->cur_req_mutex);
+
+    /* set response code */
+    resp->response->result = rc;
+
+    rc = rp_resp_fill_errors(resp, session->dm_session);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Copying errors to gpb failed");
+    }
+
+    return cm_msg_send(rp_ctx->cm_ctx, resp);
+
+unlock:
+    pthread_mutex_unlock(&session->cur_req_mutex);
+    return rc;
+}
+
 /**
  * @brief Processes a get_subtree request.
  */
@@ -1154,6 +1407,98 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Processes an export_data request.
+ */
+static int
+rp_export_data_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *skip_msg_cleanup)
+{
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG5(rp_ctx, session, msg, msg->request, msg->request->export_data_req);
+
+    SR_LOG_DBG_MSG("Processing export_data request.");
+
+    Sr__Msg *resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_RETURN(rc, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_resp_alloc(sr_mem, SR__OPERATION__EXPORT_DATA, session->id, &resp);
+    if (SR_ERR_OK != rc) {
+        sr_mem_free(sr_mem);
+        SR_LOG_ERR_MSG("Gpb response allocation failed");
+        return rc;
+    }
+
+    uint8_t *chunk = NULL;
+    size_t chunk_size = 0;
+    bool last = false;
+    LYD_FORMAT format = LYD_XML;
+    char *module_name = msg->request->export_data_req->module_name;
+
+    switch (sr_data_format_gpb_to_sr(msg->request->export_data_req->format)) {
+        case SR_DATA_JSON:
+            format = LYD_JSON;
+            break;
+        case SR_DATA_LYB:
+            format = LYD_LYB;
+            break;
+        default:
+            format = LYD_XML;
+            break;
+    }
+
+    if (session->options & SR__SESSION_FLAGS__SESS_NOTIFICATION) {
+        rc = rp_check_notif_session(rp_ctx, session, msg);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Check notif session failed");
+    }
+
+    MUTEX_LOCK_TIMED_CHECK_GOTO(&session->cur_req_mutex, rc, cleanup);
+    rp_handle_get_call_state(session);
+
+    /* store current request to session */
+    session->req = msg;
+
+    /* get the next chunk of the serialized data */
+    rc = rp_dt_export_data_wrapper(rp_ctx, session, sr_mem, module_name, format,
+            msg->request->export_data_req->offset, &chunk, &chunk_size, &last);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Export data failed for module '%s', session id=%"PRIu32".", module_name, session->id);
+    }
+
+    if (RP_REQ_WAITING_FOR_DATA == session->state) {
+        SR_LOG_DBG_MSG("Request paused, waiting for data");
+        /* we are waiting for operational data do not free the request */
+        *skip_msg_cleanup = true;
+        /* setup timeout */
+        rc = rp_set_oper_request_timeout(rp_ctx, session, msg, SR_OPER_DATA_PROVIDE_TIMEOUT);
+        sr_msg_free(resp);
+        pthread_mutex_unlock(&session->cur_req_mutex);
+        return rc;
+    }
+
+    pthread_mutex_unlock(&session->cur_req_mutex);
+
+    resp->response->export_data_resp->chunk.data = chunk;
+    resp->response->export_data_resp->chunk.len = chunk_size;
+    resp->response->export_data_resp->last = last;
+
+cleanup:
+    session->req = NULL;
+    /* set response code */
+    resp->response->result = rc;
+
+    rc = rp_resp_fill_errors(resp, session->dm_session);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Copying errors to gpb failed");
+    }
+
+    rc = cm_msg_send(rp_ctx->cm_ctx, resp);
+
+    return rc;
+}
+
 /**
  * @brief Processes a set_item request.
  */
@@ -1320,6 +1665,59 @@ rp_delete_item_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg
     return rc;
 }
 
+/**
+ * @brief Processes a set_data_tree request.
+ */
+static int
+rp_set_data_tree_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg)
+{
+    Sr__Msg *resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    char *module_name = NULL;
+    char *data = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG5(rp_ctx, session, msg, msg->request, msg->request->set_data_tree_req);
+
+    SR_LOG_DBG_MSG("Processing set_data_tree request.");
+
+    module_name = msg->request->set_data_tree_req->module_name;
+
+    /* allocate the response */
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_RETURN(rc, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_resp_alloc(sr_mem, SR__OPERATION__SET_DATA_TREE, session->id, &resp);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Allocation of set_data_tree response failed.");
+        sr_mem_free(sr_mem);
+        return SR_ERR_NOMEM;
+    }
+
+    /* copy the data from gpb, they are kept in the session's operation list */
+    data = strdup(msg->request->set_data_tree_req->data);
+    CHECK_NULL_NOMEM_GOTO(data, rc, cleanup);
+
+    rc = rp_dt_set_tree_wrapper(rp_ctx, session, module_name, data, msg->request->set_data_tree_req->merge);
+
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Set data tree failed for '%s', session id=%"PRIu32".", module_name, session->id);
+    }
+
+cleanup:
+    /* set response code */
+    resp->response->result = rc;
+
+    rc = rp_resp_fill_errors(resp, session->dm_session);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Copying errors to gpb failed");
+    }
+
+    /* send the response */
+    rc = cm_msg_send(rp_ctx->cm_ctx, resp);
+
+    return rc;
+}
+
 /**
  * @brief Processes a move_item request.
  */
@@ -1534,6 +1932,108 @@ rp_discard_changes_req_process(const rp_ctx_t *rp_ctx, const rp_session_t *sessi
     return rc;
 }
 
+/**
+ * @brief Rolls back the running datastore to the snapshot saved before an unconfirmed commit.
+ * The rollback is processed as a copy-config request of an internal session, the snapshot is released.
+ */
+static int
+rp_confirmed_commit_rollback(rp_ctx_t *rp_ctx, sr_btree_t *snapshot)
+{
+    rp_session_t *session = NULL;
+    Sr__Msg *req = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG(rp_ctx);
+
+    if (NULL == snapshot || NULL == sr_btree_get_at(snapshot, 0)) {
+        SR_LOG_DBG_MSG("Nothing to roll back, the unconfirmed commit has not changed any data.");
+        goto cleanup;
+    }
+
+    rc = rp_session_start(rp_ctx, 0, NULL, SR_DS_CANDIDATE, 0, 0, &session);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Start of the rollback session failed.");
+    session->rollback = true;
+
+    /* put the saved state into candidate, only these modules are copied to running */
+    rc = dm_restore_snapshot(rp_ctx->dm_ctx, session->dm_session, snapshot);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Restoring of the state before confirmed commit failed.");
+
+    rc = sr_gpb_req_alloc(NULL, SR__OPERATION__COPY_CONFIG, session->id, &req);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Allocation of copy_config request failed.");
+    req->request->copy_config_req->src_datastore = SR__DATA_STORE__CANDIDATE;
+    req->request->copy_config_req->dst_datastore = SR__DATA_STORE__RUNNING;
+
+    rc = rp_msg_process(rp_ctx, session, req);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Unable to enqueue the rollback request.");
+    /* the session is stopped once the request has been processed */
+    session = NULL;
+
+cleanup:
+    if (NULL != session) {
+        rp_session_stop(rp_ctx, session);
+    }
+    sr_btree_cleanup(snapshot);
+    return rc;
+}
+
+/**
+ * @brief Updates the state of confirmed commit once a copy to running datastore has finished.
+ * A plain copy confirms the pending commit, a confirmed copy (re)arms the rollback timer.
+ */
+static int
+rp_confirmed_commit_finish(rp_ctx_t *rp_ctx, const rp_session_t *session, int result)
+{
+    Sr__Msg *req = NULL;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG2(rp_ctx, session);
+
+    pthread_mutex_lock(&rp_ctx->confirmed_commit_mutex);
+
+    if (SR_ERR_OK != result) {
+        if (0 == rp_ctx->confirmed_commit_id) {
+            /* drop the state saved by the failed confirmed copy */
+            sr_btree_cleanup(rp_ctx->confirmed_commit_snapshot);
+            rp_ctx->confirmed_commit_snapshot = NULL;
+        }
+        goto cleanup;
+    }
+
+    if (0 == session->confirm_timeout) {
+        if (0 != rp_ctx->confirmed_commit_id) {
+            SR_LOG_INF("Confirmed commit id %"PRIu32" has been confirmed.", rp_ctx->confirmed_commit_id);
+            sr_btree_cleanup(rp_ctx->confirmed_commit_snapshot);
+            rp_ctx->confirmed_commit_snapshot = NULL;
+            rp_ctx->confirmed_commit_id = 0;
+        }
+        goto cleanup;
+    }
+
+    /* a new ID makes the timer of the previous confirmed copy expire without any effect */
+    if (0 == ++rp_ctx->confirmed_commit_last_id) {
+        ++rp_ctx->confirmed_commit_last_id;
+    }
+    rp_ctx->confirmed_commit_id = rp_ctx->confirmed_commit_last_id;
+
+    rc = sr_gpb_internal_req_alloc(NULL, SR__OPERATION__CONFIRMED_COMMIT_TIMEOUT, &req);
+    if (SR_ERR_OK == rc) {
+        req->internal_request->confirmed_commit_timeout_req->confirmed_commit_id = rp_ctx->confirmed_commit_id;
+        req->internal_request->postpone_timeout = session->confirm_timeout;
+        req->internal_request->has_postpone_timeout = true;
+        rc = cm_msg_send(rp_ctx->cm_ctx, req);
+    }
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Unable to set up the timeout of confirmed commit id %"PRIu32".", rp_ctx->confirmed_commit_id);
+    } else {
+        SR_LOG_INF("Confirmed commit id %"PRIu32" has to be confirmed within %"PRIu32" seconds.",
+                rp_ctx->confirmed_commit_id, session->confirm_timeout);
+    }
+
+cleanup:
+    pthread_mutex_unlock(&rp_ctx->confirmed_commit_mutex);
+    return rc;
+}
+
 /**
  * @brief Processes a copy-config request.
  */
@@ -1571,6 +2071,11 @@ rp_copy_config_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg
     locked = true;
 
     session->req = msg;
+    session->confirm_timeout = 0;
+    if (SR__DATA_STORE__RUNNING == msg->request->copy_config_req->dst_datastore &&
+            msg->request->copy_config_req->has_confirm_timeout) {
+        session->confirm_timeout = msg->request->copy_config_req->confirm_timeout;
+    }
     rc = rp_dt_copy_config(rp_ctx, session, msg->request->copy_config_req->module_name,
                 sr_datastore_gpb_to_sr(msg->request->copy_config_req->src_datastore),
                 sr_datastore_gpb_to_sr(msg->request->copy_config_req->dst_datastore), &errors, &err_cnt);
@@ -1584,9 +2089,15 @@ rp_copy_config_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg
         return SR_ERR_OK;
     }
 
+    if (SR__DATA_STORE__RUNNING == msg->request->copy_config_req->dst_datastore && !session->rollback) {
+        /* confirm the pending confirmed commit or set up a new one */
+        rp_confirmed_commit_finish(rp_ctx, session, rc);
+    }
+
 cleanup:
     session->state = RP_REQ_FINISHED;
     session->req = NULL;
+    session->confirm_timeout = 0;
     if (locked) {
         pthread_mutex_unlock(&session->cur_req_mutex);
     }
@@ -1600,6 +2111,168 @@ cleanup:
         sr_free_errors(errors, err_cnt);
     }
 
+    if (session->rollback) {
+        /* nobody waits for the response, release the internal session */
+        if (SR_ERR_OK == resp->response->result) {
+            SR_LOG_INF_MSG("Unconfirmed commit has been rolled back.");
+        } else {
+            SR_LOG_ERR("Rollback of unconfirmed commit failed: %s.", sr_strerror(resp->response->result));
+        }
+        sr_msg_free(resp);
+        pthread_mutex_lock(&session->msg_count_mutex);
+        session->stop_requested = true;
+        pthread_mutex_unlock(&session->msg_count_mutex);
+        return SR_ERR_OK;
+    }
+
+    /* send the response */
+    rc = cm_msg_send(rp_ctx->cm_ctx, resp);
+    return rc;
+}
+
+/**
+ * @brief Processes a cancel_confirmed_commit request.
+ */
+static int
+rp_cancel_confirmed_commit_req_process(rp_ctx_t *rp_ctx, const rp_session_t *session, Sr__Msg *msg)
+{
+    Sr__Msg *resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    sr_btree_t *snapshot = NULL;
+    uint32_t id = 0;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG5(rp_ctx, session, msg, msg->request, msg->request->cancel_confirmed_commit_req);
+
+    SR_LOG_DBG_MSG("Processing cancel_confirmed_commit request.");
+
+    /* allocate the response */
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_RETURN(rc, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_resp_alloc(sr_mem, SR__OPERATION__CANCEL_CONFIRMED_COMMIT, session->id, &resp);
+    if (SR_ERR_OK != rc) {
+        sr_mem_free(sr_mem);
+        SR_LOG_ERR_MSG("Allocation of cancel_confirmed_commit response failed.");
+        return SR_ERR_NOMEM;
+    }
+
+    pthread_mutex_lock(&rp_ctx->confirmed_commit_mutex);
+    id = rp_ctx->confirmed_commit_id;
+    snapshot = rp_ctx->confirmed_commit_snapshot;
+    rp_ctx->confirmed_commit_id = 0;
+    rp_ctx->confirmed_commit_snapshot = NULL;
+    pthread_mutex_unlock(&rp_ctx->confirmed_commit_mutex);
+
+    if (0 == id) {
+        SR_LOG_ERR_MSG("There is no pending confirmed commit to be canceled.");
+        rc = SR_ERR_NOT_FOUND;
+    } else {
+        SR_LOG_INF("Confirmed commit id %"PRIu32" has been canceled, rolling back.", id);
+        rc = rp_confirmed_commit_rollback(rp_ctx, snapshot);
+    }
+
+    /* set response code */
+    resp->response->result = rc;
+
+    /* send the response */
+    rc = cm_msg_send(rp_ctx->cm_ctx, resp);
+    return rc;
+}
+
+/**
+ * @brief Processes a rollback request. The inverse changes are loaded into the candidate datastore
+ * and committed to running within the same request, so that no other commit can interleave.
+ */
+static int
+rp_rollback_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *skip_msg_cleanup)
+{
+    Sr__Msg *resp = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    sr_datastore_t prev_ds = SR_DS_RUNNING;
+    sr_error_info_t *errors = NULL;
+    size_t err_cnt = 0;
+    bool locked = false;
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG5(rp_ctx, session, msg, msg->request, msg->request->rollback_req);
+
+    SR_LOG_DBG_MSG("Processing rollback request.");
+
+    /* allocate the response */
+    rc = sr_mem_new(0, &sr_mem);
+    CHECK_RC_MSG_RETURN(rc, "Failed to create a new Sysrepo memory context.");
+    rc = sr_gpb_resp_alloc(sr_mem, SR__OPERATION__ROLLBACK, session->id, &resp);
+    if (SR_ERR_OK != rc) {
+        sr_mem_free(sr_mem);
+        SR_LOG_ERR_MSG("Allocation of rollback response failed.");
+        return SR_ERR_NOMEM;
+    }
+
+    if (rp_ctx->block_further_commits) {
+        rc = SR_ERR_OPERATION_FAILED;
+    }
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Stop requested, commits are blocked.");
+
+    MUTEX_LOCK_TIMED_CHECK_GOTO(&session->cur_req_mutex, rc, cleanup);
+    locked = true;
+
+    if (RP_REQ_RESUMED != session->state) {
+        /* candidate is replaced by running with the inverse changes applied */
+        prev_ds = session->datastore;
+        rp_dt_switch_datastore(rp_ctx, session, SR_DS_CANDIDATE);
+        rc = dm_discard_changes(rp_ctx->dm_ctx, session->dm_session, NULL);
+        if (SR_ERR_OK == rc) {
+            rc = dm_remove_session_operations(session->dm_session);
+        }
+        if (SR_ERR_OK == rc) {
+            rc = dm_checkpoint_load(rp_ctx->dm_ctx, session->dm_session, msg->request->rollback_req->count);
+            if (SR_ERR_OK != rc) {
+                SR_LOG_ERR("Rollback of %"PRIu32" commit(s) failed.", msg->request->rollback_req->count);
+                dm_discard_changes(rp_ctx->dm_ctx, session->dm_session, NULL);
+            }
+        }
+        rp_dt_switch_datastore(rp_ctx, session, prev_ds);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Loading of the rollback checkpoints failed.");
+    }
+
+    /* commit the inverse changes, the request is resumed here once the verifiers reply */
+    session->req = msg;
+    session->confirm_timeout = 0;
+    rc = rp_dt_copy_config(rp_ctx, session, NULL, SR_DS_CANDIDATE, SR_DS_RUNNING, &errors, &err_cnt);
+
+    if (SR_ERR_OK == rc && RP_REQ_WAITING_FOR_VERIFIERS == session->state) {
+        SR_LOG_DBG_MSG("Rollback request paused, waiting for verifiers");
+        /* we are waiting for verifiers data do not free the request */
+        *skip_msg_cleanup = true;
+        sr_msg_free(resp);
+        pthread_mutex_unlock(&session->cur_req_mutex);
+        return SR_ERR_OK;
+    }
+
+    /* as any other copy to running, the rollback confirms the pending confirmed commit */
+    rp_confirmed_commit_finish(rp_ctx, session, rc);
+
+cleanup:
+    session->state = RP_REQ_FINISHED;
+    session->req = NULL;
+    if (locked) {
+        pthread_mutex_unlock(&session->cur_req_mutex);
+    }
+    /* set response code */
+    resp->response->result = rc;
+
+    /* copy error information to GPB  (if any) */
+    if (err_cnt > 0) {
+        sr_gpb_fill_errors(errors, err_cnt, sr_mem, &resp->response->rollback_resp->errors,
+                &resp->response->rollback_resp->n_errors);
+        sr_free_errors(errors, err_cnt);
+    }
+
+    rc = rp_resp_fill_errors(resp, session->dm_session);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Copying errors to gpb failed");
+    }
+
     /* send the response */
     rc = cm_msg_send(rp_ctx->cm_ctx, resp);
     return rc;
@@ -1708,8 +2381,29 @@ rp_session_set_opts(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg)
         return SR_ERR_NOMEM;
     }
 
-    /* white list options that can be set */
-    session->options = msg->request->session_set_opts_req->options & SR_SESS_MUTABLE_OPTS;
+    if (msg->request->session_set_opts_req->has_commit_id) {
+        /* rebind the notification session to another commit */
+        if (session->options & SR__SESSION_FLAGS__SESS_NOTIFICATION) {
+            SR_LOG_DBG("Rebinding notification session id=%"PRIu32" to commit id=%"PRIu32".",
+                    session->id, msg->request->session_set_opts_req->commit_id);
+            session->commit_id = msg->request->session_set_opts_req->commit_id;
+            /* drop the data and iterator state of the previous commit */
+            rc = dm_discard_changes(rp_ctx->dm_ctx, session->dm_session, NULL);
+            ly_set_free(session->get_items_ctx.nodes);
+            session->get_items_ctx.nodes = NULL;
+            free(session->get_items_ctx.xpath);
+            session->get_items_ctx.xpath = NULL;
+            rp_dt_free_subtree_ctx_content(&session->subtree_ctx);
+            rp_dt_free_export_ctx_content(&session->export_ctx);
+            free(session->change_ctx.xpath);
+            memset(&session->change_ctx, 0, sizeof(session->change_ctx));
+        } else {
+            rc = dm_report_error(session->dm_session, "Only a notification session can be bound to a commit", NULL, SR_ERR_UNSUPPORTED);
+        }
+    } else {
+        /* white list options that can be set */
+        session->options = msg->request->session_set_opts_req->options & SR_SESS_MUTABLE_OPTS;
+    }
 
     /* set response code */
     resp->response->result = rc;
@@ -1857,6 +2551,10 @@ rp_subscribe_req_process(const rp_ctx_t *rp_ctx, const rp_session_t *session, Sr
     if (subscribe_req->has_enable_event && subscribe_req->enable_event) {
         options |= NP_SUBSCR_EV_EVENT;
     }
+    if (subscribe_req->has_coalesce && subscribe_req->coalesce &&
+            SR__NOTIFICATION_EVENT__APPLY_EV == subscribe_req->notif_event) {
+        options |= NP_SUBSCR_COALESCE;
+    }
 
     /* subscribe to the notification */
     rc = np_notification_subscribe(rp_ctx->np_ctx, session, subscribe_req->type,
@@ -2490,7 +3188,7 @@ rp_data_provide_request_nested(rp_ctx_t *rp_ctx, rp_session_t *session, const ch
 
     /* loop through the node children */
     while ((iter = (struct lys_node *)lys_getnext(iter, sch_node, NULL, 0))) {
-        subs_index = session->state_data_ctx.subscription_nodes->count;
+        subs_index = session->state_data_ctx.subscriptions->count;
         if ((LYS_LIST | LYS_CONTAINER) & iter->nodetype) {
             /* find subscription where subsequent request will be addressed
              * this must exists since the a parent node has been already requested
@@ -2504,7 +3202,7 @@ rp_data_provide_request_nested(rp_ctx_t *rp_ctx, rp_session_t *session, const ch
             /* check if we have exact match for leaf or leaf-list node */
             rp_dt_find_exact_match_subscription_for_node(session, iter, &subs_index);
         }
-        if (subs_index < session->state_data_ctx.subscription_nodes->count) {
+        if (subs_index < session->state_data_ctx.subscriptions->count) {
             for (size_t i = 0; i < xp_count; i++) {
                 size_t len = strlen(xpaths[i]) + strlen(iter->name) + 2 /* slash + zero byte */;
 
@@ -2772,6 +3470,53 @@ rp_commit_timeout_req_process(const rp_ctx_t *rp_ctx, Sr__Msg *msg)
     return rc;
 }
 
+/**
+ * @brief Processes a commit-coalesce internal request.
+ */
+static int
+rp_commit_coalesce_req_process(const rp_ctx_t *rp_ctx, Sr__Msg *msg)
+{
+    int rc = SR_ERR_OK;
+
+    CHECK_NULL_ARG4(rp_ctx, msg, msg->internal_request, msg->internal_request->commit_coalesce_req);
+
+    SR_LOG_DBG_MSG("Processing commit-coalesce request.");
+
+    rc = dm_commit_coalesce_flush(rp_ctx->dm_ctx, msg->internal_request->commit_coalesce_req->module_name);
+
+    return rc;
+}
+
+/**
+ * @brief Processes a confirmed-commit-timeout internal request.
+ */
+static int
+rp_confirmed_commit_timeout_req_process(rp_ctx_t *rp_ctx, Sr__Msg *msg)
+{
+    sr_btree_t *snapshot = NULL;
+    uint32_t id = 0;
+
+    CHECK_NULL_ARG4(rp_ctx, msg, msg->internal_request, msg->internal_request->confirmed_commit_timeout_req);
+
+    id = msg->internal_request->confirmed_commit_timeout_req->confirmed_commit_id;
+    SR_LOG_DBG("Processing confirmed-commit-timeout request (id=%"PRIu32").", id);
+
+    pthread_mutex_lock(&rp_ctx->confirmed_commit_mutex);
+    if (id != rp_ctx->confirmed_commit_id) {
+        pthread_mutex_unlock(&rp_ctx->confirmed_commit_mutex);
+        SR_LOG_DBG("Confirmed commit id %"PRIu32" has been already confirmed, canceled or extended.", id);
+        return SR_ERR_OK;
+    }
+    snapshot = rp_ctx->confirmed_commit_snapshot;
+    rp_ctx->confirmed_commit_id = 0;
+    rp_ctx->confirmed_commit_snapshot = NULL;
+    pthread_mutex_unlock(&rp_ctx->confirmed_commit_mutex);
+
+    SR_LOG_WRN("Confirmed commit id %"PRIu32" has not been confirmed in time, rolling back.", id);
+
+    return rp_confirmed_commit_rollback(rp_ctx, snapshot);
+}
+
 /**
  * @brief Processes an operational data timeout request.
  */
@@ -2786,7 +3531,8 @@ rp_oper_data_timeout_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Ms
 
     MUTEX_LOCK_TIMED_CHECK_RETURN(&session->cur_req_mutex);
     if (RP_REQ_WAITING_FOR_DATA == session->state &&
-        session->req && session->req->request->_id == msg->internal_request->oper_data_timeout_req->request_id) {
+        session->req && session->req->request->_id == msg->internal_request->oper_data_timeout_req->request_id &&
+        session->oper_data_wait_id == msg->internal_request->oper_data_timeout_req->wait_id) {
         SR_LOG_DBG("Time out expired for operational data to be loaded. Request (id=%" PRIu64 ") processing continue, "
                 "session id = %u", session->req->request->_id, session->id);
         rp_msg_process(rp_ctx, session, session->req);
@@ -2939,15 +3685,14 @@ rp_nacm_reload_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg * ms
 }
 
 /**
- * @brief Sends an event notification to specified notification subscriber.
+ * @brief Allocates an event notification request to be sent to notification subscriber(s).
  */
 static int
-rp_event_notif_send(const rp_ctx_t *rp_ctx, const rp_session_t *session, Sr__EventNotifReq__NotifType type,
+rp_event_notif_req_alloc(const rp_session_t *session, Sr__EventNotifReq__NotifType type,
         const char *xpath, time_t timestamp, sr_api_variant_t api_variant, const sr_val_t *sr_values, size_t sr_values_cnt,
-        const sr_node_t *sr_trees, size_t sr_trees_cnt, const char *subscription_address, uint32_t subscription_id,
-        time_t delivery_time)
+        const sr_node_t *sr_trees, size_t sr_trees_cnt, Sr__Msg **req_p)
 {
-    Sr__Msg *req = NULL, *internal_req = NULL;
+    Sr__Msg *req = NULL;
     int rc = SR_ERR_OK;
 
     rc = sr_gpb_req_alloc(NULL, SR__OPERATION__EVENT_NOTIF, (NULL != session ? session->id : 0), &req);
@@ -2972,6 +3717,67 @@ rp_event_notif_send(const rp_ctx_t *rp_ctx, const rp_session_t *session, Sr__Eve
     }
     CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to duplicate event notification (%s) input data.", xpath);
 
+    *req_p = req;
+    return rc;
+
+cleanup:
+    if (NULL != req) {
+        sr_msg_free(req);
+    }
+    return rc;
+}
+
+/**
+ * @brief Adds a subscriber into the list of destinations of an event notification request.
+ */
+static int
+rp_event_notif_dst_add(Sr__Msg *req, const char *subscription_address, uint32_t subscription_id)
+{
+    Sr__EventNotifReq *notif = NULL;
+    Sr__EventNotifReq__Destination **destinations = NULL, *destination = NULL;
+
+    CHECK_NULL_ARG4(req, req->request, req->request->event_notif_req, subscription_address);
+
+    notif = req->request->event_notif_req;
+
+    destinations = realloc(notif->destinations, (notif->n_destinations + 1) * sizeof(*destinations));
+    CHECK_NULL_NOMEM_RETURN(destinations);
+    notif->destinations = destinations;
+
+    destination = calloc(1, sizeof(*destination));
+    CHECK_NULL_NOMEM_RETURN(destination);
+    sr__event_notif_req__destination__init(destination);
+
+    destination->address = strdup(subscription_address);
+    if (NULL == destination->address) {
+        free(destination);
+        SR_LOG_ERR_MSG("Unable to allocate memory for the notification destination.");
+        return SR_ERR_NOMEM;
+    }
+    destination->subscription_id = subscription_id;
+
+    notif->destinations[notif->n_destinations++] = destination;
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Sends an event notification to specified notification subscriber.
+ */
+static int
+rp_event_notif_send(const rp_ctx_t *rp_ctx, const rp_session_t *session, Sr__EventNotifReq__NotifType type,
+        const char *xpath, time_t timestamp, sr_api_variant_t api_variant, const sr_val_t *sr_values, size_t sr_values_cnt,
+        const sr_node_t *sr_trees, size_t sr_trees_cnt, const char *subscription_address, uint32_t subscription_id,
+        time_t delivery_time)
+{
+    Sr__Msg *req = NULL, *internal_req = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = rp_event_notif_req_alloc(session, type, xpath, timestamp, api_variant, sr_values, sr_values_cnt,
+            sr_trees, sr_trees_cnt, &req);
+    if (SR_ERR_OK != rc) {
+        return rc;
+    }
+
     /* set subscription info */
     req->request->event_notif_req->subscriber_address = strdup(subscription_address);
     CHECK_NULL_NOMEM_GOTO(req->request->event_notif_req->subscriber_address, rc, cleanup);
@@ -3048,6 +3854,7 @@ rp_event_notif_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg
     nacm_ctx_t *nacm_ctx = NULL;
     nacm_action_t nacm_action = NACM_ACTION_PERMIT;
     char *nacm_rule = NULL, *nacm_rule_info = NULL;
+    Sr__Msg *values_req = NULL, *trees_req = NULL, **dst_req = NULL;
     int rc = SR_ERR_OK, rc_tmp = SR_ERR_OK;
 
     CHECK_NULL_ARG_NORET4(rc, rp_ctx, msg, msg->request, msg->request->event_notif_req);
@@ -3170,10 +3977,6 @@ rp_event_notif_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg
             subscription = subscriptions_list->data[i];
             if ((NULL != subscription->xpath && rp_event_notif_match_subscr(xpath, subscription->xpath))
                     || (NULL == subscription->xpath && 0 == sr_cmp_first_ns(xpath, subscription->module_name))) {
-                /* duplicate msg into req with values and subscription details
-                 * @note we are not using memory context for the *req* message because with so many
-                 * duplications it would be actually less efficient than normally.
-                 */
                 sub_match = true;
 
                 /* NACM access control */
@@ -3191,17 +3994,43 @@ rp_event_notif_req_process(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg
                     }
                 }
 
-                rc = rp_event_notif_send(rp_ctx, session, msg->request->event_notif_req->type,
-                        xpath, msg->request->event_notif_req->timestamp,
-                        subscription->api_variant, with_def, with_def_cnt, with_def_tree, with_def_tree_cnt,
-                        subscription->dst_address, subscription->dst_id, 0);
+                /* the notification is duplicated only once per API variant, Connection Manager packs it
+                 * once and delivers it to all its destinations
+                 * @note we are not using memory context for the *req* message because it outlives this request
+                 */
+                dst_req = (SR_API_VALUES == subscription->api_variant) ? &values_req : &trees_req;
+                if (NULL == *dst_req) {
+                    rc = rp_event_notif_req_alloc(session, msg->request->event_notif_req->type,
+                            xpath, msg->request->event_notif_req->timestamp,
+                            subscription->api_variant, with_def, with_def_cnt, with_def_tree, with_def_tree_cnt, dst_req);
+                    CHECK_RC_LOG_GOTO(rc, finalize, "Error by duplicating the notification '%s'.", xpath);
+                }
+                rc = rp_event_notif_dst_add(*dst_req, subscription->dst_address, subscription->dst_id);
                 CHECK_RC_LOG_GOTO(rc, finalize, "Error by sending the notification '%s' to the subscriber '%s'.",
                         subscription->xpath, subscription->dst_address);
             }
         }
     }
 
+    /* send the notification to all matching subscribers */
+    if (NULL != values_req) {
+        rc = cm_msg_send(rp_ctx->cm_ctx, values_req);
+        values_req = NULL;
+        CHECK_RC_LOG_GOTO(rc, finalize, "Error by sending the notification '%s' to the subscribers.", xpath);
+    }
+    if (NULL != trees_req) {
+        rc = cm_msg_send(rp_ctx->cm_ctx, trees_req);
+        trees_req = NULL;
+        CHECK_RC_LOG_GOTO(rc, finalize, "Error by sending the notification '%s' to the subscribers.", xpath);
+    }
+
 finalize:
+    if (NULL != values_req) {
+        sr_msg_free(values_req);
+    }
+    if (NULL != trees_req) {
+        sr_msg_free(trees_req);
+    }
     /* free all the allocated data */
     if (SR_API_VALUES == msg_api_variant) {
         sr_free_values(values, values_cnt);
@@ -3377,13 +4206,71 @@ rp_notification_ack_process(rp_ctx_t *rp_ctx, Sr__Msg *msg)
     return rc;
 }
 
+/**
+ * @brief Enters the read side of the commit synchronization for a read-only request.
+ *
+ * A worker thread only marks its own read-side slot, so that concurrent reads do not write
+ * to the shared commit_lock. The commit_lock is read-locked only if a commit is pending.
+ *
+ * @return TRUE if commit_lock has been read-locked, FALSE if the read-side slot is used.
+ */
+static bool
+rp_read_lock(rp_ctx_t *rp_ctx)
+{
+    if (rp_reader_slot >= 0) {
+        ATOMIC_INC(&rp_ctx->readers[rp_reader_slot].active);
+        if (0 == ATOMIC_LOAD(&rp_ctx->commit_pending)) {
+            return false;
+        }
+        /* a commit is pending, let it proceed */
+        ATOMIC_DEC(&rp_ctx->readers[rp_reader_slot].active);
+    }
+    pthread_rwlock_rdlock(&rp_ctx->commit_lock);
+    return true;
+}
+
+/**
+ * @brief Leaves the read side entered by ::rp_read_lock using the read-side slot.
+ */
+static void
+rp_read_unlock(rp_ctx_t *rp_ctx)
+{
+    ATOMIC_DEC(&rp_ctx->readers[rp_reader_slot].active);
+}
+
+/**
+ * @brief Acquires the commit_lock exclusively and waits until the read requests
+ * processed without the lock have finished.
+ */
+static void
+rp_write_lock(rp_ctx_t *rp_ctx)
+{
+    pthread_rwlock_wrlock(&rp_ctx->commit_lock);
+    ATOMIC_INC(&rp_ctx->commit_pending);
+    for (size_t i = 0; i < RP_THREAD_COUNT; ++i) {
+        while (0 != ATOMIC_LOAD(&rp_ctx->readers[i].active)) {
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @brief Releases the commit_lock acquired by ::rp_write_lock.
+ */
+static void
+rp_write_unlock(rp_ctx_t *rp_ctx)
+{
+    ATOMIC_DEC(&rp_ctx->commit_pending);
+    pthread_rwlock_unlock(&rp_ctx->commit_lock);
+}
+
 /**
  * @brief Dispatches received request message.
  */
 static int
 rp_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *skip_msg_cleanup)
 {
-    bool locked = false;
+    bool locked = false, exclusive = false, read_slot = false;
     int rc = SR_ERR_OK;
 
     CHECK_NULL_ARG4(rp_ctx, msg, msg->request, skip_msg_cleanup);
@@ -3392,17 +4279,22 @@ rp_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *ski
 
     if (NULL != session) {
         dm_clear_session_errors(session->dm_session);
+        if (SR__OPERATION__GET_SUBTREE_CHUNK != msg->request->operation) {
+            /* any other request may change the data trees of the session, drop the cursor */
+            rp_dt_free_subtree_ctx_content(&session->subtree_ctx);
+        }
+        if (SR__OPERATION__EXPORT_DATA != msg->request->operation) {
+            /* the export has been abandoned */
+            rp_dt_free_export_ctx_content(&session->export_ctx);
+        }
     }
 
     if (NULL != session && 0 == msg->request->_id) {
         /* generate new request id */
+        /* request IDs are matched only within the session, no need for a context-wide counter */
         pthread_mutex_lock(&session->total_req_cnt_mutex);
-        ++session->total_req_cnt;
+        msg->request->_id = ++session->total_req_cnt;
         pthread_mutex_unlock(&session->total_req_cnt_mutex);
-        pthread_mutex_lock(&rp_ctx->total_req_cnt_mutex);
-        ++rp_ctx->total_req_cnt;
-        msg->request->_id = rp_ctx->total_req_cnt;
-        pthread_mutex_unlock(&rp_ctx->total_req_cnt_mutex);
     }
 
     /* acquire lock for operation accessing data */
@@ -3412,19 +4304,27 @@ rp_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *ski
         case SR__OPERATION__GET_SUBTREE:
         case SR__OPERATION__GET_SUBTREES:
         case SR__OPERATION__GET_SUBTREE_CHUNK:
+        case SR__OPERATION__EXPORT_DATA:
+        case SR__OPERATION__GET_ITEMS_MULTI:
+            locked = rp_read_lock(rp_ctx);
+            read_slot = !locked;
+            break;
         case SR__OPERATION__SET_ITEM:
         case SR__OPERATION__SET_ITEM_STR:
         case SR__OPERATION__DELETE_ITEM:
         case SR__OPERATION__MOVE_ITEM:
+        case SR__OPERATION__SET_DATA_TREE:
         case SR__OPERATION__SESSION_REFRESH:
             pthread_rwlock_rdlock(&rp_ctx->commit_lock);
             locked = true;
             break;
         case SR__OPERATION__COMMIT:
         case SR__OPERATION__COPY_CONFIG:
+        case SR__OPERATION__ROLLBACK:
             if (!rp_ctx->block_further_commits) {
-                pthread_rwlock_wrlock(&rp_ctx->commit_lock);
+                rp_write_lock(rp_ctx);
                 locked = true;
+                exclusive = true;
             }
             break;
         default:
@@ -3465,6 +4365,12 @@ rp_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *ski
         case SR__OPERATION__GET_SUBTREE_CHUNK:
             rc = rp_get_subtree_chunk_req_process(rp_ctx, session, msg, skip_msg_cleanup);
             break;
+        case SR__OPERATION__EXPORT_DATA:
+            rc = rp_export_data_req_process(rp_ctx, session, msg, skip_msg_cleanup);
+            break;
+        case SR__OPERATION__GET_ITEMS_MULTI:
+            rc = rp_get_items_multi_req_process(rp_ctx, session, msg, skip_msg_cleanup);
+            break;
         case SR__OPERATION__SET_ITEM:
             rc = rp_set_item_req_process(rp_ctx, session, msg);
             break;
@@ -3477,6 +4383,9 @@ rp_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *ski
         case SR__OPERATION__MOVE_ITEM:
             rc = rp_move_item_req_process(rp_ctx, session, msg);
             break;
+        case SR__OPERATION__SET_DATA_TREE:
+            rc = rp_set_data_tree_req_process(rp_ctx, session, msg);
+            break;
         case SR__OPERATION__VALIDATE:
             rc = rp_validate_req_process(rp_ctx, session, msg);
             break;
@@ -3489,6 +4398,12 @@ rp_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *ski
         case SR__OPERATION__COPY_CONFIG:
             rc = rp_copy_config_req_process(rp_ctx, session, msg, skip_msg_cleanup);
             break;
+        case SR__OPERATION__CANCEL_CONFIRMED_COMMIT:
+            rc = rp_cancel_confirmed_commit_req_process(rp_ctx, session, msg);
+            break;
+        case SR__OPERATION__ROLLBACK:
+            rc = rp_rollback_req_process(rp_ctx, session, msg, skip_msg_cleanup);
+            break;
         case SR__OPERATION__SESSION_REFRESH:
             rc = rp_session_refresh_req_process(rp_ctx, session, msg);
             break;
@@ -3531,8 +4446,12 @@ rp_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg, bool *ski
     }
 
     /* release lock */
-    if (locked) {
+    if (exclusive) {
+        rp_write_unlock(rp_ctx);
+    } else if (locked) {
         pthread_rwlock_unlock(&rp_ctx->commit_lock);
+    } else if (read_slot) {
+        rp_read_unlock(rp_ctx);
     }
 
     return rc;
@@ -3601,6 +4520,12 @@ rp_internal_req_dispatch(rp_ctx_t *rp_ctx, rp_session_t *session, Sr__Msg *msg)
         case SR__OPERATION__NACM_RELOAD:
             rc = rp_nacm_reload_req_process(rp_ctx, session, msg);
             break;
+        case SR__OPERATION__COMMIT_COALESCE:
+            rc = rp_commit_coalesce_req_process(rp_ctx, msg);
+            break;
+        case SR__OPERATION__CONFIRMED_COMMIT_TIMEOUT:
+            rc = rp_confirmed_commit_timeout_req_process(rp_ctx, msg);
+            break;
         default:
             SR_LOG_ERR("Unsupported internal request received (operation=%d).", msg->internal_request->operation);
             rc = SR_ERR_UNSUPPORTED;
@@ -3709,6 +4634,9 @@ rp_session_cleanup(const rp_ctx_t *rp_ctx, rp_session_t *session)
 
     ly_set_free(session->get_items_ctx.nodes);
     free(session->get_items_ctx.xpath);
+    rp_dt_free_subtree_ctx_content(&session->subtree_ctx);
+    rp_dt_free_export_ctx_content(&session->export_ctx);
+    sr_msg_free(session->get_items_multi_ctx.resp);
     pthread_mutex_destroy(&session->msg_count_mutex);
     pthread_mutex_destroy(&session->total_req_cnt_mutex);
     pthread_mutex_destroy(&session->cur_req_mutex);
@@ -3751,6 +4679,11 @@ rp_worker_thread_execute(void *rp_ctx_p)
     rp_ctx->active_threads++;
     pthread_mutex_unlock(&rp_ctx->request_queue_mutex);
 
+    rp_reader_slot = (int) ATOMIC_INC(&rp_ctx->worker_cnt);
+    if (rp_reader_slot >= RP_THREAD_COUNT) {
+        rp_reader_slot = -1;
+    }
+
     do {
         /* process requests while there are some */
         dequeued_prev = false;
@@ -3995,10 +4928,16 @@ rp_init(cm_ctx_t *cm_ctx, rp_ctx_t **rp_ctx_p)
         goto cleanup;
     }
 
+    if (NULL != cm_ctx && CM_MODE_DAEMON == cm_get_connection_mode(cm_ctx)) {
+        /* warm up the data of the modules enabled in running datastore before the daemon gets ready */
+        rc = dm_load_running_enabled_data(ctx->dm_ctx);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Loading of running data failed.");
+    }
+
     rc = rp_setup_internal_state_data(ctx);
     CHECK_RC_MSG_GOTO(rc, cleanup, "Set up of internal state data failed");
 
-    pthread_mutex_init(&ctx->total_req_cnt_mutex, NULL);
+    pthread_mutex_init(&ctx->confirmed_commit_mutex, NULL);
 
     /* run worker threads */
     pthread_mutex_init(&ctx->request_queue_mutex, NULL);
@@ -4054,7 +4993,6 @@ rp_cleanup(rp_ctx_t *rp_ctx)
         }
         pthread_mutex_destroy(&rp_ctx->request_queue_mutex);
         pthread_cond_destroy(&rp_ctx->request_queue_cv);
-        pthread_mutex_destroy(&rp_ctx->total_req_cnt_mutex);
 
         while (sr_cbuff_dequeue(rp_ctx->request_queue, &req)) {
             if (NULL != req.msg) {
@@ -4062,6 +5000,9 @@ rp_cleanup(rp_ctx_t *rp_ctx)
             }
         }
         pthread_rwlock_destroy(&rp_ctx->commit_lock);
+        /* the saved data trees hold references to the schemas */
+        sr_btree_cleanup(rp_ctx->confirmed_commit_snapshot);
+        pthread_mutex_destroy(&rp_ctx->confirmed_commit_mutex);
         dm_cleanup(rp_ctx->dm_ctx);
         np_cleanup(rp_ctx->np_ctx);
         pm_cleanup(rp_ctx->pm_ctx);
@@ -4259,6 +5200,9 @@ rp_all_notifications_received(rp_ctx_t *rp_ctx, uint32_t commit_id, bool finishe
         case SR__OPERATION__COMMIT:
             op_str = "commit";
             break;
+        case SR__OPERATION__ROLLBACK:
+            op_str = "rollback";
+            break;
         default:
             SR_LOG_ERR_MSG("Invalid operation of a resumed commit request");
             rc = SR_ERR_INTERNAL;
@@ -547,6 +547,190 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Checks that all the nodes of the data tree are enabled in running datastore.
+ * @param [in] session
+ * @param [in] root first top-level node of the data tree
+ * @return Error code (SR_ERR_OK on success), SR_ERR_INVAL_ARG if a disabled node is found
+ */
+static int
+rp_dt_check_tree_enabled(dm_session_t *session, struct lyd_node *root)
+{
+    struct lyd_node *top = NULL, *next = NULL, *elem = NULL;
+    char *xpath = NULL;
+    int rc = SR_ERR_OK;
+
+    LY_TREE_FOR(root, top) {
+        LY_TREE_DFS_BEGIN(top, next, elem) {
+            if (!dm_is_enabled_check_recursively(elem->schema)) {
+                xpath = lyd_path(elem);
+                SR_LOG_ERR("The node is not enabled in running datastore %s", xpath);
+                rc = dm_report_error(session, "The node is not enabled in running datastore", xpath, SR_ERR_INVAL_ARG);
+                free(xpath);
+                return rc;
+            }
+            LY_TREE_DFS_END(top, next, elem);
+        }
+    }
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Tests whether any of the siblings is an instance of the schema node.
+ */
+static bool
+rp_dt_has_sibling_of_schema(struct lyd_node *siblings, const struct lys_node *schema)
+{
+    struct lyd_node *iter = NULL;
+
+    LY_TREE_FOR(siblings, iter) {
+        if (iter->schema == schema) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Duplicates the top-level subtrees of the data tree that are instances of
+ * the same schema nodes as the top-level nodes of the data to be merged.
+ * @param [in] root first top-level node of the data tree
+ * @param [in] new_tree first top-level node of the data to be merged
+ * @param [out] dup duplicated subtrees, NULL if none of them is affected by the merge
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+rp_dt_dup_merge_target(struct lyd_node *root, struct lyd_node *new_tree, struct lyd_node **dup)
+{
+    CHECK_NULL_ARG(dup);
+    struct lyd_node *iter = NULL, *node = NULL;
+    int rc = SR_ERR_OK;
+
+    *dup = NULL;
+    LY_TREE_FOR(root, iter) {
+        if (!rp_dt_has_sibling_of_schema(new_tree, iter->schema)) {
+            continue;
+        }
+        node = lyd_dup(iter, 1);
+        CHECK_NULL_NOMEM_GOTO(node, rc, cleanup);
+        if (NULL == *dup) {
+            *dup = node;
+        } else if (0 != lyd_insert_after((*dup)->prev, node)) {
+            SR_LOG_ERR_MSG("Memory allocation failed");
+            lyd_free(node);
+            rc = SR_ERR_INTERNAL;
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    if (SR_ERR_OK != rc) {
+        lyd_free_withsiblings(*dup);
+        *dup = NULL;
+    }
+    return rc;
+}
+
+int
+rp_dt_set_tree(dm_ctx_t *dm_ctx, dm_session_t *session, const char *xpath, const char *data, bool merge)
+{
+    CHECK_NULL_ARG4(dm_ctx, session, xpath, data);
+    int rc = SR_ERR_OK;
+    dm_data_info_t *info = NULL;
+    struct lyd_node *new_tree = NULL, *merged_tree = NULL, *node = NULL, *next = NULL;
+    char *module_name = NULL;
+
+    rc = sr_copy_first_ns(xpath, &module_name);
+    CHECK_RC_LOG_RETURN(rc, "Copying module name failed for xpath '%s'", xpath);
+
+    rc = dm_get_data_info(dm_ctx, session, module_name, &info);
+    free(module_name);
+    CHECK_RC_LOG_RETURN(rc, "Getting data tree failed for xpath '%s'", xpath);
+
+    /* parse the data, they are validated with the rest of the session changes during commit */
+    ly_errno = LY_SUCCESS;
+    new_tree = lyd_parse_mem(info->schema->ly_ctx, data, LYD_XML, LYD_OPT_TRUSTED | LYD_OPT_STRICT | LYD_OPT_CONFIG);
+    if (NULL == new_tree && LY_SUCCESS != ly_errno) {
+        SR_LOG_ERR("Parsing of the data tree for '%s' failed: %s", xpath, ly_errmsg(info->schema->ly_ctx));
+        return dm_report_error(session, ly_errmsg(info->schema->ly_ctx), xpath, SR_ERR_INVAL_ARG);
+    }
+
+    LY_TREE_FOR(new_tree, node) {
+        if (lyd_node_module(node) != info->schema->module) {
+            SR_LOG_ERR("The data tree for '%s' contains data of another module", xpath);
+            rc = dm_report_error(session, "The data tree contains data of another module", xpath, SR_ERR_INVAL_ARG);
+            goto cleanup;
+        }
+    }
+
+    /* check if nodes are enabled */
+    if (dm_is_running_ds_session(session)) {
+        rc = rp_dt_check_tree_enabled(session, new_tree);
+        if (SR_ERR_OK == rc && !merge) {
+            /* all the current nodes are going to be removed */
+            rc = rp_dt_check_tree_enabled(session, info->node);
+        }
+        if (SR_ERR_OK != rc) {
+            goto cleanup;
+        }
+    }
+
+    if (merge && NULL != info->node) {
+        if (NULL != new_tree) {
+            /* merge into copies of just the subtrees the data are merged with,
+             * failed merge must not leave the session data partially modified */
+            rc = rp_dt_dup_merge_target(info->node, new_tree, &merged_tree);
+            CHECK_RC_LOG_GOTO(rc, cleanup, "Duplication of the data tree for '%s' failed", xpath);
+            if (NULL == merged_tree) {
+                /* no existing subtree is affected, the data are just added */
+                merged_tree = new_tree;
+            } else if (0 != lyd_merge(merged_tree, new_tree, LYD_OPT_DESTRUCT | LYD_OPT_EXPLICIT)) {
+                SR_LOG_ERR("Merging of the data tree for '%s' failed: %s", xpath, ly_errmsg(info->schema->ly_ctx));
+                rc = SR_ERR_INTERNAL;
+            }
+            /* the source tree has been consumed */
+            new_tree = NULL;
+            if (SR_ERR_OK != rc) {
+                goto cleanup;
+            }
+
+            /* replace the affected subtrees with the merged ones */
+            node = info->node;
+            while (NULL != node) {
+                next = node->next;
+                if (rp_dt_has_sibling_of_schema(merged_tree, node->schema)) {
+                    sr_lyd_unlink(info, node);
+                    lyd_free(node);
+                }
+                node = next;
+            }
+            while (NULL != merged_tree) {
+                node = merged_tree;
+                merged_tree = merged_tree->next;
+                lyd_unlink(node);
+                if (0 != lyd_insert_sibling(&info->node, node)) {
+                    SR_LOG_ERR("Inserting of the merged data for '%s' failed: %s", xpath, ly_errmsg(info->schema->ly_ctx));
+                    lyd_free(node);
+                    rc = SR_ERR_INTERNAL;
+                    goto cleanup;
+                }
+            }
+        }
+    } else {
+        lyd_free_withsiblings(info->node);
+        info->node = new_tree;
+        new_tree = NULL;
+    }
+
+cleanup:
+    lyd_free_withsiblings(new_tree);
+    lyd_free_withsiblings(merged_tree);
+    if (SR_ERR_OK == rc) {
+        info->modified = true;
+    }
+    return rc;
+}
+
 int
 rp_dt_move_list_wrapper(rp_ctx_t *rp_ctx, rp_session_t *session, const char *xpath, sr_move_position_t position, const char *relative_item)
 {
@@ -622,6 +806,50 @@ rp_dt_delete_item_wrapper(rp_ctx_t *rp_ctx, rp_session_t *session, const char *x
     return rc;
 }
 
+int
+rp_dt_set_tree_wrapper(rp_ctx_t *rp_ctx, rp_session_t *session, const char *module_name, char *data, bool merge)
+{
+    int rc = SR_ERR_OK;
+    char *xpath = NULL;
+    CHECK_NULL_ARG_NORET5(rc, rp_ctx, rp_ctx->dm_ctx, session, session->dm_session, module_name);
+    if (SR_ERR_OK != rc) {
+        free(data);
+        return rc;
+    }
+
+    SR_LOG_INF("Set data tree request %s datastore, module: %s, %s", sr_ds_to_str(session->datastore), module_name,
+            merge ? "merge" : "replace");
+
+    rc = ac_check_module_permissions(session->ac_session, module_name, AC_OPER_READ_WRITE);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Access control check failed for module '%s'", module_name);
+        free(data);
+        return rc;
+    }
+
+    rc = sr_asprintf(&xpath, "/%s:*", module_name);
+    if (SR_ERR_OK != rc) {
+        free(data);
+        return rc;
+    }
+
+    rc = dm_add_set_tree_operation(session->dm_session, xpath, data, merge);
+    /* data are freed by dm_add_set_tree_operation */
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Adding operation to session op list failed");
+        free(xpath);
+        return rc;
+    }
+
+    rc = rp_dt_set_tree(rp_ctx->dm_ctx, session->dm_session, xpath, data, merge);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR_MSG("Set data tree failed");
+        dm_remove_last_operation(session->dm_session);
+    }
+    free(xpath);
+    return rc;
+}
+
 /**
  * @brief Perform the list of provided operations on the session. Stops
  * on the first error, if continue on error is false. If the continue on error
@@ -671,6 +899,9 @@ rp_dt_replay_operations(dm_ctx_t *ctx, dm_session_t *session, dm_sess_op_t *oper
         case DM_MOVE_OP:
             rc = rp_dt_move_list(ctx, session, op->xpath, op->detail.mov.position, op->detail.mov.relative_item);
             break;
+        case DM_SET_TREE_OP:
+            rc = rp_dt_set_tree(ctx, session, op->xpath, op->detail.tree.data, op->detail.tree.merge);
+            break;
         }
 
         if (SR_ERR_OK != rc) {
@@ -918,6 +1149,18 @@ rp_dt_commit(rp_ctx_t *rp_ctx, rp_session_t *session, dm_commit_context_t **c_ct
             *c_ctx = commit_ctx;
             return SR_ERR_OK;
         case DM_COMMIT_WRITE:
+            if (0 != session->confirm_timeout) {
+                /* keep the state before commit, it is restored unless the commit gets confirmed */
+                pthread_mutex_lock(&rp_ctx->confirmed_commit_mutex);
+                rc = dm_commit_save_snapshot(rp_ctx->dm_ctx, commit_ctx, &rp_ctx->confirmed_commit_snapshot);
+                pthread_mutex_unlock(&rp_ctx->confirmed_commit_mutex);
+                if (SR_ERR_OK != rc) {
+                    SR_LOG_ERR_MSG("Saving of the state before confirmed commit failed");
+                    commit_ctx->result = rc;
+                    state = DM_COMMIT_NOTIFY_ABORT;
+                    break;
+                }
+            }
             rc = dm_commit_writelock_fds(session->dm_session, commit_ctx);
             if (SR_ERR_OK == rc ) {
                 rc = dm_commit_write_files(session->dm_session, commit_ctx);
@@ -934,6 +1177,12 @@ rp_dt_commit(rp_ctx_t *rp_ctx, rp_session_t *session, dm_commit_context_t **c_ct
                     rc = rp_dt_reload_nacm(rp_ctx);
                 }
             }
+            if (SR_ERR_OK == rc && SR_DS_RUNNING == session->datastore) {
+                /* keep the inverse of the changes, so that the commit can be rolled back later */
+                if (SR_ERR_OK != dm_checkpoint_save(rp_ctx->dm_ctx, session->dm_session, commit_ctx)) {
+                    SR_LOG_WRN_MSG("Saving of the rollback checkpoint failed");
+                }
+            }
             state = DM_COMMIT_NOTIFY_APPLY;
             break;
         case DM_COMMIT_NOTIFY_APPLY:
@@ -1022,6 +1271,9 @@ rp_dt_create_refresh_errors(const dm_sess_op_t *ops, size_t op_count, sr_error_i
         case DM_MOVE_OP:
             (*errors)[*err_cnt].message = strdup("MOVE Operation can not be merged with current datastore state");
             break;
+        case DM_SET_TREE_OP:
+            (*errors)[*err_cnt].message = strdup("SET TREE Operation can not be merged with current datastore state");
+            break;
         default:
             (*errors)[*err_cnt].message = strdup("An operation can not be merged with current datastore state");
         }
@@ -1127,6 +1379,9 @@ rp_dt_copy_config_to_running(rp_ctx_t *rp_ctx, rp_session_t *session, const char
         rc = dm_get_data_info(rp_ctx->dm_ctx, session->dm_session, module_name, &info);
         CHECK_RC_MSG_GOTO(rc, cleanup3, "Get data info failed");
         info->modified = true;
+    } else if (SR_DS_CANDIDATE == src) {
+        /* modules not modified in candidate mirror running, only the candidate delta is committed */
+        SR_LOG_DBG_MSG("Copying only the modules modified in candidate datastore");
     } else {
         /* load all enabled models */
         rc = dm_get_all_modules(rp_ctx->dm_ctx, session->dm_session, true, &modules);
@@ -102,6 +102,30 @@ int rp_dt_set_item_wrapper(rp_ctx_t *rp_ctx, rp_session_t *session, const char *
  */
 int rp_dt_delete_item_wrapper(rp_ctx_t *rp_ctx, rp_session_t *session, const char *xpath, sr_edit_options_t opts);
 
+/**
+ * @brief Replaces the data of the module in the session by the data tree or merges the data tree into them.
+ * The data tree is validated together with the other changes during commit.
+ * In running datastore all the replaced and new nodes must be enabled.
+ * @param [in] dm_ctx
+ * @param [in] session
+ * @param [in] xpath xpath matching all the nodes of the module (/module:*)
+ * @param [in] data data tree in XML format
+ * @param [in] merge merge the data tree instead of replacing the data of the module
+ * @return Error code (SR_ERR_OK on success) SR_ERR_INVAL_ARG, SR_ERR_UNKNOWN_MODEL
+ */
+int rp_dt_set_tree(dm_ctx_t *dm_ctx, dm_session_t *session, const char *xpath, const char *data, bool merge);
+
+/**
+ * @brief Wraps ::rp_dt_set_tree call. In case of success logs the operation to the session's operation list.
+ * @param [in] rp_ctx
+ * @param [in] session
+ * @param [in] module_name
+ * @param [in] data - will be freed with the operation list
+ * @param [in] merge
+ * @return Error code (SR_ERR_OK on success)
+ */
+int rp_dt_set_tree_wrapper(rp_ctx_t *rp_ctx, rp_session_t *session, const char *module_name, char *data, bool merge);
+
 /**
  * @brief Saves the changes made in the session to the file system. To make sure that only one commit
  * can be in progress at the same time commit_lock in rp_ctx is used. To solve potential
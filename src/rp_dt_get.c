@@ -51,8 +51,8 @@ rp_dt_free_state_data_ctx_content (rp_state_data_ctx_t *state_data)
         sr_list_cleanup(state_data->subtree_nodes);
         state_data->subtree_nodes = NULL;
 
-        sr_list_cleanup(state_data->subscription_nodes);
-        state_data->subscription_nodes = NULL;
+        dm_dp_index_release(state_data->dp_index);
+        state_data->dp_index = NULL;
 
         if (NULL != state_data->requested_xpaths) {
             for (size_t i = 0; i < state_data->requested_xpaths->count; i++) {
@@ -307,25 +307,153 @@ cleanup:
     return rc;
 }
 
-int
-rp_dt_get_subtree_chunk(dm_ctx_t *dm_ctx, rp_session_t *rp_session, struct lyd_node *data_tree, sr_mem_ctx_t *sr_mem,
-        const char *xpath, size_t slice_offset, size_t slice_width, size_t child_limit, size_t depth_limit,
-        bool check_enabled, sr_node_t **chunk, char **chunk_id)
+void
+rp_dt_free_subtree_ctx_content(rp_dt_subtree_ctx_t *subtree_ctx)
+{
+    if (NULL != subtree_ctx) {
+        free(subtree_ctx->id);
+        memset(subtree_ctx, 0, sizeof(*subtree_ctx));
+    }
+}
+
+void
+rp_dt_free_export_ctx_content(rp_dt_export_ctx_t *export_ctx)
+{
+    if (NULL != export_ctx) {
+        free(export_ctx->module_name);
+        free(export_ctx->data);
+        memset(export_ctx, 0, sizeof(*export_ctx));
+    }
+}
+
+/**
+ * @brief Resolves xpath of a subtree chunk relative to the root of the previously returned chunk.
+ * Only xpaths constructed by the client library for the next chunk are recognized (ID of a chunk
+ * followed by any number of "/[module:]name[index]" steps).
+ *
+ * @return SR_ERR_NOT_FOUND if the xpath can not be resolved using the cursor
+ */
+static int
+rp_dt_subtree_ctx_resolve(dm_ctx_t *dm_ctx, rp_dt_subtree_ctx_t *subtree_ctx, struct lyd_node *data_tree,
+        const char *xpath, bool check_enabled, struct lyd_node **node)
+{
+    CHECK_NULL_ARG4(dm_ctx, subtree_ctx, xpath, node);
+    const struct lyd_node *cur_node = NULL, *child = NULL;
+    const char *cur = NULL, *name = NULL, *colon = NULL, *bracket = NULL;
+    const char *module_name = NULL;
+    size_t module_len = 0, name_len = 0, index = 0, count = 0;
+    char *end = NULL;
+    dm_schema_info_t *si = NULL;
+    bool enabled = true;
+    int rc = SR_ERR_OK;
+
+    if (NULL == subtree_ctx->id || NULL == subtree_ctx->node || data_tree != subtree_ctx->data_tree ||
+            0 != strncmp(xpath, subtree_ctx->id, strlen(subtree_ctx->id))) {
+        return SR_ERR_NOT_FOUND;
+    }
+
+    cur_node = subtree_ctx->node;
+    cur = xpath + strlen(subtree_ctx->id);
+    while ('\0' != *cur) {
+        if ('/' != *cur) {
+            return SR_ERR_NOT_FOUND;
+        }
+        name = cur + 1;
+        bracket = strchr(name, '[');
+        if (NULL == bracket) {
+            return SR_ERR_NOT_FOUND;
+        }
+        colon = memchr(name, ':', bracket - name);
+        if (NULL != colon) {
+            module_name = name;
+            module_len = colon - name;
+            name = colon + 1;
+        } else {
+            /* unprefixed node belongs to the module of its parent */
+            module_name = lyd_node_module(cur_node)->name;
+            module_len = strlen(module_name);
+        }
+        name_len = bracket - name;
+        index = strtoul(bracket + 1, &end, 10);
+        if (']' != *end || 0 == index) {
+            return SR_ERR_NOT_FOUND;
+        }
+        cur = end + 1;
+
+        /* find index-th child with the name */
+        count = 0;
+        child = (LYS_CONTAINER | LYS_LIST) & cur_node->schema->nodetype ? cur_node->child : NULL;
+        while (NULL != child) {
+            if (name_len == strlen(child->schema->name) && 0 == strncmp(name, child->schema->name, name_len) &&
+                    module_len == strlen(lyd_node_module(child)->name) &&
+                    0 == strncmp(module_name, lyd_node_module(child)->name, module_len) &&
+                    index == ++count) {
+                break;
+            }
+            child = child->next;
+        }
+        if (NULL == child) {
+            return SR_ERR_NOT_FOUND;
+        }
+        cur_node = child;
+    }
+
+    if (check_enabled) {
+        rc = dm_get_module_and_lock(dm_ctx, lyd_node_module(cur_node)->name, &si);
+        CHECK_RC_LOG_RETURN(rc, "Get schema info failed for %s", lyd_node_module(cur_node)->name);
+        enabled = dm_is_enabled_check_recursively(cur_node->schema);
+        pthread_rwlock_unlock(&si->model_lock);
+        if (!enabled) {
+            return SR_ERR_NOT_FOUND;
+        }
+    }
+
+    *node = (struct lyd_node *) cur_node;
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Retrieves a chunk of the subtree, optionally using and updating the cursor left behind
+ * by the previous call.
+ */
+static int
+rp_dt_get_subtree_chunk_internal(dm_ctx_t *dm_ctx, rp_session_t *rp_session, rp_dt_subtree_ctx_t *subtree_ctx,
+        struct lyd_node *data_tree, sr_mem_ctx_t *sr_mem, const char *xpath, size_t slice_offset, size_t slice_width,
+        size_t child_limit, size_t depth_limit, bool check_enabled, sr_node_t **chunk, char **chunk_id)
 {
     CHECK_NULL_ARG5(dm_ctx, data_tree, xpath, chunk, chunk_id);
     int rc = SR_ERR_OK;
     sr_node_t *tree = NULL;
     char *id = NULL, *id_cpy = NULL;
     struct lyd_node *node = NULL;
+    const struct lyd_node *slice_child = NULL;
+    size_t slice_child_offset = 0;
     sr_tree_pruning_cb pruning_cb = NULL;
     rp_tree_pruning_ctx_t *pruning_ctx = NULL;
 
-    rc = rp_dt_find_node(dm_ctx, data_tree, xpath, check_enabled, &node);
+    rc = SR_ERR_NOT_FOUND;
+    if (NULL != subtree_ctx) {
+        rc = rp_dt_subtree_ctx_resolve(dm_ctx, subtree_ctx, data_tree, xpath, check_enabled, &node);
+        if (SR_ERR_OK == rc) {
+            SR_LOG_DBG("Subtree chunk %s resolved using the cursor", xpath);
+            if (node == subtree_ctx->node) {
+                /* next slice of the same node */
+                slice_child = subtree_ctx->next_child;
+                slice_child_offset = subtree_ctx->next_offset;
+            }
+        } else if (SR_ERR_NOT_FOUND != rc) {
+            return rc;
+        }
+    }
     if (SR_ERR_OK != rc) {
-        if (SR_ERR_NOT_FOUND != rc) {
-            SR_LOG_ERR("Find node failed (%d) xpath %s", rc, xpath);
+        rp_dt_free_subtree_ctx_content(subtree_ctx);
+        rc = rp_dt_find_node(dm_ctx, data_tree, xpath, check_enabled, &node);
+        if (SR_ERR_OK != rc) {
+            if (SR_ERR_NOT_FOUND != rc) {
+                SR_LOG_ERR("Find node failed (%d) xpath %s", rc, xpath);
+            }
+            return rc;
         }
-        return rc;
     }
 
     rc = rp_dt_init_tree_pruning(dm_ctx, rp_session, node, data_tree, check_enabled, &pruning_cb, &pruning_ctx);
@@ -343,8 +471,8 @@ rp_dt_get_subtree_chunk(dm_ctx_t *dm_ctx, rp_session_t *rp_session, struct lyd_n
         ATOMIC_INC(&sr_mem->obj_count);
     }
 
-    rc = sr_copy_node_to_tree_chunk(node, slice_offset, slice_width, child_limit, depth_limit, pruning_cb,
-                                    (void *)pruning_ctx, tree);
+    rc = sr_copy_node_to_tree_slice(node, &slice_child, &slice_child_offset, slice_offset, slice_width, child_limit,
+                                    depth_limit, pruning_cb, (void *)pruning_ctx, tree);
     CHECK_RC_LOG_GOTO(rc, cleanup, "Copy node to tree failed for xpath %s", xpath);
 
     /* get ID of the tree chunk */
@@ -357,7 +485,21 @@ rp_dt_get_subtree_chunk(dm_ctx_t *dm_ctx, rp_session_t *rp_session, struct lyd_n
     rc = sr_mem_edit_string(sr_mem, &id_cpy, id);
     CHECK_RC_LOG_GOTO(rc, cleanup, "Failed to copy ID of a subtree chunk with xpath %s", xpath);
 
+    if (NULL != subtree_ctx) {
+        /* remember where the chunk has ended */
+        free(subtree_ctx->id);
+        subtree_ctx->id = id;
+        id = NULL;
+        subtree_ctx->data_tree = data_tree;
+        subtree_ctx->node = node;
+        subtree_ctx->next_child = slice_child;
+        subtree_ctx->next_offset = slice_child_offset;
+    }
+
 cleanup:
+    if (SR_ERR_OK != rc) {
+        rp_dt_free_subtree_ctx_content(subtree_ctx);
+    }
     free(id);
     rp_dt_cleanup_tree_pruning(pruning_ctx);
     if (SR_ERR_OK != rc) {
@@ -370,6 +512,15 @@ cleanup:
     return rc;
 }
 
+int
+rp_dt_get_subtree_chunk(dm_ctx_t *dm_ctx, rp_session_t *rp_session, struct lyd_node *data_tree, sr_mem_ctx_t *sr_mem,
+        const char *xpath, size_t slice_offset, size_t slice_width, size_t child_limit, size_t depth_limit,
+        bool check_enabled, sr_node_t **chunk, char **chunk_id)
+{
+    return rp_dt_get_subtree_chunk_internal(dm_ctx, rp_session, NULL, data_tree, sr_mem, xpath, slice_offset,
+            slice_width, child_limit, depth_limit, check_enabled, chunk, chunk_id);
+}
+
 int
 rp_dt_get_subtrees(dm_ctx_t *dm_ctx, rp_session_t *rp_session, struct lyd_node *data_tree, sr_mem_ctx_t *sr_mem,
         const char *xpath, bool check_enable, sr_node_t **subtrees, size_t *count)
@@ -599,39 +750,6 @@ rp_dt_get_tree_roots(dm_schema_info_t *schema_info, const char *xpath, struct ly
     return rc;
 }
 
-static int
-rp_dt_subscriptions_to_schema_nodes(dm_ctx_t *dm_ctx, sr_list_t *subscriptions, sr_list_t **subscr_nodes)
-{
-    CHECK_NULL_ARG2(dm_ctx, subscr_nodes);
-    int rc = SR_ERR_OK;
-    struct lys_node *sub_node = NULL;
-    sr_list_t *nodes = NULL;
-
-    rc = sr_list_init(&nodes);
-    CHECK_RC_MSG_RETURN(rc, "List init failed");
-
-    /* find schema nodes corresponding to the subscriptions */
-    if (NULL != subscriptions) {
-        for (size_t i = 0; i < subscriptions->count; i++) {
-            np_subscription_t *subscription = subscriptions->data[i];
-            rc = rp_dt_validate_node_xpath(dm_ctx, NULL, subscription->xpath,
-                        NULL, &sub_node);
-            CHECK_RC_LOG_GOTO(rc, cleanup, "Node validation failed for xpath %s", subscription->xpath);
-
-            rc = sr_list_add(nodes, sub_node);
-            CHECK_RC_MSG_GOTO(rc, cleanup, "List add failed");
-        }
-    }
-
-cleanup:
-    if (SR_ERR_OK != rc) {
-        sr_list_cleanup(nodes);
-    } else {
-        *subscr_nodes = nodes;
-    }
-    return rc;
-}
-
 static bool
 rp_dt_no_parent_list_until(struct lys_node *until, struct lys_node *node)
 {
@@ -655,16 +773,13 @@ rp_dt_no_parent_list_until(struct lys_node *until, struct lys_node *node)
 }
 
 static bool
-rp_dt_not_coverd_by_other_subs(sr_list_t *other, struct lys_node *node) {
-    if (NULL == other || NULL == node) {
+rp_dt_not_coverd_by_other_subs(dm_dp_index_t *dp_index, struct lys_node *node) {
+    if (NULL == dp_index || NULL == node) {
         return true;
     }
-    for (size_t i = 0; i < other->count; i++) {
-        struct lys_node *sub = (struct lys_node *) other->data[i];
-        if (sub == node) {
-            continue;
-        }
-        if (rp_dt_depth_under_subtree(sub, node, NULL)) {
+    for (struct lys_node *n = lys_parent(node); NULL != n; n = lys_parent(n)) {
+        dm_node_index_entry_t *entry = dm_node_index_get(dp_index->nodes_index, n);
+        if (NULL != entry && entry->item_cnt > 0) {
             return false;
         }
     }
@@ -784,9 +899,8 @@ rp_dt_xpath_requests_state_data(rp_ctx_t *rp_ctx, rp_session_t *session, dm_sche
             goto cleanup;
         }
 
-        rc = rp_dt_subscriptions_to_schema_nodes(rp_ctx->dm_ctx, state_data_ctx->subscriptions,
-                &session->state_data_ctx.subscription_nodes);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Subscriptions to schema nodes failed");
+        rc = dm_get_dp_index(rp_ctx->dm_ctx, schema_info, state_data_ctx->subscriptions, &state_data_ctx->dp_index);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to get the index of data provider subscriptions");
     }
 
 cleanup:
@@ -811,34 +925,25 @@ rp_dt_find_subscription_covering_subtree(rp_session_t *rp_session, struct lys_no
         return false;
     }
 
-    bool match = false;
-    size_t cnt = 0, match_index = 0;
-    int match_difference = -1;
-
-    cnt = (NULL != rp_session->state_data_ctx.subscriptions) ? rp_session->state_data_ctx.subscriptions->count : 0;
+    dm_dp_index_t *dp_index = rp_session->state_data_ctx.dp_index;
+    dm_node_index_entry_t *entry = NULL;
+    size_t depth = 0;
 
-    for (size_t j = 0; j < cnt; j++) {
-        struct lys_node *subs = (struct lys_node *) rp_session->state_data_ctx.subscription_nodes->data[j];
-        size_t depth = 0;
-        if (rp_dt_depth_under_subtree(subs, subtree_node, &depth)) {
-            if (!match_index || depth < match_difference) {
-                match_index = j;
-                match_difference = depth;
-                match = true;
-                SR_LOG_DBG("Found match for %s with depth %zu index %zu", subtree_node->name, depth, match_index);
-            }
-            if (depth == 0) {
-                /* exact match */
-                break;
-            }
-        }
+    if (NULL == dp_index) {
+        return false;
     }
 
-    if (match) {
-        *found_index = match_index;
+    /* the subscription to the node itself or to the closest ancestor wins */
+    for (struct lys_node *n = subtree_node; NULL != n; n = lys_parent(n), ++depth) {
+        entry = dm_node_index_get(dp_index->nodes_index, n);
+        if (NULL != entry && entry->item_cnt > 0) {
+            *found_index = entry->items[0];
+            SR_LOG_DBG("Found match for %s with depth %zu index %zu", subtree_node->name, depth, *found_index);
+            return true;
+        }
     }
 
-    return match;
+    return false;
 }
 
 bool
@@ -849,31 +954,19 @@ rp_dt_find_exact_match_subscription_for_node(rp_session_t *rp_session, struct ly
         return false;
     }
 
-    bool match = false;
-    size_t cnt = 0, match_index = 0;
+    dm_node_index_entry_t *entry = NULL;
 
-    cnt = (NULL != rp_session->state_data_ctx.subscriptions) ? rp_session->state_data_ctx.subscriptions->count : 0;
-
-    for (size_t j = 0; j < cnt; j++) {
-        struct lys_node *sub = (struct lys_node *) rp_session->state_data_ctx.subscription_nodes->data[j];
-        if (sub->nodetype != node->nodetype) {
-            continue;
-        }
-        size_t depth = 0;
-        if (rp_dt_depth_under_subtree(sub, node, &depth)) {
-            if (0 == depth) {
-                match_index = j;
-                match = true;
-                break;
-            }
-        }
+    if (NULL == rp_session->state_data_ctx.dp_index) {
+        return false;
     }
 
-    if (match) {
-        *found_index = match_index;
+    entry = dm_node_index_get(rp_session->state_data_ctx.dp_index->nodes_index, node);
+    if (NULL == entry || 0 == entry->item_cnt) {
+        return false;
     }
 
-    return match;
+    *found_index = entry->items[0];
+    return true;
 }
 
 /**
@@ -1069,13 +1162,16 @@ rp_dt_send_first_set_of_dp_requests(rp_ctx_t *rp_ctx, rp_session_t *rp_session)
 
         } else if (LYS_CONTAINER & subtree_node->nodetype) {
             SR_LOG_DBG("Subscription covering subtree not found, looking for a subscription covering at least part of subtree %s", subtree);
-            size_t cnt = (NULL != rp_session->state_data_ctx.subscriptions) ? rp_session->state_data_ctx.subscriptions->count : 0;
-            for (size_t j = 0; j < cnt; j++) {
-                struct lys_node *subs = (struct lys_node *) rp_session->state_data_ctx.subscription_nodes->data[j];
+            dm_dp_index_t *dp_index = rp_session->state_data_ctx.dp_index;
+            dm_node_index_entry_t *entry = (NULL != dp_index) ? dm_node_index_get(dp_index->nodes_index, subtree_node) : NULL;
+            size_t cnt = (NULL != entry) ? entry->desc_item_cnt : 0;
+            for (size_t k = 0; k < cnt; k++) {
+                size_t j = entry->desc_items[k];
+                struct lys_node *subs = (struct lys_node *) dp_index->nodes->data[j];
                 size_t depth = 0;
                 if (rp_dt_depth_under_subtree(subtree_node, subs, &depth)) {
                     if (1 == depth || (rp_dt_no_parent_list_until(subtree_node, subs))) {
-                        if (rp_dt_not_coverd_by_other_subs(rp_session->state_data_ctx.subscription_nodes, subs)) {
+                        if (rp_dt_not_coverd_by_other_subs(dp_index, subs)) {
                             match = true;
 
                             xp = lys_data_path(subs);
@@ -1262,6 +1358,91 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Fast path of get_item for an xpath addressing a single configuration leaf.
+ *
+ * Configuration leaf can not contain any state data, therefore the state data detection and
+ * data provider requests are skipped. The data are looked up directly in the session copy,
+ * the value is allocated in the memory context of the response. If the xpath does not
+ * resolve to an existing configuration leaf, the request is left for the regular path.
+ *
+ * @param [in] rp_ctx
+ * @param [in] rp_session
+ * @param [in] sr_mem
+ * @param [in] xpath
+ * @param [out] value
+ * @param [out] handled Set to TRUE if the request has been processed by the fast path.
+ * @return Error code (SR_ERR_OK on success)
+ */
+static int
+rp_dt_get_config_leaf(rp_ctx_t *rp_ctx, rp_session_t *rp_session, sr_mem_ctx_t *sr_mem, const char *xpath,
+        sr_val_t **value, bool *handled)
+{
+    int rc = SR_ERR_OK;
+    char *module_name = NULL;
+    dm_data_info_t *data_info = NULL;
+    struct lyd_node *node = NULL;
+    unsigned int node_cnt = 1;
+    sr_val_t *val = NULL;
+
+    *handled = false;
+
+    /* only exact-match xpaths, wildcards and unions would be evaluated twice in case of a miss */
+    if (RP_REQ_NEW != rp_session->state || 0 != rp_session->loaded_state_data[rp_session->datastore]->count ||
+            NULL != strpbrk(xpath, "*|(") || NULL != strstr(xpath, "//") || NULL != strstr(xpath, "..")) {
+        return SR_ERR_OK;
+    }
+
+    rc = sr_copy_first_ns(xpath, &module_name);
+    if (SR_ERR_OK != rc) {
+        /* let the regular path report the error */
+        return SR_ERR_OK;
+    }
+
+    rc = ac_check_node_permissions(rp_session->ac_session, xpath, AC_OPER_READ);
+    CHECK_RC_LOG_GOTO(rc, cleanup, "Access control check failed for xpath '%s'", xpath);
+
+    /* cache hit in the session copy does not lock the schema */
+    rc = dm_get_data_info(rp_ctx->dm_ctx, rp_session->dm_session, module_name, &data_info);
+    if (SR_ERR_OK != rc || NULL == data_info->node) {
+        rc = SR_ERR_OK;
+        goto cleanup;
+    }
+
+    rc = rp_dt_find_node(rp_ctx->dm_ctx, data_info->node, xpath, dm_is_running_ds_session(rp_session->dm_session), &node);
+    if (SR_ERR_OK != rc || LYS_LEAF != node->schema->nodetype || (LYS_CONFIG_R & node->schema->flags)) {
+        rc = SR_ERR_OK;
+        goto cleanup;
+    }
+    *handled = true;
+
+    rc = rp_dt_nacm_filtering(rp_ctx->dm_ctx, rp_session, data_info->node, &node, &node_cnt);
+    CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to filter node by NACM read access.");
+    if (0 == node_cnt) {
+        rc = SR_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+
+    val = sr_calloc(sr_mem, 1, sizeof(*val));
+    CHECK_NULL_NOMEM_GOTO(val, rc, cleanup);
+    if (sr_mem) {
+        val->_sr_mem = sr_mem;
+        ATOMIC_INC(&sr_mem->obj_count);
+    }
+
+    rc = rp_dt_get_value_from_node(node, val);
+    if (SR_ERR_OK != rc) {
+        SR_LOG_ERR("Get value from node failed for xpath %s", xpath);
+        sr_free_val(val);
+        goto cleanup;
+    }
+    *value = val;
+
+cleanup:
+    free(module_name);
+    return rc;
+}
+
 int
 rp_dt_get_value_wrapper(rp_ctx_t *rp_ctx, rp_session_t *rp_session, sr_mem_ctx_t *sr_mem, const char *xpath, sr_val_t **value)
 {
@@ -1271,6 +1452,12 @@ rp_dt_get_value_wrapper(rp_ctx_t *rp_ctx, rp_session_t *rp_session, sr_mem_ctx_t
 
     int rc = SR_ERR_OK;
     struct lyd_node *data_tree = NULL;
+    bool handled = false;
+
+    rc = rp_dt_get_config_leaf(rp_ctx, rp_session, sr_mem, xpath, value, &handled);
+    if (SR_ERR_OK != rc || handled) {
+        goto cleanup;
+    }
 
     rc = rp_dt_prepare_data(rp_ctx, rp_session, xpath, SR_API_VALUES, 0, &data_tree);
     CHECK_RC_LOG_GOTO(rc, cleanup, "rp_dt_prepare_data failed %s", sr_strerror(rc));
@@ -1438,6 +1625,12 @@ rp_dt_get_subtree_wrapper_with_opts(rp_ctx_t *rp_ctx, rp_session_t *rp_session,
 
     int rc = SR_ERR_OK;
     struct lyd_node *data_tree = NULL;
+    rp_dt_subtree_ctx_t *subtree_ctx = &rp_session->subtree_ctx;
+
+    if (0 < rp_session->loaded_state_data[rp_session->datastore]->count) {
+        /* loaded state data are about to be removed from the data tree, the cursor would be left dangling */
+        rp_dt_free_subtree_ctx_content(subtree_ctx);
+    }
 
     rc = rp_dt_prepare_data(rp_ctx, rp_session, xpath, SR_API_TREES, depth_limit, &data_tree);
     CHECK_RC_LOG_GOTO(rc, cleanup, "rp_dt_prepare_data failed %s", sr_strerror(rc));
@@ -1452,8 +1645,14 @@ rp_dt_get_subtree_wrapper_with_opts(rp_ctx_t *rp_ctx, rp_session_t *rp_session,
         goto cleanup;
     }
 
-    rc = rp_dt_get_subtree_chunk(rp_ctx->dm_ctx, rp_session, data_tree, sr_mem, xpath, slice_offset, slice_width,
-            child_limit, depth_limit, dm_is_running_ds_session(rp_session->dm_session), subtree, subtree_id);
+    if (0 < rp_session->loaded_state_data[rp_session->datastore]->count) {
+        /* the data tree will not stay the same until the next chunk is requested */
+        subtree_ctx = NULL;
+    }
+
+    rc = rp_dt_get_subtree_chunk_internal(rp_ctx->dm_ctx, rp_session, subtree_ctx, data_tree, sr_mem, xpath,
+            slice_offset, slice_width, child_limit, depth_limit, dm_is_running_ds_session(rp_session->dm_session),
+            subtree, subtree_id);
     if (SR_ERR_UNAUTHORIZED == rc) {
         rc = SR_ERR_NOT_FOUND;
     } else if (SR_ERR_OK != rc) {
@@ -1545,6 +1744,154 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Removes the subtrees selected by the pruning callback from the list of siblings.
+ */
+static int
+rp_dt_export_prune(sr_tree_pruning_cb pruning_cb, void *pruning_ctx, struct lyd_node **first)
+{
+    CHECK_NULL_ARG2(pruning_cb, first);
+    struct lyd_node *iter = NULL, *next = NULL;
+    bool prune = false;
+    int rc = SR_ERR_OK;
+
+    LY_TREE_FOR_SAFE(*first, next, iter) {
+        rc = pruning_cb(pruning_ctx, iter, &prune);
+        CHECK_RC_MSG_RETURN(rc, "Tree pruning failed");
+        if (prune) {
+            if (iter == *first) {
+                *first = next;
+            }
+            lyd_free(iter);
+        } else if ((LYS_CONTAINER | LYS_LIST) & iter->schema->nodetype) {
+            rc = rp_dt_export_prune(pruning_cb, pruning_ctx, &iter->child);
+            CHECK_RC_MSG_RETURN(rc, "Tree pruning failed");
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * @brief Serializes the data tree of the module into the export cursor.
+ */
+static int
+rp_dt_export_serialize(rp_ctx_t *rp_ctx, rp_session_t *rp_session, struct lyd_node *data_tree,
+        rp_dt_export_ctx_t *export_ctx)
+{
+    CHECK_NULL_ARG3(rp_ctx, rp_session, export_ctx);
+    struct lyd_node *filtered = NULL;
+    sr_tree_pruning_cb pruning_cb = NULL;
+    rp_tree_pruning_ctx_t *pruning_ctx = NULL;
+    int rc = SR_ERR_OK;
+
+    if (NULL == data_tree) {
+        /* nothing to export */
+        return rc;
+    }
+
+    rc = rp_dt_init_tree_pruning(rp_ctx->dm_ctx, rp_session, NULL, data_tree, false, &pruning_cb, &pruning_ctx);
+    CHECK_RC_MSG_RETURN(rc, "Failed to initialize tree pruning.");
+
+    if (NULL != pruning_ctx->nacm_data_val_ctx) {
+        /* NACM read access is enforced, serialize a filtered copy of the data */
+        filtered = sr_dup_datatree(data_tree);
+        CHECK_NULL_NOMEM_GOTO(filtered, rc, cleanup);
+        rc = rp_dt_export_prune(pruning_cb, pruning_ctx, &filtered);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "Failed to filter the data tree by NACM read access.");
+        data_tree = filtered;
+        if (NULL == data_tree) {
+            goto cleanup;
+        }
+    }
+
+    if (0 != lyd_print_mem(&export_ctx->data, data_tree, export_ctx->format, LYP_WITHSIBLINGS | LYP_FORMAT)) {
+        SR_LOG_ERR("Failed to serialize the data of module '%s': %s", export_ctx->module_name, ly_errmsg(data_tree->schema->module->ctx));
+        rc = SR_ERR_INTERNAL;
+        goto cleanup;
+    }
+    if (NULL != export_ctx->data) {
+        export_ctx->size = LYD_LYB == export_ctx->format ? lyd_lyb_data_length(export_ctx->data) : strlen(export_ctx->data);
+    }
+
+cleanup:
+    lyd_free_withsiblings(filtered);
+    rp_dt_cleanup_tree_pruning(pruning_ctx);
+    return rc;
+}
+
+int
+rp_dt_export_data_wrapper(rp_ctx_t *rp_ctx, rp_session_t *rp_session, sr_mem_ctx_t *sr_mem, const char *module_name,
+        LYD_FORMAT format, size_t offset, uint8_t **chunk, size_t *chunk_size, bool *last)
+{
+    CHECK_NULL_ARG4(rp_ctx, rp_ctx->dm_ctx, rp_session, rp_session->dm_session);
+    CHECK_NULL_ARG4(module_name, chunk, chunk_size, last);
+
+    int rc = SR_ERR_OK;
+    rp_dt_export_ctx_t *export_ctx = &rp_session->export_ctx;
+    struct lyd_node *data_tree = NULL;
+    char *xpath = NULL;
+    size_t size = 0;
+
+    *chunk = NULL;
+    *chunk_size = 0;
+    *last = false;
+
+    if (0 != offset) {
+        /* the data have been serialized when the first chunk was requested */
+        if (NULL == export_ctx->module_name || 0 != strcmp(module_name, export_ctx->module_name) ||
+                format != export_ctx->format || offset != export_ctx->offset) {
+            SR_LOG_ERR("No export of module '%s' in progress at offset %zu, session id=%"PRIu32".",
+                    module_name, offset, rp_session->id);
+            rc = SR_ERR_INVAL_ARG;
+            goto cleanup;
+        }
+    } else {
+        SR_LOG_INF("Export data request %s datastore, module: %s", sr_ds_to_str(rp_session->datastore), module_name);
+        rp_dt_free_export_ctx_content(export_ctx);
+
+        rc = sr_asprintf(&xpath, "/%s:*", module_name);
+        CHECK_RC_MSG_GOTO(rc, cleanup, "sr_asprintf failed");
+
+        rc = rp_dt_prepare_data(rp_ctx, rp_session, xpath, SR_API_TREES, SIZE_MAX, &data_tree);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "rp_dt_prepare_data failed %s", sr_strerror(rc));
+
+        if (RP_REQ_WAITING_FOR_DATA == rp_session->state) {
+            SR_LOG_DBG("Session id = %u is waiting for the data", rp_session->id);
+            free(xpath);
+            return rc;
+        }
+
+        export_ctx->module_name = strdup(module_name);
+        CHECK_NULL_NOMEM_GOTO(export_ctx->module_name, rc, cleanup);
+        export_ctx->format = format;
+
+        rc = rp_dt_export_serialize(rp_ctx, rp_session, data_tree, export_ctx);
+        CHECK_RC_LOG_GOTO(rc, cleanup, "Serialization of the data failed for module '%s'", module_name);
+    }
+
+    /* copy the next chunk of the serialized data */
+    size = MIN(SR_EXPORT_CHUNK_SIZE, export_ctx->size - export_ctx->offset);
+    if (0 < size) {
+        *chunk = sr_malloc(sr_mem, size);
+        CHECK_NULL_NOMEM_GOTO(*chunk, rc, cleanup);
+        memcpy(*chunk, export_ctx->data + export_ctx->offset, size);
+    }
+    export_ctx->offset += size;
+    *chunk_size = size;
+    *last = (export_ctx->offset == export_ctx->size);
+
+cleanup:
+    if (SR_ERR_OK != rc || *last) {
+        rp_dt_free_export_ctx_content(export_ctx);
+    }
+    free(xpath);
+    rp_session->state = RP_REQ_FINISHED;
+    free(rp_session->module_name);
+    rp_session->module_name = NULL;
+    return rc;
+}
+
 /**
  * @brief generates changes for the children of created/deleted container/list
  *
@@ -1893,6 +2240,36 @@ cleanup:
     return rc;
 }
 
+/**
+ * @brief Indexes the changes of the model by their schema nodes and all the ancestors of them,
+ * so that the changes selected by a subscription are found without walking through all the changes.
+ */
+static int
+rp_dt_index_changes(dm_model_subscription_t *ms)
+{
+    CHECK_NULL_ARG2(ms, ms->changes);
+    int rc = SR_ERR_OK;
+    sr_change_t *change = NULL;
+
+    rc = dm_node_index_init(&ms->changes_index);
+    CHECK_RC_MSG_RETURN(rc, "Node index init failed");
+
+    for (size_t i = 0; i < ms->changes->count; i++) {
+        change = (sr_change_t *) ms->changes->data[i];
+        for (struct lys_node *n = change->sch_node; NULL != n; n = lys_parent(n)) {
+            rc = dm_node_index_add(ms->changes_index, n, i, false);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Node index add failed");
+        }
+    }
+
+cleanup:
+    if (SR_ERR_OK != rc) {
+        sr_btree_cleanup(ms->changes_index);
+        ms->changes_index = NULL;
+    }
+    return rc;
+}
+
 int
 rp_dt_get_changes(rp_ctx_t *rp_ctx, rp_session_t *rp_session, dm_commit_context_t *c_ctx, const char *xpath,
         size_t offset, size_t limit, sr_list_t **matched_changes)
@@ -1938,6 +2315,10 @@ rp_dt_get_changes(rp_ctx_t *rp_ctx, rp_session_t *rp_session, dm_commit_context_
                 pthread_rwlock_unlock(&ms->changes_lock);
                 goto cleanup;
             }
+            if (SR_ERR_OK != rp_dt_index_changes(ms)) {
+                /* changes will be matched one by one */
+                SR_LOG_WRN("Changes of module %s could not be indexed", ms->schema_info->module_name);
+            }
             ms->changes_generated = true;
         }
     }
@@ -241,6 +241,24 @@ int rp_dt_get_subtrees_wrapper_with_opts(rp_ctx_t *rp_ctx, rp_session_t *rp_sess
         size_t slice_offset, size_t slice_width, size_t child_limit, size_t depth_limit, sr_node_t **subtrees, size_t *count,
         char ***subtree_ids);
 
+/**
+ * @brief Returns the next chunk of the complete data tree of a module serialized in the requested format.
+ * The data tree is serialized when the chunk with offset 0 is requested and kept in the session
+ * until the last chunk is returned.
+ * @param [in] rp_ctx
+ * @param [in] rp_session
+ * @param [in] sr_mem
+ * @param [in] module_name
+ * @param [in] format
+ * @param [in] offset - offset of the requested chunk, must follow the previously returned chunk unless it is 0
+ * @param [out] chunk - at most SR_EXPORT_CHUNK_SIZE bytes of the serialized data, NULL if chunk_size is 0
+ * @param [out] chunk_size
+ * @param [out] last - TRUE if the returned chunk is the last one
+ * @return Error code (SR_ERR_OK on success), SR_ERR_INVAL_ARG, SR_ERR_UNKNOWN_MODEL
+ */
+int rp_dt_export_data_wrapper(rp_ctx_t *rp_ctx, rp_session_t *rp_session, sr_mem_ctx_t *sr_mem, const char *module_name,
+        LYD_FORMAT format, size_t offset, uint8_t **chunk, size_t *chunk_size, bool *last);
+
 /**
  * @brief Transforms difflist to the set of changes
  * @param [in] difflist
@@ -294,6 +312,16 @@ int rp_dt_prepare_data(rp_ctx_t *rp_ctx, rp_session_t *rp_session, const char *x
  */
 void rp_dt_free_state_data_ctx_content (rp_state_data_ctx_t *state_data);
 
+/**
+ * @brief Frees the content of the get_subtree_chunk cursor and resets it.
+ */
+void rp_dt_free_subtree_ctx_content(rp_dt_subtree_ctx_t *subtree_ctx);
+
+/**
+ * @brief Frees the content of the export_data cursor and resets it.
+ */
+void rp_dt_free_export_ctx_content(rp_dt_export_ctx_t *export_ctx);
+
 /**
  * @brief Function tests whether node is located under(in schema hierarchy) subtree node.
  * @param [in] subtree
@@ -236,18 +236,30 @@ rp_dt_find_changes(dm_ctx_t *dm_ctx, dm_session_t *session, dm_model_subscriptio
 
     size_t cnt = 0; /* number of returned changes (in offset limit range) */
     size_t index = cache_hit ? change_ctx->offset : 0; /* number of matching changes */
+    size_t candidate_cnt = ms->changes->count; /* number of changes to be tested */
+    const size_t *candidates = NULL; /* positions of the selected changes, if they have been looked up in the index */
+    dm_node_index_entry_t *entry = NULL;
+
+    if (NULL != change_ctx->schema_node && NULL != ms->changes_index) {
+        /* the index lists exactly the changes of the selection node and its descendants */
+        entry = dm_node_index_get(ms->changes_index, change_ctx->schema_node);
+        candidates = NULL != entry ? entry->items : NULL;
+        candidate_cnt = NULL != entry ? entry->item_cnt : 0;
+    }
 
     rc = sr_list_init(changes);
     CHECK_RC_MSG_GOTO(rc, cleanup, "sr_list_init failed");
-    size_t position = 0; /* index to change set */
+    size_t position = 0; /* index to change set, or to candidates if the index is used */
 
     /* selection from model changes */
-    for (position = change_ctx->position; position < ms->changes->count; position++) {
-        bool match = false;
-        sr_change_t *change = (sr_change_t *) ms->changes->data[position];
+    for (position = change_ctx->position; position < candidate_cnt; position++) {
+        bool match = NULL != candidates;
+        sr_change_t *change = (sr_change_t *) ms->changes->data[NULL != candidates ? candidates[position] : position];
 
-        rc = rp_dt_match_change(change_ctx->schema_node, change->sch_node, &match);
-        CHECK_RC_MSG_GOTO(rc, cleanup, "Match subscription failed");
+        if (!match) {
+            rc = rp_dt_match_change(change_ctx->schema_node, change->sch_node, &match);
+            CHECK_RC_MSG_GOTO(rc, cleanup, "Match subscription failed");
+        }
 
         if (!match) {
             continue;
@@ -29,6 +29,16 @@
 #include "persistence_manager.h"
 
 #define RP_THREAD_COUNT 4  /**< Number of threads that RP uses for processing. */
+#define RP_CACHE_LINE_SIZE 64  /**< Size of the CPU cache line the per-thread counters are aligned to. */
+
+/**
+ * @brief Read-side slot of a worker thread. The slots are padded to the cache line size, so that
+ * readers running on different CPUs do not write to a shared cache line.
+ */
+typedef struct rp_reader_slot_s {
+    ATOMIC_UINT32_T active;                  /**< Nonzero while the thread processes a read request without commit_lock. */
+    char padding[RP_CACHE_LINE_SIZE - sizeof(ATOMIC_UINT32_T)];  /**< Padding up to the cache line size. */
+} rp_reader_slot_t;
 
 /**
  * @brief Structure that holds the context of an instance of Request Processor.
@@ -57,11 +67,16 @@ typedef struct rp_ctx_s {
     sr_list_t *inter_op_data_xpath;          /**< List of list containing subtree of the module that are handled by sysrepo */
 
     pthread_rwlock_t commit_lock;            /**< Lock to synchronize commit in this instance */
+    rp_reader_slot_t readers[RP_THREAD_COUNT];  /**< Read-side slots of the worker threads, read requests avoid commit_lock using them. */
+    ATOMIC_UINT32_T commit_pending;          /**< Nonzero while a commit holds or waits for exclusive access to the data. */
+    ATOMIC_UINT32_T worker_cnt;              /**< Number of worker threads that have been assigned a read-side slot. */
     bool do_not_generate_config_change;      /**< Config-change notification will not be generated */
 
-    /* request ID generator */
-    uint64_t total_req_cnt;                  /**< Total number of received requests for this context. */
-    pthread_mutex_t total_req_cnt_mutex;     /**< Mutex protecting total_req_cnt. */
+    /* confirmed commit */
+    uint32_t confirmed_commit_id;            /**< ID of the copy to running waiting for a confirmation, 0 if none is pending. */
+    uint32_t confirmed_commit_last_id;       /**< Last assigned confirmed commit ID. */
+    sr_btree_t *confirmed_commit_snapshot;   /**< Running data trees saved before the first unconfirmed copy. */
+    pthread_mutex_t confirmed_commit_mutex;  /**< Mutex guarding the confirmed commit state. */
 } rp_ctx_t;
 
 /**
@@ -73,6 +88,36 @@ typedef struct rp_dt_get_items_ctx {
     struct ly_set *nodes;   /**< nodes to be iterated through */
 } rp_dt_get_items_ctx_t;
 
+/**
+ * @brief Cursor into the session data tree that holds the state of the last get_subtree_chunk call.
+ */
+typedef struct rp_dt_subtree_ctx {
+    char *id;                           /**< ID of the last returned chunk */
+    const struct lyd_node *data_tree;   /**< data tree the cursor points into */
+    const struct lyd_node *node;        /**< root node of the last returned chunk */
+    const struct lyd_node *next_child;  /**< first child of the chunk root behind the last returned slice */
+    size_t next_offset;                 /**< offset of the next_child */
+} rp_dt_subtree_ctx_t;
+
+/**
+ * @brief Cursor into the serialized data of a module that holds the state of the last export_data call.
+ */
+typedef struct rp_dt_export_ctx {
+    char *module_name;                  /**< name of the exported module */
+    LYD_FORMAT format;                  /**< format of the serialized data */
+    char *data;                         /**< serialized data tree of the module */
+    size_t size;                        /**< size of the serialized data */
+    size_t offset;                      /**< offset of the next chunk to be returned */
+} rp_dt_export_ctx_t;
+
+/**
+ * @brief Progress of the last get_items_multi call, the request may be paused for operational data of each module.
+ */
+typedef struct rp_dt_get_items_multi_ctx {
+    Sr__Msg *resp;                      /**< response with the value sets of the already processed xpaths */
+    size_t index;                       /**< index of the first xpath that has not been processed yet */
+} rp_dt_get_items_multi_ctx_t;
+
 /**
  * @brief Cache structure that holds of the last get_changes_iter call
  */
@@ -80,7 +125,7 @@ typedef struct rp_dt_change_ctx_s {
     char *xpath;                        /**< xpath used for change identification */
     const struct lys_node *schema_node; /**< schema node corresponding to xpath, used for matching */
     size_t offset;                      /**< offset-th matched change to be returned */
-    size_t position;                    /**< index to the change set */
+    size_t position;                    /**< index to the change set, or to the indexed changes of the schema_node */
 } rp_dt_change_ctx_t;
 
 /**
@@ -103,7 +148,7 @@ typedef struct rp_state_data_ctx_s {
     sr_list_t *subscriptions;          /**< List of subscriptions from np for a module */
     sr_list_t *subtrees;               /**< List of state data subtrees to be loaded*/
     sr_list_t *subtree_nodes;          /**< List of schema nodes corresponding to state data subtrees */
-    sr_list_t *subscription_nodes;     /**< Schema node corresponding to the subscriptions */
+    dm_dp_index_t *dp_index;           /**< Index of the subscriptions by their schema nodes, shared with other requests */
     sr_list_t *requested_xpaths;       /**< List of xpath that has been requested and response has not been processed yet */
     bool overlapping_leaf_subscription;/**< Flags signalizing that ther is a subscription for leaf or leaf-list under a container or a list */
     size_t internal_state_data_index;   /**< Index to the module of internal state data structures in rp_ctx */
@@ -119,12 +164,17 @@ typedef struct rp_session_s {
     sr_datastore_t datastore;            /**< Datastore selected for this session. */
     uint32_t options;                    /**< Session options used to override default session behavior. */
     uint32_t commit_id;                  /**< Commit ID in case that this is a notification session or session is about to resume commit processing. */
+    uint32_t confirm_timeout;            /**< Confirm timeout of the copy to running being processed, 0 if it needs no confirmation. */
+    bool rollback;                       /**< Internal session rolling back an unconfirmed commit, stopped once the rollback finishes. */
     uint32_t msg_count;                  /**< Count of unprocessed messages (including waiting in queue). */
     pthread_mutex_t msg_count_mutex;     /**< Mutex for msg_count counter. */
     bool stop_requested;                 /**< Session stop has been requested. */
     ac_session_t *ac_session;            /**< Access Control module's session context. */
     dm_session_t *dm_session;            /**< Data Manager's session context. */
     rp_dt_get_items_ctx_t get_items_ctx; /**< Context for get_items_iter calls. */
+    rp_dt_subtree_ctx_t subtree_ctx;     /**< Cursor for get_subtree_chunk calls. */
+    rp_dt_export_ctx_t export_ctx;       /**< Cursor for export_data calls. */
+    rp_dt_get_items_multi_ctx_t get_items_multi_ctx;  /**< Progress of the current get_items_multi call. */
     rp_dt_change_ctx_t change_ctx;       /**< Context for iteration over the changes */
 
     /* request ID generator */
@@ -134,6 +184,7 @@ typedef struct rp_session_s {
     /* current request - used for data retrieval calls which may need state data */
     rp_request_state_t state;            /**< the state of the request processing used if the operational data are requested */
     size_t dp_req_waiting;               /**< number of waiting request to operational data providers */
+    uint32_t oper_data_wait_id;          /**< id of the last wait for operational data, timeouts of the earlier waits are ignored */
     Sr__Msg *req;                        /**< request that is waiting for operational data */
     char *module_name;                   /**< data tree name used in the current request */
     pthread_mutex_t cur_req_mutex;       /**< mutex guarding information about currently processed request */
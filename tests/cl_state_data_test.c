@@ -1356,6 +1356,81 @@ cl_partialy_covered_by_subscription(void **state)
     sr_list_cleanup(xpath_retrieved);
 }
 
+static void
+cl_get_items_multi_state_data(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+    sr_session_ctx_t *session = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    sr_list_t *xpath_retrieved = NULL;
+    sr_val_set_t *val_sets = NULL;
+    int rc = SR_ERR_OK;
+
+    const char *xpaths[] = {
+        "/state-module:bus/gps_located",
+        "/state-module:bus/distance_travelled",
+        "/state-module:bus/gps_located",
+    };
+    size_t xpath_cnt = sizeof(xpaths) / sizeof(*xpaths);
+
+    rc = sr_list_init(&xpath_retrieved);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* start session */
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_module_change_subscribe(session, "state-module", cl_whole_module_cb, NULL,
+            0, SR_SUBSCR_DEFAULT, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* subscribe data providers */
+    rc = sr_dp_get_items_subscribe(session, "/state-module:bus/distance_travelled", cl_dp_distance_travelled, xpath_retrieved, SR_SUBSCR_CTX_REUSE, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_dp_get_items_subscribe(session, "/state-module:bus/gps_located", cl_dp_gps_located, xpath_retrieved, SR_SUBSCR_CTX_REUSE, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* retrieve data, each xpath has its own result */
+    rc = sr_get_items_multi(session, xpaths, xpath_cnt, &val_sets);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(val_sets);
+
+    assert_int_equal(SR_ERR_OK, val_sets[0].result);
+    assert_int_equal(1, val_sets[0].value_cnt);
+    assert_string_equal("/state-module:bus/gps_located", val_sets[0].values[0].xpath);
+    assert_int_equal(SR_BOOL_T, val_sets[0].values[0].type);
+
+    assert_int_equal(SR_ERR_OK, val_sets[1].result);
+    assert_int_equal(1, val_sets[1].value_cnt);
+    assert_string_equal("/state-module:bus/distance_travelled", val_sets[1].values[0].xpath);
+    assert_int_equal(SR_UINT32_T, val_sets[1].values[0].type);
+    assert_int_equal(999, val_sets[1].values[0].data.uint32_val);
+
+    assert_int_equal(SR_ERR_OK, val_sets[2].result);
+    assert_int_equal(1, val_sets[2].value_cnt);
+    assert_string_equal("/state-module:bus/gps_located", val_sets[2].values[0].xpath);
+
+    sr_free_val_sets(val_sets, xpath_cnt);
+
+    /* the state data of the module are requested once for all the xpaths */
+    const char *xpath_expected_to_be_loaded [] = {
+        "/state-module:bus/gps_located",
+        "/state-module:bus/distance_travelled",
+    };
+    CHECK_LIST_OF_STRINGS(xpath_retrieved, xpath_expected_to_be_loaded);
+
+    /* cleanup */
+    sr_unsubscribe(session, subscription);
+    sr_session_stop(session);
+
+    for (size_t i = 0; i < xpath_retrieved->count; i++) {
+        free(xpath_retrieved->data[i]);
+    }
+    sr_list_cleanup(xpath_retrieved);
+}
+
 static void
 cl_partialy_covered_by_subscription_tree(void **state)
 {
@@ -3126,6 +3201,7 @@ main()
         cmocka_unit_test_setup_teardown(cl_parent_subscription, sysrepo_setup, sysrepo_teardown),
         cmocka_unit_test_setup_teardown(cl_parent_subscription_tree, sysrepo_setup, sysrepo_teardown),
         cmocka_unit_test_setup_teardown(cl_partialy_covered_by_subscription, sysrepo_setup, sysrepo_teardown),
+        cmocka_unit_test_setup_teardown(cl_get_items_multi_state_data, sysrepo_setup, sysrepo_teardown),
         cmocka_unit_test_setup_teardown(cl_partialy_covered_by_subscription_tree, sysrepo_setup, sysrepo_teardown),
         cmocka_unit_test_setup_teardown(cl_missing_subscription, sysrepo_setup, sysrepo_teardown),
         cmocka_unit_test_setup_teardown(cl_missing_subscription_tree, sysrepo_setup, sysrepo_teardown),
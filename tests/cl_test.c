@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <limits.h>
 #include <setjmp.h>
 #include <cmocka.h>
 #include <string.h>
@@ -222,12 +223,82 @@ cl_multiconnect_test(void **state)
     sr_disconnect(conn2);
 }
 
+typedef struct cl_pool_thread_ctx_s {
+    sr_session_ctx_t *session;
+    int rc;
+} cl_pool_thread_ctx_t;
+
+static void *
+cl_connection_pool_thread(void *arg)
+{
+    cl_pool_thread_ctx_t *ctx = (cl_pool_thread_ctx_t*)arg;
+    sr_val_t *value = NULL;
+
+    for (size_t i = 0; i < 100; ++i) {
+        ctx->rc = sr_get_item(ctx->session, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value);
+        if (SR_ERR_OK != ctx->rc) {
+            break;
+        }
+        sr_free_val(value);
+        value = NULL;
+    }
+
+    return NULL;
+}
+
+static void
+cl_connection_pool_test(void **state)
+{
+    sr_conn_ctx_t *conn = NULL;
+    sr_session_ctx_t *sessions[6] = { NULL, };
+    cl_pool_thread_ctx_t thread_ctx[6] = {{ 0, }};
+    pthread_t threads[6];
+    int rc = 0;
+
+    /* connect to sysrepo with a pool of 3 sockets */
+    rc = sr_connect("cl_test", SR_CONN_DEFAULT | SR_CONN_POOL_SIZE(3), &conn);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(conn);
+
+    /* start more sessions than there are sockets */
+    for (size_t i = 0; i < 6; ++i) {
+        rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &sessions[i]);
+        assert_int_equal(rc, SR_ERR_OK);
+        assert_non_null(sessions[i]);
+    }
+
+    /* stop one session and start it again - should reuse the least used socket */
+    rc = sr_session_stop(sessions[1]);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &sessions[1]);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* send requests on all sessions in parallel */
+    for (size_t i = 0; i < 6; ++i) {
+        thread_ctx[i].session = sessions[i];
+        pthread_create(&threads[i], NULL, cl_connection_pool_thread, &thread_ctx[i]);
+    }
+    for (size_t i = 0; i < 6; ++i) {
+        pthread_join(threads[i], NULL);
+        assert_int_equal(thread_ctx[i].rc, SR_ERR_OK);
+    }
+
+    /* remaining sessions should be released automatically by disconnect */
+    rc = sr_session_stop(sessions[0]);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    sr_disconnect(conn);
+}
+
 static void
 cl_disconnect_test(void **state)
 {
-    /* used to retrieve fd from conn_ctx */
-    typedef struct test_sr_conn_ctx_s {
+    /* used to retrieve fd of the first socket from conn_ctx */
+    typedef struct test_cl_socket_s {
         int fd;
+    } test_cl_socket_t;
+    typedef struct test_sr_conn_ctx_s {
+        test_cl_socket_t *sockets;
     } test_sr_conn_ctx_t;
 
     sr_conn_ctx_t *conn = NULL;
@@ -253,7 +324,7 @@ cl_disconnect_test(void **state)
     assert_int_equal(rc, SR_ERR_OK);
 
     /* close the socket to the server and replace it with pipe */
-    fd_to_close = ((test_sr_conn_ctx_t*)conn)->fd;
+    fd_to_close = ((test_sr_conn_ctx_t*)conn)->sockets[0].fd;
     printf("fd %d will be closed\n", fd_to_close);
     close(fd_to_close);
     pipe(pipefd);
@@ -715,6 +786,64 @@ cl_get_items_test(void **state)
     assert_int_equal(rc, SR_ERR_OK);
 }
 
+static void
+cl_get_items_multi_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    createDataTreeIETFinterfacesModule();
+    sr_session_ctx_t *session = NULL;
+    sr_val_set_t *val_sets = NULL;
+    int rc = 0;
+
+    const char *xpaths[] = {
+        "/ietf-interfaces:interfaces/interface[name='eth0']/*",
+        "/unknown-model:abc",
+        "/small-module:item/name",
+        "/test-module:main/numbers",
+        "/ietf-interfaces:interfaces/interface[name='eth1']/enabled",
+    };
+    size_t xpath_cnt = sizeof(xpaths) / sizeof(*xpaths);
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(session);
+
+    /* no xpath */
+    rc = sr_get_items_multi(session, xpaths, 0, &val_sets);
+    assert_int_equal(SR_ERR_INVAL_ARG, rc);
+
+    /* perform a get-items-multi request, each xpath has its own result */
+    rc = sr_get_items_multi(session, xpaths, xpath_cnt, &val_sets);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(val_sets);
+
+    assert_int_equal(SR_ERR_OK, val_sets[0].result);
+    assert_int_equal(5, val_sets[0].value_cnt);
+    assert_string_equal("/ietf-interfaces:interfaces/interface[name='eth0']/name", val_sets[0].values[0].xpath);
+
+    assert_int_equal(SR_ERR_UNKNOWN_MODEL, val_sets[1].result);
+    assert_null(val_sets[1].values);
+
+    assert_int_equal(SR_ERR_NOT_FOUND, val_sets[2].result);
+    assert_int_equal(0, val_sets[2].value_cnt);
+
+    assert_int_equal(SR_ERR_OK, val_sets[3].result);
+    assert_int_equal(3, val_sets[3].value_cnt);
+
+    assert_int_equal(SR_ERR_OK, val_sets[4].result);
+    assert_int_equal(1, val_sets[4].value_cnt);
+    assert_int_equal(SR_BOOL_T, val_sets[4].values[0].type);
+
+    sr_free_val_sets(val_sets, xpath_cnt);
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
 static void
 cl_get_subtrees_test(void **state)
 {
@@ -785,6 +914,86 @@ cl_get_subtrees_test(void **state)
     assert_int_equal(rc, SR_ERR_OK);
 }
 
+typedef struct cl_export_buf_s {
+    char *data;
+    size_t size;
+    size_t chunk_cnt;
+    int ret;
+} cl_export_buf_t;
+
+static int
+cl_export_data_cb(const void *chunk, size_t size, void *private_ctx)
+{
+    cl_export_buf_t *buf = private_ctx;
+    char *tmp = NULL;
+
+    tmp = realloc(buf->data, buf->size + size + 1);
+    assert_non_null(tmp);
+    memcpy(tmp + buf->size, chunk, size);
+    buf->data = tmp;
+    buf->size += size;
+    buf->data[buf->size] = '\0';
+    ++buf->chunk_cnt;
+    return buf->ret;
+}
+
+static void
+cl_export_data_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session = NULL;
+    cl_export_buf_t buf = { 0, };
+    int rc = 0;
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* export the data in XML */
+    rc = sr_export_data(session, "example-module", SR_DATA_XML, cl_export_data_cb, &buf);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_true(1 <= buf.chunk_cnt);
+    assert_non_null(buf.data);
+    assert_non_null(strstr(buf.data, "<container xmlns=\"urn:ietf:params:xml:ns:yang:example\">"));
+    assert_non_null(strstr(buf.data, "<key1>key1</key1>"));
+    free(buf.data);
+    memset(&buf, 0, sizeof buf);
+
+    /* export the data in JSON */
+    rc = sr_export_data(session, "example-module", SR_DATA_JSON, cl_export_data_cb, &buf);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(buf.data);
+    assert_non_null(strstr(buf.data, "\"example-module:container\""));
+    free(buf.data);
+    memset(&buf, 0, sizeof buf);
+
+    /* an error returned by the callback stops the export */
+    buf.ret = SR_ERR_INTERNAL;
+    rc = sr_export_data(session, "example-module", SR_DATA_XML, cl_export_data_cb, &buf);
+    assert_int_equal(rc, SR_ERR_INTERNAL);
+    assert_int_equal(1, buf.chunk_cnt);
+    free(buf.data);
+    memset(&buf, 0, sizeof buf);
+
+    /* the export can be started again */
+    rc = sr_export_data(session, "example-module", SR_DATA_XML, cl_export_data_cb, &buf);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(buf.data);
+    free(buf.data);
+    memset(&buf, 0, sizeof buf);
+
+    /* unknown module */
+    rc = sr_export_data(session, "unknown-module", SR_DATA_XML, cl_export_data_cb, &buf);
+    assert_int_equal(rc, SR_ERR_UNKNOWN_MODEL);
+    assert_int_equal(0, buf.chunk_cnt);
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
 static void
 cl_get_items_iter_test(void **state)
 {
@@ -1070,6 +1279,96 @@ cl_iterative_tree_traversal(void **state)
     assert_int_equal(rc, SR_ERR_OK);
 }
 
+/**
+ * @brief Fully loads the iterative tree and compares it with the tree retrieved at once.
+ */
+static void
+cl_iterative_tree_compare(sr_session_ctx_t *session, sr_node_t *tree, const char *xpath)
+{
+    sr_node_t *expected = NULL;
+    char *expected_str = NULL, *tree_str = NULL;
+    size_t visited_iter = 0;
+    int rc = SR_ERR_OK;
+
+    rc = cl_tree_traversal(session, tree, SIZE_MAX, &visited_iter);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = sr_get_subtree(session, xpath, SR_GET_SUBTREE_DEFAULT, &expected);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = sr_print_tree_mem(&expected_str, expected, INT_MAX);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = sr_print_tree_mem(&tree_str, tree, INT_MAX);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_string_equal(expected_str, tree_str);
+
+    free(expected_str);
+    free(tree_str);
+    sr_free_tree(expected);
+}
+
+static void
+cl_iterative_tree_cursor_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session = NULL, *edit_session = NULL;
+    sr_node_t *tree = NULL;
+    sr_val_t value = { 0, };
+    size_t visited_iter = 0;
+    int rc = 0;
+
+    createDataTreeLargeIETFinterfacesModule(25);
+
+    /* start sessions */
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &edit_session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* consecutive chunks are served from the cursor: the next slice of interfaces
+     * and the content of the nodes below the root of the previous chunk */
+    rc = sr_get_subtree(session, "/ietf-interfaces:interfaces", SR_GET_SUBTREE_ITERATIVE, &tree);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(tree);
+    cl_iterative_tree_compare(session, tree, "/ietf-interfaces:interfaces");
+    sr_free_tree(tree);
+
+    /* load the first chunk and the content of the first interface */
+    rc = sr_get_subtree(session, "/ietf-interfaces:interfaces", SR_GET_SUBTREE_ITERATIVE, &tree);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(tree);
+    rc = cl_tree_traversal(session, tree, 12, &visited_iter);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_int_equal(visited_iter, 1);
+
+    /* change the data not loaded yet: a nested leaf and a new interface behind the first slice */
+    value.type = SR_UINT8_T;
+    value.data.uint8_val = 16;
+    rc = sr_set_item(edit_session, "/ietf-interfaces:interfaces/interface[name='eth3']/ietf-ip:ipv4/"
+            "address[ip='192.168.1.3']/prefix-length", &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    value.type = SR_IDENTITYREF_T;
+    value.data.identityref_val = "iana-if-type:ethernetCsmacd";
+    rc = sr_set_item(edit_session, "/ietf-interfaces:interfaces/interface[name='eth26']/type", &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(edit_session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* the refresh drops the cursor, the remaining chunks come from the refreshed data */
+    rc = sr_session_refresh(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_iterative_tree_compare(session, tree, "/ietf-interfaces:interfaces");
+    sr_free_tree(tree);
+
+    /* stop the sessions */
+    rc = sr_session_stop(edit_session);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
 static void
 cl_iterative_trees_traversal(void **state)
 {
@@ -1269,6 +1568,64 @@ cl_set_item_str_test(void **state)
     assert_int_equal(rc, SR_ERR_OK);
 }
 
+static void
+cl_set_data_tree_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session = NULL;
+    sr_val_t *values = NULL, *v = NULL;
+    size_t value_cnt = 0;
+    int rc = 0;
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* replace the data of the module */
+    rc = sr_set_data_tree(session, "example-module",
+            "<container xmlns=\"urn:ietf:params:xml:ns:yang:example\">"
+            "<list><key1>k1</key1><key2>k2</key2><leaf>replaced</leaf></list>"
+            "</container>", SR_DATA_TREE_REPLACE);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_get_items(session, "/example-module:container/list", &values, &value_cnt);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_int_equal(1, value_cnt);
+    sr_free_values(values, value_cnt);
+
+    /* merge another list instance */
+    rc = sr_set_data_tree(session, "example-module",
+            "<container xmlns=\"urn:ietf:params:xml:ns:yang:example\">"
+            "<list><key1>k3</key1><key2>k4</key2><leaf>merged</leaf></list>"
+            "</container>", SR_DATA_TREE_MERGE);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_get_items(session, "/example-module:container/list", &values, &value_cnt);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_int_equal(2, value_cnt);
+    sr_free_values(values, value_cnt);
+
+    /* commit */
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_get_item(session, "/example-module:container/list[key1='k1'][key2='k2']/leaf", &v);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_string_equal("replaced", v->data.string_val);
+    sr_free_val(v);
+
+    /* invalid data */
+    rc = sr_set_data_tree(session, "example-module", "<unknown xmlns=\"urn:ietf:params:xml:ns:yang:example\"/>",
+            SR_DATA_TREE_MERGE);
+    assert_int_equal(rc, SR_ERR_INVAL_ARG);
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
 static void
 cl_delete_item_test(void **state)
 {
@@ -2273,63 +2630,247 @@ cl_notification_test(void **state)
     assert_int_equal(rc, SR_ERR_OK);
 }
 
+typedef struct cl_data_session_test_ctx_s {
+    const char *expected;  /**< Value expected to be read within the callback. */
+    volatile int verify_cnt;
+    volatile int mismatch_cnt;
+} cl_data_session_test_ctx_t;
+
+static int
+test_data_session_change_cb(sr_session_ctx_t *session, const char *module_name, sr_notif_event_t event, void *private_ctx)
+{
+    cl_data_session_test_ctx_t *ctx = (cl_data_session_test_ctx_t*)private_ctx;
+    sr_val_t *value = NULL;
+    int rc = SR_ERR_OK;
+
+    if (SR_EV_VERIFY != event) {
+        return SR_ERR_OK;
+    }
+
+    /* the session must provide the data of the commit being verified */
+    rc = sr_get_item(session, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value);
+    if (SR_ERR_OK != rc || 0 != strcmp(ctx->expected, value->data.string_val)) {
+        ctx->mismatch_cnt += 1;
+    }
+    sr_free_val(value);
+    ctx->verify_cnt += 1;
+
+    return SR_ERR_OK;
+}
+
 static void
-cl_copy_config_test(void **state)
+cl_data_session_reuse_test(void **state)
 {
     sr_conn_ctx_t *conn = *state;
     assert_non_null(conn);
 
-    sr_session_ctx_t *session_startup = NULL, *session_running = NULL;
+    sr_session_ctx_t *session = NULL;
     sr_subscription_ctx_t *subscription = NULL;
-    int callback_called = 0;
-    sr_val_t value = { 0, }, *val = NULL;
+    cl_data_session_test_ctx_t ctx = { 0, };
+    const char *values[] = { "reuse-1", "reuse-2", "reuse-3", "reuse-4", "reuse-5", "reuse-6", "reuse-7", "reuse-8" };
+    sr_val_t value = { 0, };
     int rc = SR_ERR_OK;
 
-    /* start sessions */
-    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session_startup);
-    assert_int_equal(rc, SR_ERR_OK);
-    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session_running);
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
     assert_int_equal(rc, SR_ERR_OK);
 
-    /* copy to/from candidate */
-    rc = sr_copy_config(session_startup, NULL, SR_DS_STARTUP, SR_DS_CANDIDATE);
+    rc = sr_module_change_subscribe(session, "example-module", test_data_session_change_cb, &ctx,
+            0, SR_SUBSCR_DEFAULT, &subscription);
     assert_int_equal(rc, SR_ERR_OK);
 
-    /* copy-config all enabled models, currently none */
-    rc = sr_copy_config(session_startup, NULL, SR_DS_RUNNING, SR_DS_STARTUP);
-    assert_int_equal(rc, SR_ERR_OK);
+    /* more commits than pooled sessions, every one of them reads its own data */
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        ctx.expected = values[i];
+        value.type = SR_STRING_T;
+        value.data.string_val = (char*)values[i];
+        rc = sr_set_item(session, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value, SR_EDIT_DEFAULT);
+        assert_int_equal(rc, SR_ERR_OK);
+        rc = sr_commit(session);
+        assert_int_equal(rc, SR_ERR_OK);
+        assert_int_equal(i + 1, ctx.verify_cnt);
+    }
+    assert_int_equal(0, ctx.mismatch_cnt);
 
-    /* enable running DS for example-module */
-    rc = sr_module_change_subscribe(session_startup, "example-module", test_module_change_cb,
-            &callback_called, 0, SR_SUBSCR_DEFAULT | SR_SUBSCR_APPLY_ONLY, &subscription);
+    /* unsubscribe */
+    rc = sr_unsubscribe(NULL, subscription);
     assert_int_equal(rc, SR_ERR_OK);
 
-    /* edit config in running */
-    value.type = SR_STRING_T;
-    value.data.string_val = "copy_config_test";
-    rc = sr_set_item(session_running, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value, SR_EDIT_DEFAULT);
+    /* stop the session */
+    rc = sr_session_stop(session);
     assert_int_equal(rc, SR_ERR_OK);
+}
 
-    /* commit */
-    rc = sr_commit(session_running);
-
-    /* copy-config */
-    rc = sr_copy_config(session_startup, "example-module", SR_DS_RUNNING, SR_DS_STARTUP);
-    assert_int_equal(rc, SR_ERR_OK);
+typedef struct cl_coalesce_test_ctx_s {
+    volatile int apply_cnt;
+    volatile int leaf_change_max;  /* maximal number of changes of the leaf delivered in one notification */
+    volatile int iter_err_cnt;
+    char last_value[32];
+    char last_change[32];
+} cl_coalesce_test_ctx_t;
 
-    /* get-config from startup */
-    rc = sr_get_item(session_startup, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &val);
-    assert_int_equal(rc, SR_ERR_OK);
-    assert_string_equal(val->data.string_val, "copy_config_test");
-    sr_free_val(val);
+static int
+test_coalesce_change_cb(sr_session_ctx_t *session, const char *module_name, sr_notif_event_t event, void *private_ctx)
+{
+    cl_coalesce_test_ctx_t *ctx = (cl_coalesce_test_ctx_t*)private_ctx;
+    sr_change_iter_t *iter = NULL;
+    sr_change_oper_t oper;
+    sr_val_t *value = NULL, *old_value = NULL, *new_value = NULL;
+    char last_change[32] = { 0, };
+    int leaf_change_cnt = 0;
+    int rc = SR_ERR_OK;
 
-    /* edit config in running 2 */
-    value.type = SR_STRING_T;
-    value.data.string_val = "copy_config_modified";
-    rc = sr_set_item(session_running, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value, SR_EDIT_DEFAULT);
-    assert_int_equal(rc, SR_ERR_OK);
+    if (SR_EV_APPLY != event) {
+        return SR_ERR_OK;
+    }
 
-    /* commit */
+    rc = sr_get_item(session, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value);
+    if (SR_ERR_OK == rc) {
+        strncpy(ctx->last_value, value->data.string_val, sizeof(ctx->last_value) - 1);
+        sr_free_val(value);
+    }
+
+    /* the changes have to be the net changes of all the coalesced commits */
+    rc = sr_get_changes_iter(session, "/example-module:container", &iter);
+    if (SR_ERR_OK != rc) {
+        ctx->iter_err_cnt += 1;
+    } else {
+        while (SR_ERR_OK == sr_get_change_next(session, iter, &oper, &old_value, &new_value)) {
+            if (NULL != new_value && SR_STRING_T == new_value->type &&
+                    0 == strcmp("/example-module:container/list[key1='key1'][key2='key2']/leaf", new_value->xpath)) {
+                strncpy(last_change, new_value->data.string_val, sizeof(last_change) - 1);
+                leaf_change_cnt++;
+            }
+            sr_free_val(old_value);
+            sr_free_val(new_value);
+            old_value = new_value = NULL;
+        }
+        sr_free_change_iter(iter);
+    }
+    if (leaf_change_cnt > ctx->leaf_change_max) {
+        ctx->leaf_change_max = leaf_change_cnt;
+    }
+    ctx->apply_cnt += 1;
+    /* written last, the test waits for it */
+    strcpy(ctx->last_change, last_change);
+
+    return SR_ERR_OK;
+}
+
+static void
+cl_coalesce_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    cl_coalesce_test_ctx_t ctx = { 0, };
+    const char *values[] = { "coalesce-1", "coalesce-2", "coalesce-3", "coalesce-4", "coalesce-5",
+            "coalesce-6", "coalesce-7", "coalesce-8", "coalesce-9", "coalesce-10" };
+    size_t values_cnt = sizeof(values) / sizeof(values[0]);
+    sr_val_t value = { 0, };
+    int rc = SR_ERR_OK;
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_module_change_subscribe(session, "example-module", test_coalesce_change_cb, &ctx,
+            0, SR_SUBSCR_APPLY_ONLY | SR_SUBSCR_COALESCE, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* quick sequence of commits */
+    for (size_t i = 0; i < values_cnt; i++) {
+        value.type = SR_STRING_T;
+        value.data.string_val = (char*)values[i];
+        rc = sr_set_item(session, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value, SR_EDIT_DEFAULT);
+        assert_int_equal(rc, SR_ERR_OK);
+        rc = sr_commit(session);
+        assert_int_equal(rc, SR_ERR_OK);
+    }
+
+    /* wait for the coalescing window to expire */
+    for (int i = 0; i < 20 && 0 != strcmp(values[values_cnt - 1], ctx.last_change); i++) {
+        usleep(100000); /* 100 ms */
+    }
+
+    /* the subscriber has seen the final state, without being notified about each commit separately */
+    assert_string_equal(values[values_cnt - 1], ctx.last_value);
+    assert_true(ctx.apply_cnt >= 1);
+    assert_true(ctx.apply_cnt < values_cnt);
+
+    /* each notification carried only the net change of the leaf, the last one its final value */
+    assert_int_equal(0, ctx.iter_err_cnt);
+    assert_int_equal(1, ctx.leaf_change_max);
+    assert_string_equal(values[values_cnt - 1], ctx.last_change);
+
+    /* unsubscribe */
+    rc = sr_unsubscribe(NULL, subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
+static void
+cl_copy_config_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session_startup = NULL, *session_running = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    int callback_called = 0;
+    sr_val_t value = { 0, }, *val = NULL;
+    int rc = SR_ERR_OK;
+
+    /* start sessions */
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session_startup);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session_running);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* copy to/from candidate */
+    rc = sr_copy_config(session_startup, NULL, SR_DS_STARTUP, SR_DS_CANDIDATE);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* copy-config all enabled models, currently none */
+    rc = sr_copy_config(session_startup, NULL, SR_DS_RUNNING, SR_DS_STARTUP);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* enable running DS for example-module */
+    rc = sr_module_change_subscribe(session_startup, "example-module", test_module_change_cb,
+            &callback_called, 0, SR_SUBSCR_DEFAULT | SR_SUBSCR_APPLY_ONLY, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* edit config in running */
+    value.type = SR_STRING_T;
+    value.data.string_val = "copy_config_test";
+    rc = sr_set_item(session_running, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* commit */
+    rc = sr_commit(session_running);
+
+    /* copy-config */
+    rc = sr_copy_config(session_startup, "example-module", SR_DS_RUNNING, SR_DS_STARTUP);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* get-config from startup */
+    rc = sr_get_item(session_startup, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &val);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_string_equal(val->data.string_val, "copy_config_test");
+    sr_free_val(val);
+
+    /* edit config in running 2 */
+    value.type = SR_STRING_T;
+    value.data.string_val = "copy_config_modified";
+    rc = sr_set_item(session_running, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* commit */
     rc = sr_commit(session_running);
 
     /* copy-config all enabled models */
@@ -2414,6 +2955,311 @@ cl_copy_config_test2(void **state)
     assert_int_equal(rc, SR_ERR_OK);
 }
 
+/**
+ * @brief Waits until the leaf in running datastore reaches expected presence (rollback is asynchronous).
+ */
+static int
+cl_wait_for_running_leaf(sr_session_ctx_t *session, const char *xpath, bool present)
+{
+    sr_val_t *val = NULL;
+    int rc = SR_ERR_OK;
+
+    for (size_t i = 0; i < 50; i++) {
+        rc = sr_session_refresh(session);
+        assert_int_equal(rc, SR_ERR_OK);
+        rc = sr_get_item(session, xpath, &val);
+        sr_free_val(val);
+        val = NULL;
+        if ((present && SR_ERR_OK == rc) || (!present && SR_ERR_NOT_FOUND == rc)) {
+            break;
+        }
+        usleep(100000);
+    }
+    return rc;
+}
+
+static void
+cl_confirmed_commit_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session_candidate = NULL, *session_running = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    int callback_called = 0;
+    sr_val_t value = { 0, }, *val = NULL;
+    const char *xpath = "/example-module:container/list[key1='confirmed'][key2='commit']/leaf";
+    int rc = SR_ERR_OK;
+
+    /* start sessions */
+    rc = sr_session_start(conn, SR_DS_CANDIDATE, SR_SESS_DEFAULT, &session_candidate);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session_running);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* enable example-module */
+    rc = sr_module_change_subscribe(session_running, "example-module", test_module_change_cb,
+            &callback_called, 0, SR_SUBSCR_DEFAULT | SR_SUBSCR_APPLY_ONLY, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* nothing to cancel */
+    rc = sr_cancel_confirmed_commit(session_candidate);
+    assert_int_equal(rc, SR_ERR_NOT_FOUND);
+
+    /* not confirmed copy is rolled back once the timeout expires */
+    value.type = SR_STRING_T;
+    value.data.string_val = "confirmed_commit_test";
+    rc = sr_set_item(session_candidate, xpath, &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_copy_config_confirmed(session_candidate, NULL, SR_DS_CANDIDATE, 1);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_get_item(session_running, xpath, &val);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_string_equal(val->data.string_val, "confirmed_commit_test");
+    sr_free_val(val);
+
+    rc = cl_wait_for_running_leaf(session_running, xpath, false);
+    assert_int_equal(rc, SR_ERR_NOT_FOUND);
+
+    /* plain copy confirms the pending copy */
+    rc = sr_set_item(session_candidate, xpath, &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_copy_config_confirmed(session_candidate, NULL, SR_DS_CANDIDATE, 60);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_copy_config(session_candidate, NULL, SR_DS_CANDIDATE, SR_DS_RUNNING);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_cancel_confirmed_commit(session_candidate);
+    assert_int_equal(rc, SR_ERR_NOT_FOUND);
+
+    rc = cl_wait_for_running_leaf(session_running, xpath, true);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* canceled copy is rolled back immediately */
+    rc = sr_delete_item(session_candidate, xpath, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_copy_config_confirmed(session_candidate, NULL, SR_DS_CANDIDATE, 60);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = cl_wait_for_running_leaf(session_running, xpath, false);
+    assert_int_equal(rc, SR_ERR_NOT_FOUND);
+
+    rc = sr_cancel_confirmed_commit(session_candidate);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = cl_wait_for_running_leaf(session_running, xpath, true);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* cleanup */
+    rc = sr_delete_item(session_running, "/example-module:container/list[key1='confirmed'][key2='commit']", SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(session_running);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* stop the sessions */
+    rc = sr_session_stop(session_candidate);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_session_stop(session_running);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_unsubscribe(NULL, subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
+static void
+cl_check_running_leaf(sr_session_ctx_t *session, const char *xpath, const char *expected)
+{
+    sr_val_t *val = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = sr_session_refresh(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_get_item(session, xpath, &val);
+    if (NULL == expected) {
+        assert_int_equal(rc, SR_ERR_NOT_FOUND);
+    } else {
+        assert_int_equal(rc, SR_ERR_OK);
+        assert_string_equal(val->data.string_val, expected);
+    }
+    sr_free_val(val);
+}
+
+static void
+cl_rollback_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    int callback_called = 0;
+    sr_val_t value = { 0, };
+    const char *xpath = "/example-module:container/list[key1='rollback'][key2='test']/leaf";
+    int rc = SR_ERR_OK;
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* enable example-module */
+    rc = sr_module_change_subscribe(session, "example-module", test_module_change_cb,
+            &callback_called, 0, SR_SUBSCR_DEFAULT | SR_SUBSCR_APPLY_ONLY, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_rollback(session, 0);
+    assert_int_equal(rc, SR_ERR_INVAL_ARG);
+
+    /* two commits */
+    value.type = SR_STRING_T;
+    value.data.string_val = "first";
+    rc = sr_set_item(session, xpath, &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    value.data.string_val = "second";
+    rc = sr_set_item(session, xpath, &value, SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* roll back the last commit */
+    rc = sr_rollback(session, 1);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_leaf(session, xpath, "first");
+
+    /* the rollback is a commit on its own */
+    rc = sr_rollback(session, 1);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_leaf(session, xpath, "second");
+
+    /* roll back all four commits at once */
+    rc = sr_rollback(session, 4);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_leaf(session, xpath, NULL);
+
+    /* the deleted list instance is recreated */
+    rc = sr_rollback(session, 1);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_leaf(session, xpath, "second");
+
+    /* cleanup */
+    rc = sr_delete_item(session, "/example-module:container/list[key1='rollback'][key2='test']", SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_unsubscribe(NULL, subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
+/**
+ * @brief Checks the order of the instances of the user-ordered list test-module:user in running.
+ */
+static void
+cl_check_running_user_order(sr_session_ctx_t *session, const char **names, size_t name_cnt)
+{
+    sr_val_t *values = NULL;
+    size_t cnt = 0;
+    char xpath[PATH_MAX] = { 0, };
+    int rc = SR_ERR_OK;
+
+    rc = sr_session_refresh(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_get_items(session, "/test-module:user", &values, &cnt);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_int_equal(name_cnt, cnt);
+    for (size_t i = 0; i < cnt; ++i) {
+        snprintf(xpath, PATH_MAX, "/test-module:user[name='%s']", names[i]);
+        assert_string_equal(xpath, values[i].xpath);
+    }
+    sr_free_values(values, cnt);
+}
+
+static void
+cl_rollback_move_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    int callback_called = 0;
+    const char *order[] = { "nameA", "nameB", "nameC" };
+    const char *reversed[] = { "nameC", "nameB", "nameA" };
+    int rc = SR_ERR_OK;
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* enable test-module */
+    rc = sr_module_change_subscribe(session, "test-module", test_module_change_cb,
+            &callback_called, 0, SR_SUBSCR_DEFAULT | SR_SUBSCR_APPLY_ONLY, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_delete_item(session, "/test-module:user", SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    for (size_t i = 0; i < 3; ++i) {
+        char xpath[PATH_MAX] = { 0, };
+        snprintf(xpath, PATH_MAX, "/test-module:user[name='%s']", order[i]);
+        rc = sr_set_item(session, xpath, NULL, SR_EDIT_DEFAULT);
+        assert_int_equal(rc, SR_ERR_OK);
+    }
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_user_order(session, order, 3);
+
+    /* reverse the order, each instance is moved */
+    rc = sr_move_item(session, "/test-module:user[name='nameC']", SR_MOVE_FIRST, NULL);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_move_item(session, "/test-module:user[name='nameA']", SR_MOVE_LAST, NULL);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_user_order(session, reversed, 3);
+
+    /* the original order is restored */
+    rc = sr_rollback(session, 1);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_user_order(session, order, 3);
+
+    /* deleted instances are recreated at their original positions */
+    rc = sr_delete_item(session, "/test-module:user[name='nameA']", SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_delete_item(session, "/test-module:user[name='nameB']", SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_user_order(session, order + 2, 1);
+
+    rc = sr_rollback(session, 1);
+    assert_int_equal(rc, SR_ERR_OK);
+    cl_check_running_user_order(session, order, 3);
+
+    /* cleanup */
+    rc = sr_delete_item(session, "/test-module:user", SR_EDIT_DEFAULT);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_commit(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_unsubscribe(NULL, subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
 static int
 test_rpc_cb(const char *xpath, const sr_val_t *input, const size_t input_cnt,
         sr_val_t **output, size_t *output_cnt, void *private_ctx)
@@ -3044,6 +3890,152 @@ cl_failed_rpc_test(void **state)
 
 }
 
+/**
+ * @brief State shared with an action callback that blocks until released by the test.
+ */
+typedef struct cl_blocking_rpc_ctx_s {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool entered;       /**< the callback has been called */
+    bool released;      /**< the callback may return */
+    int rc;             /**< result of the action sent by ::cl_blocking_rpc_thread */
+} cl_blocking_rpc_ctx_t;
+
+static int
+test_blocking_action_cb(const char *xpath, const sr_val_t *input, const size_t input_cnt,
+        sr_val_t **output, size_t *output_cnt, void *private_ctx)
+{
+    cl_blocking_rpc_ctx_t *ctx = (cl_blocking_rpc_ctx_t *) private_ctx;
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->entered = true;
+    pthread_cond_broadcast(&ctx->cond);
+    while (!ctx->released) {
+        pthread_cond_wait(&ctx->cond, &ctx->lock);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return SR_ERR_OK;
+}
+
+/**
+ * @brief Sends an action handled by ::test_blocking_action_cb, over a separate connection
+ * so that the socket of the test session is not held while waiting for the response.
+ */
+static void *
+cl_blocking_rpc_thread(void *ctx_p)
+{
+    cl_blocking_rpc_ctx_t *ctx = (cl_blocking_rpc_ctx_t *) ctx_p;
+    sr_conn_ctx_t *conn = NULL;
+    sr_session_ctx_t *session = NULL;
+    sr_val_t *output = NULL;
+    size_t output_cnt = 0;
+    int rc = SR_ERR_OK;
+
+    rc = sr_connect("cl_test", SR_CONN_DEFAULT, &conn);
+    if (SR_ERR_OK == rc) {
+        rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    }
+    if (SR_ERR_OK == rc) {
+        rc = sr_action_send(session, "/test-module:kernel-modules/kernel-module[name='vboxvideo.ko']/get-dependencies",
+                NULL, 0, &output, &output_cnt);
+        sr_free_values(output, output_cnt);
+        sr_session_stop(session);
+    }
+    sr_disconnect(conn);
+
+    ctx->rc = rc;
+    return NULL;
+}
+
+static void
+cl_threaded_rpc_test(void **state)
+{
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    sr_session_ctx_t *session = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    int callback_called = 0;
+    int rc = SR_ERR_OK;
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* subscribe for RPC, callback is called from a worker thread */
+    rc = sr_rpc_subscribe(session, "/test-module:activate-software-image", test_failing_rpc_cb, &callback_called,
+            SR_SUBSCR_DEFAULT | SR_SUBSCR_THREADED, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    sr_val_t input = { 0, };
+    sr_val_t *output = NULL;
+    size_t output_cnt = 0;
+    input.xpath = "/test-module:activate-software-image/image-name";
+    input.type = SR_STRING_T;
+    input.data.string_val = "acmefw-2.3";
+
+    /* send RPCs; the response is delivered back through the event loop */
+    for (int i = 1; i <= 5; ++i) {
+        rc = sr_rpc_send(session, "/test-module:activate-software-image", &input, 1, &output, &output_cnt);
+        assert_int_equal(i, callback_called);
+        assert_int_equal(rc, 12);
+    }
+
+    /* unsubscribe */
+    rc = sr_unsubscribe(NULL, subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+    subscription = NULL;
+
+    /* a callback blocked in one subscription must not hold back the RPCs of another one */
+    cl_blocking_rpc_ctx_t blocking_ctx = { .entered = false, .released = false, .rc = SR_ERR_OK };
+    sr_subscription_ctx_t *blocking_subscription = NULL;
+    pthread_t thread;
+    callback_called = 0;
+    pthread_mutex_init(&blocking_ctx.lock, NULL);
+    pthread_cond_init(&blocking_ctx.cond, NULL);
+
+    rc = sr_module_change_subscribe(session, "test-module", empty_module_change_cb, NULL, 0, SR_SUBSCR_DEFAULT, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_rpc_subscribe(session, "/test-module:activate-software-image", test_failing_rpc_cb, &callback_called,
+            SR_SUBSCR_CTX_REUSE | SR_SUBSCR_THREADED, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_action_subscribe(session, "/test-module:kernel-modules/kernel-module/get-dependencies",
+            test_blocking_action_cb, &blocking_ctx, SR_SUBSCR_DEFAULT | SR_SUBSCR_THREADED, &blocking_subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    pthread_create(&thread, NULL, cl_blocking_rpc_thread, &blocking_ctx);
+    pthread_mutex_lock(&blocking_ctx.lock);
+    while (!blocking_ctx.entered) {
+        pthread_cond_wait(&blocking_ctx.cond, &blocking_ctx.lock);
+    }
+    pthread_mutex_unlock(&blocking_ctx.lock);
+
+    /* the blocking callback is running, an RPC handled by the other subscription completes */
+    rc = sr_rpc_send(session, "/test-module:activate-software-image", &input, 1, &output, &output_cnt);
+    assert_int_equal(1, callback_called);
+    assert_int_equal(rc, 12);
+    pthread_mutex_lock(&blocking_ctx.lock);
+    assert_false(blocking_ctx.released);
+    blocking_ctx.released = true;
+    pthread_cond_broadcast(&blocking_ctx.cond);
+    pthread_mutex_unlock(&blocking_ctx.lock);
+
+    pthread_join(thread, NULL);
+    assert_int_equal(SR_ERR_OK, blocking_ctx.rc);
+
+    rc = sr_unsubscribe(NULL, blocking_subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_unsubscribe(NULL, subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+    pthread_cond_destroy(&blocking_ctx.cond);
+    pthread_mutex_destroy(&blocking_ctx.lock);
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
 static int
 test_invalid_rpc_cb(const char *xpath, const sr_val_t *input, const size_t input_cnt,
         sr_val_t **output, size_t *output_cnt, void *private_ctx)
@@ -3651,17 +4643,22 @@ main()
             cmocka_unit_test_setup_teardown(cl_connection_test, logging_setup, NULL),
             cmocka_unit_test_setup_teardown(cl_multiconnect_test, logging_setup, NULL),
             cmocka_unit_test_setup_teardown(cl_disconnect_test, logging_setup, NULL),
+            cmocka_unit_test_setup_teardown(cl_connection_pool_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_list_schemas_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_get_schema_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_get_item_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_get_items_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_get_items_multi_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_get_items_iter_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_get_subtree_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_get_subtrees_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_export_data_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_iterative_tree_traversal, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_iterative_trees_traversal, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_iterative_tree_cursor_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_set_item_str_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_set_item_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_set_data_tree_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_delete_item_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_move_item_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_validate_test, sysrepo_setup, sysrepo_teardown),
@@ -3673,12 +4670,18 @@ main()
             cmocka_unit_test_setup_teardown(cl_refresh_session, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_refresh_session2, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_notification_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_data_session_reuse_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_coalesce_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_copy_config_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_copy_config_test2, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_confirmed_commit_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_rollback_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_rollback_move_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_rpc_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_rpc_tree_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_rpc_combo_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_failed_rpc_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(cl_threaded_rpc_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_invalid_rpc_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_action_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(cl_action_tree_test, sysrepo_setup, sysrepo_teardown),
@@ -562,6 +562,124 @@ cm_buffers_test(void **state)
     /* let the connection manager to be stopped in teardown before reading responses */
 }
 
+#define CM_STALLED_SOCKET_PATH "/tmp/sysrepo-test-stalled"  /* subscriber socket that is never read from */
+#define CM_STALLED_NOTIF_SIZE (64 * 1024)                  /* approximate size of notifications to the stalled subscriber */
+
+/**
+ * @brief Creates a listening socket of a subscriber that never accepts the connection nor reads from it.
+ */
+static int
+cm_stalled_subscriber_create(const char *socket_path)
+{
+    struct sockaddr_un addr;
+    int fd = -1, rc = -1;
+
+    unlink(socket_path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert_int_not_equal(fd, -1);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path)-1);
+
+    rc = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    assert_int_equal(rc, 0);
+    rc = listen(fd, 1);
+    assert_int_equal(rc, 0);
+
+    return fd;
+}
+
+/**
+ * @brief Sends notifications of given type with a large payload to the stalled subscriber.
+ */
+static void
+cm_stalled_notif_send(cm_ctx_t *cm_ctx, Sr__SubscriptionType type, size_t count)
+{
+    Sr__Msg *msg = NULL;
+    char *payload = NULL;
+    int rc = SR_ERR_OK;
+
+    for (size_t i = 0; i < count; i++) {
+        rc = sr_gpb_notif_alloc(NULL, type, CM_STALLED_SOCKET_PATH, 1, &msg);
+        assert_int_equal(rc, SR_ERR_OK);
+        payload = malloc(CM_STALLED_NOTIF_SIZE);
+        assert_non_null(payload);
+        memset(payload, 'a', CM_STALLED_NOTIF_SIZE - 1);
+        payload[CM_STALLED_NOTIF_SIZE - 1] = '\0';
+        if (SR__SUBSCRIPTION_TYPE__MODULE_INSTALL_SUBS == type) {
+            msg->notification->module_install_notif->module_name = payload;
+        } else {
+            msg->notification->module_change_notif->module_name = payload;
+        }
+        rc = cm_msg_send(cm_ctx, msg);
+        assert_int_equal(rc, SR_ERR_OK);
+    }
+}
+
+/**
+ * @brief Waits until the output statistics satisfy the condition.
+ */
+#define CM_OUT_STATS_WAIT(CM_CTX, STATS, COND) \
+    for (int i = 0; i < 100; i++) { \
+        cm_get_out_stats(CM_CTX, &STATS); \
+        if (COND) { \
+            break; \
+        } \
+        usleep(50000); /* 50 ms */ \
+    }
+
+static void
+cm_slow_consumer_drop_test(void **state)
+{
+    cm_ctx_t *cm_ctx = *state;
+    cm_out_stats_t before = { 0, }, after = { 0, };
+    size_t msg_cnt = SR_OUT_BUFF_LIMIT / CM_STALLED_NOTIF_SIZE;
+    int fd = -1;
+
+    assert_non_null(cm_ctx);
+    fd = cm_stalled_subscriber_create(CM_STALLED_SOCKET_PATH);
+    cm_get_out_stats(cm_ctx, &before);
+
+    /* three times more than what fits into the output buffer */
+    cm_stalled_notif_send(cm_ctx, SR__SUBSCRIPTION_TYPE__MODULE_INSTALL_SUBS, 3 * msg_cnt);
+
+    /* the oldest notifications have been dropped, the connection stays open */
+    CM_OUT_STATS_WAIT(cm_ctx, after, after.dropped_msg_cnt - before.dropped_msg_cnt >= msg_cnt);
+    assert_true(after.dropped_msg_cnt - before.dropped_msg_cnt >= msg_cnt);
+    assert_true(after.buffered_bytes <= SR_OUT_BUFF_LIMIT);
+    assert_true(after.buffered_bytes > SR_OUT_BUFF_LIMIT / 2);
+    assert_int_equal(before.disconnect_cnt, after.disconnect_cnt);
+
+    close(fd);
+    unlink(CM_STALLED_SOCKET_PATH);
+}
+
+static void
+cm_slow_consumer_disconnect_test(void **state)
+{
+    cm_ctx_t *cm_ctx = *state;
+    cm_out_stats_t before = { 0, }, after = { 0, };
+    size_t msg_cnt = SR_OUT_BUFF_LIMIT / CM_STALLED_NOTIF_SIZE;
+    int fd = -1;
+
+    assert_non_null(cm_ctx);
+    fd = cm_stalled_subscriber_create(CM_STALLED_SOCKET_PATH);
+    cm_get_out_stats(cm_ctx, &before);
+
+    /* two times more than what fits into the output buffer */
+    cm_stalled_notif_send(cm_ctx, SR__SUBSCRIPTION_TYPE__MODULE_CHANGE_SUBS, 2 * msg_cnt);
+
+    /* the connection has been closed instead of dropping any notification */
+    CM_OUT_STATS_WAIT(cm_ctx, after, after.disconnect_cnt > before.disconnect_cnt);
+    assert_true(after.disconnect_cnt > before.disconnect_cnt);
+    assert_int_equal(before.dropped_msg_cnt, after.dropped_msg_cnt);
+    assert_true(after.buffered_bytes <= SR_OUT_BUFF_LIMIT);
+
+    close(fd);
+    unlink(CM_STALLED_SOCKET_PATH);
+}
+
 static void
 cm_test_signal_callback(cm_ctx_t *cm_ctx, int signum)
 {
@@ -599,6 +717,8 @@ main() {
             cmocka_unit_test_setup_teardown(cm_session_neg_test, cm_setup, NULL),
             cmocka_unit_test_setup_teardown(cm_buffers_test, cm_setup, cm_teardown),
             cmocka_unit_test_setup_teardown(cm_signals_test, cm_setup, cm_teardown),
+            cmocka_unit_test_setup_teardown(cm_slow_consumer_drop_test, cm_setup, cm_teardown),
+            cmocka_unit_test_setup_teardown(cm_slow_consumer_disconnect_test, cm_setup, cm_teardown),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -1457,6 +1457,326 @@ sr_copy_all_ns_test(void **state)
     free(module_names);
 }
 
+static void
+sr_values_gpb_wire_fill(sr_val_t *values)
+{
+    const sr_type_t str_types[] = { SR_BINARY_T, SR_BITS_T, SR_ENUM_T, SR_IDENTITYREF_T, SR_INSTANCEID_T, SR_STRING_T,
+            SR_ANYXML_T, SR_ANYDATA_T };
+    const char *str_data[] = { "QUJD", "a b", "x", "m:id", "/m:c", "str", "<a/>", "{}" };
+    size_t i = 0;
+
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:list[k='a']"));
+    values[i++].type = SR_LIST_T;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:cont"));
+    values[i++].type = SR_CONTAINER_T;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:pres"));
+    values[i].dflt = true;
+    values[i++].type = SR_CONTAINER_PRESENCE_T;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:empty"));
+    values[i++].type = SR_LEAF_EMPTY_T;
+    for (size_t j = 0; j < sizeof str_types / sizeof *str_types; j++, i++) {
+        assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:str-leaf"));
+        assert_int_equal(SR_ERR_OK, sr_val_set_str_data(&values[i], str_types[j], str_data[j]));
+    }
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:bool"));
+    values[i].type = SR_BOOL_T;
+    values[i++].data.bool_val = true;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:dec64"));
+    values[i].type = SR_DECIMAL64_T;
+    values[i++].data.decimal64_val = -3.25;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:i8"));
+    values[i].type = SR_INT8_T;
+    values[i++].data.int8_val = INT8_MIN;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:i16"));
+    values[i].type = SR_INT16_T;
+    values[i++].data.int16_val = -300;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:i32"));
+    values[i].type = SR_INT32_T;
+    values[i++].data.int32_val = INT32_MAX;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:i64"));
+    values[i].type = SR_INT64_T;
+    values[i++].data.int64_val = INT64_MIN;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:u8"));
+    values[i].type = SR_UINT8_T;
+    values[i++].data.uint8_val = UINT8_MAX;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:u16"));
+    values[i].type = SR_UINT16_T;
+    values[i].dflt = true;
+    values[i++].data.uint16_val = 8080;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:u32"));
+    values[i].type = SR_UINT32_T;
+    values[i++].data.uint32_val = UINT32_MAX;
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:u64"));
+    values[i].type = SR_UINT64_T;
+    values[i++].data.uint64_val = UINT64_MAX;
+    /* string value without data */
+    assert_int_equal(SR_ERR_OK, sr_val_set_xpath(&values[i], "/m:no-data"));
+    values[i++].type = SR_STRING_T;
+}
+
+static void
+sr_values_gpb_wire_compare(const sr_val_t *values, const sr_val_t *decoded, size_t count)
+{
+    char *str = NULL, *decoded_str = NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        assert_string_equal(values[i].xpath, decoded[i].xpath);
+        assert_int_equal(values[i].type, decoded[i].type);
+        assert_int_equal(values[i].dflt, decoded[i].dflt);
+        str = sr_val_to_str(&values[i]);
+        decoded_str = sr_val_to_str(&decoded[i]);
+        if (NULL == str) {
+            assert_null(decoded_str);
+        } else {
+            assert_string_equal(str, decoded_str);
+        }
+        free(str);
+        free(decoded_str);
+    }
+}
+
+static void
+sr_values_gpb_wire_test(void **state)
+{
+    Sr__GetItemsResp gpb_resp = SR__GET_ITEMS_RESP__INIT, wire_resp = SR__GET_ITEMS_RESP__INIT;
+    Sr__GetItemsResp *unpacked = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    sr_val_t *values = NULL, *decoded = NULL;
+    size_t count = 23, decoded_cnt = 0, gpb_len = 0, wire_len = 0;
+    uint8_t *gpb_buf = NULL, *wire_buf = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = sr_new_values(count, &values);
+    assert_int_equal(SR_ERR_OK, rc);
+    sr_values_gpb_wire_fill(values);
+
+    /* pack using GPB values */
+    rc = sr_values_sr_to_gpb(values, count, &gpb_resp.values, &gpb_resp.n_values);
+    assert_int_equal(SR_ERR_OK, rc);
+    gpb_len = sr__get_items_resp__get_packed_size(&gpb_resp);
+    gpb_buf = calloc(gpb_len, 1);
+    assert_non_null(gpb_buf);
+    sr__get_items_resp__pack(&gpb_resp, gpb_buf);
+
+    /* pack using the direct serialization */
+    rc = sr_values_sr_to_gpb_wire(NULL, values, count, false, &wire_resp.base, "values");
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_int_equal(1, wire_resp.base.n_unknown_fields);
+    assert_int_equal(0, wire_resp.n_values);
+    wire_len = sr__get_items_resp__get_packed_size(&wire_resp);
+    wire_buf = calloc(wire_len, 1);
+    assert_non_null(wire_buf);
+    sr__get_items_resp__pack(&wire_resp, wire_buf);
+
+    /* both encodings have to be identical */
+    assert_int_equal(gpb_len, wire_len);
+    assert_memory_equal(gpb_buf, wire_buf, gpb_len);
+
+    /* the field is not a repeated Sr__Value, or the values were already serialized */
+    rc = sr_values_sr_to_gpb_wire(NULL, values, count, false, &wire_resp.base, "no-values");
+    assert_int_equal(SR_ERR_INVAL_ARG, rc);
+    rc = sr_values_sr_to_gpb_wire(NULL, values, count, false, &wire_resp.base, "values");
+    assert_int_equal(SR_ERR_INVAL_ARG, rc);
+
+    /* unpack using protobuf-c */
+    unpacked = sr__get_items_resp__unpack(NULL, wire_len, wire_buf);
+    assert_non_null(unpacked);
+    rc = sr_values_gpb_to_sr(NULL, unpacked->values, unpacked->n_values, &decoded, &decoded_cnt);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_int_equal(count, decoded_cnt);
+    sr_values_gpb_wire_compare(values, decoded, count);
+    sr_free_values(decoded, decoded_cnt);
+    sr__get_items_resp__free_unpacked(unpacked, NULL);
+
+    /* decode directly into sysrepo values */
+    rc = sr_values_gpb_wire_to_sr(NULL, wire_buf, wire_len, 1, &decoded, &decoded_cnt);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_int_equal(count, decoded_cnt);
+    sr_values_gpb_wire_compare(values, decoded, count);
+    sr_free_values(decoded, decoded_cnt);
+
+    /* decode directly into a memory context */
+    rc = sr_mem_new(0, &sr_mem);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = sr_values_gpb_wire_to_sr(sr_mem, wire_buf, wire_len, 1, &decoded, &decoded_cnt);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_int_equal(count, decoded_cnt);
+    assert_ptr_equal(sr_mem, decoded[0]._sr_mem);
+    if (NULL != sr_mem) {
+        assert_int_equal(1, sr_mem->obj_count);
+    }
+    sr_values_gpb_wire_compare(values, decoded, count);
+    sr_free_values(decoded, decoded_cnt);
+
+    /* truncated message */
+    rc = sr_values_gpb_wire_to_sr(NULL, wire_buf, wire_len - 1, 1, &decoded, &decoded_cnt);
+    assert_int_equal(SR_ERR_MALFORMED_MSG, rc);
+
+    /* cleanup */
+    if (NULL == values[0]._sr_mem) {
+        for (size_t i = 0; i < gpb_resp.n_values; i++) {
+            sr__value__free_unpacked(gpb_resp.values[i], NULL);
+        }
+        free(gpb_resp.values);
+    }
+    free(wire_resp.base.unknown_fields[0].data);
+    free(wire_resp.base.unknown_fields);
+    free(gpb_buf);
+    free(wire_buf);
+    sr_free_values(values, count);
+}
+
+static void
+sr_values_gpb_wire_compressed_test(void **state)
+{
+    Sr__GetItemsResp plain_resp = SR__GET_ITEMS_RESP__INIT, compressed_resp = SR__GET_ITEMS_RESP__INIT;
+    Sr__GetItemsResp *unpacked = NULL;
+    sr_val_t *values = NULL, *decoded = NULL, *value = NULL;
+    size_t count = 23, decoded_cnt = 0, plain_len = 0, compressed_len = 0;
+    uint8_t *buf = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = sr_new_values(count, &values);
+    assert_int_equal(SR_ERR_OK, rc);
+    sr_values_gpb_wire_fill(values);
+
+    rc = sr_values_sr_to_gpb_wire(NULL, values, count, false, &plain_resp.base, "values");
+    assert_int_equal(SR_ERR_OK, rc);
+    plain_len = sr__get_items_resp__get_packed_size(&plain_resp);
+
+    rc = sr_values_sr_to_gpb_wire(NULL, values, count, true, &compressed_resp.base, "values");
+    assert_int_equal(SR_ERR_OK, rc);
+    compressed_len = sr__get_items_resp__get_packed_size(&compressed_resp);
+    assert_true(compressed_len < plain_len);
+    buf = calloc(compressed_len, 1);
+    assert_non_null(buf);
+    sr__get_items_resp__pack(&compressed_resp, buf);
+
+    /* unpack using protobuf-c */
+    unpacked = sr__get_items_resp__unpack(NULL, compressed_len, buf);
+    assert_non_null(unpacked);
+    assert_false(unpacked->values[0]->has_xpath_prefix_len);
+    assert_true(unpacked->values[count - 1]->has_xpath_prefix_len);
+    rc = sr_values_gpb_to_sr(NULL, unpacked->values, unpacked->n_values, &decoded, &decoded_cnt);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_int_equal(count, decoded_cnt);
+    sr_values_gpb_wire_compare(values, decoded, count);
+    sr_free_values(decoded, decoded_cnt);
+
+    /* expand the values one by one, as the iterator does */
+    for (size_t i = 0; i < count; i++) {
+        rc = sr_dup_gpb_to_val_t(NULL, unpacked->values[i], &value);
+        assert_int_equal(SR_ERR_OK, rc);
+        rc = sr_gpb_val_expand_xpath(unpacked->values[i], (i > 0) ? values[i-1].xpath : NULL, value);
+        assert_int_equal(SR_ERR_OK, rc);
+        sr_values_gpb_wire_compare(&values[i], value, 1);
+        sr_free_val(value);
+    }
+
+    /* relative xpath without the preceding value */
+    rc = sr_dup_gpb_to_val_t(NULL, unpacked->values[count - 1], &value);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = sr_gpb_val_expand_xpath(unpacked->values[count - 1], NULL, value);
+    assert_int_equal(SR_ERR_MALFORMED_MSG, rc);
+    sr_free_val(value);
+    sr__get_items_resp__free_unpacked(unpacked, NULL);
+
+    /* decode directly into sysrepo values */
+    rc = sr_values_gpb_wire_to_sr(NULL, buf, compressed_len, 1, &decoded, &decoded_cnt);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_int_equal(count, decoded_cnt);
+    sr_values_gpb_wire_compare(values, decoded, count);
+    sr_free_values(decoded, decoded_cnt);
+
+    free(plain_resp.base.unknown_fields[0].data);
+    free(plain_resp.base.unknown_fields);
+    free(compressed_resp.base.unknown_fields[0].data);
+    free(compressed_resp.base.unknown_fields);
+    free(buf);
+    sr_free_values(values, count);
+}
+
+static void
+sr_gpb_event_notif_multicast_test(void **state)
+{
+    Sr__Msg *msg = NULL, *unpacked = NULL;
+    Sr__EventNotifReq *notif = NULL;
+    sr_gpb_multicast_t *multicast = NULL;
+    sr_val_t *values = NULL, *decoded = NULL;
+    struct iovec iov[SR_GPB_MULTICAST_IOV_CNT];
+    uint8_t dst_buff[SR_GPB_MULTICAST_DST_OVERHEAD + 64] = { 0, };
+    uint8_t *buf = NULL;
+    size_t count = 23, decoded_cnt = 0, msg_size = 0, pos = 0;
+    const char *addresses[] = { "/tmp/subscriber-a.sock", "/tmp/subscriber-with-a-longer-address.sock" };
+    const uint32_t ids[] = { 5, 1234567 };
+    int rc = SR_ERR_OK;
+
+    rc = sr_new_values(count, &values);
+    assert_int_equal(SR_ERR_OK, rc);
+    sr_values_gpb_wire_fill(values);
+
+    rc = sr_gpb_req_alloc(NULL, SR__OPERATION__EVENT_NOTIF, 42, &msg);
+    assert_int_equal(SR_ERR_OK, rc);
+    notif = msg->request->event_notif_req;
+    notif->type = SR__EVENT_NOTIF_REQ__NOTIF_TYPE__REALTIME;
+    notif->xpath = strdup("/test-module:link-removed");
+    notif->timestamp = 1234;
+    rc = sr_values_sr_to_gpb(values, count, &notif->values, &notif->n_values);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = sr_gpb_event_notif_multicast_init(msg, &multicast);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_null(msg->request->event_notif_req->subscriber_address);
+
+    for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); i++) {
+        rc = sr_gpb_event_notif_multicast_dst(multicast, addresses[i], ids[i], dst_buff, sizeof(dst_buff), iov, &msg_size);
+        assert_int_equal(SR_ERR_OK, rc);
+
+        /* gather the message */
+        buf = calloc(msg_size, 1);
+        assert_non_null(buf);
+        pos = 0;
+        for (size_t j = 0; j < SR_GPB_MULTICAST_IOV_CNT; j++) {
+            memcpy(buf + pos, iov[j].iov_base, iov[j].iov_len);
+            pos += iov[j].iov_len;
+        }
+        assert_int_equal(msg_size, pos);
+        assert_int_equal(msg_size - SR_MSG_PREAM_SIZE, sr_buff_to_uint32(buf));
+
+        /* unpack it as the subscriber does */
+        unpacked = sr__msg__unpack(NULL, msg_size - SR_MSG_PREAM_SIZE, buf + SR_MSG_PREAM_SIZE);
+        assert_non_null(unpacked);
+        assert_int_equal(SR__MSG__MSG_TYPE__REQUEST, unpacked->type);
+        assert_int_equal(42, unpacked->session_id);
+        assert_int_equal(SR__OPERATION__EVENT_NOTIF, unpacked->request->operation);
+        assert_non_null(unpacked->request->event_notif_req);
+        assert_string_equal(addresses[i], unpacked->request->event_notif_req->subscriber_address);
+        assert_true(unpacked->request->event_notif_req->has_subscription_id);
+        assert_int_equal(ids[i], unpacked->request->event_notif_req->subscription_id);
+        assert_string_equal("/test-module:link-removed", unpacked->request->event_notif_req->xpath);
+        assert_int_equal(1234, unpacked->request->event_notif_req->timestamp);
+        assert_int_equal(0, unpacked->request->event_notif_req->n_destinations);
+
+        rc = sr_values_gpb_to_sr(NULL, unpacked->request->event_notif_req->values,
+                unpacked->request->event_notif_req->n_values, &decoded, &decoded_cnt);
+        assert_int_equal(SR_ERR_OK, rc);
+        assert_int_equal(count, decoded_cnt);
+        sr_values_gpb_wire_compare(values, decoded, count);
+        sr_free_values(decoded, decoded_cnt);
+
+        sr__msg__free_unpacked(unpacked, NULL);
+        free(buf);
+    }
+
+    /* too small buffer for the destination-specific data */
+    rc = sr_gpb_event_notif_multicast_dst(multicast, addresses[1], ids[1], dst_buff, SR_GPB_MULTICAST_DST_OVERHEAD, iov, &msg_size);
+    assert_int_equal(SR_ERR_INVAL_ARG, rc);
+
+    sr_gpb_multicast_free(multicast);
+    sr_msg_free(msg);
+    sr_free_values(values, count);
+}
+
 int
 main() {
     const struct CMUnitTest tests[] = {
@@ -1480,6 +1800,9 @@ main() {
             cmocka_unit_test_setup_teardown(sr_free_list_of_strings_test, logging_setup, logging_cleanup),
             cmocka_unit_test_setup_teardown(sr_dup_data_tree_to_ctx_test, logging_setup, logging_cleanup),
             cmocka_unit_test_setup_teardown(sr_copy_all_ns_test, logging_setup, logging_cleanup),
+            cmocka_unit_test_setup_teardown(sr_values_gpb_wire_test, logging_setup, logging_cleanup),
+            cmocka_unit_test_setup_teardown(sr_values_gpb_wire_compressed_test, logging_setup, logging_cleanup),
+            cmocka_unit_test_setup_teardown(sr_gpb_event_notif_multicast_test, logging_setup, logging_cleanup),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
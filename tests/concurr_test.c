@@ -21,6 +21,8 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
 #include <setjmp.h>
 #include <cmocka.h>
 #include <pthread.h>
@@ -32,6 +34,9 @@
 #include "system_helper.h"
 
 #define TEST_THREAD_COUNT 10
+#define TEST_COMMIT_COUNT 100   /**< Number of commits performed while the readers are running */
+
+#define TEST_RC_LEAF_XPATH "/example-module:container/list[key1='key1'][key2='key2']/leaf"
 
 static int
 sysrepo_setup(void **state)
@@ -221,6 +226,133 @@ concurr_connections_test(void **state)
     }
 }
 
+/**
+ * @brief Shared state of the readers and the committer of ::concurr_read_commit_test.
+ */
+typedef struct test_read_commit_ctx_s {
+    sr_conn_ctx_t *conn;         /**< Connection shared by all threads. */
+    volatile bool done;          /**< Set by the committer after its last commit. */
+} test_read_commit_ctx_t;
+
+static int
+test_module_change_cb(sr_session_ctx_t *session, const char *module_name, sr_notif_event_t event, void *private_ctx)
+{
+    return SR_ERR_OK;
+}
+
+static void *
+test_thread_read_running(void *ctx)
+{
+    test_read_commit_ctx_t *rc_ctx = (test_read_commit_ctx_t *)ctx;
+    sr_session_ctx_t *session = NULL;
+    sr_val_t *value = NULL;
+    size_t reads = 0;
+    int rc = 0;
+
+    rc = sr_session_start(rc_ctx->conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    while (!rc_ctx->done || reads < 100) {
+        /* the reads of a session run on its copy of the data, refresh it to see the commits */
+        if (0 == reads % 10) {
+            rc = sr_session_refresh(session);
+            assert_int_equal(rc, SR_ERR_OK);
+        }
+        rc = sr_get_item(session, TEST_RC_LEAF_XPATH, &value);
+        assert_int_equal(rc, SR_ERR_OK);
+        assert_non_null(value);
+        assert_int_equal(SR_STRING_T, value->type);
+        assert_true(0 == strcmp("Leaf value", value->data.string_val) ||
+                0 == strncmp("commit-", value->data.string_val, strlen("commit-")));
+        sr_free_val(value);
+        ++reads;
+    }
+
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    return NULL;
+}
+
+static void *
+test_thread_commit_running(void *ctx)
+{
+    test_read_commit_ctx_t *rc_ctx = (test_read_commit_ctx_t *)ctx;
+    sr_session_ctx_t *session = NULL;
+    sr_val_t value = { 0, };
+    char buff[32] = { 0, };
+    int rc = 0;
+
+    rc = sr_session_start(rc_ctx->conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    value.type = SR_STRING_T;
+    value.data.string_val = buff;
+    for (size_t i = 0; i < TEST_COMMIT_COUNT; i++) {
+        snprintf(buff, sizeof buff, "commit-%zu", i);
+        rc = sr_set_item(session, TEST_RC_LEAF_XPATH, &value, SR_EDIT_DEFAULT);
+        assert_int_equal(rc, SR_ERR_OK);
+        rc = sr_commit(session);
+        assert_int_equal(rc, SR_ERR_OK);
+    }
+    rc_ctx->done = true;
+
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    return NULL;
+}
+
+/**
+ * Test concurrent reads of running data of one module while it is being committed to.
+ */
+static void
+concurr_read_commit_test(void **state)
+{
+    pthread_t threads[TEST_THREAD_COUNT];
+    test_read_commit_ctx_t rc_ctx = { 0, };
+    sr_session_ctx_t *session = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    sr_val_t *value = NULL;
+    size_t i = 0;
+    int rc = 0;
+    sr_conn_ctx_t *conn = *state;
+
+    assert_non_null(state);
+    rc_ctx.conn = conn;
+
+    /* enable example-module in running */
+    rc = sr_session_start(conn, SR_DS_RUNNING, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_module_change_subscribe(session, "example-module", test_module_change_cb, NULL,
+            0, SR_SUBSCR_DEFAULT | SR_SUBSCR_APPLY_ONLY, &subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* one committer, the other threads read the committed leaf */
+    pthread_create(&threads[0], NULL, test_thread_commit_running, &rc_ctx);
+    for (i = 1; i < TEST_THREAD_COUNT; i++) {
+        pthread_create(&threads[i], NULL, test_thread_read_running, &rc_ctx);
+    }
+    for (i = 0; i < TEST_THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* the last commit is visible */
+    rc = sr_session_refresh(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_get_item(session, TEST_RC_LEAF_XPATH, &value);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(value);
+    assert_int_equal(SR_STRING_T, value->type);
+    assert_int_equal(TEST_COMMIT_COUNT - 1, atoi(value->data.string_val + strlen("commit-")));
+    sr_free_val(value);
+
+    rc = sr_unsubscribe(session, subscription);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
 int
 main()
 {
@@ -228,6 +360,7 @@ main()
             cmocka_unit_test_setup_teardown(concurr_requests_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(concurr_sessions_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(concurr_connections_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(concurr_read_commit_test, sysrepo_setup, sysrepo_teardown),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -25,6 +25,9 @@
 #include <cmocka.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
 #include "data_manager.h"
 #include "test_data.h"
 #include "sr_common.h"
@@ -1119,6 +1122,482 @@ dm_schema_node_xpath_hash(void **state)
     dm_cleanup(ctx);
 }
 
+void
+dm_node_index_test(void **state)
+{
+    int rc;
+    dm_ctx_t *ctx;
+    dm_session_t *ses_ctx;
+    struct lyd_node *data_tree = NULL;
+    const struct lys_node *container = NULL, *list = NULL;
+    sr_btree_t *index = NULL;
+    dm_node_index_entry_t *entry = NULL;
+
+    rc = dm_init(NULL, NULL, NULL, CM_MODE_LOCAL, TEST_SCHEMA_SEARCH_DIR, TEST_DATA_SEARCH_DIR, &ctx);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    dm_session_start(ctx, NULL, SR_DS_STARTUP, &ses_ctx);
+
+    assert_int_equal(SR_ERR_OK, dm_get_datatree(ctx, ses_ctx, "example-module", &data_tree));
+    container = get_single_node(data_tree, "/example-module:container")->schema;
+    list = get_single_node(data_tree, "/example-module:container/list[key1='key1'][key2='key2']")->schema;
+
+    rc = dm_node_index_init(&index);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    /* empty index */
+    assert_null(dm_node_index_get(index, container));
+
+    /* exact items */
+    assert_int_equal(SR_ERR_OK, dm_node_index_add(index, list, 0, false));
+    assert_int_equal(SR_ERR_OK, dm_node_index_add(index, list, 2, false));
+    /* the same item added again is skipped */
+    assert_int_equal(SR_ERR_OK, dm_node_index_add(index, list, 2, false));
+
+    /* descendant items */
+    assert_int_equal(SR_ERR_OK, dm_node_index_add(index, container, 0, true));
+    assert_int_equal(SR_ERR_OK, dm_node_index_add(index, container, 2, true));
+    assert_int_equal(SR_ERR_OK, dm_node_index_add(index, container, 1, false));
+
+    /* module-wide item */
+    assert_int_equal(SR_ERR_OK, dm_node_index_add(index, NULL, 3, false));
+
+    entry = dm_node_index_get(index, list);
+    assert_non_null(entry);
+    assert_ptr_equal(list, entry->node);
+    assert_int_equal(2, entry->item_cnt);
+    assert_int_equal(0, entry->items[0]);
+    assert_int_equal(2, entry->items[1]);
+    assert_int_equal(0, entry->desc_item_cnt);
+
+    entry = dm_node_index_get(index, container);
+    assert_non_null(entry);
+    assert_int_equal(1, entry->item_cnt);
+    assert_int_equal(1, entry->items[0]);
+    assert_int_equal(2, entry->desc_item_cnt);
+    assert_int_equal(0, entry->desc_items[0]);
+    assert_int_equal(2, entry->desc_items[1]);
+
+    entry = dm_node_index_get(index, NULL);
+    assert_non_null(entry);
+    assert_null(entry->node);
+    assert_int_equal(1, entry->item_cnt);
+    assert_int_equal(3, entry->items[0]);
+
+    sr_btree_cleanup(index);
+
+    dm_session_stop(ctx, ses_ctx);
+    dm_cleanup(ctx);
+}
+
+void
+dm_dp_index_test(void **state)
+{
+    int rc;
+    dm_ctx_t *ctx;
+    dm_schema_info_t *si = NULL;
+    sr_list_t *subscriptions = NULL;
+    np_subscription_t *subscription = NULL;
+    dm_dp_index_t *dp_index = NULL, *cached = NULL, *rebuilt = NULL;
+    dm_node_index_entry_t *entry = NULL;
+    const char *xpaths[] = {"/example-module:container", "/example-module:container/list/leaf"};
+
+    rc = dm_init(NULL, NULL, NULL, CM_MODE_LOCAL, TEST_SCHEMA_SEARCH_DIR, TEST_DATA_SEARCH_DIR, &ctx);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = dm_get_module_without_lock(ctx, "example-module", &si);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = sr_list_init(&subscriptions);
+    assert_int_equal(SR_ERR_OK, rc);
+    for (size_t i = 0; i < sizeof(xpaths) / sizeof(*xpaths); i++) {
+        subscription = calloc(1, sizeof(*subscription));
+        assert_non_null(subscription);
+        subscription->type = SR__SUBSCRIPTION_TYPE__DP_GET_ITEMS_SUBS;
+        subscription->module_name = strdup("example-module");
+        subscription->xpath = strdup(xpaths[i]);
+        assert_int_equal(SR_ERR_OK, sr_list_add(subscriptions, subscription));
+    }
+
+    rc = dm_get_dp_index(ctx, si, subscriptions, &dp_index);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_non_null(dp_index);
+    assert_int_equal(2, dp_index->nodes->count);
+
+    /* the container subscription covers the container, the leaf one is nested */
+    entry = dm_node_index_get(dp_index->nodes_index, dp_index->nodes->data[0]);
+    assert_non_null(entry);
+    assert_int_equal(1, entry->item_cnt);
+    assert_int_equal(0, entry->items[0]);
+    assert_int_equal(1, entry->desc_item_cnt);
+    assert_int_equal(1, entry->desc_items[0]);
+
+    entry = dm_node_index_get(dp_index->nodes_index, dp_index->nodes->data[1]);
+    assert_non_null(entry);
+    assert_int_equal(1, entry->item_cnt);
+    assert_int_equal(1, entry->items[0]);
+    assert_int_equal(0, entry->desc_item_cnt);
+
+    /* the same subscriptions reuse the cached index */
+    rc = dm_get_dp_index(ctx, si, subscriptions, &cached);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_ptr_equal(dp_index, cached);
+    dm_dp_index_release(cached);
+
+    /* subscribe/unsubscribe drops the cached index, the borrowed one stays valid */
+    dm_dp_index_invalidate(ctx, "example-module");
+    rc = dm_get_dp_index(ctx, si, subscriptions, &rebuilt);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_ptr_not_equal(dp_index, rebuilt);
+    assert_int_equal(2, dp_index->nodes->count);
+
+    dm_dp_index_release(rebuilt);
+    dm_dp_index_release(dp_index);
+    np_subscriptions_list_cleanup(subscriptions);
+
+    dm_cleanup(ctx);
+}
+
+void
+dm_shared_ly_ctx_test(void **state)
+{
+    int rc;
+    dm_ctx_t *ctx;
+    dm_session_t *session = NULL;
+    dm_schema_info_t *si_test = NULL, *si_example = NULL;
+    dm_data_info_t *info = NULL;
+    dm_shared_ly_ctx_t *shared_ctx = NULL;
+    struct ly_ctx *old_ly_ctx = NULL;
+    sr_list_t *implicitly_installed = NULL;
+    sr_error_info_t *errors = NULL;
+    size_t err_cnt = 0;
+
+    rc = dm_init(NULL, NULL, NULL, CM_MODE_LOCAL, TEST_SCHEMA_SEARCH_DIR, TEST_DATA_SEARCH_DIR, &ctx);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = dm_get_module_without_lock(ctx, "test-module", &si_test);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = dm_get_module_without_lock(ctx, "example-module", &si_example);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    assert_non_null(si_test->ly_ctx);
+    assert_non_null(si_example->ly_ctx);
+    assert_ptr_equal(si_test->ly_ctx, si_test->module->ctx);
+    assert_ptr_equal(si_example->ly_ctx, si_example->module->ctx);
+#ifdef SHARED_LY_CTX
+    /* all modules are loaded in the same context */
+    assert_non_null(si_test->shared_ly_ctx);
+    assert_ptr_equal(si_test->shared_ly_ctx, si_example->shared_ly_ctx);
+    assert_ptr_equal(si_test->ly_ctx, si_example->ly_ctx);
+#else
+    /* each module has its own context */
+    assert_null(si_test->shared_ly_ctx);
+    assert_ptr_not_equal(si_test->ly_ctx, si_example->ly_ctx);
+#endif
+
+    /* keep a session copy of test-module with instance-identifier data across the install */
+    rc = dm_session_start(ctx, NULL, SR_DS_STARTUP, &session);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = dm_get_data_info(ctx, session, "test-module", &info);
+    assert_int_equal(SR_ERR_OK, rc);
+    old_ly_ctx = si_test->ly_ctx;
+    assert_ptr_equal(info->shared_ly_ctx, si_test->shared_ly_ctx);
+
+    info->modified = true;
+    assert_non_null(dm_lyd_new_path(info, "/test-module:main/instance_id",
+            "/example-module:container/list[key1='key1'][key2='key2']", LYD_PATH_OPT_UPDATE));
+
+    /* (re)installing a module switches to a new epoch of the shared context */
+    rc = dm_install_module(ctx, session, "small-module", NULL, TEST_SCHEMA_SEARCH_DIR "small-module.yang", &implicitly_installed);
+    assert_int_equal(SR_ERR_OK, rc);
+    md_free_module_key_list(implicitly_installed);
+
+    rc = dm_get_module_without_lock(ctx, "example-module", &si_example);
+    assert_int_equal(SR_ERR_OK, rc);
+#ifdef SHARED_LY_CTX
+    /* idle module has been moved to the new epoch, the one in use is kept in the old one */
+    assert_ptr_not_equal(old_ly_ctx, si_example->ly_ctx);
+    assert_ptr_equal(old_ly_ctx, si_test->ly_ctx);
+#endif
+    assert_ptr_equal(si_test->ly_ctx, info->node->schema->module->ctx);
+
+    /* the session copy is still usable, instance-identifier is resolved */
+    rc = dm_validate_session_data_trees(ctx, session, &errors, &err_cnt);
+    assert_int_equal(SR_ERR_OK, rc);
+    sr_free_errors(errors, err_cnt);
+    errors = NULL;
+    err_cnt = 0;
+
+    /* the epoch is referenced by a reader that does not hold the model lock */
+    shared_ctx = dm_schema_info_ctx_acquire(si_test);
+    dm_session_stop(ctx, session);
+    session = NULL;
+
+    /* released module is moved to the new epoch on the next lookup */
+    rc = dm_get_module_without_lock(ctx, "test-module", &si_test);
+    assert_int_equal(SR_ERR_OK, rc);
+#ifdef SHARED_LY_CTX
+    assert_ptr_equal(si_test->ly_ctx, si_example->ly_ctx);
+    assert_non_null(shared_ctx);
+    assert_ptr_not_equal(old_ly_ctx, si_test->ly_ctx);
+    /* the old epoch is still alive for the reader */
+    assert_non_null(ly_ctx_get_module(old_ly_ctx, "test-module", NULL, 1));
+#endif
+    dm_schema_info_ctx_release(shared_ctx);
+
+    /* instance-identifier data are validated in the new epoch */
+    rc = dm_session_start(ctx, NULL, SR_DS_STARTUP, &session);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = dm_get_data_info(ctx, session, "test-module", &info);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_ptr_equal(si_test->ly_ctx, info->node->schema->module->ctx);
+    info->modified = true;
+    assert_non_null(dm_lyd_new_path(info, "/test-module:main/instance_id",
+            "/example-module:container/list[key1='key1'][key2='key2']", LYD_PATH_OPT_UPDATE));
+    rc = dm_validate_session_data_trees(ctx, session, &errors, &err_cnt);
+    assert_int_equal(SR_ERR_OK, rc);
+    sr_free_errors(errors, err_cnt);
+
+    /* dangling instance-identifier is detected */
+    assert_non_null(dm_lyd_new_path(info, "/test-module:main/instance_id",
+            "/example-module:container/list[key1='none'][key2='none']", LYD_PATH_OPT_UPDATE));
+    errors = NULL;
+    err_cnt = 0;
+    rc = dm_validate_session_data_trees(ctx, session, &errors, &err_cnt);
+    assert_int_equal(SR_ERR_VALIDATION_FAILED, rc);
+    sr_free_errors(errors, err_cnt);
+
+    dm_session_stop(ctx, session);
+    dm_cleanup(ctx);
+}
+
+/* compares the running data of the modules with their startup data */
+static void
+dm_load_pool_check(dm_ctx_t *ctx, const char **module_names, size_t module_cnt)
+{
+    int rc = SR_ERR_OK;
+    dm_session_t *startup = NULL, *running = NULL;
+    struct lyd_node *startup_tree = NULL, *running_tree = NULL;
+    char *startup_str = NULL, *running_str = NULL;
+
+    rc = dm_session_start(ctx, NULL, SR_DS_STARTUP, &startup);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = dm_session_start(ctx, NULL, SR_DS_RUNNING, &running);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    for (size_t i = 0; i < module_cnt; ++i) {
+        rc = dm_get_datatree(ctx, startup, module_names[i], &startup_tree);
+        assert_int_equal(SR_ERR_OK, rc);
+        rc = dm_get_datatree(ctx, running, module_names[i], &running_tree);
+        assert_int_equal(SR_ERR_OK, rc);
+
+        assert_int_equal(0, lyd_print_mem(&startup_str, startup_tree, LYD_XML, LYP_WITHSIBLINGS));
+        assert_int_equal(0, lyd_print_mem(&running_str, running_tree, LYD_XML, LYP_WITHSIBLINGS));
+        assert_string_equal(startup_str, running_str);
+        free(startup_str);
+        free(running_str);
+    }
+
+    dm_session_stop(ctx, startup);
+    dm_session_stop(ctx, running);
+}
+
+void
+dm_load_pool_test(void **state)
+{
+    int rc = SR_ERR_OK;
+    dm_ctx_t *ctx = NULL;
+    dm_session_t *session = NULL;
+    /* test-module contains an instance-identifier and is loaded sequentially */
+    const char *module_names[] = {"example-module", "ietf-interfaces", "referenced-data", "test-module"};
+    const size_t module_cnt = sizeof(module_names) / sizeof(*module_names);
+
+    rc = dm_init(NULL, NULL, NULL, CM_MODE_LOCAL, TEST_SCHEMA_SEARCH_DIR, TEST_DATA_SEARCH_DIR, &ctx);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = dm_session_start(ctx, NULL, SR_DS_STARTUP, &session);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    for (size_t i = 0; i < module_cnt; ++i) {
+        rc = dm_enable_module_running(ctx, session, module_names[i], NULL);
+        assert_int_equal(SR_ERR_OK, rc);
+    }
+
+    /* sequential loading */
+    dm_set_data_load_threads(ctx, 1);
+    rc = dm_copy_all_models(ctx, session, SR_DS_STARTUP, SR_DS_RUNNING, false, NULL, NULL);
+    assert_int_equal(SR_ERR_OK, rc);
+    dm_load_pool_check(ctx, module_names, module_cnt);
+
+    /* the pool produces the same data, even with more threads than modules */
+    createDataTreeReferencedModule(45);
+    dm_set_data_load_threads(ctx, 8);
+    rc = dm_copy_all_models(ctx, session, SR_DS_STARTUP, SR_DS_RUNNING, false, NULL, NULL);
+    assert_int_equal(SR_ERR_OK, rc);
+    dm_load_pool_check(ctx, module_names, module_cnt);
+
+    createDataTreeReferencedModule(123);
+    dm_set_data_load_threads(ctx, 2);
+    rc = dm_copy_all_models(ctx, session, SR_DS_STARTUP, SR_DS_RUNNING, false, NULL, NULL);
+    assert_int_equal(SR_ERR_OK, rc);
+    dm_load_pool_check(ctx, module_names, module_cnt);
+
+    dm_session_stop(ctx, session);
+    dm_cleanup(ctx);
+}
+
+void
+dm_running_enabled_restart_test(void **state)
+{
+    int rc = SR_ERR_OK;
+    rp_ctx_t *ctx = NULL;
+    dm_session_t *session = NULL;
+    dm_schema_info_t *si = NULL;
+    np_subscription_t subscription = { 0, };
+    ac_ucred_t user_cred = { 0, };
+    const char *module_names[] = {"example-module"};
+    bool disable_running = false;
+
+    user_cred.r_username = getenv("USER");
+    user_cred.r_uid = getuid();
+    user_cred.r_gid = getgid();
+
+    subscription.dst_address = "/tmp/dm-test-restart.sock";
+    subscription.dst_id = 123456789;
+    subscription.type = SR__SUBSCRIPTION_TYPE__MODULE_CHANGE_SUBS;
+    subscription.notif_event = SR__NOTIFICATION_EVENT__APPLY_EV;
+    subscription.enable_running = true;
+
+    /* enable the module in running with a persistent subscription */
+    test_rp_ctx_create(CM_MODE_LOCAL, &ctx);
+    pm_remove_subscriptions_for_destination(ctx->pm_ctx, "example-module", subscription.dst_address, &disable_running);
+    rc = pm_add_subscription(ctx->pm_ctx, &user_cred, "example-module", &subscription, false);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = dm_session_start(ctx->dm_ctx, NULL, SR_DS_STARTUP, &session);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = dm_enable_module_running(ctx->dm_ctx, session, "example-module", NULL);
+    assert_int_equal(SR_ERR_OK, rc);
+    dm_session_stop(ctx->dm_ctx, session);
+    test_rp_ctx_cleanup(ctx);
+
+    /* restart, the running data are loaded before any session asks for them */
+    test_rp_ctx_create(CM_MODE_LOCAL, &ctx);
+    rc = dm_load_running_enabled_data(ctx->dm_ctx);
+    assert_int_equal(SR_ERR_OK, rc);
+
+    rc = dm_get_module_without_lock(ctx->dm_ctx, "example-module", &si);
+    assert_int_equal(SR_ERR_OK, rc);
+    assert_non_null(si->rdonly_trees[SR_DS_RUNNING]);
+    dm_load_pool_check(ctx->dm_ctx, module_names, 1);
+
+    pm_remove_subscriptions_for_destination(ctx->pm_ctx, "example-module", subscription.dst_address, &disable_running);
+    test_rp_ctx_cleanup(ctx);
+}
+
+#define DM_TEST_WARM_IMAGE TEST_DATA_SEARCH_DIR "internal/sysrepo-warm-image.bin"
+
+/* restarts the engine contexts, checks the running data of example-module and returns the inode of the warm image */
+static ino_t
+dm_warm_image_restart(rp_ctx_t **ctx)
+{
+    const char *module_names[] = {"example-module"};
+    struct stat st = {0};
+    int rc = SR_ERR_OK;
+
+    if (NULL != *ctx) {
+        test_rp_ctx_cleanup(*ctx);
+    }
+    test_rp_ctx_create(CM_MODE_LOCAL, ctx);
+    rc = dm_load_running_enabled_data((*ctx)->dm_ctx);
+    assert_int_equal(SR_ERR_OK, rc);
+    dm_load_pool_check((*ctx)->dm_ctx, module_names, 1);
+
+    assert_int_equal(0, stat(DM_TEST_WARM_IMAGE, &st));
+    return st.st_ino;
+}
+
+/* copies startup data of example-module into running */
+static void
+dm_warm_image_copy_startup(rp_ctx_t *ctx)
+{
+    dm_session_t *session = NULL;
+    int rc = SR_ERR_OK;
+
+    rc = dm_session_start(ctx->dm_ctx, NULL, SR_DS_STARTUP, &session);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = dm_enable_module_running(ctx->dm_ctx, session, "example-module", NULL);
+    assert_int_equal(SR_ERR_OK, rc);
+    rc = dm_copy_module(ctx->dm_ctx, session, "example-module", SR_DS_STARTUP, SR_DS_RUNNING, NULL, 0, NULL, NULL);
+    assert_int_equal(SR_ERR_OK, rc);
+    dm_session_stop(ctx->dm_ctx, session);
+}
+
+void
+dm_warm_image_test(void **state)
+{
+    int rc = SR_ERR_OK;
+    rp_ctx_t *ctx = NULL;
+    np_subscription_t subscription = { 0, };
+    ac_ucred_t user_cred = { 0, };
+    bool disable_running = false;
+    uint32_t version = UINT32_MAX;
+    ino_t image_ino = 0, ino = 0;
+    FILE *f = NULL;
+
+    user_cred.r_username = getenv("USER");
+    user_cred.r_uid = getuid();
+    user_cred.r_gid = getgid();
+
+    subscription.dst_address = "/tmp/dm-test-warm-image.sock";
+    subscription.dst_id = 123456789;
+    subscription.type = SR__SUBSCRIPTION_TYPE__MODULE_CHANGE_SUBS;
+    subscription.notif_event = SR__NOTIFICATION_EVENT__APPLY_EV;
+    subscription.enable_running = true;
+
+    test_rp_ctx_create(CM_MODE_LOCAL, &ctx);
+    pm_remove_subscriptions_for_destination(ctx->pm_ctx, "example-module", subscription.dst_address, &disable_running);
+    rc = pm_add_subscription(ctx->pm_ctx, &user_cred, "example-module", &subscription, false);
+    assert_int_equal(SR_ERR_OK, rc);
+    dm_warm_image_copy_startup(ctx);
+    unlink(DM_TEST_WARM_IMAGE);
+
+    /* the image is written into the internal data directory of the context once the files are parsed */
+    image_ino = dm_warm_image_restart(&ctx);
+
+    /* nothing has changed, the data are taken from the image, which is kept */
+    ino = dm_warm_image_restart(&ctx);
+    assert_int_equal(image_ino, ino);
+
+    /* the data file has changed, it is parsed and the image is refreshed */
+    createDataTreeLargeExampleModule(20);
+    dm_warm_image_copy_startup(ctx);
+    ino = dm_warm_image_restart(&ctx);
+    assert_int_not_equal(image_ino, ino);
+    image_ino = ino;
+
+    /* image of a different version is ignored */
+    f = fopen(DM_TEST_WARM_IMAGE, "r+");
+    assert_non_null(f);
+    assert_int_equal(0, fseek(f, sizeof(uint32_t), SEEK_SET));
+    assert_int_equal(1, fwrite(&version, sizeof version, 1, f));
+    fclose(f);
+    ino = dm_warm_image_restart(&ctx);
+    assert_int_not_equal(image_ino, ino);
+    image_ino = ino;
+
+    /* truncated image is ignored */
+    assert_int_equal(0, truncate(DM_TEST_WARM_IMAGE, sizeof(uint32_t)));
+    ino = dm_warm_image_restart(&ctx);
+    assert_int_not_equal(image_ino, ino);
+
+    /* restore the data of example-module */
+    createDataTreeExampleModule();
+    dm_warm_image_copy_startup(ctx);
+    pm_remove_subscriptions_for_destination(ctx->pm_ctx, "example-module", subscription.dst_address, &disable_running);
+    test_rp_ctx_cleanup(ctx);
+}
+
 int
 main()
 {
@@ -1141,6 +1620,12 @@ main()
             cmocka_unit_test(dm_event_notif_parse_test),
             cmocka_unit_test(dm_action_test),
             cmocka_unit_test(dm_schema_node_xpath_hash),
+            cmocka_unit_test(dm_node_index_test),
+            cmocka_unit_test(dm_dp_index_test),
+            cmocka_unit_test(dm_shared_ly_ctx_test),
+            cmocka_unit_test(dm_load_pool_test),
+            cmocka_unit_test(dm_running_enabled_restart_test),
+            cmocka_unit_test(dm_warm_image_test),
     };
 
     return cmocka_run_group_tests(tests, setup, NULL);
@@ -300,6 +300,28 @@ perf_data_provide_test(void **state, int op_num, int *items) {
     *items = val_cnt;
 }
 
+static void
+perf_get_item_state_module_test(void **state, int op_num, int *items) {
+    dp_setup_t *dp_setup = *state;
+    assert_non_null(dp_setup);
+
+    sr_val_t *value = NULL;
+    int rc = 0;
+
+    /* perform a get-item request of a config leaf in a module with a data provider */
+    for (size_t i = 0; i<op_num; i++){
+
+        /* existing leaf */
+        rc = sr_get_item(dp_setup->session, "/ietf-interfaces:interfaces/interface[name='eth0']/description", &value);
+        assert_int_equal(rc, SR_ERR_OK);
+        assert_non_null(value);
+        assert_int_equal(SR_STRING_T, value->type);
+        sr_free_val(value);
+    }
+
+    *items = 1;
+}
+
 static void
 perf_get_item_test(void **state, int op_num, int *items) {
     sr_conn_ctx_t *conn = *state;
@@ -719,6 +741,46 @@ perf_set_delete_100_test(void **state, int op_num, int *items) {
     *items = 100 /* list instances */ * 3 /* leaves */ * 2 /* set + delete */ ;
 }
 
+static void
+perf_set_get_large_value_test(void **state, int op_num, int *items) {
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+    sr_session_ctx_t *session = NULL;
+    sr_val_t value = {0,}, *result = NULL;
+    size_t large_size = 1024 * 1024; /* 1 MB */
+    char *large_str = NULL;
+    int rc = 0;
+
+    large_str = malloc(large_size + 1);
+    assert_non_null(large_str);
+    memset(large_str, 'x', large_size);
+    large_str[large_size] = '\0';
+
+    /* start a session */
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* messages with the large value are sent to both directions */
+    for (size_t i = 0; i < op_num; i++) {
+        value.type = SR_STRING_T;
+        value.data.string_val = large_str;
+        rc = sr_set_item(session, "/example-module:container/list[key1='large'][key2='large']/leaf", &value, SR_EDIT_DEFAULT);
+        assert_int_equal(rc, SR_ERR_OK);
+
+        rc = sr_get_item(session, "/example-module:container/list[key1='large'][key2='large']/leaf", &result);
+        assert_int_equal(rc, SR_ERR_OK);
+        assert_int_equal(large_size, strlen(result->data.string_val));
+        sr_free_val(result);
+    }
+
+    /* stop the session */
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+    free(large_str);
+
+    *items = 2 /* set + get */ ;
+}
+
 static void
 perf_commit_test(void **state, int op_num, int *items) {
     sr_conn_ctx_t *conn = *state;
@@ -945,6 +1007,7 @@ main (int argc, char **argv)
 {
     test_t tests[] = {
         {perf_get_item_test, "Get item one leaf", OP_COUNT, sysrepo_setup, sysrepo_teardown},
+        {perf_get_item_state_module_test, "Get item one leaf, state data", OP_COUNT, data_provide_setup, data_provide_teardown},
         {perf_get_item_first_test, "Get item first leaf", OP_COUNT, sysrepo_setup, sysrepo_teardown},
         {perf_get_item_with_data_load_test, "Get item incl session start", OP_COUNT, sysrepo_setup, sysrepo_teardown},
         {perf_get_items_test, "Get items all lists", OP_COUNT, sysrepo_setup, sysrepo_teardown},
@@ -956,6 +1019,7 @@ main (int argc, char **argv)
         {perf_get_ietf_intefaces_tree_test, "Get subtrees ietf-if config", OP_COUNT, sysrepo_setup, sysrepo_teardown},
         {perf_set_delete_test, "Set & delete one list", OP_COUNT, sysrepo_setup, sysrepo_teardown},
         {perf_set_delete_100_test, "Set & delete 100 lists", OP_COUNT_COMMIT, sysrepo_setup, sysrepo_teardown},
+        {perf_set_get_large_value_test, "Set & get 1 MB leaf value", OP_COUNT_COMMIT, sysrepo_setup, sysrepo_teardown},
         {perf_commit_test, "Commit one leaf change", OP_COUNT_COMMIT, sysrepo_setup, sysrepo_teardown},
         {perf_data_provide_test, "Operational data provide", OP_COUNT_COMMIT, data_provide_setup, data_provide_teardown},
         {perf_rpc_test, "RPC", OP_COUNT_COMMIT, sysrepo_setup, sysrepo_teardown},
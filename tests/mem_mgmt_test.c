@@ -27,6 +27,9 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #include "sr_common.h"
@@ -832,6 +835,123 @@ sr_mem_edit_string_va_test(void **state)
 #undef LONGER_STRING_VALUE
 }
 
+#define MEM_BENCH_THREADS 4   /**< Number of threads competing for memory contexts */
+#define MEM_BENCH_ROUNDS  2000 /**< Number of rounds of the contention benchmark */
+#define MEM_BENCH_BATCH   8   /**< Number of contexts allocated by each thread in one round */
+
+/**
+ * @brief Contexts allocated in the current round, thread *i* releases contexts allocated by thread *i+1*.
+ */
+static sr_mem_ctx_t *mem_bench_ctxs[MEM_BENCH_THREADS][MEM_BENCH_BATCH];
+static pthread_barrier_t mem_bench_barrier;
+
+static void *
+mem_bench_thread(void *arg)
+{
+    size_t id = (size_t)arg;
+    sr_mem_ctx_t *sr_mem = NULL;
+    unsigned seed = id;
+    size_t size = 0;
+    int rc = SR_ERR_OK;
+
+    for (size_t round = 0; round < MEM_BENCH_ROUNDS; ++round) {
+        for (size_t i = 0; i < MEM_BENCH_BATCH; ++i) {
+            /* mostly small requests with occasional bursts of large ones (e.g. get-items) */
+            size = (0 == rand_r(&seed) % 8) ? MEM_BLOCK_MIN_SIZE * 64 : MEM_BLOCK_MIN_SIZE;
+            rc = sr_mem_new(size, &sr_mem);
+            assert_int_equal(SR_ERR_OK, rc);
+            assert_non_null(sr_malloc(sr_mem, size));
+            mem_bench_ctxs[id][i] = sr_mem;
+        }
+        pthread_barrier_wait(&mem_bench_barrier);
+        for (size_t i = 0; i < MEM_BENCH_BATCH; ++i) {
+            sr_mem_free(mem_bench_ctxs[(id + 1) % MEM_BENCH_THREADS][i]);
+        }
+        pthread_barrier_wait(&mem_bench_barrier);
+    }
+    return NULL;
+}
+
+static void
+sr_mem_pool_contention_test(void **state)
+{
+    pthread_t threads[MEM_BENCH_THREADS];
+    sr_mem_pool_stats_t before = {0}, after = {0};
+    struct timespec ts_start = {0}, ts_end = {0};
+    uint64_t requests = 0;
+
+    sr_mem_pool_get_stats(&before);
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    pthread_barrier_init(&mem_bench_barrier, NULL, MEM_BENCH_THREADS);
+    for (size_t i = 0; i < MEM_BENCH_THREADS; ++i) {
+        assert_int_equal(0, pthread_create(&threads[i], NULL, mem_bench_thread, (void *)i));
+    }
+    for (size_t i = 0; i < MEM_BENCH_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&mem_bench_barrier);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    sr_mem_pool_get_stats(&after);
+
+    requests = (uint64_t)MEM_BENCH_THREADS * MEM_BENCH_ROUNDS * MEM_BENCH_BATCH;
+    assert_int_equal(requests, (after.hits - before.hits) + (after.shared_hits - before.shared_hits)
+            + (after.misses - before.misses));
+    /* all contexts were released by a different thread than the one which acquired them */
+    assert_true(after.shared_hits - before.shared_hits > requests / 2);
+
+    printf("sr_mem pool contention: %"PRIu64" contexts in %.3f s, hits=%"PRIu64" shared hits=%"PRIu64
+            " misses=%"PRIu64" destroyed=%"PRIu64" retained=%"PRIu64" B\n", requests,
+            (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9,
+            after.hits - before.hits, after.shared_hits - before.shared_hits, after.misses - before.misses,
+            after.destroyed - before.destroyed, after.bytes_retained);
+}
+
+#define MEM_LIMIT_CTX_SIZE (256 * 1024) /**< Size of the contexts used to exceed the limit of retained bytes */
+#define MEM_LIMIT_CTX_COUNT (2 * MAX_RETAINED_FREE_MEM_BYTES / MEM_LIMIT_CTX_SIZE)
+
+static void *
+mem_limit_thread(void *arg)
+{
+    sr_mem_ctx_t **ctxs = (sr_mem_ctx_t **)arg;
+
+    for (size_t i = 0; i < MEM_LIMIT_CTX_COUNT; ++i) {
+        assert_int_equal(SR_ERR_OK, sr_mem_new(MEM_LIMIT_CTX_SIZE, &ctxs[i]));
+        assert_non_null(sr_malloc(ctxs[i], MEM_LIMIT_CTX_SIZE));
+    }
+    return NULL;
+}
+
+static void
+sr_mem_pool_limits_test(void **state)
+{
+    sr_mem_ctx_t *ctxs[MEM_LIMIT_CTX_COUNT] = { NULL, };
+    sr_mem_ctx_t *sr_mem = NULL;
+    sr_mem_pool_stats_t released = {0}, after = {0};
+    pthread_t thread;
+
+    /* contexts acquired by another thread are returned via the shared pool, but only up to the byte limit */
+    assert_int_equal(0, pthread_create(&thread, NULL, mem_limit_thread, ctxs));
+    pthread_join(thread, NULL);
+    for (size_t i = 0; i < MEM_LIMIT_CTX_COUNT; ++i) {
+        sr_mem_free(ctxs[i]);
+    }
+    sr_mem_pool_get_stats(&released);
+    assert_true(released.bytes_retained <= MAX_RETAINED_FREE_MEM_BYTES);
+    assert_true(released.bytes_retained > MAX_RETAINED_FREE_MEM_BYTES / 2);
+
+    /* no demand for large contexts, the shared pool is released after an idle adaptation period */
+    for (size_t i = 0; i < 3 * MEM_POOL_ADAPT_PERIOD; ++i) {
+        assert_int_equal(SR_ERR_OK, sr_mem_new(MEM_BLOCK_MIN_SIZE, &sr_mem));
+        assert_non_null(sr_malloc(sr_mem, MEM_BLOCK_MIN_SIZE));
+        sr_mem_free(sr_mem);
+    }
+    sr_mem_pool_get_stats(&after);
+    assert_true(after.bytes_retained < released.bytes_retained / 2);
+    assert_true(after.destroyed - released.destroyed >= released.bytes_retained / MEM_LIMIT_CTX_SIZE / 2);
+}
+
 int
 main() {
     const struct CMUnitTest tests[] = {
@@ -842,6 +962,8 @@ main() {
         cmocka_unit_test(sr_mem_edit_string_test),
         cmocka_unit_test(sr_mem_edit_string_va_test),
         cmocka_unit_test(sr_realloc_test),
+        cmocka_unit_test(sr_mem_pool_contention_test),
+        cmocka_unit_test(sr_mem_pool_limits_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -22,10 +22,17 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <setjmp.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <cmocka.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 #include "sysrepo.h"
 #include "sr_common.h"
+#include "data_manager.h"
 #include "test_module_helper.h"
 #include "system_helper.h"
 
@@ -48,6 +55,14 @@ sysrepo_setup(void **state)
     return 0;
 }
 
+static int
+sysrepo_test_module_setup(void **state)
+{
+    createDataTreeTestModule();
+    createDataTreeReferencedModule(42);
+    return sysrepo_setup(state);
+}
+
 static int
 sysrepo_teardown(void **state)
 {
@@ -122,11 +137,378 @@ perf_get_subtree_test(void **state) {
     assert_int_equal(rc, SR_ERR_OK);
 }
 
+/**
+ * @brief Memory usage of the process (in library mode it includes the local Sysrepo Engine).
+ */
+typedef struct perf_mem_usage_s {
+    size_t rss;          /**< resident set size */
+    size_t heap_used;    /**< bytes allocated by malloc and not freed */
+    size_t heap_free;    /**< bytes freed but retained by malloc (fragmentation) */
+} perf_mem_usage_t;
+
+static void
+perf_mem_usage_get(perf_mem_usage_t *usage)
+{
+    FILE *statm = NULL;
+    unsigned long size = 0, resident = 0;
+
+    memset(usage, 0, sizeof *usage);
+
+    statm = fopen("/proc/self/statm", "r");
+    if (NULL != statm) {
+        if (2 == fscanf(statm, "%lu %lu", &size, &resident)) {
+            usage->rss = resident * sysconf(_SC_PAGESIZE);
+        }
+        fclose(statm);
+    }
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    usage->heap_used = mi.uordblks + mi.hblkhd;
+    usage->heap_free = mi.fordblks;
+#elif defined(__GLIBC__)
+    struct mallinfo mi = mallinfo();
+    usage->heap_used = (size_t) mi.uordblks + (size_t) mi.hblkhd;
+    usage->heap_free = (size_t) mi.fordblks;
+#endif
+}
+
+static void
+perf_data_tree_churn_session(sr_conn_ctx_t *conn)
+{
+    sr_session_ctx_t *session = NULL;
+    sr_val_t *value = NULL;
+    int rc = 0;
+
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    rc = sr_get_item(session, XP_TEST_MODULE_STRING, &value);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_non_null(value);
+    assert_int_equal(SR_STRING_T, value->type);
+    sr_free_val(value);
+
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+}
+
+static void
+perf_data_tree_churn_test(void **state) {
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    struct timespec ts_start = {0}, ts_end = {0};
+    perf_mem_usage_t mem_before = {0}, mem_after = {0};
+    size_t count = 10000;
+
+    /* warm up, so that the caches (schemas, read-only trees) are part of the baseline */
+    perf_data_tree_churn_session(conn);
+    perf_mem_usage_get(&mem_before);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    /* each session loads test-module, the data of the modules it references are loaded
+     * only for the validation and released right after */
+    for (size_t i = 0; i < count; i++) {
+        perf_data_tree_churn_session(conn);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    perf_mem_usage_get(&mem_after);
+
+    printf("Data tree load/free churn: %zu sessions in %.3f s\n", count,
+            (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9);
+    printf("    RSS %zu kB -> %zu kB, heap in use %zu kB -> %zu kB, heap free (fragmented) %zu kB -> %zu kB\n",
+            mem_before.rss / 1024, mem_after.rss / 1024, mem_before.heap_used / 1024, mem_after.heap_used / 1024,
+            mem_before.heap_free / 1024, mem_after.heap_free / 1024);
+}
+
+static double
+perf_elapsed(const struct timespec *ts_start, const struct timespec *ts_end)
+{
+    return (ts_end->tv_sec - ts_start->tv_sec) + (ts_end->tv_nsec - ts_start->tv_nsec) / 1e9;
+}
+
+static void
+perf_values_gpb_conversion_test(void **state) {
+    Sr__GetItemsResp gpb_resp = SR__GET_ITEMS_RESP__INIT, wire_resp = SR__GET_ITEMS_RESP__INIT;
+    Sr__GetItemsResp compressed_resp = SR__GET_ITEMS_RESP__INIT;
+    Sr__GetItemsResp *unpacked = NULL;
+    sr_mem_ctx_t *sr_mem = NULL;
+    sr_val_t *values = NULL, *decoded = NULL;
+    struct timespec ts_start = {0}, ts_end = {0};
+    size_t count = 100000, decoded_cnt = 0, gpb_len = 0, wire_len = 0, compressed_len = 0;
+    uint8_t *gpb_buf = NULL, *wire_buf = NULL, *compressed_buf = NULL;
+    int rc = 0;
+
+    rc = sr_new_values(count, &values);
+    assert_int_equal(rc, SR_ERR_OK);
+    for (size_t i = 0; i < count; i++) {
+        rc = sr_val_build_xpath(&values[i], "/example-module:container/list[key1='k%zu'][key2='k%zu']/leaf", i, i);
+        assert_int_equal(rc, SR_ERR_OK);
+        rc = sr_val_build_str_data(&values[i], SR_STRING_T, "value%zu", i);
+        assert_int_equal(rc, SR_ERR_OK);
+    }
+    sr_mem = values[0]._sr_mem;
+
+    /* encoding through GPB values */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    rc = sr_values_sr_to_gpb(values, count, &gpb_resp.values, &gpb_resp.n_values);
+    assert_int_equal(rc, SR_ERR_OK);
+    gpb_len = sr__get_items_resp__get_packed_size(&gpb_resp);
+    gpb_buf = malloc(gpb_len);
+    assert_non_null(gpb_buf);
+    sr__get_items_resp__pack(&gpb_resp, gpb_buf);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    printf("Encoding of %zu values through GPB values: %.3f s\n", count, perf_elapsed(&ts_start, &ts_end));
+
+    /* direct encoding */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    rc = sr_values_sr_to_gpb_wire(sr_mem, values, count, false, &wire_resp.base, "values");
+    assert_int_equal(rc, SR_ERR_OK);
+    wire_len = sr__get_items_resp__get_packed_size(&wire_resp);
+    wire_buf = malloc(wire_len);
+    assert_non_null(wire_buf);
+    sr__get_items_resp__pack(&wire_resp, wire_buf);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    printf("Direct encoding of %zu values: %.3f s\n", count, perf_elapsed(&ts_start, &ts_end));
+
+    assert_int_equal(gpb_len, wire_len);
+    assert_memory_equal(gpb_buf, wire_buf, gpb_len);
+
+    /* direct encoding with compressed xpaths */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    rc = sr_values_sr_to_gpb_wire(sr_mem, values, count, true, &compressed_resp.base, "values");
+    assert_int_equal(rc, SR_ERR_OK);
+    compressed_len = sr__get_items_resp__get_packed_size(&compressed_resp);
+    compressed_buf = malloc(compressed_len);
+    assert_non_null(compressed_buf);
+    sr__get_items_resp__pack(&compressed_resp, compressed_buf);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    printf("Direct encoding of %zu values with compressed xpaths: %.3f s, %zu bytes instead of %zu\n", count,
+            perf_elapsed(&ts_start, &ts_end), compressed_len, wire_len);
+
+    /* decoding through GPB values */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    unpacked = sr__get_items_resp__unpack(NULL, wire_len, wire_buf);
+    assert_non_null(unpacked);
+    rc = sr_values_gpb_to_sr(NULL, unpacked->values, unpacked->n_values, &decoded, &decoded_cnt);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_int_equal(decoded_cnt, count);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    printf("Decoding of %zu values through GPB values: %.3f s\n", count, perf_elapsed(&ts_start, &ts_end));
+    sr_free_values(decoded, decoded_cnt);
+    sr__get_items_resp__free_unpacked(unpacked, NULL);
+
+    /* direct decoding */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    rc = sr_values_gpb_wire_to_sr(NULL, wire_buf, wire_len, 1, &decoded, &decoded_cnt);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_int_equal(decoded_cnt, count);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    printf("Direct decoding of %zu values: %.3f s\n", count, perf_elapsed(&ts_start, &ts_end));
+    sr_free_values(decoded, decoded_cnt);
+
+    /* direct decoding of compressed xpaths */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    rc = sr_values_gpb_wire_to_sr(NULL, compressed_buf, compressed_len, 1, &decoded, &decoded_cnt);
+    assert_int_equal(rc, SR_ERR_OK);
+    assert_int_equal(decoded_cnt, count);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    printf("Direct decoding of %zu values with compressed xpaths: %.3f s\n", count, perf_elapsed(&ts_start, &ts_end));
+    assert_string_equal(values[count - 1].xpath, decoded[count - 1].xpath);
+    sr_free_values(decoded, decoded_cnt);
+
+    if (NULL == sr_mem) {
+        for (size_t i = 0; i < gpb_resp.n_values; i++) {
+            sr__value__free_unpacked(gpb_resp.values[i], NULL);
+        }
+        free(gpb_resp.values);
+        free(wire_resp.base.unknown_fields[0].data);
+        free(wire_resp.base.unknown_fields);
+        free(compressed_resp.base.unknown_fields[0].data);
+        free(compressed_resp.base.unknown_fields);
+    }
+    free(gpb_buf);
+    free(wire_buf);
+    free(compressed_buf);
+    sr_free_values(values, count);
+}
+
+#define PERF_LOAD_MODULE_CNT 120   /**< Number of modules generated for the data loading benchmark */
+#define PERF_LOAD_ITEM_CNT 200     /**< Number of list entries in the data of each generated module */
+
+/* creates schema and startup data of the generated module, or removes them including the running data */
+static void
+perf_load_module_files(size_t idx, bool create)
+{
+    char module_name[PATH_MAX] = { 0, }, schema_file[PATH_MAX] = { 0, };
+    char *startup_file = NULL, *running_file = NULL;
+    FILE *f = NULL;
+    int rc = SR_ERR_OK;
+
+    snprintf(module_name, PATH_MAX, "perf-load-%03zu", idx);
+    snprintf(schema_file, PATH_MAX, "%s%s.yang", TEST_SCHEMA_SEARCH_DIR, module_name);
+    rc = sr_get_data_file_name(TEST_DATA_SEARCH_DIR, module_name, SR_DS_STARTUP, &startup_file);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = sr_get_data_file_name(TEST_DATA_SEARCH_DIR, module_name, SR_DS_RUNNING, &running_file);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    if (!create) {
+        unlink(schema_file);
+        unlink(startup_file);
+        unlink(running_file);
+        free(startup_file);
+        free(running_file);
+        return;
+    }
+
+    f = fopen(schema_file, "w");
+    assert_non_null(f);
+    fprintf(f, "module %s {\n  namespace \"urn:%s\";\n  prefix pl;\n"
+            "  container cont {\n    list item {\n      key name;\n"
+            "      leaf name { type string; }\n      leaf value { type uint32; }\n    }\n  }\n}\n",
+            module_name, module_name);
+    fclose(f);
+
+    f = fopen(startup_file, "w");
+    assert_non_null(f);
+    fprintf(f, "<cont xmlns=\"urn:%s\">", module_name);
+    for (size_t i = 0; i < PERF_LOAD_ITEM_CNT; ++i) {
+        fprintf(f, "<item><name>item%zu</name><value>%zu</value></item>", i, i);
+    }
+    fprintf(f, "</cont>\n");
+    fclose(f);
+
+    free(startup_file);
+    free(running_file);
+}
+
+static void
+perf_data_load_threads_test(void **state) {
+    dm_ctx_t *dm_ctx = NULL;
+    dm_session_t *session = NULL;
+    sr_list_t *implicitly_installed = NULL;
+    char module_name[PATH_MAX] = { 0, }, schema_file[PATH_MAX] = { 0, };
+    struct timespec ts_start = {0}, ts_end = {0};
+    double elapsed_seq = 0, elapsed_par = 0;
+    size_t thread_cnt = 1 < SR_DATA_LOAD_THREADS ? SR_DATA_LOAD_THREADS : 4;
+    int rc = SR_ERR_OK;
+
+    sr_log_stderr(SR_LL_NONE);
+
+    for (size_t i = 0; i < PERF_LOAD_MODULE_CNT; ++i) {
+        perf_load_module_files(i, true);
+    }
+
+    rc = dm_init(NULL, NULL, NULL, CM_MODE_LOCAL, TEST_SCHEMA_SEARCH_DIR, TEST_DATA_SEARCH_DIR, &dm_ctx);
+    assert_int_equal(rc, SR_ERR_OK);
+    rc = dm_session_start(dm_ctx, NULL, SR_DS_STARTUP, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    /* the modules are installed in memory only */
+    for (size_t i = 0; i < PERF_LOAD_MODULE_CNT; ++i) {
+        snprintf(module_name, PATH_MAX, "perf-load-%03zu", i);
+        snprintf(schema_file, PATH_MAX, "%s%s.yang", TEST_SCHEMA_SEARCH_DIR, module_name);
+        rc = dm_install_module(dm_ctx, session, module_name, NULL, schema_file, &implicitly_installed);
+        assert_int_equal(rc, SR_ERR_OK);
+        md_free_module_key_list(implicitly_installed);
+        implicitly_installed = NULL;
+        rc = dm_enable_module_running(dm_ctx, session, module_name, NULL);
+        assert_int_equal(rc, SR_ERR_OK);
+    }
+
+    /* each copy parses and validates the startup data of all the modules */
+    dm_set_data_load_threads(dm_ctx, 1);
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    rc = dm_copy_all_models(dm_ctx, session, SR_DS_STARTUP, SR_DS_RUNNING, false, NULL, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    assert_int_equal(rc, SR_ERR_OK);
+    elapsed_seq = perf_elapsed(&ts_start, &ts_end);
+
+    dm_set_data_load_threads(dm_ctx, thread_cnt);
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    rc = dm_copy_all_models(dm_ctx, session, SR_DS_STARTUP, SR_DS_RUNNING, false, NULL, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    assert_int_equal(rc, SR_ERR_OK);
+    elapsed_par = perf_elapsed(&ts_start, &ts_end);
+
+    printf("Copy of startup of %d modules to running: %.3f s using 1 thread, %.3f s using %zu threads (speedup %.2fx)\n",
+            PERF_LOAD_MODULE_CNT, elapsed_seq, elapsed_par, thread_cnt, 0 < elapsed_par ? elapsed_seq / elapsed_par : 0);
+
+    dm_session_stop(dm_ctx, session);
+    dm_cleanup(dm_ctx);
+
+    for (size_t i = 0; i < PERF_LOAD_MODULE_CNT; ++i) {
+        perf_load_module_files(i, false);
+    }
+}
+
+#define PERF_GET_THREADS_MAX 16     /**< Maximal number of threads issuing get requests concurrently */
+#define PERF_GET_THREAD_OPS 20000   /**< Number of get-item requests done by each thread */
+
+static void *
+perf_get_item_thread(void *sr_conn_ctx_p)
+{
+    sr_conn_ctx_t *conn = (sr_conn_ctx_t *)sr_conn_ctx_p;
+    sr_session_ctx_t *session = NULL;
+    sr_val_t *value = NULL;
+    int rc = 0;
+
+    rc = sr_session_start(conn, SR_DS_STARTUP, SR_SESS_DEFAULT, &session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    for (size_t i = 0; i < PERF_GET_THREAD_OPS; i++) {
+        rc = sr_get_item(session, "/example-module:container/list[key1='key1'][key2='key2']/leaf", &value);
+        assert_int_equal(rc, SR_ERR_OK);
+        assert_non_null(value);
+        sr_free_val(value);
+    }
+
+    rc = sr_session_stop(session);
+    assert_int_equal(rc, SR_ERR_OK);
+
+    return NULL;
+}
+
+static void
+perf_get_item_threads_test(void **state) {
+    sr_conn_ctx_t *conn = *state;
+    assert_non_null(conn);
+
+    pthread_t threads[PERF_GET_THREADS_MAX];
+    struct timespec ts_start = {0}, ts_end = {0};
+    double elapsed = 0, base = 0;
+
+    /* the throughput of reads should grow with the number of threads up to the number of engine workers */
+    for (size_t thread_cnt = 1; thread_cnt <= PERF_GET_THREADS_MAX; thread_cnt *= 2) {
+        clock_gettime(CLOCK_MONOTONIC, &ts_start);
+        for (size_t i = 0; i < thread_cnt; i++) {
+            pthread_create(&threads[i], NULL, perf_get_item_thread, conn);
+        }
+        for (size_t i = 0; i < thread_cnt; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+        elapsed = perf_elapsed(&ts_start, &ts_end);
+        if (1 == thread_cnt) {
+            base = PERF_GET_THREAD_OPS / elapsed;
+        }
+        printf("Get-item throughput with %2zu threads: %.0f ops/s (%.2fx)\n", thread_cnt,
+                thread_cnt * PERF_GET_THREAD_OPS / elapsed, 0 < base ? thread_cnt * PERF_GET_THREAD_OPS / elapsed / base : 0);
+    }
+}
+
 int
 main() {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test_setup_teardown(perf_get_item_test, sysrepo_setup, sysrepo_teardown),
             cmocka_unit_test_setup_teardown(perf_get_subtree_test, sysrepo_setup, sysrepo_teardown),
+            cmocka_unit_test_setup_teardown(perf_data_tree_churn_test, sysrepo_test_module_setup, sysrepo_teardown),
+            cmocka_unit_test(perf_values_gpb_conversion_test),
+            cmocka_unit_test(perf_data_load_threads_test),
+            cmocka_unit_test_setup_teardown(perf_get_item_threads_test, sysrepo_setup, sysrepo_teardown),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);